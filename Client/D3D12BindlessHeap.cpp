@@ -0,0 +1,205 @@
+#include "pch.h"
+#include "D3D12BindlessHeap.h"
+#include "D3D12PipelineCache.h"
+#include "D3D12Renderer.h"
+
+/*
+=====================
+D3D12BindlessHeap
+=====================
+*/
+
+void D3D12BindlessHeap::Init(D3D12Renderer* renderer, uint32 descriptorsCount)
+{
+	m_renderer = renderer;
+	m_device = renderer->GetDevice();
+	m_descriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	m_descriptorsCount = descriptorsCount;
+
+	// Tier 1 caps tables at 128 SRVs and requires every descriptor in them to be valid.
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+	ThrowIfFailed(m_device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)));
+	if (options.ResourceBindingTier < D3D12_RESOURCE_BINDING_TIER_2)
+	{
+		ThrowIfFailed(E_FAIL);
+		return;
+	}
+
+	CreateRootSignature();
+	CreateDescriptorHeap();
+
+	// Popped from the back, so low indices go first.
+	m_freeIndices = new uint32[m_descriptorsCount];
+	m_freeIndicesCount = m_descriptorsCount - BINDLESS_UAVS_COUNT;
+	for (uint32 i = 0; i < m_freeIndicesCount; i++)
+	{
+		m_freeIndices[i] = m_descriptorsCount - 1 - i;
+	}
+
+	m_freeUavIndicesCount = BINDLESS_UAVS_COUNT;
+	for (uint32 i = 0; i < BINDLESS_UAVS_COUNT; i++)
+	{
+		m_freeUavIndices[i] = BINDLESS_UAVS_COUNT - 1 - i;
+		CreateNullUav(i);
+	}
+}
+
+void D3D12BindlessHeap::Clean()
+{
+	if (m_deferredFrees)
+	{
+		delete[] m_deferredFrees;
+		m_deferredFrees = nullptr;
+	}
+	m_deferredFreesCount = 0;
+	m_deferredFreesCapacity = 0;
+
+	if (m_freeIndices)
+	{
+		delete[] m_freeIndices;
+		m_freeIndices = nullptr;
+	}
+	m_freeIndicesCount = 0;
+	m_freeUavIndicesCount = 0;
+
+	DestroyDescriptorHeap();
+	DestroyRootSignature();
+}
+
+uint32 D3D12BindlessHeap::Allocate()
+{
+	if (m_freeIndicesCount == 0)
+		return BINDLESS_INVALID_INDEX;
+
+	return m_freeIndices[--m_freeIndicesCount];
+}
+
+uint32 D3D12BindlessHeap::AllocateUav()
+{
+	if (m_freeUavIndicesCount == 0)
+		return BINDLESS_INVALID_INDEX;
+
+	return m_freeUavIndices[--m_freeUavIndicesCount];
+}
+
+void D3D12BindlessHeap::Free(uint32 index)
+{
+	if (index == BINDLESS_INVALID_INDEX)
+		return;
+
+	if (m_deferredFreesCount == m_deferredFreesCapacity)
+	{
+		uint32 capacity = m_deferredFreesCapacity ? m_deferredFreesCapacity * 2 : 64;
+		DeferredFree* deferredFrees = new DeferredFree[capacity];
+		for (uint32 i = 0; i < m_deferredFreesCount; i++)
+		{
+			deferredFrees[i] = m_deferredFrees[i];
+		}
+
+		delete[] m_deferredFrees;
+		m_deferredFrees = deferredFrees;
+		m_deferredFreesCapacity = capacity;
+	}
+
+	DeferredFree& deferred = m_deferredFrees[m_deferredFreesCount++];
+	deferred.index = index;
+	deferred.fenceValue = m_renderer->GetFrameFenceValue();
+}
+
+void D3D12BindlessHeap::ReleaseDeferred(uint64 completedFenceValue)
+{
+	uint32 remaining = 0;
+	for (uint32 i = 0; i < m_deferredFreesCount; i++)
+	{
+		DeferredFree& deferred = m_deferredFrees[i];
+		if (deferred.fenceValue > completedFenceValue)
+		{
+			m_deferredFrees[remaining++] = deferred;
+		}
+		else if (deferred.index < BINDLESS_UAVS_COUNT)
+		{
+			// The UAV table must stay valid, so the slot goes back to null.
+			CreateNullUav(deferred.index);
+			m_freeUavIndices[m_freeUavIndicesCount++] = deferred.index;
+		}
+		else
+		{
+			m_freeIndices[m_freeIndicesCount++] = deferred.index;
+		}
+	}
+	m_deferredFreesCount = remaining;
+}
+
+void D3D12BindlessHeap::Bind(ID3D12GraphicsCommandList* commandList)
+{
+	commandList->SetDescriptorHeaps(1, &m_descriptorHeap);
+	commandList->SetGraphicsRootSignature(m_rootSignature);
+	commandList->SetGraphicsRootDescriptorTable(BINDLESS_ROOT_PARAMETER_TEXTURES, m_descriptorHeap->GetGPUDescriptorHandleForHeapStart());
+	commandList->SetGraphicsRootDescriptorTable(BINDLESS_ROOT_PARAMETER_UAVS, m_descriptorHeap->GetGPUDescriptorHandleForHeapStart());
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE D3D12BindlessHeap::GetCpuHandle(uint32 index)
+{
+	return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_descriptorHeap->GetCPUDescriptorHandleForHeapStart(), index, m_descriptorSize);
+}
+
+void D3D12BindlessHeap::CreateRootSignature()
+{
+	// Unbounded, and in their own spaces so they cannot overlap other SRVs. Both
+	// ranges start at the table start: one for float textures, one for uint.
+	CD3DX12_DESCRIPTOR_RANGE textureRanges[2];
+	textureRanges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 1, 0);
+	textureRanges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 2, 0);
+
+	CD3DX12_DESCRIPTOR_RANGE uavRange;
+	uavRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, BINDLESS_UAVS_COUNT, 0, 1);
+
+	CD3DX12_ROOT_PARAMETER rootParameters[BINDLESS_ROOT_PARAMETERS_COUNT];
+	rootParameters[BINDLESS_ROOT_PARAMETER_OBJECT_CONSTANTS].InitAsConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_ALL);
+	rootParameters[BINDLESS_ROOT_PARAMETER_FRAME_CONSTANTS].InitAsConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_ALL);
+	rootParameters[BINDLESS_ROOT_PARAMETER_MATERIALS].InitAsShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+	rootParameters[BINDLESS_ROOT_PARAMETER_TEXTURES].InitAsDescriptorTable(_countof(textureRanges), textureRanges, D3D12_SHADER_VISIBILITY_PIXEL);
+	rootParameters[BINDLESS_ROOT_PARAMETER_UAVS].InitAsDescriptorTable(1, &uavRange, D3D12_SHADER_VISIBILITY_PIXEL);
+
+	CD3DX12_STATIC_SAMPLER_DESC linearClamp(0, D3D12_FILTER_MIN_MAG_MIP_LINEAR, D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_CLAMP);
+
+	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+	rootSignatureDesc.Init(_countof(rootParameters), rootParameters, 1, &linearClamp, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+
+	m_rootSignature = m_renderer->GetPipelineCache()->GetRootSignature(rootSignatureDesc);
+}
+
+void D3D12BindlessHeap::CreateDescriptorHeap()
+{
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+	heapDesc.NumDescriptors = m_descriptorsCount;
+	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	ThrowIfFailed(m_device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_descriptorHeap)));
+}
+
+void D3D12BindlessHeap::CreateNullUav(uint32 index)
+{
+	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+	uavDesc.Format = DXGI_FORMAT_R32_UINT;
+	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+	m_device->CreateUnorderedAccessView(nullptr, nullptr, &uavDesc, GetCpuHandle(index));
+}
+
+void D3D12BindlessHeap::DestroyRootSignature()
+{
+	if (m_rootSignature)
+	{
+		m_rootSignature->Release();
+		m_rootSignature = nullptr;
+	}
+}
+
+void D3D12BindlessHeap::DestroyDescriptorHeap()
+{
+	if (m_descriptorHeap)
+	{
+		m_renderer->DeferRelease(m_descriptorHeap);
+		m_descriptorHeap = nullptr;
+	}
+}
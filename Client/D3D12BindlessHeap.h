@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../Common/ShaderConstants.h"
+
+class D3D12Renderer;
+
+const uint32 BINDLESS_INVALID_INDEX = 0xffffffff;
+// The first descriptors of the heap are kept for UAVs. Tier 2 caps UAV tables
+// at 64 descriptors and needs each of them valid, so unused slots hold null UAVs.
+const uint32 BINDLESS_UAVS_COUNT = 16;
+
+// Root parameters of the one graphics root signature every pipeline shares.
+enum BINDLESS_ROOT_PARAMETER
+{
+	BINDLESS_ROOT_PARAMETER_OBJECT_CONSTANTS,	// b0, root CBV: the only root write per draw.
+	BINDLESS_ROOT_PARAMETER_FRAME_CONSTANTS,	// b1, root CBV set per command list.
+	BINDLESS_ROOT_PARAMETER_MATERIALS,			// t0, root SRV of every MaterialConstants.
+	BINDLESS_ROOT_PARAMETER_TEXTURES,			// t0 space1 and space2, unbounded tables over the whole heap.
+	BINDLESS_ROOT_PARAMETER_UAVS,				// u0 space1, table over the UAV slots.
+	BINDLESS_ROOT_PARAMETERS_COUNT,
+};
+
+/*
+=====================
+D3D12BindlessHeap
+=====================
+*/
+
+// One shader-visible heap holds every texture SRV, and the root signature
+// exposes all of it as a single unbounded table. Shaders pick textures by
+// index, so the heap and table are bound once per command list and draws only
+// change the object CBV. Space2 views the same heap as uint textures. Needs
+// resource binding tier 2.
+class D3D12BindlessHeap
+{
+public:
+	void Init(D3D12Renderer* renderer, uint32 descriptorsCount);
+	// The heap goes through the renderer's deferred release.
+	void Clean();
+
+	// Returns BINDLESS_INVALID_INDEX when the heap is full.
+	uint32 Allocate();
+	// Index of a UAV slot, also its index in the UAV table.
+	uint32 AllocateUav();
+	// The index is reused only once the GPU is done with the frame being recorded.
+	void Free(uint32 index);
+	void ReleaseDeferred(uint64 completedFenceValue);
+
+	// Sets the heap, the root signature and the texture table.
+	void Bind(ID3D12GraphicsCommandList* commandList);
+
+	D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(uint32 index);
+	inline ID3D12RootSignature* GetRootSignature() { return m_rootSignature; }
+
+private:
+	struct DeferredFree
+	{
+		uint32 index = 0;
+		uint64 fenceValue = 0;
+	};
+
+	D3D12Renderer* m_renderer = nullptr;
+	ID3D12Device* m_device = nullptr;
+	ID3D12RootSignature* m_rootSignature = nullptr;
+	ID3D12DescriptorHeap* m_descriptorHeap = nullptr;
+	uint32 m_descriptorSize = 0;
+	uint32 m_descriptorsCount = 0;
+
+	// Stack of free indices.
+	uint32* m_freeIndices = nullptr;
+	uint32 m_freeIndicesCount = 0;
+	uint32 m_freeUavIndices[BINDLESS_UAVS_COUNT] = {};
+	uint32 m_freeUavIndicesCount = 0;
+
+	DeferredFree* m_deferredFrees = nullptr;
+	uint32 m_deferredFreesCount = 0;
+	uint32 m_deferredFreesCapacity = 0;
+
+	void CreateRootSignature();
+	void CreateDescriptorHeap();
+	void CreateNullUav(uint32 index);
+
+	void DestroyRootSignature();
+	void DestroyDescriptorHeap();
+};
@@ -0,0 +1,56 @@
+#include "pch.h"
+#include "D3D12ConstantRing.h"
+#include "D3D12Utils.h"
+
+/*
+=====================
+D3D12ConstantRing
+=====================
+*/
+
+void D3D12ConstantRing::Init(ID3D12Device* device, uint32 framesCount, uint32 sizePerFrame)
+{
+	m_framesCount = framesCount;
+	m_sizePerFrame = D3D12Utils::CalcConstantBufferByteSize(sizePerFrame);
+
+	CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
+	auto desc = CD3DX12_RESOURCE_DESC::Buffer(static_cast<uint64>(m_sizePerFrame) * m_framesCount);
+	ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_buffer)));
+
+	CD3DX12_RANGE readRange(0, 0);
+	ThrowIfFailed(m_buffer->Map(0, &readRange, reinterpret_cast<void**>(&m_mappedData)));
+
+	m_frameStart = 0;
+	m_frameUsed = 0;
+}
+
+void D3D12ConstantRing::Clean()
+{
+	if (m_buffer)
+	{
+		m_buffer->Unmap(0, nullptr);
+		m_mappedData = nullptr;
+
+		m_buffer->Release();
+		m_buffer = nullptr;
+	}
+}
+
+void D3D12ConstantRing::BeginFrame(uint32 frameIndex)
+{
+	m_frameStart = (frameIndex % m_framesCount) * m_sizePerFrame;
+	m_frameUsed = 0;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS D3D12ConstantRing::Push(const void* data, uint32 size)
+{
+	uint32 alignedSize = D3D12Utils::CalcConstantBufferByteSize(size);
+	if (m_frameUsed + alignedSize > m_sizePerFrame)
+		return 0;
+
+	uint32 offset = m_frameStart + m_frameUsed;
+	m_frameUsed += alignedSize;
+
+	::memcpy(m_mappedData + offset, data, size);
+	return m_buffer->GetGPUVirtualAddress() + offset;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+/*
+=====================
+D3D12ConstantRing
+=====================
+*/
+
+// Per-draw constants, bound as root CBVs straight from a persistently mapped
+// upload heap. Each frame in flight has its own region, filled front to back
+// and rewound when the frame comes around again, so a draw costs a memcpy and
+// one root write instead of a buffer and a descriptor per object.
+class D3D12ConstantRing
+{
+public:
+	// sizePerFrame is rounded up to the 256 byte CBV alignment.
+	void Init(ID3D12Device* device, uint32 framesCount, uint32 sizePerFrame);
+	void Clean();
+
+	// The GPU must be done with the frame that last used frameIndex.
+	void BeginFrame(uint32 frameIndex);
+
+	// Returns 0 when the frame's region is full.
+	D3D12_GPU_VIRTUAL_ADDRESS Push(const void* data, uint32 size);
+
+private:
+	ID3D12Resource* m_buffer = nullptr;
+	BYTE* m_mappedData = nullptr;
+	uint32 m_framesCount = 0;
+	uint32 m_sizePerFrame = 0;
+
+	uint32 m_frameStart = 0;
+	uint32 m_frameUsed = 0;
+};
@@ -0,0 +1,167 @@
+#include "pch.h"
+#include "D3D12GpuProfiler.h"
+#include "D3D12Renderer.h"
+#include "../Common/Profiler.h"
+
+/*
+=====================
+D3D12GpuProfiler
+=====================
+*/
+
+void D3D12GpuProfiler::Init(D3D12Renderer* renderer, uint32 framesCount)
+{
+	m_renderer = renderer;
+	m_framesCount = framesCount;
+	m_frames = new FrameSlot[m_framesCount];
+	m_currentFrame = 0;
+
+	ID3D12Device* device = renderer->GetDevice();
+
+	D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+	queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	queryHeapDesc.Count = s_QueriesPerFrame * m_framesCount;
+	ThrowIfFailed(device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_queryHeap)));
+
+	CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_READBACK);
+	auto desc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(uint64) * s_QueriesPerFrame * m_framesCount);
+	ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m_readbackBuffer)));
+
+	ThrowIfFailed(renderer->GetCommandQueue()->GetTimestampFrequency(&m_gpuFrequency));
+
+	m_trackId = Profiler::CreateTrack("GPU");
+}
+
+void D3D12GpuProfiler::Clean()
+{
+	// The last frames are still unread.
+	if (m_frames)
+	{
+		for (uint32 i = 1; i <= m_framesCount; i++)
+		{
+			ReadBack((m_currentFrame + i) % m_framesCount);
+		}
+
+		delete[] m_frames;
+		m_frames = nullptr;
+	}
+
+	if (m_readbackBuffer)
+	{
+		m_renderer->DeferRelease(m_readbackBuffer);
+		m_readbackBuffer = nullptr;
+	}
+
+	if (m_queryHeap)
+	{
+		m_renderer->DeferRelease(m_queryHeap);
+		m_queryHeap = nullptr;
+	}
+}
+
+void D3D12GpuProfiler::BeginFrame(ID3D12GraphicsCommandList* commandList)
+{
+	m_currentFrame = (m_currentFrame + 1) % m_framesCount;
+	ReadBack(m_currentFrame);
+
+	FrameSlot& frame = m_frames[m_currentFrame];
+	frame.zonesCount = 0;
+	frame.resolved = false;
+	m_stackCount = 0;
+	m_droppedDepth = 0;
+
+	BeginZone(commandList, "Frame");
+}
+
+void D3D12GpuProfiler::EndFrame(ID3D12GraphicsCommandList* commandList)
+{
+	while (m_stackCount)
+	{
+		EndZone(commandList);
+	}
+
+	FrameSlot& frame = m_frames[m_currentFrame];
+	if (frame.zonesCount == 0)
+		return;
+
+	uint32 firstQuery = m_currentFrame * s_QueriesPerFrame;
+	commandList->ResolveQueryData(m_queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, firstQuery, frame.zonesCount * 2, m_readbackBuffer, sizeof(uint64) * firstQuery);
+	frame.resolved = true;
+}
+
+void D3D12GpuProfiler::BeginZone(ID3D12GraphicsCommandList* commandList, const char* name)
+{
+	FrameSlot& frame = m_frames[m_currentFrame];
+	if (frame.zonesCount == s_MaxZones || m_droppedDepth)
+	{
+		m_droppedDepth++;
+		return;
+	}
+
+	uint32 zoneIndex = frame.zonesCount++;
+	frame.zones[zoneIndex].name = name;
+	frame.zones[zoneIndex].depth = m_stackCount;
+	m_stack[m_stackCount++] = zoneIndex;
+
+	commandList->EndQuery(m_queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, m_currentFrame * s_QueriesPerFrame + zoneIndex * 2);
+}
+
+void D3D12GpuProfiler::EndZone(ID3D12GraphicsCommandList* commandList)
+{
+	if (m_droppedDepth)
+	{
+		m_droppedDepth--;
+		return;
+	}
+
+	if (m_stackCount == 0)
+		return;
+
+	uint32 zoneIndex = m_stack[--m_stackCount];
+	commandList->EndQuery(m_queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, m_currentFrame * s_QueriesPerFrame + zoneIndex * 2 + 1);
+}
+
+void D3D12GpuProfiler::ReadBack(uint32 frameIndex)
+{
+	FrameSlot& frame = m_frames[frameIndex];
+	if (!frame.resolved)
+		return;
+	frame.resolved = false;
+
+	uint32 firstQuery = frameIndex * s_QueriesPerFrame;
+	CD3DX12_RANGE readRange(sizeof(uint64) * firstQuery, sizeof(uint64) * (firstQuery + frame.zonesCount * 2));
+	uint64* mappedData = nullptr;
+	if (FAILED(m_readbackBuffer->Map(0, &readRange, reinterpret_cast<void**>(&mappedData))))
+		return;
+
+	const uint64* timestamps = mappedData + firstQuery;
+
+	// Both clocks sampled at once map GPU timestamps onto the CPU timeline.
+	uint64 gpuCalibration = 0;
+	uint64 cpuCalibration = 0;
+	bool calibrated = m_trackId && SUCCEEDED(m_renderer->GetCommandQueue()->GetClockCalibration(&gpuCalibration, &cpuCalibration));
+	double cpuTicksPerGpuTick = static_cast<double>(Profiler::GetTicksPerSecond()) / static_cast<double>(m_gpuFrequency);
+
+	m_timingsCount = frame.zonesCount;
+	for (uint32 i = 0; i < frame.zonesCount; i++)
+	{
+		uint64 begin = timestamps[i * 2];
+		uint64 end = timestamps[i * 2 + 1];
+		end = end > begin ? end : begin;
+
+		GpuZoneTiming& timing = m_timings[i];
+		timing.name = frame.zones[i].name;
+		timing.depth = frame.zones[i].depth;
+		timing.milliseconds = static_cast<float>(static_cast<double>(end - begin) * 1000.0 / static_cast<double>(m_gpuFrequency));
+
+		if (calibrated)
+		{
+			uint64 cpuBegin = cpuCalibration + static_cast<int64>(static_cast<double>(static_cast<int64>(begin - gpuCalibration)) * cpuTicksPerGpuTick);
+			uint64 cpuEnd = cpuCalibration + static_cast<int64>(static_cast<double>(static_cast<int64>(end - gpuCalibration)) * cpuTicksPerGpuTick);
+			Profiler::AddZone(m_trackId, timing.name, cpuBegin, cpuEnd, timing.depth);
+		}
+	}
+
+	CD3DX12_RANGE writeRange(0, 0);
+	m_readbackBuffer->Unmap(0, &writeRange);
+}
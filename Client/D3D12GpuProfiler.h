@@ -0,0 +1,81 @@
+#pragma once
+
+class D3D12Renderer;
+
+struct GpuZoneTiming
+{
+	const char* name = nullptr;
+	uint32 depth = 0;
+	float milliseconds = 0.0f;
+};
+
+/*
+=====================
+D3D12GpuProfiler
+=====================
+*/
+
+// Times passes on the GPU with timestamp queries written around them on the
+// frame's command list. Each frame in flight resolves into its own slice of a
+// readback buffer, which is read when that slot comes around again, so nothing
+// waits on the GPU. Zones are converted to CPU ticks with the queue's clock
+// calibration and added to the profiler's "GPU" track.
+class D3D12GpuProfiler
+{
+public:
+	void Init(D3D12Renderer* renderer, uint32 framesCount);
+	// Every frame recorded must have completed on the GPU.
+	void Clean();
+
+	// framesCount frames ago must have completed on the GPU: its timings are
+	// read back here before its slot is reused. Opens the "Frame" zone.
+	void BeginFrame(ID3D12GraphicsCommandList* commandList);
+	// Closes the "Frame" zone and resolves the frame's queries.
+	void EndFrame(ID3D12GraphicsCommandList* commandList);
+
+	// name must outlive the profiler. Zones past s_MaxZones are dropped.
+	void BeginZone(ID3D12GraphicsCommandList* commandList, const char* name);
+	void EndZone(ID3D12GraphicsCommandList* commandList);
+
+	// Of the newest frame read back, in BeginZone order; the first is the frame.
+	inline const GpuZoneTiming* GetZoneTimings() { return m_timings; }
+	inline uint32 GetZoneTimingsCount() { return m_timingsCount; }
+	inline float GetFrameMilliseconds() { return m_timingsCount ? m_timings[0].milliseconds : 0.0f; }
+
+private:
+	static const uint32 s_MaxZones = 64;
+	static const uint32 s_QueriesPerFrame = s_MaxZones * 2;
+
+	struct Zone
+	{
+		const char* name = nullptr;
+		uint32 depth = 0;
+	};
+
+	struct FrameSlot
+	{
+		Zone zones[s_MaxZones] = {};
+		uint32 zonesCount = 0;
+		bool resolved = false;
+	};
+
+	D3D12Renderer* m_renderer = nullptr;
+	ID3D12QueryHeap* m_queryHeap = nullptr;
+	ID3D12Resource* m_readbackBuffer = nullptr;
+	uint64 m_gpuFrequency = 0;
+	uint32 m_trackId = 0;
+
+	FrameSlot* m_frames = nullptr;
+	uint32 m_framesCount = 0;
+	uint32 m_currentFrame = 0;
+
+	// Open zones of the frame being recorded, as indices into its zones.
+	uint32 m_stack[s_MaxZones] = {};
+	uint32 m_stackCount = 0;
+	uint32 m_droppedDepth = 0;
+
+	GpuZoneTiming m_timings[s_MaxZones] = {};
+	uint32 m_timingsCount = 0;
+
+	void ReadBack(uint32 frameIndex);
+};
@@ -0,0 +1,281 @@
+#include "pch.h"
+#include "D3D12MaterialSystem.h"
+#include "D3D12PipelineCache.h"
+#include "D3D12Renderer.h"
+#include "D3D12RHI.h"
+#include "D3D12ShaderCache.h"
+#include "D3D12Utils.h"
+#include "D3D12VirtualTexture.h"
+
+/*
+=====================
+D3D12MaterialSystem
+=====================
+*/
+
+// Indexed by feature bit.
+static const char* const MATERIAL_FEATURE_DEFINES[MATERIAL_FEATURES_COUNT] =
+{
+	"USE_VERTEX_COLOR",
+	"USE_ALBEDO_TEXTURE",
+	"USE_ALPHA_TEST",
+	"USE_VIRTUAL_TEXTURE",
+};
+
+static const D3D12_INPUT_ELEMENT_DESC MATERIAL_INPUT_ELEMENTS[] =
+{
+	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 28, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+};
+
+void D3D12MaterialSystem::Init(D3D12Renderer* renderer)
+{
+	m_renderer = renderer;
+	m_device = renderer->GetDevice();
+
+	CreateConstantBuffer();
+
+	// Created up front so other permutations always have something to draw with.
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+	ID3DBlob* vertexShader = nullptr;
+	ID3DBlob* pixelShader = nullptr;
+	BuildPipelineDesc(0, &psoDesc, &vertexShader, &pixelShader);
+	if (vertexShader && pixelShader)
+		m_fallbackPipelineState = m_renderer->GetPipelineCache()->GetPipelineState(psoDesc);
+
+	if (vertexShader)
+	{
+		vertexShader->Release();
+		vertexShader = nullptr;
+	}
+
+	if (pixelShader)
+	{
+		pixelShader->Release();
+		pixelShader = nullptr;
+	}
+}
+
+void D3D12MaterialSystem::Clean()
+{
+	for (uint32 i = 0; i < s_MaxMaterials; i++)
+	{
+		if (m_materials[i])
+			DestroyMaterial(m_materials[i]);
+	}
+
+	if (m_fallbackPipelineState)
+	{
+		m_fallbackPipelineState->Release();
+		m_fallbackPipelineState = nullptr;
+	}
+
+	DestroyConstantBuffer();
+}
+
+Material* D3D12MaterialSystem::CreateMaterial(const MaterialDesc& desc)
+{
+	uint32 index = MATERIAL_INVALID_INDEX;
+	for (uint32 i = 0; i < s_MaxMaterials; i++)
+	{
+		if (!m_materials[i])
+		{
+			index = i;
+			break;
+		}
+	}
+
+	if (index == MATERIAL_INVALID_INDEX)
+		return nullptr;
+
+	uint32 features = desc.features & (MATERIAL_PERMUTATIONS_COUNT - 1);
+
+	Material* material = new Material;
+	material->index = index;
+
+	if ((features & MATERIAL_FEATURE_ALBEDO_TEXTURE) && desc.albedoTexture)
+	{
+		D3D12BindlessHeap* bindlessHeap = m_renderer->GetBindlessHeap();
+		material->albedoDescriptor = bindlessHeap->Allocate();
+		if (material->albedoDescriptor != BINDLESS_INVALID_INDEX)
+			material->albedoTexture = m_renderer->CreateStreamedTexture(desc.albedoTexture, bindlessHeap->GetCpuHandle(material->albedoDescriptor));
+	}
+
+	// Shaders never read the descriptor without the feature, so it is left unwritten.
+	if (!material->albedoTexture)
+	{
+		features &= ~MATERIAL_FEATURE_ALBEDO_TEXTURE;
+		m_renderer->GetBindlessHeap()->Free(material->albedoDescriptor);
+		material->albedoDescriptor = BINDLESS_INVALID_INDEX;
+	}
+
+	if ((features & MATERIAL_FEATURE_VIRTUAL_TEXTURE) && desc.virtualTexture)
+		material->virtualTexture = m_renderer->CreateVirtualTexture(desc.virtualTexture);
+
+	if (!material->virtualTexture)
+		features &= ~MATERIAL_FEATURE_VIRTUAL_TEXTURE;
+	material->features = features;
+
+	MaterialConstants& constants = m_mappedConstants[index];
+	constants = {};
+	constants.baseColor = desc.baseColor;
+	constants.alphaCutoff = desc.alphaCutoff;
+	constants.albedoTexture = material->albedoDescriptor;
+	if (material->virtualTexture)
+	{
+		constants.virtualTexture = material->virtualTexture->GetTextureIndex();
+		constants.virtualResidencyMap = material->virtualTexture->GetResidencyMapIndex();
+		constants.virtualFeedback = material->virtualTexture->GetFeedbackIndex();
+		constants.virtualTextureConstants = material->virtualTexture->GetConstants();
+	}
+
+	AcquirePermutation(features);
+
+	m_materials[index] = material;
+	return material;
+}
+
+void D3D12MaterialSystem::DestroyMaterial(Material* material)
+{
+	if (!material)
+		return;
+
+	ReleasePermutation(material->features);
+
+	m_renderer->DestroyTexture(material->albedoTexture);
+	material->albedoTexture = nullptr;
+
+	m_renderer->GetBindlessHeap()->Free(material->albedoDescriptor);
+	material->albedoDescriptor = BINDLESS_INVALID_INDEX;
+
+	m_renderer->DestroyVirtualTexture(material->virtualTexture);
+	material->virtualTexture = nullptr;
+
+	m_materials[material->index] = nullptr;
+	delete material;
+}
+
+RHIPipeline* D3D12MaterialSystem::GetPipeline(const Material* material)
+{
+	PipelineHandle* pipeline = m_permutations[material->features].pipeline;
+	ID3D12PipelineState* pipelineState = pipeline ? m_renderer->GetPipelineCache()->Resolve(pipeline) : nullptr;
+	return D3D12RHIDevice::ToRHIPipeline(pipelineState);
+}
+
+D3D12_INPUT_LAYOUT_DESC D3D12MaterialSystem::GetInputLayout() const
+{
+	return { MATERIAL_INPUT_ELEMENTS, _countof(MATERIAL_INPUT_ELEMENTS) };
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS D3D12MaterialSystem::GetConstantsAddress()
+{
+	return m_constantBuffer->GetGPUVirtualAddress();
+}
+
+void D3D12MaterialSystem::GetShaderDefines(uint32 features, D3D_SHADER_MACRO* outDefines)
+{
+	uint32 definesCount = 0;
+	for (uint32 i = 0; i < MATERIAL_FEATURES_COUNT; i++)
+	{
+		if (features & (1 << i))
+			outDefines[definesCount++] = { MATERIAL_FEATURE_DEFINES[i], "1" };
+	}
+
+	outDefines[definesCount] = { nullptr, nullptr };
+}
+
+void D3D12MaterialSystem::CreateConstantBuffer()
+{
+	ThrowIfFailed(m_device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(sizeof(MaterialConstants) * s_MaxMaterials),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&m_constantBuffer)));
+
+	ThrowIfFailed(m_constantBuffer->Map(0, nullptr, reinterpret_cast<void**>(&m_mappedConstants)));
+}
+
+void D3D12MaterialSystem::DestroyConstantBuffer()
+{
+	if (m_constantBuffer)
+	{
+		m_constantBuffer->Unmap(0, nullptr);
+		m_mappedConstants = nullptr;
+
+		m_renderer->DeferRelease(m_constantBuffer);
+		m_constantBuffer = nullptr;
+	}
+}
+
+void D3D12MaterialSystem::BuildPipelineDesc(uint32 features, D3D12_GRAPHICS_PIPELINE_STATE_DESC* outDesc, ID3DBlob** outVertexShader, ID3DBlob** outPixelShader)
+{
+	D3D_SHADER_MACRO defines[MATERIAL_FEATURES_COUNT + 1] = {};
+	GetShaderDefines(features, defines);
+
+	D3D12ShaderCache* shaderCache = m_renderer->GetShaderCache();
+	*outVertexShader = shaderCache->GetShader(MATERIAL_SHADER_FILENAME, "VSMain", MATERIAL_VERTEX_SHADER_TARGET, defines);
+	*outPixelShader = shaderCache->GetShader(MATERIAL_SHADER_FILENAME, "PSMain", MATERIAL_PIXEL_SHADER_TARGET, defines);
+	if (!*outVertexShader || !*outPixelShader)
+	{
+		ThrowIfFailed(E_FAIL);
+		return;
+	}
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC& psoDesc = *outDesc;
+	psoDesc = {};
+	psoDesc.InputLayout = GetInputLayout();
+	psoDesc.pRootSignature = m_renderer->GetBindlessHeap()->GetRootSignature();
+	psoDesc.VS = { (*outVertexShader)->GetBufferPointer(), (*outVertexShader)->GetBufferSize() };
+	psoDesc.PS = { (*outPixelShader)->GetBufferPointer(), (*outPixelShader)->GetBufferSize() };
+	psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+	psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+	psoDesc.SampleMask = UINT_MAX;
+	psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	psoDesc.NumRenderTargets = 1;
+	psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+	psoDesc.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	psoDesc.SampleDesc.Count = 1;
+}
+
+void D3D12MaterialSystem::AcquirePermutation(uint32 features)
+{
+	Permutation& permutation = m_permutations[features];
+	if (permutation.materialsCount++ > 0)
+		return;
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+	ID3DBlob* vertexShader = nullptr;
+	ID3DBlob* pixelShader = nullptr;
+	BuildPipelineDesc(features, &psoDesc, &vertexShader, &pixelShader);
+	if (vertexShader && pixelShader)
+		permutation.pipeline = m_renderer->GetPipelineCache()->RequestPipelineState(psoDesc, m_fallbackPipelineState);
+
+	if (vertexShader)
+	{
+		vertexShader->Release();
+		vertexShader = nullptr;
+	}
+
+	if (pixelShader)
+	{
+		pixelShader->Release();
+		pixelShader = nullptr;
+	}
+}
+
+void D3D12MaterialSystem::ReleasePermutation(uint32 features)
+{
+	Permutation& permutation = m_permutations[features];
+	if (--permutation.materialsCount > 0)
+		return;
+
+	if (permutation.pipeline)
+	{
+		m_renderer->GetPipelineCache()->ReleasePipelineState(permutation.pipeline);
+		permutation.pipeline = nullptr;
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "D3D12BindlessHeap.h"
+#include "../Common/RHI.h"
+
+class D3D12Renderer;
+class D3D12VirtualTexture;
+struct PipelineHandle;
+struct TextureHandle;
+
+const uint32 MATERIAL_INVALID_INDEX = 0xffffffff;
+
+// Every material pipeline is built from these, with the defines from
+// D3D12MaterialSystem::GetShaderDefines. 5.1 for the unbounded texture array.
+const char MATERIAL_SHADER_FILENAME[] = "shaders.hlsl";
+const char MATERIAL_VERTEX_SHADER_TARGET[] = "vs_5_1";
+const char MATERIAL_PIXEL_SHADER_TARGET[] = "ps_5_1";
+
+struct MaterialDesc
+{
+	uint32 features = 0;					// MATERIAL_FEATURE flags.
+	Vector4 baseColor = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+	float alphaCutoff = 0.5f;				// Used with MATERIAL_FEATURE_ALPHA_TEST.
+	const char* albedoTexture = nullptr;	// Streamed DDS, used with MATERIAL_FEATURE_ALBEDO_TEXTURE.
+	const char* virtualTexture = nullptr;	// Tiled DDS, used with MATERIAL_FEATURE_VIRTUAL_TEXTURE.
+};
+
+struct Material
+{
+	uint32 index = MATERIAL_INVALID_INDEX;
+	uint32 features = 0;
+	TextureHandle* albedoTexture = nullptr;
+	uint32 albedoDescriptor = BINDLESS_INVALID_INDEX;
+	D3D12VirtualTexture* virtualTexture = nullptr;
+};
+
+/*
+=====================
+D3D12MaterialSystem
+=====================
+*/
+
+// Material constants live in a structured buffer indexed by ObjectConstants,
+// and name their textures by bindless heap index. The pipeline for a feature
+// combination is requested when the first material needs it and released
+// with the last one. Permutations compile in the background and draw with the
+// featureless pipeline until they are ready.
+class D3D12MaterialSystem
+{
+public:
+	void Init(D3D12Renderer* renderer);
+	// Every material must have been destroyed.
+	void Clean();
+
+	// Returns nullptr when every material slot is taken. Features whose data is
+	// missing, such as a texture that fails to load, are dropped.
+	Material* CreateMaterial(const MaterialDesc& desc);
+	void DestroyMaterial(Material* material);
+
+	// Pipeline to draw the material with on top of D3D12BindlessHeap::Bind; the
+	// material index goes in ObjectConstants. Returns nullptr when the material
+	// cannot be drawn yet.
+	RHIPipeline* GetPipeline(const Material* material);
+	// The engine's Vertex, shared by every pipeline over the bindless root signature.
+	D3D12_INPUT_LAYOUT_DESC GetInputLayout() const;
+
+	// For BINDLESS_ROOT_PARAMETER_MATERIALS.
+	D3D12_GPU_VIRTUAL_ADDRESS GetConstantsAddress();
+
+	// Defines for the permutation of MATERIAL_FEATURE flags, closed by an empty
+	// macro. outDefines holds MATERIAL_FEATURES_COUNT + 1 entries.
+	static void GetShaderDefines(uint32 features, D3D_SHADER_MACRO* outDefines);
+
+private:
+	static const uint32 s_MaxMaterials = 256;
+
+	struct Permutation
+	{
+		PipelineHandle* pipeline = nullptr;
+		uint32 materialsCount = 0;
+	};
+
+	D3D12Renderer* m_renderer = nullptr;
+	ID3D12Device* m_device = nullptr;
+	ID3D12PipelineState* m_fallbackPipelineState = nullptr;
+	Permutation m_permutations[MATERIAL_PERMUTATIONS_COUNT] = {};
+
+	// Persistently mapped; a slot is written once when its material is created.
+	ID3D12Resource* m_constantBuffer = nullptr;
+	MaterialConstants* m_mappedConstants = nullptr;
+
+	Material* m_materials[s_MaxMaterials] = {};
+
+	void CreateConstantBuffer();
+	void DestroyConstantBuffer();
+
+	void BuildPipelineDesc(uint32 features, D3D12_GRAPHICS_PIPELINE_STATE_DESC* outDesc, ID3DBlob** outVertexShader, ID3DBlob** outPixelShader);
+	void AcquirePermutation(uint32 features);
+	void ReleasePermutation(uint32 features);
+};
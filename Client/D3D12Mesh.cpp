@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "D3D12Mesh.h"
 #include "D3D12Utils.h"
+#include "D3D12MaterialSystem.h"
 #include "D3D12Renderer.h"
 
 /*
@@ -9,76 +10,106 @@ D3D12Mesh.
 ================
 */
 
-uint32 D3D12Mesh::sm_refCount = 0;
-ID3D12RootSignature* D3D12Mesh::sm_rootSignature = nullptr;
-ID3D12PipelineState* D3D12Mesh::sm_pipelineState = nullptr;
-
 bool D3D12Mesh::Init(D3D12Renderer* renderer, MeshData meshData)
 {
 	m_renderer = renderer;
 	m_meshData = meshData;
 
-	ID3D12Device* device = m_renderer->GetDevice();
+	if (m_meshData.indicesCount == 0 || m_meshData.verticesCount == 0)
+		return false;
+
+	CreateLods();
+	CreateMeshlets();
 
-	if (sm_refCount == 0)
+	// LOD 0 goes in meshlet order so each meshlet is a contiguous index range.
+	Index* indices = new Index[m_lodChain.indicesCount];
+	::memcpy(indices, m_lodChain.indices, sizeof(Index) * m_lodChain.indicesCount);
+	if (m_meshletData.meshletsCount)
 	{
-		CreateRootSignature();
-		CreatePipelineState();
+		MeshletBuilder::ExpandIndices(m_meshletData, indices);
 	}
 
-	// Create buffers.
-	m_vertexBuffer = D3D12Utils::CreateVertexBuffer(device, meshData.vertices, meshData.verticesCount, meshData.verticesSize, sizeof(Vertex));
-	m_indexBuffer = D3D12Utils::CreateIndexBuffer(device, meshData.indices, meshData.indicesCount, meshData.indicesSize, DXGI_FORMAT_R32_UINT);
+	CreateResources(m_meshData.vertices, m_meshData.verticesCount, indices, m_lodChain.indicesCount);
+
+	delete[] indices;
+	indices = nullptr;
+
+	return true;
+}
+
+bool D3D12Mesh::Init(D3D12Renderer* renderer, const char* filename)
+{
+	m_renderer = renderer;
 
-	// Create const buffer.
-	CreateDesciptorHeap();
-	CreateConstantBuffer();
-	// Create texture.
-	CreateTextureResource();
+	MeshFileView view = {};
+	if (!MeshFile::Open(filename, &view))
+		return false;
 
-	sm_refCount++;
+	const MeshFileHeader* header = view.header;
+
+	// Only the small tables used for CPU culling and LOD selection are copied.
+	// Vertex and index blobs go from the mapping straight into the upload ring.
+	m_lodChain.lodsCount = header->lodsCount;
+	m_lodChain.indicesCount = header->indicesCount;
+	::memcpy(m_lodChain.lods, view.lods, sizeof(MeshLod) * header->lodsCount);
+
+	if (header->meshletsCount && (header->flags & MESH_FILE_FLAG_MESHLET_ORDERED))
+	{
+		m_meshletData.meshletsCount = header->meshletsCount;
+		m_meshletData.meshlets = new Meshlet[header->meshletsCount];
+		m_meshletData.bounds = new MeshletBounds[header->meshletsCount];
+		::memcpy(m_meshletData.meshlets, view.meshlets, sizeof(Meshlet) * header->meshletsCount);
+		::memcpy(m_meshletData.bounds, view.meshletBounds, sizeof(MeshletBounds) * header->meshletsCount);
+
+		m_drawRanges = new DrawRange[header->meshletsCount];
+		m_drawRangesCount = 0;
+	}
+
+	m_boundsCenter = header->boundsCenter;
+	m_boundsRadius = header->boundsRadius;
+
+	CreateResources(view.vertices, header->verticesCount, view.indices, header->indicesCount);
+
+	MeshFile::Close(&view);
 
 	return true;
 }
 
+void D3D12Mesh::CreateResources(const Vertex* vertices, uint32 verticesCount, const Index* indices, uint32 indicesCount)
+{
+	RHIDevice* rhi = m_renderer->GetRHI();
+
+	// Create buffers.
+	RHIBufferDesc vertexBufferDesc;
+	vertexBufferDesc.usage = RHI_BUFFER_USAGE_VERTEX;
+	vertexBufferDesc.size = sizeof(Vertex) * verticesCount;
+	vertexBufferDesc.stride = sizeof(Vertex);
+	m_vertexBuffer = rhi->CreateBuffer(vertexBufferDesc, vertices);
+
+	RHIBufferDesc indexBufferDesc;
+	indexBufferDesc.usage = RHI_BUFFER_USAGE_INDEX;
+	indexBufferDesc.size = sizeof(Index) * indicesCount;
+	indexBufferDesc.stride = sizeof(Index);
+	m_indexBuffer = rhi->CreateBuffer(indexBufferDesc, indices);
+}
+
 void D3D12Mesh::Clean()
 {
-	DestroyTextureResource();
-	DestroyConstantBuffer();
-	DestroyDescriptorHeap();
+	DestroyLods();
+	DestroyMeshlets();
 
 	if (m_indexBuffer)
 	{
-		m_indexBuffer->upload->Release();
-		m_indexBuffer->upload = nullptr;
-
-		m_indexBuffer->resource->Release();
-		m_indexBuffer->resource = nullptr;
-
-		delete m_indexBuffer;
+		m_renderer->GetRHI()->DestroyBuffer(m_indexBuffer);
 		m_indexBuffer = nullptr;
 	}
 
 	if (m_vertexBuffer)
 	{
-		m_vertexBuffer->upload->Release();
-		m_vertexBuffer->upload = nullptr;
-
-		m_vertexBuffer->resource->Release();
-		m_vertexBuffer->resource = nullptr;
-
-		delete m_vertexBuffer;
+		m_renderer->GetRHI()->DestroyBuffer(m_vertexBuffer);
 		m_vertexBuffer = nullptr;
 	}
 
-	uint32 refCount = --sm_refCount;
-
-	if (refCount == 0)
-	{
-		DestroyPipelineState();
-		DestroyRootSignature();
-	}
-
 	// TODO
 	if (m_meshData.vertices)
 	{
@@ -100,218 +131,167 @@ void D3D12Mesh::UpdateWorldMatrix(Matrix worldRow)
 
 void D3D12Mesh::Update()
 {
-	m_constData.world = m_worldRow;
-	m_constData.world = m_constData.world.Transpose();
-	m_constData.view = DirectX::XMMatrixLookToLH(Vector3(0.0f, 0.0f, -1.0f), Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 1.0f, 0.0f));
-	m_constData.view = m_constData.view.Transpose();
-	m_constData.proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(70.0f), m_renderer->GetAspectRatio(), 0.1f, 100.0f);
-	m_constData.proj = m_constData.proj.Transpose();
+	const Vector3& eyePos = m_renderer->GetEyePosition();
+	const Matrix& view = m_renderer->GetViewMatrix();
+	const Matrix& proj = m_renderer->GetProjMatrix();
 
-	uint32 bufferSize = D3D12Utils::CalcConstantBufferByteSize(sizeof(ConstBufferData));
+	float pixelsPerUnit = CalcPixelsPerUnit(view, proj);
+	SelectLod(pixelsPerUnit);
 
-	::memcpy(m_mappedData, &m_constData, bufferSize);
-}
+	// The texture is mapped once over the mesh, so its on-screen size is the bounds' diameter.
+	if (m_material)
+		m_renderer->RequestTextureResolution(m_material->albedoTexture, 2.0f * m_boundsRadius * pixelsPerUnit);
 
-void D3D12Mesh::Render(ID3D12GraphicsCommandList* commandList)
-{
-	commandList->SetGraphicsRootSignature(sm_rootSignature);
-	commandList->SetPipelineState(sm_pipelineState);
-	commandList->SetDescriptorHeaps(1, &m_cbvHeap);
-	commandList->SetGraphicsRootDescriptorTable(0, m_cbvHeap->GetGPUDescriptorHandleForHeapStart());
-	// Record commands.
-	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	commandList->IASetVertexBuffers(0, 1, &m_vertexBuffer->vertexBufferView);
-	commandList->IASetIndexBuffer(&m_indexBuffer->indexBufferView);
-	commandList->DrawIndexedInstanced(m_meshData.indicesCount, 1, 0, 0, 0);
+	if (m_currentLod == 0 && m_meshletData.meshletsCount)
+	{
+		CullMeshlets(m_worldRow * view * proj, Vector3::Transform(eyePos, m_worldRow.Invert()));
+	}
 }
 
-void D3D12Mesh::CreateRootSignature()
+void D3D12Mesh::Render(RHICommandList* commandList)
 {
-	ID3D12Device* device = m_renderer->GetDevice();
-
-	// Create a single descriptor table of CBVs.
-	CD3DX12_DESCRIPTOR_RANGE cbvTable[2];
-	cbvTable[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0);
-	cbvTable[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
-	// Root parameter can be a table, root descriptor or root constants.
-	CD3DX12_ROOT_PARAMETER slotRootParameter[1];
-	slotRootParameter[0].InitAsDescriptorTable(_countof(cbvTable), cbvTable);
+	if (!m_material)
+		return;
 
-	CD3DX12_STATIC_SAMPLER_DESC linearClamp(0, D3D12_FILTER_MIN_MAG_MIP_LINEAR, D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_CLAMP);
+	RHIPipeline* pipeline = m_renderer->GetMaterialSystem()->GetPipeline(m_material);
+	if (!pipeline)
+		return;
 
-	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
-	rootSignatureDesc.Init(_countof(slotRootParameter), slotRootParameter, 1, &linearClamp, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+	ObjectConstants constants = {};
+	constants.world = m_worldRow.Transpose();
+	constants.materialIndex = m_material->index;
+	if (!commandList->SetConstants(RHI_CONSTANTS_SLOT_OBJECT, &constants, sizeof(constants)))
+		return;
 
-	ID3DBlob* signature = nullptr;
-	ID3DBlob* error = nullptr;
-	ThrowIfFailed(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error));
-	ThrowIfFailed(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&sm_rootSignature)));
+	// Everything else was bound once for the command list.
+	commandList->SetPipeline(pipeline);
+	commandList->SetVertexBuffer(m_vertexBuffer);
+	commandList->SetIndexBuffer(m_indexBuffer);
 
-	if (signature)
-	{
-		signature->Release();
-		signature = nullptr;
-	}
-	if (error)
+	if (m_currentLod > 0)
 	{
-		error->Release();
-		error = nullptr;
+		const MeshLod& lod = m_lodChain.lods[m_currentLod];
+		commandList->DrawIndexed(lod.indicesCount, lod.indexOffset, 0);
+		return;
 	}
-}
 
-void D3D12Mesh::CreatePipelineState()
-{
-	ID3D12Device* device = m_renderer->GetDevice();
-
-	ID3DBlob* vertexShader = nullptr;
-	ID3DBlob* pixelShader = nullptr;
-
-#if defined(_DEBUG)
-	// Enable better shader debugging with the graphics debugging tools.
-	UINT compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#else
-	UINT compileFlags = 0;
-#endif
-	ThrowIfFailed(D3DCompileFromFile(L"shaders.hlsl", nullptr, nullptr, "VSMain", "vs_5_0", compileFlags, 0, &vertexShader, nullptr));
-	ThrowIfFailed(D3DCompileFromFile(L"shaders.hlsl", nullptr, nullptr, "PSMain", "ps_5_0", compileFlags, 0, &pixelShader, nullptr));
-
-	// Define the vertex input layout.
-	D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
-	{
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 28, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-	};
-
-	// Describe and create the graphics pipeline state object (PSO).
-	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
-	psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
-	psoDesc.pRootSignature = sm_rootSignature;
-	psoDesc.VS = { reinterpret_cast<UINT8*>(vertexShader->GetBufferPointer()), vertexShader->GetBufferSize() };
-	psoDesc.PS = { reinterpret_cast<UINT8*>(pixelShader->GetBufferPointer()), pixelShader->GetBufferSize() };
-	psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
-	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
-	psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
-	psoDesc.SampleMask = UINT_MAX;
-	psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-	psoDesc.NumRenderTargets = 1;
-	psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
-	psoDesc.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
-	psoDesc.SampleDesc.Count = 1;
-	ThrowIfFailed(device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&sm_pipelineState)));
-
-	if (vertexShader)
+	if (m_meshletData.meshletsCount)
 	{
-		vertexShader->Release();
-		vertexShader = nullptr;
+		for (uint32 i = 0; i < m_drawRangesCount; i++)
+		{
+			commandList->DrawIndexed(m_drawRanges[i].indexCount, m_drawRanges[i].startIndex, 0);
+		}
+		return;
 	}
 
-	if (pixelShader)
-	{
-		pixelShader->Release();
-		pixelShader = nullptr;
-	}
+	commandList->DrawIndexed(m_lodChain.lods[0].indicesCount, 0, 0);
 }
 
-void D3D12Mesh::CreateDesciptorHeap()
+void D3D12Mesh::CreateMeshlets()
 {
-	ID3D12Device* device = m_renderer->GetDevice();
-
-	D3D12_DESCRIPTOR_HEAP_DESC cbvsrvHeapDesc = {};
-	cbvsrvHeapDesc.NumDescriptors = 2;
-	cbvsrvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	cbvsrvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	ThrowIfFailed(device->CreateDescriptorHeap(&cbvsrvHeapDesc, IID_PPV_ARGS(&m_cbvHeap)));
+	if (m_meshData.indicesCount / 3 < MESHLET_MIN_MESH_TRIANGLES || !MeshletBuilder::Build(m_meshData, &m_meshletData))
+		return;
 
-	m_cbvsrvDesciptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	m_drawRanges = new DrawRange[m_meshletData.meshletsCount];
+	m_drawRangesCount = 0;
 }
 
-void D3D12Mesh::CreateConstantBuffer()
+void D3D12Mesh::CreateLods()
 {
-	ID3D12Device* device = m_renderer->GetDevice();
-
-	uint32 bufferCount = 1;
-	uint32 bufferSize = D3D12Utils::CalcConstantBufferByteSize(sizeof(ConstBufferData));
-
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(bufferSize * bufferCount),
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&m_constBuffer)));
+	if (m_meshData.verticesCount == 0 || m_meshData.indicesCount == 0)
+		return;
 
-	ThrowIfFailed(m_constBuffer->Map(0, nullptr, reinterpret_cast<void**>(&m_mappedData)));
-
-	D3D12_GPU_VIRTUAL_ADDRESS cbAddress = m_constBuffer->GetGPUVirtualAddress();
-	// Offset to the ith object constant buffer in the buffer.
-	int32 boxCBufIndex = 0;
-	cbAddress += boxCBufIndex * bufferSize;
-
-	D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc;
-	cbvDesc.BufferLocation = cbAddress;
-	cbvDesc.SizeInBytes = bufferSize;
-
-	device->CreateConstantBufferView(&cbvDesc, m_cbvHeap->GetCPUDescriptorHandleForHeapStart());
-}
-
-void D3D12Mesh::DestroyRootSignature()
-{
-	if (sm_rootSignature)
+	// Bounding sphere around the AABB center, used to project LOD errors.
+	Vector3 minPos = m_meshData.vertices[0].posModel;
+	Vector3 maxPos = minPos;
+	for (uint32 i = 1; i < m_meshData.verticesCount; i++)
 	{
-		sm_rootSignature->Release();
-		sm_rootSignature = nullptr;
+		minPos = Vector3::Min(minPos, m_meshData.vertices[i].posModel);
+		maxPos = Vector3::Max(maxPos, m_meshData.vertices[i].posModel);
 	}
-}
 
-void D3D12Mesh::DestroyPipelineState()
-{
-	if (sm_pipelineState)
+	m_boundsCenter = (minPos + maxPos) * 0.5f;
+	m_boundsRadius = 0.0f;
+	for (uint32 i = 0; i < m_meshData.verticesCount; i++)
 	{
-		sm_pipelineState->Release();
-		sm_pipelineState = nullptr;
+		float dist = Vector3::Distance(m_boundsCenter, m_meshData.vertices[i].posModel);
+		m_boundsRadius = dist > m_boundsRadius ? dist : m_boundsRadius;
 	}
+
+	MeshSimplifier::BuildLodChain(m_meshData, &m_lodChain);
+	m_currentLod = 0;
 }
 
-void D3D12Mesh::DestroyDescriptorHeap()
+float D3D12Mesh::CalcPixelsPerUnit(const Matrix& view, const Matrix& proj)
 {
-	if (m_cbvHeap)
-	{
-		m_cbvHeap->Release();
-		m_cbvHeap = nullptr;
-	}
+	// Screen-space size of one model unit at the depth of the bounding sphere.
+	Vector3 centerView = Vector3::Transform(Vector3::Transform(m_boundsCenter, m_worldRow), view);
+	float scale = Vector3(m_worldRow._11, m_worldRow._12, m_worldRow._13).Length();
+	float depth = centerView.z - m_boundsRadius * scale;
+	depth = depth > 0.1f ? depth : 0.1f;
+
+	return scale * proj._22 * m_renderer->GetScreenHeight() * 0.5f / depth;
 }
 
-void D3D12Mesh::CreateTextureResource()
+void D3D12Mesh::SelectLod(float pixelsPerUnit)
 {
-	ID3D12Device* device = m_renderer->GetDevice();
+	if (m_lodChain.lodsCount <= 1)
+		return;
 
-	CD3DX12_CPU_DESCRIPTOR_HANDLE srvHandle(m_cbvHeap->GetCPUDescriptorHandleForHeapStart(), m_cbvsrvDesciptorSize);
-	m_textureHandle = D3D12Utils::CreateTexture2D(device, L"../Assets/WoodCrate01.dds", srvHandle);
+	m_currentLod = MeshSimplifier::SelectLod(m_lodChain, pixelsPerUnit);
 }
 
-void D3D12Mesh::DestroyConstantBuffer()
+void D3D12Mesh::CullMeshlets(const Matrix& worldViewProj, const Vector3& cameraPosModel)
 {
-	if (m_constBuffer)
+	Vector4 planes[6];
+	MeshletCulling::ExtractFrustumPlanes(worldViewProj, planes);
+
+	m_drawRangesCount = 0;
+	uint32 culledCount = 0;
+	for (uint32 i = 0; i < m_meshletData.meshletsCount; i++)
 	{
-		m_constBuffer->Unmap(0, nullptr);
+		if (!MeshletCulling::IsVisible(m_meshletData.bounds[i], planes, cameraPosModel))
+		{
+			culledCount++;
+			continue;
+		}
+
+		const Meshlet& meshlet = m_meshletData.meshlets[i];
+		uint32 startIndex = meshlet.triangleOffset;
+		uint32 indexCount = meshlet.triangleCount * 3;
+
+		if (m_drawRangesCount > 0)
+		{
+			DrawRange& last = m_drawRanges[m_drawRangesCount - 1];
+			if (last.startIndex + last.indexCount == startIndex)
+			{
+				last.indexCount += indexCount;
+				continue;
+			}
+		}
 
-		m_constBuffer->Release();
-		m_constBuffer = nullptr;
+		m_drawRanges[m_drawRangesCount].startIndex = startIndex;
+		m_drawRanges[m_drawRangesCount].indexCount = indexCount;
+		m_drawRangesCount++;
 	}
+
+	m_renderer->GetFrameStats().Add(FRAME_STAT_CULLED_MESHLETS, culledCount);
 }
 
-void D3D12Mesh::DestroyTextureResource()
+void D3D12Mesh::DestroyMeshlets()
 {
-	if (m_textureHandle)
+	if (m_drawRanges)
 	{
-		if (m_textureHandle->resource)
-		{
-			m_textureHandle->resource->Release();
-			m_textureHandle->resource = nullptr;
-		}
-
-		delete m_textureHandle;
-		m_textureHandle = nullptr;
+		delete[] m_drawRanges;
+		m_drawRanges = nullptr;
 	}
+	m_drawRangesCount = 0;
+
+	MeshletBuilder::Destroy(&m_meshletData);
+}
+
+void D3D12Mesh::DestroyLods()
+{
+	MeshSimplifier::Destroy(&m_lodChain);
+	m_currentLod = 0;
 }
@@ -1,15 +1,18 @@
 #pragma once
 
 #include "../Common/Vertex.h"
+#include "../Common/MeshletBuilder.h"
+#include "../Common/MeshSimplifier.h"
+#include "../Common/MeshFile.h"
+#include "../Common/RHI.h"
 
-struct ConstBufferData
+struct DrawRange
 {
-	Matrix world;
-	Matrix view;
-	Matrix proj;
+	uint32 startIndex = 0;
+	uint32 indexCount = 0;
 };
 
-struct TextureHandle;
+struct Material;
 class D3D12Renderer;
 
 /*
@@ -22,43 +25,46 @@ class D3D12Mesh
 {
 public:
 	bool Init(D3D12Renderer* device, MeshData meshData);
+	// Loads a cooked mesh file. LODs and meshlets come precomputed from the file.
+	bool Init(D3D12Renderer* device, const char* filename);
 	void Clean();
 	void UpdateWorldMatrix(Matrix worldRow);
+	// The mesh is not drawn without a material. Materials can be shared between meshes.
+	inline void SetMaterial(const Material* material) { m_material = material; }
 	void Update();
-	void Render(ID3D12GraphicsCommandList* commandList);
+	void Render(RHICommandList* commandList);
 
 private:
-	static uint32 sm_refCount;
-	static ID3D12RootSignature* sm_rootSignature;
-	static ID3D12PipelineState* sm_pipelineState;
-
 	D3D12Renderer* m_renderer = nullptr;
 	// App resources.
-	VertexBuffer* m_vertexBuffer = nullptr;
-	IndexBuffer* m_indexBuffer = nullptr;
+	RHIBuffer* m_vertexBuffer = nullptr;
+	RHIBuffer* m_indexBuffer = nullptr;
 
-	ID3D12DescriptorHeap* m_cbvHeap = nullptr;
-	uint32 m_cbvsrvDesciptorSize = 0;
+	MeshData m_meshData = {};
 
-	ConstBufferData m_constData = {};
-	ID3D12Resource* m_constBuffer = nullptr;
-	BYTE* m_mappedData = nullptr;
+	// Large meshes are split into meshlets and culled per cluster. Visible
+	// meshlets that are adjacent in the index buffer are merged into one draw.
+	MeshletData m_meshletData = {};
+	DrawRange* m_drawRanges = nullptr;
+	uint32 m_drawRangesCount = 0;
 
-	MeshData m_meshData = {};
+	// LODs share the vertex buffer and are stored back to back in the index buffer.
+	MeshLodChain m_lodChain = {};
+	uint32 m_currentLod = 0;
+	Vector3 m_boundsCenter = {};
+	float m_boundsRadius = 0.0f;
 
 	Matrix m_worldRow = Matrix();
 
-	TextureHandle* m_textureHandle = nullptr;
+	const Material* m_material = nullptr;
 
-	void CreateRootSignature();
-	void CreatePipelineState();
-	void CreateDesciptorHeap();
-	void CreateConstantBuffer();
-	void CreateTextureResource();
+	void CreateResources(const Vertex* vertices, uint32 verticesCount, const Index* indices, uint32 indicesCount);
+	void CreateMeshlets();
+	void CreateLods();
+	void CullMeshlets(const Matrix& worldViewProj, const Vector3& cameraPosModel);
+	float CalcPixelsPerUnit(const Matrix& view, const Matrix& proj);
+	void SelectLod(float pixelsPerUnit);
 
-	void DestroyRootSignature();
-	void DestroyPipelineState();
-	void DestroyDescriptorHeap();
-	void DestroyConstantBuffer();
-	void DestroyTextureResource();
+	void DestroyMeshlets();
+	void DestroyLods();
 };
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "pch.h"
+#include "D3D12MipGenerator.h"
+#include "D3D12PipelineCache.h"
+#include "D3D12Renderer.h"
+#include "D3D12ShaderCache.h"
+#include "D3D12Utils.h"
+
+/*
+=====================
+D3D12MipGenerator
+=====================
+*/
+
+void D3D12MipGenerator::Init(D3D12Renderer* renderer)
+{
+	m_renderer = renderer;
+	m_device = renderer->GetDevice();
+	m_descriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	CreateRootSignature();
+	CreatePipelineState();
+	CreateDescriptorHeap();
+}
+
+void D3D12MipGenerator::Clean()
+{
+	if (m_descriptorHeap)
+	{
+		m_renderer->DeferRelease(m_descriptorHeap);
+		m_descriptorHeap = nullptr;
+	}
+
+	DestroyPipelineState();
+	DestroyRootSignature();
+}
+
+void D3D12MipGenerator::Generate(ID3D12GraphicsCommandList* commandList, ID3D12Resource* texture, DXGI_FORMAT format)
+{
+	D3D12_RESOURCE_DESC desc = texture->GetDesc();
+	if (!IsSupported(format) || desc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D || desc.DepthOrArraySize != 1 || !(desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS))
+	{
+		ThrowIfFailed(E_INVALIDARG);
+		return;
+	}
+
+	uint32 mipLevels = desc.MipLevels;
+	if (mipLevels < 2)
+		return;
+
+	// Every dispatch writes at least one mip, which bounds the descriptors needed.
+	if (m_descriptorsUsed + (mipLevels - 1) * s_DescriptorsPerDispatch > s_DescriptorHeapSize)
+	{
+		m_renderer->DeferRelease(m_descriptorHeap);
+		CreateDescriptorHeap();
+	}
+
+	commandList->SetComputeRootSignature(m_rootSignature);
+	commandList->SetPipelineState(m_pipelineState);
+	commandList->SetDescriptorHeaps(1, &m_descriptorHeap);
+
+	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	commandList->ResourceBarrier(1, &barrier);
+
+	bool isSrgb = format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+	DXGI_FORMAT uavFormat = GetUavFormat(format);
+	uint32 width = static_cast<uint32>(desc.Width);
+	uint32 height = desc.Height;
+
+	uint32 srcMip = 0;
+	while (srcMip + 1 < mipLevels)
+	{
+		uint32 srcWidth = width >> srcMip ? width >> srcMip : 1;
+		uint32 srcHeight = height >> srcMip ? height >> srcMip : 1;
+		uint32 dstWidth = srcWidth >> 1 ? srcWidth >> 1 : 1;
+		uint32 dstHeight = srcHeight >> 1 ? srcHeight >> 1 : 1;
+
+		// A group's later mips are exact only while the first one halves evenly;
+		// an axis that has reached 1 stays 1 and does not limit the other.
+		uint32 evenBits = (dstWidth == 1 ? dstHeight : dstWidth) | (dstHeight == 1 ? dstWidth : dstHeight);
+		uint32 mipsCount = 1;
+		while (mipsCount < s_MaxMipsPerDispatch && srcMip + mipsCount + 1 < mipLevels && ((evenBits >> (mipsCount - 1)) & 1) == 0)
+		{
+			mipsCount++;
+		}
+
+		// The SRV covers only the source mip, so the destinations can be in UNORDERED_ACCESS meanwhile.
+		CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(m_descriptorHeap->GetCPUDescriptorHandleForHeapStart(), m_descriptorsUsed, m_descriptorSize);
+		CD3DX12_GPU_DESCRIPTOR_HANDLE gpuHandle(m_descriptorHeap->GetGPUDescriptorHandleForHeapStart(), m_descriptorsUsed, m_descriptorSize);
+		m_descriptorsUsed += s_DescriptorsPerDispatch;
+
+		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		srvDesc.Format = format;
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MostDetailedMip = srcMip;
+		srvDesc.Texture2D.MipLevels = 1;
+		m_device->CreateShaderResourceView(texture, &srvDesc, cpuHandle);
+
+		// Unused slots still need a valid descriptor.
+		for (uint32 i = 0; i < s_MaxMipsPerDispatch; i++)
+		{
+			D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+			uavDesc.Format = uavFormat;
+			uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+			uavDesc.Texture2D.MipSlice = i < mipsCount ? srcMip + 1 + i : 0;
+			m_device->CreateUnorderedAccessView(i < mipsCount ? texture : nullptr, nullptr, &uavDesc, CD3DX12_CPU_DESCRIPTOR_HANDLE(cpuHandle, 1 + i, m_descriptorSize));
+		}
+
+		D3D12_RESOURCE_BARRIER barriers[s_MaxMipsPerDispatch];
+		for (uint32 i = 0; i < mipsCount; i++)
+		{
+			barriers[i] = CD3DX12_RESOURCE_BARRIER::Transition(texture, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, srcMip + 1 + i);
+		}
+		commandList->ResourceBarrier(mipsCount, barriers);
+
+		MipConstants constants = {};
+		constants.texelSize[0] = 1.0f / static_cast<float>(dstWidth);
+		constants.texelSize[1] = 1.0f / static_cast<float>(dstHeight);
+		constants.mipsCount = mipsCount;
+		constants.srcDimension = (srcWidth & 1) | (srcHeight & 1) << 1;
+		constants.isSrgb = isSrgb ? 1 : 0;
+
+		commandList->SetComputeRoot32BitConstants(0, sizeof(MipConstants) / 4, &constants, 0);
+		commandList->SetComputeRootDescriptorTable(1, gpuHandle);
+		commandList->Dispatch((dstWidth + 7) / 8, (dstHeight + 7) / 8, 1);
+
+		// Also orders the writes before the next dispatch reads them.
+		for (uint32 i = 0; i < mipsCount; i++)
+		{
+			barriers[i] = CD3DX12_RESOURCE_BARRIER::Transition(texture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, srcMip + 1 + i);
+		}
+		commandList->ResourceBarrier(mipsCount, barriers);
+
+		srcMip += mipsCount;
+	}
+
+	barrier = CD3DX12_RESOURCE_BARRIER::Transition(texture, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	commandList->ResourceBarrier(1, &barrier);
+}
+
+bool D3D12MipGenerator::IsSupported(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+DXGI_FORMAT D3D12MipGenerator::GetResourceFormat(DXGI_FORMAT format)
+{
+	return format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB ? DXGI_FORMAT_R8G8B8A8_TYPELESS : format;
+}
+
+DXGI_FORMAT D3D12MipGenerator::GetUavFormat(DXGI_FORMAT format)
+{
+	return format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB ? DXGI_FORMAT_R8G8B8A8_UNORM : format;
+}
+
+void D3D12MipGenerator::CreateRootSignature()
+{
+	CD3DX12_DESCRIPTOR_RANGE ranges[2];
+	ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+	ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, s_MaxMipsPerDispatch, 0);
+
+	CD3DX12_ROOT_PARAMETER slotRootParameter[2];
+	slotRootParameter[0].InitAsConstants(sizeof(MipConstants) / 4, 0);
+	slotRootParameter[1].InitAsDescriptorTable(_countof(ranges), ranges);
+
+	CD3DX12_STATIC_SAMPLER_DESC linearClamp(0, D3D12_FILTER_MIN_MAG_MIP_LINEAR, D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_CLAMP);
+
+	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+	rootSignatureDesc.Init(_countof(slotRootParameter), slotRootParameter, 1, &linearClamp, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+	m_rootSignature = m_renderer->GetPipelineCache()->GetRootSignature(rootSignatureDesc);
+}
+
+void D3D12MipGenerator::CreatePipelineState()
+{
+	ID3DBlob* computeShader = m_renderer->GetShaderCache()->GetShader("GenerateMips.hlsl", "CSMain", "cs_5_0");
+	if (!computeShader)
+	{
+		ThrowIfFailed(E_FAIL);
+		return;
+	}
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+	psoDesc.pRootSignature = m_rootSignature;
+	psoDesc.CS = { reinterpret_cast<UINT8*>(computeShader->GetBufferPointer()), computeShader->GetBufferSize() };
+	m_pipelineState = m_renderer->GetPipelineCache()->GetPipelineState(psoDesc);
+
+	if (computeShader)
+	{
+		computeShader->Release();
+		computeShader = nullptr;
+	}
+}
+
+void D3D12MipGenerator::CreateDescriptorHeap()
+{
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+	heapDesc.NumDescriptors = s_DescriptorHeapSize;
+	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	ThrowIfFailed(m_device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_descriptorHeap)));
+
+	m_descriptorsUsed = 0;
+}
+
+void D3D12MipGenerator::DestroyRootSignature()
+{
+	if (m_rootSignature)
+	{
+		m_rootSignature->Release();
+		m_rootSignature = nullptr;
+	}
+}
+
+void D3D12MipGenerator::DestroyPipelineState()
+{
+	if (m_pipelineState)
+	{
+		m_pipelineState->Release();
+		m_pipelineState = nullptr;
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+class D3D12Renderer;
+
+/*
+=====================
+D3D12MipGenerator
+=====================
+*/
+
+// Fills the mip chain of a texture from mip 0 with a compute shader, for render
+// targets and textures produced at runtime. One dispatch writes up to four mips
+// through groupshared memory; levels with an odd width or height also average
+// in the source row or column a plain 2x2 reduction would drop. sRGB textures
+// are filtered in linear light, which needs a typeless resource so each mip can
+// be read as sRGB and written as UNORM.
+class D3D12MipGenerator
+{
+public:
+	void Init(D3D12Renderer* renderer);
+	// The descriptor heap goes through the renderer's deferred release.
+	void Clean();
+
+	// texture must be a single 2D slice created with ALLOW_UNORDERED_ACCESS, in
+	// PIXEL_SHADER_RESOURCE; it is left there. format is the view format, so
+	// sRGB for sRGB data. Binds the generator's own descriptor heap and compute
+	// root signature on commandList; callers set theirs again afterwards.
+	void Generate(ID3D12GraphicsCommandList* commandList, ID3D12Resource* texture, DXGI_FORMAT format);
+
+	// RGBA8 (linear or sRGB), RGBA16F and RGBA32F.
+	static bool IsSupported(DXGI_FORMAT format);
+	// Format to create the resource with: typeless for sRGB so it can have UAVs.
+	static DXGI_FORMAT GetResourceFormat(DXGI_FORMAT format);
+
+private:
+	static const uint32 s_MaxMipsPerDispatch = 4;
+	static const uint32 s_DescriptorsPerDispatch = 1 + s_MaxMipsPerDispatch;
+	static const uint32 s_DescriptorHeapSize = 1024;
+
+	// Matches MipConstants in GenerateMips.hlsl.
+	struct MipConstants
+	{
+		float texelSize[2];
+		uint32 mipsCount;
+		uint32 srcDimension;
+		uint32 isSrgb;
+	};
+
+	D3D12Renderer* m_renderer = nullptr;
+	ID3D12Device* m_device = nullptr;
+	ID3D12RootSignature* m_rootSignature = nullptr;
+	ID3D12PipelineState* m_pipelineState = nullptr;
+
+	// Filled front to back and replaced when full, so descriptors the GPU may
+	// still read are never overwritten.
+	ID3D12DescriptorHeap* m_descriptorHeap = nullptr;
+	uint32 m_descriptorSize = 0;
+	uint32 m_descriptorsUsed = 0;
+
+	void CreateRootSignature();
+	void CreatePipelineState();
+	void CreateDescriptorHeap();
+
+	void DestroyRootSignature();
+	void DestroyPipelineState();
+
+	static DXGI_FORMAT GetUavFormat(DXGI_FORMAT format);
+};
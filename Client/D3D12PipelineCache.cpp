@@ -0,0 +1,803 @@
+#include "pch.h"
+#include "D3D12PipelineCache.h"
+#include "D3D12Renderer.h"
+#include "D3D12ShaderCache.h"
+#include "D3D12Utils.h"
+#include "../Common/FileMapping.h"
+#include "../Common/Hash.h"
+
+const uint32 PIPELINE_SHADER_STAGES_COUNT = 5;
+
+struct PipelineCompileJob
+{
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+	uint8* data = nullptr;			// Shaders and input layout the desc points into.
+	uint64 key = 0;					// Only known once compiled for reloads.
+	bool persistent = false;
+	uint32 jobId = PIPELINE_COMPILE_INVALID_ID;
+	float milliseconds = 0.0f;		// Written by the worker.
+
+	// Set for reloads, which compile the shaders again before the pipeline.
+	D3D12ShaderCache* shaderCache = nullptr;
+	ID3DBlob* shaders[PIPELINE_SHADER_STAGES_COUNT] = {};
+};
+
+/*
+=====================
+D3D12PipelineCache
+=====================
+*/
+
+static float GetElapsedMilliseconds(const LARGE_INTEGER& startTime)
+{
+	LARGE_INTEGER frequency = {};
+	LARGE_INTEGER time = {};
+	::QueryPerformanceFrequency(&frequency);
+	::QueryPerformanceCounter(&time);
+	return static_cast<float>(time.QuadPart - startTime.QuadPart) * 1000.0f / static_cast<float>(frequency.QuadPart);
+}
+
+static uint64 HashShader(const D3D12_SHADER_BYTECODE& shader, uint64 seed)
+{
+	uint64 hash = HashValue(shader.BytecodeLength, seed);
+	return shader.BytecodeLength ? HashBytes(shader.pShaderBytecode, shader.BytecodeLength, hash) : hash;
+}
+
+static void GetPipelineName(uint64 key, wchar_t* outName)
+{
+	::swprintf_s(outName, 17, L"%016llx", static_cast<unsigned long long>(key));
+}
+
+// Runs on a compile worker. The device is free-threaded; nothing else of the cache is touched here.
+static void* CompilePipelineState(void* context, void* job)
+{
+	ID3D12Device* device = static_cast<ID3D12Device*>(context);
+	PipelineCompileJob* compileJob = static_cast<PipelineCompileJob*>(job);
+
+	if (compileJob->shaderCache)
+	{
+		// Compile errors are printed by the shader cache.
+		D3D12_SHADER_BYTECODE* shaders[] = { &compileJob->desc.VS, &compileJob->desc.PS, &compileJob->desc.DS, &compileJob->desc.HS, &compileJob->desc.GS };
+		for (uint32 i = 0; i < PIPELINE_SHADER_STAGES_COUNT; i++)
+		{
+			if (!compileJob->shaderCache->ReloadShader(*shaders[i], &compileJob->shaders[i]))
+				return nullptr;
+
+			if (compileJob->shaders[i])
+				*shaders[i] = { compileJob->shaders[i]->GetBufferPointer(), compileJob->shaders[i]->GetBufferSize() };
+		}
+	}
+
+	LARGE_INTEGER startTime = {};
+	::QueryPerformanceCounter(&startTime);
+
+	ID3D12PipelineState* pipelineState = nullptr;
+	if (FAILED(device->CreateGraphicsPipelineState(&compileJob->desc, IID_PPV_ARGS(&pipelineState))))
+		pipelineState = nullptr;
+
+	compileJob->milliseconds = GetElapsedMilliseconds(startTime);
+	return pipelineState;
+}
+
+static void DiscardCompileJob(void* context, void* job, void* result)
+{
+	PipelineCompileJob* compileJob = static_cast<PipelineCompileJob*>(job);
+
+	if (result)
+		static_cast<ID3D12PipelineState*>(result)->Release();
+
+	for (uint32 i = 0; i < PIPELINE_SHADER_STAGES_COUNT; i++)
+	{
+		if (compileJob->shaders[i])
+			compileJob->shaders[i]->Release();
+	}
+
+	if (compileJob->desc.pRootSignature)
+		compileJob->desc.pRootSignature->Release();
+
+	delete[] compileJob->data;
+	delete compileJob;
+}
+
+void D3D12PipelineCache::Init(D3D12Renderer* renderer, const char* filename, uint32 compileThreadsCount)
+{
+	m_renderer = renderer;
+	m_device = renderer->GetDevice();
+	::strcpy_s(m_filename, filename);
+	m_stats = {};
+
+	CreateLibrary();
+
+	m_compileAsync = compileThreadsCount > 0;
+	if (m_compileAsync)
+	{
+		PipelineCompileQueueSettings queueSettings = {};
+		queueSettings.threadsCount = compileThreadsCount;
+		queueSettings.compile = CompilePipelineState;
+		queueSettings.discard = DiscardCompileJob;
+		queueSettings.context = m_device;
+		m_compileQueue.Init(queueSettings);
+	}
+}
+
+void D3D12PipelineCache::Clean()
+{
+	// Compiles still running are waited for, and their pipelines dropped.
+	if (m_compileAsync)
+	{
+		m_compileQueue.Clean();
+		m_compileAsync = false;
+	}
+
+	if (m_pendingHandles)
+	{
+		delete[] m_pendingHandles;
+		m_pendingHandles = nullptr;
+	}
+	m_pendingHandlesCount = 0;
+	m_pendingHandlesCapacity = 0;
+
+	if (m_handles)
+	{
+		delete[] m_handles;
+		m_handles = nullptr;
+	}
+	m_handlesCount = 0;
+	m_handlesCapacity = 0;
+
+	if (m_library && m_libraryDirty)
+		SaveLibrary();
+
+	ReleaseEntries(&m_pipelineStates, &m_pipelineStatesCount, &m_pipelineStatesCapacity);
+	ReleaseEntries(&m_rootSignatures, &m_rootSignaturesCount, &m_rootSignaturesCapacity);
+
+	if (m_library)
+	{
+		m_library->Release();
+		m_library = nullptr;
+	}
+
+	if (m_libraryData)
+	{
+		delete[] m_libraryData;
+		m_libraryData = nullptr;
+	}
+	m_libraryDirty = false;
+}
+
+void D3D12PipelineCache::Update()
+{
+	uint32 i = 0;
+	while (i < m_pendingHandlesCount)
+	{
+		PipelineCompileJob* job = m_pendingHandles[i]->job;
+
+		PIPELINE_COMPILE_STATE state = m_compileQueue.GetState(job->jobId);
+		if (state == PIPELINE_COMPILE_STATE_QUEUED || state == PIPELINE_COMPILE_STATE_COMPILING)
+		{
+			i++;
+			continue;
+		}
+
+		// The library is only touched on this thread, so the pipeline is stored here rather than on the worker.
+		ID3D12PipelineState* pipelineState = static_cast<ID3D12PipelineState*>(m_compileQueue.GetResult(job->jobId));
+		if (pipelineState)
+		{
+			if (job->shaderCache)
+				job->key = GetPipelineKey(job->desc, &job->persistent);
+
+			// A reload that changed nothing, or a pipeline created meanwhile by GetPipelineState.
+			ID3D12PipelineState* existing = static_cast<ID3D12PipelineState*>(FindEntry(m_pipelineStates, m_pipelineStatesCount, job->key));
+			if (existing)
+			{
+				pipelineState = existing;
+			}
+			else
+			{
+				AddPipelineState(job->key, job->persistent, pipelineState);
+				m_stats.createMilliseconds += job->milliseconds;
+				m_stats.createsCount++;
+				m_stats.asyncCreatesCount++;
+			}
+		}
+		else if (job->shaderCache)
+		{
+			::printf("Shader reload failed; keeping the previous pipeline\n");
+		}
+		else
+		{
+			// Draws keep resolving to the fallback.
+			::printf("Pipeline %016llx failed to compile\n", static_cast<unsigned long long>(job->key));
+		}
+
+		// Every handle sharing the job, this one included, is at index i or later.
+		for (uint32 n = m_pendingHandlesCount; n > i; n--)
+		{
+			PipelineHandle* handle = m_pendingHandles[n - 1];
+			if (handle->job != job)
+				continue;
+
+			handle->job = nullptr;
+			if (pipelineState && pipelineState != handle->pipelineState)
+			{
+				if (handle->pipelineState)
+					RetirePipelineState(handle->pipelineState);
+
+				pipelineState->AddRef();
+				handle->pipelineState = pipelineState;
+			}
+
+			m_pendingHandles[n - 1] = m_pendingHandles[--m_pendingHandlesCount];
+		}
+
+		m_compileQueue.Release(job->jobId);
+	}
+}
+
+void D3D12PipelineCache::ReloadShaders()
+{
+	if (!m_compileAsync)
+		return;
+
+	D3D12ShaderCache* shaderCache = m_renderer->GetShaderCache();
+	for (uint32 i = 0; i < m_handlesCount; i++)
+	{
+		PipelineHandle* handle = m_handles[i];
+		if (!handle->request)
+			continue;
+
+		// Whatever is in flight was built from the old sources.
+		if (handle->job)
+		{
+			RemoveHandle(m_pendingHandles, &m_pendingHandlesCount, handle);
+			ReleaseCompileJob(handle->job);
+			handle->job = nullptr;
+		}
+
+		PipelineCompileJob* job = CreateCompileJob(handle->request->desc, 0, false);
+		job->shaderCache = shaderCache;
+		job->jobId = m_compileQueue.Submit(job);
+		if (job->jobId == PIPELINE_COMPILE_INVALID_ID)
+		{
+			DiscardCompileJob(nullptr, job, nullptr);
+			continue;
+		}
+
+		handle->job = job;
+		AddHandle(&m_pendingHandles, &m_pendingHandlesCount, &m_pendingHandlesCapacity, handle);
+	}
+}
+
+ID3D12RootSignature* D3D12PipelineCache::GetRootSignature(const D3D12_ROOT_SIGNATURE_DESC& desc)
+{
+	ID3DBlob* signature = nullptr;
+	ID3DBlob* error = nullptr;
+	ThrowIfFailed(D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error));
+
+	if (error)
+	{
+		error->Release();
+		error = nullptr;
+	}
+
+	if (!signature)
+		return nullptr;
+
+	uint64 key = HashBytes(signature->GetBufferPointer(), signature->GetBufferSize());
+
+	ID3D12RootSignature* rootSignature = static_cast<ID3D12RootSignature*>(FindEntry(m_rootSignatures, m_rootSignaturesCount, key));
+	if (rootSignature)
+	{
+		rootSignature->AddRef();
+	}
+	else
+	{
+		ThrowIfFailed(m_device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature)));
+		if (rootSignature)
+			AddEntry(&m_rootSignatures, &m_rootSignaturesCount, &m_rootSignaturesCapacity, key, rootSignature);
+	}
+
+	signature->Release();
+	signature = nullptr;
+
+	return rootSignature;
+}
+
+ID3D12PipelineState* D3D12PipelineCache::GetPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+	bool persistent = false;
+	uint64 key = GetPipelineKey(desc, &persistent);
+	return FindOrCreatePipelineState(key, persistent, false, &desc);
+}
+
+ID3D12PipelineState* D3D12PipelineCache::GetPipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc)
+{
+	bool persistent = false;
+	uint64 key = GetPipelineKey(desc, &persistent);
+	return FindOrCreatePipelineState(key, persistent, true, &desc);
+}
+
+PipelineHandle* D3D12PipelineCache::RequestPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, ID3D12PipelineState* fallback)
+{
+	PipelineHandle* handle = new PipelineHandle;
+	handle->fallback = fallback;
+	if (fallback)
+		fallback->AddRef();
+
+	AddHandle(&m_handles, &m_handlesCount, &m_handlesCapacity, handle);
+
+	bool persistent = false;
+	uint64 key = GetPipelineKey(desc, &persistent);
+
+	// Stream output is rare enough not to be worth copying for the workers, or reloading.
+	if (!desc.StreamOutput.NumEntries)
+		handle->request = CreateCompileJob(desc, key, persistent);
+
+	handle->pipelineState = FindPipelineState(key, persistent, false, &desc);
+	if (handle->pipelineState)
+		return handle;
+
+	if (!m_compileAsync || !handle->request)
+	{
+		handle->pipelineState = CreatePipelineState(key, persistent, false, &desc);
+		return handle;
+	}
+
+	for (uint32 i = 0; i < m_pendingHandlesCount; i++)
+	{
+		PipelineCompileJob* pendingJob = m_pendingHandles[i]->job;
+		if (!pendingJob->shaderCache && pendingJob->key == key)
+		{
+			handle->job = pendingJob;
+			AddHandle(&m_pendingHandles, &m_pendingHandlesCount, &m_pendingHandlesCapacity, handle);
+			return handle;
+		}
+	}
+
+	PipelineCompileJob* job = CreateCompileJob(desc, key, persistent);
+	job->jobId = m_compileQueue.Submit(job);
+	if (job->jobId == PIPELINE_COMPILE_INVALID_ID)
+	{
+		// Every slot is busy; stall rather than drop the request.
+		DiscardCompileJob(nullptr, job, nullptr);
+		handle->pipelineState = CreatePipelineState(key, persistent, false, &desc);
+		return handle;
+	}
+
+	handle->job = job;
+	AddHandle(&m_pendingHandles, &m_pendingHandlesCount, &m_pendingHandlesCapacity, handle);
+	return handle;
+}
+
+ID3D12PipelineState* D3D12PipelineCache::Resolve(PipelineHandle* handle)
+{
+	if (handle->pipelineState)
+		return handle->pipelineState;
+
+	m_stats.fallbacksCount++;
+	return handle->fallback;
+}
+
+void D3D12PipelineCache::ReleasePipelineState(PipelineHandle* handle)
+{
+	RemoveHandle(m_handles, &m_handlesCount, handle);
+
+	if (handle->job)
+	{
+		RemoveHandle(m_pendingHandles, &m_pendingHandlesCount, handle);
+		ReleaseCompileJob(handle->job);
+		handle->job = nullptr;
+	}
+
+	if (handle->request)
+	{
+		DiscardCompileJob(nullptr, handle->request, nullptr);
+		handle->request = nullptr;
+	}
+
+	if (handle->pipelineState)
+	{
+		handle->pipelineState->Release();
+		handle->pipelineState = nullptr;
+	}
+
+	if (handle->fallback)
+	{
+		handle->fallback->Release();
+		handle->fallback = nullptr;
+	}
+
+	delete handle;
+}
+
+void D3D12PipelineCache::CreateLibrary()
+{
+	ID3D12Device1* device1 = nullptr;
+	if (FAILED(m_device->QueryInterface(IID_PPV_ARGS(&device1))))
+		return;
+
+	D3D12_FEATURE_DATA_SHADER_CACHE shaderCache = {};
+	if (SUCCEEDED(m_device->CheckFeatureSupport(D3D12_FEATURE_SHADER_CACHE, &shaderCache, sizeof(shaderCache))) && (shaderCache.SupportFlags & D3D12_SHADER_CACHE_SUPPORT_LIBRARY))
+	{
+		// Copied out of the mapping so the file can be replaced on Clean.
+		uint64 librarySize = 0;
+		FileMapping mapping = {};
+		if (FileSystem::MapFile(m_filename, &mapping))
+		{
+			librarySize = mapping.size;
+			m_libraryData = new uint8[static_cast<size_t>(librarySize)];
+			::memcpy(m_libraryData, mapping.data, static_cast<size_t>(librarySize));
+			FileSystem::UnmapFile(&mapping);
+		}
+
+		// Libraries saved by another driver or adapter are rejected; start over with an empty one.
+		if (!m_libraryData || FAILED(device1->CreatePipelineLibrary(m_libraryData, static_cast<SIZE_T>(librarySize), IID_PPV_ARGS(&m_library))))
+		{
+			if (m_libraryData)
+			{
+				delete[] m_libraryData;
+				m_libraryData = nullptr;
+			}
+
+			m_library = nullptr;
+			if (FAILED(device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_library))))
+				m_library = nullptr;
+		}
+	}
+
+	device1->Release();
+	device1 = nullptr;
+}
+
+void D3D12PipelineCache::SaveLibrary()
+{
+	SIZE_T size = m_library->GetSerializedSize();
+	uint8* data = new uint8[size];
+	if (SUCCEEDED(m_library->Serialize(data, size)))
+	{
+		// Written aside and renamed, so an interrupted run never leaves a truncated library behind.
+		char tempPath[MAX_PATH] = {};
+		::sprintf_s(tempPath, "%s.tmp", m_filename);
+
+		FILE* file = nullptr;
+		if (::fopen_s(&file, tempPath, "wb") == 0 && file)
+		{
+			size_t written = ::fwrite(data, 1, size, file);
+			::fclose(file);
+
+			if (written != size || !::MoveFileExA(tempPath, m_filename, MOVEFILE_REPLACE_EXISTING))
+				::DeleteFileA(tempPath);
+		}
+	}
+
+	delete[] data;
+	m_libraryDirty = false;
+}
+
+uint64 D3D12PipelineCache::GetPipelineKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, bool* outPersistent) const
+{
+	uint64 rootSignatureKey = 0;
+	*outPersistent = FindRootSignatureKey(desc.pRootSignature, &rootSignatureKey);
+
+	uint64 key = HashString("graphics");
+	key = HashValue(rootSignatureKey, key);
+	key = HashShader(desc.VS, key);
+	key = HashShader(desc.PS, key);
+	key = HashShader(desc.DS, key);
+	key = HashShader(desc.HS, key);
+	key = HashShader(desc.GS, key);
+
+	key = HashValue(desc.StreamOutput.NumEntries, key);
+	for (uint32 i = 0; i < desc.StreamOutput.NumEntries; i++)
+	{
+		const D3D12_SO_DECLARATION_ENTRY& entry = desc.StreamOutput.pSODeclaration[i];
+		key = HashValue(entry.Stream, key);
+		key = entry.SemanticName ? HashString(entry.SemanticName, key) : key;
+		key = HashValue(entry.SemanticIndex, key);
+		key = HashValue(entry.StartComponent, key);
+		key = HashValue(entry.ComponentCount, key);
+		key = HashValue(entry.OutputSlot, key);
+	}
+	key = HashValue(desc.StreamOutput.NumStrides, key);
+	for (uint32 i = 0; i < desc.StreamOutput.NumStrides; i++)
+	{
+		key = HashValue(desc.StreamOutput.pBufferStrides[i], key);
+	}
+	key = HashValue(desc.StreamOutput.RasterizedStream, key);
+
+	// Plain 4-byte fields throughout, so there is no padding to worry about.
+	key = HashValue(desc.BlendState, key);
+	key = HashValue(desc.SampleMask, key);
+	key = HashValue(desc.RasterizerState, key);
+	key = HashValue(desc.DepthStencilState, key);
+
+	key = HashValue(desc.InputLayout.NumElements, key);
+	for (uint32 i = 0; i < desc.InputLayout.NumElements; i++)
+	{
+		const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+		key = HashString(element.SemanticName, key);
+		key = HashValue(element.SemanticIndex, key);
+		key = HashValue(element.Format, key);
+		key = HashValue(element.InputSlot, key);
+		key = HashValue(element.AlignedByteOffset, key);
+		key = HashValue(element.InputSlotClass, key);
+		key = HashValue(element.InstanceDataStepRate, key);
+	}
+
+	key = HashValue(desc.IBStripCutValue, key);
+	key = HashValue(desc.PrimitiveTopologyType, key);
+	key = HashValue(desc.NumRenderTargets, key);
+	key = HashValue(desc.RTVFormats, key);
+	key = HashValue(desc.DSVFormat, key);
+	key = HashValue(desc.SampleDesc, key);
+	key = HashValue(desc.NodeMask, key);
+	key = HashValue(desc.Flags, key);
+
+	return key;
+}
+
+uint64 D3D12PipelineCache::GetPipelineKey(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, bool* outPersistent) const
+{
+	uint64 rootSignatureKey = 0;
+	*outPersistent = FindRootSignatureKey(desc.pRootSignature, &rootSignatureKey);
+
+	uint64 key = HashString("compute");
+	key = HashValue(rootSignatureKey, key);
+	key = HashShader(desc.CS, key);
+	key = HashValue(desc.NodeMask, key);
+	key = HashValue(desc.Flags, key);
+	return key;
+}
+
+bool D3D12PipelineCache::FindRootSignatureKey(ID3D12RootSignature* rootSignature, uint64* outKey) const
+{
+	for (uint32 i = 0; i < m_rootSignaturesCount; i++)
+	{
+		if (m_rootSignatures[i].object == rootSignature)
+		{
+			*outKey = m_rootSignatures[i].key;
+			return true;
+		}
+	}
+
+	*outKey = HashValue(rootSignature);
+	return false;
+}
+
+ID3D12DeviceChild* D3D12PipelineCache::FindEntry(const Entry* entries, uint32 count, uint64 key) const
+{
+	for (uint32 i = 0; i < count; i++)
+	{
+		if (entries[i].key == key)
+			return entries[i].object;
+	}
+	return nullptr;
+}
+
+void D3D12PipelineCache::AddEntry(Entry** entries, uint32* count, uint32* capacity, uint64 key, ID3D12DeviceChild* object)
+{
+	if (*count == *capacity)
+	{
+		uint32 newCapacity = *capacity ? *capacity * 2 : 16;
+		Entry* newEntries = new Entry[newCapacity];
+		for (uint32 i = 0; i < *count; i++)
+		{
+			newEntries[i] = (*entries)[i];
+		}
+
+		delete[] *entries;
+		*entries = newEntries;
+		*capacity = newCapacity;
+	}
+
+	object->AddRef();
+
+	Entry& entry = (*entries)[(*count)++];
+	entry.key = key;
+	entry.object = object;
+}
+
+void D3D12PipelineCache::ReleaseEntries(Entry** entries, uint32* count, uint32* capacity)
+{
+	for (uint32 i = 0; i < *count; i++)
+	{
+		(*entries)[i].object->Release();
+	}
+
+	if (*entries)
+	{
+		delete[] *entries;
+		*entries = nullptr;
+	}
+	*count = 0;
+	*capacity = 0;
+}
+
+ID3D12PipelineState* D3D12PipelineCache::FindOrCreatePipelineState(uint64 key, bool persistent, bool isCompute, const void* desc)
+{
+	ID3D12PipelineState* pipelineState = FindPipelineState(key, persistent, isCompute, desc);
+	return pipelineState ? pipelineState : CreatePipelineState(key, persistent, isCompute, desc);
+}
+
+ID3D12PipelineState* D3D12PipelineCache::FindPipelineState(uint64 key, bool persistent, bool isCompute, const void* desc)
+{
+	ID3D12PipelineState* pipelineState = static_cast<ID3D12PipelineState*>(FindEntry(m_pipelineStates, m_pipelineStatesCount, key));
+	if (pipelineState)
+	{
+		pipelineState->AddRef();
+		m_stats.memoryHitsCount++;
+		return pipelineState;
+	}
+
+	if (!m_library || !persistent)
+		return nullptr;
+
+	wchar_t name[17] = {};
+	GetPipelineName(key, name);
+
+	LARGE_INTEGER startTime = {};
+	::QueryPerformanceCounter(&startTime);
+
+	// Fails with E_INVALIDARG when the name is not in the library yet.
+	HRESULT hr = isCompute ?
+		m_library->LoadComputePipeline(name, static_cast<const D3D12_COMPUTE_PIPELINE_STATE_DESC*>(desc), IID_PPV_ARGS(&pipelineState)) :
+		m_library->LoadGraphicsPipeline(name, static_cast<const D3D12_GRAPHICS_PIPELINE_STATE_DESC*>(desc), IID_PPV_ARGS(&pipelineState));
+	m_stats.loadMilliseconds += GetElapsedMilliseconds(startTime);
+
+	if (FAILED(hr))
+		return nullptr;
+
+	m_stats.libraryHitsCount++;
+	AddEntry(&m_pipelineStates, &m_pipelineStatesCount, &m_pipelineStatesCapacity, key, pipelineState);
+	return pipelineState;
+}
+
+ID3D12PipelineState* D3D12PipelineCache::CreatePipelineState(uint64 key, bool persistent, bool isCompute, const void* desc)
+{
+	LARGE_INTEGER startTime = {};
+	::QueryPerformanceCounter(&startTime);
+
+	ID3D12PipelineState* pipelineState = nullptr;
+	HRESULT hr = isCompute ?
+		m_device->CreateComputePipelineState(static_cast<const D3D12_COMPUTE_PIPELINE_STATE_DESC*>(desc), IID_PPV_ARGS(&pipelineState)) :
+		m_device->CreateGraphicsPipelineState(static_cast<const D3D12_GRAPHICS_PIPELINE_STATE_DESC*>(desc), IID_PPV_ARGS(&pipelineState));
+	if (FAILED(hr))
+	{
+		ThrowIfFailed(hr);
+		return nullptr;
+	}
+
+	m_stats.createMilliseconds += GetElapsedMilliseconds(startTime);
+	m_stats.createsCount++;
+
+	AddPipelineState(key, persistent, pipelineState);
+	return pipelineState;
+}
+
+void D3D12PipelineCache::AddPipelineState(uint64 key, bool persistent, ID3D12PipelineState* pipelineState)
+{
+	if (m_library && persistent)
+	{
+		wchar_t name[17] = {};
+		GetPipelineName(key, name);
+
+		if (SUCCEEDED(m_library->StorePipeline(name, pipelineState)))
+			m_libraryDirty = true;
+	}
+
+	AddEntry(&m_pipelineStates, &m_pipelineStatesCount, &m_pipelineStatesCapacity, key, pipelineState);
+}
+
+PipelineCompileJob* D3D12PipelineCache::CreateCompileJob(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64 key, bool persistent)
+{
+	PipelineCompileJob* job = new PipelineCompileJob;
+	job->desc = desc;
+	job->desc.CachedPSO = {};
+	job->key = key;
+	job->persistent = persistent;
+
+	// The caller's shaders and input layout may be gone by the time a worker
+	// gets to the job, so they are copied into one block the desc points into.
+	D3D12_SHADER_BYTECODE* shaders[] = { &job->desc.VS, &job->desc.PS, &job->desc.DS, &job->desc.HS, &job->desc.GS };
+
+	uint32 elementsCount = desc.InputLayout.NumElements;
+	size_t dataSize = elementsCount * sizeof(D3D12_INPUT_ELEMENT_DESC);
+	for (uint32 i = 0; i < elementsCount; i++)
+	{
+		dataSize += ::strlen(desc.InputLayout.pInputElementDescs[i].SemanticName) + 1;
+	}
+	for (uint32 i = 0; i < _countof(shaders); i++)
+	{
+		dataSize += shaders[i]->BytecodeLength;
+	}
+
+	job->data = new uint8[dataSize];
+	uint8* cursor = job->data;
+
+	// Elements first, so they sit at the block's alignment.
+	D3D12_INPUT_ELEMENT_DESC* elements = reinterpret_cast<D3D12_INPUT_ELEMENT_DESC*>(cursor);
+	cursor += elementsCount * sizeof(D3D12_INPUT_ELEMENT_DESC);
+	for (uint32 i = 0; i < elementsCount; i++)
+	{
+		elements[i] = desc.InputLayout.pInputElementDescs[i];
+
+		size_t nameSize = ::strlen(elements[i].SemanticName) + 1;
+		::memcpy(cursor, elements[i].SemanticName, nameSize);
+		elements[i].SemanticName = reinterpret_cast<const char*>(cursor);
+		cursor += nameSize;
+	}
+	job->desc.InputLayout.pInputElementDescs = elementsCount ? elements : nullptr;
+
+	for (uint32 i = 0; i < _countof(shaders); i++)
+	{
+		if (!shaders[i]->BytecodeLength)
+			continue;
+
+		::memcpy(cursor, shaders[i]->pShaderBytecode, shaders[i]->BytecodeLength);
+		shaders[i]->pShaderBytecode = cursor;
+		cursor += shaders[i]->BytecodeLength;
+	}
+
+	if (job->desc.pRootSignature)
+		job->desc.pRootSignature->AddRef();
+
+	return job;
+}
+
+void D3D12PipelineCache::AddHandle(PipelineHandle*** handles, uint32* count, uint32* capacity, PipelineHandle* handle)
+{
+	if (*count == *capacity)
+	{
+		uint32 newCapacity = *capacity ? *capacity * 2 : 16;
+		PipelineHandle** newHandles = new PipelineHandle*[newCapacity];
+		for (uint32 i = 0; i < *count; i++)
+		{
+			newHandles[i] = (*handles)[i];
+		}
+
+		delete[] *handles;
+		*handles = newHandles;
+		*capacity = newCapacity;
+	}
+
+	(*handles)[(*count)++] = handle;
+}
+
+void D3D12PipelineCache::RemoveHandle(PipelineHandle** handles, uint32* count, PipelineHandle* handle)
+{
+	for (uint32 i = 0; i < *count; i++)
+	{
+		if (handles[i] == handle)
+		{
+			handles[i] = handles[--(*count)];
+			return;
+		}
+	}
+}
+
+void D3D12PipelineCache::RetirePipelineState(ID3D12PipelineState* pipelineState)
+{
+	for (uint32 i = 0; i < m_pipelineStatesCount; i++)
+	{
+		if (m_pipelineStates[i].object == pipelineState)
+		{
+			m_renderer->DeferRelease(pipelineState);
+			m_pipelineStates[i] = m_pipelineStates[--m_pipelineStatesCount];
+			break;
+		}
+	}
+
+	m_renderer->DeferRelease(pipelineState);
+}
+
+void D3D12PipelineCache::ReleaseCompileJob(PipelineCompileJob* job)
+{
+	for (uint32 i = 0; i < m_pendingHandlesCount; i++)
+	{
+		if (m_pendingHandles[i]->job == job)
+			return;
+	}
+
+	// A job still compiling is discarded by its worker.
+	m_compileQueue.Release(job->jobId);
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "../Common/PipelineCompileQueue.h"
+
+// Relative to the shader cache directory.
+const char PIPELINE_LIBRARY_FILENAME[] = "Pipelines.bin";
+
+struct PipelineCacheStats
+{
+	uint32 memoryHitsCount = 0;
+	uint32 libraryHitsCount = 0;
+	uint32 createsCount = 0;
+	float loadMilliseconds = 0.0f;		// Spent in library loads.
+	float createMilliseconds = 0.0f;	// Spent in driver compiles, on workers included.
+	uint32 asyncCreatesCount = 0;
+	uint32 fallbacksCount = 0;			// Draws that resolved to a fallback or were skipped.
+};
+
+struct PipelineCompileJob;
+class D3D12Renderer;
+
+// What RequestPipelineState hands out. Resolve it every draw.
+struct PipelineHandle
+{
+	ID3D12PipelineState* pipelineState = nullptr;	// nullptr until compiled.
+	ID3D12PipelineState* fallback = nullptr;
+	PipelineCompileJob* job = nullptr;		// Compile in flight.
+	PipelineCompileJob* request = nullptr;	// Copy of the desc, rebuilt from on shader reloads.
+};
+
+/*
+=====================
+D3D12PipelineCache
+=====================
+*/
+
+// Dedupes root signatures and pipeline states by a hash of everything that
+// goes into them. Root signatures are keyed by their serialized form, and
+// pipelines by the root signature's key, the shader bytecode and the fixed
+// function state, so keys are the same from one run to the next. New
+// pipelines are stored in an ID3D12PipelineLibrary that is written out on
+// Clean and loaded on Init, so warm runs skip driver compilation. Without
+// pipeline library support, pipelines are still deduped in memory.
+//
+// RequestPipelineState moves driver compiles onto worker threads. Library and
+// memory hits are ready at once; misses are compiled in the background while
+// draws use the fallback given with the request, and Update swaps the real
+// pipeline in. Requests for the same pipeline share one compile. Shader
+// reloads go through the same path, swapping pipelines at a frame boundary.
+class D3D12PipelineCache
+{
+public:
+	// With no compile threads, requested pipelines are created on the spot and
+	// shader reloads are ignored.
+	void Init(D3D12Renderer* renderer, const char* filename, uint32 compileThreadsCount);
+	// Saves the library when pipelines were added. The GPU must be idle.
+	void Clean();
+
+	// Picks up finished background compiles. Replaced pipelines are released
+	// once the frame being recorded is done with them. Call once a frame.
+	void Update();
+	// Rebuilds every requested pipeline from the current shader sources in the
+	// background. Pipelines that fail to compile are kept as they are.
+	void ReloadShaders();
+
+	// Returned objects hold a reference for the caller to release.
+	ID3D12RootSignature* GetRootSignature(const D3D12_ROOT_SIGNATURE_DESC& desc);
+	ID3D12PipelineState* GetPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+	ID3D12PipelineState* GetPipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc);
+
+	// The fallback may be nullptr, in which case draws are skipped until the
+	// pipeline is ready. The handle holds a reference to it.
+	PipelineHandle* RequestPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, ID3D12PipelineState* fallback);
+	// Returns the pipeline to draw with, or nullptr to skip the draw.
+	ID3D12PipelineState* Resolve(PipelineHandle* handle);
+	void ReleasePipelineState(PipelineHandle* handle);
+
+	inline const PipelineCacheStats& GetStats() const { return m_stats; }
+
+private:
+	struct Entry
+	{
+		uint64 key = 0;
+		ID3D12DeviceChild* object = nullptr;
+	};
+
+	D3D12Renderer* m_renderer = nullptr;
+	ID3D12Device* m_device = nullptr;
+	ID3D12PipelineLibrary* m_library = nullptr;
+	uint8* m_libraryData = nullptr;		// Must outlive the library it was loaded into.
+	bool m_libraryDirty = false;
+	char m_filename[MAX_PATH] = {};
+
+	Entry* m_rootSignatures = nullptr;
+	uint32 m_rootSignaturesCount = 0;
+	uint32 m_rootSignaturesCapacity = 0;
+
+	Entry* m_pipelineStates = nullptr;
+	uint32 m_pipelineStatesCount = 0;
+	uint32 m_pipelineStatesCapacity = 0;
+
+	PipelineCompileQueue m_compileQueue;
+	bool m_compileAsync = false;
+
+	PipelineHandle** m_handles = nullptr;
+	uint32 m_handlesCount = 0;
+	uint32 m_handlesCapacity = 0;
+
+	// Handles waiting on a background compile.
+	PipelineHandle** m_pendingHandles = nullptr;
+	uint32 m_pendingHandlesCount = 0;
+	uint32 m_pendingHandlesCapacity = 0;
+
+	PipelineCacheStats m_stats;
+
+	void CreateLibrary();
+	void SaveLibrary();
+
+	bool FindRootSignatureKey(ID3D12RootSignature* rootSignature, uint64* outKey) const;
+	ID3D12DeviceChild* FindEntry(const Entry* entries, uint32 count, uint64 key) const;
+	void AddEntry(Entry** entries, uint32* count, uint32* capacity, uint64 key, ID3D12DeviceChild* object);
+	void ReleaseEntries(Entry** entries, uint32* count, uint32* capacity);
+
+	uint64 GetPipelineKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, bool* outPersistent) const;
+	uint64 GetPipelineKey(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, bool* outPersistent) const;
+
+	// Pipelines whose root signature did not come from this cache are only kept in memory.
+	ID3D12PipelineState* FindOrCreatePipelineState(uint64 key, bool persistent, bool isCompute, const void* desc);
+	// Memory, then the library. Returns nullptr on a miss.
+	ID3D12PipelineState* FindPipelineState(uint64 key, bool persistent, bool isCompute, const void* desc);
+	ID3D12PipelineState* CreatePipelineState(uint64 key, bool persistent, bool isCompute, const void* desc);
+	void AddPipelineState(uint64 key, bool persistent, ID3D12PipelineState* pipelineState);
+
+	PipelineCompileJob* CreateCompileJob(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64 key, bool persistent);
+	void AddHandle(PipelineHandle*** handles, uint32* count, uint32* capacity, PipelineHandle* handle);
+	void RemoveHandle(PipelineHandle** handles, uint32* count, PipelineHandle* handle);
+	// Drops the cache's reference too, so a pipeline replaced by a reload goes away.
+	void RetirePipelineState(ID3D12PipelineState* pipelineState);
+	// Done with the job once no other pending handle shares it.
+	void ReleaseCompileJob(PipelineCompileJob* job);
+};
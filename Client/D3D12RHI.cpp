@@ -0,0 +1,461 @@
+#include "pch.h"
+#include "D3D12RHI.h"
+#include "D3D12BindlessHeap.h"
+#include "D3D12ConstantRing.h"
+#include "D3D12MaterialSystem.h"
+#include "D3D12PipelineCache.h"
+#include "D3D12Renderer.h"
+#include "D3D12Utils.h"
+
+static D3D12_RESOURCE_STATES ToResourceState(RHI_RESOURCE_STATE state)
+{
+	switch (state)
+	{
+	case RHI_RESOURCE_STATE_RENDER_TARGET:
+		return D3D12_RESOURCE_STATE_RENDER_TARGET;
+	case RHI_RESOURCE_STATE_DEPTH_WRITE:
+		return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+	case RHI_RESOURCE_STATE_SHADER_RESOURCE:
+		return D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+	case RHI_RESOURCE_STATE_COPY_SOURCE:
+		return D3D12_RESOURCE_STATE_COPY_SOURCE;
+	case RHI_RESOURCE_STATE_COPY_DEST:
+		return D3D12_RESOURCE_STATE_COPY_DEST;
+	case RHI_RESOURCE_STATE_PRESENT:
+		return D3D12_RESOURCE_STATE_PRESENT;
+	default:
+		return D3D12_RESOURCE_STATE_COMMON;
+	}
+}
+
+/*
+=====================
+D3D12RHICommandList
+=====================
+*/
+
+void D3D12RHICommandList::Init(D3D12RHIDevice* device, D3D12Renderer* renderer)
+{
+	m_device = device;
+	m_renderer = renderer;
+
+	ID3D12Device* d3dDevice = renderer->GetDevice();
+	ThrowIfFailed(d3dDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_commandAllocator)));
+	ThrowIfFailed(d3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocator, nullptr, IID_PPV_ARGS(&m_commandList)));
+	ThrowIfFailed(m_commandList->Close());
+}
+
+void D3D12RHICommandList::Init(D3D12Renderer* renderer, ID3D12GraphicsCommandList* commandList)
+{
+	m_renderer = renderer;
+	m_commandList = commandList;
+}
+
+void D3D12RHICommandList::Clean()
+{
+	if (!IsOwned())
+	{
+		m_commandList = nullptr;
+		return;
+	}
+
+	if (m_commandList)
+	{
+		m_renderer->DeferRelease(m_commandList);
+		m_commandList = nullptr;
+	}
+
+	if (m_commandAllocator)
+	{
+		m_renderer->DeferRelease(m_commandAllocator);
+		m_commandAllocator = nullptr;
+	}
+}
+
+void D3D12RHICommandList::Begin()
+{
+	if (!IsOwned())
+		return;
+
+	m_device->WaitForFence(m_fenceValue);
+
+	ThrowIfFailed(m_commandAllocator->Reset());
+	ThrowIfFailed(m_commandList->Reset(m_commandAllocator, nullptr));
+	m_renderer->BindGlobalState(m_commandList);
+}
+
+void D3D12RHICommandList::End()
+{
+	if (!IsOwned())
+		return;
+
+	ThrowIfFailed(m_commandList->Close());
+}
+
+void D3D12RHICommandList::TextureBarrier(RHITexture* texture, RHI_RESOURCE_STATE before, RHI_RESOURCE_STATE after)
+{
+	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(D3D12RHIDevice::ToTexture(texture)->resource, ToResourceState(before), ToResourceState(after));
+	m_commandList->ResourceBarrier(1, &barrier);
+}
+
+void D3D12RHICommandList::SetRenderTargets(RHITexture* colorTarget, RHITexture* depthTarget)
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = {};
+	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = {};
+	if (colorTarget)
+		rtvHandle = D3D12RHIDevice::ToTexture(colorTarget)->viewHeap->GetCPUDescriptorHandleForHeapStart();
+	if (depthTarget)
+		dsvHandle = D3D12RHIDevice::ToTexture(depthTarget)->viewHeap->GetCPUDescriptorHandleForHeapStart();
+
+	m_commandList->OMSetRenderTargets(colorTarget ? 1 : 0, colorTarget ? &rtvHandle : nullptr, FALSE, depthTarget ? &dsvHandle : nullptr);
+}
+
+void D3D12RHICommandList::ClearRenderTarget(RHITexture* texture, const float color[4])
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = D3D12RHIDevice::ToTexture(texture)->viewHeap->GetCPUDescriptorHandleForHeapStart();
+	m_commandList->ClearRenderTargetView(rtvHandle, color, 0, nullptr);
+}
+
+void D3D12RHICommandList::ClearDepth(RHITexture* texture, float depth)
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = D3D12RHIDevice::ToTexture(texture)->viewHeap->GetCPUDescriptorHandleForHeapStart();
+	m_commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, depth, 0, 0, nullptr);
+}
+
+void D3D12RHICommandList::SetViewport(uint32 width, uint32 height)
+{
+	D3D12_VIEWPORT viewport = { 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f };
+	D3D12_RECT scissorRect = { 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) };
+	m_commandList->RSSetViewports(1, &viewport);
+	m_commandList->RSSetScissorRects(1, &scissorRect);
+}
+
+void D3D12RHICommandList::SetPipeline(RHIPipeline* pipeline)
+{
+	m_commandList->SetPipelineState(D3D12RHIDevice::ToPipelineState(pipeline));
+	m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	m_renderer->GetFrameStats().Add(FRAME_STAT_PIPELINE_BINDS, 1);
+}
+
+bool D3D12RHICommandList::SetConstants(RHI_CONSTANTS_SLOT slot, const void* data, uint32 size)
+{
+	D3D12_GPU_VIRTUAL_ADDRESS address = m_renderer->GetConstantRing()->Push(data, size);
+	if (!address)
+		return false;
+
+	uint32 rootParameter = slot == RHI_CONSTANTS_SLOT_FRAME ? BINDLESS_ROOT_PARAMETER_FRAME_CONSTANTS : BINDLESS_ROOT_PARAMETER_OBJECT_CONSTANTS;
+	m_commandList->SetGraphicsRootConstantBufferView(rootParameter, address);
+	m_renderer->GetFrameStats().Add(FRAME_STAT_DESCRIPTOR_BINDS, 1);
+	return true;
+}
+
+void D3D12RHICommandList::SetVertexBuffer(RHIBuffer* buffer)
+{
+	m_commandList->IASetVertexBuffers(0, 1, &D3D12RHIDevice::ToBuffer(buffer)->vertexBuffer->vertexBufferView);
+	m_renderer->GetFrameStats().Add(FRAME_STAT_VERTEX_BUFFER_BINDS, 1);
+}
+
+void D3D12RHICommandList::SetIndexBuffer(RHIBuffer* buffer)
+{
+	m_commandList->IASetIndexBuffer(&D3D12RHIDevice::ToBuffer(buffer)->indexBuffer->indexBufferView);
+}
+
+void D3D12RHICommandList::DrawIndexed(uint32 indexCount, uint32 startIndex, int32 baseVertex)
+{
+	m_commandList->DrawIndexedInstanced(indexCount, 1, startIndex, baseVertex, 0);
+
+	FrameStats& stats = m_renderer->GetFrameStats();
+	stats.Add(FRAME_STAT_DRAW_CALLS, 1);
+	stats.Add(FRAME_STAT_TRIANGLES, indexCount / 3);
+}
+
+/*
+=================
+D3D12RHIDevice
+=================
+*/
+
+void D3D12RHIDevice::Init(D3D12Renderer* renderer)
+{
+	m_renderer = renderer;
+	m_device = renderer->GetDevice();
+
+	ThrowIfFailed(m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
+	m_fenceValue = 0;
+
+	m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (m_fenceEvent == nullptr)
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+}
+
+void D3D12RHIDevice::Clean()
+{
+	if (m_fence)
+	{
+		WaitForFence(m_fenceValue);
+
+		m_fence->Release();
+		m_fence = nullptr;
+	}
+
+	if (m_fenceEvent)
+	{
+		::CloseHandle(m_fenceEvent);
+		m_fenceEvent = nullptr;
+	}
+}
+
+RHIBuffer* D3D12RHIDevice::CreateBuffer(const RHIBufferDesc& desc, const void* data)
+{
+	if (desc.size == 0 || desc.stride == 0 || data == nullptr)
+		return nullptr;
+
+	D3D12UploadRing* uploadRing = m_renderer->GetUploadRing();
+	uint32 count = desc.size / desc.stride;
+
+	D3D12RHIBuffer* buffer = new D3D12RHIBuffer;
+	if (desc.usage == RHI_BUFFER_USAGE_INDEX)
+	{
+		DXGI_FORMAT format = desc.stride == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		buffer->indexBuffer = D3D12Utils::CreateIndexBuffer(m_device, uploadRing, data, count, desc.size, format);
+	}
+	else
+	{
+		buffer->vertexBuffer = D3D12Utils::CreateVertexBuffer(m_device, uploadRing, data, count, desc.size, desc.stride);
+	}
+
+	return reinterpret_cast<RHIBuffer*>(buffer);
+}
+
+void D3D12RHIDevice::DestroyBuffer(RHIBuffer* buffer)
+{
+	D3D12RHIBuffer* d3dBuffer = ToBuffer(buffer);
+	if (!d3dBuffer)
+		return;
+
+	// Copies into the buffer may still be pending on the upload ring.
+	if (d3dBuffer->vertexBuffer)
+	{
+		m_renderer->DeferRelease(d3dBuffer->vertexBuffer->resource);
+		delete d3dBuffer->vertexBuffer;
+		d3dBuffer->vertexBuffer = nullptr;
+	}
+
+	if (d3dBuffer->indexBuffer)
+	{
+		m_renderer->DeferRelease(d3dBuffer->indexBuffer->resource);
+		delete d3dBuffer->indexBuffer;
+		d3dBuffer->indexBuffer = nullptr;
+	}
+
+	delete d3dBuffer;
+}
+
+RHITexture* D3D12RHIDevice::CreateTexture(const RHITextureDesc& desc, const void* data, uint32 rowPitch)
+{
+	if (desc.usage & (RHI_TEXTURE_USAGE_RENDER_TARGET | RHI_TEXTURE_USAGE_DEPTH_STENCIL))
+		return CreateTarget(desc);
+
+	if (data == nullptr)
+		return nullptr;
+
+	D3D12BindlessHeap* bindlessHeap = m_renderer->GetBindlessHeap();
+	uint32 srvIndex = bindlessHeap->Allocate();
+	if (srvIndex == BINDLESS_INVALID_INDEX)
+		return nullptr;
+
+	TextureHandle* handle = m_renderer->CreateTexture2D(desc.width, desc.height, static_cast<DXGI_FORMAT>(desc.format), data, rowPitch, bindlessHeap->GetCpuHandle(srvIndex));
+	if (!handle)
+	{
+		bindlessHeap->Free(srvIndex);
+		return nullptr;
+	}
+
+	D3D12RHITexture* texture = new D3D12RHITexture;
+	texture->resource = handle->resource;
+	texture->handle = handle;
+	texture->srvIndex = srvIndex;
+	return reinterpret_cast<RHITexture*>(texture);
+}
+
+void D3D12RHIDevice::DestroyTexture(RHITexture* texture)
+{
+	D3D12RHITexture* d3dTexture = ToTexture(texture);
+	if (!d3dTexture)
+		return;
+
+	if (d3dTexture->handle)
+	{
+		m_renderer->DestroyTexture(d3dTexture->handle);
+		d3dTexture->handle = nullptr;
+	}
+	else if (d3dTexture->resource)
+	{
+		m_renderer->DeferRelease(d3dTexture->resource);
+	}
+	d3dTexture->resource = nullptr;
+
+	if (d3dTexture->viewHeap)
+	{
+		m_renderer->DeferRelease(d3dTexture->viewHeap);
+		d3dTexture->viewHeap = nullptr;
+	}
+
+	if (d3dTexture->srvIndex != RHI_INVALID_INDEX)
+	{
+		m_renderer->GetBindlessHeap()->Free(d3dTexture->srvIndex);
+		d3dTexture->srvIndex = RHI_INVALID_INDEX;
+	}
+
+	delete d3dTexture;
+}
+
+uint32 D3D12RHIDevice::GetTextureIndex(RHITexture* texture)
+{
+	D3D12RHITexture* d3dTexture = ToTexture(texture);
+	return d3dTexture ? d3dTexture->srvIndex : RHI_INVALID_INDEX;
+}
+
+RHIPipeline* D3D12RHIDevice::CreatePipeline(const RHIPipelineDesc& desc)
+{
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+	psoDesc.InputLayout = m_renderer->GetMaterialSystem()->GetInputLayout();
+	psoDesc.pRootSignature = m_renderer->GetBindlessHeap()->GetRootSignature();
+	psoDesc.VS = { desc.vertexShader, desc.vertexShaderSize };
+	psoDesc.PS = { desc.pixelShader, desc.pixelShaderSize };
+	psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+	psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+	psoDesc.DepthStencilState.DepthEnable = desc.depthTest ? TRUE : FALSE;
+	psoDesc.SampleMask = UINT_MAX;
+	psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	psoDesc.NumRenderTargets = desc.colorFormat != RHI_FORMAT_UNKNOWN ? 1 : 0;
+	psoDesc.RTVFormats[0] = static_cast<DXGI_FORMAT>(desc.colorFormat);
+	psoDesc.DSVFormat = static_cast<DXGI_FORMAT>(desc.depthFormat);
+	psoDesc.SampleDesc.Count = 1;
+
+	return ToRHIPipeline(m_renderer->GetPipelineCache()->GetPipelineState(psoDesc));
+}
+
+void D3D12RHIDevice::DestroyPipeline(RHIPipeline* pipeline)
+{
+	if (pipeline)
+		m_renderer->DeferRelease(ToPipelineState(pipeline));
+}
+
+RHICommandList* D3D12RHIDevice::CreateCommandList()
+{
+	D3D12RHICommandList* commandList = new D3D12RHICommandList;
+	commandList->Init(this, m_renderer);
+	return commandList;
+}
+
+void D3D12RHIDevice::DestroyCommandList(RHICommandList* commandList)
+{
+	if (!commandList)
+		return;
+
+	// Lists given to the RHI are always the ones it created.
+	D3D12RHICommandList* d3dCommandList = static_cast<D3D12RHICommandList*>(commandList);
+	d3dCommandList->Clean();
+	delete d3dCommandList;
+}
+
+uint64 D3D12RHIDevice::Submit(RHICommandList* const* commandLists, uint32 commandListsCount)
+{
+	// Buffers and textures created so far are uploaded before the lists run.
+	m_renderer->GetUploadRing()->Submit();
+
+	uint64 fenceValue = ++m_fenceValue;
+	ID3D12CommandQueue* commandQueue = m_renderer->GetCommandQueue();
+
+	ID3D12CommandList* d3dCommandLists[s_MaxSubmitLists] = {};
+	uint32 d3dCommandListsCount = 0;
+	for (uint32 i = 0; i < commandListsCount; i++)
+	{
+		D3D12RHICommandList* commandList = static_cast<D3D12RHICommandList*>(commandLists[i]);
+		commandList->SetFenceValue(fenceValue);
+		d3dCommandLists[d3dCommandListsCount++] = commandList->GetCommandList();
+
+		if (d3dCommandListsCount == s_MaxSubmitLists || i + 1 == commandListsCount)
+		{
+			commandQueue->ExecuteCommandLists(d3dCommandListsCount, d3dCommandLists);
+			d3dCommandListsCount = 0;
+		}
+	}
+
+	ThrowIfFailed(commandQueue->Signal(m_fence, fenceValue));
+	return fenceValue;
+}
+
+uint64 D3D12RHIDevice::GetCompletedFenceValue()
+{
+	return m_fence->GetCompletedValue();
+}
+
+void D3D12RHIDevice::WaitForFence(uint64 fenceValue)
+{
+	if (m_fence->GetCompletedValue() >= fenceValue)
+		return;
+
+	ThrowIfFailed(m_fence->SetEventOnCompletion(fenceValue, m_fenceEvent));
+	::WaitForSingleObject(m_fenceEvent, INFINITE);
+}
+
+// Each target gets a one-entry RTV or DSV heap; there are few of them.
+RHITexture* D3D12RHIDevice::CreateTarget(const RHITextureDesc& desc)
+{
+	bool isDepth = (desc.usage & RHI_TEXTURE_USAGE_DEPTH_STENCIL) != 0;
+	DXGI_FORMAT format = static_cast<DXGI_FORMAT>(desc.format);
+
+	D3D12_CLEAR_VALUE clearValue = {};
+	clearValue.Format = format;
+	if (isDepth)
+	{
+		clearValue.DepthStencil.Depth = desc.clearDepth;
+	}
+	else
+	{
+		::memcpy(clearValue.Color, desc.clearColor, sizeof(clearValue.Color));
+	}
+
+	D3D12_RESOURCE_FLAGS flags = isDepth ? D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL : D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+	D3D12_RESOURCE_STATES initialState = isDepth ? D3D12_RESOURCE_STATE_DEPTH_WRITE : D3D12_RESOURCE_STATE_RENDER_TARGET;
+
+	D3D12RHITexture* texture = new D3D12RHITexture;
+	ThrowIfFailed(m_device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Tex2D(format, desc.width, desc.height, 1, 1, 1, 0, flags),
+		initialState,
+		&clearValue,
+		IID_PPV_ARGS(&texture->resource)));
+
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+	heapDesc.NumDescriptors = 1;
+	heapDesc.Type = isDepth ? D3D12_DESCRIPTOR_HEAP_TYPE_DSV : D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	ThrowIfFailed(m_device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&texture->viewHeap)));
+
+	D3D12_CPU_DESCRIPTOR_HANDLE viewHandle = texture->viewHeap->GetCPUDescriptorHandleForHeapStart();
+	if (isDepth)
+	{
+		m_device->CreateDepthStencilView(texture->resource, nullptr, viewHandle);
+		return reinterpret_cast<RHITexture*>(texture);
+	}
+
+	m_device->CreateRenderTargetView(texture->resource, nullptr, viewHandle);
+
+	// Depth targets are not sampled, so only color targets get a bindless index.
+	if (desc.usage & RHI_TEXTURE_USAGE_SHADER_RESOURCE)
+	{
+		D3D12BindlessHeap* bindlessHeap = m_renderer->GetBindlessHeap();
+		texture->srvIndex = bindlessHeap->Allocate();
+		if (texture->srvIndex != BINDLESS_INVALID_INDEX)
+			D3D12Utils::CreateTextureSRV(m_device, texture->resource, format, bindlessHeap->GetCpuHandle(texture->srvIndex));
+	}
+
+	return reinterpret_cast<RHITexture*>(texture);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "../Common/RHI.h"
+
+class D3D12Renderer;
+class D3D12RHIDevice;
+struct TextureHandle;
+
+struct D3D12RHIBuffer
+{
+	VertexBuffer* vertexBuffer = nullptr;	// One of the two, by usage.
+	IndexBuffer* indexBuffer = nullptr;
+};
+
+struct D3D12RHITexture
+{
+	ID3D12Resource* resource = nullptr;
+	TextureHandle* handle = nullptr;		// Textures created with data, owned by the renderer.
+	ID3D12DescriptorHeap* viewHeap = nullptr;	// The RTV or DSV of a target.
+	uint32 srvIndex = RHI_INVALID_INDEX;
+};
+
+/*
+=====================
+D3D12RHICommandList
+=====================
+*/
+
+// Draws go through the bindless root signature: SetConstants writes the
+// renderer's constant ring and sets a root CBV, and the bindless heap, frame
+// constants and materials are bound once in Begin.
+class D3D12RHICommandList : public RHICommandList
+{
+public:
+	// Records into its own allocator and list, executed by D3D12RHIDevice::Submit.
+	void Init(D3D12RHIDevice* device, D3D12Renderer* renderer);
+	// Records into a list reset and executed by someone else, such as the
+	// renderer's frame list. Begin and End do nothing and it is never submitted.
+	void Init(D3D12Renderer* renderer, ID3D12GraphicsCommandList* commandList);
+	void Clean();
+
+	void Begin() override;
+	void End() override;
+
+	void TextureBarrier(RHITexture* texture, RHI_RESOURCE_STATE before, RHI_RESOURCE_STATE after) override;
+	void SetRenderTargets(RHITexture* colorTarget, RHITexture* depthTarget) override;
+	void ClearRenderTarget(RHITexture* texture, const float color[4]) override;
+	void ClearDepth(RHITexture* texture, float depth) override;
+	void SetViewport(uint32 width, uint32 height) override;
+
+	void SetPipeline(RHIPipeline* pipeline) override;
+	// Constants live in the renderer's ring, so owned lists must be submitted
+	// before the renderer's frame after next.
+	bool SetConstants(RHI_CONSTANTS_SLOT slot, const void* data, uint32 size) override;
+	void SetVertexBuffer(RHIBuffer* buffer) override;
+	void SetIndexBuffer(RHIBuffer* buffer) override;
+	void DrawIndexed(uint32 indexCount, uint32 startIndex, int32 baseVertex) override;
+
+	inline ID3D12GraphicsCommandList* GetCommandList() { return m_commandList; }
+	inline bool IsOwned() const { return m_commandAllocator != nullptr; }
+	// Set by Submit; Begin waits for it before the allocator is reset.
+	inline void SetFenceValue(uint64 fenceValue) { m_fenceValue = fenceValue; }
+
+private:
+	D3D12Renderer* m_renderer = nullptr;
+	D3D12RHIDevice* m_device = nullptr;
+	ID3D12CommandAllocator* m_commandAllocator = nullptr;
+	ID3D12GraphicsCommandList* m_commandList = nullptr;
+	uint64 m_fenceValue = 0;
+};
+
+/*
+=================
+D3D12RHIDevice
+=================
+*/
+
+// The RHI over the renderer's device and queue. Pipelines are pipeline cache
+// entries over the bindless root signature and the engine's Vertex layout,
+// textures are bindless, and buffers are uploaded through the upload ring.
+// Everything runs on the renderer's queue ahead of its frame fence, so objects
+// are destroyed through D3D12Renderer::DeferRelease.
+class D3D12RHIDevice : public RHIDevice
+{
+public:
+	void Init(D3D12Renderer* renderer);
+	// Waits for everything submitted. Every object must have been destroyed.
+	void Clean();
+
+	RHIBuffer* CreateBuffer(const RHIBufferDesc& desc, const void* data) override;
+	void DestroyBuffer(RHIBuffer* buffer) override;
+
+	RHITexture* CreateTexture(const RHITextureDesc& desc, const void* data, uint32 rowPitch) override;
+	void DestroyTexture(RHITexture* texture) override;
+	uint32 GetTextureIndex(RHITexture* texture) override;
+
+	RHIPipeline* CreatePipeline(const RHIPipelineDesc& desc) override;
+	void DestroyPipeline(RHIPipeline* pipeline) override;
+
+	RHICommandList* CreateCommandList() override;
+	void DestroyCommandList(RHICommandList* commandList) override;
+
+	uint64 Submit(RHICommandList* const* commandLists, uint32 commandListsCount) override;
+	uint64 GetCompletedFenceValue() override;
+	void WaitForFence(uint64 fenceValue) override;
+
+	// Pipelines from elsewhere, such as D3D12MaterialSystem, can be set on RHI
+	// command lists. They are not the RHI's to destroy.
+	static inline RHIPipeline* ToRHIPipeline(ID3D12PipelineState* pipelineState) { return reinterpret_cast<RHIPipeline*>(pipelineState); }
+	static inline ID3D12PipelineState* ToPipelineState(RHIPipeline* pipeline) { return reinterpret_cast<ID3D12PipelineState*>(pipeline); }
+	static inline D3D12RHIBuffer* ToBuffer(RHIBuffer* buffer) { return reinterpret_cast<D3D12RHIBuffer*>(buffer); }
+	static inline D3D12RHITexture* ToTexture(RHITexture* texture) { return reinterpret_cast<D3D12RHITexture*>(texture); }
+
+private:
+	static const uint32 s_MaxSubmitLists = 16;
+
+	D3D12Renderer* m_renderer = nullptr;
+	ID3D12Device* m_device = nullptr;
+	ID3D12Fence* m_fence = nullptr;
+	HANDLE m_fenceEvent = nullptr;
+	uint64 m_fenceValue = 0;
+
+	RHITexture* CreateTarget(const RHITextureDesc& desc);
+};
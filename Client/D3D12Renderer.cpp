@@ -1,7 +1,19 @@
 #include "pch.h"
 #include "D3D12Renderer.h"
 #include "D3D12Utils.h"
+#include "D3D12BindlessHeap.h"
+#include "D3D12ConstantRing.h"
+#include "D3D12GpuProfiler.h"
+#include "D3D12MaterialSystem.h"
 #include "D3D12Mesh.h"
+#include "D3D12MipGenerator.h"
+#include "D3D12PipelineCache.h"
+#include "D3D12RHI.h"
+#include "D3D12ShaderCache.h"
+#include "D3D12UploadRing.h"
+#include "D3D12VirtualTexture.h"
+#include "../Common/ImageFile.h"
+#include "../Common/Profiler.h"
 
 /*
 ==================
@@ -9,9 +21,10 @@ D3D12Renderer
 ==================
 */
 
-bool D3D12Renderer::Init(HWND hwnd)
+bool D3D12Renderer::Init(HWND hwnd, const char* shaderDirectory)
 {
 	m_hwnd = hwnd;
+	::QueryPerformanceCounter(&m_initTime);
 
 #if defined(_DEBUG)
 	// Enable the D3D12 debug layer.
@@ -94,6 +107,9 @@ bool D3D12Renderer::Init(HWND hwnd)
 
 	m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
 
+	// Kept for video memory usage in the frame stats.
+	factory->EnumAdapterByLuid(m_device->GetAdapterLuid(), IID_PPV_ARGS(&m_adapter));
+
 	factory->Release();
 	factory = nullptr;
 
@@ -102,6 +118,47 @@ bool D3D12Renderer::Init(HWND hwnd)
 	CreateCommandAllocatorAndList();
 	CreateFence();
 
+	m_uploadRing = new D3D12UploadRing;
+	m_uploadRing->Init(m_device, m_commandQueue, s_UploadRingSize);
+
+	m_constantRing = new D3D12ConstantRing;
+	m_constantRing->Init(m_device, s_FrameCount, s_DrawConstantsSize);
+
+	m_gpuProfiler = new D3D12GpuProfiler;
+	m_gpuProfiler->Init(this, s_FrameCount);
+
+	m_shaderCache = new D3D12ShaderCache;
+	m_shaderCache->Init(shaderDirectory, SHADER_CACHE_DIRECTORY);
+
+	char pipelineLibraryPath[MAX_PATH] = {};
+	::sprintf_s(pipelineLibraryPath, "%s\\%s", m_shaderCache->GetCacheDirectory(), PIPELINE_LIBRARY_FILENAME);
+	m_pipelineCache = new D3D12PipelineCache;
+	m_pipelineCache->Init(this, pipelineLibraryPath, s_PipelineCompileThreads);
+
+	m_mipGenerator = new D3D12MipGenerator;
+	m_mipGenerator->Init(this);
+
+	TextureStreamerSettings streamerSettings;
+	streamerSettings.budgetBytes = s_TextureBudget;
+	streamerSettings.maxTextures = s_MaxStreamedTextures;
+	streamerSettings.maxRequestsPerFrame = s_MaxStreamRequests;
+	m_textureStreamer.Init(streamerSettings);
+	m_streamedTextures = new StreamedTexture[s_MaxStreamedTextures];
+
+	m_bindlessHeap = new D3D12BindlessHeap;
+	m_bindlessHeap->Init(this, s_BindlessDescriptors);
+
+	// Material textures are streamed.
+	m_materialSystem = new D3D12MaterialSystem;
+	m_materialSystem->Init(this);
+
+	m_rhi = new D3D12RHIDevice;
+	m_rhi->Init(this);
+
+	// Draws are recorded through the RHI into the frame's list.
+	m_rhiCommandList = new D3D12RHICommandList;
+	m_rhiCommandList->Init(this, m_commandList);
+
 	m_viewport.TopLeftX = 0.0f;
 	m_viewport.TopLeftY = 0.0f;
 	m_viewport.Width = m_screenWidth;
@@ -114,6 +171,12 @@ bool D3D12Renderer::Init(HWND hwnd)
 	m_scissorRect.right = static_cast<LONG>(m_screenWidth);
 	m_scissorRect.bottom = static_cast<LONG>(m_screenHeight);
 
+	m_view = DirectX::XMMatrixLookToLH(m_eyePosition, Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 1.0f, 0.0f));
+	m_proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(70.0f), m_aspectRatio, 0.1f, 100.0f);
+
+	m_frameStats.Init();
+	m_frameStartTicks = Profiler::GetTicks();
+
 	return true;
 }
 
@@ -121,11 +184,115 @@ void D3D12Renderer::Clean()
 {
 	WaitForPreviousFrame();
 
+	if (m_rhiCommandList)
+	{
+		m_rhiCommandList->Clean();
+		delete m_rhiCommandList;
+		m_rhiCommandList = nullptr;
+	}
+
+	if (m_rhi)
+	{
+		m_rhi->Clean();
+		delete m_rhi;
+		m_rhi = nullptr;
+	}
+
+	if (m_materialSystem)
+	{
+		m_materialSystem->Clean();
+		delete m_materialSystem;
+		m_materialSystem = nullptr;
+	}
+
+	// After the materials, which destroy their own, and before the heap they take descriptors from.
+	for (uint32 i = 0; i < s_MaxVirtualTextures; i++)
+	{
+		DestroyVirtualTexture(m_virtualTextures[i]);
+	}
+
+	if (m_bindlessHeap)
+	{
+		m_bindlessHeap->Clean();
+		delete m_bindlessHeap;
+		m_bindlessHeap = nullptr;
+	}
+
+	if (m_mipGenerator)
+	{
+		m_mipGenerator->Clean();
+		delete m_mipGenerator;
+		m_mipGenerator = nullptr;
+	}
+
+	if (m_gpuProfiler)
+	{
+		m_gpuProfiler->Clean();
+		delete m_gpuProfiler;
+		m_gpuProfiler = nullptr;
+	}
+
+	ReleaseDeferred(UINT64_MAX);
+
+	if (m_deferredReleases)
+	{
+		delete[] m_deferredReleases;
+		m_deferredReleases = nullptr;
+	}
+	m_deferredReleasesCapacity = 0;
+
+	if (m_streamedTextures)
+	{
+		delete[] m_streamedTextures;
+		m_streamedTextures = nullptr;
+	}
+	m_textureStreamer.Clean();
+
+	if (m_pipelineCache)
+	{
+		const PipelineCacheStats& stats = m_pipelineCache->GetStats();
+		::printf("Pipelines: %u created in %.1f ms (%u in the background), %u loaded from the library in %.1f ms, %u from memory, %u fallback draws\n",
+			stats.createsCount, stats.createMilliseconds, stats.asyncCreatesCount, stats.libraryHitsCount, stats.loadMilliseconds, stats.memoryHitsCount, stats.fallbacksCount);
+
+		m_pipelineCache->Clean();
+		delete m_pipelineCache;
+		m_pipelineCache = nullptr;
+	}
+
+	if (m_shaderCache)
+	{
+		m_shaderCache->Clean();
+		delete m_shaderCache;
+		m_shaderCache = nullptr;
+	}
+
+	if (m_constantRing)
+	{
+		m_constantRing->Clean();
+		delete m_constantRing;
+		m_constantRing = nullptr;
+	}
+
+	if (m_uploadRing)
+	{
+		m_uploadRing->Clean();
+		delete m_uploadRing;
+		m_uploadRing = nullptr;
+	}
+
 	DestroyFence();
 	DestroyCommandAllocatorAndList();
 	DestroyFrameResources();
 	DestroyDesriptorHeap();
 
+	m_frameStats.Clean();
+
+	if (m_adapter)
+	{
+		m_adapter->Release();
+		m_adapter = nullptr;
+	}
+
 	if (m_swapChain)
 	{
 		m_swapChain->Release();
@@ -156,13 +323,30 @@ void D3D12Renderer::Clean()
 
 void D3D12Renderer::Update()
 {
+	PROFILE_SCOPE("Update");
+
+	if (m_shaderCache->PollChanges())
+		m_pipelineCache->ReloadShaders();
+
+	m_pipelineCache->Update();
 }
 
 void D3D12Renderer::BeginRender()
 {
+	PROFILE_SCOPE("BeginRender");
+
+	UpdateTextureStreaming();
+
+	for (uint32 i = 0; i < s_MaxVirtualTextures; i++)
+	{
+		if (m_virtualTextures[i])
+			m_virtualTextures[i]->Update();
+	}
+
 	ThrowIfFailed(m_commandAllocator->Reset());
 
 	ThrowIfFailed(m_commandList->Reset(m_commandAllocator, nullptr));
+	m_gpuProfiler->BeginFrame(m_commandList);
 
 	// Set necessary state.
 	m_commandList->RSSetViewports(1, &m_viewport);
@@ -176,19 +360,50 @@ void D3D12Renderer::BeginRender()
 	CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
 	m_commandList->OMSetRenderTargets(1, &rtvHandle, 1, &dsvHandle);
 
+	m_gpuProfiler->BeginZone(m_commandList, "Clear");
 	const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
 	m_commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
 	m_commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+	m_gpuProfiler->EndZone(m_commandList);
+
+	m_constantRing->BeginFrame(m_frameIndex);
+
+	FrameConstants frameConstants;
+	frameConstants.view = m_view.Transpose();
+	frameConstants.proj = m_proj.Transpose();
+	frameConstants.frameIndex = static_cast<uint32>(m_fenceValue);
+	m_frameConstants = m_constantRing->Push(&frameConstants, sizeof(frameConstants));
+
+	BindGlobalState(m_commandList);
+
+	// Closed in EndRender.
+	m_gpuProfiler->BeginZone(m_commandList, "Scene");
 }
 
 void D3D12Renderer::EndRender()
 {
+	PROFILE_SCOPE("EndRender");
+
+	m_gpuProfiler->EndZone(m_commandList);
+
+	m_gpuProfiler->BeginZone(m_commandList, "TextureFeedback");
+	for (uint32 i = 0; i < s_MaxVirtualTextures; i++)
+	{
+		if (m_virtualTextures[i])
+			m_virtualTextures[i]->RecordFeedback(m_commandList);
+	}
+	m_gpuProfiler->EndZone(m_commandList);
+
 	// Indicate that the back buffer will now be used to present.
 	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex], D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
 	m_commandList->ResourceBarrier(1, &barrier);
 
+	m_gpuProfiler->EndFrame(m_commandList);
 	ThrowIfFailed(m_commandList->Close());
 
+	// Pending uploads go first on the same queue, so no extra sync is needed.
+	m_uploadRing->Submit();
+
 	// Execute the command list.
 	ID3D12CommandList* ppCommandLists[] = { m_commandList };
 	m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
@@ -196,10 +411,35 @@ void D3D12Renderer::EndRender()
 
 void D3D12Renderer::Present()
 {
+	PROFILE_SCOPE("Present");
+
 	// Present the frame.
 	ThrowIfFailed(m_swapChain->Present(1, 0));
 
+	uint64 waitStartTicks = Profiler::GetTicks();
 	WaitForPreviousFrame();
+	EndFrameStats(Profiler::GetTicks() - waitStartTicks);
+
+	// Delete the shader cache directory to measure a cold start.
+	if (!m_firstFramePresented)
+	{
+		LARGE_INTEGER frequency = {};
+		LARGE_INTEGER time = {};
+		::QueryPerformanceFrequency(&frequency);
+		::QueryPerformanceCounter(&time);
+
+		const ShaderCacheStats& stats = m_shaderCache->GetStats();
+		float milliseconds = static_cast<float>(time.QuadPart - m_initTime.QuadPart) * 1000.0f / static_cast<float>(frequency.QuadPart);
+		::printf("Startup: %.1f ms to first frame, %.1f ms in shaders (%u compiled, %u from disk, %u from memory)\n",
+			milliseconds, stats.milliseconds, stats.compilesCount, stats.diskHitsCount, stats.memoryHitsCount);
+
+		const PipelineCacheStats& pipelineStats = m_pipelineCache->GetStats();
+		uint32 pipelinesCount = pipelineStats.createsCount + pipelineStats.libraryHitsCount + pipelineStats.memoryHitsCount;
+		float hitRate = pipelinesCount ? 100.0f * static_cast<float>(pipelinesCount - pipelineStats.createsCount) / static_cast<float>(pipelinesCount) : 0.0f;
+		::printf("Startup: %.1f ms creating pipelines, %.1f ms loading them, %.0f%% hit rate\n", pipelineStats.createMilliseconds, pipelineStats.loadMilliseconds, hitRate);
+
+		m_firstFramePresented = true;
+	}
 }
 
 D3D12Mesh* D3D12Renderer::CreateMesh(MeshData meshData)
@@ -209,9 +449,21 @@ D3D12Mesh* D3D12Renderer::CreateMesh(MeshData meshData)
 	return mesh;
 }
 
+D3D12Mesh* D3D12Renderer::CreateMesh(const char* filename)
+{
+	D3D12Mesh* mesh = new D3D12Mesh;
+	if (!mesh->Init(this, filename))
+	{
+		delete mesh;
+		return nullptr;
+	}
+	return mesh;
+}
+
 void D3D12Renderer::RenderMesh(D3D12Mesh* mesh)
 {
-	mesh->Render(m_commandList);
+	PROFILE_SCOPE("RenderMesh");
+	mesh->Render(m_rhiCommandList);
 }
 
 void D3D12Renderer::DestroyMesh(D3D12Mesh* mesh)
@@ -224,6 +476,249 @@ void D3D12Renderer::DestroyMesh(D3D12Mesh* mesh)
 	}
 }
 
+Material* D3D12Renderer::CreateMaterial(const MaterialDesc& desc)
+{
+	return m_materialSystem->CreateMaterial(desc);
+}
+
+void D3D12Renderer::DestroyMaterial(Material* material)
+{
+	m_materialSystem->DestroyMaterial(material);
+}
+
+TextureHandle* D3D12Renderer::CreateStreamedTexture(const char* filename, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
+{
+	// Uncooked images have no mip chain on disk to stream from; they get one at load time.
+	if (ImageFile::IsSupported(filename))
+		return D3D12Utils::CreateTexture2D(m_device, m_uploadRing, filename, srvHandle);
+
+	DDSFileView view;
+	if (!DDSFile::Open(filename, &view))
+		return nullptr;
+
+	const DDSTextureInfo& info = view.info;
+
+	// A single mip has nothing to stream; CreateTexture2D builds its chain instead.
+	if (info.mipLevels == 1)
+	{
+		DDSFile::Close(&view);
+		return D3D12Utils::CreateTexture2D(m_device, m_uploadRing, filename, srvHandle);
+	}
+
+	StreamedTextureDesc desc;
+	desc.width = info.width;
+	desc.height = info.height;
+	desc.mipLevels = info.mipLevels;
+	desc.blockCompressed = DDSFile::IsBlockCompressed(info.format);
+	for (uint32 mip = 0; mip < info.mipLevels; mip++)
+	{
+		desc.mipSizes[mip] = info.mips[mip].size * info.arraySize;
+	}
+
+	// Out of streaming slots, or a BC texture whose mips cannot be a top mip:
+	// fall back to a fully resident texture.
+	uint32 streamingId = m_textureStreamer.Register(desc);
+	if (streamingId == TEXTURE_STREAMER_INVALID_ID)
+	{
+		DDSFile::Close(&view);
+		return D3D12Utils::CreateTexture2D(m_device, m_uploadRing, filename, srvHandle);
+	}
+
+	uint32 tailMip = m_textureStreamer.GetResidentMip(streamingId);
+
+	TextureHandle* texture = new TextureHandle;
+	texture->resource = D3D12Utils::CreateTextureResource(m_device, info, tailMip);
+	texture->srvHandle = srvHandle;
+	texture->mostDetailedMip = tailMip;
+	texture->streamingId = streamingId;
+
+	D3D12Utils::UploadTextureMips(m_device, m_uploadRing, texture->resource, view, tailMip, info.mipLevels - tailMip, tailMip);
+	D3D12Utils::CreateTextureSRV(m_device, texture->resource, info, srvHandle);
+
+	m_streamedTextures[streamingId].handle = texture;
+	m_streamedTextures[streamingId].view = view;
+
+	return texture;
+}
+
+TextureHandle* D3D12Renderer::CreateTexture2D(uint32 width, uint32 height, DXGI_FORMAT format, const void* pixels, uint32 rowPitch, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
+{
+	return D3D12Utils::CreateTexture2D(m_device, m_uploadRing, m_mipGenerator, width, height, format, pixels, rowPitch, srvHandle);
+}
+
+void D3D12Renderer::DestroyTexture(TextureHandle* texture)
+{
+	if (!texture)
+		return;
+
+	if (texture->streamingId != TEXTURE_STREAMER_INVALID_ID)
+	{
+		StreamedTexture& streamed = m_streamedTextures[texture->streamingId];
+		DDSFile::Close(&streamed.view);
+		streamed = {};
+
+		m_textureStreamer.Unregister(texture->streamingId);
+	}
+
+	if (texture->resource)
+	{
+		DeferRelease(texture->resource);
+		texture->resource = nullptr;
+	}
+
+	delete texture;
+}
+
+void D3D12Renderer::RequestTextureResolution(TextureHandle* texture, float screenPixels)
+{
+	if (texture && texture->streamingId != TEXTURE_STREAMER_INVALID_ID)
+		m_textureStreamer.ReportScreenSize(texture->streamingId, screenPixels);
+}
+
+D3D12VirtualTexture* D3D12Renderer::CreateVirtualTexture(const char* filename)
+{
+	for (uint32 i = 0; i < s_MaxVirtualTextures; i++)
+	{
+		if (m_virtualTextures[i])
+			continue;
+
+		D3D12VirtualTexture* texture = new D3D12VirtualTexture;
+		if (!texture->Init(this, filename, s_VirtualTexturePages))
+		{
+			delete texture;
+			return nullptr;
+		}
+
+		m_virtualTextures[i] = texture;
+		return texture;
+	}
+
+	return nullptr;
+}
+
+void D3D12Renderer::DestroyVirtualTexture(D3D12VirtualTexture* texture)
+{
+	if (!texture)
+		return;
+
+	for (uint32 i = 0; i < s_MaxVirtualTextures; i++)
+	{
+		if (m_virtualTextures[i] == texture)
+			m_virtualTextures[i] = nullptr;
+	}
+
+	texture->Clean();
+	delete texture;
+}
+
+void D3D12Renderer::GenerateMips(ID3D12Resource* texture, DXGI_FORMAT format)
+{
+	// The generator swaps the descriptor heap out from under the bindless table.
+	m_gpuProfiler->BeginZone(m_commandList, "GenerateMips");
+	m_mipGenerator->Generate(m_commandList, texture, format);
+	m_gpuProfiler->EndZone(m_commandList);
+	BindGlobalState(m_commandList);
+}
+
+void D3D12Renderer::DeferRelease(IUnknown* object)
+{
+	if (m_deferredReleasesCount == m_deferredReleasesCapacity)
+	{
+		uint32 capacity = m_deferredReleasesCapacity ? m_deferredReleasesCapacity * 2 : 64;
+		DeferredRelease* deferredReleases = new DeferredRelease[capacity];
+		for (uint32 i = 0; i < m_deferredReleasesCount; i++)
+		{
+			deferredReleases[i] = m_deferredReleases[i];
+		}
+
+		delete[] m_deferredReleases;
+		m_deferredReleases = deferredReleases;
+		m_deferredReleasesCapacity = capacity;
+	}
+
+	// m_fenceValue is signaled after the frame currently being recorded.
+	DeferredRelease& deferred = m_deferredReleases[m_deferredReleasesCount++];
+	deferred.object = object;
+	deferred.fenceValue = m_fenceValue;
+}
+
+void D3D12Renderer::UpdateTextureStreaming()
+{
+	PROFILE_SCOPE("UpdateTextureStreaming");
+
+	TextureStreamRequest requests[s_MaxStreamRequests];
+	uint32 requestsCount = m_textureStreamer.Update(requests, s_MaxStreamRequests);
+
+	for (uint32 i = 0; i < requestsCount; i++)
+	{
+		ApplyStreamRequest(requests[i]);
+		m_textureStreamer.CompleteRequest(requests[i].textureId);
+	}
+}
+
+void D3D12Renderer::ApplyStreamRequest(const TextureStreamRequest& request)
+{
+	StreamedTexture& streamed = m_streamedTextures[request.textureId];
+	TextureHandle* texture = streamed.handle;
+	const DDSTextureInfo& info = streamed.view.info;
+
+	uint32 oldMip = texture->mostDetailedMip;
+	uint32 newMip = request.mostDetailedMip;
+	if (oldMip == newMip)
+		return;
+
+	ID3D12Resource* resource = D3D12Utils::CreateTextureResource(m_device, info, newMip);
+	uint32 oldMipLevels = info.mipLevels - oldMip;
+	uint32 newMipLevels = info.mipLevels - newMip;
+
+	// Only mips the old texture lacks are read from the file.
+	if (newMip < oldMip)
+		D3D12Utils::UploadTextureMips(m_device, m_uploadRing, resource, streamed.view, newMip, oldMip - newMip, newMip);
+
+	// The rest are copied on the GPU from the old texture.
+	ID3D12GraphicsCommandList* commandList = m_uploadRing->GetCommandList();
+	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(texture->resource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	commandList->ResourceBarrier(1, &barrier);
+
+	uint32 firstSharedMip = oldMip > newMip ? oldMip : newMip;
+	for (uint32 slice = 0; slice < info.arraySize; slice++)
+	{
+		for (uint32 mip = firstSharedMip; mip < info.mipLevels; mip++)
+		{
+			uint32 dstSubresource = D3D12CalcSubresource(mip - newMip, slice, 0, newMipLevels, info.arraySize);
+			CD3DX12_TEXTURE_COPY_LOCATION dst(resource, dstSubresource);
+			CD3DX12_TEXTURE_COPY_LOCATION src(texture->resource, D3D12CalcSubresource(mip - oldMip, slice, 0, oldMipLevels, info.arraySize));
+			commandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+
+			barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, dstSubresource);
+			commandList->ResourceBarrier(1, &barrier);
+		}
+	}
+
+	// Present waits for the GPU, so nothing reads the descriptor while it is rewritten here.
+	DeferRelease(texture->resource);
+	texture->resource = resource;
+	texture->mostDetailedMip = newMip;
+	D3D12Utils::CreateTextureSRV(m_device, resource, info, texture->srvHandle);
+}
+
+void D3D12Renderer::ReleaseDeferred(uint64 completedFenceValue)
+{
+	uint32 remaining = 0;
+	for (uint32 i = 0; i < m_deferredReleasesCount; i++)
+	{
+		DeferredRelease& deferred = m_deferredReleases[i];
+		if (deferred.fenceValue <= completedFenceValue)
+			deferred.object->Release();
+		else
+			m_deferredReleases[remaining++] = deferred;
+	}
+	m_deferredReleasesCount = remaining;
+
+	if (m_bindlessHeap)
+		m_bindlessHeap->ReleaseDeferred(completedFenceValue);
+}
+
 void D3D12Renderer::CreateDescriptorHeap()
 {
 	D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
@@ -373,6 +868,8 @@ void D3D12Renderer::DestroyFence()
 
 void D3D12Renderer::WaitForPreviousFrame()
 {
+	PROFILE_SCOPE("WaitForPreviousFrame");
+
 	uint64 curFenceValue = m_fenceValue++;
 	m_commandQueue->Signal(m_fence, curFenceValue);
 
@@ -383,4 +880,67 @@ void D3D12Renderer::WaitForPreviousFrame()
 	}
 
 	m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
+
+	ReleaseDeferred(m_fence->GetCompletedValue());
+}
+
+// Bound once per command list: draws only change pipelines and the object CBV.
+void D3D12Renderer::BindGlobalState(ID3D12GraphicsCommandList* commandList)
+{
+	m_bindlessHeap->Bind(commandList);
+	commandList->SetGraphicsRootConstantBufferView(BINDLESS_ROOT_PARAMETER_FRAME_CONSTANTS, m_frameConstants);
+	commandList->SetGraphicsRootShaderResourceView(BINDLESS_ROOT_PARAMETER_MATERIALS, m_materialSystem->GetConstantsAddress());
+
+	// Heap, texture and UAV tables, frame CBV and material SRV.
+	m_frameStats.Add(FRAME_STAT_DESCRIPTOR_BINDS, 5);
+}
+
+// Draw counters were added while recording; the rest is sampled here.
+void D3D12Renderer::EndFrameStats(uint64 waitTicks)
+{
+	uint64 ticks = Profiler::GetTicks();
+	float millisecondsPerTick = 1000.0f / static_cast<float>(Profiler::GetTicksPerSecond());
+	float frameMilliseconds = static_cast<float>(ticks - m_frameStartTicks) * millisecondsPerTick;
+	m_frameStartTicks = ticks;
+
+	m_frameStats.SetMilliseconds(FRAME_STAT_FRAME_MILLISECONDS, frameMilliseconds);
+	m_frameStats.SetMilliseconds(FRAME_STAT_CPU_MILLISECONDS, frameMilliseconds - static_cast<float>(waitTicks) * millisecondsPerTick);
+	m_frameStats.SetMilliseconds(FRAME_STAT_GPU_MILLISECONDS, m_gpuProfiler->GetFrameMilliseconds());
+
+	uint64 uploadedBytes = m_uploadRing->GetAllocatedBytes();
+	m_frameStats.Set(FRAME_STAT_UPLOAD_BYTES, uploadedBytes - m_uploadedBytes);
+	m_uploadedBytes = uploadedBytes;
+
+	if (m_adapter)
+	{
+		DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+		if (SUCCEEDED(m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo)))
+			m_frameStats.Set(FRAME_STAT_LOCAL_MEMORY_BYTES, memoryInfo.CurrentUsage);
+		if (SUCCEEDED(m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &memoryInfo)))
+			m_frameStats.Set(FRAME_STAT_NON_LOCAL_MEMORY_BYTES, memoryInfo.CurrentUsage);
+	}
+	m_frameStats.Set(FRAME_STAT_STREAMED_TEXTURE_BYTES, m_textureStreamer.GetResidentBytes());
+
+	m_frameStats.EndFrame();
+
+	if (m_statsOverlay && ticks - m_statsOverlayTicks >= Profiler::GetTicksPerSecond() * s_StatsOverlayMilliseconds / 1000)
+	{
+		UpdateStatsOverlay();
+		m_statsOverlayTicks = ticks;
+	}
+}
+
+// There is no text rendering yet, so the overlay is the window title.
+void D3D12Renderer::UpdateStatsOverlay()
+{
+	FrameStatSummary frame = m_frameStats.GetSummary(FRAME_STAT_FRAME_MILLISECONDS);
+	FrameStatSummary cpu = m_frameStats.GetSummary(FRAME_STAT_CPU_MILLISECONDS);
+	FrameStatSummary gpu = m_frameStats.GetSummary(FRAME_STAT_GPU_MILLISECONDS);
+	FrameStatSummary draws = m_frameStats.GetSummary(FRAME_STAT_DRAW_CALLS);
+	FrameStatSummary triangles = m_frameStats.GetSummary(FRAME_STAT_TRIANGLES);
+
+	char text[256] = {};
+	::sprintf_s(text, "Frame %.2f ms (p95 %.2f, p99 %.2f) | CPU %.2f ms | GPU %.2f ms | %.0f draws, %.0fk triangles",
+		frame.p50, frame.p95, frame.p99, cpu.p50, gpu.p50, draws.last, triangles.last / 1000.0);
+	::SetWindowTextA(m_hwnd, text);
 }
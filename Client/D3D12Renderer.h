@@ -1,6 +1,10 @@
 #pragma once
 
 #include "../Common/Vertex.h"
+#include "../Common/DDSFile.h"
+#include "../Common/FrameStats.h"
+#include "../Common/RHI.h"
+#include "../Common/TextureStreamer.h"
 
 /*
 ==================
@@ -8,12 +12,27 @@ D3D12Renderer
 ==================
 */
 
+class D3D12BindlessHeap;
+class D3D12ConstantRing;
+class D3D12GpuProfiler;
+class D3D12MaterialSystem;
 class D3D12Mesh;
+class D3D12MipGenerator;
+class D3D12PipelineCache;
+class D3D12RHICommandList;
+class D3D12RHIDevice;
+class D3D12ShaderCache;
+class D3D12UploadRing;
+class D3D12VirtualTexture;
+struct Material;
+struct MaterialDesc;
+struct TextureHandle;
 
 class D3D12Renderer
 {
 public:
-	bool Init(HWND hwnd);
+	// shaderDirectory is watched for edits; see D3D12ShaderCache.
+	bool Init(HWND hwnd, const char* shaderDirectory);
 	void Clean();
 	void Update();
 	void BeginRender();
@@ -21,19 +40,98 @@ public:
 	void Present();
 
 	D3D12Mesh* CreateMesh(MeshData meshData);
+	D3D12Mesh* CreateMesh(const char* filename);
 	void RenderMesh(D3D12Mesh* mesh);
 	void DestroyMesh(D3D12Mesh* mesh);
 
+	// See D3D12MaterialSystem. Returns nullptr when out of material slots.
+	Material* CreateMaterial(const MaterialDesc& desc);
+	void DestroyMaterial(Material* material);
+
+	// Streamed textures start with only their mip tail resident and gain or
+	// lose mips as RequestTextureResolution demand and the budget allow.
+	TextureHandle* CreateStreamedTexture(const char* filename, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle);
+	// Runtime-generated pixels: mip 0 is uploaded and the chain is built on the GPU.
+	TextureHandle* CreateTexture2D(uint32 width, uint32 height, DXGI_FORMAT format, const void* pixels, uint32 rowPitch, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle);
+	void DestroyTexture(TextureHandle* texture);
+	void RequestTextureResolution(TextureHandle* texture, float screenPixels);
+	inline void SetTextureBudget(uint64 budgetBytes) { m_textureStreamer.SetBudget(budgetBytes); }
+
+	// Virtual textures map 64 KB tiles on demand from shader feedback. Returns
+	// nullptr when tiled resources are unsupported, the file is not a 2D texture
+	// or the bindless heap is out of descriptors.
+	D3D12VirtualTexture* CreateVirtualTexture(const char* filename);
+	void DestroyVirtualTexture(D3D12VirtualTexture* texture);
+
+	// Rebuilds the mips of a render target from mip 0 on the frame's command list.
+	// Call between BeginRender and EndRender with the texture in PIXEL_SHADER_RESOURCE
+	// and created by D3D12Utils::CreateMipmappedTextureResource.
+	void GenerateMips(ID3D12Resource* texture, DXGI_FORMAT format);
+
+	// Releases the object once the GPU has finished every frame submitted so far
+	// and the one being recorded.
+	void DeferRelease(IUnknown* object);
+
+	// Sets the bindless heap, frame constants and material constants that every
+	// draw shares. The frame's command list gets them in BeginRender.
+	void BindGlobalState(ID3D12GraphicsCommandList* commandList);
+
 	inline ID3D12Device* GetDevice() { return m_device; }
+	inline ID3D12CommandQueue* GetCommandQueue() { return m_commandQueue; }
+	inline D3D12UploadRing* GetUploadRing() { return m_uploadRing; }
+	inline D3D12ShaderCache* GetShaderCache() { return m_shaderCache; }
+	inline D3D12PipelineCache* GetPipelineCache() { return m_pipelineCache; }
+	inline D3D12BindlessHeap* GetBindlessHeap() { return m_bindlessHeap; }
+	inline D3D12MaterialSystem* GetMaterialSystem() { return m_materialSystem; }
+	inline D3D12GpuProfiler* GetGpuProfiler() { return m_gpuProfiler; }
+	// Rewound once per frame in BeginRender.
+	inline D3D12ConstantRing* GetConstantRing() { return m_constantRing; }
+	inline RHIDevice* GetRHI() { return m_rhi; }
+	// The frame's command list, between BeginRender and EndRender.
+	inline RHICommandList* GetRHICommandList() { return m_rhiCommandList; }
 	inline float GetAspectRatio() { return m_aspectRatio; }
+	inline const Vector3& GetEyePosition() { return m_eyePosition; }
+	inline const Matrix& GetViewMatrix() { return m_view; }
+	inline const Matrix& GetProjMatrix() { return m_proj; }
+	// Signaled once the GPU is done with the frame being recorded.
+	inline uint64 GetFrameFenceValue() { return m_fenceValue; }
+	inline float GetScreenHeight() { return m_screenHeight; }
+
+	// Counters of the frame being recorded and the rolling history; see FrameStats.
+	inline FrameStats& GetFrameStats() { return m_frameStats; }
+	// Shows frame time percentiles, GPU time and draw counts in the window title.
+	inline void SetStatsOverlay(bool enabled) { m_statsOverlay = enabled; }
 
 private:
 	const static uint32 s_FrameCount = 2;
+	const static uint64 s_UploadRingSize = 32 * 1024 * 1024;
+	const static uint64 s_TextureBudget = 256 * 1024 * 1024;
+	const static uint32 s_MaxStreamedTextures = 256;
+	const static uint32 s_MaxStreamRequests = 4;
+	const static uint32 s_MaxVirtualTextures = 16;
+	const static uint32 s_VirtualTexturePages = 1024;		// 64 MB per texture.
+	const static uint32 s_PipelineCompileThreads = 2;
+	const static uint32 s_BindlessDescriptors = 4096;
+	const static uint32 s_DrawConstantsSize = 1024 * 1024;	// Per frame; 4096 draws of 256 bytes.
+	const static uint32 s_StatsOverlayMilliseconds = 500;
+
+	struct StreamedTexture
+	{
+		TextureHandle* handle = nullptr;
+		DDSFileView view = {};		// Stays mapped so finer mips can be read back in.
+	};
+
+	struct DeferredRelease
+	{
+		IUnknown* object = nullptr;
+		uint64 fenceValue = 0;
+	};
 
 	// Pipeline objects.
 	D3D12_VIEWPORT m_viewport = {};
 	D3D12_RECT m_scissorRect = {};
 	IDXGISwapChain3* m_swapChain = nullptr;
+	IDXGIAdapter3* m_adapter = nullptr;
 	ID3D12Device* m_device = nullptr;
 	ID3D12Resource* m_renderTargets[s_FrameCount] = {};
 	ID3D12Resource* m_depthStencilBuffer = nullptr;
@@ -45,6 +143,27 @@ private:
 	uint32 m_rtvDescriptorSize = 0;
 	uint32 m_dsvDesciptorSize = 0;
 
+	D3D12UploadRing* m_uploadRing = nullptr;
+	D3D12ShaderCache* m_shaderCache = nullptr;
+	D3D12PipelineCache* m_pipelineCache = nullptr;
+	D3D12MipGenerator* m_mipGenerator = nullptr;
+	D3D12BindlessHeap* m_bindlessHeap = nullptr;
+	D3D12ConstantRing* m_constantRing = nullptr;
+	D3D12GpuProfiler* m_gpuProfiler = nullptr;
+	D3D12MaterialSystem* m_materialSystem = nullptr;
+	D3D12RHIDevice* m_rhi = nullptr;
+	D3D12RHICommandList* m_rhiCommandList = nullptr;
+
+	// Indexed by streamer id.
+	TextureStreamer m_textureStreamer;
+	StreamedTexture* m_streamedTextures = nullptr;
+
+	D3D12VirtualTexture* m_virtualTextures[s_MaxVirtualTextures] = {};
+
+	DeferredRelease* m_deferredReleases = nullptr;
+	uint32 m_deferredReleasesCount = 0;
+	uint32 m_deferredReleasesCapacity = 0;
+
 	// Synchronization objects.
 	uint32 m_frameIndex = 0;
 	HANDLE m_fenceEvent = nullptr;
@@ -58,6 +177,21 @@ private:
 	float m_screenHeight = 0.0f;
 	float m_aspectRatio = 0.0f;
 
+	Vector3 m_eyePosition = Vector3(0.0f, 0.0f, -1.0f);
+	Matrix m_view = Matrix();
+	Matrix m_proj = Matrix();
+	D3D12_GPU_VIRTUAL_ADDRESS m_frameConstants = 0;
+
+	FrameStats m_frameStats;
+	uint64 m_frameStartTicks = 0;
+	uint64 m_uploadedBytes = 0;
+	uint64 m_statsOverlayTicks = 0;
+	bool m_statsOverlay = false;
+
+	// Startup is measured from Init to the first Present.
+	LARGE_INTEGER m_initTime = {};
+	bool m_firstFramePresented = false;
+
 	void CreateDescriptorHeap();
 	void CreateFrameResources();
 	void CreateCommandAllocatorAndList();
@@ -69,5 +203,12 @@ private:
 	void DestroyFence();
 
 	void WaitForPreviousFrame();
+
+	void EndFrameStats(uint64 waitTicks);
+	void UpdateStatsOverlay();
+
+	void UpdateTextureStreaming();
+	void ApplyStreamRequest(const TextureStreamRequest& request);
+	void ReleaseDeferred(uint64 completedFenceValue);
 };
 
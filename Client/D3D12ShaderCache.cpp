@@ -0,0 +1,513 @@
+#include "pch.h"
+#include "D3D12ShaderCache.h"
+#include "D3D12MaterialSystem.h"
+#include "../Common/FileMapping.h"
+#include "../Common/Hash.h"
+
+/*
+=====================
+D3D12ShaderCache
+=====================
+*/
+
+// Serves #include from the shader directory straight out of file mappings.
+class ShaderIncludeHandler : public ID3DInclude
+{
+public:
+	explicit ShaderIncludeHandler(const char* directory) : m_directory(directory) {}
+
+	~ShaderIncludeHandler()
+	{
+		for (uint32 i = 0; i < m_mappingsCount; i++)
+		{
+			FileSystem::UnmapFile(&m_mappings[i]);
+		}
+	}
+
+	HRESULT __stdcall Open(D3D_INCLUDE_TYPE includeType, LPCSTR fileName, LPCVOID parentData, LPCVOID* outData, UINT* outBytes) override
+	{
+		if (m_mappingsCount == s_MaxOpenIncludes)
+			return E_FAIL;
+
+		char path[MAX_PATH] = {};
+		::sprintf_s(path, "%s\\%s", m_directory, fileName);
+
+		FileMapping& mapping = m_mappings[m_mappingsCount];
+		if (!FileSystem::MapFile(path, &mapping))
+			return E_FAIL;
+
+		m_mappingsCount++;
+		*outData = mapping.data;
+		*outBytes = static_cast<UINT>(mapping.size);
+		return S_OK;
+	}
+
+	HRESULT __stdcall Close(LPCVOID data) override
+	{
+		for (uint32 i = 0; i < m_mappingsCount; i++)
+		{
+			if (m_mappings[i].data != data)
+				continue;
+
+			FileSystem::UnmapFile(&m_mappings[i]);
+			m_mappings[i] = m_mappings[--m_mappingsCount];
+			m_mappings[m_mappingsCount] = {};
+			break;
+		}
+		return S_OK;
+	}
+
+private:
+	static const uint32 s_MaxOpenIncludes = 16;
+
+	const char* m_directory = nullptr;
+	FileMapping m_mappings[s_MaxOpenIncludes] = {};
+	uint32 m_mappingsCount = 0;
+};
+
+static void ResolveDirectory(const char* directory, char* outPath)
+{
+	bool isAbsolute = directory[0] == '\\' || directory[0] == '/' || (directory[0] && directory[1] == ':');
+	if (isAbsolute)
+	{
+		::strcpy_s(outPath, MAX_PATH, directory);
+		return;
+	}
+
+	char modulePath[MAX_PATH] = {};
+	::GetModuleFileNameA(nullptr, modulePath, MAX_PATH);
+	char* separator = ::strrchr(modulePath, '\\');
+	if (separator)
+		separator[1] = '\0';
+
+	::sprintf_s(outPath, MAX_PATH, "%s%s", modulePath, directory);
+}
+
+static bool IsDirectory(const char* path)
+{
+	DWORD attributes = ::GetFileAttributesA(path);
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+static void PrintErrors(const char* filename, ID3DBlob* errors)
+{
+	if (!errors)
+		return;
+
+	::printf("%s: %.*s\n", filename, static_cast<int>(errors->GetBufferSize()), static_cast<const char*>(errors->GetBufferPointer()));
+	errors->Release();
+}
+
+static bool IsIdentifierChar(uint8 c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Matches name followed by '(' as a whole identifier; good enough for entry
+// points, which are declared once at file scope.
+static bool HasEntryPoint(const uint8* source, uint64 size, const char* name)
+{
+	uint64 length = ::strlen(name);
+	for (uint64 i = 0; i + length < size; i++)
+	{
+		if (source[i + length] != '(' || ::memcmp(source + i, name, static_cast<size_t>(length)) != 0)
+			continue;
+
+		if (i == 0 || !IsIdentifierChar(source[i - 1]))
+			return true;
+	}
+	return false;
+}
+
+static char* AppendString(char* cursor, const char* string)
+{
+	size_t size = ::strlen(string) + 1;
+	::memcpy(cursor, string, size);
+	return cursor + size;
+}
+
+// Packs a GetShader request into one allocation, laid out as Entry::request describes.
+static char* CopyRequest(const char* filename, const char* entryPoint, const char* target, const D3D_SHADER_MACRO* defines)
+{
+	size_t size = ::strlen(filename) + ::strlen(entryPoint) + ::strlen(target) + 4;
+	for (const D3D_SHADER_MACRO* define = defines; define && define->Name; define++)
+	{
+		size += ::strlen(define->Name) + (define->Definition ? ::strlen(define->Definition) : 0) + 2;
+	}
+
+	char* request = new char[size];
+	char* cursor = request;
+	cursor = AppendString(cursor, filename);
+	cursor = AppendString(cursor, entryPoint);
+	cursor = AppendString(cursor, target);
+	for (const D3D_SHADER_MACRO* define = defines; define && define->Name; define++)
+	{
+		cursor = AppendString(cursor, define->Name);
+		cursor = AppendString(cursor, define->Definition ? define->Definition : "");
+	}
+	*cursor = '\0';
+
+	return request;
+}
+
+void D3D12ShaderCache::Init(const char* shaderDirectory, const char* cacheDirectory)
+{
+	ResolveDirectory(shaderDirectory, m_shaderDirectory);
+	if (!IsDirectory(m_shaderDirectory))
+		::strcpy_s(m_shaderDirectory, ".");
+
+	ResolveDirectory(cacheDirectory, m_cacheDirectory);
+	::CreateDirectoryA(m_cacheDirectory, nullptr);
+
+#if defined(_DEBUG)
+	// Enable better shader debugging with the graphics debugging tools.
+	m_compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+	m_compileFlags = 0;
+#endif
+
+	::InitializeCriticalSection(&m_lock);
+
+	m_changeNotification = ::FindFirstChangeNotificationA(m_shaderDirectory, FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+	m_changeTime = 0;
+
+	m_stats = {};
+}
+
+void D3D12ShaderCache::Clean()
+{
+	if (m_changeNotification != INVALID_HANDLE_VALUE)
+	{
+		::FindCloseChangeNotification(m_changeNotification);
+		m_changeNotification = INVALID_HANDLE_VALUE;
+	}
+
+	for (uint32 i = 0; i < m_entriesCount; i++)
+	{
+		m_entries[i].blob->Release();
+		delete[] m_entries[i].request;
+	}
+
+	if (m_entries)
+	{
+		delete[] m_entries;
+		m_entries = nullptr;
+	}
+	m_entriesCount = 0;
+	m_entriesCapacity = 0;
+
+	::DeleteCriticalSection(&m_lock);
+}
+
+ID3DBlob* D3D12ShaderCache::GetShader(const char* filename, const char* entryPoint, const char* target, const D3D_SHADER_MACRO* defines)
+{
+	::EnterCriticalSection(&m_lock);
+
+	LARGE_INTEGER frequency = {};
+	LARGE_INTEGER startTime = {};
+	::QueryPerformanceFrequency(&frequency);
+	::QueryPerformanceCounter(&startTime);
+
+	ID3DBlob* blob = nullptr;
+
+	ID3DBlob* source = Preprocess(filename, defines);
+	if (source)
+	{
+		uint64 key = HashBytes(source->GetBufferPointer(), source->GetBufferSize());
+		key = HashString(entryPoint, key);
+		key = HashString(target, key);
+		key = HashValue(m_compileFlags, key);
+		key = HashValue(D3D_COMPILER_VERSION, key);
+		key = HashValue(SHADER_CACHE_VERSION, key);
+
+		for (uint32 i = 0; i < m_entriesCount; i++)
+		{
+			if (m_entries[i].key == key)
+			{
+				blob = m_entries[i].blob;
+				blob->AddRef();
+				m_stats.memoryHitsCount++;
+				break;
+			}
+		}
+
+		if (!blob)
+		{
+			blob = LoadFromDisk(key);
+			if (blob)
+			{
+				m_stats.diskHitsCount++;
+				AddEntry(key, blob, filename, entryPoint, target, defines);
+			}
+		}
+
+		if (!blob)
+		{
+			// Defines are already applied, and #line directives keep errors pointing at the original files.
+			ID3DBlob* errors = nullptr;
+			HRESULT hr = D3DCompile(source->GetBufferPointer(), source->GetBufferSize(), filename, nullptr, nullptr, entryPoint, target, m_compileFlags, 0, &blob, &errors);
+			PrintErrors(filename, errors);
+
+			if (SUCCEEDED(hr))
+			{
+				m_stats.compilesCount++;
+				SaveToDisk(key, blob);
+				AddEntry(key, blob, filename, entryPoint, target, defines);
+			}
+			else if (blob)
+			{
+				blob->Release();
+				blob = nullptr;
+			}
+		}
+
+		source->Release();
+	}
+
+	LARGE_INTEGER endTime = {};
+	::QueryPerformanceCounter(&endTime);
+	m_stats.milliseconds += static_cast<float>(endTime.QuadPart - startTime.QuadPart) * 1000.0f / static_cast<float>(frequency.QuadPart);
+
+	::LeaveCriticalSection(&m_lock);
+
+	return blob;
+}
+
+bool D3D12ShaderCache::ReloadShader(const D3D12_SHADER_BYTECODE& bytecode, ID3DBlob** outBlob)
+{
+	*outBlob = nullptr;
+	if (!bytecode.BytecodeLength)
+		return true;
+
+	uint64 bytecodeKey = HashBytes(bytecode.pShaderBytecode, bytecode.BytecodeLength);
+
+	// Requests are never freed before Clean, so the pointer outlives the lock.
+	const char* request = nullptr;
+	::EnterCriticalSection(&m_lock);
+	for (uint32 i = 0; i < m_entriesCount; i++)
+	{
+		if (m_entries[i].bytecodeKey == bytecodeKey)
+		{
+			request = m_entries[i].request;
+			break;
+		}
+	}
+	::LeaveCriticalSection(&m_lock);
+
+	if (!request)
+		return true;
+
+	const char* filename = request;
+	const char* entryPoint = filename + ::strlen(filename) + 1;
+	const char* target = entryPoint + ::strlen(entryPoint) + 1;
+	const char* cursor = target + ::strlen(target) + 1;
+
+	D3D_SHADER_MACRO defines[SHADER_MAX_DEFINES + 1] = {};
+	for (uint32 i = 0; *cursor && i < SHADER_MAX_DEFINES; i++)
+	{
+		defines[i].Name = cursor;
+		cursor += ::strlen(cursor) + 1;
+		defines[i].Definition = cursor;
+		cursor += ::strlen(cursor) + 1;
+	}
+
+	*outBlob = GetShader(filename, entryPoint, target, defines);
+	return *outBlob != nullptr;
+}
+
+bool D3D12ShaderCache::PollChanges()
+{
+	if (m_changeNotification == INVALID_HANDLE_VALUE)
+		return false;
+
+	// Every notification restarts the quiet period.
+	ULONGLONG time = ::GetTickCount64();
+	if (::WaitForSingleObject(m_changeNotification, 0) == WAIT_OBJECT_0)
+	{
+		::FindNextChangeNotification(m_changeNotification);
+		m_changeTime = time;
+		return false;
+	}
+
+	if (!m_changeTime || time - m_changeTime < SHADER_RELOAD_DELAY_MILLISECONDS)
+		return false;
+
+	m_changeTime = 0;
+	return true;
+}
+
+bool D3D12ShaderCache::CompileAll()
+{
+	struct EntryPoint
+	{
+		const char* name;
+		const char* target;
+	};
+	// The targets the renderer asks for, or the keys would never match.
+	static const EntryPoint ENTRY_POINTS[] =
+	{
+		{ "VSMain", MATERIAL_VERTEX_SHADER_TARGET },
+		{ "PSMain", MATERIAL_PIXEL_SHADER_TARGET },
+		{ "CSMain", "cs_5_0" },
+	};
+
+	char pattern[MAX_PATH] = {};
+	::sprintf_s(pattern, "%s\\*.hlsl", m_shaderDirectory);
+
+	WIN32_FIND_DATAA findData = {};
+	HANDLE find = ::FindFirstFileA(pattern, &findData);
+	if (find == INVALID_HANDLE_VALUE)
+	{
+		::printf("%s: no shaders found\n", m_shaderDirectory);
+		return false;
+	}
+
+	bool result = true;
+	do
+	{
+		char path[MAX_PATH] = {};
+		::sprintf_s(path, "%s\\%s", m_shaderDirectory, findData.cFileName);
+
+		FileMapping mapping = {};
+		if (!FileSystem::MapFile(path, &mapping))
+		{
+			::printf("%s: cannot open\n", path);
+			result = false;
+			continue;
+		}
+
+		// Material shaders are compiled once per feature permutation, with the
+		// defines the material system asks for at runtime.
+		bool isMaterialShader = ::_stricmp(findData.cFileName, MATERIAL_SHADER_FILENAME) == 0;
+		uint32 permutationsCount = isMaterialShader ? MATERIAL_PERMUTATIONS_COUNT : 1;
+
+		for (const EntryPoint& entryPoint : ENTRY_POINTS)
+		{
+			if (!HasEntryPoint(mapping.data, mapping.size, entryPoint.name))
+				continue;
+
+			for (uint32 features = 0; features < permutationsCount; features++)
+			{
+				D3D_SHADER_MACRO defines[MATERIAL_FEATURES_COUNT + 1] = {};
+				if (isMaterialShader)
+					D3D12MaterialSystem::GetShaderDefines(features, defines);
+
+				ID3DBlob* blob = GetShader(findData.cFileName, entryPoint.name, entryPoint.target, defines);
+				if (blob)
+				{
+					blob->Release();
+				}
+				else
+				{
+					result = false;
+				}
+			}
+		}
+
+		FileSystem::UnmapFile(&mapping);
+	} while (::FindNextFileA(find, &findData));
+
+	::FindClose(find);
+
+	::printf("Shader cache: %u compiled, %u up to date, %.1f ms\n", m_stats.compilesCount, m_stats.diskHitsCount + m_stats.memoryHitsCount, m_stats.milliseconds);
+	return result;
+}
+
+ID3DBlob* D3D12ShaderCache::Preprocess(const char* filename, const D3D_SHADER_MACRO* defines)
+{
+	char path[MAX_PATH] = {};
+	::sprintf_s(path, "%s\\%s", m_shaderDirectory, filename);
+
+	FileMapping mapping = {};
+	if (!FileSystem::MapFile(path, &mapping))
+	{
+		::printf("%s: cannot open\n", path);
+		return nullptr;
+	}
+
+	// The file name alone goes into #line directives, so the output, and the
+	// key, do not depend on where the sources live.
+	ShaderIncludeHandler include(m_shaderDirectory);
+	ID3DBlob* source = nullptr;
+	ID3DBlob* errors = nullptr;
+	HRESULT hr = D3DPreprocess(mapping.data, static_cast<SIZE_T>(mapping.size), filename, defines, &include, &source, &errors);
+	PrintErrors(filename, errors);
+
+	FileSystem::UnmapFile(&mapping);
+
+	if (FAILED(hr) && source)
+	{
+		source->Release();
+		source = nullptr;
+	}
+
+	return source;
+}
+
+ID3DBlob* D3D12ShaderCache::LoadFromDisk(uint64 key)
+{
+	char path[MAX_PATH] = {};
+	GetCachePath(key, "cso", path);
+
+	FileMapping mapping = {};
+	if (!FileSystem::MapFile(path, &mapping))
+		return nullptr;
+
+	ID3DBlob* blob = nullptr;
+	if (SUCCEEDED(D3DCreateBlob(static_cast<SIZE_T>(mapping.size), &blob)))
+		::memcpy(blob->GetBufferPointer(), mapping.data, static_cast<size_t>(mapping.size));
+
+	FileSystem::UnmapFile(&mapping);
+
+	return blob;
+}
+
+void D3D12ShaderCache::SaveToDisk(uint64 key, ID3DBlob* blob)
+{
+	char tempPath[MAX_PATH] = {};
+	char path[MAX_PATH] = {};
+	GetCachePath(key, "tmp", tempPath);
+	GetCachePath(key, "cso", path);
+
+	// Written aside and renamed, so an interrupted run never leaves a truncated
+	// entry behind. Failures only cost a compile on the next run.
+	FILE* file = nullptr;
+	if (::fopen_s(&file, tempPath, "wb") != 0 || !file)
+		return;
+
+	size_t written = ::fwrite(blob->GetBufferPointer(), 1, blob->GetBufferSize(), file);
+	::fclose(file);
+
+	if (written != blob->GetBufferSize() || !::MoveFileExA(tempPath, path, MOVEFILE_REPLACE_EXISTING))
+		::DeleteFileA(tempPath);
+}
+
+void D3D12ShaderCache::AddEntry(uint64 key, ID3DBlob* blob, const char* filename, const char* entryPoint, const char* target, const D3D_SHADER_MACRO* defines)
+{
+	if (m_entriesCount == m_entriesCapacity)
+	{
+		uint32 capacity = m_entriesCapacity ? m_entriesCapacity * 2 : 16;
+		Entry* entries = new Entry[capacity];
+		for (uint32 i = 0; i < m_entriesCount; i++)
+		{
+			entries[i] = m_entries[i];
+		}
+
+		delete[] m_entries;
+		m_entries = entries;
+		m_entriesCapacity = capacity;
+	}
+
+	blob->AddRef();
+
+	Entry& entry = m_entries[m_entriesCount++];
+	entry.key = key;
+	entry.bytecodeKey = HashBytes(blob->GetBufferPointer(), blob->GetBufferSize());
+	entry.blob = blob;
+	entry.request = CopyRequest(filename, entryPoint, target, defines);
+}
+
+void D3D12ShaderCache::GetCachePath(uint64 key, const char* extension, char* outPath)
+{
+	::sprintf_s(outPath, MAX_PATH, "%s\\%016llx.%s", m_cacheDirectory, static_cast<unsigned long long>(key), extension);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+// Relative to the executable. When the executable has no shader directory next
+// to it, sources are read from the working directory instead.
+const char SHADER_DIRECTORY[] = "Shaders";
+const char SHADER_CACHE_DIRECTORY[] = "ShaderCache";
+
+// Bumped when the key layout or the cached file contents change.
+const uint32 SHADER_CACHE_VERSION = 1;
+
+// Reloads wait for the shader directory to be quiet this long, so an editor's
+// save is picked up once and not half written.
+const uint32 SHADER_RELOAD_DELAY_MILLISECONDS = 200;
+const uint32 SHADER_MAX_DEFINES = 32;
+
+struct ShaderCacheStats
+{
+	uint32 memoryHitsCount = 0;
+	uint32 diskHitsCount = 0;
+	uint32 compilesCount = 0;
+	float milliseconds = 0.0f;		// Everything spent in GetShader, hits included.
+};
+
+/*
+=====================
+D3D12ShaderCache
+=====================
+*/
+
+// Compiled bytecode keyed by a hash of the preprocessed source, which covers
+// includes and defines, together with the entry point, target, compile flags
+// and compiler version. Lookups go through memory, then one .cso file per key
+// in the cache directory, and only compile on a miss. "Client -compileshaders"
+// fills the cache at build time so the first run starts warm.
+//
+// The shader directory is watched for edits. Each entry remembers the request
+// that produced it, so bytecode held by a pipeline can be compiled again from
+// the current sources. GetShader and ReloadShader may be called from any thread.
+class D3D12ShaderCache
+{
+public:
+	void Init(const char* shaderDirectory, const char* cacheDirectory);
+	void Clean();
+
+	// Returns nullptr and prints the compiler output when compilation fails.
+	// The caller releases the blob.
+	ID3DBlob* GetShader(const char* filename, const char* entryPoint, const char* target, const D3D_SHADER_MACRO* defines = nullptr);
+	// Compiles the sources the bytecode was built from again. Returns false when
+	// that fails. outBlob is left nullptr when the bytecode did not come from here.
+	bool ReloadShader(const D3D12_SHADER_BYTECODE& bytecode, ID3DBlob** outBlob);
+
+	// True once per batch of edits to the shader directory.
+	bool PollChanges();
+
+	// Compiles every VSMain, PSMain and CSMain found in the shader directory's
+	// .hlsl files, the material shader once per feature permutation. Returns
+	// false if any of them failed.
+	bool CompileAll();
+
+	inline const ShaderCacheStats& GetStats() const { return m_stats; }
+	inline const char* GetCacheDirectory() const { return m_cacheDirectory; }
+
+private:
+	struct Entry
+	{
+		uint64 key = 0;
+		uint64 bytecodeKey = 0;
+		ID3DBlob* blob = nullptr;
+		// Filename, entry point, target, then define names and values, each
+		// null-terminated and closed by an empty string.
+		char* request = nullptr;
+	};
+
+	char m_shaderDirectory[MAX_PATH] = {};
+	char m_cacheDirectory[MAX_PATH] = {};
+	UINT m_compileFlags = 0;
+
+	Entry* m_entries = nullptr;
+	uint32 m_entriesCount = 0;
+	uint32 m_entriesCapacity = 0;
+
+	CRITICAL_SECTION m_lock = {};
+
+	HANDLE m_changeNotification = INVALID_HANDLE_VALUE;
+	ULONGLONG m_changeTime = 0;			// Last change not reloaded yet, 0 when there is none.
+
+	ShaderCacheStats m_stats;
+
+	ID3DBlob* Preprocess(const char* filename, const D3D_SHADER_MACRO* defines);
+	ID3DBlob* LoadFromDisk(uint64 key);
+	void SaveToDisk(uint64 key, ID3DBlob* blob);
+	void AddEntry(uint64 key, ID3DBlob* blob, const char* filename, const char* entryPoint, const char* target, const D3D_SHADER_MACRO* defines);
+
+	void GetCachePath(uint64 key, const char* extension, char* outPath);
+};
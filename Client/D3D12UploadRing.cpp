@@ -0,0 +1,201 @@
+#include "pch.h"
+#include "D3D12UploadRing.h"
+#include "D3D12Utils.h"
+
+/*
+=====================
+D3D12UploadRing
+=====================
+*/
+
+void D3D12UploadRing::Init(ID3D12Device* device, ID3D12CommandQueue* commandQueue, uint64 size)
+{
+	m_device = device;
+	m_commandQueue = commandQueue;
+	m_size = size;
+
+	CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
+	auto desc = CD3DX12_RESOURCE_DESC::Buffer(size);
+	ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_buffer)));
+
+	// Upload heaps may stay mapped for the lifetime of the resource.
+	CD3DX12_RANGE readRange(0, 0);
+	ThrowIfFailed(m_buffer->Map(0, &readRange, reinterpret_cast<void**>(&m_mappedData)));
+
+	for (uint32 i = 0; i < s_MaxSubmissions; i++)
+	{
+		ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_submissions[i].commandAllocator)));
+	}
+
+	ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_submissions[0].commandAllocator, nullptr, IID_PPV_ARGS(&m_commandList)));
+	ThrowIfFailed(m_commandList->Close());
+
+	ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
+	m_fenceValue = 1;
+
+	m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (m_fenceEvent == nullptr)
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+}
+
+void D3D12UploadRing::Clean()
+{
+	if (m_fence)
+	{
+		Submit();
+		WaitForIdle();
+	}
+
+	if (m_fenceEvent)
+	{
+		::CloseHandle(m_fenceEvent);
+		m_fenceEvent = nullptr;
+	}
+
+	if (m_fence)
+	{
+		m_fence->Release();
+		m_fence = nullptr;
+	}
+
+	if (m_commandList)
+	{
+		m_commandList->Release();
+		m_commandList = nullptr;
+	}
+
+	for (uint32 i = 0; i < s_MaxSubmissions; i++)
+	{
+		if (m_submissions[i].commandAllocator)
+		{
+			m_submissions[i].commandAllocator->Release();
+			m_submissions[i].commandAllocator = nullptr;
+		}
+	}
+
+	if (m_buffer)
+	{
+		m_buffer->Unmap(0, nullptr);
+		m_buffer->Release();
+		m_buffer = nullptr;
+	}
+
+	m_mappedData = nullptr;
+}
+
+bool D3D12UploadRing::Allocate(uint64 size, uint64 alignment, UploadAllocation* outAllocation)
+{
+	if (size > m_size)
+		return false;
+
+	while (true)
+	{
+		BeginRecording();
+
+		if (m_usedSize == 0)
+			m_head = 0;
+
+		uint64 offset = (m_head + alignment - 1) & ~(alignment - 1);
+		uint64 wasted = offset - m_head;
+
+		// Skip the tail end of the buffer when the block does not fit there.
+		if (offset + size > m_size)
+		{
+			wasted = m_size - m_head;
+			offset = 0;
+		}
+
+		if (m_usedSize + wasted + size <= m_size)
+		{
+			m_head = offset + size;
+			m_usedSize += wasted + size;
+			m_pendingSize += wasted + size;
+			m_allocatedBytes += size;
+
+			outAllocation->resource = m_buffer;
+			outAllocation->offset = offset;
+			outAllocation->cpuAddress = m_mappedData + offset;
+			return true;
+		}
+
+		// Out of space: push pending copies and wait for the oldest batch.
+		Submit();
+
+		if (m_submissionCount == 0)
+			return false;
+
+		RetireOldest();
+	}
+}
+
+ID3D12GraphicsCommandList* D3D12UploadRing::GetCommandList()
+{
+	BeginRecording();
+	return m_commandList;
+}
+
+void D3D12UploadRing::Submit()
+{
+	if (!m_recording)
+		return;
+
+	ThrowIfFailed(m_commandList->Close());
+
+	ID3D12CommandList* ppCommandLists[] = { m_commandList };
+	m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+	uint32 slot = (m_submissionStart + m_submissionCount) % s_MaxSubmissions;
+	m_submissions[slot].fenceValue = m_fenceValue;
+	m_submissions[slot].size = m_pendingSize;
+	m_submissionCount++;
+	m_pendingSize = 0;
+
+	ThrowIfFailed(m_commandQueue->Signal(m_fence, m_fenceValue));
+	m_fenceValue++;
+
+	m_recording = false;
+}
+
+void D3D12UploadRing::WaitForIdle()
+{
+	while (m_submissionCount)
+	{
+		RetireOldest();
+	}
+}
+
+void D3D12UploadRing::BeginRecording()
+{
+	if (m_recording)
+		return;
+
+	// Every submission owns an allocator; make sure the next one is free.
+	if (m_submissionCount == s_MaxSubmissions)
+		RetireOldest();
+
+	ID3D12CommandAllocator* commandAllocator = m_submissions[(m_submissionStart + m_submissionCount) % s_MaxSubmissions].commandAllocator;
+	ThrowIfFailed(commandAllocator->Reset());
+	ThrowIfFailed(m_commandList->Reset(commandAllocator, nullptr));
+
+	m_recording = true;
+}
+
+void D3D12UploadRing::RetireOldest()
+{
+	Submission& submission = m_submissions[m_submissionStart];
+
+	if (m_fence->GetCompletedValue() < submission.fenceValue)
+	{
+		m_fence->SetEventOnCompletion(submission.fenceValue, m_fenceEvent);
+		::WaitForSingleObject(m_fenceEvent, INFINITE);
+	}
+
+	// Submissions retire in allocation order, so the oldest bytes are freed first.
+	m_usedSize -= submission.size;
+	submission.size = 0;
+
+	m_submissionStart = (m_submissionStart + 1) % s_MaxSubmissions;
+	m_submissionCount--;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+/*
+=====================
+D3D12UploadRing
+=====================
+*/
+
+struct UploadAllocation
+{
+	ID3D12Resource* resource = nullptr;
+	uint64 offset = 0;
+	BYTE* cpuAddress = nullptr;
+};
+
+// Persistently mapped upload heap used as a ring buffer. Copies are recorded
+// on the ring's own command list and submitted to the renderer's queue ahead of
+// the frame, so callers never wait for the GPU unless the ring is full.
+class D3D12UploadRing
+{
+public:
+	void Init(ID3D12Device* device, ID3D12CommandQueue* commandQueue, uint64 size);
+	void Clean();
+
+	bool Allocate(uint64 size, uint64 alignment, UploadAllocation* outAllocation);
+	ID3D12GraphicsCommandList* GetCommandList();
+
+	void Submit();
+	void WaitForIdle();
+
+	inline uint64 GetSize() { return m_size; }
+	// Largest block a streamed upload asks for at a time. Half the ring, so the
+	// next chunk can be filled while the copy of the previous one is in flight.
+	inline uint64 GetMaxChunkSize() { return m_size / 2; }
+	// Bytes handed out since Init, padding excluded.
+	inline uint64 GetAllocatedBytes() { return m_allocatedBytes; }
+
+private:
+	static const uint32 s_MaxSubmissions = 8;
+
+	struct Submission
+	{
+		uint64 fenceValue = 0;
+		uint64 size = 0;
+		ID3D12CommandAllocator* commandAllocator = nullptr;
+	};
+
+	ID3D12Device* m_device = nullptr;
+	ID3D12CommandQueue* m_commandQueue = nullptr;
+	ID3D12GraphicsCommandList* m_commandList = nullptr;
+	ID3D12Resource* m_buffer = nullptr;
+	BYTE* m_mappedData = nullptr;
+	uint64 m_size = 0;
+
+	// Bytes in flight, including alignment padding and skipped tail space.
+	uint64 m_head = 0;
+	uint64 m_usedSize = 0;
+	uint64 m_pendingSize = 0;
+	uint64 m_allocatedBytes = 0;
+
+	Submission m_submissions[s_MaxSubmissions] = {};
+	uint32 m_submissionStart = 0;
+	uint32 m_submissionCount = 0;
+	bool m_recording = false;
+
+	ID3D12Fence* m_fence = nullptr;
+	HANDLE m_fenceEvent = nullptr;
+	uint64 m_fenceValue = 0;
+
+	void BeginRecording();
+	void RetireOldest();
+};
@@ -1,8 +1,10 @@
 #include "pch.h"
 #include "D3D12Utils.h"
-#include "D3D12CommandList.h"
-#include <directxtk12/DDSTextureLoader.h>
-#include <directxtk12/ResourceUploadBatch.h>
+#include "D3D12MipGenerator.h"
+#include "D3D12UploadRing.h"
+#include "../Common/BCEncoder.h"
+#include "../Common/ImageFile.h"
+#include "../Common/MipGenerator.h"
 
 /*
 ================
@@ -21,39 +23,101 @@ void ThrowIfFailed(HRESULT hr)
 
 namespace D3D12Utils
 {
-	VertexBuffer* CreateVertexBuffer(ID3D12Device* device, void* vertices, uint32 count, uint32 size, uint32 stride)
+	// Copies data into a default heap buffer through the upload ring. The copy
+	// is submitted with the ring, ahead of the next frame's command list. Data
+	// larger than a ring chunk is streamed in pieces; Allocate submits the
+	// copies recorded so far and waits for ring space between them.
+	static ID3D12Resource* CreateDefaultBuffer(ID3D12Device* device, D3D12UploadRing* uploadRing, const void* data, uint32 size, D3D12_RESOURCE_STATES finalState)
 	{
-		VertexBuffer* vertexBuffer = new VertexBuffer;
+		ID3D12Resource* resource = nullptr;
 
 		CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
 		auto desc = CD3DX12_RESOURCE_DESC::Buffer(size);
-		ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&vertexBuffer->resource)));
+		ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&resource)));
+
+		uploadRing->GetCommandList()->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST));
+
+		const uint8* src = static_cast<const uint8*>(data);
+		uint64 maxChunkSize = uploadRing->GetMaxChunkSize();
+		for (uint64 offset = 0; offset < size; )
+		{
+			uint64 chunkSize = size - offset < maxChunkSize ? size - offset : maxChunkSize;
 
-		heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-		desc = CD3DX12_RESOURCE_DESC::Buffer(size);
-		ThrowIfFailed(device->CreateCommittedResource(&heapProps,D3D12_HEAP_FLAG_NONE,&desc,D3D12_RESOURCE_STATE_GENERIC_READ,nullptr,IID_PPV_ARGS(&vertexBuffer->upload)));
+			UploadAllocation allocation = {};
+			if (!uploadRing->Allocate(chunkSize, 4, &allocation))
+			{
+				ThrowIfFailed(E_OUTOFMEMORY);
+				break;
+			}
 
-		// Describe the data we want to copy into the default buffer.
-		D3D12_SUBRESOURCE_DATA subResourceData = {};
-		subResourceData.pData = vertices;
-		subResourceData.RowPitch = size;
-		subResourceData.SlicePitch = subResourceData.RowPitch;
+			::memcpy(allocation.cpuAddress, src + offset, static_cast<size_t>(chunkSize));
 
-		// TODO
-		D3D12CommandList* ctx = new D3D12CommandList;
-		ctx->Init(device);
-		ctx->Reset();
+			// Fetched per chunk: Allocate may have submitted the previous list to make room.
+			uploadRing->GetCommandList()->CopyBufferRegion(resource, offset, allocation.resource, allocation.offset, chunkSize);
+			offset += chunkSize;
+		}
 
-		ctx->m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(vertexBuffer->resource, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST));
-		UpdateSubresources<1>(ctx->m_commandList, vertexBuffer->resource, vertexBuffer->upload, 0, 0, 1, &subResourceData);
-		ctx->m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(vertexBuffer->resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
+		// Buffers decay to COMMON between submissions and are promoted back to
+		// COPY_DEST by the copy, so the final transition is valid on any list.
+		uploadRing->GetCommandList()->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource, D3D12_RESOURCE_STATE_COPY_DEST, finalState));
+
+		return resource;
+	}
 
-		ctx->ExcuteCommandLists();
-		ctx->WaitForGpu();
-		ctx->Clean();
+	// Copies rows srcRowPitch bytes apart into one subresource, which must be in
+	// COPY_DEST. A subresource larger than a ring chunk is copied in bands of
+	// whole rows, one CopyTextureRegion box per band. Rows are block rows for
+	// block-compressed formats.
+	static void UploadSubresource(ID3D12Device* device, D3D12UploadRing* uploadRing, ID3D12Resource* texture, uint32 subresource, const uint8* src, uint64 srcRowPitch)
+	{
+		D3D12_RESOURCE_DESC desc = texture->GetDesc();
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+		uint32 rowsCount = 0;
+		uint64 rowSize = 0;
+		uint64 totalSize = 0;
+		device->GetCopyableFootprints(&desc, subresource, 1, 0, &footprint, &rowsCount, &rowSize, &totalSize);
+
+		// Texels per row: 4 for block-compressed formats, whose footprint height is block aligned.
+		uint32 rowHeight = footprint.Footprint.Height / rowsCount;
+		uint32 rowPitch = footprint.Footprint.RowPitch;
+		uint32 bandRowsCount = static_cast<uint32>(uploadRing->GetMaxChunkSize() / rowPitch);
+
+		for (uint32 firstRow = 0; firstRow < rowsCount; firstRow += bandRowsCount)
+		{
+			uint32 bandRows = rowsCount - firstRow < bandRowsCount ? rowsCount - firstRow : bandRowsCount;
+
+			UploadAllocation allocation = {};
+			if (!uploadRing->Allocate(static_cast<uint64>(bandRows) * rowPitch, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, &allocation))
+			{
+				ThrowIfFailed(E_OUTOFMEMORY);
+				return;
+			}
+
+			// Rows are tightly packed in the source but 256-byte aligned in the footprint.
+			for (uint32 row = 0; row < bandRows; row++)
+			{
+				::memcpy(allocation.cpuAddress + row * rowPitch, src + (firstRow + row) * srcRowPitch, static_cast<size_t>(rowSize));
+			}
+
+			D3D12_PLACED_SUBRESOURCE_FOOTPRINT bandFootprint = footprint;
+			bandFootprint.Offset = allocation.offset;
+			bandFootprint.Footprint.Height = bandRows * rowHeight;
+
+			D3D12_BOX box = { 0, 0, 0, bandFootprint.Footprint.Width, bandFootprint.Footprint.Height, 1 };
+
+			// Fetched per band: Allocate may have submitted the previous list to make room.
+			ID3D12GraphicsCommandList* commandList = uploadRing->GetCommandList();
+			CD3DX12_TEXTURE_COPY_LOCATION dst(texture, subresource);
+			CD3DX12_TEXTURE_COPY_LOCATION copySrc(allocation.resource, bandFootprint);
+			commandList->CopyTextureRegion(&dst, 0, firstRow * rowHeight, 0, &copySrc, &box);
+		}
+	}
 
-		delete ctx;
-		ctx = nullptr;
+	VertexBuffer* CreateVertexBuffer(ID3D12Device* device, D3D12UploadRing* uploadRing, const void* vertices, uint32 count, uint32 size, uint32 stride)
+	{
+		VertexBuffer* vertexBuffer = new VertexBuffer;
+		vertexBuffer->resource = CreateDefaultBuffer(device, uploadRing, vertices, size, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+		vertexBuffer->count = count;
 
 		// Initialize the vertex buffer view.
 		vertexBuffer->vertexBufferView.BufferLocation = vertexBuffer->resource->GetGPUVirtualAddress();
@@ -63,82 +127,269 @@ namespace D3D12Utils
 		return vertexBuffer;
 	}
 
-	IndexBuffer* CreateIndexBuffer(ID3D12Device* device, void* indices, uint32 count, uint32 size, DXGI_FORMAT format)
+	IndexBuffer* CreateIndexBuffer(ID3D12Device* device, D3D12UploadRing* uploadRing, const void* indices, uint32 count, uint32 size, DXGI_FORMAT format)
 	{
 		IndexBuffer* indexBuffer = new IndexBuffer;
+		indexBuffer->resource = CreateDefaultBuffer(device, uploadRing, indices, size, D3D12_RESOURCE_STATE_INDEX_BUFFER);
+		indexBuffer->count = count;
 
-		CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
-		auto desc = CD3DX12_RESOURCE_DESC::Buffer(size);
-		ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&indexBuffer->resource)));
+		// Initialize the index buffer view.
+		indexBuffer->indexBufferView.BufferLocation = indexBuffer->resource->GetGPUVirtualAddress();
+		indexBuffer->indexBufferView.Format = format;
+		indexBuffer->indexBufferView.SizeInBytes = size;
 
-		heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-		desc = CD3DX12_RESOURCE_DESC::Buffer(size);
-		ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&indexBuffer->upload)));
+		return indexBuffer;
+	}
 
-		// Describe the data we want to copy into the default buffer.
-		D3D12_SUBRESOURCE_DATA subResourceData = {};
-		subResourceData.pData = indices;
-		subResourceData.RowPitch = size;
-		subResourceData.SlicePitch = subResourceData.RowPitch;
+	void UploadTextureMips(ID3D12Device* device, D3D12UploadRing* uploadRing, ID3D12Resource* texture, const DDSFileView& view, uint32 firstMip, uint32 mipsCount, uint32 mostDetailedMip)
+	{
+		const DDSTextureInfo& info = view.info;
+		D3D12_RESOURCE_DESC desc = texture->GetDesc();
+
+		for (uint32 slice = 0; slice < info.arraySize; slice++)
+		{
+			for (uint32 mip = firstMip; mip < firstMip + mipsCount; mip++)
+			{
+				uint32 subresource = D3D12CalcSubresource(mip - mostDetailedMip, slice, 0, desc.MipLevels, desc.DepthOrArraySize);
+				UploadSubresource(device, uploadRing, texture, subresource, DDSFile::GetMipData(view, mip, slice), info.mips[mip].rowPitch);
+
+				ID3D12GraphicsCommandList* commandList = uploadRing->GetCommandList();
+				commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(texture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, subresource));
+			}
+		}
+	}
 
-		// TODO
-		D3D12CommandList* ctx = new D3D12CommandList;
-		ctx->Init(device);
-		ctx->Reset();
+	static TextureHandle* CreateTextureFromView(ID3D12Device* device, D3D12UploadRing* uploadRing, const DDSFileView& view, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
+	{
+		TextureHandle* textureHandle = new TextureHandle;
+		textureHandle->resource = CreateTextureResource(device, view.info, 0);
+		UploadTextureMips(device, uploadRing, textureHandle->resource, view, 0, view.info.mipLevels, 0);
 
-		ctx->m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(indexBuffer->resource, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST));
-		UpdateSubresources<1>(ctx->m_commandList, indexBuffer->resource, indexBuffer->upload, 0, 0, 1, &subResourceData);
-		ctx->m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(indexBuffer->resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
+		CreateTextureSRV(device, textureHandle->resource, view.info, srvHandle);
+		textureHandle->srvHandle = srvHandle;
 
-		ctx->ExcuteCommandLists();
-		ctx->WaitForGpu();
-		ctx->Clean();
+		return textureHandle;
+	}
 
-		delete ctx;
-		ctx = nullptr;
+	// PNG and TGA sources get a box-filtered mip chain and are block-compressed
+	// at load time: a quick BC1, or BC3 when the image has alpha. Sizes that are
+	// not a multiple of 4 cannot be block-compressed and stay RGBA8. Cooked DDS
+	// files load faster and look better.
+	static TextureHandle* CreateTexture2DFromImage(ID3D12Device* device, D3D12UploadRing* uploadRing, const char* filename, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
+	{
+		ImageData image = {};
+		if (!ImageFile::Load(filename, &image))
+		{
+			ThrowIfFailed(E_FAIL);
+			return nullptr;
+		}
+
+		bool compress = image.width % 4 == 0 && image.height % 4 == 0;
+		DDS_FORMAT format = compress ? (image.hasAlpha ? DDS_FORMAT_BC3_UNORM : DDS_FORMAT_BC1_UNORM) : DDS_FORMAT_R8G8B8A8_UNORM;
+		uint32 mipLevels = MipGenerator::GetMipLevelsCount(image.width, image.height);
+
+		DDSTextureInfo pixelsInfo = {};
+		DDSFileView view;
+		if (!DDSFile::InitInfo(DDS_FORMAT_R8G8B8A8_UNORM, image.width, image.height, mipLevels, &pixelsInfo) ||
+			!DDSFile::InitInfo(format, image.width, image.height, mipLevels, &view.info))
+		{
+			ImageFile::Destroy(&image);
+			ThrowIfFailed(E_FAIL);
+			return nullptr;
+		}
+
+		// Image files hold sRGB-encoded color, so the mips are filtered in linear light.
+		uint8* pixels = new uint8[pixelsInfo.sliceSize];
+		::memcpy(pixels, image.pixels, static_cast<size_t>(pixelsInfo.mips[0].size));
+		ImageFile::Destroy(&image);
+		MipGenerator::Generate(pixelsInfo, MIP_FILTER_BOX, true, 0, pixels);
+
+		uint8* blocks = pixels;
+		if (compress)
+		{
+			blocks = new uint8[view.info.sliceSize];
+			for (uint32 mip = 0; mip < mipLevels; mip++)
+			{
+				const DDSMipLayout& layout = pixelsInfo.mips[mip];
+				BCEncoder::Compress(pixels + layout.offset, layout.width, layout.height, format, BC_QUALITY_FAST, 0, blocks + view.info.mips[mip].offset);
+			}
+			delete[] pixels;
+		}
+
+		// The view only borrows the data, so it is never closed.
+		view.mapping.data = blocks;
+		view.mapping.size = view.info.sliceSize;
+
+		TextureHandle* textureHandle = CreateTextureFromView(device, uploadRing, view, srvHandle);
+
+		delete[] blocks;
 
-		// Initialize the vertex buffer view.
-		indexBuffer->indexBufferView.BufferLocation = indexBuffer->resource->GetGPUVirtualAddress();
-		indexBuffer->indexBufferView.Format = format;
-		indexBuffer->indexBufferView.SizeInBytes = size;
+		return textureHandle;
+	}
 
-		return indexBuffer;
+	// A DDS saved without mips would alias under minification, so the chain is
+	// built at load time when the format allows it.
+	static TextureHandle* CreateTexture2DWithMips(ID3D12Device* device, D3D12UploadRing* uploadRing, const DDSFileView& source, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
+	{
+		const DDSTextureInfo& sourceInfo = source.info;
+
+		DDSFileView view;
+		DDSFile::InitInfo(sourceInfo.format, sourceInfo.width, sourceInfo.height, MipGenerator::GetMipLevelsCount(sourceInfo.width, sourceInfo.height), &view.info);
+		view.info.arraySize = sourceInfo.arraySize;
+		view.info.isCubemap = sourceInfo.isCubemap;
+
+		uint8* data = new uint8[view.info.sliceSize * view.info.arraySize];
+		for (uint32 slice = 0; slice < sourceInfo.arraySize; slice++)
+		{
+			::memcpy(data + view.info.sliceSize * slice, DDSFile::GetMipData(source, 0, slice), static_cast<size_t>(sourceInfo.mips[0].size));
+		}
+		MipGenerator::Generate(view.info, MIP_FILTER_BOX, false, 0, data);
+
+		view.mapping.data = data;
+		view.mapping.size = view.info.sliceSize * view.info.arraySize;
+
+		TextureHandle* textureHandle = CreateTextureFromView(device, uploadRing, view, srvHandle);
+
+		delete[] data;
+
+		return textureHandle;
 	}
 
-	TextureHandle* CreateTexture2D(ID3D12Device* device, const wchar_t* filename, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
+	TextureHandle* CreateTexture2D(ID3D12Device* device, D3D12UploadRing* uploadRing, const char* filename, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
 	{
-		using namespace DirectX;
+		if (ImageFile::IsSupported(filename))
+			return CreateTexture2DFromImage(device, uploadRing, filename, srvHandle);
+
+		DDSFileView view;
+		if (!DDSFile::Open(filename, &view))
+		{
+			ThrowIfFailed(E_FAIL);
+			return nullptr;
+		}
+
+		TextureHandle* textureHandle = nullptr;
+		if (view.info.mipLevels == 1 && (view.info.width > 1 || view.info.height > 1) && MipGenerator::IsSupported(view.info.format))
+		{
+			textureHandle = CreateTexture2DWithMips(device, uploadRing, view, srvHandle);
+		}
+		else
+		{
+			// Copies read straight from the mapping, so the file is never staged in memory.
+			textureHandle = CreateTextureFromView(device, uploadRing, view, srvHandle);
+		}
+
+		DDSFile::Close(&view);
 
-		// TODO
-		D3D12CommandList* ctx = new D3D12CommandList;
-		ctx->Init(device);
+		return textureHandle;
+	}
+
+	TextureHandle* CreateTexture2D(ID3D12Device* device, D3D12UploadRing* uploadRing, D3D12MipGenerator* mipGenerator, uint32 width, uint32 height, DXGI_FORMAT format, const void* pixels, uint32 rowPitch, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
+	{
+		if (!D3D12MipGenerator::IsSupported(format))
+		{
+			ThrowIfFailed(E_INVALIDARG);
+			return nullptr;
+		}
 
 		TextureHandle* textureHandle = new TextureHandle;
-		ResourceUploadBatch resourceUpload(device);
-		resourceUpload.Begin();
+		textureHandle->resource = CreateMipmappedTextureResource(device, width, height, format, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COPY_DEST);
+
+		UploadSubresource(device, uploadRing, textureHandle->resource, 0, static_cast<const uint8*>(pixels), rowPitch);
+
+		ID3D12GraphicsCommandList* commandList = uploadRing->GetCommandList();
+		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(textureHandle->resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+		// Runs with the ring's copies, ahead of the frame that first samples the texture.
+		mipGenerator->Generate(commandList, textureHandle->resource, format);
+
+		CreateTextureSRV(device, textureHandle->resource, format, srvHandle);
+		textureHandle->srvHandle = srvHandle;
+
+		return textureHandle;
+	}
+
+	ID3D12Resource* CreateTextureResource(ID3D12Device* device, const DDSTextureInfo& info, uint32 mostDetailedMip)
+	{
+		ID3D12Resource* resource = nullptr;
+
+		const DDSMipLayout& layout = info.mips[mostDetailedMip];
+		CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
+		auto desc = CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(info.format), layout.width, layout.height, static_cast<uint16>(info.arraySize), static_cast<uint16>(info.mipLevels - mostDetailedMip));
+		ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&resource)));
+
+		return resource;
+	}
+
+	ID3D12Resource* CreateReservedTextureResource(ID3D12Device* device, const DDSTextureInfo& info)
+	{
+		ID3D12Resource* resource = nullptr;
+
+		// Tiles are mapped one at a time with UpdateTileMappings, so the layout must be the standard 64 KB swizzle.
+		auto desc = CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(info.format), info.width, info.height, static_cast<uint16>(info.arraySize), static_cast<uint16>(info.mipLevels), 1, 0, D3D12_RESOURCE_FLAG_NONE, D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE);
+		ThrowIfFailed(device->CreateReservedResource(&desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&resource)));
+
+		return resource;
+	}
+
+	ID3D12Resource* CreateMipmappedTextureResource(ID3D12Device* device, uint32 width, uint32 height, DXGI_FORMAT format, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES initialState)
+	{
+		ID3D12Resource* resource = nullptr;
 
-		ThrowIfFailed(CreateDDSTextureFromFile(device, resourceUpload, filename, &textureHandle->resource));
+		uint16 mipLevels = static_cast<uint16>(MipGenerator::GetMipLevelsCount(width, height));
+		CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
+		auto desc = CD3DX12_RESOURCE_DESC::Tex2D(D3D12MipGenerator::GetResourceFormat(format), width, height, 1, mipLevels, 1, 0, flags | D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+		ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc, initialState, nullptr, IID_PPV_ARGS(&resource)));
 
-		auto uploadResourcesFinished = resourceUpload.End(ctx->m_commandQueue);
+		return resource;
+	}
 
-		uploadResourcesFinished.wait();
+	void CreateTextureSRV(ID3D12Device* device, ID3D12Resource* texture, const DDSTextureInfo& info, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
+	{
+		D3D12_RESOURCE_DESC desc = texture->GetDesc();
 
 		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-		srvDesc.Format = textureHandle->resource->GetDesc().Format;
+		srvDesc.Format = desc.Format;
+		if (info.isCubemap)
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+			srvDesc.TextureCube.MostDetailedMip = 0;
+			srvDesc.TextureCube.MipLevels = desc.MipLevels;
+			srvDesc.TextureCube.ResourceMinLODClamp = 0.0f;
+		}
+		else if (info.arraySize > 1)
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+			srvDesc.Texture2DArray.MostDetailedMip = 0;
+			srvDesc.Texture2DArray.MipLevels = desc.MipLevels;
+			srvDesc.Texture2DArray.FirstArraySlice = 0;
+			srvDesc.Texture2DArray.ArraySize = info.arraySize;
+			srvDesc.Texture2DArray.ResourceMinLODClamp = 0.0f;
+		}
+		else
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MostDetailedMip = 0;
+			srvDesc.Texture2D.MipLevels = desc.MipLevels;
+			srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+		}
+
+		device->CreateShaderResourceView(texture, &srvDesc, srvHandle);
+	}
+
+	void CreateTextureSRV(ID3D12Device* device, ID3D12Resource* texture, DXGI_FORMAT format, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
+	{
+		D3D12_RESOURCE_DESC desc = texture->GetDesc();
+
+		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		srvDesc.Format = format;
 		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
 		srvDesc.Texture2D.MostDetailedMip = 0;
-		srvDesc.Texture2D.MipLevels = textureHandle->resource->GetDesc().MipLevels;
+		srvDesc.Texture2D.MipLevels = desc.MipLevels;
 		srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
 
-		device->CreateShaderResourceView(textureHandle->resource, &srvDesc, srvHandle);
-		textureHandle->srvHandle = srvHandle;
-
-		ctx->Clean();
-		delete ctx;
-		ctx = nullptr;
-
-		return textureHandle;
+		device->CreateShaderResourceView(texture, &srvDesc, srvHandle);
 	}
 
 	uint32 CalcConstantBufferByteSize(uint32 size)
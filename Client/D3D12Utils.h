@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../Common/Vertex.h"
+#include "../Common/DDSFile.h"
+#include "../Common/TextureStreamer.h"
 
 /*
 ================
@@ -13,15 +15,42 @@ struct TextureHandle
 	ID3D12Resource* resource = nullptr;
 	ID3D12Resource* upload = nullptr;
 	D3D12_CPU_DESCRIPTOR_HANDLE srvHandle = {};
+
+	// Streamed textures: mip 0 of resource is file mip mostDetailedMip.
+	uint32 mostDetailedMip = 0;
+	uint32 streamingId = TEXTURE_STREAMER_INVALID_ID;
 };
 
+class D3D12MipGenerator;
+class D3D12UploadRing;
+
 void ThrowIfFailed(HRESULT hr);
 
 namespace D3D12Utils
 {
-	VertexBuffer* CreateVertexBuffer(ID3D12Device* device, void* vertices, uint32 count, uint32 size, uint32 stride);
-	IndexBuffer* CreateIndexBuffer(ID3D12Device* device, void* indices, uint32 count, uint32 size, DXGI_FORMAT format);
-	TextureHandle* CreateTexture2D(ID3D12Device* device, const wchar_t* filename, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle);
+	VertexBuffer* CreateVertexBuffer(ID3D12Device* device, D3D12UploadRing* uploadRing, const void* vertices, uint32 count, uint32 size, uint32 stride);
+	IndexBuffer* CreateIndexBuffer(ID3D12Device* device, D3D12UploadRing* uploadRing, const void* indices, uint32 count, uint32 size, DXGI_FORMAT format);
+	TextureHandle* CreateTexture2D(ID3D12Device* device, D3D12UploadRing* uploadRing, const char* filename, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle);
+	// Uploads pixels as mip 0 and fills the rest of the chain on the GPU, on the
+	// upload ring's command list. format must pass D3D12MipGenerator::IsSupported.
+	TextureHandle* CreateTexture2D(ID3D12Device* device, D3D12UploadRing* uploadRing, D3D12MipGenerator* mipGenerator, uint32 width, uint32 height, DXGI_FORMAT format, const void* pixels, uint32 rowPitch, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle);
+
+	// Texture holding file mips [mostDetailedMip, info.mipLevels), created in COPY_DEST.
+	ID3D12Resource* CreateTextureResource(ID3D12Device* device, const DDSTextureInfo& info, uint32 mostDetailedMip);
+	// Reserved texture with every mip of the file and no memory behind it, created in COPY_DEST.
+	ID3D12Resource* CreateReservedTextureResource(ID3D12Device* device, const DDSTextureInfo& info);
+	// Full mip chain with unordered access for D3D12MipGenerator, plus flags such as
+	// ALLOW_RENDER_TARGET. sRGB formats get a typeless resource.
+	ID3D12Resource* CreateMipmappedTextureResource(ID3D12Device* device, uint32 width, uint32 height, DXGI_FORMAT format, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES initialState);
+	void CreateTextureSRV(ID3D12Device* device, ID3D12Resource* texture, const DDSTextureInfo& info, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle);
+	// Every mip of a single 2D slice, viewed as format.
+	void CreateTextureSRV(ID3D12Device* device, ID3D12Resource* texture, DXGI_FORMAT format, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle);
+
+	// Copies file mips [firstMip, firstMip + mipsCount) of every slice from the mapping into the
+	// upload ring. File mip mostDetailedMip lands in mip 0 of the texture, which must be in
+	// COPY_DEST; the uploaded subresources end in PIXEL_SHADER_RESOURCE. Mips larger than a
+	// ring chunk are copied in row bands, so any size fits through the ring.
+	void UploadTextureMips(ID3D12Device* device, D3D12UploadRing* uploadRing, ID3D12Resource* texture, const DDSFileView& view, uint32 firstMip, uint32 mipsCount, uint32 mostDetailedMip);
 	uint32 CalcConstantBufferByteSize(uint32 size);
 }
 
@@ -0,0 +1,526 @@
+#include "pch.h"
+#include "D3D12VirtualTexture.h"
+#include "D3D12Renderer.h"
+#include "D3D12UploadRing.h"
+#include "D3D12Utils.h"
+
+/*
+=====================
+D3D12VirtualTexture
+=====================
+*/
+
+bool D3D12VirtualTexture::Init(D3D12Renderer* renderer, const char* filename, uint32 physicalPagesCount)
+{
+	m_renderer = renderer;
+	m_device = renderer->GetDevice();
+	m_commandQueue = renderer->GetCommandQueue();
+	m_uploadRing = renderer->GetUploadRing();
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+	if (FAILED(m_device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))) || options.TiledResourcesTier == D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED)
+		return false;
+
+	if (!DDSFile::Open(filename, &m_view))
+		return false;
+
+	// Tiles are addressed by mip only; arrays and cubes stay on the streamed path.
+	if (m_view.info.arraySize != 1)
+	{
+		DDSFile::Close(&m_view);
+		return false;
+	}
+
+	D3D12BindlessHeap* bindlessHeap = renderer->GetBindlessHeap();
+	m_textureDescriptor = bindlessHeap->Allocate();
+	m_residencyMapDescriptor = bindlessHeap->Allocate();
+	m_feedbackDescriptor = bindlessHeap->AllocateUav();
+	if (m_textureDescriptor == BINDLESS_INVALID_INDEX || m_residencyMapDescriptor == BINDLESS_INVALID_INDEX || m_feedbackDescriptor == BINDLESS_INVALID_INDEX)
+	{
+		FreeDescriptors();
+		DDSFile::Close(&m_view);
+		return false;
+	}
+
+	CreateTexture(physicalPagesCount, bindlessHeap->GetCpuHandle(m_textureDescriptor));
+	CreateResidencyMap(bindlessHeap->GetCpuHandle(m_residencyMapDescriptor));
+	CreateFeedback(bindlessHeap->GetCpuHandle(m_feedbackDescriptor));
+
+	m_slotData = new uint8[s_MaxLoadsInFlight * VT_TILE_SIZE];
+	for (uint32 i = 0; i < s_MaxLoadsInFlight; i++)
+	{
+		m_slots[i].state = LOAD_SLOT_STATE_FREE;
+		m_slots[i].data = m_slotData + i * VT_TILE_SIZE;
+	}
+
+	::InitializeCriticalSection(&m_lock);
+	::InitializeConditionVariable(&m_loaderWake);
+	m_quit = false;
+
+	m_loaderThread = ::CreateThread(nullptr, 0, LoaderThreadProc, this, 0, nullptr);
+	if (m_loaderThread == nullptr)
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+
+	return true;
+}
+
+void D3D12VirtualTexture::Clean()
+{
+	if (m_loaderThread)
+	{
+		::EnterCriticalSection(&m_lock);
+		m_quit = true;
+		::LeaveCriticalSection(&m_lock);
+		::WakeConditionVariable(&m_loaderWake);
+
+		::WaitForSingleObject(m_loaderThread, INFINITE);
+		::CloseHandle(m_loaderThread);
+		m_loaderThread = nullptr;
+
+		::DeleteCriticalSection(&m_lock);
+	}
+
+	if (m_slotData)
+	{
+		delete[] m_slotData;
+		m_slotData = nullptr;
+	}
+
+	if (m_residencyData)
+	{
+		delete[] m_residencyData;
+		m_residencyData = nullptr;
+	}
+
+	ID3D12Resource* resources[] = { m_texture, m_residencyMap, m_feedback, m_feedbackReadback, m_feedbackClear };
+	for (ID3D12Resource* resource : resources)
+	{
+		if (resource)
+			m_renderer->DeferRelease(resource);
+	}
+	m_texture = nullptr;
+	m_residencyMap = nullptr;
+	m_feedback = nullptr;
+	m_feedbackReadback = nullptr;
+	m_feedbackClear = nullptr;
+
+	if (m_heap)
+	{
+		m_renderer->DeferRelease(m_heap);
+		m_heap = nullptr;
+	}
+
+	FreeDescriptors();
+
+	m_pageTable.Clean();
+	DDSFile::Close(&m_view);
+}
+
+void D3D12VirtualTexture::Update()
+{
+	ReadFeedback();
+	MapCompletedTiles();
+	IssueLoads();
+
+	if (m_residencyDirty)
+		UploadResidencyMap();
+}
+
+void D3D12VirtualTexture::RecordFeedback(ID3D12GraphicsCommandList* commandList)
+{
+	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_feedback, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	commandList->ResourceBarrier(1, &barrier);
+	commandList->CopyBufferRegion(m_feedbackReadback, 0, m_feedback, 0, m_feedbackSize);
+
+	barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_feedback, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+	commandList->ResourceBarrier(1, &barrier);
+	commandList->CopyBufferRegion(m_feedback, 0, m_feedbackClear, 0, m_feedbackSize);
+
+	barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_feedback, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	commandList->ResourceBarrier(1, &barrier);
+
+	m_feedbackPending = true;
+}
+
+void D3D12VirtualTexture::CreateTexture(uint32 physicalPagesCount, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
+{
+	const DDSTextureInfo& info = m_view.info;
+	m_texture = D3D12Utils::CreateReservedTextureResource(m_device, info);
+
+	uint32 tilesCount = 0;
+	D3D12_PACKED_MIP_INFO packedMipInfo = {};
+	D3D12_TILE_SHAPE tileShape = {};
+	uint32 subresourceTilingsCount = info.mipLevels;
+	D3D12_SUBRESOURCE_TILING subresourceTilings[DDS_MAX_MIPS] = {};
+	m_device->GetResourceTiling(m_texture, &tilesCount, &packedMipInfo, &tileShape, &subresourceTilingsCount, 0, subresourceTilings);
+
+	VirtualTextureDesc desc;
+	desc.standardMipsCount = packedMipInfo.NumStandardMips;
+	for (uint32 mip = 0; mip < desc.standardMipsCount; mip++)
+	{
+		desc.widthInTiles[mip] = subresourceTilings[mip].WidthInTiles;
+		desc.heightInTiles[mip] = subresourceTilings[mip].HeightInTiles;
+	}
+	desc.physicalPagesCount = physicalPagesCount;
+	m_pageTable.Init(desc);
+	m_physicalPagesCount = physicalPagesCount;
+
+	// A tile holds the same number of block rows at every mip.
+	uint32 rowHeight = DDSFile::IsBlockCompressed(info.format) ? 4 : 1;
+	m_tileRowsCount = tileShape.HeightInTexels / rowHeight;
+
+	m_constants.textureSize[0] = info.width;
+	m_constants.textureSize[1] = info.height;
+	m_constants.tileSize[0] = tileShape.WidthInTexels;
+	m_constants.tileSize[1] = tileShape.HeightInTexels;
+	m_constants.mip0Tiles[0] = desc.standardMipsCount ? desc.widthInTiles[0] : 1;
+	m_constants.mip0Tiles[1] = desc.standardMipsCount ? desc.heightInTiles[0] : 1;
+	m_constants.standardMipsCount = desc.standardMipsCount;
+	for (uint32 mip = 0; mip < desc.standardMipsCount; mip++)
+	{
+		m_constants.mipOffsets[mip] = m_pageTable.GetTileIndex(mip, 0, 0);
+	}
+
+	// The pool comes first in the heap, the packed tail after it.
+	uint64 heapSize = static_cast<uint64>(physicalPagesCount + packedMipInfo.NumTilesForPackedMips) * VT_TILE_SIZE;
+	CD3DX12_HEAP_DESC heapDesc(heapSize, D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES);
+	ThrowIfFailed(m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_heap)));
+
+	if (packedMipInfo.NumPackedMips)
+	{
+		CD3DX12_TILED_RESOURCE_COORDINATE coord(0, 0, 0, packedMipInfo.NumStandardMips);
+		D3D12_TILE_REGION_SIZE regionSize = {};
+		regionSize.NumTiles = packedMipInfo.NumTilesForPackedMips;
+
+		D3D12_TILE_RANGE_FLAGS rangeFlags = D3D12_TILE_RANGE_FLAG_NONE;
+		uint32 heapOffset = physicalPagesCount;
+		uint32 rangeTilesCount = packedMipInfo.NumTilesForPackedMips;
+		m_commandQueue->UpdateTileMappings(m_texture, 1, &coord, &regionSize, m_heap, 1, &rangeFlags, &heapOffset, &rangeTilesCount, D3D12_TILE_MAPPING_FLAG_NONE);
+
+		// Queue operations run in order, so the mapping is in place before the ring's copies.
+		D3D12Utils::UploadTextureMips(m_device, m_uploadRing, m_texture, m_view, packedMipInfo.NumStandardMips, packedMipInfo.NumPackedMips, 0);
+	}
+
+	// Standard mips start unmapped. The residency map keeps shaders off them until tiles arrive.
+	ID3D12GraphicsCommandList* commandList = m_uploadRing->GetCommandList();
+	for (uint32 mip = 0; mip < packedMipInfo.NumStandardMips; mip++)
+	{
+		auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_texture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, mip);
+		commandList->ResourceBarrier(1, &barrier);
+	}
+
+	D3D12Utils::CreateTextureSRV(m_device, m_texture, info, srvHandle);
+}
+
+void D3D12VirtualTexture::FreeDescriptors()
+{
+	D3D12BindlessHeap* bindlessHeap = m_renderer->GetBindlessHeap();
+	bindlessHeap->Free(m_textureDescriptor);
+	bindlessHeap->Free(m_residencyMapDescriptor);
+	bindlessHeap->Free(m_feedbackDescriptor);
+	m_textureDescriptor = BINDLESS_INVALID_INDEX;
+	m_residencyMapDescriptor = BINDLESS_INVALID_INDEX;
+	m_feedbackDescriptor = BINDLESS_INVALID_INDEX;
+}
+
+void D3D12VirtualTexture::CreateResidencyMap(D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
+{
+	uint32 width = m_constants.mip0Tiles[0];
+	uint32 height = m_constants.mip0Tiles[1];
+
+	m_residencyData = new uint8[width * height];
+	::memset(m_residencyData, 0, width * height);
+
+	CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
+	auto desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8_UINT, width, height, 1, 1);
+	ThrowIfFailed(m_device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, nullptr, IID_PPV_ARGS(&m_residencyMap)));
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = DXGI_FORMAT_R8_UINT;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = 1;
+	m_device->CreateShaderResourceView(m_residencyMap, &srvDesc, srvHandle);
+
+	UploadResidencyMap();
+}
+
+void D3D12VirtualTexture::CreateFeedback(D3D12_CPU_DESCRIPTOR_HANDLE uavHandle)
+{
+	uint32 elementsCount = m_pageTable.GetTilesCount() ? m_pageTable.GetTilesCount() : 1;
+	m_feedbackSize = elementsCount * sizeof(uint32);
+
+	CD3DX12_HEAP_PROPERTIES defaultHeapProps(D3D12_HEAP_TYPE_DEFAULT);
+	auto desc = CD3DX12_RESOURCE_DESC::Buffer(m_feedbackSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+	ThrowIfFailed(m_device->CreateCommittedResource(&defaultHeapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&m_feedback)));
+
+	CD3DX12_HEAP_PROPERTIES readbackHeapProps(D3D12_HEAP_TYPE_READBACK);
+	desc = CD3DX12_RESOURCE_DESC::Buffer(m_feedbackSize);
+	ThrowIfFailed(m_device->CreateCommittedResource(&readbackHeapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m_feedbackReadback)));
+
+	// Zeros copied over the feedback buffer after every readback.
+	CD3DX12_HEAP_PROPERTIES uploadHeapProps(D3D12_HEAP_TYPE_UPLOAD);
+	ThrowIfFailed(m_device->CreateCommittedResource(&uploadHeapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_feedbackClear)));
+
+	uint8* clearData = nullptr;
+	CD3DX12_RANGE readRange(0, 0);
+	ThrowIfFailed(m_feedbackClear->Map(0, &readRange, reinterpret_cast<void**>(&clearData)));
+	::memset(clearData, 0, m_feedbackSize);
+	m_feedbackClear->Unmap(0, nullptr);
+
+	ID3D12GraphicsCommandList* commandList = m_uploadRing->GetCommandList();
+	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_feedback, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
+	commandList->ResourceBarrier(1, &barrier);
+	commandList->CopyBufferRegion(m_feedback, 0, m_feedbackClear, 0, m_feedbackSize);
+	barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_feedback, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	commandList->ResourceBarrier(1, &barrier);
+
+	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+	uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+	uavDesc.Buffer.NumElements = elementsCount;
+	uavDesc.Buffer.StructureByteStride = sizeof(uint32);
+	m_device->CreateUnorderedAccessView(m_feedback, nullptr, &uavDesc, uavHandle);
+}
+
+void D3D12VirtualTexture::ReadFeedback()
+{
+	if (!m_feedbackPending)
+		return;
+
+	// Present waited for the GPU, so last frame's copy has landed.
+	uint32* feedback = nullptr;
+	CD3DX12_RANGE readRange(0, m_feedbackSize);
+	ThrowIfFailed(m_feedbackReadback->Map(0, &readRange, reinterpret_cast<void**>(&feedback)));
+
+	uint32 tilesCount = m_pageTable.GetTilesCount();
+	for (uint32 i = 0; i < tilesCount; i++)
+	{
+		if (feedback[i])
+			m_pageTable.RequestTile(i);
+	}
+
+	CD3DX12_RANGE writeRange(0, 0);
+	m_feedbackReadback->Unmap(0, &writeRange);
+	m_feedbackPending = false;
+}
+
+void D3D12VirtualTexture::MapCompletedTiles()
+{
+	// The loader thread never touches a slot once it is done, so the data can be read outside the lock.
+	LoadSlot* completed[s_MaxLoadsInFlight] = {};
+	uint32 completedCount = 0;
+
+	::EnterCriticalSection(&m_lock);
+	for (uint32 i = 0; i < s_MaxLoadsInFlight; i++)
+	{
+		if (m_slots[i].state == LOAD_SLOT_STATE_DONE)
+			completed[completedCount++] = &m_slots[i];
+	}
+	::LeaveCriticalSection(&m_lock);
+
+	if (completedCount == 0)
+		return;
+
+	ID3D12GraphicsCommandList* commandList = m_uploadRing->GetCommandList();
+	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+	commandList->ResourceBarrier(1, &barrier);
+
+	for (uint32 i = 0; i < completedCount; i++)
+	{
+		const VirtualTileLoad& load = completed[i]->load;
+		MapTile(load.mip, load.x, load.y, load.page);
+
+		UploadAllocation allocation = {};
+		if (!m_uploadRing->Allocate(VT_TILE_SIZE, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, &allocation))
+		{
+			ThrowIfFailed(E_OUTOFMEMORY);
+		}
+		::memcpy(allocation.cpuAddress, completed[i]->data, VT_TILE_SIZE);
+
+		CD3DX12_TILED_RESOURCE_COORDINATE coord(load.x, load.y, 0, load.mip);
+		D3D12_TILE_REGION_SIZE regionSize = {};
+		regionSize.NumTiles = 1;
+
+		// Fetched per copy: Allocate may have submitted the previous list to make room.
+		commandList = m_uploadRing->GetCommandList();
+		commandList->CopyTiles(m_texture, &coord, &regionSize, allocation.resource, allocation.offset, D3D12_TILE_COPY_FLAG_LINEAR_BUFFER_TO_SWIZZLED_TILED_RESOURCE);
+
+		m_pageTable.CompleteLoad(load.tileIndex);
+	}
+
+	commandList = m_uploadRing->GetCommandList();
+	barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_texture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	commandList->ResourceBarrier(1, &barrier);
+
+	::EnterCriticalSection(&m_lock);
+	for (uint32 i = 0; i < completedCount; i++)
+	{
+		completed[i]->state = LOAD_SLOT_STATE_FREE;
+	}
+	::LeaveCriticalSection(&m_lock);
+
+	m_residencyDirty = true;
+}
+
+void D3D12VirtualTexture::IssueLoads()
+{
+	uint32 freeSlots[s_MaxLoadsInFlight] = {};
+	uint32 freeSlotsCount = 0;
+
+	::EnterCriticalSection(&m_lock);
+	for (uint32 i = 0; i < s_MaxLoadsInFlight; i++)
+	{
+		if (m_slots[i].state == LOAD_SLOT_STATE_FREE)
+			freeSlots[freeSlotsCount++] = i;
+	}
+	::LeaveCriticalSection(&m_lock);
+
+	// Called even with no free slot: Update also ends the page table's frame.
+	VirtualTileLoad loads[s_MaxLoadsInFlight];
+	uint32 loadsCount = m_pageTable.Update(loads, freeSlotsCount);
+	if (loadsCount == 0)
+		return;
+
+	for (uint32 i = 0; i < loadsCount; i++)
+	{
+		// The page is handed over before its new data arrives; the old tile must
+		// not keep reading it. The residency map is rewritten this frame too.
+		if (loads[i].evictedTileIndex != VT_INVALID_INDEX)
+		{
+			UnmapTile(loads[i].evictedMip, loads[i].evictedX, loads[i].evictedY);
+			m_residencyDirty = true;
+		}
+	}
+
+	::EnterCriticalSection(&m_lock);
+	for (uint32 i = 0; i < loadsCount; i++)
+	{
+		LoadSlot& slot = m_slots[freeSlots[i]];
+		slot.load = loads[i];
+		slot.state = LOAD_SLOT_STATE_QUEUED;
+	}
+	::LeaveCriticalSection(&m_lock);
+
+	::WakeConditionVariable(&m_loaderWake);
+}
+
+void D3D12VirtualTexture::UploadResidencyMap()
+{
+	m_pageTable.BuildResidencyMap(m_residencyData);
+
+	D3D12_RESOURCE_DESC desc = m_residencyMap->GetDesc();
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+	uint32 rowsCount = 0;
+	uint64 rowSize = 0;
+	uint64 totalSize = 0;
+	m_device->GetCopyableFootprints(&desc, 0, 1, 0, &footprint, &rowsCount, &rowSize, &totalSize);
+
+	UploadAllocation allocation = {};
+	if (!m_uploadRing->Allocate(totalSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, &allocation))
+	{
+		ThrowIfFailed(E_OUTOFMEMORY);
+	}
+
+	for (uint32 row = 0; row < rowsCount; row++)
+	{
+		::memcpy(allocation.cpuAddress + row * footprint.Footprint.RowPitch, m_residencyData + row * rowSize, static_cast<size_t>(rowSize));
+	}
+	footprint.Offset = allocation.offset;
+
+	ID3D12GraphicsCommandList* commandList = m_uploadRing->GetCommandList();
+	auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_residencyMap, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+	commandList->ResourceBarrier(1, &barrier);
+
+	CD3DX12_TEXTURE_COPY_LOCATION dst(m_residencyMap, 0);
+	CD3DX12_TEXTURE_COPY_LOCATION src(allocation.resource, footprint);
+	commandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+
+	barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_residencyMap, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	commandList->ResourceBarrier(1, &barrier);
+
+	m_residencyDirty = false;
+}
+
+void D3D12VirtualTexture::MapTile(uint32 mip, uint32 x, uint32 y, uint32 page)
+{
+	CD3DX12_TILED_RESOURCE_COORDINATE coord(x, y, 0, mip);
+	D3D12_TILE_REGION_SIZE regionSize = {};
+	regionSize.NumTiles = 1;
+
+	D3D12_TILE_RANGE_FLAGS rangeFlags = D3D12_TILE_RANGE_FLAG_NONE;
+	uint32 rangeTilesCount = 1;
+	m_commandQueue->UpdateTileMappings(m_texture, 1, &coord, &regionSize, m_heap, 1, &rangeFlags, &page, &rangeTilesCount, D3D12_TILE_MAPPING_FLAG_NONE);
+}
+
+void D3D12VirtualTexture::UnmapTile(uint32 mip, uint32 x, uint32 y)
+{
+	CD3DX12_TILED_RESOURCE_COORDINATE coord(x, y, 0, mip);
+	D3D12_TILE_REGION_SIZE regionSize = {};
+	regionSize.NumTiles = 1;
+
+	D3D12_TILE_RANGE_FLAGS rangeFlags = D3D12_TILE_RANGE_FLAG_NULL;
+	uint32 rangeTilesCount = 1;
+	m_commandQueue->UpdateTileMappings(m_texture, 1, &coord, &regionSize, nullptr, 1, &rangeFlags, nullptr, &rangeTilesCount, D3D12_TILE_MAPPING_FLAG_NONE);
+}
+
+DWORD WINAPI D3D12VirtualTexture::LoaderThreadProc(void* param)
+{
+	D3D12VirtualTexture* texture = static_cast<D3D12VirtualTexture*>(param);
+
+	::EnterCriticalSection(&texture->m_lock);
+	while (!texture->m_quit)
+	{
+		LoadSlot* slot = nullptr;
+		for (uint32 i = 0; i < s_MaxLoadsInFlight; i++)
+		{
+			if (texture->m_slots[i].state == LOAD_SLOT_STATE_QUEUED)
+			{
+				slot = &texture->m_slots[i];
+				break;
+			}
+		}
+
+		if (!slot)
+		{
+			::SleepConditionVariableCS(&texture->m_loaderWake, &texture->m_lock, INFINITE);
+			continue;
+		}
+
+		slot->state = LOAD_SLOT_STATE_LOADING;
+		VirtualTileLoad load = slot->load;
+		::LeaveCriticalSection(&texture->m_lock);
+
+		// Page faults on the file mapping are taken here, off the render thread.
+		texture->LoadTile(load, slot->data);
+
+		::EnterCriticalSection(&texture->m_lock);
+		slot->state = LOAD_SLOT_STATE_DONE;
+	}
+	::LeaveCriticalSection(&texture->m_lock);
+
+	return 0;
+}
+
+void D3D12VirtualTexture::LoadTile(const VirtualTileLoad& load, uint8* outData)
+{
+	// CopyTiles takes a tile as tightly packed rows of blocks.
+	const DDSMipLayout& layout = m_view.info.mips[load.mip];
+	const uint8* src = DDSFile::GetMipData(m_view, load.mip);
+	uint32 tileRowPitch = VT_TILE_SIZE / m_tileRowsCount;
+	uint32 srcX = load.x * tileRowPitch;
+	uint32 firstRow = load.y * m_tileRowsCount;
+
+	// Tiles on the right and bottom edges hang over the mip; the overhang stays black.
+	::memset(outData, 0, VT_TILE_SIZE);
+	if (srcX >= layout.rowPitch)
+		return;
+
+	uint32 copySize = layout.rowPitch - srcX < tileRowPitch ? layout.rowPitch - srcX : tileRowPitch;
+	for (uint32 row = 0; row < m_tileRowsCount && firstRow + row < layout.rowsCount; row++)
+	{
+		::memcpy(outData + row * tileRowPitch, src + static_cast<uint64>(firstRow + row) * layout.rowPitch + srcX, copySize);
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "D3D12BindlessHeap.h"
+#include "../Common/DDSFile.h"
+#include "../Common/VirtualTexturePageTable.h"
+
+class D3D12Renderer;
+class D3D12UploadRing;
+
+/*
+=====================
+D3D12VirtualTexture
+=====================
+*/
+
+// Reserved texture whose 64 KB tiles are mapped into a heap of physical pages
+// on demand. Shaders record the tiles they would like to sample into a feedback
+// buffer; it is read back one frame later, the page table picks what to load
+// and evict, and a loader thread cuts the tiles out of the mapped DDS file.
+// The packed mip tail is mapped and uploaded once and never evicted.
+class D3D12VirtualTexture
+{
+public:
+	// Takes the texture and residency map SRVs and a feedback UAV slot from the
+	// renderer's bindless heap.
+	bool Init(D3D12Renderer* renderer, const char* filename, uint32 physicalPagesCount);
+	// GPU objects and descriptors go through the renderer's deferred release.
+	void Clean();
+
+	// Reads last frame's feedback, maps finished tiles and issues new loads. Call before recording the frame.
+	void Update();
+	// Copies this frame's feedback out and clears it. Call at the end of the frame's command list.
+	void RecordFeedback(ID3D12GraphicsCommandList* commandList);
+
+	inline const VirtualTextureConstants& GetConstants() const { return m_constants; }
+	// Bindless heap indices, for MaterialConstants.
+	inline uint32 GetTextureIndex() const { return m_textureDescriptor; }
+	inline uint32 GetResidencyMapIndex() const { return m_residencyMapDescriptor; }
+	inline uint32 GetFeedbackIndex() const { return m_feedbackDescriptor; }
+	inline uint32 GetResidentTilesCount() const { return m_pageTable.GetResidentTilesCount(); }
+
+private:
+	static const uint32 s_MaxLoadsInFlight = 16;
+
+	enum LOAD_SLOT_STATE
+	{
+		LOAD_SLOT_STATE_FREE,
+		LOAD_SLOT_STATE_QUEUED,
+		LOAD_SLOT_STATE_LOADING,
+		LOAD_SLOT_STATE_DONE,
+	};
+
+	struct LoadSlot
+	{
+		VirtualTileLoad load = {};
+		LOAD_SLOT_STATE state = LOAD_SLOT_STATE_FREE;
+		uint8* data = nullptr;
+	};
+
+	D3D12Renderer* m_renderer = nullptr;
+	ID3D12Device* m_device = nullptr;
+	ID3D12CommandQueue* m_commandQueue = nullptr;
+	D3D12UploadRing* m_uploadRing = nullptr;
+
+	DDSFileView m_view = {};
+	VirtualTexturePageTable m_pageTable;
+	VirtualTextureConstants m_constants = {};
+	uint32 m_physicalPagesCount = 0;
+	uint32 m_tileRowsCount = 0;
+
+	uint32 m_textureDescriptor = BINDLESS_INVALID_INDEX;
+	uint32 m_residencyMapDescriptor = BINDLESS_INVALID_INDEX;
+	uint32 m_feedbackDescriptor = BINDLESS_INVALID_INDEX;
+
+	ID3D12Resource* m_texture = nullptr;
+	ID3D12Heap* m_heap = nullptr;
+
+	// Finest resident mip per mip 0 tile, one byte each.
+	ID3D12Resource* m_residencyMap = nullptr;
+	uint8* m_residencyData = nullptr;
+	bool m_residencyDirty = true;
+
+	// One uint per standard tile, non-zero when some pixel wanted it.
+	ID3D12Resource* m_feedback = nullptr;
+	ID3D12Resource* m_feedbackReadback = nullptr;
+	ID3D12Resource* m_feedbackClear = nullptr;
+	uint32 m_feedbackSize = 0;
+	bool m_feedbackPending = false;
+
+	// Shared with the loader thread under m_lock.
+	LoadSlot m_slots[s_MaxLoadsInFlight] = {};
+	uint8* m_slotData = nullptr;
+	HANDLE m_loaderThread = nullptr;
+	CRITICAL_SECTION m_lock = {};
+	CONDITION_VARIABLE m_loaderWake = {};
+	bool m_quit = false;
+
+	void CreateTexture(uint32 physicalPagesCount, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle);
+	void CreateResidencyMap(D3D12_CPU_DESCRIPTOR_HANDLE srvHandle);
+	void CreateFeedback(D3D12_CPU_DESCRIPTOR_HANDLE uavHandle);
+	void FreeDescriptors();
+
+	void ReadFeedback();
+	void MapCompletedTiles();
+	void IssueLoads();
+	void UploadResidencyMap();
+	void MapTile(uint32 mip, uint32 x, uint32 y, uint32 page);
+	void UnmapTile(uint32 mip, uint32 x, uint32 y);
+
+	static DWORD WINAPI LoaderThreadProc(void* param);
+	void LoadTile(const VirtualTileLoad& load, uint8* outData);
+};
@@ -1,9 +1,10 @@
 #include "pch.h"
 #include "D3D12Renderer.h"
+#include "D3D12MaterialSystem.h"
 #include "D3D12Mesh.h"
-#include "GeometryGenerator.h"
-
-#include "../../Gen/LinkedList.h"
+#include "D3D12ShaderCache.h"
+#include "../Common/GeometryGenerator.h"
+#include "../Common/Profiler.h"
 
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 
@@ -18,6 +19,43 @@ int main(int argc, char* argv[])
 	// Memory leak profiler.
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 
+	// Post-build step: fill the shader cache next to the executable, then exit.
+	if (argc > 1 && ::strcmp(argv[1], "-compileshaders") == 0)
+	{
+		D3D12ShaderCache shaderCache;
+		shaderCache.Init(SHADER_DIRECTORY, SHADER_CACHE_DIRECTORY);
+		bool result = shaderCache.CompileAll();
+		shaderCache.Clean();
+		return result ? 0 : 1;
+	}
+
+	// "-shaders <dir>" reads and watches shaders from another directory, such as
+	// the source tree, so edits there are hot reloaded. Relative to the executable.
+	// "-trace <file>" writes a Chrome trace of the last frames on exit; open it
+	// in about:tracing or ui.perfetto.dev. "-stats" shows frame stats in the
+	// title bar and "-statscsv <file>" writes them for every frame.
+	const char* shaderDirectory = SHADER_DIRECTORY;
+	const char* traceFilename = nullptr;
+	const char* statsFilename = nullptr;
+	bool statsOverlay = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (::strcmp(argv[i], "-stats") == 0)
+			statsOverlay = true;
+		else if (i + 1 == argc)
+			break;
+		else if (::strcmp(argv[i], "-shaders") == 0)
+			shaderDirectory = argv[i + 1];
+		else if (::strcmp(argv[i], "-trace") == 0)
+			traceFilename = argv[i + 1];
+		else if (::strcmp(argv[i], "-statscsv") == 0)
+			statsFilename = argv[i + 1];
+	}
+
+	// Before the renderer so its worker threads are named in the trace.
+	Profiler::Init();
+	PROFILE_THREAD_NAME("Main");
+
 	// Register the window class.
 	const wchar_t CLASS_NAME[] = L"Windows Class";
 	const wchar_t WINDOW_NAME[] = L"XFree Engine Demo_v.1.0";
@@ -40,23 +78,56 @@ int main(int argc, char* argv[])
 	ShowWindow(hwnd, SW_SHOW);
 
 	D3D12Renderer* renderer = new D3D12Renderer;
-	if (!renderer->Init(hwnd))
+	if (!renderer->Init(hwnd, shaderDirectory))
 		return -1;
 
-	xlist* list = nullptr;
-	xlist_init(&list);
+	renderer->SetStatsOverlay(statsOverlay);
+	if (statsFilename && !renderer->GetFrameStats().OpenCsv(statsFilename))
+		::printf("Failed to open %s\n", statsFilename);
+
+	const uint32 MAX_MESHES = 8;
+	D3D12Mesh* meshes[MAX_MESHES] = {};
+	uint32 meshesCount = 0;
+
+	MaterialDesc crateDesc;
+	crateDesc.features = MATERIAL_FEATURE_ALBEDO_TEXTURE;
+	crateDesc.albedoTexture = "../Assets/WoodCrate01.dds";
+	Material* crate = renderer->CreateMaterial(crateDesc);
+
+	MaterialDesc vertexColorDesc;
+	vertexColorDesc.features = MATERIAL_FEATURE_VERTEX_COLOR;
+	Material* vertexColor = renderer->CreateMaterial(vertexColorDesc);
+
+	// Falls back to the base color where tiled resources are unsupported.
+	MaterialDesc virtualDesc;
+	virtualDesc.features = MATERIAL_FEATURE_VIRTUAL_TEXTURE;
+	virtualDesc.virtualTexture = "../Assets/WoodCrate01.dds";
+	Material* virtualCrate = renderer->CreateMaterial(virtualDesc);
 
 	D3D12Mesh* mesh = renderer->CreateMesh(GeometryGenerator::MakeBox(0.1f));
 	mesh->UpdateWorldMatrix(Matrix::CreateRotationY(DirectX::XM_PIDIV4) * Matrix::CreateTranslation(Vector3(0.0f, 0.2f, 0.0f)));
-	xlist_insert(list, mesh);
+	mesh->SetMaterial(crate);
+	meshes[meshesCount++] = mesh;
 
 	mesh = renderer->CreateMesh(GeometryGenerator::MakeBox(0.1f));
 	mesh->UpdateWorldMatrix(Matrix::CreateTranslation(Vector3(-0.5f, 0.0f, 0.0f)));
-	xlist_insert(list, mesh);
+	mesh->SetMaterial(vertexColor);
+	meshes[meshesCount++] = mesh;
 
 	mesh = renderer->CreateMesh(GeometryGenerator::MakeBox(0.1f));
 	mesh->UpdateWorldMatrix(Matrix::CreateTranslation(Vector3(0.5f, 0.0f, 0.0f)));
-	xlist_insert(list, mesh);
+	mesh->SetMaterial(crate);
+	meshes[meshesCount++] = mesh;
+
+	mesh = renderer->CreateMesh(GeometryGenerator::MakeSphere(0.1f, 128, 64));
+	mesh->UpdateWorldMatrix(Matrix::CreateTranslation(Vector3(0.0f, -0.3f, 0.0f)));
+	mesh->SetMaterial(crate);
+	meshes[meshesCount++] = mesh;
+
+	mesh = renderer->CreateMesh(GeometryGenerator::MakeBox(0.1f));
+	mesh->UpdateWorldMatrix(Matrix::CreateRotationY(DirectX::XM_PIDIV4));
+	mesh->SetMaterial(virtualCrate);
+	meshes[meshesCount++] = mesh;
 
 	MSG msg = { };
 	while (true)
@@ -73,45 +144,41 @@ int main(int argc, char* argv[])
 		}
 		else
 		{
+			PROFILE_SCOPE("Frame");
+
 			renderer->Update();
 
-			while (true)
 			{
-				void* iter = xlist_iter(list);
-				if (iter == nullptr)
-					break;
-				((D3D12Mesh*)(xlist_get_data(iter)))->Update();
+				PROFILE_SCOPE("UpdateMeshes");
+				for (uint32 i = 0; i < meshesCount; i++)
+					meshes[i]->Update();
 			}
 
 			renderer->BeginRender();
 
-			while (true)
-			{
-				void* iter = xlist_iter(list);
-				if (iter == nullptr)
-					break;
-				renderer->RenderMesh((D3D12Mesh*)xlist_get_data(iter));
-			}
+			for (uint32 i = 0; i < meshesCount; i++)
+				renderer->RenderMesh(meshes[i]);
 			
 			renderer->EndRender();
 			renderer->Present();
 		}
 	}
 
-	while (true)
-	{
-		void* iter = xlist_iter(list);
-		if (iter == nullptr)
-			break;
-		renderer->DestroyMesh((D3D12Mesh*)xlist_get_data(iter));
-	}
+	for (uint32 i = 0; i < meshesCount; i++)
+		renderer->DestroyMesh(meshes[i]);
 
-	xlist_clean(list);
+	renderer->DestroyMaterial(virtualCrate);
+	renderer->DestroyMaterial(vertexColor);
+	renderer->DestroyMaterial(crate);
 
 	renderer->Clean();
 	delete renderer;
 	renderer = nullptr;
 
+	if (traceFilename && !Profiler::WriteChromeTrace(traceFilename))
+		::printf("Failed to write %s\n", traceFilename);
+	Profiler::Clean();
+
 	::CloseWindow(hwnd);
 	hwnd = nullptr;
 
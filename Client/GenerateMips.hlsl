@@ -0,0 +1,133 @@
+// Compute mip generation for D3D12MipGenerator. Each dispatch reads one source
+// mip and writes up to four destination mips; every 8x8 group reduces its block
+// through groupshared memory. sRGB textures are read through an sRGB view, so
+// filtering happens in linear light, and encoded again before the store since
+// UAVs cannot be sRGB.
+
+Texture2D<float4> srcMip : register(t0);
+RWTexture2D<float4> outMip1 : register(u0);
+RWTexture2D<float4> outMip2 : register(u1);
+RWTexture2D<float4> outMip3 : register(u2);
+RWTexture2D<float4> outMip4 : register(u3);
+
+SamplerState linearClamp : register(s0);
+
+cbuffer MipConstants : register(b0)
+{
+	float2 texelSize;		// 1 / size of the first destination mip.
+	uint mipsCount;			// Destination mips written by this dispatch, 1 to 4.
+	uint srcDimension;		// Bit 0: source width is odd. Bit 1: source height is odd.
+	uint isSrgb;
+};
+
+// Channels are kept in separate arrays to avoid bank conflicts.
+groupshared float gs_R[64];
+groupshared float gs_G[64];
+groupshared float gs_B[64];
+groupshared float gs_A[64];
+
+void StoreColor(uint index, float4 color)
+{
+	gs_R[index] = color.r;
+	gs_G[index] = color.g;
+	gs_B[index] = color.b;
+	gs_A[index] = color.a;
+}
+
+float4 LoadColor(uint index)
+{
+	return float4(gs_R[index], gs_G[index], gs_B[index], gs_A[index]);
+}
+
+float3 LinearToSrgb(float3 color)
+{
+	return color < 0.0031308 ? 12.92 * color : 1.055 * pow(abs(color), 1.0 / 2.4) - 0.055;
+}
+
+float4 PackColor(float4 color)
+{
+	return isSrgb ? float4(LinearToSrgb(color.rgb), color.a) : color;
+}
+
+[numthreads(8, 8, 1)]
+void CSMain(uint groupIndex : SV_GroupIndex, uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+	// An odd source dimension leaves each destination texel covering one and a
+	// half source texels along it. Two bilinear taps a quarter texel in from
+	// either edge cover that footprint.
+	float4 src1 = 0;
+	switch (srcDimension)
+	{
+	case 0:
+	{
+		float2 uv = texelSize * (dispatchThreadId.xy + 0.5);
+		src1 = srcMip.SampleLevel(linearClamp, uv, 0);
+		break;
+	}
+	case 1:
+	{
+		float2 uv = texelSize * (dispatchThreadId.xy + float2(0.25, 0.5));
+		float2 offset = texelSize * float2(0.5, 0.0);
+		src1 = 0.5 * (srcMip.SampleLevel(linearClamp, uv, 0) + srcMip.SampleLevel(linearClamp, uv + offset, 0));
+		break;
+	}
+	case 2:
+	{
+		float2 uv = texelSize * (dispatchThreadId.xy + float2(0.5, 0.25));
+		float2 offset = texelSize * float2(0.0, 0.5);
+		src1 = 0.5 * (srcMip.SampleLevel(linearClamp, uv, 0) + srcMip.SampleLevel(linearClamp, uv + offset, 0));
+		break;
+	}
+	default:
+	{
+		float2 uv = texelSize * (dispatchThreadId.xy + 0.25);
+		float2 offset = texelSize * 0.5;
+		src1 = srcMip.SampleLevel(linearClamp, uv, 0);
+		src1 += srcMip.SampleLevel(linearClamp, uv + float2(offset.x, 0.0), 0);
+		src1 += srcMip.SampleLevel(linearClamp, uv + float2(0.0, offset.y), 0);
+		src1 += srcMip.SampleLevel(linearClamp, uv + offset, 0);
+		src1 *= 0.25;
+		break;
+	}
+	}
+
+	outMip1[dispatchThreadId.xy] = PackColor(src1);
+
+	if (mipsCount == 1)
+		return;
+
+	StoreColor(groupIndex, src1);
+	GroupMemoryBarrierWithGroupSync();
+
+	// Threads with even x and y.
+	if ((groupIndex & 0x9) == 0)
+	{
+		src1 = 0.25 * (src1 + LoadColor(groupIndex + 0x01) + LoadColor(groupIndex + 0x08) + LoadColor(groupIndex + 0x09));
+		outMip2[dispatchThreadId.xy / 2] = PackColor(src1);
+		StoreColor(groupIndex, src1);
+	}
+
+	if (mipsCount == 2)
+		return;
+
+	GroupMemoryBarrierWithGroupSync();
+
+	// Threads with x and y multiples of four.
+	if ((groupIndex & 0x1b) == 0)
+	{
+		src1 = 0.25 * (src1 + LoadColor(groupIndex + 0x02) + LoadColor(groupIndex + 0x10) + LoadColor(groupIndex + 0x12));
+		outMip3[dispatchThreadId.xy / 4] = PackColor(src1);
+		StoreColor(groupIndex, src1);
+	}
+
+	if (mipsCount == 3)
+		return;
+
+	GroupMemoryBarrierWithGroupSync();
+
+	if (groupIndex == 0)
+	{
+		src1 = 0.25 * (src1 + LoadColor(groupIndex + 0x04) + LoadColor(groupIndex + 0x20) + LoadColor(groupIndex + 0x24));
+		outMip4[dispatchThreadId.xy / 8] = PackColor(src1);
+	}
+}
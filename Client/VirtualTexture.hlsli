@@ -0,0 +1,50 @@
+// Sampling and feedback for D3D12VirtualTexture. The including shader finds
+// the texture, residency map and feedback buffer by their bindless indices,
+// and the constants from D3D12VirtualTexture::GetConstants.
+
+struct VirtualTextureConstants
+{
+	uint2 textureSize;
+	uint2 tileSize;
+	uint2 mip0Tiles;
+	uint standardMipsCount;
+	uint padding;
+	uint4 mipOffsets[4];
+};
+
+uint GetVirtualMipOffset(VirtualTextureConstants vt, uint mip)
+{
+	return vt.mipOffsets[mip >> 2][mip & 3];
+}
+
+// Records the tile this pixel would sample at full detail. Only one pixel in
+// each 4x4 block writes per frame, rotating with frameIndex, to keep UAV traffic low.
+void WriteVirtualFeedback(VirtualTextureConstants vt, Texture2D virtualTexture, SamplerState samplerState, RWStructuredBuffer<uint> feedback, float2 uv, float4 posProj, uint frameIndex)
+{
+	uint2 pixel = uint2(posProj.xy) & 3;
+	if (pixel.x + pixel.y * 4 != (frameIndex & 15))
+		return;
+
+	float lod = virtualTexture.CalculateLevelOfDetailUnclamped(samplerState, uv);
+	uint mip = (uint)max(floor(lod), 0.0);
+
+	// The packed tail is always resident.
+	if (mip >= vt.standardMipsCount)
+		return;
+
+	uint2 mipSize = max(vt.textureSize >> mip, 1);
+	uint2 mipTiles = (mipSize + vt.tileSize - 1) / vt.tileSize;
+	uint2 tile = min(uint2(saturate(uv) * mipSize) / vt.tileSize, mipTiles - 1);
+
+	feedback[GetVirtualMipOffset(vt, mip) + tile.y * mipTiles.x + tile.x] = 1;
+}
+
+// Samples with the LOD clamped to the finest mip resident under uv, so
+// unmapped tiles are never read.
+float4 SampleVirtual(VirtualTextureConstants vt, Texture2D virtualTexture, Texture2D<uint> residencyMap, SamplerState samplerState, float2 uv)
+{
+	uint2 tile = min(uint2(saturate(uv) * vt.mip0Tiles), vt.mip0Tiles - 1);
+	float minLod = (float)residencyMap.Load(int3(tile, 0));
+
+	return virtualTexture.Sample(samplerState, uv, int2(0, 0), minLod);
+}
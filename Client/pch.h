@@ -3,15 +3,20 @@
 #include "../Common/Types.h"
 
 #include <stdio.h>
-#define _CRTDBG_MAP_ALLOC
-#include <stdlib.h>
-#include <crtdbg.h>
-#ifdef _DEBUG
-	#define new new( _NORMAL_BLOCK , __FILE__ , __LINE__ )
+#if defined(_MSC_VER)
+	// The CRT debug heap, to report leaks with their file and line.
+	#define _CRTDBG_MAP_ALLOC
+	#include <stdlib.h>
+	#include <crtdbg.h>
+	#ifdef _DEBUG
+		#define new new( _NORMAL_BLOCK , __FILE__ , __LINE__ )
+	#endif
 #else
-	#define new new
+	#include <stdlib.h>
+#endif
+#if defined(_WIN32)
+	#include <Windows.h>
 #endif
-#include <Windows.h>
 
 /*
 ==============
@@ -31,7 +36,4 @@ Renderer
 #pragma comment(lib, "dxguid.lib")
 #pragma comment(lib, "d3dcompiler.lib")
 
-// TODO
-#pragma comment(lib, "../Binary/Debug/x64/Gen.lib")
-
 #include "D3D12GpuBuffer.h"
\ No newline at end of file
@@ -1,12 +1,53 @@
-Texture2D albedoTexture : register(t0);
+// Material features, set by D3D12MaterialSystem for each permutation.
+#ifndef USE_VERTEX_COLOR
+#define USE_VERTEX_COLOR 0
+#endif
+#ifndef USE_ALBEDO_TEXTURE
+#define USE_ALBEDO_TEXTURE 0
+#endif
+#ifndef USE_ALPHA_TEST
+#define USE_ALPHA_TEST 0
+#endif
+#ifndef USE_VIRTUAL_TEXTURE
+#define USE_VIRTUAL_TEXTURE 0
+#endif
+
+#include "VirtualTexture.hlsli"
+
+// Matches BINDLESS_UAVS_COUNT.
+#define BINDLESS_UAVS_COUNT 16
+
+struct MaterialConstants
+{
+	float4 baseColor;
+	float alphaCutoff;
+	uint albedoTexture;		// Index into textures.
+	uint virtualTexture;	// Index into textures.
+	uint virtualResidencyMap;	// Index into uintTextures.
+	uint virtualFeedback;	// Index into feedbackBuffers.
+	float3 padding;
+	VirtualTextureConstants virtualTextureConstants;
+};
+
+// Every texture in the bindless heap; see D3D12BindlessHeap.
+Texture2D textures[] : register(t0, space1);
+Texture2D<uint> uintTextures[] : register(t0, space2);
+RWStructuredBuffer<uint> feedbackBuffers[BINDLESS_UAVS_COUNT] : register(u0, space1);
+StructuredBuffer<MaterialConstants> materials : register(t0);
 
 SamplerState linearClamp : register(s0);
 
-cbuffer ConstBuffer : register(b0)
+cbuffer ObjectConstants : register(b0)
 {
 	matrix world;
+	uint materialIndex;
+};
+
+cbuffer FrameConstants : register(b1)
+{
 	matrix view;
 	matrix proj;
+	uint frameIndex;
 };
 
 struct VSInput
@@ -19,8 +60,12 @@ struct VSInput
 struct PSInput
 {
 	float4 posProj : SV_POSITION;
+#if USE_VERTEX_COLOR
 	float4 color : COLOR;
+#endif
+#if USE_ALBEDO_TEXTURE || USE_VIRTUAL_TEXTURE
 	float2 texCoord : TEXCOORD;
+#endif
 };
 
 PSInput VSMain(VSInput input)
@@ -34,15 +79,38 @@ PSInput VSMain(VSInput input)
 	pos = mul(pos, proj);
 
 	output.posProj = pos;
+#if USE_VERTEX_COLOR
 	output.color = input.color;
+#endif
+#if USE_ALBEDO_TEXTURE || USE_VIRTUAL_TEXTURE
 	output.texCoord = input.texCoord;
+#endif
 
 	return output;
 }
 
 float4 PSMain(PSInput input) : SV_Target0
 {
-	return albedoTexture.Sample(linearClamp, input.texCoord);
+	MaterialConstants material = materials[materialIndex];
+
+	float4 color = material.baseColor;
+#if USE_ALBEDO_TEXTURE
+	color *= textures[material.albedoTexture].Sample(linearClamp, input.texCoord);
+#endif
+#if USE_VIRTUAL_TEXTURE
+	Texture2D virtualTexture = textures[material.virtualTexture];
+	VirtualTextureConstants vt = material.virtualTextureConstants;
+	WriteVirtualFeedback(vt, virtualTexture, linearClamp, feedbackBuffers[material.virtualFeedback], input.texCoord, input.posProj, frameIndex);
+	color *= SampleVirtual(vt, virtualTexture, uintTextures[material.virtualResidencyMap], linearClamp, input.texCoord);
+#endif
+#if USE_VERTEX_COLOR
+	color *= input.color;
+#endif
+#if USE_ALPHA_TEST
+	clip(color.a - material.alphaCutoff);
+#endif
+
+	return color;
 }
 
 
@@ -0,0 +1,1059 @@
+#include "BCEncoder.h"
+#include "Platform.h"
+
+#include <math.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+	#define BC_ENCODER_SSE2
+	#include <emmintrin.h>
+#endif
+
+/*
+============
+BC Encoder
+============
+*/
+
+namespace BCEncoder
+{
+	const uint32 BLOCK_TEXELS = 16;
+	const uint32 BC1_BLOCK_SIZE = 8;
+	const uint32 BC7_MODE6_INDEX_BITS = 4;
+
+	static const uint8 s_BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Position of each BC1 palette entry along the endpoint line.
+	static const float s_BC1Weights4[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+	static const float s_BC1Weights3[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+
+	struct BitWriter
+	{
+		uint8* data = nullptr;
+		uint32 bit = 0;
+
+		void Write(uint32 value, uint32 count)
+		{
+			for (uint32 i = 0; i < count; i++, bit++)
+			{
+				if (value & (1u << i))
+					data[bit >> 3] |= static_cast<uint8>(1u << (bit & 7));
+			}
+		}
+	};
+
+	struct BitReader
+	{
+		const uint8* data = nullptr;
+		uint32 bit = 0;
+
+		uint32 Read(uint32 count)
+		{
+			uint32 value = 0;
+			for (uint32 i = 0; i < count; i++, bit++)
+			{
+				value |= static_cast<uint32>((data[bit >> 3] >> (bit & 7)) & 1) << i;
+			}
+			return value;
+		}
+	};
+
+	static inline float Clamp(float value, float minValue, float maxValue)
+	{
+		return value < minValue ? minValue : (value > maxValue ? maxValue : value);
+	}
+
+	// Closest palette entry per texel by squared RGB (or RGBA) distance. Ties
+	// go to the lower index, in both paths.
+	static void FindClosest(const uint8* texels, const uint8* palette, uint32 paletteCount, bool useAlpha, uint8* outIndices, uint32* outErrors)
+	{
+#if defined(BC_ENCODER_SSE2)
+		// Two texels per register as 16-bit lanes; madd squares and sums channel pairs.
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i channelMask = useAlpha ? _mm_set1_epi32(-1) : _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+
+		__m128i lo[4];
+		__m128i hi[4];
+		__m128i bestError[4];
+		__m128i bestIndex[4];
+		for (uint32 i = 0; i < 4; i++)
+		{
+			__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + i * 16));
+			lo[i] = _mm_and_si128(_mm_unpacklo_epi8(pixels, zero), channelMask);
+			hi[i] = _mm_and_si128(_mm_unpackhi_epi8(pixels, zero), channelMask);
+			bestError[i] = _mm_set1_epi32(0x7fffffff);
+			bestIndex[i] = zero;
+		}
+
+		for (uint32 entry = 0; entry < paletteCount; entry++)
+		{
+			const uint8* color = palette + entry * 4;
+			__m128i entryColor = _mm_and_si128(_mm_set_epi16(color[3], color[2], color[1], color[0], color[3], color[2], color[1], color[0]), channelMask);
+			__m128i entryIndex = _mm_set1_epi32(static_cast<int32>(entry));
+
+			for (uint32 i = 0; i < 4; i++)
+			{
+				__m128i deltaLo = _mm_sub_epi16(lo[i], entryColor);
+				__m128i deltaHi = _mm_sub_epi16(hi[i], entryColor);
+				__m128 sumsLo = _mm_castsi128_ps(_mm_madd_epi16(deltaLo, deltaLo));
+				__m128 sumsHi = _mm_castsi128_ps(_mm_madd_epi16(deltaHi, deltaHi));
+
+				__m128i even = _mm_castps_si128(_mm_shuffle_ps(sumsLo, sumsHi, _MM_SHUFFLE(2, 0, 2, 0)));
+				__m128i odd = _mm_castps_si128(_mm_shuffle_ps(sumsLo, sumsHi, _MM_SHUFFLE(3, 1, 3, 1)));
+				__m128i error = _mm_add_epi32(even, odd);
+
+				__m128i better = _mm_cmplt_epi32(error, bestError[i]);
+				bestError[i] = _mm_or_si128(_mm_and_si128(better, error), _mm_andnot_si128(better, bestError[i]));
+				bestIndex[i] = _mm_or_si128(_mm_and_si128(better, entryIndex), _mm_andnot_si128(better, bestIndex[i]));
+			}
+		}
+
+		for (uint32 i = 0; i < 4; i++)
+		{
+			uint32 errors[4];
+			uint32 indices[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(errors), bestError[i]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(indices), bestIndex[i]);
+			for (uint32 j = 0; j < 4; j++)
+			{
+				outIndices[i * 4 + j] = static_cast<uint8>(indices[j]);
+				outErrors[i * 4 + j] = errors[j];
+			}
+		}
+#else
+		uint32 channelsCount = useAlpha ? 4 : 3;
+		for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+		{
+			const uint8* texel = texels + i * 4;
+			uint32 bestError = 0xffffffff;
+			uint8 bestIndex = 0;
+			for (uint32 entry = 0; entry < paletteCount; entry++)
+			{
+				uint32 error = 0;
+				for (uint32 c = 0; c < channelsCount; c++)
+				{
+					int32 delta = static_cast<int32>(texel[c]) - palette[entry * 4 + c];
+					error += static_cast<uint32>(delta * delta);
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					bestIndex = static_cast<uint8>(entry);
+				}
+			}
+			outIndices[i] = bestIndex;
+			outErrors[i] = bestError;
+		}
+#endif
+	}
+
+	/*
+	============
+	Endpoint fitting
+	============
+	*/
+
+	// Bounding box inset by 1/16 of its size, with the diagonal flipped on
+	// channels that run against the widest one.
+	static void FitBoundingBox(const float (*points)[4], uint32 pointsCount, uint32 channelsCount, float* outE0, float* outE1)
+	{
+		float minValues[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+		float maxValues[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float mean[4] = {};
+		for (uint32 i = 0; i < pointsCount; i++)
+		{
+			for (uint32 c = 0; c < channelsCount; c++)
+			{
+				minValues[c] = points[i][c] < minValues[c] ? points[i][c] : minValues[c];
+				maxValues[c] = points[i][c] > maxValues[c] ? points[i][c] : maxValues[c];
+				mean[c] += points[i][c];
+			}
+		}
+
+		uint32 widest = 0;
+		for (uint32 c = 0; c < channelsCount; c++)
+		{
+			mean[c] /= static_cast<float>(pointsCount);
+			if (maxValues[c] - minValues[c] > maxValues[widest] - minValues[widest])
+				widest = c;
+		}
+
+		for (uint32 c = 0; c < channelsCount; c++)
+		{
+			float inset = (maxValues[c] - minValues[c]) / 16.0f;
+			outE0[c] = minValues[c] + inset;
+			outE1[c] = maxValues[c] - inset;
+		}
+
+		for (uint32 c = 0; c < channelsCount; c++)
+		{
+			float covariance = 0.0f;
+			for (uint32 i = 0; i < pointsCount; i++)
+			{
+				covariance += (points[i][c] - mean[c]) * (points[i][widest] - mean[widest]);
+			}
+			if (covariance < 0.0f)
+			{
+				float temp = outE0[c];
+				outE0[c] = outE1[c];
+				outE1[c] = temp;
+			}
+		}
+	}
+
+	// Extremes of the points projected on their principal axis, found by power
+	// iteration.
+	static void FitPrincipalAxis(const float (*points)[4], uint32 pointsCount, uint32 channelsCount, float* outE0, float* outE1)
+	{
+		float mean[4] = {};
+		for (uint32 i = 0; i < pointsCount; i++)
+		{
+			for (uint32 c = 0; c < channelsCount; c++)
+			{
+				mean[c] += points[i][c];
+			}
+		}
+		for (uint32 c = 0; c < channelsCount; c++)
+		{
+			mean[c] /= static_cast<float>(pointsCount);
+		}
+
+		float covariance[4][4] = {};
+		for (uint32 i = 0; i < pointsCount; i++)
+		{
+			for (uint32 r = 0; r < channelsCount; r++)
+			{
+				for (uint32 c = r; c < channelsCount; c++)
+				{
+					covariance[r][c] += (points[i][r] - mean[r]) * (points[i][c] - mean[c]);
+				}
+			}
+		}
+		for (uint32 r = 0; r < channelsCount; r++)
+		{
+			for (uint32 c = 0; c < r; c++)
+			{
+				covariance[r][c] = covariance[c][r];
+			}
+		}
+
+		// Start from the bounding box diagonal; it is usually close already.
+		float axis[4] = {};
+		FitBoundingBox(points, pointsCount, channelsCount, outE0, outE1);
+		for (uint32 c = 0; c < channelsCount; c++)
+		{
+			axis[c] = outE1[c] - outE0[c];
+		}
+
+		for (uint32 iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {};
+			float largest = 0.0f;
+			for (uint32 r = 0; r < channelsCount; r++)
+			{
+				for (uint32 c = 0; c < channelsCount; c++)
+				{
+					next[r] += covariance[r][c] * axis[c];
+				}
+				largest = fabsf(next[r]) > largest ? fabsf(next[r]) : largest;
+			}
+
+			// A flat block has no principal axis; keep the bounding box.
+			if (largest < 1e-6f)
+				return;
+
+			for (uint32 c = 0; c < channelsCount; c++)
+			{
+				axis[c] = next[c] / largest;
+			}
+		}
+
+		float lengthSquared = 0.0f;
+		for (uint32 c = 0; c < channelsCount; c++)
+		{
+			lengthSquared += axis[c] * axis[c];
+		}
+
+		float minT = 1e30f;
+		float maxT = -1e30f;
+		for (uint32 i = 0; i < pointsCount; i++)
+		{
+			float t = 0.0f;
+			for (uint32 c = 0; c < channelsCount; c++)
+			{
+				t += (points[i][c] - mean[c]) * axis[c];
+			}
+			t /= lengthSquared;
+			minT = t < minT ? t : minT;
+			maxT = t > maxT ? t : maxT;
+		}
+
+		// Same inset as the bounding box: the extremes rarely land on a palette entry.
+		float inset = (maxT - minT) / 16.0f;
+		minT += inset;
+		maxT -= inset;
+
+		for (uint32 c = 0; c < channelsCount; c++)
+		{
+			outE0[c] = Clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+			outE1[c] = Clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+		}
+	}
+
+	// Endpoints minimizing the squared error for fixed interpolation weights.
+	// Returns false when every point uses the same weight.
+	static bool RefineEndpoints(const float (*points)[4], const float* weights, uint32 pointsCount, uint32 channelsCount, float* outE0, float* outE1)
+	{
+		float a = 0.0f;
+		float b = 0.0f;
+		float c = 0.0f;
+		float x0[4] = {};
+		float x1[4] = {};
+		for (uint32 i = 0; i < pointsCount; i++)
+		{
+			float t = weights[i];
+			float s = 1.0f - t;
+			a += s * s;
+			b += s * t;
+			c += t * t;
+			for (uint32 ch = 0; ch < channelsCount; ch++)
+			{
+				x0[ch] += s * points[i][ch];
+				x1[ch] += t * points[i][ch];
+			}
+		}
+
+		float determinant = a * c - b * b;
+		if (fabsf(determinant) < 1e-6f)
+			return false;
+
+		for (uint32 ch = 0; ch < channelsCount; ch++)
+		{
+			outE0[ch] = Clamp((c * x0[ch] - b * x1[ch]) / determinant, 0.0f, 255.0f);
+			outE1[ch] = Clamp((a * x1[ch] - b * x0[ch]) / determinant, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	// FAST starts from the bounding box only. Higher qualities also start from
+	// the principal axis and keep whichever start ends with the lower error;
+	// on smooth blocks the inset box often quantizes better.
+	static uint32 GetFitsCount(BC_QUALITY quality)
+	{
+		return quality == BC_QUALITY_FAST ? 1 : 2;
+	}
+
+	static void FitEndpoints(const float (*points)[4], uint32 pointsCount, uint32 channelsCount, uint32 fit, float* outE0, float* outE1)
+	{
+		if (fit == 0)
+			FitBoundingBox(points, pointsCount, channelsCount, outE0, outE1);
+		else
+			FitPrincipalAxis(points, pointsCount, channelsCount, outE0, outE1);
+	}
+
+	static uint32 GetRefineIterations(BC_QUALITY quality)
+	{
+		switch (quality)
+		{
+		case BC_QUALITY_FAST: return 0;
+		case BC_QUALITY_NORMAL: return 1;
+		default: return 3;
+		}
+	}
+
+	/*
+	============
+	BC1
+	============
+	*/
+
+	static uint16 Pack565(const float* color)
+	{
+		uint32 r = static_cast<uint32>(color[0] * 31.0f / 255.0f + 0.5f);
+		uint32 g = static_cast<uint32>(color[1] * 63.0f / 255.0f + 0.5f);
+		uint32 b = static_cast<uint32>(color[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16>((r << 11) | (g << 5) | b);
+	}
+
+	static void Unpack565(uint16 packed, uint8* outColor)
+	{
+		uint32 r = (packed >> 11) & 0x1f;
+		uint32 g = (packed >> 5) & 0x3f;
+		uint32 b = packed & 0x1f;
+		outColor[0] = static_cast<uint8>((r << 3) | (r >> 2));
+		outColor[1] = static_cast<uint8>((g << 2) | (g >> 4));
+		outColor[2] = static_cast<uint8>((b << 3) | (b >> 2));
+		outColor[3] = 255;
+	}
+
+	// Palette as the decoder builds it: four colors when c0 > c1, otherwise
+	// three and transparent black. BC3 always uses four.
+	static void BuildBC1Palette(uint16 c0, uint16 c1, bool fourColors, uint8* outPalette)
+	{
+		Unpack565(c0, outPalette);
+		Unpack565(c1, outPalette + 4);
+		for (uint32 c = 0; c < 3; c++)
+		{
+			uint32 v0 = outPalette[c];
+			uint32 v1 = outPalette[4 + c];
+			if (fourColors)
+			{
+				outPalette[8 + c] = static_cast<uint8>((2 * v0 + v1) / 3);
+				outPalette[12 + c] = static_cast<uint8>((v0 + 2 * v1) / 3);
+			}
+			else
+			{
+				outPalette[8 + c] = static_cast<uint8>((v0 + v1) / 2);
+				outPalette[12 + c] = 0;
+			}
+		}
+		outPalette[11] = 255;
+		outPalette[15] = fourColors ? 255 : 0;
+	}
+
+	static void WriteBC1Block(uint16 c0, uint16 c1, const uint8* indices, uint8* outBlock)
+	{
+		uint32 bits = 0;
+		for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+		{
+			bits |= static_cast<uint32>(indices[i]) << (i * 2);
+		}
+
+		outBlock[0] = static_cast<uint8>(c0);
+		outBlock[1] = static_cast<uint8>(c0 >> 8);
+		outBlock[2] = static_cast<uint8>(c1);
+		outBlock[3] = static_cast<uint8>(c1 >> 8);
+		::memcpy(outBlock + 4, &bits, sizeof(bits));
+	}
+
+	static void EncodeColorBlock(const uint8* texels, BC_QUALITY quality, bool allowTransparent, uint8* outBlock)
+	{
+		float points[BLOCK_TEXELS][4] = {};
+		uint32 pointsCount = 0;
+		bool transparent[BLOCK_TEXELS] = {};
+		bool threeColors = false;
+
+		for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+		{
+			const uint8* texel = texels + i * 4;
+			if (allowTransparent && texel[3] < 128)
+			{
+				transparent[i] = true;
+				threeColors = true;
+				continue;
+			}
+			points[pointsCount][0] = texel[0];
+			points[pointsCount][1] = texel[1];
+			points[pointsCount][2] = texel[2];
+			pointsCount++;
+		}
+
+		if (pointsCount == 0)
+		{
+			uint8 indices[BLOCK_TEXELS];
+			::memset(indices, 3, sizeof(indices));
+			WriteBC1Block(0, 0, indices, outBlock);
+			return;
+		}
+
+		uint16 bestC0 = 0;
+		uint16 bestC1 = 0;
+		uint8 bestIndices[BLOCK_TEXELS] = {};
+		uint32 bestError = 0xffffffff;
+
+		uint32 fitsCount = GetFitsCount(quality);
+		uint32 iterations = GetRefineIterations(quality);
+		for (uint32 fit = 0; fit < fitsCount && bestError != 0; fit++)
+		{
+			float e0[4] = {};
+			float e1[4] = {};
+			FitEndpoints(points, pointsCount, 3, fit, e0, e1);
+
+			for (uint32 iteration = 0; iteration <= iterations; iteration++)
+			{
+				uint16 c0 = Pack565(e0);
+				uint16 c1 = Pack565(e1);
+
+				// The endpoint order selects the mode.
+				if ((threeColors && c0 > c1) || (!threeColors && c0 < c1))
+				{
+					uint16 temp = c0;
+					c0 = c1;
+					c1 = temp;
+				}
+
+				uint8 palette[16];
+				BuildBC1Palette(c0, c1, !threeColors, palette);
+
+				uint8 indices[BLOCK_TEXELS];
+				uint32 errors[BLOCK_TEXELS];
+				FindClosest(texels, palette, threeColors ? 3 : 4, false, indices, errors);
+
+				uint32 error = 0;
+				for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+				{
+					if (transparent[i])
+						indices[i] = 3;
+					else
+						error += errors[i];
+				}
+
+				if (error < bestError)
+				{
+					bestError = error;
+					bestC0 = c0;
+					bestC1 = c1;
+					::memcpy(bestIndices, indices, sizeof(indices));
+				}
+
+				if (iteration == iterations || bestError == 0)
+					break;
+
+				// Refit to the weights the chosen indices imply, from the decoded endpoints.
+				float weights[BLOCK_TEXELS];
+				uint32 point = 0;
+				for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+				{
+					if (!transparent[i])
+						weights[point++] = threeColors ? s_BC1Weights3[indices[i]] : s_BC1Weights4[indices[i]];
+				}
+
+				float refinedE0[4] = {};
+				float refinedE1[4] = {};
+				if (!RefineEndpoints(points, weights, pointsCount, 3, refinedE0, refinedE1))
+					break;
+
+				// The weights refer to (c0, c1) after the mode swap, so e0 and e1 follow that order.
+				::memcpy(e0, refinedE0, sizeof(e0));
+				::memcpy(e1, refinedE1, sizeof(e1));
+			}
+		}
+
+		WriteBC1Block(bestC0, bestC1, bestIndices, outBlock);
+	}
+
+	/*
+	============
+	BC3 alpha
+	============
+	*/
+
+	static void BuildAlphaPalette(uint8 a0, uint8 a1, uint8* outPalette)
+	{
+		outPalette[0] = a0;
+		outPalette[1] = a1;
+		if (a0 > a1)
+		{
+			for (uint32 i = 1; i < 7; i++)
+			{
+				outPalette[i + 1] = static_cast<uint8>(((7 - i) * a0 + i * a1 + 3) / 7);
+			}
+		}
+		else
+		{
+			for (uint32 i = 1; i < 5; i++)
+			{
+				outPalette[i + 1] = static_cast<uint8>(((5 - i) * a0 + i * a1 + 2) / 5);
+			}
+			outPalette[6] = 0;
+			outPalette[7] = 255;
+		}
+	}
+
+	static uint32 ChooseAlphaIndices(const uint8* texels, const uint8* palette, uint8* outIndices)
+	{
+		uint32 totalError = 0;
+		for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+		{
+			int32 alpha = texels[i * 4 + 3];
+			uint32 bestError = 0xffffffff;
+			for (uint32 entry = 0; entry < 8; entry++)
+			{
+				int32 delta = alpha - palette[entry];
+				uint32 error = static_cast<uint32>(delta * delta);
+				if (error < bestError)
+				{
+					bestError = error;
+					outIndices[i] = static_cast<uint8>(entry);
+				}
+			}
+			totalError += bestError;
+		}
+		return totalError;
+	}
+
+	static void EncodeAlphaBlock(const uint8* texels, BC_QUALITY quality, uint8* outBlock)
+	{
+		uint8 minAlpha = 255;
+		uint8 maxAlpha = 0;
+		uint8 innerMin = 255;
+		uint8 innerMax = 0;
+		for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+		{
+			uint8 alpha = texels[i * 4 + 3];
+			minAlpha = alpha < minAlpha ? alpha : minAlpha;
+			maxAlpha = alpha > maxAlpha ? alpha : maxAlpha;
+			if (alpha != 0 && alpha != 255)
+			{
+				innerMin = alpha < innerMin ? alpha : innerMin;
+				innerMax = alpha > innerMax ? alpha : innerMax;
+			}
+		}
+
+		// Eight interpolated values between the extremes.
+		uint8 a0 = maxAlpha;
+		uint8 a1 = minAlpha;
+		uint8 palette[8];
+		uint8 indices[BLOCK_TEXELS] = {};
+		BuildAlphaPalette(a0, a1, palette);
+		uint32 error = ChooseAlphaIndices(texels, palette, indices);
+
+		// Six between the inner values, with exact 0 and 255 on the side:
+		// better when a few texels sit at the extremes, as in cutout masks.
+		if (quality != BC_QUALITY_FAST && error && (minAlpha == 0 || maxAlpha == 255))
+		{
+			uint8 b0 = innerMin <= innerMax ? innerMin : 0;
+			uint8 b1 = innerMin <= innerMax ? innerMax : 0;
+			uint8 sixPalette[8];
+			uint8 sixIndices[BLOCK_TEXELS] = {};
+			BuildAlphaPalette(b0, b1, sixPalette);
+			uint32 sixError = ChooseAlphaIndices(texels, sixPalette, sixIndices);
+			if (sixError < error)
+			{
+				a0 = b0;
+				a1 = b1;
+				::memcpy(indices, sixIndices, sizeof(indices));
+			}
+		}
+
+		::memset(outBlock, 0, 8);
+		outBlock[0] = a0;
+		outBlock[1] = a1;
+		BitWriter writer;
+		writer.data = outBlock + 2;
+		for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+		{
+			writer.Write(indices[i], 3);
+		}
+	}
+
+	/*
+	============
+	BC7
+	============
+	*/
+
+	// Quantizes an endpoint to 7 bits per channel plus a shared p-bit.
+	static void QuantizeBC7Endpoint(const float* endpoint, uint32 pBit, uint8* outColor)
+	{
+		for (uint32 c = 0; c < 4; c++)
+		{
+			float value = (endpoint[c] - static_cast<float>(pBit)) / 2.0f + 0.5f;
+			uint32 quantized = static_cast<uint32>(Clamp(value, 0.0f, 127.0f));
+			outColor[c] = static_cast<uint8>((quantized << 1) | pBit);
+		}
+	}
+
+	static uint32 ChooseBC7PBit(const float* endpoint)
+	{
+		float bestError = 1e30f;
+		uint32 bestPBit = 0;
+		for (uint32 pBit = 0; pBit < 2; pBit++)
+		{
+			uint8 color[4];
+			QuantizeBC7Endpoint(endpoint, pBit, color);
+			float error = 0.0f;
+			for (uint32 c = 0; c < 4; c++)
+			{
+				float delta = color[c] - endpoint[c];
+				error += delta * delta;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				bestPBit = pBit;
+			}
+		}
+		return bestPBit;
+	}
+
+	static void BuildBC7Palette(const uint8* color0, const uint8* color1, uint8* outPalette)
+	{
+		for (uint32 i = 0; i < 16; i++)
+		{
+			uint32 weight = s_BC7Weights4[i];
+			for (uint32 c = 0; c < 4; c++)
+			{
+				outPalette[i * 4 + c] = static_cast<uint8>(((64 - weight) * color0[c] + weight * color1[c] + 32) >> 6);
+			}
+		}
+	}
+
+	void EncodeBlockBC7(const uint8* texels, BC_QUALITY quality, uint8* outBlock)
+	{
+		float points[BLOCK_TEXELS][4];
+		for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+		{
+			for (uint32 c = 0; c < 4; c++)
+			{
+				points[i][c] = texels[i * 4 + c];
+			}
+		}
+
+		uint8 bestColor0[4] = {};
+		uint8 bestColor1[4] = {};
+		uint8 bestIndices[BLOCK_TEXELS] = {};
+		uint32 bestError = 0xffffffff;
+
+		uint32 fitsCount = GetFitsCount(quality);
+		uint32 iterations = GetRefineIterations(quality);
+		for (uint32 fit = 0; fit < fitsCount && bestError != 0; fit++)
+		{
+			float e0[4] = {};
+			float e1[4] = {};
+			FitEndpoints(points, BLOCK_TEXELS, 4, fit, e0, e1);
+
+			for (uint32 iteration = 0; iteration <= iterations; iteration++)
+			{
+				// Each endpoint picks its p-bit on its own, except at HIGH where all four pairs are tried.
+				uint32 pBits0[4] = { ChooseBC7PBit(e0) };
+				uint32 pBits1[4] = { ChooseBC7PBit(e1) };
+				uint32 candidatesCount = 1;
+				if (quality == BC_QUALITY_HIGH)
+				{
+					for (uint32 i = 0; i < 4; i++)
+					{
+						pBits0[i] = i & 1;
+						pBits1[i] = i >> 1;
+					}
+					candidatesCount = 4;
+				}
+
+				// Refine from this start's own best indices, not the best over every start.
+				uint8 refitIndices[BLOCK_TEXELS] = {};
+				uint32 refitError = 0xffffffff;
+
+				for (uint32 candidate = 0; candidate < candidatesCount; candidate++)
+				{
+					uint8 color0[4];
+					uint8 color1[4];
+					QuantizeBC7Endpoint(e0, pBits0[candidate], color0);
+					QuantizeBC7Endpoint(e1, pBits1[candidate], color1);
+
+					uint8 palette[16 * 4];
+					BuildBC7Palette(color0, color1, palette);
+
+					uint8 candidateIndices[BLOCK_TEXELS];
+					uint32 errors[BLOCK_TEXELS];
+					FindClosest(texels, palette, 16, true, candidateIndices, errors);
+
+					uint32 error = 0;
+					for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+					{
+						error += errors[i];
+					}
+
+					if (error < refitError)
+					{
+						refitError = error;
+						::memcpy(refitIndices, candidateIndices, sizeof(candidateIndices));
+					}
+
+					if (error < bestError)
+					{
+						bestError = error;
+						::memcpy(bestColor0, color0, sizeof(color0));
+						::memcpy(bestColor1, color1, sizeof(color1));
+						::memcpy(bestIndices, candidateIndices, sizeof(candidateIndices));
+					}
+				}
+
+				if (iteration == iterations || bestError == 0)
+					break;
+
+				float weights[BLOCK_TEXELS];
+				for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+				{
+					weights[i] = s_BC7Weights4[refitIndices[i]] / 64.0f;
+				}
+				if (!RefineEndpoints(points, weights, BLOCK_TEXELS, 4, e0, e1))
+					break;
+			}
+		}
+
+		// The first index drops its top bit, so it must be below 8; swap the
+		// endpoints and mirror the indices if it is not.
+		if (bestIndices[0] & 8)
+		{
+			for (uint32 c = 0; c < 4; c++)
+			{
+				uint8 temp = bestColor0[c];
+				bestColor0[c] = bestColor1[c];
+				bestColor1[c] = temp;
+			}
+			for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+			{
+				bestIndices[i] = static_cast<uint8>(15 - bestIndices[i]);
+			}
+		}
+
+		::memset(outBlock, 0, 16);
+		BitWriter writer;
+		writer.data = outBlock;
+		writer.Write(1u << 6, 7);
+		for (uint32 c = 0; c < 4; c++)
+		{
+			writer.Write(bestColor0[c] >> 1, 7);
+			writer.Write(bestColor1[c] >> 1, 7);
+		}
+		writer.Write(bestColor0[0] & 1, 1);
+		writer.Write(bestColor1[0] & 1, 1);
+		for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+		{
+			writer.Write(bestIndices[i], i == 0 ? BC7_MODE6_INDEX_BITS - 1 : BC7_MODE6_INDEX_BITS);
+		}
+	}
+
+	bool DecodeBlockBC7(const uint8* block, uint8* outTexels)
+	{
+		BitReader reader;
+		reader.data = block;
+		if (reader.Read(7) != (1u << 6))
+			return false;
+
+		uint8 color0[4];
+		uint8 color1[4];
+		for (uint32 c = 0; c < 4; c++)
+		{
+			color0[c] = static_cast<uint8>(reader.Read(7) << 1);
+			color1[c] = static_cast<uint8>(reader.Read(7) << 1);
+		}
+
+		uint32 pBit0 = reader.Read(1);
+		uint32 pBit1 = reader.Read(1);
+		for (uint32 c = 0; c < 4; c++)
+		{
+			color0[c] |= pBit0;
+			color1[c] |= pBit1;
+		}
+
+		uint8 palette[16 * 4];
+		BuildBC7Palette(color0, color1, palette);
+		for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+		{
+			uint32 index = reader.Read(i == 0 ? BC7_MODE6_INDEX_BITS - 1 : BC7_MODE6_INDEX_BITS);
+			::memcpy(outTexels + i * 4, palette + index * 4, 4);
+		}
+		return true;
+	}
+
+	void EncodeBlockBC1(const uint8* texels, BC_QUALITY quality, uint8* outBlock)
+	{
+		EncodeColorBlock(texels, quality, true, outBlock);
+	}
+
+	void EncodeBlockBC3(const uint8* texels, BC_QUALITY quality, uint8* outBlock)
+	{
+		EncodeAlphaBlock(texels, quality, outBlock);
+		EncodeColorBlock(texels, quality, false, outBlock + 8);
+	}
+
+	void DecodeBlockBC1(const uint8* block, uint8* outTexels)
+	{
+		uint16 c0 = static_cast<uint16>(block[0] | (block[1] << 8));
+		uint16 c1 = static_cast<uint16>(block[2] | (block[3] << 8));
+		uint32 bits = 0;
+		::memcpy(&bits, block + 4, sizeof(bits));
+
+		uint8 palette[16];
+		BuildBC1Palette(c0, c1, c0 > c1, palette);
+		for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+		{
+			::memcpy(outTexels + i * 4, palette + ((bits >> (i * 2)) & 3) * 4, 4);
+		}
+	}
+
+	void DecodeBlockBC3(const uint8* block, uint8* outTexels)
+	{
+		uint16 c0 = static_cast<uint16>(block[8] | (block[9] << 8));
+		uint16 c1 = static_cast<uint16>(block[10] | (block[11] << 8));
+		uint32 bits = 0;
+		::memcpy(&bits, block + 12, sizeof(bits));
+
+		uint8 palette[16];
+		BuildBC1Palette(c0, c1, true, palette);
+
+		uint8 alphaPalette[8];
+		BuildAlphaPalette(block[0], block[1], alphaPalette);
+		BitReader reader;
+		reader.data = block + 2;
+
+		for (uint32 i = 0; i < BLOCK_TEXELS; i++)
+		{
+			::memcpy(outTexels + i * 4, palette + ((bits >> (i * 2)) & 3) * 4, 3);
+			outTexels[i * 4 + 3] = alphaPalette[reader.Read(3)];
+		}
+	}
+
+	bool IsSupported(DDS_FORMAT format)
+	{
+		switch (format)
+		{
+		case DDS_FORMAT_BC1_UNORM:
+		case DDS_FORMAT_BC1_UNORM_SRGB:
+		case DDS_FORMAT_BC3_UNORM:
+		case DDS_FORMAT_BC3_UNORM_SRGB:
+		case DDS_FORMAT_BC7_UNORM:
+		case DDS_FORMAT_BC7_UNORM_SRGB:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	static uint32 GetBlockSize(DDS_FORMAT format)
+	{
+		return format == DDS_FORMAT_BC1_UNORM || format == DDS_FORMAT_BC1_UNORM_SRGB ? BC1_BLOCK_SIZE : 2 * BC1_BLOCK_SIZE;
+	}
+
+	bool Compress(const uint8* pixels, uint32 width, uint32 height, DDS_FORMAT format, BC_QUALITY quality, uint32 threadsCount, uint8* outBlocks)
+	{
+		if (!IsSupported(format) || width == 0 || height == 0)
+			return false;
+
+		uint32 blocksWide = (width + 3) / 4;
+		uint32 blocksHigh = (height + 3) / 4;
+		uint32 blockSize = GetBlockSize(format);
+
+		auto encodeRow = [&](uint32 blockY)
+		{
+			uint8 texels[BLOCK_TEXELS * 4];
+			for (uint32 blockX = 0; blockX < blocksWide; blockX++)
+			{
+				for (uint32 y = 0; y < 4; y++)
+				{
+					uint32 srcY = blockY * 4 + y < height ? blockY * 4 + y : height - 1;
+					for (uint32 x = 0; x < 4; x++)
+					{
+						uint32 srcX = blockX * 4 + x < width ? blockX * 4 + x : width - 1;
+						::memcpy(texels + (y * 4 + x) * 4, pixels + (static_cast<uint64>(srcY) * width + srcX) * 4, 4);
+					}
+				}
+
+				uint8* block = outBlocks + (static_cast<uint64>(blockY) * blocksWide + blockX) * blockSize;
+				switch (format)
+				{
+				case DDS_FORMAT_BC1_UNORM:
+				case DDS_FORMAT_BC1_UNORM_SRGB:
+					EncodeBlockBC1(texels, quality, block);
+					break;
+				case DDS_FORMAT_BC3_UNORM:
+				case DDS_FORMAT_BC3_UNORM_SRGB:
+					EncodeBlockBC3(texels, quality, block);
+					break;
+				default:
+					EncodeBlockBC7(texels, quality, block);
+					break;
+				}
+			}
+		};
+
+		if (threadsCount == 0)
+			threadsCount = Platform::GetHardwareThreadsCount();
+		if (threadsCount > blocksHigh)
+			threadsCount = blocksHigh;
+
+		// Rows take the same time on average, so workers just pull the next one.
+		std::atomic<uint32> nextRow(0);
+		auto worker = [&]()
+		{
+			for (uint32 row = nextRow.fetch_add(1); row < blocksHigh; row = nextRow.fetch_add(1))
+			{
+				encodeRow(row);
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (uint32 i = 1; i < threadsCount; i++)
+		{
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		return true;
+	}
+
+	bool Decompress(const uint8* blocks, uint32 width, uint32 height, DDS_FORMAT format, uint8* outPixels)
+	{
+		if (!IsSupported(format))
+			return false;
+
+		uint32 blocksWide = (width + 3) / 4;
+		uint32 blocksHigh = (height + 3) / 4;
+		uint32 blockSize = GetBlockSize(format);
+
+		for (uint32 blockY = 0; blockY < blocksHigh; blockY++)
+		{
+			for (uint32 blockX = 0; blockX < blocksWide; blockX++)
+			{
+				const uint8* block = blocks + (static_cast<uint64>(blockY) * blocksWide + blockX) * blockSize;
+				uint8 texels[BLOCK_TEXELS * 4];
+				switch (format)
+				{
+				case DDS_FORMAT_BC1_UNORM:
+				case DDS_FORMAT_BC1_UNORM_SRGB:
+					DecodeBlockBC1(block, texels);
+					break;
+				case DDS_FORMAT_BC3_UNORM:
+				case DDS_FORMAT_BC3_UNORM_SRGB:
+					DecodeBlockBC3(block, texels);
+					break;
+				default:
+					if (!DecodeBlockBC7(block, texels))
+						return false;
+					break;
+				}
+
+				for (uint32 y = 0; y < 4 && blockY * 4 + y < height; y++)
+				{
+					for (uint32 x = 0; x < 4 && blockX * 4 + x < width; x++)
+					{
+						uint64 dst = (static_cast<uint64>(blockY * 4 + y) * width + blockX * 4 + x) * 4;
+						::memcpy(outPixels + dst, texels + (y * 4 + x) * 4, 4);
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	float ComputePsnr(const uint8* reference, const uint8* pixels, uint32 width, uint32 height, bool includeAlpha)
+	{
+		uint32 channelsCount = includeAlpha ? 4 : 3;
+		uint64 pixelsCount = static_cast<uint64>(width) * height;
+
+		double squaredError = 0.0;
+		for (uint64 i = 0; i < pixelsCount; i++)
+		{
+			for (uint32 c = 0; c < channelsCount; c++)
+			{
+				double delta = static_cast<double>(reference[i * 4 + c]) - pixels[i * 4 + c];
+				squaredError += delta * delta;
+			}
+		}
+
+		double meanSquaredError = squaredError / static_cast<double>(pixelsCount * channelsCount);
+		if (meanSquaredError <= 0.0)
+			return INFINITY;
+
+		return static_cast<float>(10.0 * log10(255.0 * 255.0 / meanSquaredError));
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Types.h"
+#include "DDSFile.h"
+
+/*
+============
+BC Encoder
+============
+*/
+
+// FAST fits endpoints to the block's bounding box; NORMAL also tries the
+// principal axis and refines once by least squares; HIGH refines further and
+// searches the BC7 p-bits and the BC3 six-alpha mode exhaustively.
+enum BC_QUALITY
+{
+	BC_QUALITY_FAST,
+	BC_QUALITY_NORMAL,
+	BC_QUALITY_HIGH,
+};
+
+namespace BCEncoder
+{
+	// texels are a 4x4 block of RGBA8, row by row.
+	// BC1 switches to its three color + transparent mode when some alpha is below 128.
+	void EncodeBlockBC1(const uint8* texels, BC_QUALITY quality, uint8* outBlock);
+	void EncodeBlockBC3(const uint8* texels, BC_QUALITY quality, uint8* outBlock);
+	// Mode 6 only: one RGBA subset with 4-bit indices, which suits most albedo and mask textures.
+	void EncodeBlockBC7(const uint8* texels, BC_QUALITY quality, uint8* outBlock);
+
+	void DecodeBlockBC1(const uint8* block, uint8* outTexels);
+	void DecodeBlockBC3(const uint8* block, uint8* outTexels);
+	// Mode 6 only; returns false for blocks in any other mode.
+	bool DecodeBlockBC7(const uint8* block, uint8* outTexels);
+
+	// BC1, BC3 and BC7, linear or sRGB. The sRGB variants store the same bits.
+	bool IsSupported(DDS_FORMAT format);
+
+	// pixels are RGBA8 rows, tightly packed. Partial edge blocks repeat the
+	// last row and column. Rows of blocks are spread over threadsCount
+	// threads; 0 uses every hardware thread. outBlocks holds the mip as laid
+	// out by DDSFile::ComputeMipLayout.
+	bool Compress(const uint8* pixels, uint32 width, uint32 height, DDS_FORMAT format, BC_QUALITY quality, uint32 threadsCount, uint8* outBlocks);
+	bool Decompress(const uint8* blocks, uint32 width, uint32 height, DDS_FORMAT format, uint8* outPixels);
+
+	// Peak signal-to-noise ratio in dB between two RGBA8 images, over RGB or RGBA.
+	float ComputePsnr(const uint8* reference, const uint8* pixels, uint32 width, uint32 height, bool includeAlpha);
+}
@@ -0,0 +1,396 @@
+#include "DDSFile.h"
+#include "Platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+==========
+DDSFile
+==========
+*/
+
+namespace DDSFile
+{
+	const uint32 DDSD_CAPS = 0x1;
+	const uint32 DDSD_HEIGHT = 0x2;
+	const uint32 DDSD_WIDTH = 0x4;
+	const uint32 DDSD_PITCH = 0x8;
+	const uint32 DDSD_PIXELFORMAT = 0x1000;
+	const uint32 DDSD_MIPMAPCOUNT = 0x20000;
+	const uint32 DDSD_LINEARSIZE = 0x80000;
+	const uint32 DDSCAPS_COMPLEX = 0x8;
+	const uint32 DDSCAPS_TEXTURE = 0x1000;
+	const uint32 DDSCAPS_MIPMAP = 0x400000;
+	const uint32 DDPF_FOURCC = 0x4;
+	const uint32 DDPF_RGB = 0x40;
+	const uint32 DDPF_LUMINANCE = 0x20000;
+	const uint32 DDSCAPS2_CUBEMAP = 0x200;
+	const uint32 DDSCAPS2_CUBEMAP_ALLFACES = 0xfc00;
+	const uint32 DDSCAPS2_VOLUME = 0x200000;
+	const uint32 DDS_RESOURCE_DIMENSION_TEXTURE2D = 3;
+	const uint32 DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+	struct DDSPixelFormat
+	{
+		uint32 size;
+		uint32 flags;
+		uint32 fourCC;
+		uint32 rgbBitCount;
+		uint32 rBitMask;
+		uint32 gBitMask;
+		uint32 bBitMask;
+		uint32 aBitMask;
+	};
+
+	struct DDSHeader
+	{
+		uint32 size;
+		uint32 flags;
+		uint32 height;
+		uint32 width;
+		uint32 pitchOrLinearSize;
+		uint32 depth;
+		uint32 mipMapCount;
+		uint32 reserved1[11];
+		DDSPixelFormat pixelFormat;
+		uint32 caps;
+		uint32 caps2;
+		uint32 caps3;
+		uint32 caps4;
+		uint32 reserved2;
+	};
+
+	struct DDSHeaderDXT10
+	{
+		uint32 dxgiFormat;
+		uint32 resourceDimension;
+		uint32 miscFlag;
+		uint32 arraySize;
+		uint32 miscFlags2;
+	};
+
+	static_assert(sizeof(DDSHeader) == 124, "DDS header layout");
+	static_assert(sizeof(DDSHeaderDXT10) == 20, "DDS DX10 header layout");
+
+	static constexpr uint32 MakeFourCC(char a, char b, char c, char d)
+	{
+		return static_cast<uint32>(static_cast<uint8>(a)) | (static_cast<uint32>(static_cast<uint8>(b)) << 8) |
+			(static_cast<uint32>(static_cast<uint8>(c)) << 16) | (static_cast<uint32>(static_cast<uint8>(d)) << 24);
+	}
+
+	static DDS_FORMAT GetLegacyFormat(const DDSPixelFormat& pixelFormat)
+	{
+		if (pixelFormat.flags & DDPF_FOURCC)
+		{
+			switch (pixelFormat.fourCC)
+			{
+			case MakeFourCC('D', 'X', 'T', '1'): return DDS_FORMAT_BC1_UNORM;
+			case MakeFourCC('D', 'X', 'T', '2'):
+			case MakeFourCC('D', 'X', 'T', '3'): return DDS_FORMAT_BC2_UNORM;
+			case MakeFourCC('D', 'X', 'T', '4'):
+			case MakeFourCC('D', 'X', 'T', '5'): return DDS_FORMAT_BC3_UNORM;
+			case MakeFourCC('A', 'T', 'I', '1'):
+			case MakeFourCC('B', 'C', '4', 'U'): return DDS_FORMAT_BC4_UNORM;
+			case MakeFourCC('B', 'C', '4', 'S'): return DDS_FORMAT_BC4_SNORM;
+			case MakeFourCC('A', 'T', 'I', '2'):
+			case MakeFourCC('B', 'C', '5', 'U'): return DDS_FORMAT_BC5_UNORM;
+			case MakeFourCC('B', 'C', '5', 'S'): return DDS_FORMAT_BC5_SNORM;
+			case 113: return DDS_FORMAT_R16G16B16A16_FLOAT;		// D3DFMT_A16B16G16R16F
+			case 116: return DDS_FORMAT_R32G32B32A32_FLOAT;		// D3DFMT_A32B32G32R32F
+			default: return DDS_FORMAT_UNKNOWN;
+			}
+		}
+
+		if ((pixelFormat.flags & DDPF_RGB) && pixelFormat.rgbBitCount == 32)
+		{
+			if (pixelFormat.rBitMask == 0x000000ff && pixelFormat.gBitMask == 0x0000ff00 && pixelFormat.bBitMask == 0x00ff0000)
+				return DDS_FORMAT_R8G8B8A8_UNORM;
+			if (pixelFormat.rBitMask == 0x00ff0000 && pixelFormat.gBitMask == 0x0000ff00 && pixelFormat.bBitMask == 0x000000ff)
+				return pixelFormat.aBitMask ? DDS_FORMAT_B8G8R8A8_UNORM : DDS_FORMAT_B8G8R8X8_UNORM;
+		}
+
+		if ((pixelFormat.flags & DDPF_LUMINANCE) && pixelFormat.rgbBitCount == 8)
+			return DDS_FORMAT_R8_UNORM;
+
+		return DDS_FORMAT_UNKNOWN;
+	}
+
+	bool IsBlockCompressed(DDS_FORMAT format)
+	{
+		switch (format)
+		{
+		case DDS_FORMAT_BC1_UNORM:
+		case DDS_FORMAT_BC1_UNORM_SRGB:
+		case DDS_FORMAT_BC2_UNORM:
+		case DDS_FORMAT_BC2_UNORM_SRGB:
+		case DDS_FORMAT_BC3_UNORM:
+		case DDS_FORMAT_BC3_UNORM_SRGB:
+		case DDS_FORMAT_BC4_UNORM:
+		case DDS_FORMAT_BC4_SNORM:
+		case DDS_FORMAT_BC5_UNORM:
+		case DDS_FORMAT_BC5_SNORM:
+		case DDS_FORMAT_BC6H_UF16:
+		case DDS_FORMAT_BC6H_SF16:
+		case DDS_FORMAT_BC7_UNORM:
+		case DDS_FORMAT_BC7_UNORM_SRGB:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	uint32 GetBitsPerPixel(DDS_FORMAT format)
+	{
+		switch (format)
+		{
+		case DDS_FORMAT_R32G32B32A32_FLOAT: return 128;
+		case DDS_FORMAT_R16G16B16A16_FLOAT: return 64;
+		case DDS_FORMAT_R8G8B8A8_UNORM:
+		case DDS_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DDS_FORMAT_B8G8R8A8_UNORM:
+		case DDS_FORMAT_B8G8R8X8_UNORM:
+		case DDS_FORMAT_B8G8R8A8_UNORM_SRGB: return 32;
+		case DDS_FORMAT_R8G8_UNORM: return 16;
+		case DDS_FORMAT_R8_UNORM: return 8;
+		case DDS_FORMAT_BC1_UNORM:
+		case DDS_FORMAT_BC1_UNORM_SRGB:
+		case DDS_FORMAT_BC4_UNORM:
+		case DDS_FORMAT_BC4_SNORM: return 4;
+		case DDS_FORMAT_BC2_UNORM:
+		case DDS_FORMAT_BC2_UNORM_SRGB:
+		case DDS_FORMAT_BC3_UNORM:
+		case DDS_FORMAT_BC3_UNORM_SRGB:
+		case DDS_FORMAT_BC5_UNORM:
+		case DDS_FORMAT_BC5_SNORM:
+		case DDS_FORMAT_BC6H_UF16:
+		case DDS_FORMAT_BC6H_SF16:
+		case DDS_FORMAT_BC7_UNORM:
+		case DDS_FORMAT_BC7_UNORM_SRGB: return 8;
+		default: return 0;
+		}
+	}
+
+	bool ComputeMipLayout(DDS_FORMAT format, uint32 width, uint32 height, uint32 mip, DDSMipLayout* outLayout)
+	{
+		uint32 bitsPerPixel = GetBitsPerPixel(format);
+		if (bitsPerPixel == 0)
+			return false;
+
+		*outLayout = {};
+		outLayout->width = width >> mip ? width >> mip : 1;
+		outLayout->height = height >> mip ? height >> mip : 1;
+
+		if (IsBlockCompressed(format))
+		{
+			// 4x4 blocks; partial blocks at the edge still take a full block.
+			uint32 blocksWide = (outLayout->width + 3) / 4;
+			uint32 blocksHigh = (outLayout->height + 3) / 4;
+			outLayout->rowPitch = blocksWide * bitsPerPixel * 2;
+			outLayout->rowsCount = blocksHigh;
+		}
+		else
+		{
+			outLayout->rowPitch = (outLayout->width * bitsPerPixel + 7) / 8;
+			outLayout->rowsCount = outLayout->height;
+		}
+
+		outLayout->size = static_cast<uint64>(outLayout->rowPitch) * outLayout->rowsCount;
+		return true;
+	}
+
+	bool InitInfo(DDS_FORMAT format, uint32 width, uint32 height, uint32 mipLevels, DDSTextureInfo* outInfo)
+	{
+		*outInfo = {};
+
+		if (width == 0 || height == 0 || width > DDS_MAX_DIMENSION || height > DDS_MAX_DIMENSION || mipLevels == 0 || mipLevels > DDS_MAX_MIPS)
+			return false;
+
+		outInfo->format = format;
+		outInfo->width = width;
+		outInfo->height = height;
+		outInfo->mipLevels = mipLevels;
+		outInfo->arraySize = 1;
+
+		uint64 sliceSize = 0;
+		for (uint32 mip = 0; mip < mipLevels; mip++)
+		{
+			DDSMipLayout& layout = outInfo->mips[mip];
+			if (!ComputeMipLayout(format, width, height, mip, &layout))
+			{
+				*outInfo = {};
+				return false;
+			}
+			layout.offset = sliceSize;
+			sliceSize += layout.size;
+		}
+		outInfo->sliceSize = sliceSize;
+		return true;
+	}
+
+	bool Parse(const uint8* data, uint64 size, DDSTextureInfo* outInfo)
+	{
+		*outInfo = {};
+
+		if (size < sizeof(uint32) + sizeof(DDSHeader))
+			return false;
+
+		uint32 magic = 0;
+		::memcpy(&magic, data, sizeof(magic));
+
+		DDSHeader header;
+		::memcpy(&header, data + sizeof(uint32), sizeof(header));
+		if (magic != DDS_MAGIC || header.size != sizeof(DDSHeader) || header.pixelFormat.size != sizeof(DDSPixelFormat))
+			return false;
+
+		uint64 dataOffset = sizeof(uint32) + sizeof(DDSHeader);
+		DDS_FORMAT format = DDS_FORMAT_UNKNOWN;
+		uint32 arraySize = 1;
+		bool isCubemap = false;
+
+		if ((header.pixelFormat.flags & DDPF_FOURCC) && header.pixelFormat.fourCC == MakeFourCC('D', 'X', '1', '0'))
+		{
+			if (size < dataOffset + sizeof(DDSHeaderDXT10))
+				return false;
+
+			DDSHeaderDXT10 headerDXT10;
+			::memcpy(&headerDXT10, data + dataOffset, sizeof(headerDXT10));
+			dataOffset += sizeof(DDSHeaderDXT10);
+
+			if (headerDXT10.resourceDimension != DDS_RESOURCE_DIMENSION_TEXTURE2D || headerDXT10.arraySize == 0)
+				return false;
+
+			// Checked before the cube count is multiplied in, so it cannot wrap.
+			format = static_cast<DDS_FORMAT>(headerDXT10.dxgiFormat);
+			isCubemap = (headerDXT10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE) != 0;
+			if (headerDXT10.arraySize > (isCubemap ? DDS_MAX_ARRAY_SIZE / 6 : DDS_MAX_ARRAY_SIZE))
+				return false;
+
+			arraySize = headerDXT10.arraySize * (isCubemap ? 6 : 1);
+		}
+		else
+		{
+			if (header.caps2 & DDSCAPS2_VOLUME)
+				return false;
+
+			format = GetLegacyFormat(header.pixelFormat);
+			if (header.caps2 & DDSCAPS2_CUBEMAP)
+			{
+				// Partial cubemaps cannot be described by a D3D12 texture.
+				if ((header.caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES)
+					return false;
+
+				isCubemap = true;
+				arraySize = 6;
+			}
+		}
+
+		if (GetBitsPerPixel(format) == 0)
+			return false;
+
+		if (header.width == 0 || header.height == 0 || header.width > DDS_MAX_DIMENSION || header.height > DDS_MAX_DIMENSION)
+			return false;
+
+		uint32 mipLevels = (header.flags & DDSD_MIPMAPCOUNT) && header.mipMapCount ? header.mipMapCount : 1;
+
+		uint32 maxMipLevels = 1;
+		for (uint32 dim = header.width > header.height ? header.width : header.height; dim > 1; dim >>= 1)
+		{
+			maxMipLevels++;
+		}
+		if (mipLevels > maxMipLevels || mipLevels > DDS_MAX_MIPS)
+			return false;
+
+		outInfo->format = format;
+		outInfo->width = header.width;
+		outInfo->height = header.height;
+		outInfo->mipLevels = mipLevels;
+		outInfo->arraySize = arraySize;
+		outInfo->isCubemap = isCubemap;
+		outInfo->dataOffset = dataOffset;
+
+		// Slices are stored one after another, each with its full mip chain.
+		uint64 sliceSize = 0;
+		for (uint32 mip = 0; mip < mipLevels; mip++)
+		{
+			DDSMipLayout& layout = outInfo->mips[mip];
+			ComputeMipLayout(format, header.width, header.height, mip, &layout);
+			layout.offset = sliceSize;
+			sliceSize += layout.size;
+		}
+		outInfo->sliceSize = sliceSize;
+
+		// Divided rather than multiplied so a hostile header cannot wrap the sum.
+		if (dataOffset > size || sliceSize > (size - dataOffset) / arraySize)
+		{
+			*outInfo = {};
+			return false;
+		}
+		return true;
+	}
+
+	bool Open(const char* filename, DDSFileView* outView)
+	{
+		*outView = {};
+
+		if (!FileSystem::MapFile(filename, &outView->mapping))
+			return false;
+
+		if (!Parse(outView->mapping.data, outView->mapping.size, &outView->info))
+		{
+			Close(outView);
+			return false;
+		}
+		return true;
+	}
+
+	void Close(DDSFileView* view)
+	{
+		FileSystem::UnmapFile(&view->mapping);
+		*view = {};
+	}
+
+	bool Write(const char* filename, const DDSTextureInfo& info, const uint8* data)
+	{
+		DDSHeader header = {};
+		header.size = sizeof(DDSHeader);
+		header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT;
+		header.flags |= IsBlockCompressed(info.format) ? DDSD_LINEARSIZE : DDSD_PITCH;
+		header.height = info.height;
+		header.width = info.width;
+		header.pitchOrLinearSize = IsBlockCompressed(info.format) ? static_cast<uint32>(info.mips[0].size) : info.mips[0].rowPitch;
+		header.depth = 1;
+		header.mipMapCount = info.mipLevels;
+		header.pixelFormat.size = sizeof(DDSPixelFormat);
+		header.pixelFormat.flags = DDPF_FOURCC;
+		header.pixelFormat.fourCC = MakeFourCC('D', 'X', '1', '0');
+		header.caps = DDSCAPS_TEXTURE | (info.mipLevels > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+		DDSHeaderDXT10 headerDXT10 = {};
+		headerDXT10.dxgiFormat = static_cast<uint32>(info.format);
+		headerDXT10.resourceDimension = DDS_RESOURCE_DIMENSION_TEXTURE2D;
+		headerDXT10.miscFlag = info.isCubemap ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+		headerDXT10.arraySize = info.isCubemap ? info.arraySize / 6 : info.arraySize;
+
+		FILE* file = Platform::OpenFile(filename, "wb");
+		if (file == nullptr)
+			return false;
+
+		uint32 magic = DDS_MAGIC;
+		uint64 dataSize = info.sliceSize * info.arraySize;
+		bool result = fwrite(&magic, sizeof(magic), 1, file) == 1 &&
+			fwrite(&header, sizeof(header), 1, file) == 1 &&
+			fwrite(&headerDXT10, sizeof(headerDXT10), 1, file) == 1 &&
+			fwrite(data, 1, static_cast<size_t>(dataSize), file) == dataSize;
+
+		if (fclose(file) != 0)
+			result = false;
+		return result;
+	}
+
+	const uint8* GetMipData(const DDSFileView& view, uint32 mip, uint32 slice)
+	{
+		const DDSTextureInfo& info = view.info;
+		return view.mapping.data + info.dataOffset + info.sliceSize * slice + info.mips[mip].offset;
+	}
+}
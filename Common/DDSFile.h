@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Types.h"
+#include "FileMapping.h"
+
+/*
+==========
+DDS File
+==========
+*/
+
+const uint32 DDS_MAGIC = 0x20534444;	// 'DDS '
+const uint32 DDS_MAX_MIPS = 16;
+const uint32 DDS_MAX_DIMENSION = 16384;
+const uint32 DDS_MAX_ARRAY_SIZE = 2048;	// D3D12's limit, counting six per cube; fits the uint16 of a resource desc.
+
+// Values match DXGI_FORMAT so the renderer can cast directly; kept separate
+// so the parser does not depend on the D3D headers.
+enum DDS_FORMAT
+{
+	DDS_FORMAT_UNKNOWN = 0,
+	DDS_FORMAT_R32G32B32A32_FLOAT = 2,
+	DDS_FORMAT_R16G16B16A16_FLOAT = 10,
+	DDS_FORMAT_R8G8B8A8_UNORM = 28,
+	DDS_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+	DDS_FORMAT_R8G8_UNORM = 49,
+	DDS_FORMAT_R8_UNORM = 61,
+	DDS_FORMAT_BC1_UNORM = 71,
+	DDS_FORMAT_BC1_UNORM_SRGB = 72,
+	DDS_FORMAT_BC2_UNORM = 74,
+	DDS_FORMAT_BC2_UNORM_SRGB = 75,
+	DDS_FORMAT_BC3_UNORM = 77,
+	DDS_FORMAT_BC3_UNORM_SRGB = 78,
+	DDS_FORMAT_BC4_UNORM = 80,
+	DDS_FORMAT_BC4_SNORM = 81,
+	DDS_FORMAT_BC5_UNORM = 83,
+	DDS_FORMAT_BC5_SNORM = 84,
+	DDS_FORMAT_B8G8R8A8_UNORM = 87,
+	DDS_FORMAT_B8G8R8X8_UNORM = 88,
+	DDS_FORMAT_B8G8R8A8_UNORM_SRGB = 91,
+	DDS_FORMAT_BC6H_UF16 = 95,
+	DDS_FORMAT_BC6H_SF16 = 96,
+	DDS_FORMAT_BC7_UNORM = 98,
+	DDS_FORMAT_BC7_UNORM_SRGB = 99,
+};
+
+// Memory layout of one mip level as stored in the file. Rows are block rows
+// for compressed formats, so rowPitch * rowsCount == size.
+struct DDSMipLayout
+{
+	uint64 offset = 0;		// From the start of the array slice.
+	uint32 width = 0;
+	uint32 height = 0;
+	uint32 rowPitch = 0;
+	uint32 rowsCount = 0;
+	uint64 size = 0;
+};
+
+struct DDSTextureInfo
+{
+	DDS_FORMAT format = DDS_FORMAT_UNKNOWN;
+	uint32 width = 0;
+	uint32 height = 0;
+	uint32 mipLevels = 0;
+	uint32 arraySize = 0;		// Six per cube.
+	bool isCubemap = false;
+
+	uint64 dataOffset = 0;		// First byte of pixel data in the file.
+	uint64 sliceSize = 0;		// All mips of one array slice.
+	DDSMipLayout mips[DDS_MAX_MIPS] = {};
+};
+
+// Pointers into the mapped file, valid until DDSFile::Close.
+struct DDSFileView
+{
+	FileMapping mapping = {};
+	DDSTextureInfo info = {};
+};
+
+/*
+==========
+DDSFile
+==========
+*/
+
+namespace DDSFile
+{
+	bool IsBlockCompressed(DDS_FORMAT format);
+	uint32 GetBitsPerPixel(DDS_FORMAT format);		// Bits per texel, or per block texel for BC formats.
+
+	// Layout math shared with the uploader and the streamer. Returns false for
+	// unsupported formats.
+	bool ComputeMipLayout(DDS_FORMAT format, uint32 width, uint32 height, uint32 mip, DDSMipLayout* outLayout);
+
+	// Describes a single 2D texture built in memory, with its mips packed
+	// back to back from offset 0.
+	bool InitInfo(DDS_FORMAT format, uint32 width, uint32 height, uint32 mipLevels, DDSTextureInfo* outInfo);
+
+	// Validates the header and checks that every subresource lies inside the data.
+	bool Parse(const uint8* data, uint64 size, DDSTextureInfo* outInfo);
+
+	bool Open(const char* filename, DDSFileView* outView);
+	void Close(DDSFileView* view);
+
+	// Always writes the DX10 header extension, so sRGB and BC7 round trip.
+	// data holds every slice with its mip chain, laid out as info describes.
+	bool Write(const char* filename, const DDSTextureInfo& info, const uint8* data);
+
+	// Start of subresource (mip, slice) in the mapped file.
+	const uint8* GetMipData(const DDSFileView& view, uint32 mip, uint32 slice = 0);
+}
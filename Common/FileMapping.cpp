@@ -0,0 +1,121 @@
+#include "FileMapping.h"
+
+#if defined(_WIN32)
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+/*
+============
+File Mapping
+============
+*/
+
+namespace FileSystem
+{
+#if defined(_WIN32)
+	bool MapFile(const char* filename, FileMapping* outMapping)
+	{
+		*outMapping = {};
+
+		HANDLE file = ::CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize = {};
+		if (!::GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			::CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			::CloseHandle(file);
+			return false;
+		}
+
+		void* data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == nullptr)
+		{
+			::CloseHandle(mapping);
+			::CloseHandle(file);
+			return false;
+		}
+
+		outMapping->data = static_cast<const uint8*>(data);
+		outMapping->size = static_cast<uint64>(fileSize.QuadPart);
+		outMapping->fileHandle = file;
+		outMapping->mappingHandle = mapping;
+		return true;
+	}
+
+	void UnmapFile(FileMapping* mapping)
+	{
+		if (mapping->data)
+		{
+			::UnmapViewOfFile(mapping->data);
+			mapping->data = nullptr;
+		}
+
+		if (mapping->mappingHandle)
+		{
+			::CloseHandle(mapping->mappingHandle);
+			mapping->mappingHandle = nullptr;
+		}
+
+		if (mapping->fileHandle)
+		{
+			::CloseHandle(mapping->fileHandle);
+			mapping->fileHandle = nullptr;
+		}
+
+		mapping->size = 0;
+	}
+#else
+	bool MapFile(const char* filename, FileMapping* outMapping)
+	{
+		*outMapping = {};
+
+		int fd = ::open(filename, O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat fileStat = {};
+		if (::fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+		{
+			::close(fd);
+			return false;
+		}
+
+		void* data = ::mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		// The mapping keeps its own reference to the file.
+		::close(fd);
+
+		if (data == MAP_FAILED)
+			return false;
+
+		::madvise(data, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+
+		outMapping->data = static_cast<const uint8*>(data);
+		outMapping->size = static_cast<uint64>(fileStat.st_size);
+		return true;
+	}
+
+	void UnmapFile(FileMapping* mapping)
+	{
+		if (mapping->data)
+		{
+			::munmap(const_cast<uint8*>(mapping->data), static_cast<size_t>(mapping->size));
+			mapping->data = nullptr;
+		}
+
+		mapping->size = 0;
+	}
+#endif
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Types.h"
+
+/*
+============
+File Mapping
+============
+*/
+
+// Read-only view of a whole file. Pages are faulted in on first access, so
+// callers can copy straight from data without staging the file in memory.
+struct FileMapping
+{
+	const uint8* data = nullptr;
+	uint64 size = 0;
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+};
+
+namespace FileSystem
+{
+	bool MapFile(const char* filename, FileMapping* outMapping);
+	void UnmapFile(FileMapping* mapping);
+}
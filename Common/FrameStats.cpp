@@ -0,0 +1,152 @@
+#include "FrameStats.h"
+#include "Platform.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+/*
+==========
+FrameStats
+==========
+*/
+
+static const char* const FRAME_STAT_NAMES[FRAME_STAT_COUNT] =
+{
+	"frame_ms",
+	"cpu_ms",
+	"gpu_ms",
+	"draw_calls",
+	"triangles",
+	"pipeline_binds",
+	"descriptor_binds",
+	"vertex_buffer_binds",
+	"upload_bytes",
+	"culled_meshlets",
+	"local_memory_bytes",
+	"non_local_memory_bytes",
+	"streamed_texture_bytes",
+};
+
+// Smallest value with at least percent of the samples at or below it.
+static double CalcPercentile(const double* sorted, uint32 count, double percent)
+{
+	uint32 rank = static_cast<uint32>(ceil(percent * 0.01 * static_cast<double>(count)));
+	rank = rank > 0 ? rank : 1;
+	return sorted[(rank < count ? rank : count) - 1];
+}
+
+void FrameStats::Init(uint32 historyFrames)
+{
+	m_historySize = historyFrames ? historyFrames : 1;
+	m_historyCount = 0;
+	m_historyNext = 0;
+	m_frameIndex = 0;
+	memset(m_current, 0, sizeof(m_current));
+
+	m_history = new double[m_historySize * FRAME_STAT_COUNT];
+	m_scratch = new double[m_historySize];
+}
+
+void FrameStats::Clean()
+{
+	CloseCsv();
+
+	if (m_scratch)
+	{
+		delete[] m_scratch;
+		m_scratch = nullptr;
+	}
+
+	if (m_history)
+	{
+		delete[] m_history;
+		m_history = nullptr;
+	}
+
+	m_historyCount = 0;
+}
+
+void FrameStats::EndFrame()
+{
+	memcpy(m_history + m_historyNext * FRAME_STAT_COUNT, m_current, sizeof(m_current));
+	m_historyNext = (m_historyNext + 1) % m_historySize;
+	m_historyCount = m_historyCount < m_historySize ? m_historyCount + 1 : m_historySize;
+
+	if (m_csvFile)
+	{
+		FILE* file = static_cast<FILE*>(m_csvFile);
+		fprintf(file, "%llu", static_cast<unsigned long long>(m_frameIndex));
+		for (uint32 i = 0; i < FRAME_STAT_COUNT; i++)
+		{
+			if (i < FRAME_STAT_TIMINGS_COUNT)
+				fprintf(file, ",%g", m_current[i]);
+			else
+				fprintf(file, ",%llu", static_cast<unsigned long long>(m_current[i]));
+		}
+		fprintf(file, "\n");
+	}
+
+	m_frameIndex++;
+	memset(m_current, 0, sizeof(m_current));
+}
+
+FrameStatSummary FrameStats::GetSummary(FRAME_STAT stat) const
+{
+	FrameStatSummary summary;
+	if (m_historyCount == 0)
+		return summary;
+
+	uint32 last = (m_historyNext + m_historySize - 1) % m_historySize;
+	summary.last = m_history[last * FRAME_STAT_COUNT + stat];
+
+	// Ring order does not matter once sorted.
+	double sum = 0.0;
+	for (uint32 i = 0; i < m_historyCount; i++)
+	{
+		m_scratch[i] = m_history[i * FRAME_STAT_COUNT + stat];
+		sum += m_scratch[i];
+	}
+	std::sort(m_scratch, m_scratch + m_historyCount);
+
+	summary.average = sum / static_cast<double>(m_historyCount);
+	summary.p50 = CalcPercentile(m_scratch, m_historyCount, 50.0);
+	summary.p95 = CalcPercentile(m_scratch, m_historyCount, 95.0);
+	summary.p99 = CalcPercentile(m_scratch, m_historyCount, 99.0);
+	summary.max = m_scratch[m_historyCount - 1];
+	return summary;
+}
+
+bool FrameStats::OpenCsv(const char* filename)
+{
+	CloseCsv();
+
+	FILE* file = Platform::OpenFile(filename, "w");
+	if (file == nullptr)
+		return false;
+
+	fprintf(file, "frame");
+	for (uint32 i = 0; i < FRAME_STAT_COUNT; i++)
+	{
+		fprintf(file, ",%s", FRAME_STAT_NAMES[i]);
+	}
+	fprintf(file, "\n");
+
+	m_csvFile = file;
+	return true;
+}
+
+void FrameStats::CloseCsv()
+{
+	if (m_csvFile)
+	{
+		fclose(static_cast<FILE*>(m_csvFile));
+		m_csvFile = nullptr;
+	}
+}
+
+const char* FrameStats::GetName(FRAME_STAT stat)
+{
+	return stat < FRAME_STAT_COUNT ? FRAME_STAT_NAMES[stat] : "";
+}
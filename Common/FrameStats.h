@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Types.h"
+
+/*
+===========
+Frame Stats
+===========
+*/
+
+// Timings come first and are set with SetMilliseconds; the rest are counters.
+enum FRAME_STAT
+{
+	FRAME_STAT_FRAME_MILLISECONDS,		// Present to present.
+	FRAME_STAT_CPU_MILLISECONDS,		// Frame time minus the wait for the GPU.
+	FRAME_STAT_GPU_MILLISECONDS,		// From timestamp queries, a few frames late.
+	FRAME_STAT_DRAW_CALLS,
+	FRAME_STAT_TRIANGLES,
+	FRAME_STAT_PIPELINE_BINDS,
+	FRAME_STAT_DESCRIPTOR_BINDS,		// Descriptor heaps, tables and root descriptors.
+	FRAME_STAT_VERTEX_BUFFER_BINDS,
+	FRAME_STAT_UPLOAD_BYTES,
+	FRAME_STAT_CULLED_MESHLETS,
+	FRAME_STAT_LOCAL_MEMORY_BYTES,		// Video memory: default heaps.
+	FRAME_STAT_NON_LOCAL_MEMORY_BYTES,	// System memory: upload and readback heaps.
+	FRAME_STAT_STREAMED_TEXTURE_BYTES,
+	FRAME_STAT_COUNT,
+};
+
+const uint32 FRAME_STAT_TIMINGS_COUNT = FRAME_STAT_DRAW_CALLS;
+const uint32 FRAME_STATS_DEFAULT_HISTORY = 240;
+
+// Doubles hold every counter exactly up to 2^53, byte counts of any heap included.
+struct FrameStatSummary
+{
+	double last = 0.0;
+	double average = 0.0;
+	double p50 = 0.0;
+	double p95 = 0.0;
+	double p99 = 0.0;
+	double max = 0.0;
+};
+
+/*
+==========
+FrameStats
+==========
+*/
+
+// Per-frame counters with a rolling history for percentiles. Counters are
+// added to during the frame and moved into the history by EndFrame, which
+// also appends a row to the CSV file when one is open.
+class FrameStats
+{
+public:
+	void Init(uint32 historyFrames = FRAME_STATS_DEFAULT_HISTORY);
+	void Clean();
+
+	inline void Add(FRAME_STAT stat, uint64 count) { m_current[stat] += static_cast<double>(count); }
+	inline void Set(FRAME_STAT stat, uint64 count) { m_current[stat] = static_cast<double>(count); }
+	inline void SetMilliseconds(FRAME_STAT stat, float milliseconds) { m_current[stat] = milliseconds; }
+	void EndFrame();
+
+	// Over the frames in the history, nearest-rank percentiles.
+	FrameStatSummary GetSummary(FRAME_STAT stat) const;
+	inline uint32 GetFramesCount() const { return m_historyCount; }
+
+	// One column per stat and a row per frame from now on.
+	bool OpenCsv(const char* filename);
+	void CloseCsv();
+
+	static const char* GetName(FRAME_STAT stat);
+
+private:
+	uint32 m_historySize = 0;
+	uint32 m_historyCount = 0;
+	uint32 m_historyNext = 0;
+	uint64 m_frameIndex = 0;
+
+	double m_current[FRAME_STAT_COUNT] = {};
+	double* m_history = nullptr;			// m_historySize frames of FRAME_STAT_COUNT values.
+	double* m_scratch = nullptr;			// Sorted copy of one stat's history.
+
+	void* m_csvFile = nullptr;
+};
@@ -1,6 +1,8 @@
-#include "pch.h"
 #include "GeometryGenerator.h"
 
+#include <math.h>
+#include <string.h>
+
 /*
 ==================
 GeometryGenerator.
@@ -191,5 +193,59 @@ namespace GeometryGenerator
 
 		return meshData;
 	}
-}
 
+	MeshData MakeSphere(const float scale, const uint32 slices, const uint32 stacks)
+	{
+		MeshData meshData = {};
+
+		uint32 count = (stacks + 1) * (slices + 1);
+
+		meshData.vertices = new Vertex[count];
+		meshData.verticesSize = sizeof(Vertex) * count;
+		meshData.verticesCount = count;
+
+		for (uint32 i = 0; i <= stacks; i++)
+		{
+			float phi = DirectX::XM_PI * i / stacks;
+			for (uint32 j = 0; j <= slices; j++)
+			{
+				float theta = DirectX::XM_2PI * j / slices;
+
+				Vertex& vertex = meshData.vertices[i * (slices + 1) + j];
+				vertex.posModel = Vector3(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta)) * scale;
+				vertex.color = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+				vertex.texCoord = Vector2(static_cast<float>(j) / slices, static_cast<float>(i) / stacks);
+			}
+		}
+
+		// The pole rows collapse to a point, so their quads become single fan triangles.
+		count = stacks > 1 ? (stacks - 1) * slices * 6 : 0;
+
+		meshData.indices = new Index[count];
+		meshData.indicesSize = sizeof(Index) * count;
+		meshData.indicesCount = count;
+
+		Index* index = meshData.indices;
+		for (uint32 i = 0; i < stacks; i++)
+		{
+			for (uint32 j = 0; j < slices; j++)
+			{
+				Index a = i * (slices + 1) + j;
+				Index b = a + 1;
+				Index c = a + (slices + 1);
+				Index d = c + 1;
+
+				if (i != 0)
+				{
+					*index++ = a; *index++ = b; *index++ = c;
+				}
+				if (i != stacks - 1)
+				{
+					*index++ = b; *index++ = d; *index++ = c;
+				}
+			}
+		}
+
+		return meshData;
+	}
+}
@@ -1,6 +1,7 @@
 #pragma once
 
-#include "../Common/Vertex.h"
+#include "Types.h"
+#include "Vertex.h"
 
 /*
 ==================
@@ -13,4 +14,5 @@ namespace GeometryGenerator
 	MeshData MakeTriangle();
 	MeshData MakeSqaure(const float scale = 1.0f);
 	MeshData MakeBox(const float scale = 1.0f);
+	MeshData MakeSphere(const float scale = 1.0f, const uint32 slices = 64, const uint32 stacks = 32);
 }
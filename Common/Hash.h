@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Types.h"
+
+/*
+=====
+Hash
+=====
+*/
+
+// 64-bit FNV-1a. Not cryptographic; used for content-addressed caches where
+// the key is rebuilt from the same inputs on every run.
+const uint64 HASH_FNV1A_OFFSET = 0xcbf29ce484222325ull;
+const uint64 HASH_FNV1A_PRIME = 0x100000001b3ull;
+
+inline uint64 HashBytes(const void* data, uint64 size, uint64 seed = HASH_FNV1A_OFFSET)
+{
+	const uint8* bytes = static_cast<const uint8*>(data);
+	uint64 hash = seed;
+	for (uint64 i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= HASH_FNV1A_PRIME;
+	}
+	return hash;
+}
+
+inline uint64 HashString(const char* str, uint64 seed = HASH_FNV1A_OFFSET)
+{
+	uint64 hash = seed;
+	for (; *str; str++)
+	{
+		hash ^= static_cast<uint8>(*str);
+		hash *= HASH_FNV1A_PRIME;
+	}
+	// Terminate so ("ab", "c") and ("a", "bc") hash differently when chained.
+	hash ^= 0xff;
+	hash *= HASH_FNV1A_PRIME;
+	return hash;
+}
+
+template<typename T>
+inline uint64 HashValue(const T& value, uint64 seed = HASH_FNV1A_OFFSET)
+{
+	return HashBytes(&value, sizeof(T), seed);
+}
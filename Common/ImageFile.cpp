@@ -0,0 +1,848 @@
+#include "ImageFile.h"
+#include "FileMapping.h"
+#include "Platform.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+/*
+============
+Image File
+============
+*/
+
+namespace ImageFile
+{
+	static const char* GetExtension(const char* filename)
+	{
+		const char* dot = ::strrchr(filename, '.');
+		return dot ? dot + 1 : "";
+	}
+
+	static bool EqualsNoCase(const char* lhs, const char* rhs)
+	{
+		for (; *lhs && *rhs; lhs++, rhs++)
+		{
+			if (::tolower(static_cast<uint8>(*lhs)) != ::tolower(static_cast<uint8>(*rhs)))
+				return false;
+		}
+		return *lhs == *rhs;
+	}
+
+	static uint16 ReadLE16(const uint8* data)
+	{
+		return static_cast<uint16>(data[0] | (data[1] << 8));
+	}
+
+	static uint32 ReadBE32(const uint8* data)
+	{
+		return (static_cast<uint32>(data[0]) << 24) | (static_cast<uint32>(data[1]) << 16) | (static_cast<uint32>(data[2]) << 8) | data[3];
+	}
+
+	static void AllocatePixels(uint32 width, uint32 height, ImageData* outImage)
+	{
+		outImage->width = width;
+		outImage->height = height;
+		outImage->pixels = new uint8[static_cast<uint64>(width) * height * 4];
+		outImage->hasAlpha = false;
+	}
+
+	static void UpdateHasAlpha(ImageData* image)
+	{
+		uint64 pixelsCount = static_cast<uint64>(image->width) * image->height;
+		for (uint64 i = 0; i < pixelsCount; i++)
+		{
+			if (image->pixels[i * 4 + 3] != 255)
+			{
+				image->hasAlpha = true;
+				return;
+			}
+		}
+	}
+
+	/*
+	============
+	TGA
+	============
+	*/
+
+	const uint32 TGA_HEADER_SIZE = 18;
+	const uint8 TGA_TYPE_COLOR_MAPPED = 1;
+	const uint8 TGA_TYPE_TRUE_COLOR = 2;
+	const uint8 TGA_TYPE_GRAYSCALE = 3;
+	const uint8 TGA_TYPE_RLE_FLAG = 8;
+	const uint8 TGA_DESCRIPTOR_RIGHT_TO_LEFT = 0x10;
+	const uint8 TGA_DESCRIPTOR_TOP_TO_BOTTOM = 0x20;
+
+	// Converts one stored TGA pixel (BGR order) to RGBA.
+	static void DecodeTgaPixel(const uint8* src, uint32 bytesPerPixel, bool grayscale, uint8* dst)
+	{
+		if (grayscale)
+		{
+			dst[0] = dst[1] = dst[2] = src[0];
+			dst[3] = bytesPerPixel == 2 ? src[1] : 255;
+			return;
+		}
+
+		switch (bytesPerPixel)
+		{
+		case 2:
+		{
+			// A1R5G5B5.
+			uint16 value = ReadLE16(src);
+			uint8 r = (value >> 10) & 0x1f;
+			uint8 g = (value >> 5) & 0x1f;
+			uint8 b = value & 0x1f;
+			dst[0] = static_cast<uint8>((r << 3) | (r >> 2));
+			dst[1] = static_cast<uint8>((g << 3) | (g >> 2));
+			dst[2] = static_cast<uint8>((b << 3) | (b >> 2));
+			dst[3] = 255;
+			break;
+		}
+		case 3:
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+			dst[3] = 255;
+			break;
+		case 4:
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+			dst[3] = src[3];
+			break;
+		}
+	}
+
+	bool LoadTga(const uint8* data, uint64 size, ImageData* outImage)
+	{
+		*outImage = {};
+
+		if (size < TGA_HEADER_SIZE)
+			return false;
+
+		uint8 idLength = data[0];
+		uint8 colorMapType = data[1];
+		uint8 imageType = data[2];
+		uint16 colorMapFirst = ReadLE16(data + 3);
+		uint16 colorMapLength = ReadLE16(data + 5);
+		uint8 colorMapDepth = data[7];
+		uint16 width = ReadLE16(data + 12);
+		uint16 height = ReadLE16(data + 14);
+		uint8 pixelDepth = data[16];
+		uint8 descriptor = data[17];
+
+		bool rle = (imageType & TGA_TYPE_RLE_FLAG) != 0;
+		uint8 baseType = imageType & ~TGA_TYPE_RLE_FLAG;
+		if (baseType != TGA_TYPE_COLOR_MAPPED && baseType != TGA_TYPE_TRUE_COLOR && baseType != TGA_TYPE_GRAYSCALE)
+			return false;
+
+		if (width == 0 || height == 0 || (pixelDepth % 8 != 0 && pixelDepth != 15))
+			return false;
+
+		uint32 bytesPerPixel = (pixelDepth + 7) / 8;
+		if (bytesPerPixel == 0 || bytesPerPixel > 4)
+			return false;
+
+		uint64 offset = TGA_HEADER_SIZE + idLength;
+
+		// The color map holds true-color entries; pixels index into it.
+		const uint8* colorMap = nullptr;
+		uint32 colorMapBytesPerEntry = (colorMapDepth + 7) / 8;
+		if (colorMapType == 1)
+		{
+			colorMap = data + offset;
+			offset += static_cast<uint64>(colorMapLength) * colorMapBytesPerEntry;
+			if (offset > size)
+				return false;
+		}
+
+		if (baseType == TGA_TYPE_COLOR_MAPPED && (!colorMap || colorMapLength == 0 || bytesPerPixel > 2 || colorMapBytesPerEntry < 2 || colorMapBytesPerEntry > 4))
+			return false;
+
+		AllocatePixels(width, height, outImage);
+
+		uint64 pixelsCount = static_cast<uint64>(width) * height;
+		uint64 pixel = 0;
+		bool grayscale = baseType == TGA_TYPE_GRAYSCALE;
+
+		auto writePixel = [&](const uint8* src)
+		{
+			uint8* dst = outImage->pixels + pixel * 4;
+			if (baseType == TGA_TYPE_COLOR_MAPPED)
+			{
+				uint32 index = bytesPerPixel == 2 ? ReadLE16(src) : src[0];
+				index -= colorMapFirst;
+				if (index >= colorMapLength)
+					index = 0;
+				DecodeTgaPixel(colorMap + index * colorMapBytesPerEntry, colorMapBytesPerEntry, false, dst);
+			}
+			else
+			{
+				DecodeTgaPixel(src, bytesPerPixel, grayscale, dst);
+			}
+			pixel++;
+		};
+
+		while (pixel < pixelsCount)
+		{
+			if (!rle)
+			{
+				if (offset + bytesPerPixel > size)
+					break;
+				writePixel(data + offset);
+				offset += bytesPerPixel;
+				continue;
+			}
+
+			// Packets: a repeated pixel or a run of raw pixels, 1 to 128 long.
+			if (offset >= size)
+				break;
+			uint8 packet = data[offset++];
+			uint32 count = (packet & 0x7f) + 1;
+
+			if (packet & 0x80)
+			{
+				if (offset + bytesPerPixel > size)
+					break;
+				for (uint32 i = 0; i < count && pixel < pixelsCount; i++)
+				{
+					writePixel(data + offset);
+				}
+				offset += bytesPerPixel;
+			}
+			else
+			{
+				for (uint32 i = 0; i < count && pixel < pixelsCount; i++)
+				{
+					if (offset + bytesPerPixel > size)
+						break;
+					writePixel(data + offset);
+					offset += bytesPerPixel;
+				}
+			}
+		}
+
+		if (pixel < pixelsCount)
+		{
+			Destroy(outImage);
+			return false;
+		}
+
+		// Stored bottom to top unless the descriptor says otherwise.
+		uint32 rowSize = width * 4;
+		if (!(descriptor & TGA_DESCRIPTOR_TOP_TO_BOTTOM))
+		{
+			std::vector<uint8> row(rowSize);
+			for (uint32 y = 0; y < height / 2u; y++)
+			{
+				uint8* top = outImage->pixels + static_cast<uint64>(y) * rowSize;
+				uint8* bottom = outImage->pixels + static_cast<uint64>(height - 1 - y) * rowSize;
+				::memcpy(row.data(), top, rowSize);
+				::memcpy(top, bottom, rowSize);
+				::memcpy(bottom, row.data(), rowSize);
+			}
+		}
+
+		if (descriptor & TGA_DESCRIPTOR_RIGHT_TO_LEFT)
+		{
+			for (uint32 y = 0; y < height; y++)
+			{
+				uint32* row = reinterpret_cast<uint32*>(outImage->pixels + static_cast<uint64>(y) * rowSize);
+				for (uint32 x = 0; x < width / 2u; x++)
+				{
+					uint32 temp = row[x];
+					row[x] = row[width - 1 - x];
+					row[width - 1 - x] = temp;
+				}
+			}
+		}
+
+		UpdateHasAlpha(outImage);
+		return true;
+	}
+
+	/*
+	============
+	Inflate
+	============
+	*/
+
+	// Canonical Huffman decoding as in RFC 1951: codes of the same length are
+	// consecutive, so counts per length and symbols sorted by code are enough.
+	struct Huffman
+	{
+		uint16 counts[16] = {};
+		uint16 symbols[288] = {};
+	};
+
+	struct BitReader
+	{
+		const uint8* data = nullptr;
+		uint64 size = 0;
+		uint64 offset = 0;
+		uint32 bitBuffer = 0;
+		uint32 bitsCount = 0;
+		bool overrun = false;
+	};
+
+	static uint32 ReadBits(BitReader& reader, uint32 count)
+	{
+		while (reader.bitsCount < count)
+		{
+			if (reader.offset >= reader.size)
+			{
+				reader.overrun = true;
+				return 0;
+			}
+			reader.bitBuffer |= static_cast<uint32>(reader.data[reader.offset++]) << reader.bitsCount;
+			reader.bitsCount += 8;
+		}
+
+		uint32 value = reader.bitBuffer & ((1u << count) - 1);
+		reader.bitBuffer >>= count;
+		reader.bitsCount -= count;
+		return value;
+	}
+
+	static bool BuildHuffman(Huffman* huffman, const uint8* lengths, uint32 count)
+	{
+		*huffman = {};
+		for (uint32 i = 0; i < count; i++)
+		{
+			huffman->counts[lengths[i]]++;
+		}
+		huffman->counts[0] = 0;
+
+		// Reject over-subscribed code sets.
+		int32 left = 1;
+		for (uint32 length = 1; length < 16; length++)
+		{
+			left <<= 1;
+			left -= huffman->counts[length];
+			if (left < 0)
+				return false;
+		}
+
+		uint16 offsets[16] = {};
+		for (uint32 length = 1; length < 15; length++)
+		{
+			offsets[length + 1] = offsets[length] + huffman->counts[length];
+		}
+
+		for (uint32 i = 0; i < count; i++)
+		{
+			if (lengths[i])
+				huffman->symbols[offsets[lengths[i]]++] = static_cast<uint16>(i);
+		}
+		return true;
+	}
+
+	static int32 DecodeSymbol(BitReader& reader, const Huffman& huffman)
+	{
+		int32 code = 0;
+		int32 first = 0;
+		int32 index = 0;
+		for (uint32 length = 1; length < 16; length++)
+		{
+			code |= static_cast<int32>(ReadBits(reader, 1));
+			int32 count = huffman.counts[length];
+			if (code - first < count)
+				return huffman.symbols[index + code - first];
+
+			index += count;
+			first = (first + count) << 1;
+			code <<= 1;
+		}
+		return -1;
+	}
+
+	static const uint16 s_LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const uint8 s_LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static const uint16 s_DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static const uint8 s_DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	// Fails rather than write past maxSize bytes.
+	static bool InflateBlock(BitReader& reader, const Huffman& lengthCodes, const Huffman& distanceCodes, uint64 maxSize, std::vector<uint8>* out)
+	{
+		while (true)
+		{
+			int32 symbol = DecodeSymbol(reader, lengthCodes);
+			if (symbol < 0 || reader.overrun)
+				return false;
+
+			if (symbol < 256)
+			{
+				if (out->size() >= maxSize)
+					return false;
+				out->push_back(static_cast<uint8>(symbol));
+				continue;
+			}
+
+			if (symbol == 256)
+				return true;
+
+			symbol -= 257;
+			if (symbol >= 29)
+				return false;
+			uint32 length = s_LengthBase[symbol] + ReadBits(reader, s_LengthExtra[symbol]);
+
+			int32 distanceSymbol = DecodeSymbol(reader, distanceCodes);
+			if (distanceSymbol < 0 || distanceSymbol >= 30)
+				return false;
+			uint32 distance = s_DistanceBase[distanceSymbol] + ReadBits(reader, s_DistanceExtra[distanceSymbol]);
+			if (distance > out->size() || length > maxSize - out->size() || reader.overrun)
+				return false;
+
+			// Byte by byte: the source may overlap the bytes being written.
+			uint64 start = out->size() - distance;
+			for (uint32 i = 0; i < length; i++)
+			{
+				out->push_back((*out)[start + i]);
+			}
+		}
+	}
+
+	// A stream that inflates past maxSize bytes is rejected before it can
+	// grow the output any further.
+	static bool Inflate(const uint8* data, uint64 size, uint64 maxSize, std::vector<uint8>* out)
+	{
+		// zlib wrapper: deflate method, no preset dictionary.
+		if (size < 2 || (data[0] & 0x0f) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20))
+			return false;
+
+		BitReader reader;
+		reader.data = data + 2;
+		reader.size = size - 2;
+
+		uint32 last = 0;
+		while (!last)
+		{
+			last = ReadBits(reader, 1);
+			uint32 type = ReadBits(reader, 2);
+
+			if (type == 0)
+			{
+				// Stored: byte aligned LEN, NLEN, then raw bytes.
+				reader.bitBuffer = 0;
+				reader.bitsCount = 0;
+				if (reader.offset + 4 > reader.size)
+					return false;
+
+				uint32 length = ReadLE16(reader.data + reader.offset);
+				uint32 lengthComplement = ReadLE16(reader.data + reader.offset + 2);
+				reader.offset += 4;
+				if ((length ^ 0xffff) != lengthComplement || reader.offset + length > reader.size || length > maxSize - out->size())
+					return false;
+
+				out->insert(out->end(), reader.data + reader.offset, reader.data + reader.offset + length);
+				reader.offset += length;
+			}
+			else if (type == 1)
+			{
+				uint8 lengths[288 + 30];
+				uint32 i = 0;
+				for (; i < 144; i++) lengths[i] = 8;
+				for (; i < 256; i++) lengths[i] = 9;
+				for (; i < 280; i++) lengths[i] = 7;
+				for (; i < 288; i++) lengths[i] = 8;
+				for (; i < 288 + 30; i++) lengths[i] = 5;
+
+				Huffman lengthCodes;
+				Huffman distanceCodes;
+				BuildHuffman(&lengthCodes, lengths, 288);
+				BuildHuffman(&distanceCodes, lengths + 288, 30);
+				if (!InflateBlock(reader, lengthCodes, distanceCodes, maxSize, out))
+					return false;
+			}
+			else if (type == 2)
+			{
+				static const uint8 s_CodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+				uint32 lengthCodesCount = ReadBits(reader, 5) + 257;
+				uint32 distanceCodesCount = ReadBits(reader, 5) + 1;
+				uint32 codeLengthCodesCount = ReadBits(reader, 4) + 4;
+				if (lengthCodesCount > 286 || distanceCodesCount > 30)
+					return false;
+
+				uint8 codeLengths[19] = {};
+				for (uint32 i = 0; i < codeLengthCodesCount; i++)
+				{
+					codeLengths[s_CodeLengthOrder[i]] = static_cast<uint8>(ReadBits(reader, 3));
+				}
+
+				Huffman codeLengthCodes;
+				if (!BuildHuffman(&codeLengthCodes, codeLengths, 19))
+					return false;
+
+				// Literal/length and distance code lengths share one run-length coded list.
+				uint8 lengths[286 + 30] = {};
+				uint32 count = 0;
+				while (count < lengthCodesCount + distanceCodesCount)
+				{
+					int32 symbol = DecodeSymbol(reader, codeLengthCodes);
+					if (symbol < 0 || reader.overrun)
+						return false;
+
+					if (symbol < 16)
+					{
+						lengths[count++] = static_cast<uint8>(symbol);
+						continue;
+					}
+
+					uint8 value = 0;
+					uint32 repeat = 0;
+					if (symbol == 16)
+					{
+						if (count == 0)
+							return false;
+						value = lengths[count - 1];
+						repeat = 3 + ReadBits(reader, 2);
+					}
+					else if (symbol == 17)
+					{
+						repeat = 3 + ReadBits(reader, 3);
+					}
+					else
+					{
+						repeat = 11 + ReadBits(reader, 7);
+					}
+
+					if (count + repeat > lengthCodesCount + distanceCodesCount)
+						return false;
+					while (repeat--)
+					{
+						lengths[count++] = value;
+					}
+				}
+
+				Huffman lengthCodes;
+				Huffman distanceCodes;
+				if (!BuildHuffman(&lengthCodes, lengths, lengthCodesCount) || !BuildHuffman(&distanceCodes, lengths + lengthCodesCount, distanceCodesCount))
+					return false;
+				if (!InflateBlock(reader, lengthCodes, distanceCodes, maxSize, out))
+					return false;
+			}
+			else
+			{
+				return false;
+			}
+
+			if (reader.overrun)
+				return false;
+		}
+
+		return true;
+	}
+
+	/*
+	============
+	PNG
+	============
+	*/
+
+	const uint8 PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	const uint8 PNG_COLOR_GRAY = 0;
+	const uint8 PNG_COLOR_RGB = 2;
+	const uint8 PNG_COLOR_PALETTE = 3;
+	const uint8 PNG_COLOR_GRAY_ALPHA = 4;
+	const uint8 PNG_COLOR_RGBA = 6;
+
+	static uint8 Paeth(uint8 a, uint8 b, uint8 c)
+	{
+		int32 p = a + b - c;
+		int32 pa = p > a ? p - a : a - p;
+		int32 pb = p > b ? p - b : b - p;
+		int32 pc = p > c ? p - c : c - p;
+		if (pa <= pb && pa <= pc)
+			return a;
+		return pb <= pc ? b : c;
+	}
+
+	// Sample index of a row, bitDepth bits each, most significant bits first.
+	static uint32 GetSample(const uint8* row, uint32 index, uint32 bitDepth)
+	{
+		switch (bitDepth)
+		{
+		case 16: return (row[index * 2] << 8) | row[index * 2 + 1];
+		case 8: return row[index];
+		default:
+		{
+			uint32 bit = index * bitDepth;
+			return (row[bit >> 3] >> (8 - bitDepth - (bit & 7))) & ((1u << bitDepth) - 1);
+		}
+		}
+	}
+
+	bool LoadPng(const uint8* data, uint64 size, ImageData* outImage)
+	{
+		*outImage = {};
+
+		if (size < sizeof(PNG_SIGNATURE) || ::memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0)
+			return false;
+
+		uint32 width = 0;
+		uint32 height = 0;
+		uint8 bitDepth = 0;
+		uint8 colorType = 0;
+		uint8 palette[256 * 4] = {};
+		uint32 paletteCount = 0;
+		bool hasTransparentColor = false;
+		uint32 transparentColor[3] = {};
+		std::vector<uint8> compressed;
+
+		uint64 offset = sizeof(PNG_SIGNATURE);
+		bool ended = false;
+		while (!ended && offset + 12 <= size)
+		{
+			uint32 length = ReadBE32(data + offset);
+			const uint8* type = data + offset + 4;
+			const uint8* chunk = data + offset + 8;
+			if (offset + 12 + length > size)
+				return false;
+			offset += 12 + length;
+
+			if (::memcmp(type, "IHDR", 4) == 0)
+			{
+				if (length < 13)
+					return false;
+				width = ReadBE32(chunk);
+				height = ReadBE32(chunk + 4);
+				bitDepth = chunk[8];
+				colorType = chunk[9];
+
+				// Compression and filter methods are always 0; interlacing is not supported.
+				if (chunk[10] != 0 || chunk[11] != 0 || chunk[12] != 0)
+					return false;
+			}
+			else if (::memcmp(type, "PLTE", 4) == 0)
+			{
+				paletteCount = length / 3 < 256 ? length / 3 : 256;
+				for (uint32 i = 0; i < paletteCount; i++)
+				{
+					palette[i * 4 + 0] = chunk[i * 3 + 0];
+					palette[i * 4 + 1] = chunk[i * 3 + 1];
+					palette[i * 4 + 2] = chunk[i * 3 + 2];
+					palette[i * 4 + 3] = 255;
+				}
+			}
+			else if (::memcmp(type, "tRNS", 4) == 0)
+			{
+				if (colorType == PNG_COLOR_PALETTE)
+				{
+					for (uint32 i = 0; i < length && i < 256; i++)
+					{
+						palette[i * 4 + 3] = chunk[i];
+					}
+				}
+				else if (colorType == PNG_COLOR_GRAY && length >= 2)
+				{
+					hasTransparentColor = true;
+					transparentColor[0] = (chunk[0] << 8) | chunk[1];
+				}
+				else if (colorType == PNG_COLOR_RGB && length >= 6)
+				{
+					hasTransparentColor = true;
+					for (uint32 i = 0; i < 3; i++)
+					{
+						transparentColor[i] = (chunk[i * 2] << 8) | chunk[i * 2 + 1];
+					}
+				}
+			}
+			else if (::memcmp(type, "IDAT", 4) == 0)
+			{
+				compressed.insert(compressed.end(), chunk, chunk + length);
+			}
+			else if (::memcmp(type, "IEND", 4) == 0)
+			{
+				ended = true;
+			}
+		}
+
+		uint32 channelsCount = 0;
+		switch (colorType)
+		{
+		case PNG_COLOR_GRAY: channelsCount = 1; break;
+		case PNG_COLOR_RGB: channelsCount = 3; break;
+		case PNG_COLOR_PALETTE: channelsCount = 1; break;
+		case PNG_COLOR_GRAY_ALPHA: channelsCount = 2; break;
+		case PNG_COLOR_RGBA: channelsCount = 4; break;
+		default: return false;
+		}
+
+		bool validDepth = bitDepth == 8 || (bitDepth == 16 && colorType != PNG_COLOR_PALETTE) ||
+			((bitDepth == 1 || bitDepth == 2 || bitDepth == 4) && (colorType == PNG_COLOR_GRAY || colorType == PNG_COLOR_PALETTE));
+		if (width == 0 || height == 0 || !validDepth || (colorType == PNG_COLOR_PALETTE && paletteCount == 0))
+			return false;
+
+		// Each row starts with its filter type byte.
+		uint32 bitsPerPixel = channelsCount * bitDepth;
+		uint32 bytesPerPixel = bitsPerPixel >= 8 ? bitsPerPixel / 8 : 1;
+		uint64 rowSize = (static_cast<uint64>(width) * bitsPerPixel + 7) / 8;
+
+		std::vector<uint8> filtered;
+		if (!Inflate(compressed.data(), compressed.size(), (rowSize + 1) * height, &filtered))
+			return false;
+		if (filtered.size() < (rowSize + 1) * height)
+			return false;
+
+		std::vector<uint8> previousRow(rowSize, 0);
+		std::vector<uint8> row(rowSize);
+
+		AllocatePixels(width, height, outImage);
+		uint32 maxSample = (1u << bitDepth) - 1;
+
+		for (uint32 y = 0; y < height; y++)
+		{
+			const uint8* src = filtered.data() + y * (rowSize + 1);
+			uint8 filter = src[0];
+			src++;
+
+			for (uint64 i = 0; i < rowSize; i++)
+			{
+				uint8 left = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+				uint8 up = previousRow[i];
+				uint8 upLeft = i >= bytesPerPixel ? previousRow[i - bytesPerPixel] : 0;
+
+				switch (filter)
+				{
+				case 0: row[i] = src[i]; break;
+				case 1: row[i] = static_cast<uint8>(src[i] + left); break;
+				case 2: row[i] = static_cast<uint8>(src[i] + up); break;
+				case 3: row[i] = static_cast<uint8>(src[i] + ((left + up) >> 1)); break;
+				case 4: row[i] = static_cast<uint8>(src[i] + Paeth(left, up, upLeft)); break;
+				default:
+					Destroy(outImage);
+					return false;
+				}
+			}
+
+			uint8* dst = outImage->pixels + static_cast<uint64>(y) * width * 4;
+			for (uint32 x = 0; x < width; x++, dst += 4)
+			{
+				uint32 samples[4] = {};
+				for (uint32 c = 0; c < channelsCount; c++)
+				{
+					samples[c] = GetSample(row.data(), x * channelsCount + c, bitDepth);
+				}
+
+				if (colorType == PNG_COLOR_PALETTE)
+				{
+					uint32 index = samples[0] < paletteCount ? samples[0] : 0;
+					::memcpy(dst, palette + index * 4, 4);
+					continue;
+				}
+
+				// Scale every depth to 8 bits; 16-bit samples keep their high byte.
+				uint8 values[4] = {};
+				for (uint32 c = 0; c < channelsCount; c++)
+				{
+					values[c] = static_cast<uint8>(bitDepth == 16 ? samples[c] >> 8 : samples[c] * 255 / maxSample);
+				}
+
+				switch (colorType)
+				{
+				case PNG_COLOR_GRAY:
+					dst[0] = dst[1] = dst[2] = values[0];
+					dst[3] = hasTransparentColor && samples[0] == transparentColor[0] ? 0 : 255;
+					break;
+				case PNG_COLOR_RGB:
+					dst[0] = values[0];
+					dst[1] = values[1];
+					dst[2] = values[2];
+					dst[3] = hasTransparentColor && samples[0] == transparentColor[0] && samples[1] == transparentColor[1] && samples[2] == transparentColor[2] ? 0 : 255;
+					break;
+				case PNG_COLOR_GRAY_ALPHA:
+					dst[0] = dst[1] = dst[2] = values[0];
+					dst[3] = values[1];
+					break;
+				case PNG_COLOR_RGBA:
+					::memcpy(dst, values, 4);
+					break;
+				}
+			}
+
+			previousRow.swap(row);
+		}
+
+		UpdateHasAlpha(outImage);
+		return true;
+	}
+
+	bool SaveTga(const char* filename, const uint8* pixels, uint32 width, uint32 height, uint32 rowPitch)
+	{
+		if (width == 0 || height == 0 || width > 0xffff || height > 0xffff || rowPitch < width * 4)
+			return false;
+
+		uint8 header[TGA_HEADER_SIZE] = {};
+		header[2] = TGA_TYPE_TRUE_COLOR;
+		header[12] = static_cast<uint8>(width);
+		header[13] = static_cast<uint8>(width >> 8);
+		header[14] = static_cast<uint8>(height);
+		header[15] = static_cast<uint8>(height >> 8);
+		header[16] = 32;
+		header[17] = TGA_DESCRIPTOR_TOP_TO_BOTTOM | 8;	// 8 alpha bits.
+
+		FILE* file = Platform::OpenFile(filename, "wb");
+		if (file == nullptr)
+			return false;
+
+		bool result = fwrite(header, sizeof(header), 1, file) == 1;
+
+		// TGA stores BGRA.
+		std::vector<uint8> row(width * 4);
+		for (uint32 y = 0; y < height && result; y++)
+		{
+			const uint8* src = pixels + static_cast<uint64>(y) * rowPitch;
+			for (uint32 x = 0; x < width; x++)
+			{
+				row[x * 4 + 0] = src[x * 4 + 2];
+				row[x * 4 + 1] = src[x * 4 + 1];
+				row[x * 4 + 2] = src[x * 4 + 0];
+				row[x * 4 + 3] = src[x * 4 + 3];
+			}
+			result = fwrite(row.data(), 1, row.size(), file) == row.size();
+		}
+
+		if (fclose(file) != 0)
+			result = false;
+		return result;
+	}
+
+	bool Load(const char* filename, ImageData* outImage)
+	{
+		*outImage = {};
+
+		FileMapping mapping = {};
+		if (!FileSystem::MapFile(filename, &mapping))
+			return false;
+
+		const char* extension = GetExtension(filename);
+		bool result = false;
+		if (EqualsNoCase(extension, "png"))
+			result = LoadPng(mapping.data, mapping.size, outImage);
+		else if (EqualsNoCase(extension, "tga"))
+			result = LoadTga(mapping.data, mapping.size, outImage);
+
+		FileSystem::UnmapFile(&mapping);
+		return result;
+	}
+
+	bool IsSupported(const char* filename)
+	{
+		const char* extension = GetExtension(filename);
+		return EqualsNoCase(extension, "png") || EqualsNoCase(extension, "tga");
+	}
+
+	void Destroy(ImageData* image)
+	{
+		if (image->pixels)
+		{
+			delete[] image->pixels;
+			image->pixels = nullptr;
+		}
+		*image = {};
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Types.h"
+
+/*
+============
+Image File
+============
+*/
+
+// Decoded image, always RGBA8 with rows tightly packed top to bottom.
+struct ImageData
+{
+	uint32 width = 0;
+	uint32 height = 0;
+	uint8* pixels = nullptr;
+	bool hasAlpha = false;		// Some pixel has alpha below 255.
+};
+
+namespace ImageFile
+{
+	// Uncompressed and RLE true-color, grayscale and color-mapped TGA.
+	bool LoadTga(const uint8* data, uint64 size, ImageData* outImage);
+	// Non-interlaced PNG of any color type, 8 or 16 bits per channel, or palette.
+	bool LoadPng(const uint8* data, uint64 size, ImageData* outImage);
+
+	// Uncompressed 32-bit TGA with rows top to bottom, from RGBA8 rows rowPitch
+	// bytes apart.
+	bool SaveTga(const char* filename, const uint8* pixels, uint32 width, uint32 height, uint32 rowPitch);
+
+	// Picks the loader from the file extension.
+	bool Load(const char* filename, ImageData* outImage);
+	bool IsSupported(const char* filename);
+	void Destroy(ImageData* image);
+}
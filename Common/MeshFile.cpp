@@ -0,0 +1,258 @@
+#include "MeshFile.h"
+#include "Platform.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+/*
+==========
+MeshFile
+==========
+*/
+
+namespace MeshFile
+{
+	static uint64 AlignUp(uint64 value, uint64 alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	static void ComputeBounds(const MeshData& meshData, MeshFileHeader* header)
+	{
+		if (meshData.verticesCount == 0)
+			return;
+
+		Vector3 minPos = meshData.vertices[0].posModel;
+		Vector3 maxPos = minPos;
+		for (uint32 i = 1; i < meshData.verticesCount; i++)
+		{
+			minPos = Vector3::Min(minPos, meshData.vertices[i].posModel);
+			maxPos = Vector3::Max(maxPos, meshData.vertices[i].posModel);
+		}
+
+		Vector3 center = (minPos + maxPos) * 0.5f;
+		float radius = 0.0f;
+		for (uint32 i = 0; i < meshData.verticesCount; i++)
+		{
+			float dist = Vector3::Distance(center, meshData.vertices[i].posModel);
+			radius = dist > radius ? dist : radius;
+		}
+
+		header->boundsMin = minPos;
+		header->boundsMax = maxPos;
+		header->boundsCenter = center;
+		header->boundsRadius = radius;
+	}
+
+	// Meshlets index the meshlet vertex and triangle sections and, as ranges of
+	// meshlet-ordered indices, LOD 0; nothing may point past any of them.
+	static bool ValidateMeshlets(const MeshFileHeader& header, const void* const blobs[MESH_FILE_SECTION_COUNT], const MeshLod& lod0)
+	{
+		if (((header.flags & MESH_FILE_FLAG_MESHLET_ORDERED) != 0) != (header.meshletsCount != 0))
+			return false;
+
+		const Meshlet* meshlets = static_cast<const Meshlet*>(blobs[MESH_FILE_SECTION_MESHLETS]);
+		const uint32* meshletVertices = static_cast<const uint32*>(blobs[MESH_FILE_SECTION_MESHLET_VERTICES]);
+		const uint8* meshletTriangles = static_cast<const uint8*>(blobs[MESH_FILE_SECTION_MESHLET_TRIANGLES]);
+		uint64 trianglesSize = 3 * static_cast<uint64>(header.meshletTrianglesCount);
+
+		for (uint32 i = 0; i < header.meshletsCount; i++)
+		{
+			const Meshlet& meshlet = meshlets[i];
+			if (meshlet.vertexCount > MESHLET_MAX_VERTICES || meshlet.triangleCount > MESHLET_MAX_TRIANGLES)
+				return false;
+
+			uint64 verticesEnd = static_cast<uint64>(meshlet.vertexOffset) + meshlet.vertexCount;
+			uint64 trianglesEnd = static_cast<uint64>(meshlet.triangleOffset) + meshlet.triangleCount * 3u;
+			if (verticesEnd > header.meshletVerticesCount || trianglesEnd > trianglesSize)
+				return false;
+
+			if (meshlet.triangleOffset < lod0.indexOffset || trianglesEnd > static_cast<uint64>(lod0.indexOffset) + lod0.indicesCount)
+				return false;
+
+			for (uint32 j = 0; j < meshlet.vertexCount; j++)
+			{
+				if (meshletVertices[meshlet.vertexOffset + j] >= header.verticesCount)
+					return false;
+			}
+
+			for (uint32 j = 0; j < meshlet.triangleCount * 3u; j++)
+			{
+				if (meshletTriangles[meshlet.triangleOffset + j] >= meshlet.vertexCount)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	bool Write(const char* filename, const MeshData& meshData, const MeshLodChain* lodChain, const MeshletData* meshletData)
+	{
+		MeshFileHeader header;
+		header.verticesCount = meshData.verticesCount;
+		ComputeBounds(meshData, &header);
+
+		// A mesh without a chain is a single LOD.
+		MeshLod singleLod;
+		singleLod.indicesCount = meshData.indicesCount;
+
+		const Index* sourceIndices = lodChain ? lodChain->indices : meshData.indices;
+		const MeshLod* lods = lodChain ? lodChain->lods : &singleLod;
+		header.indicesCount = lodChain ? lodChain->indicesCount : meshData.indicesCount;
+		header.lodsCount = lodChain ? lodChain->lodsCount : 1;
+
+		std::vector<Index> indices(sourceIndices, sourceIndices + header.indicesCount);
+
+		if (meshletData && meshletData->meshletsCount)
+		{
+			if (meshletData->trianglesCount * 3 != lods[0].indicesCount)
+				return false;
+
+			MeshletBuilder::ExpandIndices(*meshletData, indices.data());
+			header.flags |= MESH_FILE_FLAG_MESHLET_ORDERED;
+			header.meshletsCount = meshletData->meshletsCount;
+			header.meshletVerticesCount = meshletData->verticesCount;
+			header.meshletTrianglesCount = meshletData->trianglesCount;
+		}
+
+		const void* blobs[MESH_FILE_SECTION_COUNT] = {};
+		uint64 sizes[MESH_FILE_SECTION_COUNT] = {};
+
+		blobs[MESH_FILE_SECTION_VERTICES] = meshData.vertices;
+		sizes[MESH_FILE_SECTION_VERTICES] = sizeof(Vertex) * static_cast<uint64>(meshData.verticesCount);
+		blobs[MESH_FILE_SECTION_INDICES] = indices.data();
+		sizes[MESH_FILE_SECTION_INDICES] = sizeof(Index) * static_cast<uint64>(indices.size());
+		blobs[MESH_FILE_SECTION_LODS] = lods;
+		sizes[MESH_FILE_SECTION_LODS] = sizeof(MeshLod) * static_cast<uint64>(header.lodsCount);
+
+		if (header.meshletsCount)
+		{
+			blobs[MESH_FILE_SECTION_MESHLETS] = meshletData->meshlets;
+			sizes[MESH_FILE_SECTION_MESHLETS] = sizeof(Meshlet) * static_cast<uint64>(meshletData->meshletsCount);
+			blobs[MESH_FILE_SECTION_MESHLET_BOUNDS] = meshletData->bounds;
+			sizes[MESH_FILE_SECTION_MESHLET_BOUNDS] = sizeof(MeshletBounds) * static_cast<uint64>(meshletData->meshletsCount);
+			blobs[MESH_FILE_SECTION_MESHLET_VERTICES] = meshletData->vertices;
+			sizes[MESH_FILE_SECTION_MESHLET_VERTICES] = sizeof(uint32) * static_cast<uint64>(meshletData->verticesCount);
+			blobs[MESH_FILE_SECTION_MESHLET_TRIANGLES] = meshletData->triangles;
+			sizes[MESH_FILE_SECTION_MESHLET_TRIANGLES] = 3 * static_cast<uint64>(meshletData->trianglesCount);
+		}
+
+		uint64 offset = AlignUp(sizeof(MeshFileHeader), MESH_FILE_ALIGNMENT);
+		for (uint32 i = 0; i < MESH_FILE_SECTION_COUNT; i++)
+		{
+			header.sections[i].offset = sizes[i] ? offset : 0;
+			header.sections[i].size = sizes[i];
+			offset = AlignUp(offset + sizes[i], MESH_FILE_ALIGNMENT);
+		}
+
+		FILE* file = Platform::OpenFile(filename, "wb");
+		if (file == nullptr)
+			return false;
+
+		static const uint8 zeros[MESH_FILE_ALIGNMENT] = {};
+		bool succeeded = fwrite(&header, sizeof(header), 1, file) == 1;
+		uint64 written = sizeof(header);
+
+		for (uint32 i = 0; i < MESH_FILE_SECTION_COUNT && succeeded; i++)
+		{
+			if (sizes[i] == 0)
+				continue;
+
+			uint64 padding = header.sections[i].offset - written;
+			succeeded = succeeded && (padding == 0 || fwrite(zeros, static_cast<size_t>(padding), 1, file) == 1);
+			succeeded = succeeded && fwrite(blobs[i], static_cast<size_t>(sizes[i]), 1, file) == 1;
+			written = header.sections[i].offset + sizes[i];
+		}
+
+		succeeded = fclose(file) == 0 && succeeded;
+		return succeeded;
+	}
+
+	bool Open(const char* filename, MeshFileView* outView)
+	{
+		FileMapping mapping;
+		if (!FileSystem::MapFile(filename, &mapping))
+			return false;
+
+		if (!Open(mapping, outView))
+		{
+			FileSystem::UnmapFile(&mapping);
+			return false;
+		}
+		return true;
+	}
+
+	bool Open(const FileMapping& mapping, MeshFileView* outView)
+	{
+		*outView = {};
+
+		if (mapping.size < sizeof(MeshFileHeader))
+			return false;
+
+		const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(mapping.data);
+		if (header->magic != MESH_FILE_MAGIC || header->version != MESH_FILE_VERSION || header->headerSize != sizeof(MeshFileHeader))
+			return false;
+
+		if (header->vertexStride != sizeof(Vertex) || header->lodsCount == 0 || header->lodsCount > MESH_MAX_LODS)
+			return false;
+
+		uint64 expectedSizes[MESH_FILE_SECTION_COUNT] = {};
+		expectedSizes[MESH_FILE_SECTION_VERTICES] = sizeof(Vertex) * static_cast<uint64>(header->verticesCount);
+		expectedSizes[MESH_FILE_SECTION_INDICES] = sizeof(Index) * static_cast<uint64>(header->indicesCount);
+		expectedSizes[MESH_FILE_SECTION_LODS] = sizeof(MeshLod) * static_cast<uint64>(header->lodsCount);
+		expectedSizes[MESH_FILE_SECTION_MESHLETS] = sizeof(Meshlet) * static_cast<uint64>(header->meshletsCount);
+		expectedSizes[MESH_FILE_SECTION_MESHLET_BOUNDS] = sizeof(MeshletBounds) * static_cast<uint64>(header->meshletsCount);
+		expectedSizes[MESH_FILE_SECTION_MESHLET_VERTICES] = sizeof(uint32) * static_cast<uint64>(header->meshletVerticesCount);
+		expectedSizes[MESH_FILE_SECTION_MESHLET_TRIANGLES] = 3 * static_cast<uint64>(header->meshletTrianglesCount);
+
+		const void* blobs[MESH_FILE_SECTION_COUNT] = {};
+		for (uint32 i = 0; i < MESH_FILE_SECTION_COUNT; i++)
+		{
+			const MeshFileSection& section = header->sections[i];
+			if (section.size != expectedSizes[i])
+				return false;
+
+			if (section.size == 0)
+				continue;
+
+			if (section.offset % MESH_FILE_ALIGNMENT != 0 || section.offset > mapping.size || section.size > mapping.size - section.offset)
+				return false;
+
+			blobs[i] = mapping.data + section.offset;
+		}
+
+		const MeshLod* lods = static_cast<const MeshLod*>(blobs[MESH_FILE_SECTION_LODS]);
+		for (uint32 i = 0; i < header->lodsCount; i++)
+		{
+			if (lods[i].indexOffset > header->indicesCount || lods[i].indicesCount > header->indicesCount - lods[i].indexOffset)
+				return false;
+		}
+
+		const Index* indices = static_cast<const Index*>(blobs[MESH_FILE_SECTION_INDICES]);
+		for (uint32 i = 0; i < header->indicesCount; i++)
+		{
+			if (indices[i] >= header->verticesCount)
+				return false;
+		}
+
+		if (!ValidateMeshlets(*header, blobs, lods[0]))
+			return false;
+
+		outView->mapping = mapping;
+		outView->header = header;
+		outView->vertices = static_cast<const Vertex*>(blobs[MESH_FILE_SECTION_VERTICES]);
+		outView->indices = static_cast<const Index*>(blobs[MESH_FILE_SECTION_INDICES]);
+		outView->lods = lods;
+		outView->meshlets = static_cast<const Meshlet*>(blobs[MESH_FILE_SECTION_MESHLETS]);
+		outView->meshletBounds = static_cast<const MeshletBounds*>(blobs[MESH_FILE_SECTION_MESHLET_BOUNDS]);
+		outView->meshletVertices = static_cast<const uint32*>(blobs[MESH_FILE_SECTION_MESHLET_VERTICES]);
+		outView->meshletTriangles = static_cast<const uint8*>(blobs[MESH_FILE_SECTION_MESHLET_TRIANGLES]);
+		return true;
+	}
+
+	void Close(MeshFileView* view)
+	{
+		FileSystem::UnmapFile(&view->mapping);
+		*view = {};
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Types.h"
+#include "Vertex.h"
+#include "FileMapping.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
+
+/*
+==========
+Mesh File
+==========
+*/
+
+// Cooked mesh container. Every blob starts on a MESH_FILE_ALIGNMENT boundary
+// so the runtime can hand pointers into the mapped file straight to memcpy
+// or SIMD code. Bump MESH_FILE_VERSION whenever the layout changes.
+const uint32 MESH_FILE_MAGIC = 0x48534d58;	// 'XMSH'
+const uint32 MESH_FILE_VERSION = 1;
+const uint32 MESH_FILE_ALIGNMENT = 64;
+
+// LOD 0 indices are stored in meshlet order.
+const uint32 MESH_FILE_FLAG_MESHLET_ORDERED = 0x1;
+
+enum MESH_FILE_SECTION
+{
+	MESH_FILE_SECTION_VERTICES,
+	MESH_FILE_SECTION_INDICES,
+	MESH_FILE_SECTION_LODS,
+	MESH_FILE_SECTION_MESHLETS,
+	MESH_FILE_SECTION_MESHLET_BOUNDS,
+	MESH_FILE_SECTION_MESHLET_VERTICES,
+	MESH_FILE_SECTION_MESHLET_TRIANGLES,
+	MESH_FILE_SECTION_COUNT,
+};
+
+struct MeshFileSection
+{
+	uint64 offset = 0;
+	uint64 size = 0;
+};
+
+struct MeshFileHeader
+{
+	uint32 magic = MESH_FILE_MAGIC;
+	uint32 version = MESH_FILE_VERSION;
+	uint32 headerSize = sizeof(MeshFileHeader);
+	uint32 flags = 0;
+
+	uint32 vertexStride = sizeof(Vertex);
+	uint32 verticesCount = 0;
+	uint32 indicesCount = 0;		// All LODs.
+	uint32 lodsCount = 0;
+
+	uint32 meshletsCount = 0;
+	uint32 meshletVerticesCount = 0;
+	uint32 meshletTrianglesCount = 0;
+	uint32 padding = 0;
+
+	Vector3 boundsMin = {};
+	Vector3 boundsMax = {};
+	Vector3 boundsCenter = {};
+	float boundsRadius = 0.0f;
+
+	MeshFileSection sections[MESH_FILE_SECTION_COUNT] = {};
+};
+
+// Pointers into the mapped file, valid until MeshFile::Close.
+struct MeshFileView
+{
+	FileMapping mapping = {};
+	const MeshFileHeader* header = nullptr;
+	const Vertex* vertices = nullptr;
+	const Index* indices = nullptr;
+	const MeshLod* lods = nullptr;
+	const Meshlet* meshlets = nullptr;
+	const MeshletBounds* meshletBounds = nullptr;
+	const uint32* meshletVertices = nullptr;
+	const uint8* meshletTriangles = nullptr;
+};
+
+/*
+==========
+MeshFile
+==========
+*/
+
+namespace MeshFile
+{
+	// lodChain and meshletData are optional. When meshletData is given, LOD 0 of
+	// lodChain (or meshData.indices) is rewritten in meshlet order.
+	bool Write(const char* filename, const MeshData& meshData, const MeshLodChain* lodChain, const MeshletData* meshletData);
+
+	// Maps the file and validates the header and every section against the file size.
+	bool Open(const char* filename, MeshFileView* outView);
+	bool Open(const FileMapping& mapping, MeshFileView* outView);
+	void Close(MeshFileView* view);
+}
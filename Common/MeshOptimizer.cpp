@@ -0,0 +1,351 @@
+#include "MeshOptimizer.h"
+#include "Hash.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+/*
+==================
+MeshOptimizer
+==================
+*/
+
+namespace MeshOptimizer
+{
+	static float Quantize(float value, float minValue, float extent, float steps)
+	{
+		if (extent <= 0.0f)
+			return value;
+
+		float q = floorf((value - minValue) / extent * steps + 0.5f);
+		return minValue + q * extent / steps;
+	}
+
+	void QuantizeVertices(MeshData* meshData)
+	{
+		if (meshData->verticesCount == 0)
+			return;
+
+		Vector3 minPos = meshData->vertices[0].posModel;
+		Vector3 maxPos = minPos;
+		Vector2 minUV = meshData->vertices[0].texCoord;
+		Vector2 maxUV = minUV;
+		for (uint32 i = 1; i < meshData->verticesCount; i++)
+		{
+			const Vertex& vertex = meshData->vertices[i];
+			minPos = Vector3::Min(minPos, vertex.posModel);
+			maxPos = Vector3::Max(maxPos, vertex.posModel);
+			minUV.x = vertex.texCoord.x < minUV.x ? vertex.texCoord.x : minUV.x;
+			minUV.y = vertex.texCoord.y < minUV.y ? vertex.texCoord.y : minUV.y;
+			maxUV.x = vertex.texCoord.x > maxUV.x ? vertex.texCoord.x : maxUV.x;
+			maxUV.y = vertex.texCoord.y > maxUV.y ? vertex.texCoord.y : maxUV.y;
+		}
+
+		// A uniform grid keeps the mesh's proportions exact.
+		Vector3 extent = maxPos - minPos;
+		float maxExtent = extent.x > extent.y ? extent.x : extent.y;
+		maxExtent = extent.z > maxExtent ? extent.z : maxExtent;
+
+		for (uint32 i = 0; i < meshData->verticesCount; i++)
+		{
+			Vertex& vertex = meshData->vertices[i];
+			vertex.posModel.x = Quantize(vertex.posModel.x, minPos.x, maxExtent, 65535.0f);
+			vertex.posModel.y = Quantize(vertex.posModel.y, minPos.y, maxExtent, 65535.0f);
+			vertex.posModel.z = Quantize(vertex.posModel.z, minPos.z, maxExtent, 65535.0f);
+			vertex.texCoord.x = Quantize(vertex.texCoord.x, minUV.x, maxUV.x - minUV.x, 65535.0f);
+			vertex.texCoord.y = Quantize(vertex.texCoord.y, minUV.y, maxUV.y - minUV.y, 65535.0f);
+			vertex.color.x = Quantize(vertex.color.x, 0.0f, 1.0f, 255.0f);
+			vertex.color.y = Quantize(vertex.color.y, 0.0f, 1.0f, 255.0f);
+			vertex.color.z = Quantize(vertex.color.z, 0.0f, 1.0f, 255.0f);
+			vertex.color.w = Quantize(vertex.color.w, 0.0f, 1.0f, 255.0f);
+		}
+	}
+
+	struct VertexHasher
+	{
+		const Vertex* vertices;
+
+		size_t operator()(uint32 index) const
+		{
+			return static_cast<size_t>(HashValue(vertices[index]));
+		}
+	};
+
+	struct VertexEqual
+	{
+		const Vertex* vertices;
+
+		bool operator()(uint32 lhs, uint32 rhs) const
+		{
+			return ::memcmp(&vertices[lhs], &vertices[rhs], sizeof(Vertex)) == 0;
+		}
+	};
+
+	void WeldVertices(MeshData* meshData)
+	{
+		uint32 verticesCount = meshData->verticesCount;
+		if (verticesCount == 0)
+			return;
+
+		std::unordered_map<uint32, uint32, VertexHasher, VertexEqual> unique(verticesCount, VertexHasher{ meshData->vertices }, VertexEqual{ meshData->vertices });
+
+		// First occurrence wins, so the output order follows the input order.
+		std::vector<uint32> remap(verticesCount);
+		uint32 uniqueCount = 0;
+		for (uint32 i = 0; i < verticesCount; i++)
+		{
+			auto result = unique.emplace(i, uniqueCount);
+			if (result.second)
+				uniqueCount++;
+
+			remap[i] = result.first->second;
+		}
+
+		Vertex* vertices = new Vertex[uniqueCount];
+		for (uint32 i = 0; i < verticesCount; i++)
+		{
+			vertices[remap[i]] = meshData->vertices[i];
+		}
+
+		if (meshData->indices == nullptr)
+		{
+			meshData->indices = new Index[verticesCount];
+			meshData->indicesCount = verticesCount;
+			meshData->indicesSize = sizeof(Index) * verticesCount;
+			for (uint32 i = 0; i < verticesCount; i++)
+			{
+				meshData->indices[i] = i;
+			}
+		}
+
+		for (uint32 i = 0; i < meshData->indicesCount; i++)
+		{
+			meshData->indices[i] = remap[meshData->indices[i]];
+		}
+
+		delete[] meshData->vertices;
+		meshData->vertices = vertices;
+		meshData->verticesCount = uniqueCount;
+		meshData->verticesSize = sizeof(Vertex) * uniqueCount;
+	}
+
+	/*
+	Forsyth, "Linear-Speed Vertex Cache Optimisation".
+	*/
+	const uint32 CACHE_SIZE = 32;
+	const float CACHE_DECAY_POWER = 1.5f;
+	const float LAST_TRIANGLE_SCORE = 0.75f;
+	const float VALENCE_BOOST_SCALE = 2.0f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+
+	static float ComputeVertexScore(int32 cachePosition, uint32 remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				float scaler = 1.0f / (CACHE_SIZE - 3);
+				score = powf(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+			}
+		}
+
+		score += VALENCE_BOOST_SCALE * powf(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+		return score;
+	}
+
+	void OptimizeVertexCache(Index* indices, uint32 indicesCount, uint32 verticesCount)
+	{
+		uint32 trianglesCount = indicesCount / 3;
+		if (trianglesCount == 0)
+			return;
+
+		std::vector<uint32> adjacencyOffsets(verticesCount + 1, 0);
+		for (uint32 i = 0; i < trianglesCount * 3; i++)
+		{
+			adjacencyOffsets[indices[i] + 1]++;
+		}
+		for (uint32 i = 0; i < verticesCount; i++)
+		{
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		}
+
+		std::vector<uint32> remaining(verticesCount, 0);
+		std::vector<uint32> adjacency(trianglesCount * 3);
+		for (uint32 i = 0; i < trianglesCount * 3; i++)
+		{
+			uint32 vertex = indices[i];
+			adjacency[adjacencyOffsets[vertex] + remaining[vertex]++] = i / 3;
+		}
+
+		std::vector<int32> cachePosition(verticesCount, -1);
+		std::vector<float> vertexScores(verticesCount);
+		for (uint32 i = 0; i < verticesCount; i++)
+		{
+			vertexScores[i] = ComputeVertexScore(-1, remaining[i]);
+		}
+
+		std::vector<float> triangleScores(trianglesCount);
+		for (uint32 i = 0; i < trianglesCount; i++)
+		{
+			triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+		}
+
+		std::vector<uint8> emitted(trianglesCount, 0);
+		std::vector<Index> output(trianglesCount * 3);
+
+		uint32 cache[CACHE_SIZE + 3];
+		uint32 cacheCount = 0;
+		uint32 newCache[CACHE_SIZE + 3];
+
+		uint32 bestTriangle = 0;
+		uint32 scanCursor = 0;
+
+		for (uint32 outputTriangle = 0; outputTriangle < trianglesCount; outputTriangle++)
+		{
+			if (bestTriangle == UINT32_MAX)
+			{
+				// Nothing in the cache has triangles left; restart from the next unemitted one.
+				while (emitted[scanCursor])
+				{
+					scanCursor++;
+				}
+				bestTriangle = scanCursor;
+			}
+
+			emitted[bestTriangle] = 1;
+			const Index* tri = &indices[bestTriangle * 3];
+			::memcpy(&output[outputTriangle * 3], tri, sizeof(Index) * 3);
+
+			// Move the triangle's vertices to the front of the LRU cache.
+			uint32 newCacheCount = 0;
+			for (uint32 i = 0; i < 3; i++)
+			{
+				newCache[newCacheCount++] = tri[i];
+
+				// Remove the emitted triangle from the vertex's live list.
+				uint32 vertex = tri[i];
+				uint32* list = &adjacency[adjacencyOffsets[vertex]];
+				for (uint32 j = 0; j < remaining[vertex]; j++)
+				{
+					if (list[j] == bestTriangle)
+					{
+						list[j] = list[remaining[vertex] - 1];
+						break;
+					}
+				}
+				remaining[vertex]--;
+			}
+			for (uint32 i = 0; i < cacheCount; i++)
+			{
+				uint32 vertex = cache[i];
+				if (vertex != tri[0] && vertex != tri[1] && vertex != tri[2])
+					newCache[newCacheCount++] = vertex;
+			}
+
+			for (uint32 i = CACHE_SIZE; i < newCacheCount; i++)
+			{
+				cachePosition[newCache[i]] = -1;
+			}
+			cacheCount = newCacheCount < CACHE_SIZE ? newCacheCount : CACHE_SIZE;
+			::memcpy(cache, newCache, sizeof(uint32) * cacheCount);
+
+			// Rescore vertices and triangles around the cache.
+			for (uint32 i = 0; i < newCacheCount; i++)
+			{
+				uint32 vertex = newCache[i];
+				int32 position = i < CACHE_SIZE ? static_cast<int32>(i) : -1;
+				cachePosition[vertex] = position;
+
+				float delta = ComputeVertexScore(position, remaining[vertex]) - vertexScores[vertex];
+				vertexScores[vertex] += delta;
+
+				for (uint32 j = 0; j < remaining[vertex]; j++)
+				{
+					triangleScores[adjacency[adjacencyOffsets[vertex] + j]] += delta;
+				}
+			}
+
+			// Best candidate among triangles touching the cache; ties go to the lowest index.
+			bestTriangle = UINT32_MAX;
+			float bestScore = -1.0f;
+			for (uint32 i = 0; i < cacheCount; i++)
+			{
+				uint32 vertex = cache[i];
+				for (uint32 j = 0; j < remaining[vertex]; j++)
+				{
+					uint32 triangle = adjacency[adjacencyOffsets[vertex] + j];
+					float score = triangleScores[triangle];
+					if (score > bestScore || (score == bestScore && triangle < bestTriangle))
+					{
+						bestScore = score;
+						bestTriangle = triangle;
+					}
+				}
+			}
+		}
+
+		::memcpy(indices, output.data(), sizeof(Index) * trianglesCount * 3);
+	}
+
+	void OptimizeVertexFetch(MeshData* meshData)
+	{
+		std::vector<uint32> remap(meshData->verticesCount, UINT32_MAX);
+		uint32 nextVertex = 0;
+
+		for (uint32 i = 0; i < meshData->indicesCount; i++)
+		{
+			Index& index = meshData->indices[i];
+			if (remap[index] == UINT32_MAX)
+				remap[index] = nextVertex++;
+
+			index = remap[index];
+		}
+
+		// Vertices no index refers to are dropped.
+		Vertex* vertices = new Vertex[nextVertex];
+		for (uint32 i = 0; i < meshData->verticesCount; i++)
+		{
+			if (remap[i] != UINT32_MAX)
+				vertices[remap[i]] = meshData->vertices[i];
+		}
+
+		delete[] meshData->vertices;
+		meshData->vertices = vertices;
+		meshData->verticesCount = nextVertex;
+		meshData->verticesSize = sizeof(Vertex) * nextVertex;
+	}
+
+	float AnalyzeVertexCache(const Index* indices, uint32 indicesCount, uint32 verticesCount, uint32 cacheSize)
+	{
+		if (indicesCount < 3)
+			return 0.0f;
+
+		// Timestamp FIFO: a vertex is cached if it entered within the last cacheSize misses.
+		std::vector<uint32> timestamps(verticesCount, 0);
+		uint32 time = cacheSize + 1;
+		uint32 misses = 0;
+
+		for (uint32 i = 0; i < indicesCount; i++)
+		{
+			uint32 vertex = indices[i];
+			if (time - timestamps[vertex] > cacheSize)
+			{
+				timestamps[vertex] = time++;
+				misses++;
+			}
+		}
+
+		return static_cast<float>(misses) / (indicesCount / 3);
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Types.h"
+#include "Vertex.h"
+
+/*
+==================
+MeshOptimizer
+==================
+*/
+
+// Offline passes run by the cooker. All of them work in place on MeshData
+// buffers allocated with new[] and are deterministic.
+namespace MeshOptimizer
+{
+	// Snaps attributes to the precision of a packed vertex format (16-bit
+	// positions and texcoords over their bounds, 8-bit colors), so vertices
+	// that only differ by noise weld together.
+	void QuantizeVertices(MeshData* meshData);
+
+	// Merges bit-identical vertices. Builds an index buffer when the mesh has none.
+	void WeldVertices(MeshData* meshData);
+
+	// Reorders triangles for the post-transform vertex cache (Forsyth).
+	void OptimizeVertexCache(Index* indices, uint32 indicesCount, uint32 verticesCount);
+
+	// Reorders vertices by first use so vertex fetch walks memory linearly.
+	void OptimizeVertexFetch(MeshData* meshData);
+
+	// Average cache miss ratio (ACMR) for a FIFO cache, for reporting.
+	float AnalyzeVertexCache(const Index* indices, uint32 indicesCount, uint32 verticesCount, uint32 cacheSize = 16);
+}
@@ -0,0 +1,428 @@
+#include "MeshSimplifier.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+/*
+==================
+MeshSimplifier
+==================
+*/
+
+namespace MeshSimplifier
+{
+	// Symmetric 4x4 plane quadric, weighted by triangle area.
+	struct Quadric
+	{
+		double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+		double b2 = 0.0, bc = 0.0, bd = 0.0;
+		double c2 = 0.0, cd = 0.0;
+		double d2 = 0.0;
+		double weight = 0.0;
+
+		void Add(const Quadric& q)
+		{
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+			weight += q.weight;
+		}
+
+		// Mean squared distance of p to the accumulated planes.
+		double Error(const Vector3& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double error = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+				+ b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+				+ c2 * z * z + 2.0 * cd * z
+				+ d2;
+			error = error < 0.0 ? 0.0 : error;
+			return weight > 0.0 ? error / weight : 0.0;
+		}
+	};
+
+	struct Collapse
+	{
+		uint32 from = 0;
+		uint32 to = 0;
+		double error = 0.0;
+	};
+
+	static Quadric MakePlaneQuadric(const Vector3& p0, const Vector3& p1, const Vector3& p2)
+	{
+		Quadric q;
+
+		Vector3 normal = (p1 - p0).Cross(p2 - p0);
+		double length = normal.Length();
+		if (length <= 0.0)
+			return q;
+
+		double a = normal.x / length;
+		double b = normal.y / length;
+		double c = normal.z / length;
+		double d = -(a * p0.x + b * p0.y + c * p0.z);
+		double area = length * 0.5;
+
+		q.a2 = a * a * area; q.ab = a * b * area; q.ac = a * c * area; q.ad = a * d * area;
+		q.b2 = b * b * area; q.bc = b * c * area; q.bd = b * d * area;
+		q.c2 = c * c * area; q.cd = c * d * area;
+		q.d2 = d * d * area;
+		q.weight = area;
+		return q;
+	}
+
+	// Maps every vertex to the lowest index sharing its position, so attribute
+	// seams are treated as one point by the simplifier.
+	static void BuildPositionRemap(const MeshData& meshData, std::vector<uint32>& outRemap)
+	{
+		std::vector<uint32> order(meshData.verticesCount);
+		for (uint32 i = 0; i < meshData.verticesCount; i++)
+		{
+			order[i] = i;
+		}
+
+		const Vertex* vertices = meshData.vertices;
+		std::sort(order.begin(), order.end(), [vertices](uint32 lhs, uint32 rhs)
+		{
+			const Vector3& a = vertices[lhs].posModel;
+			const Vector3& b = vertices[rhs].posModel;
+			if (a.x != b.x) return a.x < b.x;
+			if (a.y != b.y) return a.y < b.y;
+			if (a.z != b.z) return a.z < b.z;
+			return lhs < rhs;
+		});
+
+		outRemap.resize(meshData.verticesCount);
+		for (uint32 i = 0; i < meshData.verticesCount; )
+		{
+			uint32 first = order[i];
+			uint32 j = i;
+			while (j < meshData.verticesCount && ::memcmp(&vertices[order[j]].posModel, &vertices[first].posModel, sizeof(Vector3)) == 0)
+			{
+				outRemap[order[j]] = first;
+				j++;
+			}
+			i = j;
+		}
+	}
+
+	// Locks vertices on open borders and on attribute seams.
+	static void ClassifyVertices(const MeshData& meshData, const Index* indices, uint32 indicesCount, const std::vector<uint32>& remap, std::vector<uint8>& outLocked)
+	{
+		outLocked.assign(meshData.verticesCount, 0);
+
+		for (uint32 i = 0; i < meshData.verticesCount; i++)
+		{
+			if (remap[i] != i)
+			{
+				outLocked[i] = 1;
+				outLocked[remap[i]] = 1;
+			}
+		}
+
+		// An edge used by a single triangle (in position space) is a border.
+		std::vector<uint64> edges;
+		edges.reserve(indicesCount);
+		for (uint32 i = 0; i < indicesCount; i += 3)
+		{
+			for (uint32 e = 0; e < 3; e++)
+			{
+				uint32 a = remap[indices[i + e]];
+				uint32 b = remap[indices[i + (e + 1) % 3]];
+				uint32 lo = a < b ? a : b;
+				uint32 hi = a < b ? b : a;
+				edges.push_back((static_cast<uint64>(lo) << 32) | hi);
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+
+		for (size_t i = 0; i < edges.size(); )
+		{
+			size_t j = i;
+			while (j < edges.size() && edges[j] == edges[i])
+			{
+				j++;
+			}
+
+			if (j - i == 1)
+			{
+				outLocked[static_cast<uint32>(edges[i] >> 32)] = 1;
+				outLocked[static_cast<uint32>(edges[i] & 0xffffffff)] = 1;
+			}
+			i = j;
+		}
+
+		for (uint32 i = 0; i < meshData.verticesCount; i++)
+		{
+			if (outLocked[remap[i]])
+				outLocked[i] = 1;
+		}
+	}
+
+	// Rejects collapses that would flip or degenerate a surviving triangle.
+	static bool CollapseFlipsTriangle(const MeshData& meshData, const std::vector<Index>& triangles, const std::vector<uint32>& adjacencyOffsets, const std::vector<uint32>& adjacency, uint32 from, uint32 to)
+	{
+		const Vector3& target = meshData.vertices[to].posModel;
+
+		for (uint32 i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++)
+		{
+			const Index* tri = &triangles[adjacency[i] * 3];
+			if (tri[0] == to || tri[1] == to || tri[2] == to)
+				continue;
+
+			Vector3 p[3] = { meshData.vertices[tri[0]].posModel, meshData.vertices[tri[1]].posModel, meshData.vertices[tri[2]].posModel };
+			Vector3 before = (p[1] - p[0]).Cross(p[2] - p[0]);
+
+			for (uint32 k = 0; k < 3; k++)
+			{
+				if (tri[k] == from)
+					p[k] = target;
+			}
+			Vector3 after = (p[1] - p[0]).Cross(p[2] - p[0]);
+
+			// Turning a normal by more than about 75 degrees counts as a flip, so
+			// steps across passes cannot add up to a triangle standing on edge.
+			if (before.Dot(after) <= 0.25f * before.Length() * after.Length())
+				return true;
+		}
+		return false;
+	}
+
+	uint32 Simplify(const MeshData& meshData, const Index* indices, uint32 indicesCount, uint32 targetIndicesCount, float maxError, Index* outIndices, float* outError)
+	{
+		std::vector<Index> triangles(indices, indices + indicesCount);
+		float resultError = 0.0f;
+
+		std::vector<uint32> remap;
+		std::vector<uint8> locked;
+		BuildPositionRemap(meshData, remap);
+		ClassifyVertices(meshData, indices, indicesCount, remap, locked);
+
+		std::vector<Quadric> quadrics(meshData.verticesCount);
+		for (uint32 i = 0; i < indicesCount; i += 3)
+		{
+			Quadric q = MakePlaneQuadric(meshData.vertices[indices[i]].posModel, meshData.vertices[indices[i + 1]].posModel, meshData.vertices[indices[i + 2]].posModel);
+			quadrics[remap[indices[i]]].Add(q);
+			quadrics[remap[indices[i + 1]]].Add(q);
+			quadrics[remap[indices[i + 2]]].Add(q);
+		}
+
+		double maxErrorSq = static_cast<double>(maxError) * maxError;
+
+		std::vector<Collapse> collapses;
+		std::vector<uint32> adjacencyOffsets;
+		std::vector<uint32> adjacency;
+		std::vector<uint32> collapseTarget(meshData.verticesCount);
+		std::vector<uint8> touched(meshData.verticesCount);
+
+		while (triangles.size() > targetIndicesCount)
+		{
+			uint32 trianglesCount = static_cast<uint32>(triangles.size() / 3);
+
+			// Vertex to triangle adjacency for the flip test.
+			adjacencyOffsets.assign(meshData.verticesCount + 1, 0);
+			for (Index index : triangles)
+			{
+				adjacencyOffsets[index + 1]++;
+			}
+			for (uint32 i = 0; i < meshData.verticesCount; i++)
+			{
+				adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+			}
+			adjacency.resize(triangles.size());
+			std::vector<uint32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32 i = 0; i < triangles.size(); i++)
+			{
+				adjacency[fill[triangles[i]]++] = i / 3;
+			}
+
+			// Cheapest direction of every edge whose source vertex may move.
+			collapses.clear();
+			for (uint32 i = 0; i < triangles.size(); i += 3)
+			{
+				for (uint32 e = 0; e < 3; e++)
+				{
+					uint32 a = triangles[i + e];
+					uint32 b = triangles[i + (e + 1) % 3];
+					if (locked[a] && locked[b])
+						continue;
+
+					Quadric q = quadrics[remap[a]];
+					q.Add(quadrics[remap[b]]);
+
+					double errorAB = locked[a] ? 1e30 : q.Error(meshData.vertices[b].posModel);
+					double errorBA = locked[b] ? 1e30 : q.Error(meshData.vertices[a].posModel);
+
+					Collapse collapse;
+					collapse.from = errorAB <= errorBA ? a : b;
+					collapse.to = errorAB <= errorBA ? b : a;
+					collapse.error = errorAB <= errorBA ? errorAB : errorBA;
+					collapses.push_back(collapse);
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs)
+			{
+				if (lhs.error != rhs.error) return lhs.error < rhs.error;
+				if (lhs.from != rhs.from) return lhs.from < rhs.from;
+				return lhs.to < rhs.to;
+			});
+
+			for (uint32 i = 0; i < meshData.verticesCount; i++)
+			{
+				collapseTarget[i] = i;
+			}
+			std::fill(touched.begin(), touched.end(), 0);
+
+			// Each collapse removes about two triangles; stop once the target is met.
+			uint32 trianglesToRemove = (static_cast<uint32>(triangles.size()) - targetIndicesCount) / 3;
+			uint32 removedEstimate = 0;
+			uint32 appliedCount = 0;
+
+			for (const Collapse& collapse : collapses)
+			{
+				if (collapse.error > maxErrorSq || removedEstimate >= trianglesToRemove)
+					break;
+
+				if (touched[collapse.from] || touched[collapse.to])
+					continue;
+
+				if (CollapseFlipsTriangle(meshData, triangles, adjacencyOffsets, adjacency, collapse.from, collapse.to))
+					continue;
+
+				collapseTarget[collapse.from] = collapse.to;
+				quadrics[remap[collapse.to]].Add(quadrics[remap[collapse.from]]);
+
+				// Neighbours are frozen for the rest of the pass since the flip
+				// test above assumed their positions.
+				for (uint32 j = adjacencyOffsets[collapse.from]; j < adjacencyOffsets[collapse.from + 1]; j++)
+				{
+					const Index* tri = &triangles[adjacency[j] * 3];
+					touched[tri[0]] = 1;
+					touched[tri[1]] = 1;
+					touched[tri[2]] = 1;
+				}
+
+				float error = static_cast<float>(sqrt(collapse.error));
+				resultError = error > resultError ? error : resultError;
+
+				removedEstimate += 2;
+				appliedCount++;
+			}
+
+			if (appliedCount == 0)
+				break;
+
+			// Apply the collapses and drop triangles that became degenerate.
+			uint32 writeCount = 0;
+			for (uint32 i = 0; i < trianglesCount; i++)
+			{
+				Index a = collapseTarget[triangles[i * 3 + 0]];
+				Index b = collapseTarget[triangles[i * 3 + 1]];
+				Index c = collapseTarget[triangles[i * 3 + 2]];
+
+				if (remap[a] == remap[b] || remap[b] == remap[c] || remap[a] == remap[c])
+					continue;
+
+				triangles[writeCount * 3 + 0] = a;
+				triangles[writeCount * 3 + 1] = b;
+				triangles[writeCount * 3 + 2] = c;
+				writeCount++;
+			}
+			triangles.resize(writeCount * 3);
+		}
+
+		if (triangles.size())
+		{
+			::memcpy(outIndices, triangles.data(), sizeof(Index) * triangles.size());
+		}
+
+		if (outError)
+		{
+			*outError = resultError;
+		}
+
+		return static_cast<uint32>(triangles.size());
+	}
+
+	bool BuildLodChain(const MeshData& meshData, MeshLodChain* outLodChain)
+	{
+		*outLodChain = {};
+
+		if (meshData.indicesCount == 0)
+			return false;
+
+		// Worst case every LOD is as large as the source mesh.
+		std::vector<Index> indices(meshData.indices, meshData.indices + meshData.indicesCount);
+
+		MeshLod* lods = outLodChain->lods;
+		lods[0].indexOffset = 0;
+		lods[0].indicesCount = meshData.indicesCount;
+		lods[0].error = 0.0f;
+		outLodChain->lodsCount = 1;
+
+		const float maxError = 1e30f;
+		const uint32 minIndicesCount = 3 * 32;
+
+		while (outLodChain->lodsCount < MESH_MAX_LODS)
+		{
+			const MeshLod& prev = lods[outLodChain->lodsCount - 1];
+			if (prev.indicesCount <= minIndicesCount)
+				break;
+
+			uint32 target = (prev.indicesCount / 3 / 2) * 3;
+			uint32 offset = static_cast<uint32>(indices.size());
+			indices.resize(offset + prev.indicesCount);
+
+			float error = 0.0f;
+			uint32 count = Simplify(meshData, &indices[prev.indexOffset], prev.indicesCount, target, maxError, &indices[offset], &error);
+
+			// Stop when the simplifier got stuck on locked vertices.
+			if (count == 0 || count > prev.indicesCount * 3 / 4)
+			{
+				indices.resize(offset);
+				break;
+			}
+			indices.resize(offset + count);
+
+			MeshLod& lod = lods[outLodChain->lodsCount++];
+			lod.indexOffset = offset;
+			lod.indicesCount = count;
+			lod.error = error > prev.error ? error : prev.error;
+		}
+
+		outLodChain->indicesCount = static_cast<uint32>(indices.size());
+		outLodChain->indices = new Index[outLodChain->indicesCount];
+		::memcpy(outLodChain->indices, indices.data(), sizeof(Index) * indices.size());
+
+		return true;
+	}
+
+	void Destroy(MeshLodChain* lodChain)
+	{
+		if (lodChain->indices)
+		{
+			delete[] lodChain->indices;
+			lodChain->indices = nullptr;
+		}
+
+		lodChain->indicesCount = 0;
+		lodChain->lodsCount = 0;
+	}
+
+	uint32 SelectLod(const MeshLodChain& lodChain, float pixelsPerUnit, float maxPixelError)
+	{
+		uint32 lod = 0;
+		for (uint32 i = 1; i < lodChain.lodsCount; i++)
+		{
+			if (lodChain.lods[i].error * pixelsPerUnit > maxPixelError)
+				break;
+
+			lod = i;
+		}
+		return lod;
+	}
+}
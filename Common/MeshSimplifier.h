@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Types.h"
+#include "Vertex.h"
+
+/*
+========
+Mesh LOD
+========
+*/
+
+const uint32 MESH_MAX_LODS = 5;
+
+struct MeshLod
+{
+	uint32 indexOffset = 0;
+	uint32 indicesCount = 0;
+	float error = 0.0f;		// Geometric deviation from LOD 0 in model units.
+};
+
+// All LODs index the original vertex buffer, so only the index buffer grows.
+struct MeshLodChain
+{
+	Index* indices = nullptr;
+	uint32 indicesCount = 0;
+	MeshLod lods[MESH_MAX_LODS] = {};
+	uint32 lodsCount = 0;
+};
+
+/*
+==================
+MeshSimplifier
+==================
+*/
+
+namespace MeshSimplifier
+{
+	// Quadric error metric edge collapse restricted to existing vertex positions.
+	// Border and attribute seam vertices are locked. Returns the number of indices
+	// written to outIndices, which must hold indicesCount entries.
+	uint32 Simplify(const MeshData& meshData, const Index* indices, uint32 indicesCount, uint32 targetIndicesCount, float maxError, Index* outIndices, float* outError);
+
+	// LOD 0 is the source mesh; every following LOD halves the triangle count until
+	// the simplifier stops making progress.
+	bool BuildLodChain(const MeshData& meshData, MeshLodChain* outLodChain);
+	void Destroy(MeshLodChain* lodChain);
+
+	// Picks the coarsest LOD whose error stays below maxPixelError once projected.
+	// pixelsPerUnit is the screen-space size of one model unit at the mesh's depth.
+	uint32 SelectLod(const MeshLodChain& lodChain, float pixelsPerUnit, float maxPixelError = 1.0f);
+}
@@ -0,0 +1,423 @@
+#include "MeshletBuilder.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+/*
+==================
+MeshletBuilder
+==================
+*/
+
+namespace MeshletBuilder
+{
+	const uint8 INVALID_LOCAL_INDEX = 0xff;
+
+	static Vector3 ComputeTriangleNormal(const Vector3& a, const Vector3& b, const Vector3& c)
+	{
+		// Clockwise triangles are front facing, matching the default rasterizer state.
+		Vector3 normal = (b - a).Cross(c - a);
+		float length = normal.Length();
+		return length > 0.0f ? normal / length : Vector3(0.0f, 0.0f, 0.0f);
+	}
+
+	static int8 QuantizeSnorm8(float value)
+	{
+		float scaled = value * 127.0f;
+		scaled = scaled < -127.0f ? -127.0f : (scaled > 127.0f ? 127.0f : scaled);
+		return static_cast<int8>(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+	}
+
+	static void ComputeBounds(const MeshData& meshData, const MeshletData& meshletData, const Meshlet& meshlet, MeshletBounds* outBounds)
+	{
+		const uint32* vertices = meshletData.vertices + meshlet.vertexOffset;
+		const uint8* triangles = meshletData.triangles + meshlet.triangleOffset;
+
+		// Ritter's bounding sphere: start from an approximate diameter and grow.
+		Vector3 p0 = meshData.vertices[vertices[0]].posModel;
+		Vector3 p1 = p0;
+		float maxDistSq = 0.0f;
+		for (uint32 i = 0; i < meshlet.vertexCount; i++)
+		{
+			const Vector3& p = meshData.vertices[vertices[i]].posModel;
+			float distSq = (p - p0).LengthSquared();
+			if (distSq > maxDistSq)
+			{
+				maxDistSq = distSq;
+				p1 = p;
+			}
+		}
+
+		Vector3 p2 = p1;
+		maxDistSq = 0.0f;
+		for (uint32 i = 0; i < meshlet.vertexCount; i++)
+		{
+			const Vector3& p = meshData.vertices[vertices[i]].posModel;
+			float distSq = (p - p1).LengthSquared();
+			if (distSq > maxDistSq)
+			{
+				maxDistSq = distSq;
+				p2 = p;
+			}
+		}
+
+		Vector3 center = (p1 + p2) * 0.5f;
+		float radius = sqrtf(maxDistSq) * 0.5f;
+		for (uint32 i = 0; i < meshlet.vertexCount; i++)
+		{
+			const Vector3& p = meshData.vertices[vertices[i]].posModel;
+			float dist = (p - center).Length();
+			if (dist > radius)
+			{
+				float newRadius = (radius + dist) * 0.5f;
+				center += (p - center) * ((newRadius - radius) / dist);
+				radius = newRadius;
+			}
+		}
+
+		outBounds->center = center;
+		outBounds->radius = radius;
+
+		// Normal cone from the average face normal.
+		Vector3 axis = Vector3(0.0f, 0.0f, 0.0f);
+		for (uint32 i = 0; i < meshlet.triangleCount; i++)
+		{
+			const Vector3& a = meshData.vertices[vertices[triangles[i * 3 + 0]]].posModel;
+			const Vector3& b = meshData.vertices[vertices[triangles[i * 3 + 1]]].posModel;
+			const Vector3& c = meshData.vertices[vertices[triangles[i * 3 + 2]]].posModel;
+			axis += ComputeTriangleNormal(a, b, c);
+		}
+
+		outBounds->coneAxis[0] = 0;
+		outBounds->coneAxis[1] = 0;
+		outBounds->coneAxis[2] = 0;
+		outBounds->coneCutoff = 127;
+
+		float axisLength = axis.Length();
+		if (axisLength <= 0.0f)
+			return;
+
+		axis = axis / axisLength;
+
+		float minDot = 1.0f;
+		for (uint32 i = 0; i < meshlet.triangleCount; i++)
+		{
+			const Vector3& a = meshData.vertices[vertices[triangles[i * 3 + 0]]].posModel;
+			const Vector3& b = meshData.vertices[vertices[triangles[i * 3 + 1]]].posModel;
+			const Vector3& c = meshData.vertices[vertices[triangles[i * 3 + 2]]].posModel;
+			Vector3 normal = ComputeTriangleNormal(a, b, c);
+			float dot = normal.Dot(axis);
+			minDot = dot < minDot ? dot : minDot;
+		}
+
+		// A cone wider than a hemisphere can never be entirely backfacing.
+		if (minDot <= 0.0f)
+			return;
+
+		float cutoff = sqrtf(1.0f - minDot * minDot);
+
+		int8 quantizedAxis[3] = { QuantizeSnorm8(axis.x), QuantizeSnorm8(axis.y), QuantizeSnorm8(axis.z) };
+		Vector3 dequantizedAxis = Vector3(quantizedAxis[0] / 127.0f, quantizedAxis[1] / 127.0f, quantizedAxis[2] / 127.0f);
+
+		// Widen the cone by the quantization error so culling stays conservative.
+		float axisError = (dequantizedAxis - axis).Length();
+		float quantizedCutoff = ceilf((cutoff + axisError) * 127.0f);
+		if (quantizedCutoff >= 127.0f)
+			return;
+
+		outBounds->coneAxis[0] = quantizedAxis[0];
+		outBounds->coneAxis[1] = quantizedAxis[1];
+		outBounds->coneAxis[2] = quantizedAxis[2];
+		outBounds->coneCutoff = static_cast<int8>(quantizedCutoff);
+	}
+
+	bool Build(const MeshData& meshData, MeshletData* outMeshletData)
+	{
+		*outMeshletData = {};
+
+		uint32 trianglesCount = meshData.indicesCount / 3;
+		if (trianglesCount == 0 || meshData.verticesCount == 0)
+			return false;
+
+		const Index* indices = meshData.indices;
+
+		// Vertex to triangle adjacency.
+		std::vector<uint32> adjacencyOffsets(meshData.verticesCount + 1, 0);
+		for (uint32 i = 0; i < trianglesCount * 3; i++)
+		{
+			if (indices[i] >= meshData.verticesCount)
+				return false;
+
+			adjacencyOffsets[indices[i] + 1]++;
+		}
+		for (uint32 i = 0; i < meshData.verticesCount; i++)
+		{
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		}
+
+		std::vector<uint32> adjacency(trianglesCount * 3);
+		std::vector<uint32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32 i = 0; i < trianglesCount * 3; i++)
+		{
+			adjacency[fill[indices[i]]++] = i / 3;
+		}
+
+		std::vector<uint8> emitted(trianglesCount, 0);
+		std::vector<uint8> localIndex(meshData.verticesCount, INVALID_LOCAL_INDEX);
+
+		std::vector<Meshlet> meshlets;
+		std::vector<uint32> meshletVertices;
+		std::vector<uint8> meshletTriangles;
+
+		meshlets.reserve(trianglesCount / MESHLET_MAX_TRIANGLES + 1);
+		meshletVertices.reserve(trianglesCount * 3);
+		meshletTriangles.reserve(trianglesCount * 3);
+
+		Meshlet current = {};
+		Vector3 positionSum = Vector3(0.0f, 0.0f, 0.0f);
+		uint32 seedCursor = 0;
+		uint32 emittedCount = 0;
+
+		auto countNewVertices = [&](uint32 triangle)
+		{
+			uint32 a = indices[triangle * 3 + 0];
+			uint32 b = indices[triangle * 3 + 1];
+			uint32 c = indices[triangle * 3 + 2];
+			uint32 count = 0;
+			count += localIndex[a] == INVALID_LOCAL_INDEX;
+			count += localIndex[b] == INVALID_LOCAL_INDEX && b != a;
+			count += localIndex[c] == INVALID_LOCAL_INDEX && c != a && c != b;
+			return count;
+		};
+
+		auto flush = [&]()
+		{
+			if (current.triangleCount == 0)
+				return;
+
+			for (uint32 i = 0; i < current.vertexCount; i++)
+			{
+				localIndex[meshletVertices[current.vertexOffset + i]] = INVALID_LOCAL_INDEX;
+			}
+
+			meshlets.push_back(current);
+
+			current = {};
+			positionSum = Vector3(0.0f, 0.0f, 0.0f);
+			current.vertexOffset = static_cast<uint32>(meshletVertices.size());
+			current.triangleOffset = static_cast<uint32>(meshletTriangles.size());
+		};
+
+		auto emit = [&](uint32 triangle)
+		{
+			for (uint32 i = 0; i < 3; i++)
+			{
+				uint32 vertex = indices[triangle * 3 + i];
+				if (localIndex[vertex] == INVALID_LOCAL_INDEX)
+				{
+					localIndex[vertex] = current.vertexCount++;
+					meshletVertices.push_back(vertex);
+					positionSum += meshData.vertices[vertex].posModel;
+				}
+				meshletTriangles.push_back(localIndex[vertex]);
+			}
+
+			current.triangleCount++;
+			emitted[triangle] = 1;
+			emittedCount++;
+		};
+
+		while (emittedCount < trianglesCount)
+		{
+			// Prefer the adjacent triangle that adds the fewest new vertices, then the
+			// one closest to the meshlet centroid so meshlets stay compact. Remaining
+			// ties go to the lowest triangle index to keep the output deterministic.
+			uint32 bestTriangle = UINT32_MAX;
+			uint32 bestNewVertices = 4;
+			float bestDistSq = 0.0f;
+			Vector3 centroid = current.vertexCount ? positionSum / static_cast<float>(current.vertexCount) : positionSum;
+			for (uint32 i = 0; i < current.vertexCount; i++)
+			{
+				uint32 vertex = meshletVertices[current.vertexOffset + i];
+				for (uint32 j = adjacencyOffsets[vertex]; j < adjacencyOffsets[vertex + 1]; j++)
+				{
+					uint32 triangle = adjacency[j];
+					if (emitted[triangle])
+						continue;
+
+					uint32 newVertices = countNewVertices(triangle);
+					if (current.vertexCount + newVertices > MESHLET_MAX_VERTICES)
+						continue;
+
+					if (newVertices > bestNewVertices)
+						continue;
+
+					const Vector3& a = meshData.vertices[indices[triangle * 3 + 0]].posModel;
+					const Vector3& b = meshData.vertices[indices[triangle * 3 + 1]].posModel;
+					const Vector3& c = meshData.vertices[indices[triangle * 3 + 2]].posModel;
+					float distSq = ((a + b + c) / 3.0f - centroid).LengthSquared();
+
+					bool better = newVertices < bestNewVertices;
+					better = better || distSq < bestDistSq;
+					better = better || (distSq == bestDistSq && triangle < bestTriangle);
+					if (better)
+					{
+						bestTriangle = triangle;
+						bestNewVertices = newVertices;
+						bestDistSq = distSq;
+					}
+				}
+			}
+
+			if (bestTriangle == UINT32_MAX)
+			{
+				while (emitted[seedCursor])
+				{
+					seedCursor++;
+				}
+
+				if (current.vertexCount + countNewVertices(seedCursor) > MESHLET_MAX_VERTICES)
+					flush();
+
+				bestTriangle = seedCursor;
+			}
+
+			emit(bestTriangle);
+
+			if (current.triangleCount == MESHLET_MAX_TRIANGLES)
+				flush();
+		}
+		flush();
+
+		outMeshletData->meshletsCount = static_cast<uint32>(meshlets.size());
+		outMeshletData->verticesCount = static_cast<uint32>(meshletVertices.size());
+		outMeshletData->trianglesCount = static_cast<uint32>(meshletTriangles.size() / 3);
+
+		outMeshletData->meshlets = new Meshlet[outMeshletData->meshletsCount];
+		outMeshletData->bounds = new MeshletBounds[outMeshletData->meshletsCount];
+		outMeshletData->vertices = new uint32[outMeshletData->verticesCount];
+		outMeshletData->triangles = new uint8[outMeshletData->trianglesCount * 3];
+
+		::memcpy(outMeshletData->meshlets, meshlets.data(), sizeof(Meshlet) * meshlets.size());
+		::memcpy(outMeshletData->vertices, meshletVertices.data(), sizeof(uint32) * meshletVertices.size());
+		::memcpy(outMeshletData->triangles, meshletTriangles.data(), meshletTriangles.size());
+
+		for (uint32 i = 0; i < outMeshletData->meshletsCount; i++)
+		{
+			ComputeBounds(meshData, *outMeshletData, outMeshletData->meshlets[i], &outMeshletData->bounds[i]);
+		}
+
+		return true;
+	}
+
+	void Destroy(MeshletData* meshletData)
+	{
+		if (meshletData->meshlets)
+		{
+			delete[] meshletData->meshlets;
+			meshletData->meshlets = nullptr;
+		}
+
+		if (meshletData->bounds)
+		{
+			delete[] meshletData->bounds;
+			meshletData->bounds = nullptr;
+		}
+
+		if (meshletData->vertices)
+		{
+			delete[] meshletData->vertices;
+			meshletData->vertices = nullptr;
+		}
+
+		if (meshletData->triangles)
+		{
+			delete[] meshletData->triangles;
+			meshletData->triangles = nullptr;
+		}
+
+		meshletData->meshletsCount = 0;
+		meshletData->verticesCount = 0;
+		meshletData->trianglesCount = 0;
+	}
+
+	void ExpandIndices(const MeshletData& meshletData, Index* outIndices)
+	{
+		for (uint32 i = 0; i < meshletData.meshletsCount; i++)
+		{
+			const Meshlet& meshlet = meshletData.meshlets[i];
+			const uint32* vertices = meshletData.vertices + meshlet.vertexOffset;
+			const uint8* triangles = meshletData.triangles + meshlet.triangleOffset;
+
+			for (uint32 j = 0; j < meshlet.triangleCount * 3u; j++)
+			{
+				outIndices[meshlet.triangleOffset + j] = vertices[triangles[j]];
+			}
+		}
+	}
+}
+
+/*
+==================
+MeshletCulling
+==================
+*/
+
+namespace MeshletCulling
+{
+	void ExtractFrustumPlanes(const Matrix& m, Vector4 outPlanes[6])
+	{
+		// Row vectors (clip = v * m), so planes come from the matrix columns.
+		// D3D clip space has 0 <= z <= w.
+		outPlanes[0] = Vector4(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41);	// Left
+		outPlanes[1] = Vector4(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41);	// Right
+		outPlanes[2] = Vector4(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42);	// Bottom
+		outPlanes[3] = Vector4(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42);	// Top
+		outPlanes[4] = Vector4(m._13, m._23, m._33, m._43);									// Near
+		outPlanes[5] = Vector4(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43);	// Far
+
+		for (uint32 i = 0; i < 6; i++)
+		{
+			Vector4& plane = outPlanes[i];
+			float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+			if (length > 0.0f)
+			{
+				plane.x /= length;
+				plane.y /= length;
+				plane.z /= length;
+				plane.w /= length;
+			}
+		}
+	}
+
+	bool IsSphereVisible(const Vector4 planes[6], const Vector3& center, float radius)
+	{
+		for (uint32 i = 0; i < 6; i++)
+		{
+			const Vector4& plane = planes[i];
+			float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+			if (distance < -radius)
+				return false;
+		}
+		return true;
+	}
+
+	bool IsBackfacing(const MeshletBounds& bounds, const Vector3& cameraPos)
+	{
+		if (bounds.coneCutoff >= 127)
+			return false;
+
+		Vector3 axis = Vector3(bounds.coneAxis[0] / 127.0f, bounds.coneAxis[1] / 127.0f, bounds.coneAxis[2] / 127.0f);
+		float cutoff = bounds.coneCutoff / 127.0f;
+
+		Vector3 toCenter = bounds.center - cameraPos;
+		return toCenter.Dot(axis) >= cutoff * toCenter.Length() + bounds.radius;
+	}
+
+	bool IsVisible(const MeshletBounds& bounds, const Vector4 planes[6], const Vector3& cameraPos)
+	{
+		return IsSphereVisible(planes, bounds.center, bounds.radius) && !IsBackfacing(bounds, cameraPos);
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Types.h"
+#include "Vertex.h"
+
+/*
+=======
+Meshlet
+=======
+*/
+
+const uint32 MESHLET_MAX_VERTICES = 64;
+const uint32 MESHLET_MAX_TRIANGLES = 124;
+
+// Meshes below this triangle count are drawn in one call and never split.
+const uint32 MESHLET_MIN_MESH_TRIANGLES = 512;
+
+struct Meshlet
+{
+	uint32 vertexOffset = 0;	// First entry in MeshletData::vertices.
+	uint32 triangleOffset = 0;	// First byte in MeshletData::triangles.
+	uint8 vertexCount = 0;
+	uint8 triangleCount = 0;
+	uint16 padding = 0;
+};
+
+// Bounding sphere and normal cone. The cone is quantized to 8 bits so a GPU
+// culling pass can read one meshlet's bounds with a single 32-byte load.
+struct MeshletBounds
+{
+	Vector3 center = {};
+	float radius = 0.0f;
+	int8 coneAxis[3] = {};
+	int8 coneCutoff = 127;
+	uint32 padding[3] = {};
+};
+
+struct MeshletData
+{
+	Meshlet* meshlets = nullptr;
+	MeshletBounds* bounds = nullptr;
+	uint32* vertices = nullptr;		// Meshlet-local to mesh vertex index.
+	uint8* triangles = nullptr;		// Three meshlet-local indices per triangle.
+	uint32 meshletsCount = 0;
+	uint32 verticesCount = 0;
+	uint32 trianglesCount = 0;
+};
+
+/*
+==================
+MeshletBuilder
+==================
+*/
+
+namespace MeshletBuilder
+{
+	// Greedily grows meshlets from adjacent triangles. The output only depends
+	// on the input order, so the same MeshData always yields the same meshlets.
+	bool Build(const MeshData& meshData, MeshletData* outMeshletData);
+	void Destroy(MeshletData* meshletData);
+
+	// Writes meshlet-ordered triangle lists, so meshlet i covers indices
+	// [meshlet.triangleOffset, meshlet.triangleOffset + meshlet.triangleCount * 3).
+	void ExpandIndices(const MeshletData& meshletData, Index* outIndices);
+}
+
+/*
+==================
+MeshletCulling
+==================
+*/
+
+namespace MeshletCulling
+{
+	// Planes in the space worldViewProj maps from, normalized, pointing inward.
+	void ExtractFrustumPlanes(const Matrix& worldViewProj, Vector4 outPlanes[6]);
+	bool IsSphereVisible(const Vector4 planes[6], const Vector3& center, float radius);
+	// True when every triangle in the meshlet faces away from cameraPos.
+	bool IsBackfacing(const MeshletBounds& bounds, const Vector3& cameraPos);
+	bool IsVisible(const MeshletBounds& bounds, const Vector4 planes[6], const Vector3& cameraPos);
+}
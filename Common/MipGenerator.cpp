@@ -0,0 +1,504 @@
+#include "MipGenerator.h"
+#include "Platform.h"
+
+#include <math.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+	#define MIP_GENERATOR_SSE2
+	#include <emmintrin.h>
+#endif
+
+/*
+==============
+Mip Generator
+==============
+*/
+
+namespace MipGenerator
+{
+	const uint32 BAND_ROWS = 16;
+	const float KAISER_RADIUS = 3.0f;		// In destination texels.
+	const float KAISER_ALPHA = 4.0f;
+	const float PI = 3.14159265f;
+
+	/*
+	============
+	Conversions
+	============
+	*/
+
+	static float SrgbToLinear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	// Decoding goes through a table. Encoding searches the linear values halfway
+	// between neighbouring codes, which rounds exactly like the sRGB formula.
+	struct SrgbTables
+	{
+		float toLinear[256];
+		float thresholds[255];
+
+		SrgbTables()
+		{
+			for (uint32 i = 0; i < 256; i++)
+			{
+				toLinear[i] = SrgbToLinear(i / 255.0f);
+			}
+			for (uint32 i = 0; i < 255; i++)
+			{
+				thresholds[i] = SrgbToLinear((i + 0.5f) / 255.0f);
+			}
+		}
+	};
+
+	static const SrgbTables& GetSrgbTables()
+	{
+		static const SrgbTables tables;
+		return tables;
+	}
+
+	static uint8 EncodeSrgb(const SrgbTables& tables, float value)
+	{
+		uint32 code = 0;
+		for (uint32 step = 128; step > 0; step >>= 1)
+		{
+			if (tables.thresholds[code + step - 1] <= value)
+				code += step;
+		}
+		return static_cast<uint8>(code);
+	}
+
+	static uint8 EncodeUnorm(float value)
+	{
+		value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+		return static_cast<uint8>(value * 255.0f + 0.5f);
+	}
+
+	static float HalfToFloat(uint16 half)
+	{
+		uint32 sign = static_cast<uint32>(half & 0x8000) << 16;
+		uint32 exponent = (half >> 10) & 0x1f;
+		uint32 mantissa = half & 0x3ff;
+
+		uint32 bits = 0;
+		if (exponent == 0x1f)
+		{
+			bits = sign | 0x7f800000 | (mantissa << 13);
+		}
+		else if (exponent != 0)
+		{
+			bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+		}
+		else if (mantissa != 0)
+		{
+			// Subnormal: shift the mantissa up until its leading one is implicit.
+			exponent = 113;
+			while ((mantissa & 0x400) == 0)
+			{
+				mantissa <<= 1;
+				exponent--;
+			}
+			bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+		}
+		else
+		{
+			bits = sign;
+		}
+
+		float value;
+		::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	// Rounds to nearest even; overflow becomes infinity.
+	static uint16 FloatToHalf(float value)
+	{
+		uint32 bits;
+		::memcpy(&bits, &value, sizeof(bits));
+
+		uint32 sign = (bits >> 16) & 0x8000;
+		uint32 absBits = bits & 0x7fffffff;
+
+		if (absBits >= 0x7f800000)
+			return static_cast<uint16>(sign | 0x7c00 | (absBits > 0x7f800000 ? 0x200 : 0));
+		if (absBits >= 0x477ff000)
+			return static_cast<uint16>(sign | 0x7c00);
+
+		uint32 result = 0;
+		uint32 remainder = 0;
+		uint32 halfway = 0;
+		if (absBits < 0x38800000)
+		{
+			if (absBits <= 0x33000000)
+				return static_cast<uint16>(sign);
+
+			uint32 mantissa = (absBits & 0x7fffff) | 0x800000;
+			uint32 shift = 126 - (absBits >> 23);
+			result = mantissa >> shift;
+			remainder = mantissa & ((1u << shift) - 1);
+			halfway = 1u << (shift - 1);
+		}
+		else
+		{
+			result = (absBits - 0x38000000) >> 13;
+			remainder = absBits & 0x1fff;
+			halfway = 0x1000;
+		}
+
+		if (remainder > halfway || (remainder == halfway && (result & 1)))
+			result++;
+		return static_cast<uint16>(sign | result);
+	}
+
+	// One row to linear RGBA floats.
+	static void DecodeRow(const uint8* src, uint32 width, DDS_FORMAT format, bool srgb, float* outRow)
+	{
+		uint32 count = width * 4;
+		switch (format)
+		{
+		case DDS_FORMAT_R8G8B8A8_UNORM:
+		case DDS_FORMAT_R8G8B8A8_UNORM_SRGB:
+			if (srgb)
+			{
+				const SrgbTables& tables = GetSrgbTables();
+				for (uint32 i = 0; i < count; i += 4)
+				{
+					outRow[i + 0] = tables.toLinear[src[i + 0]];
+					outRow[i + 1] = tables.toLinear[src[i + 1]];
+					outRow[i + 2] = tables.toLinear[src[i + 2]];
+					outRow[i + 3] = src[i + 3] / 255.0f;
+				}
+			}
+			else
+			{
+				for (uint32 i = 0; i < count; i++)
+				{
+					outRow[i] = src[i] / 255.0f;
+				}
+			}
+			break;
+		case DDS_FORMAT_R16G16B16A16_FLOAT:
+			for (uint32 i = 0; i < count; i++)
+			{
+				uint16 half;
+				::memcpy(&half, src + i * 2, sizeof(half));
+				outRow[i] = HalfToFloat(half);
+			}
+			break;
+		default:
+			::memcpy(outRow, src, count * sizeof(float));
+			break;
+		}
+	}
+
+	static void EncodeRow(const float* row, uint32 width, DDS_FORMAT format, bool srgb, uint8* outDst)
+	{
+		uint32 count = width * 4;
+		switch (format)
+		{
+		case DDS_FORMAT_R8G8B8A8_UNORM:
+		case DDS_FORMAT_R8G8B8A8_UNORM_SRGB:
+			if (srgb)
+			{
+				const SrgbTables& tables = GetSrgbTables();
+				for (uint32 i = 0; i < count; i += 4)
+				{
+					outDst[i + 0] = EncodeSrgb(tables, row[i + 0]);
+					outDst[i + 1] = EncodeSrgb(tables, row[i + 1]);
+					outDst[i + 2] = EncodeSrgb(tables, row[i + 2]);
+					outDst[i + 3] = EncodeUnorm(row[i + 3]);
+				}
+			}
+			else
+			{
+				for (uint32 i = 0; i < count; i++)
+				{
+					outDst[i] = EncodeUnorm(row[i]);
+				}
+			}
+			break;
+		case DDS_FORMAT_R16G16B16A16_FLOAT:
+			for (uint32 i = 0; i < count; i++)
+			{
+				uint16 half = FloatToHalf(row[i]);
+				::memcpy(outDst + i * 2, &half, sizeof(half));
+			}
+			break;
+		default:
+			::memcpy(outDst, row, count * sizeof(float));
+			break;
+		}
+	}
+
+	/*
+	============
+	Filters
+	============
+	*/
+
+	// Modified Bessel function of the first kind, order zero.
+	static float BesselI0(float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		float halfX = x * 0.5f;
+		for (uint32 k = 1; k < 32; k++)
+		{
+			term *= halfX / static_cast<float>(k);
+			float squared = term * term;
+			sum += squared;
+			if (squared < sum * 1e-8f)
+				break;
+		}
+		return sum;
+	}
+
+	// x is in destination texels.
+	static float Kaiser(float x)
+	{
+		float ratio = x / KAISER_RADIUS;
+		if (ratio <= -1.0f || ratio >= 1.0f)
+			return 0.0f;
+
+		float sinc = fabsf(x) < 1e-6f ? 1.0f : sinf(PI * x) / (PI * x);
+		return sinc * BesselI0(KAISER_ALPHA * sqrtf(1.0f - ratio * ratio)) / BesselI0(KAISER_ALPHA);
+	}
+
+	// Source texels and weights for every destination texel of one axis,
+	// tapsCount per texel. Indices are clamped to the source, weights sum to one.
+	struct FilterTaps
+	{
+		uint32 tapsCount = 0;
+		std::vector<uint32> indices;
+		std::vector<float> weights;
+	};
+
+	static void BuildFilterTaps(MIP_FILTER filter, uint32 srcSize, uint32 dstSize, FilterTaps* outTaps)
+	{
+		float scale = static_cast<float>(srcSize) / static_cast<float>(dstSize);
+		float radius = filter == MIP_FILTER_BOX ? scale * 0.5f : KAISER_RADIUS * scale;
+
+		// Box taps are the texels the destination footprint overlaps; Kaiser
+		// taps are the texels whose centers fall inside the window.
+		auto getFirst = [&](float center) { return static_cast<int32>(filter == MIP_FILTER_BOX ? floorf(center - radius) : floorf(center - radius - 0.5f) + 1.0f); };
+		auto getLast = [&](float center) { return static_cast<int32>(filter == MIP_FILTER_BOX ? ceilf(center + radius) - 1.0f : ceilf(center + radius - 0.5f) - 1.0f); };
+
+		uint32 tapsCount = 1;
+		for (uint32 d = 0; d < dstSize; d++)
+		{
+			float center = (d + 0.5f) * scale;
+			uint32 count = static_cast<uint32>(getLast(center) - getFirst(center) + 1);
+			tapsCount = count > tapsCount ? count : tapsCount;
+		}
+
+		outTaps->tapsCount = tapsCount;
+		outTaps->indices.assign(static_cast<size_t>(dstSize) * tapsCount, 0);
+		outTaps->weights.assign(static_cast<size_t>(dstSize) * tapsCount, 0.0f);
+
+		for (uint32 d = 0; d < dstSize; d++)
+		{
+			float center = (d + 0.5f) * scale;
+			int32 first = getFirst(center);
+			uint32* indices = &outTaps->indices[d * tapsCount];
+			float* weights = &outTaps->weights[d * tapsCount];
+
+			float sum = 0.0f;
+			for (uint32 t = 0; t < tapsCount; t++)
+			{
+				int32 i = first + static_cast<int32>(t);
+
+				float weight = 0.0f;
+				if (filter == MIP_FILTER_BOX)
+				{
+					float overlap = fminf(i + 1.0f, center + radius) - fmaxf(static_cast<float>(i), center - radius);
+					weight = overlap > 0.0f ? overlap : 0.0f;
+				}
+				else
+				{
+					weight = Kaiser((i + 0.5f - center) / scale);
+				}
+
+				indices[t] = static_cast<uint32>(i < 0 ? 0 : (i >= static_cast<int32>(srcSize) ? srcSize - 1 : i));
+				weights[t] = weight;
+				sum += weight;
+			}
+
+			for (uint32 t = 0; t < tapsCount; t++)
+			{
+				weights[t] /= sum;
+			}
+		}
+	}
+
+	// sum += row * weight over count floats; count is a multiple of four.
+	static void AccumulateRow(float* sum, const float* row, float weight, uint32 count)
+	{
+#if defined(MIP_GENERATOR_SSE2)
+		__m128 weights = _mm_set1_ps(weight);
+		for (uint32 i = 0; i < count; i += 4)
+		{
+			__m128 value = _mm_mul_ps(_mm_loadu_ps(row + i), weights);
+			_mm_storeu_ps(sum + i, _mm_add_ps(_mm_loadu_ps(sum + i), value));
+		}
+#else
+		for (uint32 i = 0; i < count; i++)
+		{
+			sum[i] += row[i] * weight;
+		}
+#endif
+	}
+
+	// Horizontal pass over one row of RGBA floats.
+	static void FilterRow(const float* row, const FilterTaps& taps, uint32 dstWidth, float* outRow)
+	{
+		for (uint32 x = 0; x < dstWidth; x++)
+		{
+			const uint32* indices = &taps.indices[x * taps.tapsCount];
+			const float* weights = &taps.weights[x * taps.tapsCount];
+#if defined(MIP_GENERATOR_SSE2)
+			__m128 sum = _mm_setzero_ps();
+			for (uint32 t = 0; t < taps.tapsCount; t++)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(row + indices[t] * 4), _mm_set1_ps(weights[t])));
+			}
+			_mm_storeu_ps(outRow + x * 4, sum);
+#else
+			float sum[4] = {};
+			for (uint32 t = 0; t < taps.tapsCount; t++)
+			{
+				for (uint32 c = 0; c < 4; c++)
+				{
+					sum[c] += row[indices[t] * 4 + c] * weights[t];
+				}
+			}
+			::memcpy(outRow + x * 4, sum, sizeof(sum));
+#endif
+		}
+	}
+
+	/*
+	============
+	Generation
+	============
+	*/
+
+	uint32 GetMipLevelsCount(uint32 width, uint32 height)
+	{
+		uint32 size = width > height ? width : height;
+		uint32 count = 1;
+		while (size > 1 && count < DDS_MAX_MIPS)
+		{
+			size >>= 1;
+			count++;
+		}
+		return count;
+	}
+
+	bool IsSupported(DDS_FORMAT format)
+	{
+		switch (format)
+		{
+		case DDS_FORMAT_R8G8B8A8_UNORM:
+		case DDS_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DDS_FORMAT_R16G16B16A16_FLOAT:
+		case DDS_FORMAT_R32G32B32A32_FLOAT:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool Generate(const DDSTextureInfo& info, MIP_FILTER filter, bool srgb, uint32 threadsCount, uint8* data)
+	{
+		if (!IsSupported(info.format))
+			return false;
+
+		srgb = srgb || info.format == DDS_FORMAT_R8G8B8A8_UNORM_SRGB;
+
+		if (threadsCount == 0)
+			threadsCount = Platform::GetHardwareThreadsCount();
+
+		// Levels depend on each other, so only the bands within a level run in parallel.
+		for (uint32 mip = 1; mip < info.mipLevels; mip++)
+		{
+			const DDSMipLayout& srcLayout = info.mips[mip - 1];
+			const DDSMipLayout& dstLayout = info.mips[mip];
+
+			FilterTaps horizontal;
+			FilterTaps vertical;
+			BuildFilterTaps(filter, srcLayout.width, dstLayout.width, &horizontal);
+			BuildFilterTaps(filter, srcLayout.height, dstLayout.height, &vertical);
+
+			uint32 bandsCount = (dstLayout.height + BAND_ROWS - 1) / BAND_ROWS;
+			uint32 jobsCount = bandsCount * info.arraySize;
+
+			std::atomic<uint32> nextJob(0);
+			auto worker = [&]()
+			{
+				std::vector<float> sourceRows;
+				std::vector<float> columnSum(static_cast<size_t>(srcLayout.width) * 4);
+				std::vector<float> destRow(static_cast<size_t>(dstLayout.width) * 4);
+				uint32 rowFloats = srcLayout.width * 4;
+
+				for (uint32 job = nextJob.fetch_add(1); job < jobsCount; job = nextJob.fetch_add(1))
+				{
+					uint32 slice = job / bandsCount;
+					uint32 band = job % bandsCount;
+					const uint8* src = data + info.sliceSize * slice + srcLayout.offset;
+					uint8* dst = data + info.sliceSize * slice + dstLayout.offset;
+
+					uint32 firstRow = band * BAND_ROWS;
+					uint32 lastRow = firstRow + BAND_ROWS < dstLayout.height ? firstRow + BAND_ROWS : dstLayout.height;
+
+					// Neighbouring rows share most of their taps, so the source rows
+					// under the band are decoded once up front. Clamped indices keep
+					// the range contiguous.
+					uint32 firstSource = vertical.indices[firstRow * vertical.tapsCount];
+					uint32 lastSource = vertical.indices[lastRow * vertical.tapsCount - 1];
+					sourceRows.resize(static_cast<size_t>(lastSource - firstSource + 1) * rowFloats);
+					for (uint32 srcY = firstSource; srcY <= lastSource; srcY++)
+					{
+						DecodeRow(src + static_cast<uint64>(srcY) * srcLayout.rowPitch, srcLayout.width, info.format, srgb, &sourceRows[static_cast<size_t>(srcY - firstSource) * rowFloats]);
+					}
+
+					for (uint32 y = firstRow; y < lastRow; y++)
+					{
+						// Vertical pass first, so the horizontal one runs on a single row.
+						::memset(columnSum.data(), 0, columnSum.size() * sizeof(float));
+						for (uint32 t = 0; t < vertical.tapsCount; t++)
+						{
+							float weight = vertical.weights[y * vertical.tapsCount + t];
+							if (weight == 0.0f)
+								continue;
+
+							uint32 srcY = vertical.indices[y * vertical.tapsCount + t];
+							AccumulateRow(columnSum.data(), &sourceRows[static_cast<size_t>(srcY - firstSource) * rowFloats], weight, rowFloats);
+						}
+
+						FilterRow(columnSum.data(), horizontal, dstLayout.width, destRow.data());
+						EncodeRow(destRow.data(), dstLayout.width, info.format, srgb, dst + static_cast<uint64>(y) * dstLayout.rowPitch);
+					}
+				}
+			};
+
+			uint32 levelThreadsCount = threadsCount < jobsCount ? threadsCount : jobsCount;
+			std::vector<std::thread> threads;
+			for (uint32 i = 1; i < levelThreadsCount; i++)
+			{
+				threads.emplace_back(worker);
+			}
+			worker();
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+		}
+
+		return true;
+	}
+}
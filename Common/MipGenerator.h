@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Types.h"
+#include "DDSFile.h"
+
+/*
+==============
+Mip Generator
+==============
+*/
+
+// BOX averages the source texels under each destination texel. KAISER is a
+// Kaiser-windowed sinc three destination texels wide; it keeps more detail
+// at the cost of some ringing near hard edges.
+enum MIP_FILTER
+{
+	MIP_FILTER_BOX,
+	MIP_FILTER_KAISER,
+};
+
+namespace MipGenerator
+{
+	// Full chain down to 1x1, capped at DDS_MAX_MIPS.
+	uint32 GetMipLevelsCount(uint32 width, uint32 height);
+
+	// RGBA8 (linear or sRGB), RGBA16F and RGBA32F.
+	bool IsSupported(DDS_FORMAT format);
+
+	// data holds every slice laid out as info describes, with mip 0 filled in;
+	// the other mips are written from it. Each level is filtered from the one
+	// above it, with clamped edges. Filtering happens in linear light when the
+	// format is sRGB or srgb is set; alpha is always linear. Each level is cut
+	// into bands of rows spread over threadsCount threads; 0 uses every
+	// hardware thread.
+	bool Generate(const DDSTextureInfo& info, MIP_FILTER filter, bool srgb, uint32 threadsCount, uint8* data);
+}
@@ -0,0 +1,263 @@
+#include "PipelineCompileQueue.h"
+#include "Profiler.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+====================
+PipelineCompileQueue
+====================
+*/
+
+struct PipelineCompileQueue::Workers
+{
+	mutable std::mutex lock;
+	std::condition_variable wake;
+	std::vector<std::thread> threads;
+	bool quit = false;
+};
+
+void PipelineCompileQueue::Init(const PipelineCompileQueueSettings& settings)
+{
+	m_settings = settings;
+	m_slots = new Slot[m_settings.maxJobs];
+	m_queue = new uint32[m_settings.maxJobs];
+	m_freeHint = 0;
+	m_queueStart = 0;
+	m_queueCount = 0;
+
+	m_workers = new Workers;
+	for (uint32 i = 0; i < m_settings.threadsCount; i++)
+	{
+		m_workers->threads.emplace_back([this]() { WorkerLoop(); });
+	}
+}
+
+void PipelineCompileQueue::Clean()
+{
+	if (m_workers)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_workers->lock);
+			m_workers->quit = true;
+		}
+		m_workers->wake.notify_all();
+
+		for (std::thread& thread : m_workers->threads)
+		{
+			thread.join();
+		}
+
+		delete m_workers;
+		m_workers = nullptr;
+	}
+
+	if (m_slots)
+	{
+		// Released slots still in the queue were discarded by Release.
+		for (uint32 i = 0; i < m_settings.maxJobs; i++)
+		{
+			if (m_slots[i].state != PIPELINE_COMPILE_STATE_FREE && !m_slots[i].released && m_settings.discard)
+				m_settings.discard(m_settings.context, m_slots[i].job, m_slots[i].result);
+		}
+
+		delete[] m_slots;
+		m_slots = nullptr;
+	}
+
+	if (m_queue)
+	{
+		delete[] m_queue;
+		m_queue = nullptr;
+	}
+
+	m_queueCount = 0;
+}
+
+uint32 PipelineCompileQueue::Submit(void* job)
+{
+	uint32 jobId = PIPELINE_COMPILE_INVALID_ID;
+	{
+		std::lock_guard<std::mutex> lock(m_workers->lock);
+
+		for (uint32 n = 0; n < m_settings.maxJobs; n++)
+		{
+			uint32 id = (m_freeHint + n) % m_settings.maxJobs;
+			if (m_slots[id].state != PIPELINE_COMPILE_STATE_FREE)
+				continue;
+
+			Slot& slot = m_slots[id];
+			slot = {};
+			slot.job = job;
+			slot.state = PIPELINE_COMPILE_STATE_QUEUED;
+
+			m_queue[(m_queueStart + m_queueCount) % m_settings.maxJobs] = id;
+			m_queueCount++;
+
+			m_freeHint = (id + 1) % m_settings.maxJobs;
+			jobId = id;
+			break;
+		}
+	}
+
+	if (jobId != PIPELINE_COMPILE_INVALID_ID)
+		m_workers->wake.notify_one();
+
+	return jobId;
+}
+
+void PipelineCompileQueue::Release(uint32 jobId)
+{
+	void* job = nullptr;
+	void* result = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(m_workers->lock);
+
+		// Released but still queued or compiling; already handled.
+		Slot& slot = m_slots[jobId];
+		if (slot.released)
+			return;
+
+		switch (slot.state)
+		{
+		case PIPELINE_COMPILE_STATE_FREE:
+			return;
+		case PIPELINE_COMPILE_STATE_COMPILING:
+			slot.released = true;
+			return;
+		case PIPELINE_COMPILE_STATE_QUEUED:
+			// Its queue entry is skipped when popped.
+			slot.released = true;
+			break;
+		default:
+			break;
+		}
+
+		job = slot.job;
+		result = slot.result;
+		if (slot.state != PIPELINE_COMPILE_STATE_QUEUED)
+			slot = {};
+	}
+
+	if (m_settings.discard)
+		m_settings.discard(m_settings.context, job, result);
+}
+
+PIPELINE_COMPILE_STATE PipelineCompileQueue::GetState(uint32 jobId) const
+{
+	std::lock_guard<std::mutex> lock(m_workers->lock);
+	return m_slots[jobId].released ? PIPELINE_COMPILE_STATE_FREE : m_slots[jobId].state;
+}
+
+void* PipelineCompileQueue::GetResult(uint32 jobId) const
+{
+	std::lock_guard<std::mutex> lock(m_workers->lock);
+	return m_slots[jobId].state == PIPELINE_COMPILE_STATE_READY ? m_slots[jobId].result : nullptr;
+}
+
+bool PipelineCompileQueue::CompileOne()
+{
+	uint32 jobId = PIPELINE_COMPILE_INVALID_ID;
+	{
+		std::lock_guard<std::mutex> lock(m_workers->lock);
+		if (!PopQueued(&jobId))
+			return false;
+	}
+
+	Compile(jobId);
+	return true;
+}
+
+uint32 PipelineCompileQueue::GetQueuedCount() const
+{
+	std::lock_guard<std::mutex> lock(m_workers->lock);
+
+	uint32 queuedCount = 0;
+	for (uint32 i = 0; i < m_queueCount; i++)
+	{
+		if (!m_slots[m_queue[(m_queueStart + i) % m_settings.maxJobs]].released)
+			queuedCount++;
+	}
+	return queuedCount;
+}
+
+// Called with the lock held. Released jobs are freed here rather than in
+// Release, so their ids cannot be reused while still in the ring.
+bool PipelineCompileQueue::PopQueued(uint32* outJobId)
+{
+	while (m_queueCount)
+	{
+		uint32 id = m_queue[m_queueStart];
+		m_queueStart = (m_queueStart + 1) % m_settings.maxJobs;
+		m_queueCount--;
+
+		Slot& slot = m_slots[id];
+		if (slot.released)
+		{
+			slot = {};
+			continue;
+		}
+
+		slot.state = PIPELINE_COMPILE_STATE_COMPILING;
+		*outJobId = id;
+		return true;
+	}
+
+	return false;
+}
+
+void PipelineCompileQueue::Compile(uint32 jobId)
+{
+	// Nothing else touches a COMPILING slot's job, so it is read without the lock.
+	void* job = m_slots[jobId].job;
+	void* result = nullptr;
+	{
+		PROFILE_SCOPE("CompilePipeline");
+		result = m_settings.compile(m_settings.context, job);
+	}
+
+	bool discard = false;
+	{
+		std::lock_guard<std::mutex> lock(m_workers->lock);
+
+		Slot& slot = m_slots[jobId];
+		if (slot.released)
+		{
+			slot = {};
+			discard = true;
+		}
+		else
+		{
+			slot.result = result;
+			slot.state = result ? PIPELINE_COMPILE_STATE_READY : PIPELINE_COMPILE_STATE_FAILED;
+		}
+	}
+
+	if (discard && m_settings.discard)
+		m_settings.discard(m_settings.context, job, result);
+}
+
+void PipelineCompileQueue::WorkerLoop()
+{
+	PROFILE_THREAD_NAME("Pipeline Compile");
+
+	while (true)
+	{
+		uint32 jobId = PIPELINE_COMPILE_INVALID_ID;
+		{
+			std::unique_lock<std::mutex> lock(m_workers->lock);
+			m_workers->wake.wait(lock, [this]() { return m_workers->quit || m_queueCount != 0; });
+
+			if (m_workers->quit)
+				return;
+
+			if (!PopQueued(&jobId))
+				continue;
+		}
+
+		Compile(jobId);
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Types.h"
+
+/*
+======================
+Pipeline Compile Queue
+======================
+*/
+
+const uint32 PIPELINE_COMPILE_INVALID_ID = 0xffffffff;
+
+enum PIPELINE_COMPILE_STATE
+{
+	PIPELINE_COMPILE_STATE_FREE,
+	PIPELINE_COMPILE_STATE_QUEUED,
+	PIPELINE_COMPILE_STATE_COMPILING,
+	PIPELINE_COMPILE_STATE_READY,
+	PIPELINE_COMPILE_STATE_FAILED,
+};
+
+// compile runs on a worker thread, or in CompileOne, and returns nullptr on
+// failure. discard gets every job back once it is released, with its result,
+// so the owner can free both.
+typedef void* (*PipelineCompileFunc)(void* context, void* job);
+typedef void (*PipelineDiscardFunc)(void* context, void* job, void* result);
+
+struct PipelineCompileQueueSettings
+{
+	uint32 maxJobs = 256;
+	uint32 threadsCount = 1;			// 0 starts no workers; jobs only run through CompileOne.
+	PipelineCompileFunc compile = nullptr;
+	PipelineDiscardFunc discard = nullptr;
+	void* context = nullptr;
+};
+
+/*
+====================
+PipelineCompileQueue
+====================
+*/
+
+// Runs pipeline compiles off the render thread. It knows nothing about the
+// device: jobs and results are opaque pointers handed to the callbacks. A job
+// goes QUEUED, COMPILING, then READY or FAILED, and stays there until it is
+// released. Jobs start in submission order.
+class PipelineCompileQueue
+{
+public:
+	void Init(const PipelineCompileQueueSettings& settings);
+	// Waits for compiles in progress, then discards every job left.
+	void Clean();
+
+	// Returns PIPELINE_COMPILE_INVALID_ID when full.
+	uint32 Submit(void* job);
+	// A job still compiling is discarded by its worker once it finishes.
+	void Release(uint32 jobId);
+
+	PIPELINE_COMPILE_STATE GetState(uint32 jobId) const;
+	// nullptr until the job is READY.
+	void* GetResult(uint32 jobId) const;
+
+	// Compiles the oldest queued job on the calling thread. Returns false when
+	// nothing was queued.
+	bool CompileOne();
+
+	uint32 GetQueuedCount() const;
+
+private:
+	struct Slot
+	{
+		void* job = nullptr;
+		void* result = nullptr;
+		PIPELINE_COMPILE_STATE state = PIPELINE_COMPILE_STATE_FREE;
+		bool released = false;
+	};
+
+	// Threads and the lock live in the .cpp so this header stays free of the standard library.
+	struct Workers;
+
+	PipelineCompileQueueSettings m_settings = {};
+	Slot* m_slots = nullptr;
+	uint32 m_freeHint = 0;
+
+	// Ring of queued job ids, oldest first.
+	uint32* m_queue = nullptr;
+	uint32 m_queueStart = 0;
+	uint32 m_queueCount = 0;
+
+	Workers* m_workers = nullptr;
+
+	bool PopQueued(uint32* outJobId);
+	void Compile(uint32 jobId);
+	void WorkerLoop();
+};
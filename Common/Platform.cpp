@@ -0,0 +1,167 @@
+#include "Platform.h"
+
+#include <string.h>
+#include <thread>
+
+#if defined(_WIN32)
+	#include <Windows.h>
+	#include <intrin.h>
+#else
+	#include <time.h>
+	#include <unistd.h>
+#endif
+
+/*
+========
+Platform
+========
+*/
+
+namespace Platform
+{
+#if defined(_WIN32)
+	uint64 GetTicks()
+	{
+		LARGE_INTEGER counter = {};
+		::QueryPerformanceCounter(&counter);
+		return static_cast<uint64>(counter.QuadPart);
+	}
+
+	uint64 GetTicksPerSecond()
+	{
+		LARGE_INTEGER frequency = {};
+		::QueryPerformanceFrequency(&frequency);
+		return static_cast<uint64>(frequency.QuadPart);
+	}
+
+	double GetThreadCpuSeconds()
+	{
+		FILETIME creationTime, exitTime, kernelTime, userTime;
+		if (!::GetThreadTimes(::GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+			return 0.0;
+
+		uint64 kernel = (static_cast<uint64>(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+		uint64 user = (static_cast<uint64>(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+		return static_cast<double>(kernel + user) * 1e-7;
+	}
+
+	FILE* OpenFile(const char* filename, const char* mode)
+	{
+		FILE* file = nullptr;
+		if (fopen_s(&file, filename, mode) != 0)
+			return nullptr;
+
+		return file;
+	}
+
+	bool GetHostName(char* outName, uint32 size)
+	{
+		if (size == 0)
+			return false;
+
+		outName[0] = '\0';
+		DWORD length = size;
+		return ::GetComputerNameA(outName, &length) != 0;
+	}
+#else
+	uint64 GetTicks()
+	{
+		timespec time = {};
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return static_cast<uint64>(time.tv_sec) * 1000000000ull + static_cast<uint64>(time.tv_nsec);
+	}
+
+	uint64 GetTicksPerSecond()
+	{
+		return 1000000000ull;
+	}
+
+	double GetThreadCpuSeconds()
+	{
+		timespec time = {};
+		if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+			return 0.0;
+
+		return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1e-9;
+	}
+
+	FILE* OpenFile(const char* filename, const char* mode)
+	{
+		return fopen(filename, mode);
+	}
+
+	bool GetHostName(char* outName, uint32 size)
+	{
+		if (size == 0)
+			return false;
+
+		// gethostname need not terminate a truncated name.
+		::memset(outName, 0, size);
+		if (::gethostname(outName, size - 1) != 0)
+		{
+			outName[0] = '\0';
+			return false;
+		}
+
+		return true;
+	}
+#endif
+
+	uint32 GetHardwareThreadsCount()
+	{
+		uint32 threadsCount = std::thread::hardware_concurrency();
+		return threadsCount ? threadsCount : 1;
+	}
+
+	const char* GetInstructionSetName()
+	{
+#if defined(__AVX512F__)
+		return "avx512";
+#elif defined(__AVX2__)
+		return "avx2";
+#elif defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+		return "sse2";
+#else
+		return "none";
+#endif
+	}
+
+	// The AVX-512 builds target F, BW, DQ and VL, and the AVX2 builds AVX2
+	// and FMA, as every CPU with AVX2 since Haswell has both.
+	bool IsInstructionSetSupported()
+	{
+#if !defined(__AVX2__)
+		return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+		int info[4] = {};
+		::__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+
+		::__cpuid(info, 1);
+		const int FMA = 1 << 12;
+		const int OSXSAVE = 1 << 27;
+		const int AVX = 1 << 28;
+		if ((info[2] & (FMA | OSXSAVE | AVX)) != (FMA | OSXSAVE | AVX))
+			return false;
+
+		// The OS must save the YMM, and for AVX-512 the ZMM and mask, registers.
+		uint64 xcr0 = ::_xgetbv(0);
+		::__cpuidex(info, 7, 0);
+		uint32 features = static_cast<uint32>(info[1]);
+	#if defined(__AVX512F__)
+		const uint32 REQUIRED = (1u << 5) | (1u << 16) | (1u << 17) | (1u << 30) | (1u << 31);
+		return (xcr0 & 0xe6) == 0xe6 && (features & REQUIRED) == REQUIRED;
+	#else
+		return (xcr0 & 0x6) == 0x6 && (features & (1u << 5)) != 0;
+	#endif
+#else
+		__builtin_cpu_init();
+	#if defined(__AVX512F__)
+		return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl");
+	#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	#endif
+#endif
+	}
+}
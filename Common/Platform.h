@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Types.h"
+
+#include <stdio.h>
+
+/*
+========
+Platform
+========
+*/
+
+// What the engine core needs from the OS beyond the C++ standard library, for
+// MSVC on Windows and GCC or Clang on Linux. Threads and atomics are the
+// standard ones, and files are mapped through FileSystem::MapFile.
+namespace Platform
+{
+	// A monotonic clock: QPC on Windows, CLOCK_MONOTONIC elsewhere.
+	uint64 GetTicks();
+	uint64 GetTicksPerSecond();
+
+	// User and kernel time the calling thread has run for.
+	double GetThreadCpuSeconds();
+
+	// Never 0, unlike std::thread::hardware_concurrency.
+	uint32 GetHardwareThreadsCount();
+
+	// fopen. Returns nullptr on failure.
+	FILE* OpenFile(const char* filename, const char* mode);
+
+	// Returns false and an empty name when it is unknown.
+	bool GetHostName(char* outName, uint32 size);
+
+	// The widest x86 extension the build targets, such as "avx2" when built
+	// with -mavx2 or /arch:AVX2, and whether this CPU and OS run it.
+	const char* GetInstructionSetName();
+	bool IsInstructionSetSupported();
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <math.h>
+
+/*
+==============
+Portable Math
+==============
+*/
+
+// DirectXTK's SimpleMath is Windows-only, so elsewhere Vertex.h uses this
+// subset of it, with the same names, layout and row-vector conventions: what
+// Common/, the tools and the benchmarks use. Results can differ from
+// DirectXMath in the last bit.
+namespace DirectX
+{
+	constexpr float XM_PI = 3.141592654f;
+	constexpr float XM_2PI = 6.283185307f;
+	constexpr float XM_PIDIV2 = 1.570796327f;
+	constexpr float XM_PIDIV4 = 0.785398163f;
+
+	inline constexpr float XMConvertToRadians(float degrees) { return degrees * (XM_PI / 180.0f); }
+	inline constexpr float XMConvertToDegrees(float radians) { return radians * (180.0f / XM_PI); }
+
+	namespace SimpleMath
+	{
+		struct Matrix;
+
+		struct Vector2
+		{
+			float x = 0.0f;
+			float y = 0.0f;
+
+			Vector2() = default;
+			constexpr Vector2(float x, float y) : x(x), y(y) {}
+		};
+
+		struct Vector3
+		{
+			float x = 0.0f;
+			float y = 0.0f;
+			float z = 0.0f;
+
+			Vector3() = default;
+			constexpr Vector3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+			inline Vector3 operator+(const Vector3& v) const { return Vector3(x + v.x, y + v.y, z + v.z); }
+			inline Vector3 operator-(const Vector3& v) const { return Vector3(x - v.x, y - v.y, z - v.z); }
+			inline Vector3 operator*(float s) const { return Vector3(x * s, y * s, z * s); }
+			inline Vector3 operator/(float s) const { return Vector3(x / s, y / s, z / s); }
+			inline Vector3 operator-() const { return Vector3(-x, -y, -z); }
+
+			inline Vector3& operator+=(const Vector3& v) { x += v.x; y += v.y; z += v.z; return *this; }
+			inline Vector3& operator-=(const Vector3& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+			inline Vector3& operator*=(float s) { x *= s; y *= s; z *= s; return *this; }
+			inline Vector3& operator/=(float s) { x /= s; y /= s; z /= s; return *this; }
+
+			inline bool operator==(const Vector3& v) const { return x == v.x && y == v.y && z == v.z; }
+			inline bool operator!=(const Vector3& v) const { return !(*this == v); }
+
+			inline float Length() const { return sqrtf(LengthSquared()); }
+			inline float LengthSquared() const { return x * x + y * y + z * z; }
+			inline float Dot(const Vector3& v) const { return x * v.x + y * v.y + z * v.z; }
+			inline Vector3 Cross(const Vector3& v) const { return Vector3(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x); }
+
+			// A zero vector stays zero.
+			inline void Normalize()
+			{
+				float length = Length();
+				if (length > 0.0f)
+					*this *= 1.0f / length;
+			}
+
+			static inline Vector3 Min(const Vector3& a, const Vector3& b) { return Vector3(fminf(a.x, b.x), fminf(a.y, b.y), fminf(a.z, b.z)); }
+			static inline Vector3 Max(const Vector3& a, const Vector3& b) { return Vector3(fmaxf(a.x, b.x), fmaxf(a.y, b.y), fmaxf(a.z, b.z)); }
+			static inline float Distance(const Vector3& a, const Vector3& b) { return (a - b).Length(); }
+
+			// As a point: w = 1, and the result is divided by w.
+			static inline Vector3 Transform(const Vector3& v, const Matrix& m);
+		};
+
+		inline Vector3 operator*(float s, const Vector3& v) { return v * s; }
+
+		struct Vector4
+		{
+			float x = 0.0f;
+			float y = 0.0f;
+			float z = 0.0f;
+			float w = 0.0f;
+
+			Vector4() = default;
+			constexpr Vector4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+		};
+
+		// Row-major, and vectors are rows: v * world * view * proj.
+		struct Matrix
+		{
+			union
+			{
+				struct
+				{
+					float _11, _12, _13, _14;
+					float _21, _22, _23, _24;
+					float _31, _32, _33, _34;
+					float _41, _42, _43, _44;
+				};
+				float m[4][4];
+			};
+
+			// Identity, as SimpleMath's.
+			Matrix()
+				: _11(1.0f), _12(0.0f), _13(0.0f), _14(0.0f)
+				, _21(0.0f), _22(1.0f), _23(0.0f), _24(0.0f)
+				, _31(0.0f), _32(0.0f), _33(1.0f), _34(0.0f)
+				, _41(0.0f), _42(0.0f), _43(0.0f), _44(1.0f)
+			{
+			}
+
+			inline Matrix operator*(const Matrix& b) const
+			{
+				Matrix result;
+				for (int row = 0; row < 4; row++)
+				{
+					for (int column = 0; column < 4; column++)
+						result.m[row][column] = m[row][0] * b.m[0][column] + m[row][1] * b.m[1][column] + m[row][2] * b.m[2][column] + m[row][3] * b.m[3][column];
+				}
+
+				return result;
+			}
+
+			inline Matrix Transpose() const
+			{
+				Matrix result;
+				for (int row = 0; row < 4; row++)
+				{
+					for (int column = 0; column < 4; column++)
+						result.m[row][column] = m[column][row];
+				}
+
+				return result;
+			}
+
+			// By cofactors. A singular matrix gives infinities, as XMMatrixInverse.
+			inline Matrix Invert() const
+			{
+				// 2x2 determinants of the bottom two rows and of the top two.
+				float b0 = _31 * _42 - _32 * _41;
+				float b1 = _31 * _43 - _33 * _41;
+				float b2 = _31 * _44 - _34 * _41;
+				float b3 = _32 * _43 - _33 * _42;
+				float b4 = _32 * _44 - _34 * _42;
+				float b5 = _33 * _44 - _34 * _43;
+				float t0 = _11 * _22 - _12 * _21;
+				float t1 = _11 * _23 - _13 * _21;
+				float t2 = _11 * _24 - _14 * _21;
+				float t3 = _12 * _23 - _13 * _22;
+				float t4 = _12 * _24 - _14 * _22;
+				float t5 = _13 * _24 - _14 * _23;
+
+				float inverseDeterminant = 1.0f / (t0 * b5 - t1 * b4 + t2 * b3 + t3 * b2 - t4 * b1 + t5 * b0);
+
+				Matrix result;
+				result._11 = (_22 * b5 - _23 * b4 + _24 * b3) * inverseDeterminant;
+				result._12 = (-_12 * b5 + _13 * b4 - _14 * b3) * inverseDeterminant;
+				result._13 = (_42 * t5 - _43 * t4 + _44 * t3) * inverseDeterminant;
+				result._14 = (-_32 * t5 + _33 * t4 - _34 * t3) * inverseDeterminant;
+				result._21 = (-_21 * b5 + _23 * b2 - _24 * b1) * inverseDeterminant;
+				result._22 = (_11 * b5 - _13 * b2 + _14 * b1) * inverseDeterminant;
+				result._23 = (-_41 * t5 + _43 * t2 - _44 * t1) * inverseDeterminant;
+				result._24 = (_31 * t5 - _33 * t2 + _34 * t1) * inverseDeterminant;
+				result._31 = (_21 * b4 - _22 * b2 + _24 * b0) * inverseDeterminant;
+				result._32 = (-_11 * b4 + _12 * b2 - _14 * b0) * inverseDeterminant;
+				result._33 = (_41 * t4 - _42 * t2 + _44 * t0) * inverseDeterminant;
+				result._34 = (-_31 * t4 + _32 * t2 - _34 * t0) * inverseDeterminant;
+				result._41 = (-_21 * b3 + _22 * b1 - _23 * b0) * inverseDeterminant;
+				result._42 = (_11 * b3 - _12 * b1 + _13 * b0) * inverseDeterminant;
+				result._43 = (-_41 * t3 + _42 * t1 - _43 * t0) * inverseDeterminant;
+				result._44 = (_31 * t3 - _32 * t1 + _33 * t0) * inverseDeterminant;
+				return result;
+			}
+
+			inline Vector3 Translation() const { return Vector3(_41, _42, _43); }
+
+			static inline Matrix CreateTranslation(const Vector3& position) { return CreateTranslation(position.x, position.y, position.z); }
+			static inline Matrix CreateTranslation(float x, float y, float z)
+			{
+				Matrix result;
+				result._41 = x;
+				result._42 = y;
+				result._43 = z;
+				return result;
+			}
+
+			static inline Matrix CreateScale(float scale) { return CreateScale(scale, scale, scale); }
+			static inline Matrix CreateScale(const Vector3& scales) { return CreateScale(scales.x, scales.y, scales.z); }
+			static inline Matrix CreateScale(float x, float y, float z)
+			{
+				Matrix result;
+				result._11 = x;
+				result._22 = y;
+				result._33 = z;
+				return result;
+			}
+
+			static inline Matrix CreateRotationY(float radians)
+			{
+				float c = cosf(radians);
+				float s = sinf(radians);
+
+				Matrix result;
+				result._11 = c;
+				result._13 = -s;
+				result._31 = s;
+				result._33 = c;
+				return result;
+			}
+		};
+
+		inline Vector3 Vector3::Transform(const Vector3& v, const Matrix& m)
+		{
+			float x = v.x * m._11 + v.y * m._21 + v.z * m._31 + m._41;
+			float y = v.x * m._12 + v.y * m._22 + v.z * m._32 + m._42;
+			float z = v.x * m._13 + v.y * m._23 + v.z * m._33 + m._43;
+			float w = v.x * m._14 + v.y * m._24 + v.z * m._34 + m._44;
+			return Vector3(x / w, y / w, z / w);
+		}
+	}
+
+	// DirectXMath returns XMMATRIX, which converts to Matrix; these return it.
+	inline SimpleMath::Matrix XMMatrixLookToLH(const SimpleMath::Vector3& eyePosition, const SimpleMath::Vector3& eyeDirection, const SimpleMath::Vector3& upDirection)
+	{
+		SimpleMath::Vector3 zAxis = eyeDirection;
+		zAxis.Normalize();
+		SimpleMath::Vector3 xAxis = upDirection.Cross(zAxis);
+		xAxis.Normalize();
+		SimpleMath::Vector3 yAxis = zAxis.Cross(xAxis);
+
+		SimpleMath::Matrix result;
+		result._11 = xAxis.x;
+		result._21 = xAxis.y;
+		result._31 = xAxis.z;
+		result._12 = yAxis.x;
+		result._22 = yAxis.y;
+		result._32 = yAxis.z;
+		result._13 = zAxis.x;
+		result._23 = zAxis.y;
+		result._33 = zAxis.z;
+		result._41 = -xAxis.Dot(eyePosition);
+		result._42 = -yAxis.Dot(eyePosition);
+		result._43 = -zAxis.Dot(eyePosition);
+		return result;
+	}
+
+	// Depth 0 at nearZ and 1 at farZ.
+	inline SimpleMath::Matrix XMMatrixPerspectiveFovLH(float fovAngleY, float aspectRatio, float nearZ, float farZ)
+	{
+		float height = 1.0f / tanf(fovAngleY * 0.5f);
+		float range = farZ / (farZ - nearZ);
+
+		SimpleMath::Matrix result;
+		result._11 = height / aspectRatio;
+		result._22 = height;
+		result._33 = range;
+		result._34 = 1.0f;
+		result._43 = -range * nearZ;
+		result._44 = 0.0f;
+		return result;
+	}
+}
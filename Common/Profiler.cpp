@@ -0,0 +1,307 @@
+#include "Profiler.h"
+#include "Platform.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/*
+========
+Profiler
+========
+*/
+
+namespace Profiler
+{
+	// Fields are relaxed atomics so the trace can be written while the owner
+	// thread records; on x86 these are plain loads and stores.
+	struct Event
+	{
+		std::atomic<const char*> name;
+		std::atomic<uint64> begin;
+		std::atomic<uint64> end;
+		std::atomic<uint32> depth;
+	};
+
+	struct ThreadEvents
+	{
+		Event* events = nullptr;
+		uint32 capacity = 0;
+		uint32 id = 0;
+		std::atomic<const char*> name = { nullptr };
+
+		// An event is claimed before its slot is written and published after,
+		// so a reader can tell which slots may have changed under it.
+		std::atomic<uint64> claimed = { 0 };
+		std::atomic<uint64> published = { 0 };
+
+		// Open zones; only the owner thread touches these.
+		uint64 stackBegins[PROFILER_MAX_DEPTH] = {};
+		const char* stackNames[PROFILER_MAX_DEPTH] = {};
+		uint32 depth = 0;
+	};
+
+	struct TraceEvent
+	{
+		const char* name;
+		uint64 begin;
+		uint64 end;
+		uint32 depth;
+		uint32 threadId;
+	};
+
+	static std::mutex s_lock;
+	static std::vector<ThreadEvents*> s_threads;
+	static uint32 s_eventsPerThread = 0;
+	static uint64 s_startTicks = 0;
+
+	// 0 while not initialized. Bumped by every Init so threads drop buffers from
+	// a previous session.
+	static std::atomic<uint32> s_generation = { 0 };
+	static uint32 s_lastGeneration = 0;
+
+	static thread_local ThreadEvents* t_events = nullptr;
+	static thread_local uint32 t_generation = 0;
+
+	static ThreadEvents* CreateThreadEvents()
+	{
+		ThreadEvents* events = new ThreadEvents;
+		events->capacity = s_eventsPerThread;
+		events->events = new Event[s_eventsPerThread];
+		events->id = static_cast<uint32>(s_threads.size()) + 1;
+		s_threads.push_back(events);
+		return events;
+	}
+
+	// Only one thread at a time may push to a given ring.
+	static void PushEvent(ThreadEvents* events, const char* name, uint64 begin, uint64 end, uint32 depth)
+	{
+		uint64 index = events->published.load(std::memory_order_relaxed);
+		events->claimed.store(index + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		Event& event = events->events[index % events->capacity];
+		event.name.store(name, std::memory_order_relaxed);
+		event.begin.store(begin, std::memory_order_relaxed);
+		event.end.store(end, std::memory_order_relaxed);
+		event.depth.store(depth, std::memory_order_relaxed);
+
+		events->published.store(index + 1, std::memory_order_release);
+	}
+
+	static ThreadEvents* GetThreadEvents()
+	{
+		uint32 generation = s_generation.load(std::memory_order_acquire);
+		if (generation == 0)
+			return nullptr;
+
+		if (t_generation == generation)
+			return t_events;
+
+		// Once per thread and session.
+		std::lock_guard<std::mutex> lock(s_lock);
+		if (s_generation.load(std::memory_order_relaxed) != generation)
+			return nullptr;
+
+		ThreadEvents* events = CreateThreadEvents();
+		t_events = events;
+		t_generation = generation;
+		return events;
+	}
+
+	static void WriteEscaped(FILE* file, const char* text)
+	{
+		for (const char* c = text; *c; c++)
+		{
+			if (*c == '"' || *c == '\\')
+				fputc('\\', file);
+			fputc(*c, file);
+		}
+	}
+
+	void Init(uint32 eventsPerThread)
+	{
+		std::lock_guard<std::mutex> lock(s_lock);
+		if (s_generation.load(std::memory_order_relaxed) != 0)
+			return;
+
+		s_eventsPerThread = eventsPerThread ? eventsPerThread : 1;
+		s_startTicks = GetTicks();
+
+		s_generation.store(++s_lastGeneration, std::memory_order_release);
+	}
+
+	void Clean()
+	{
+		std::lock_guard<std::mutex> lock(s_lock);
+		s_generation.store(0, std::memory_order_release);
+
+		for (ThreadEvents* events : s_threads)
+		{
+			delete[] events->events;
+			delete events;
+		}
+		s_threads.clear();
+	}
+
+	void BeginZone(const char* name)
+	{
+		ThreadEvents* events = GetThreadEvents();
+		if (!events)
+			return;
+
+		// Zones deeper than the stack are not recorded, but still counted so
+		// their EndZone calls match up.
+		if (events->depth < PROFILER_MAX_DEPTH)
+		{
+			events->stackNames[events->depth] = name;
+			events->stackBegins[events->depth] = GetTicks();
+		}
+		events->depth++;
+	}
+
+	void EndZone()
+	{
+		ThreadEvents* events = GetThreadEvents();
+		if (!events || events->depth == 0)
+			return;
+
+		uint64 end = GetTicks();
+		uint32 depth = --events->depth;
+		if (depth >= PROFILER_MAX_DEPTH)
+			return;
+
+		PushEvent(events, events->stackNames[depth], events->stackBegins[depth], end, depth);
+	}
+
+	void SetThreadName(const char* name)
+	{
+		ThreadEvents* events = GetThreadEvents();
+		if (events)
+			events->name.store(name, std::memory_order_relaxed);
+	}
+
+	uint32 CreateTrack(const char* name)
+	{
+		std::lock_guard<std::mutex> lock(s_lock);
+		if (s_generation.load(std::memory_order_relaxed) == 0)
+			return 0;
+
+		ThreadEvents* events = CreateThreadEvents();
+		events->name.store(name, std::memory_order_relaxed);
+		return events->id;
+	}
+
+	void AddZone(uint32 trackId, const char* name, uint64 beginTicks, uint64 endTicks, uint32 depth)
+	{
+		std::lock_guard<std::mutex> lock(s_lock);
+		if (s_generation.load(std::memory_order_relaxed) == 0 || trackId == 0 || trackId > s_threads.size())
+			return;
+
+		PushEvent(s_threads[trackId - 1], name, beginTicks, endTicks, depth);
+	}
+
+	uint64 GetTicks()
+	{
+		return Platform::GetTicks();
+	}
+
+	uint64 GetTicksPerSecond()
+	{
+		return Platform::GetTicksPerSecond();
+	}
+
+	bool WriteChromeTrace(const char* filename)
+	{
+		std::vector<TraceEvent> traceEvents;
+		std::vector<TraceEvent> threadNames;
+		uint64 startTicks = 0;
+		{
+			std::lock_guard<std::mutex> lock(s_lock);
+			if (s_generation.load(std::memory_order_relaxed) == 0)
+				return false;
+
+			startTicks = s_startTicks;
+
+			for (ThreadEvents* events : s_threads)
+			{
+				TraceEvent threadName = {};
+				threadName.name = events->name.load(std::memory_order_relaxed);
+				threadName.threadId = events->id;
+				if (threadName.name)
+					threadNames.push_back(threadName);
+
+				uint64 end = events->published.load(std::memory_order_acquire);
+				uint64 start = end > events->capacity ? end - events->capacity : 0;
+
+				size_t first = traceEvents.size();
+				for (uint64 i = start; i < end; i++)
+				{
+					Event& event = events->events[i % events->capacity];
+
+					TraceEvent traceEvent;
+					traceEvent.name = event.name.load(std::memory_order_relaxed);
+					traceEvent.begin = event.begin.load(std::memory_order_relaxed);
+					traceEvent.end = event.end.load(std::memory_order_relaxed);
+					traceEvent.depth = event.depth.load(std::memory_order_relaxed);
+					traceEvent.threadId = events->id;
+					traceEvents.push_back(traceEvent);
+				}
+
+				// Slots claimed since the copy started may hold a newer, torn
+				// event. They are the oldest ones copied.
+				std::atomic_thread_fence(std::memory_order_acquire);
+				uint64 claimed = events->claimed.load(std::memory_order_relaxed);
+				uint64 firstValid = claimed > events->capacity ? claimed - events->capacity : 0;
+				if (firstValid > start)
+				{
+					uint64 dropped = (firstValid < end ? firstValid : end) - start;
+					traceEvents.erase(traceEvents.begin() + first, traceEvents.begin() + first + static_cast<size_t>(dropped));
+				}
+			}
+		}
+
+		// Parents before children, so viewers nest zones that start on the same tick.
+		std::sort(traceEvents.begin(), traceEvents.end(), [](const TraceEvent& a, const TraceEvent& b)
+		{
+			if (a.threadId != b.threadId)
+				return a.threadId < b.threadId;
+			if (a.begin != b.begin)
+				return a.begin < b.begin;
+			return a.depth < b.depth;
+		});
+
+		FILE* file = Platform::OpenFile(filename, "wb");
+		if (file == nullptr)
+			return false;
+
+		double microsecondsPerTick = 1000000.0 / static_cast<double>(GetTicksPerSecond());
+
+		fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"XFree\"}}");
+
+		for (const TraceEvent& threadName : threadNames)
+		{
+			fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", threadName.threadId);
+			WriteEscaped(file, threadName.name);
+			fprintf(file, "\"}}");
+		}
+
+		for (const TraceEvent& event : traceEvents)
+		{
+			double begin = static_cast<double>(event.begin - startTicks) * microsecondsPerTick;
+			double duration = static_cast<double>(event.end - event.begin) * microsecondsPerTick;
+
+			fprintf(file, ",\n{\"name\":\"");
+			WriteEscaped(file, event.name);
+			fprintf(file, "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", event.threadId, begin, duration);
+		}
+
+		fprintf(file, "\n]}\n");
+		bool succeeded = ferror(file) == 0;
+		fclose(file);
+		return succeeded;
+	}
+}
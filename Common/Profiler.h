@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Types.h"
+
+/*
+========
+Profiler
+========
+*/
+
+// Release-noprof builds (XFREE_PROFILER=OFF in CMake) define PROFILER_DISABLED,
+// which compiles every PROFILE_* macro to nothing. The functions below stay
+// available either way.
+#if defined(PROFILER_DISABLED)
+	#define PROFILER_ENABLED 0
+#else
+	#define PROFILER_ENABLED 1
+#endif
+
+const uint32 PROFILER_DEFAULT_EVENTS_PER_THREAD = 64 * 1024;
+const uint32 PROFILER_MAX_DEPTH = 32;
+
+// CPU zones are timed with a monotonic clock (QPC on Windows) and kept in a
+// ring per thread, so recording takes no lock and the newest events win when
+// a ring wraps. A zone is stored once it ends, with its nesting depth, and
+// becomes one complete event in the trace. Zone and thread names must outlive
+// the profiler: pass string literals.
+namespace Profiler
+{
+	void Init(uint32 eventsPerThread = PROFILER_DEFAULT_EVENTS_PER_THREAD);
+	// No thread may be inside a zone.
+	void Clean();
+
+	void BeginZone(const char* name);
+	void EndZone();
+
+	// Names the calling thread in the trace.
+	void SetThreadName(const char* name);
+
+	// Zones timed elsewhere, such as on the GPU, go on a track of their own.
+	// Returns 0 when the profiler is not initialized; the id is only valid until
+	// Clean. AddZone takes GetTicks() ticks and a lock, so it suits a handful of
+	// zones per frame.
+	uint32 CreateTrack(const char* name);
+	void AddZone(uint32 trackId, const char* name, uint64 beginTicks, uint64 endTicks, uint32 depth);
+
+	uint64 GetTicks();
+	uint64 GetTicksPerSecond();
+
+	// Chrome about:tracing / Perfetto JSON of every event still in the rings.
+	// Threads may keep recording; events overwritten meanwhile are left out.
+	bool WriteChromeTrace(const char* filename);
+}
+
+class ProfileScope
+{
+public:
+	inline ProfileScope(const char* name) { Profiler::BeginZone(name); }
+	inline ~ProfileScope() { Profiler::EndZone(); }
+};
+
+#if PROFILER_ENABLED
+	#define PROFILE_CONCAT_INNER(a, b) a##b
+	#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+	#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+	#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+	#define PROFILE_THREAD_NAME(name) Profiler::SetThreadName(name)
+#else
+	#define PROFILE_SCOPE(name)
+	#define PROFILE_FUNCTION()
+	#define PROFILE_THREAD_NAME(name)
+#endif
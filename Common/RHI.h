@@ -0,0 +1,164 @@
+#pragma once
+
+#include "Types.h"
+
+/*
+===
+RHI
+===
+*/
+
+// Each backend defines what these point to; they are only passed back to the
+// device that created them.
+struct RHIBuffer;
+struct RHITexture;
+struct RHIPipeline;
+
+const uint32 RHI_INVALID_INDEX = 0xffffffff;
+
+// Values match DXGI_FORMAT.
+enum RHI_FORMAT
+{
+	RHI_FORMAT_UNKNOWN = 0,
+	RHI_FORMAT_R8G8B8A8_UNORM = 28,
+	RHI_FORMAT_R32_UINT = 42,
+	RHI_FORMAT_D24_UNORM_S8_UINT = 45,
+	RHI_FORMAT_R16_UINT = 57,
+};
+
+// Constants bound per draw or per frame; the layouts are the shaders' cbuffers.
+enum RHI_CONSTANTS_SLOT
+{
+	RHI_CONSTANTS_SLOT_OBJECT,
+	RHI_CONSTANTS_SLOT_FRAME,
+	RHI_CONSTANTS_SLOT_COUNT,
+};
+
+enum RHI_BUFFER_USAGE
+{
+	RHI_BUFFER_USAGE_VERTEX,
+	RHI_BUFFER_USAGE_INDEX,
+};
+
+enum RHI_TEXTURE_USAGE
+{
+	RHI_TEXTURE_USAGE_SHADER_RESOURCE = 0x1,
+	RHI_TEXTURE_USAGE_RENDER_TARGET = 0x2,
+	RHI_TEXTURE_USAGE_DEPTH_STENCIL = 0x4,
+};
+
+enum RHI_RESOURCE_STATE
+{
+	RHI_RESOURCE_STATE_COMMON,
+	RHI_RESOURCE_STATE_RENDER_TARGET,
+	RHI_RESOURCE_STATE_DEPTH_WRITE,
+	RHI_RESOURCE_STATE_SHADER_RESOURCE,
+	RHI_RESOURCE_STATE_COPY_SOURCE,
+	RHI_RESOURCE_STATE_COPY_DEST,
+	RHI_RESOURCE_STATE_PRESENT,
+};
+
+// Buffers are immutable: the data is uploaded at creation and the buffer stays
+// in the state its usage needs, so only textures take barriers.
+struct RHIBufferDesc
+{
+	RHI_BUFFER_USAGE usage = RHI_BUFFER_USAGE_VERTEX;
+	uint32 size = 0;
+	uint32 stride = 0;				// Vertex size, or 2 or 4 for 16 or 32-bit indices.
+};
+
+struct RHITextureDesc
+{
+	uint32 width = 0;
+	uint32 height = 0;
+	RHI_FORMAT format = RHI_FORMAT_R8G8B8A8_UNORM;
+	uint32 usage = RHI_TEXTURE_USAGE_SHADER_RESOURCE;	// RHI_TEXTURE_USAGE flags.
+	float clearColor[4] = {};		// Fast clear values for render and depth targets.
+	float clearDepth = 1.0f;
+};
+
+// Pipelines draw triangle lists of the engine's Vertex, and read textures by
+// the index GetTextureIndex gives. Faces are clockwise and back faces are culled.
+struct RHIPipelineDesc
+{
+	uint32 features = 0;					// MATERIAL_FEATURE flags the shaders were built with.
+	const void* vertexShader = nullptr;		// Bytecode in the backend's format; CPU backends run their own VSMain and PSMain.
+	uint32 vertexShaderSize = 0;
+	const void* pixelShader = nullptr;
+	uint32 pixelShaderSize = 0;
+	RHI_FORMAT colorFormat = RHI_FORMAT_R8G8B8A8_UNORM;
+	RHI_FORMAT depthFormat = RHI_FORMAT_D24_UNORM_S8_UINT;
+	bool depthTest = true;
+};
+
+/*
+================
+RHICommandList
+================
+*/
+
+// Records the operations the renderer submits. Lists are recorded on one
+// thread at a time and reused from frame to frame.
+class RHICommandList
+{
+public:
+	virtual ~RHICommandList() {}
+
+	// Waits until the list's previous submission is done with its memory.
+	virtual void Begin() = 0;
+	virtual void End() = 0;
+
+	virtual void TextureBarrier(RHITexture* texture, RHI_RESOURCE_STATE before, RHI_RESOURCE_STATE after) = 0;
+	// Either target may be nullptr.
+	virtual void SetRenderTargets(RHITexture* colorTarget, RHITexture* depthTarget) = 0;
+	virtual void ClearRenderTarget(RHITexture* texture, const float color[4]) = 0;
+	virtual void ClearDepth(RHITexture* texture, float depth) = 0;
+	// Viewport and scissor over the top-left width by height pixels.
+	virtual void SetViewport(uint32 width, uint32 height) = 0;
+
+	virtual void SetPipeline(RHIPipeline* pipeline) = 0;
+	// Copies size bytes for the draws that follow. Returns false when the
+	// frame's constant memory is full; the draw should be skipped.
+	virtual bool SetConstants(RHI_CONSTANTS_SLOT slot, const void* data, uint32 size) = 0;
+	virtual void SetVertexBuffer(RHIBuffer* buffer) = 0;
+	virtual void SetIndexBuffer(RHIBuffer* buffer) = 0;
+	virtual void DrawIndexed(uint32 indexCount, uint32 startIndex, int32 baseVertex) = 0;
+};
+
+/*
+==========
+RHIDevice
+==========
+*/
+
+// Creates resources and submits command lists. Objects are destroyed once
+// every submission so far is done with them, so they can be destroyed while
+// still referenced by lists in flight.
+class RHIDevice
+{
+public:
+	virtual ~RHIDevice() {}
+
+	// Returns nullptr on failure.
+	virtual RHIBuffer* CreateBuffer(const RHIBufferDesc& desc, const void* data) = 0;
+	virtual void DestroyBuffer(RHIBuffer* buffer) = 0;
+
+	// data holds mip 0 and may be nullptr for render and depth targets, which
+	// start in RENDER_TARGET and DEPTH_WRITE. Other textures start in SHADER_RESOURCE.
+	virtual RHITexture* CreateTexture(const RHITextureDesc& desc, const void* data, uint32 rowPitch) = 0;
+	virtual void DestroyTexture(RHITexture* texture) = 0;
+	// Shader resource index of the texture, for material and draw constants.
+	virtual uint32 GetTextureIndex(RHITexture* texture) = 0;
+
+	virtual RHIPipeline* CreatePipeline(const RHIPipelineDesc& desc) = 0;
+	virtual void DestroyPipeline(RHIPipeline* pipeline) = 0;
+
+	virtual RHICommandList* CreateCommandList() = 0;
+	virtual void DestroyCommandList(RHICommandList* commandList) = 0;
+
+	// Executes the lists in order and returns the fence value signaled once
+	// they are done.
+	virtual uint64 Submit(RHICommandList* const* commandLists, uint32 commandListsCount) = 0;
+	virtual uint64 GetCompletedFenceValue() = 0;
+	virtual void WaitForFence(uint64 fenceValue) = 0;
+};
@@ -0,0 +1,272 @@
+#include "RHINull.h"
+
+#include <string.h>
+
+/*
+===================
+NullRHICommandList
+===================
+*/
+
+NullRHICommandList::NullRHICommandList()
+{
+	m_capacity = s_InitialCapacity;
+	m_commands = new uint8[m_capacity];
+}
+
+NullRHICommandList::~NullRHICommandList()
+{
+	if (m_commands)
+	{
+		delete[] m_commands;
+		m_commands = nullptr;
+	}
+}
+
+void NullRHICommandList::Begin()
+{
+	m_size = 0;
+}
+
+void NullRHICommandList::End()
+{
+}
+
+void NullRHICommandList::TextureBarrier(RHITexture* texture, RHI_RESOURCE_STATE before, RHI_RESOURCE_STATE after)
+{
+	RHICommandTextureBarrier* command = static_cast<RHICommandTextureBarrier*>(Push(RHI_COMMAND_TEXTURE_BARRIER, sizeof(RHICommandTextureBarrier)));
+	command->texture = texture;
+	command->before = before;
+	command->after = after;
+}
+
+void NullRHICommandList::SetRenderTargets(RHITexture* colorTarget, RHITexture* depthTarget)
+{
+	RHICommandSetRenderTargets* command = static_cast<RHICommandSetRenderTargets*>(Push(RHI_COMMAND_SET_RENDER_TARGETS, sizeof(RHICommandSetRenderTargets)));
+	command->colorTarget = colorTarget;
+	command->depthTarget = depthTarget;
+}
+
+void NullRHICommandList::ClearRenderTarget(RHITexture* texture, const float color[4])
+{
+	RHICommandClearRenderTarget* command = static_cast<RHICommandClearRenderTarget*>(Push(RHI_COMMAND_CLEAR_RENDER_TARGET, sizeof(RHICommandClearRenderTarget)));
+	command->texture = texture;
+	::memcpy(command->color, color, sizeof(command->color));
+}
+
+void NullRHICommandList::ClearDepth(RHITexture* texture, float depth)
+{
+	RHICommandClearDepth* command = static_cast<RHICommandClearDepth*>(Push(RHI_COMMAND_CLEAR_DEPTH, sizeof(RHICommandClearDepth)));
+	command->texture = texture;
+	command->depth = depth;
+}
+
+void NullRHICommandList::SetViewport(uint32 width, uint32 height)
+{
+	RHICommandSetViewport* command = static_cast<RHICommandSetViewport*>(Push(RHI_COMMAND_SET_VIEWPORT, sizeof(RHICommandSetViewport)));
+	command->width = width;
+	command->height = height;
+}
+
+void NullRHICommandList::SetPipeline(RHIPipeline* pipeline)
+{
+	RHICommandSetPipeline* command = static_cast<RHICommandSetPipeline*>(Push(RHI_COMMAND_SET_PIPELINE, sizeof(RHICommandSetPipeline)));
+	command->pipeline = pipeline;
+}
+
+bool NullRHICommandList::SetConstants(RHI_CONSTANTS_SLOT slot, const void* data, uint32 size)
+{
+	RHICommandSetConstants* command = static_cast<RHICommandSetConstants*>(Push(RHI_COMMAND_SET_CONSTANTS, sizeof(RHICommandSetConstants) + size));
+	command->slot = slot;
+	command->dataSize = size;
+	::memcpy(command + 1, data, size);
+	return true;
+}
+
+void NullRHICommandList::SetVertexBuffer(RHIBuffer* buffer)
+{
+	RHICommandSetBuffer* command = static_cast<RHICommandSetBuffer*>(Push(RHI_COMMAND_SET_VERTEX_BUFFER, sizeof(RHICommandSetBuffer)));
+	command->buffer = buffer;
+}
+
+void NullRHICommandList::SetIndexBuffer(RHIBuffer* buffer)
+{
+	RHICommandSetBuffer* command = static_cast<RHICommandSetBuffer*>(Push(RHI_COMMAND_SET_INDEX_BUFFER, sizeof(RHICommandSetBuffer)));
+	command->buffer = buffer;
+}
+
+void NullRHICommandList::DrawIndexed(uint32 indexCount, uint32 startIndex, int32 baseVertex)
+{
+	RHICommandDrawIndexed* command = static_cast<RHICommandDrawIndexed*>(Push(RHI_COMMAND_DRAW_INDEXED, sizeof(RHICommandDrawIndexed)));
+	command->indexCount = indexCount;
+	command->startIndex = startIndex;
+	command->baseVertex = baseVertex;
+}
+
+void* NullRHICommandList::Push(RHI_COMMAND type, uint32 size)
+{
+	size = (size + 7) & ~7u;
+
+	if (m_size + size > m_capacity)
+	{
+		uint64 capacity = m_capacity * 2;
+		while (m_size + size > capacity)
+			capacity *= 2;
+
+		uint8* commands = new uint8[capacity];
+		::memcpy(commands, m_commands, m_size);
+		delete[] m_commands;
+		m_commands = commands;
+		m_capacity = capacity;
+	}
+
+	RHICommandHeader* header = reinterpret_cast<RHICommandHeader*>(m_commands + m_size);
+	header->type = type;
+	header->padding = 0;
+	header->size = size;
+	m_size += size;
+	return header;
+}
+
+/*
+=============
+NullRHIDevice
+=============
+*/
+
+RHIBuffer* NullRHIDevice::CreateBuffer(const RHIBufferDesc& desc, const void* data)
+{
+	if (desc.size == 0 || data == nullptr)
+		return nullptr;
+
+	NullRHIBuffer* buffer = new NullRHIBuffer;
+	buffer->desc = desc;
+	buffer->data = new uint8[desc.size];
+	::memcpy(buffer->data, data, desc.size);
+	return reinterpret_cast<RHIBuffer*>(buffer);
+}
+
+void NullRHIDevice::DestroyBuffer(RHIBuffer* buffer)
+{
+	NullRHIBuffer* nullBuffer = ToBuffer(buffer);
+	if (nullBuffer == nullptr)
+		return;
+
+	delete[] nullBuffer->data;
+	delete nullBuffer;
+}
+
+RHITexture* NullRHIDevice::CreateTexture(const RHITextureDesc& desc, const void* data, uint32 rowPitch)
+{
+	if (desc.width == 0 || desc.height == 0)
+		return nullptr;
+
+	// Every format the RHI has is 4 bytes per pixel. Rows are padded to four
+	// pixels so CPU backends can work on whole groups of four.
+	uint32 packedPitch = desc.width * 4;
+	if (data && rowPitch < packedPitch)
+		return nullptr;
+
+	NullRHITexture* texture = new NullRHITexture;
+	texture->desc = desc;
+	texture->rowPitch = (packedPitch + 15) & ~15u;
+	texture->data = new uint8[static_cast<uint64>(texture->rowPitch) * desc.height];
+	texture->index = m_texturesCount++;
+
+	::memset(texture->data, 0, static_cast<uint64>(texture->rowPitch) * desc.height);
+	if (data)
+	{
+		for (uint32 y = 0; y < desc.height; y++)
+			::memcpy(texture->data + static_cast<uint64>(y) * texture->rowPitch, static_cast<const uint8*>(data) + static_cast<uint64>(y) * rowPitch, packedPitch);
+	}
+
+	return reinterpret_cast<RHITexture*>(texture);
+}
+
+void NullRHIDevice::DestroyTexture(RHITexture* texture)
+{
+	NullRHITexture* nullTexture = ToTexture(texture);
+	if (nullTexture == nullptr)
+		return;
+
+	delete[] nullTexture->data;
+	delete nullTexture;
+}
+
+uint32 NullRHIDevice::GetTextureIndex(RHITexture* texture)
+{
+	NullRHITexture* nullTexture = ToTexture(texture);
+	return nullTexture ? nullTexture->index : RHI_INVALID_INDEX;
+}
+
+RHIPipeline* NullRHIDevice::CreatePipeline(const RHIPipelineDesc& desc)
+{
+	NullRHIPipeline* pipeline = new NullRHIPipeline;
+	pipeline->desc = desc;
+	pipeline->desc.vertexShader = nullptr;
+	pipeline->desc.pixelShader = nullptr;
+	return reinterpret_cast<RHIPipeline*>(pipeline);
+}
+
+void NullRHIDevice::DestroyPipeline(RHIPipeline* pipeline)
+{
+	delete ToPipeline(pipeline);
+}
+
+RHICommandList* NullRHIDevice::CreateCommandList()
+{
+	return new NullRHICommandList;
+}
+
+void NullRHIDevice::DestroyCommandList(RHICommandList* commandList)
+{
+	delete commandList;
+}
+
+uint64 NullRHIDevice::Submit(RHICommandList* const* commandLists, uint32 commandListsCount)
+{
+	for (uint32 i = 0; i < commandListsCount; i++)
+	{
+		// Lists submitted to a device are always the ones it created.
+		const NullRHICommandList* commandList = static_cast<const NullRHICommandList*>(commandLists[i]);
+		Execute(commandList->GetCommands(), commandList->GetCommandsSize());
+		m_stats.recordedBytes += commandList->GetCommandsSize();
+	}
+
+	m_stats.submitsCount++;
+	return ++m_fenceValue;
+}
+
+uint64 NullRHIDevice::GetCompletedFenceValue()
+{
+	return m_fenceValue;
+}
+
+void NullRHIDevice::WaitForFence(uint64 fenceValue)
+{
+	(void)fenceValue;
+}
+
+void NullRHIDevice::Execute(const uint8* commands, uint64 size)
+{
+	uint64 offset = 0;
+	while (offset < size)
+	{
+		const RHICommandHeader* header = reinterpret_cast<const RHICommandHeader*>(commands + offset);
+		switch (header->type)
+		{
+		case RHI_COMMAND_SET_CONSTANTS:
+			m_stats.constantBytes += reinterpret_cast<const RHICommandSetConstants*>(header)->dataSize;
+			break;
+		case RHI_COMMAND_DRAW_INDEXED:
+			m_stats.drawsCount++;
+			m_stats.indicesCount += reinterpret_cast<const RHICommandDrawIndexed*>(header)->indexCount;
+			break;
+		default:
+			break;
+		}
+
+		m_stats.commandsCount++;
+		offset += header->size;
+	}
+}
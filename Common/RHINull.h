@@ -0,0 +1,222 @@
+#pragma once
+
+#include "RHI.h"
+
+/*
+===================
+RHI Command Stream
+===================
+*/
+
+enum RHI_COMMAND : uint16
+{
+	RHI_COMMAND_TEXTURE_BARRIER,
+	RHI_COMMAND_SET_RENDER_TARGETS,
+	RHI_COMMAND_CLEAR_RENDER_TARGET,
+	RHI_COMMAND_CLEAR_DEPTH,
+	RHI_COMMAND_SET_VIEWPORT,
+	RHI_COMMAND_SET_PIPELINE,
+	RHI_COMMAND_SET_CONSTANTS,
+	RHI_COMMAND_SET_VERTEX_BUFFER,
+	RHI_COMMAND_SET_INDEX_BUFFER,
+	RHI_COMMAND_DRAW_INDEXED,
+	RHI_COMMAND_COUNT,
+};
+
+// Every command starts with a header, and size includes the header and any
+// data after the command so the stream can be walked without knowing every
+// type. Commands are 8-byte aligned.
+struct RHICommandHeader
+{
+	RHI_COMMAND type = RHI_COMMAND_COUNT;
+	uint16 padding = 0;
+	uint32 size = 0;
+};
+
+struct RHICommandTextureBarrier
+{
+	RHICommandHeader header;
+	RHITexture* texture;
+	RHI_RESOURCE_STATE before;
+	RHI_RESOURCE_STATE after;
+};
+
+struct RHICommandSetRenderTargets
+{
+	RHICommandHeader header;
+	RHITexture* colorTarget;
+	RHITexture* depthTarget;
+};
+
+struct RHICommandClearRenderTarget
+{
+	RHICommandHeader header;
+	RHITexture* texture;
+	float color[4];
+};
+
+struct RHICommandClearDepth
+{
+	RHICommandHeader header;
+	RHITexture* texture;
+	float depth;
+};
+
+struct RHICommandSetViewport
+{
+	RHICommandHeader header;
+	uint32 width;
+	uint32 height;
+};
+
+struct RHICommandSetPipeline
+{
+	RHICommandHeader header;
+	RHIPipeline* pipeline;
+};
+
+// Followed by dataSize bytes of constants.
+struct RHICommandSetConstants
+{
+	RHICommandHeader header;
+	RHI_CONSTANTS_SLOT slot;
+	uint32 dataSize;
+};
+
+struct RHICommandSetBuffer
+{
+	RHICommandHeader header;
+	RHIBuffer* buffer;
+};
+
+struct RHICommandDrawIndexed
+{
+	RHICommandHeader header;
+	uint32 indexCount;
+	uint32 startIndex;
+	int32 baseVertex;
+};
+
+/*
+=================
+Null RHI Objects
+=================
+*/
+
+// Null objects keep their description and a CPU copy of their data, so a
+// backend that executes the stream on the CPU can build on the null device.
+struct NullRHIBuffer
+{
+	RHIBufferDesc desc = {};
+	uint8* data = nullptr;
+};
+
+struct NullRHITexture
+{
+	RHITextureDesc desc = {};
+	uint32 rowPitch = 0;			// width * 4, rounded up to 16 bytes.
+	uint8* data = nullptr;			// rowPitch * height bytes.
+	uint32 index = RHI_INVALID_INDEX;
+};
+
+struct NullRHIPipeline
+{
+	RHIPipelineDesc desc = {};		// The shader pointers are not kept valid.
+};
+
+struct RHINullStats
+{
+	uint64 submitsCount = 0;
+	uint64 commandsCount = 0;
+	uint64 drawsCount = 0;
+	uint64 indicesCount = 0;
+	uint64 constantBytes = 0;
+	uint64 recordedBytes = 0;
+};
+
+/*
+===================
+NullRHICommandList
+===================
+*/
+
+// Records commands into a growable block of memory.
+class NullRHICommandList : public RHICommandList
+{
+public:
+	NullRHICommandList();
+	~NullRHICommandList() override;
+
+	void Begin() override;
+	void End() override;
+
+	void TextureBarrier(RHITexture* texture, RHI_RESOURCE_STATE before, RHI_RESOURCE_STATE after) override;
+	void SetRenderTargets(RHITexture* colorTarget, RHITexture* depthTarget) override;
+	void ClearRenderTarget(RHITexture* texture, const float color[4]) override;
+	void ClearDepth(RHITexture* texture, float depth) override;
+	void SetViewport(uint32 width, uint32 height) override;
+
+	void SetPipeline(RHIPipeline* pipeline) override;
+	bool SetConstants(RHI_CONSTANTS_SLOT slot, const void* data, uint32 size) override;
+	void SetVertexBuffer(RHIBuffer* buffer) override;
+	void SetIndexBuffer(RHIBuffer* buffer) override;
+	void DrawIndexed(uint32 indexCount, uint32 startIndex, int32 baseVertex) override;
+
+	inline const uint8* GetCommands() const { return m_commands; }
+	inline uint64 GetCommandsSize() const { return m_size; }
+
+private:
+	static const uint64 s_InitialCapacity = 64 * 1024;
+
+	uint8* m_commands = nullptr;
+	uint64 m_size = 0;
+	uint64 m_capacity = 0;
+
+	void* Push(RHI_COMMAND type, uint32 size);
+};
+
+/*
+=============
+NullRHIDevice
+=============
+*/
+
+// Runs without a GPU: objects live in CPU memory and submitted lists are walked
+// on the calling thread, so every fence is complete when Submit returns. Used
+// to profile the submission path headlessly and as a base for CPU backends.
+class NullRHIDevice : public RHIDevice
+{
+public:
+	RHIBuffer* CreateBuffer(const RHIBufferDesc& desc, const void* data) override;
+	void DestroyBuffer(RHIBuffer* buffer) override;
+
+	RHITexture* CreateTexture(const RHITextureDesc& desc, const void* data, uint32 rowPitch) override;
+	void DestroyTexture(RHITexture* texture) override;
+	uint32 GetTextureIndex(RHITexture* texture) override;
+
+	RHIPipeline* CreatePipeline(const RHIPipelineDesc& desc) override;
+	void DestroyPipeline(RHIPipeline* pipeline) override;
+
+	RHICommandList* CreateCommandList() override;
+	void DestroyCommandList(RHICommandList* commandList) override;
+
+	uint64 Submit(RHICommandList* const* commandLists, uint32 commandListsCount) override;
+	uint64 GetCompletedFenceValue() override;
+	void WaitForFence(uint64 fenceValue) override;
+
+	inline const RHINullStats& GetStats() const { return m_stats; }
+	inline void ResetStats() { m_stats = {}; }
+
+	static inline NullRHIBuffer* ToBuffer(RHIBuffer* buffer) { return reinterpret_cast<NullRHIBuffer*>(buffer); }
+	static inline NullRHITexture* ToTexture(RHITexture* texture) { return reinterpret_cast<NullRHITexture*>(texture); }
+	static inline NullRHIPipeline* ToPipeline(RHIPipeline* pipeline) { return reinterpret_cast<NullRHIPipeline*>(pipeline); }
+
+protected:
+	// Called by Submit for each list in order. The null device only counts.
+	virtual void Execute(const uint8* commands, uint64 size);
+
+private:
+	RHINullStats m_stats;
+	uint64 m_fenceValue = 0;
+	uint32 m_texturesCount = 0;
+};
@@ -0,0 +1,1271 @@
+#include "RHISoftware.h"
+#include "Platform.h"
+
+#include <math.h>
+#include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+	#define SOFTWARE_RHI_SSE2
+	#include <emmintrin.h>
+#endif
+
+/*
+==============
+Four-Wide Math
+==============
+*/
+
+// Pixels are shaded four at a time, one per lane. Without SSE2 the same code
+// runs on plain arrays. RoundToInt rounds to nearest, as the GPU converts to
+// UNORM; adding 0.5 and truncating would carry 1.0 past 2^24 - 1 in floats.
+#if defined(SOFTWARE_RHI_SSE2)
+typedef __m128 Float4;
+typedef __m128i Int4;
+
+static inline Float4 SetFloat4(float value) { return _mm_set1_ps(value); }
+static inline Float4 SetFloat4(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+static inline Float4 Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+static inline Float4 Sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+static inline Float4 Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+static inline Float4 Div(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+// With a NaN, Min and Max return b.
+static inline Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+static inline Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+static inline Float4 Saturate(Float4 a) { return _mm_min_ps(_mm_max_ps(a, _mm_setzero_ps()), _mm_set1_ps(1.0f)); }
+static inline Float4 ToFloat(Int4 a) { return _mm_cvtepi32_ps(a); }
+static inline Int4 CmpGreaterEqual(Float4 a, Float4 b) { return _mm_castps_si128(_mm_cmpge_ps(a, b)); }
+static inline Int4 RoundToInt(Float4 a) { return _mm_cvtps_epi32(a); }
+static inline Int4 TruncateToInt(Float4 a) { return _mm_cvttps_epi32(a); }
+
+static inline Int4 SetInt4(int32 value) { return _mm_set1_epi32(value); }
+static inline Int4 SetInt4(int32 x, int32 y, int32 z, int32 w) { return _mm_setr_epi32(x, y, z, w); }
+static inline Int4 Add(Int4 a, Int4 b) { return _mm_add_epi32(a, b); }
+static inline Int4 Or(Int4 a, Int4 b) { return _mm_or_si128(a, b); }
+static inline Int4 And(Int4 a, Int4 b) { return _mm_and_si128(a, b); }
+static inline Int4 AndNot(Int4 a, Int4 b) { return _mm_andnot_si128(a, b); }
+static inline Int4 Select(Int4 mask, Int4 a, Int4 b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+static inline Int4 ShiftLeft(Int4 a, int32 bits) { return _mm_slli_epi32(a, bits); }
+static inline Int4 ShiftRight(Int4 a, int32 bits) { return _mm_srli_epi32(a, bits); }
+static inline Int4 SignMask(Int4 a) { return _mm_srai_epi32(a, 31); }
+static inline Int4 CmpLess(Int4 a, Int4 b) { return _mm_cmplt_epi32(a, b); }
+static inline Int4 CmpGreater(Int4 a, Int4 b) { return _mm_cmpgt_epi32(a, b); }
+static inline Int4 Load(const uint32* in) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(in)); }
+static inline void Store(uint32* out, Int4 a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(out), a); }
+static inline void Store(int32* out, Int4 a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(out), a); }
+static inline uint32 GetLaneMask(Int4 mask) { return static_cast<uint32>(_mm_movemask_ps(_mm_castsi128_ps(mask))); }
+#else
+struct Float4 { float v[4]; };
+struct Int4 { int32 v[4]; };
+
+static inline Float4 SetFloat4(float value) { return { { value, value, value, value } }; }
+static inline Float4 SetFloat4(float x, float y, float z, float w) { return { { x, y, z, w } }; }
+static inline Float4 Add(Float4 a, Float4 b) { for (uint32 i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+static inline Float4 Sub(Float4 a, Float4 b) { for (uint32 i = 0; i < 4; i++) a.v[i] -= b.v[i]; return a; }
+static inline Float4 Mul(Float4 a, Float4 b) { for (uint32 i = 0; i < 4; i++) a.v[i] *= b.v[i]; return a; }
+static inline Float4 Div(Float4 a, Float4 b) { for (uint32 i = 0; i < 4; i++) a.v[i] /= b.v[i]; return a; }
+static inline Float4 Min(Float4 a, Float4 b) { for (uint32 i = 0; i < 4; i++) a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return a; }
+static inline Float4 Max(Float4 a, Float4 b) { for (uint32 i = 0; i < 4; i++) a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return a; }
+static inline Float4 Saturate(Float4 a) { for (uint32 i = 0; i < 4; i++) a.v[i] = a.v[i] > 0.0f ? (a.v[i] < 1.0f ? a.v[i] : 1.0f) : 0.0f; return a; }
+static inline Float4 ToFloat(Int4 a) { Float4 r; for (uint32 i = 0; i < 4; i++) r.v[i] = static_cast<float>(a.v[i]); return r; }
+static inline Int4 CmpGreaterEqual(Float4 a, Float4 b) { Int4 r; for (uint32 i = 0; i < 4; i++) r.v[i] = a.v[i] >= b.v[i] ? -1 : 0; return r; }
+static inline Int4 RoundToInt(Float4 a) { Int4 r; for (uint32 i = 0; i < 4; i++) r.v[i] = static_cast<int32>(lrintf(a.v[i])); return r; }
+static inline Int4 TruncateToInt(Float4 a) { Int4 r; for (uint32 i = 0; i < 4; i++) r.v[i] = static_cast<int32>(a.v[i]); return r; }
+
+static inline Int4 SetInt4(int32 value) { return { { value, value, value, value } }; }
+static inline Int4 SetInt4(int32 x, int32 y, int32 z, int32 w) { return { { x, y, z, w } }; }
+static inline Int4 Add(Int4 a, Int4 b) { for (uint32 i = 0; i < 4; i++) a.v[i] = static_cast<int32>(static_cast<uint32>(a.v[i]) + static_cast<uint32>(b.v[i])); return a; }
+static inline Int4 Or(Int4 a, Int4 b) { for (uint32 i = 0; i < 4; i++) a.v[i] |= b.v[i]; return a; }
+static inline Int4 And(Int4 a, Int4 b) { for (uint32 i = 0; i < 4; i++) a.v[i] &= b.v[i]; return a; }
+static inline Int4 AndNot(Int4 a, Int4 b) { for (uint32 i = 0; i < 4; i++) a.v[i] = ~a.v[i] & b.v[i]; return a; }
+static inline Int4 Select(Int4 mask, Int4 a, Int4 b) { return Or(And(mask, a), AndNot(mask, b)); }
+static inline Int4 ShiftLeft(Int4 a, int32 bits) { for (uint32 i = 0; i < 4; i++) a.v[i] = static_cast<int32>(static_cast<uint32>(a.v[i]) << bits); return a; }
+static inline Int4 ShiftRight(Int4 a, int32 bits) { for (uint32 i = 0; i < 4; i++) a.v[i] = static_cast<int32>(static_cast<uint32>(a.v[i]) >> bits); return a; }
+static inline Int4 SignMask(Int4 a) { for (uint32 i = 0; i < 4; i++) a.v[i] = a.v[i] < 0 ? -1 : 0; return a; }
+static inline Int4 CmpLess(Int4 a, Int4 b) { for (uint32 i = 0; i < 4; i++) a.v[i] = a.v[i] < b.v[i] ? -1 : 0; return a; }
+static inline Int4 CmpGreater(Int4 a, Int4 b) { for (uint32 i = 0; i < 4; i++) a.v[i] = a.v[i] > b.v[i] ? -1 : 0; return a; }
+static inline Int4 Load(const uint32* in) { Int4 r; ::memcpy(r.v, in, sizeof(r.v)); return r; }
+static inline void Store(uint32* out, Int4 a) { ::memcpy(out, a.v, sizeof(a.v)); }
+static inline void Store(int32* out, Int4 a) { ::memcpy(out, a.v, sizeof(a.v)); }
+static inline uint32 GetLaneMask(Int4 mask) { uint32 bits = 0; for (uint32 i = 0; i < 4; i++) bits |= mask.v[i] < 0 ? 1u << i : 0u; return bits; }
+#endif
+
+/*
+==================
+Software Pipeline
+==================
+*/
+
+static const uint32 TILE_SIZE_LOG2 = 6;
+static const uint32 TILE_SIZE = 1 << TILE_SIZE_LOG2;
+static const uint32 MAX_TARGET_SIZE = 4096;
+static const uint32 VERTICES_PER_JOB = 1024;
+static const uint32 TRIANGLES_PER_JOB = 1024;
+
+// Four bits of subpixel precision and a guard band of 2048 pixels keep vertex
+// positions under 2^17, so edge functions stepped across one tile fit in 32 bits.
+static const int32 SUBPIXEL_BITS = 4;
+static const int32 SUBPIXEL_ONE = 1 << SUBPIXEL_BITS;
+static const float GUARD_BAND_PIXELS = 2048.0f;
+
+static const uint32 DEPTH_MASK = 0x00ffffff;
+static const uint32 STENCIL_MASK = 0xff000000;
+static const float DEPTH_SCALE = 16777215.0f;
+
+// Matches Vertex and the input layout of the D3D12 pipelines.
+static const uint32 VERTEX_COLOR_OFFSET = 12;
+static const uint32 VERTEX_TEXCOORD_OFFSET = 28;
+
+// Interpolated across each triangle as planes in screen space. Everything
+// after INV_W is divided by w, for perspective correction.
+enum ATTRIBUTE
+{
+	ATTRIBUTE_DEPTH,
+	ATTRIBUTE_INV_W,
+	ATTRIBUTE_RED,
+	ATTRIBUTE_GREEN,
+	ATTRIBUTE_BLUE,
+	ATTRIBUTE_ALPHA,
+	ATTRIBUTE_U,
+	ATTRIBUTE_V,
+	ATTRIBUTES_COUNT,
+};
+
+enum CLIP_PLANE
+{
+	CLIP_PLANE_NEAR,
+	CLIP_PLANE_FAR,
+	CLIP_PLANE_LEFT,
+	CLIP_PLANE_RIGHT,
+	CLIP_PLANE_BOTTOM,
+	CLIP_PLANE_TOP,
+	CLIP_PLANES_COUNT,
+};
+
+// Clipping a triangle by every plane adds at most one vertex per plane.
+static const uint32 MAX_CLIPPED_VERTICES = 3 + CLIP_PLANES_COUNT;
+
+struct ClipVertex
+{
+	float position[4];		// Clip space.
+	float color[4];
+	float texCoord[2];
+};
+
+struct SetupTriangle
+{
+	int32 x[3];				// Fixed point, SUBPIXEL_BITS.
+	int32 y[3];
+	int32 bias[3];			// -1 for edges the top-left rule leaves out.
+	int32 minX;				// Pixel bounds, inclusive and inside the viewport.
+	int32 minY;
+	int32 maxX;
+	int32 maxY;
+	float originX;			// Vertex 0 in pixels; planes are relative to it.
+	float originY;
+	float planes[ATTRIBUTES_COUNT][3];	// Value at the origin, then per pixel in x and y.
+	uint32 drawIndex;
+};
+
+struct SoftwareDraw
+{
+	const NullRHIBuffer* vertexBuffer = nullptr;
+	const NullRHIBuffer* indexBuffer = nullptr;
+	uint32 indexCount = 0;
+	uint32 startIndex = 0;
+	int32 baseVertex = 0;
+	float worldViewProj[16] = {};	// Row vectors, as VSMain multiplies.
+
+	uint32 features = 0;
+	bool depthTest = true;
+	float baseColor[4] = {};
+	float alphaCutoff = 0.0f;
+	const NullRHITexture* albedoTexture = nullptr;
+
+	// Vertices the indices reach, transformed once per flush. verticesCount
+	// is 0 for draws that index outside the vertex buffer.
+	uint32 firstVertex = 0;
+	uint32 verticesCount = 0;
+	uint32 firstClipVertex = 0;
+};
+
+struct VertexJob
+{
+	uint32 drawIndex = 0;
+	uint32 firstVertex = 0;		// Relative to the draw's.
+	uint32 verticesCount = 0;
+};
+
+// Triangles are set up and binned by job, and each tile walks the jobs in
+// order, so tiles see triangles in draw order on any thread count.
+struct TriangleJob
+{
+	uint32 drawIndex = 0;
+	uint32 firstTriangle = 0;
+	uint32 trianglesCount = 0;
+
+	std::vector<SetupTriangle> triangles;
+	std::vector<uint32> binTiles;			// Tile of every binned triangle, in setup order.
+	std::vector<uint32> binTriangles;
+	std::vector<uint32> tileStarts;			// Into tileTriangles, tilesCount + 1 entries.
+	std::vector<uint32> tileTriangles;
+	std::vector<uint32> tileCursors;
+};
+
+typedef void (*SoftwareJobFunc)(void* context, uint32 job);
+
+struct SoftwareRHIDevice::Workers
+{
+	std::mutex lock;
+	std::condition_variable wake;
+	std::condition_variable done;
+	std::vector<std::thread> threads;
+	bool quit = false;
+
+	SoftwareJobFunc func = nullptr;
+	void* context = nullptr;
+	uint32 jobsCount = 0;
+	std::atomic<uint32> nextJob;
+	uint32 generation = 0;
+	uint32 busyCount = 0;
+
+	void RunJobs()
+	{
+		for (uint32 job = nextJob.fetch_add(1); job < jobsCount; job = nextJob.fetch_add(1))
+		{
+			func(context, job);
+		}
+	}
+
+	void WorkerLoop()
+	{
+		uint32 seenGeneration = 0;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				wake.wait(guard, [&]() { return quit || generation != seenGeneration; });
+				if (quit)
+					return;
+				seenGeneration = generation;
+			}
+
+			RunJobs();
+
+			std::lock_guard<std::mutex> guard(lock);
+			if (--busyCount == 0)
+				done.notify_one();
+		}
+	}
+
+	// Runs func for every job across the workers and the calling thread.
+	void Run(SoftwareJobFunc jobFunc, void* jobContext, uint32 count)
+	{
+		if (threads.empty() || count <= 1)
+		{
+			for (uint32 job = 0; job < count; job++)
+			{
+				jobFunc(jobContext, job);
+			}
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			func = jobFunc;
+			context = jobContext;
+			jobsCount = count;
+			nextJob = 0;
+			busyCount = static_cast<uint32>(threads.size());
+			generation++;
+		}
+		wake.notify_all();
+
+		RunJobs();
+
+		std::unique_lock<std::mutex> guard(lock);
+		done.wait(guard, [&]() { return busyCount == 0; });
+	}
+};
+
+struct SoftwareFrame
+{
+	// Current state of the list being executed.
+	NullRHITexture* colorTarget = nullptr;
+	NullRHITexture* depthTarget = nullptr;
+	uint32 viewportWidth = MAX_TARGET_SIZE;
+	uint32 viewportHeight = MAX_TARGET_SIZE;
+	const NullRHIPipeline* pipeline = nullptr;
+	const NullRHIBuffer* vertexBuffer = nullptr;
+	const NullRHIBuffer* indexBuffer = nullptr;
+	ObjectConstants objectConstants = {};
+	FrameConstants frameConstants = {};
+
+	// Draws since the last flush.
+	std::vector<SoftwareDraw> draws;
+	std::vector<ClipVertex> clipVertices;
+	std::vector<VertexJob> vertexJobs;
+	std::vector<TriangleJob> triangleJobs;
+	uint32 triangleJobsCount = 0;
+
+	// Set up for each flush.
+	uint32 width = 0;
+	uint32 height = 0;
+	uint32 tilesX = 0;
+	uint32 tilesCount = 0;
+	float guardBandX = 1.0f;
+	float guardBandY = 1.0f;
+
+	std::atomic<uint64> rasterizedTrianglesCount;
+	std::atomic<uint64> pixelsCount;
+};
+
+static void MultiplyMatrix(const float* a, const float* b, float* out)
+{
+	for (uint32 row = 0; row < 4; row++)
+	{
+		for (uint32 column = 0; column < 4; column++)
+		{
+			out[row * 4 + column] = a[row * 4 + 0] * b[0 * 4 + column] + a[row * 4 + 1] * b[1 * 4 + column] + a[row * 4 + 2] * b[2 * 4 + column] + a[row * 4 + 3] * b[3 * 4 + column];
+		}
+	}
+}
+
+// Constants hold matrices transposed for HLSL.
+static void LoadTransposed(const Matrix& matrix, float* out)
+{
+	float transposed[16];
+	::memcpy(transposed, &matrix, sizeof(transposed));
+	for (uint32 row = 0; row < 4; row++)
+	{
+		for (uint32 column = 0; column < 4; column++)
+		{
+			out[row * 4 + column] = transposed[column * 4 + row];
+		}
+	}
+}
+
+static uint32 PackColor(const float color[4])
+{
+	uint32 packed = 0;
+	for (uint32 i = 0; i < 4; i++)
+	{
+		float value = color[i] > 0.0f ? (color[i] < 1.0f ? color[i] : 1.0f) : 0.0f;
+		packed |= static_cast<uint32>(value * 255.0f + 0.5f) << (i * 8);
+	}
+	return packed;
+}
+
+static uint32 ReadIndex(const NullRHIBuffer* indexBuffer, uint32 index)
+{
+	if (indexBuffer->desc.stride == 2)
+	{
+		uint16 value = 0;
+		::memcpy(&value, indexBuffer->data + index * 2, sizeof(value));
+		return value;
+	}
+
+	uint32 value = 0;
+	::memcpy(&value, indexBuffer->data + static_cast<uint64>(index) * 4, sizeof(value));
+	return value;
+}
+
+// Bilinear with clamped addressing, as linearClamp in shaders.hlsl, for the
+// lanes in laneMask. Only the texel fetches are done lane by lane.
+static void SampleTexture(const NullRHITexture* texture, Float4 u, Float4 v, uint32 laneMask, Float4* outColor)
+{
+	if (!texture)
+	{
+		outColor[0] = outColor[1] = outColor[2] = outColor[3] = SetFloat4(0.0f);
+		return;
+	}
+
+	const Float4 zero = SetFloat4(0.0f);
+	const Float4 one = SetFloat4(1.0f);
+	Float4 width = SetFloat4(static_cast<float>(texture->desc.width));
+	Float4 height = SetFloat4(static_cast<float>(texture->desc.height));
+	Float4 maxX = SetFloat4(static_cast<float>(texture->desc.width - 1));
+	Float4 maxY = SetFloat4(static_cast<float>(texture->desc.height - 1));
+
+	// Clamped first, so NaNs and huge coordinates stay in range. Past -1 they
+	// floor by truncating.
+	Float4 tu = Min(Max(Sub(Mul(u, width), SetFloat4(0.5f)), SetFloat4(-1.0f)), width);
+	Float4 tv = Min(Max(Sub(Mul(v, height), SetFloat4(0.5f)), SetFloat4(-1.0f)), height);
+	Float4 floorU = Sub(ToFloat(TruncateToInt(Add(tu, one))), one);
+	Float4 floorV = Sub(ToFloat(TruncateToInt(Add(tv, one))), one);
+	Float4 fracU = Sub(tu, floorU);
+	Float4 fracV = Sub(tv, floorV);
+
+	int32 x0[4];
+	int32 x1[4];
+	int32 y0[4];
+	int32 y1[4];
+	Store(x0, TruncateToInt(Min(Max(floorU, zero), maxX)));
+	Store(x1, TruncateToInt(Min(Max(Add(floorU, one), zero), maxX)));
+	Store(y0, TruncateToInt(Min(Max(floorV, zero), maxY)));
+	Store(y1, TruncateToInt(Min(Max(Add(floorV, one), zero), maxY)));
+
+	uint32 texels[4][4] = {};
+	for (uint32 lane = 0; lane < 4; lane++)
+	{
+		if (!(laneMask & (1 << lane)))
+			continue;
+
+		const uint8* row0 = texture->data + static_cast<uint64>(y0[lane]) * texture->rowPitch;
+		const uint8* row1 = texture->data + static_cast<uint64>(y1[lane]) * texture->rowPitch;
+		::memcpy(&texels[0][lane], row0 + x0[lane] * 4, sizeof(uint32));
+		::memcpy(&texels[1][lane], row0 + x1[lane] * 4, sizeof(uint32));
+		::memcpy(&texels[2][lane], row1 + x0[lane] * 4, sizeof(uint32));
+		::memcpy(&texels[3][lane], row1 + x1[lane] * 4, sizeof(uint32));
+	}
+
+	Int4 topLeft = Load(texels[0]);
+	Int4 topRight = Load(texels[1]);
+	Int4 bottomLeft = Load(texels[2]);
+	Int4 bottomRight = Load(texels[3]);
+	const Int4 channelMask = SetInt4(0xff);
+	for (uint32 c = 0; c < 4; c++)
+	{
+		Float4 c00 = ToFloat(And(ShiftRight(topLeft, c * 8), channelMask));
+		Float4 c10 = ToFloat(And(ShiftRight(topRight, c * 8), channelMask));
+		Float4 c01 = ToFloat(And(ShiftRight(bottomLeft, c * 8), channelMask));
+		Float4 c11 = ToFloat(And(ShiftRight(bottomRight, c * 8), channelMask));
+		Float4 top = Add(c00, Mul(Sub(c10, c00), fracU));
+		Float4 bottom = Add(c01, Mul(Sub(c11, c01), fracU));
+		outColor[c] = Mul(Add(top, Mul(Sub(bottom, top), fracV)), SetFloat4(1.0f / 255.0f));
+	}
+}
+
+static inline float GetClipDistance(const ClipVertex& vertex, uint32 plane, float guardBandX, float guardBandY)
+{
+	const float* p = vertex.position;
+	switch (plane)
+	{
+	case CLIP_PLANE_NEAR:
+		return p[2];
+	case CLIP_PLANE_FAR:
+		return p[3] - p[2];
+	case CLIP_PLANE_LEFT:
+		return p[0] + guardBandX * p[3];
+	case CLIP_PLANE_RIGHT:
+		return guardBandX * p[3] - p[0];
+	case CLIP_PLANE_BOTTOM:
+		return p[1] + guardBandY * p[3];
+	default:
+		return guardBandY * p[3] - p[1];
+	}
+}
+
+static uint32 GetClipCode(const ClipVertex& vertex, float guardBandX, float guardBandY)
+{
+	uint32 code = 0;
+	for (uint32 plane = 0; plane < CLIP_PLANES_COUNT; plane++)
+	{
+		if (GetClipDistance(vertex, plane, guardBandX, guardBandY) < 0.0f)
+			code |= 1 << plane;
+	}
+	return code;
+}
+
+static void LerpVertex(const ClipVertex& a, const ClipVertex& b, float t, ClipVertex* out)
+{
+	const float* from = a.position;
+	const float* to = b.position;
+	float* result = out->position;
+	// ClipVertex is only floats.
+	for (uint32 i = 0; i < sizeof(ClipVertex) / sizeof(float); i++)
+	{
+		result[i] = from[i] + (to[i] - from[i]) * t;
+	}
+}
+
+// Sutherland-Hodgman against the planes in clipCode. Returns the vertex count.
+static uint32 ClipPolygon(ClipVertex* vertices, uint32 verticesCount, uint32 clipCode, float guardBandX, float guardBandY)
+{
+	ClipVertex scratch[MAX_CLIPPED_VERTICES];
+	ClipVertex* input = vertices;
+	ClipVertex* output = scratch;
+
+	for (uint32 plane = 0; plane < CLIP_PLANES_COUNT && verticesCount >= 3; plane++)
+	{
+		if (!(clipCode & (1 << plane)))
+			continue;
+
+		uint32 outputCount = 0;
+		for (uint32 i = 0; i < verticesCount; i++)
+		{
+			const ClipVertex& current = input[i];
+			const ClipVertex& next = input[(i + 1) % verticesCount];
+			float currentDistance = GetClipDistance(current, plane, guardBandX, guardBandY);
+			float nextDistance = GetClipDistance(next, plane, guardBandX, guardBandY);
+
+			if (currentDistance >= 0.0f)
+				output[outputCount++] = current;
+			if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+				LerpVertex(current, next, currentDistance / (currentDistance - nextDistance), &output[outputCount++]);
+		}
+
+		ClipVertex* swap = input;
+		input = output;
+		output = swap;
+		verticesCount = outputCount;
+	}
+
+	if (input != vertices)
+		::memcpy(vertices, input, sizeof(ClipVertex) * verticesCount);
+	return verticesCount;
+}
+
+static void SetupAndBinTriangle(const SoftwareFrame* frame, const ClipVertex* v0, const ClipVertex* v1, const ClipVertex* v2, uint32 drawIndex, TriangleJob* job);
+
+/*
+===================
+SoftwareRHIDevice
+===================
+*/
+
+void SoftwareRHIDevice::Init(uint32 threadsCount)
+{
+	if (threadsCount == 0)
+		threadsCount = Platform::GetHardwareThreadsCount();
+
+	m_frame = new SoftwareFrame;
+	m_workers = new Workers;
+
+	// The calling thread works too.
+	for (uint32 i = 1; i < threadsCount; i++)
+	{
+		Workers* workers = m_workers;
+		m_workers->threads.emplace_back([workers]() { workers->WorkerLoop(); });
+	}
+}
+
+void SoftwareRHIDevice::Clean()
+{
+	if (m_workers)
+	{
+		{
+			std::lock_guard<std::mutex> guard(m_workers->lock);
+			m_workers->quit = true;
+		}
+		m_workers->wake.notify_all();
+
+		for (std::thread& thread : m_workers->threads)
+		{
+			thread.join();
+		}
+
+		delete m_workers;
+		m_workers = nullptr;
+	}
+
+	if (m_frame)
+	{
+		delete m_frame;
+		m_frame = nullptr;
+	}
+
+	if (m_textures)
+	{
+		delete[] m_textures;
+		m_textures = nullptr;
+	}
+	m_texturesCapacity = 0;
+
+	if (m_materials)
+	{
+		delete[] m_materials;
+		m_materials = nullptr;
+	}
+	m_materialsCount = 0;
+}
+
+RHITexture* SoftwareRHIDevice::CreateTexture(const RHITextureDesc& desc, const void* data, uint32 rowPitch)
+{
+	if (desc.width > MAX_TARGET_SIZE || desc.height > MAX_TARGET_SIZE)
+		return nullptr;
+
+	RHITexture* texture = NullRHIDevice::CreateTexture(desc, data, rowPitch);
+	if (!texture)
+		return nullptr;
+
+	uint32 index = GetTextureIndex(texture);
+	if (index >= m_texturesCapacity)
+	{
+		uint32 capacity = m_texturesCapacity ? m_texturesCapacity * 2 : 64;
+		while (index >= capacity)
+			capacity *= 2;
+
+		NullRHITexture** textures = new NullRHITexture*[capacity];
+		::memset(textures, 0, sizeof(NullRHITexture*) * capacity);
+		if (m_textures)
+		{
+			::memcpy(textures, m_textures, sizeof(NullRHITexture*) * m_texturesCapacity);
+			delete[] m_textures;
+		}
+		m_textures = textures;
+		m_texturesCapacity = capacity;
+	}
+
+	m_textures[index] = ToTexture(texture);
+	return texture;
+}
+
+void SoftwareRHIDevice::DestroyTexture(RHITexture* texture)
+{
+	uint32 index = GetTextureIndex(texture);
+	if (index < m_texturesCapacity)
+		m_textures[index] = nullptr;
+
+	NullRHIDevice::DestroyTexture(texture);
+}
+
+void SoftwareRHIDevice::SetMaterials(const MaterialConstants* materials, uint32 materialsCount)
+{
+	if (m_materials)
+	{
+		delete[] m_materials;
+		m_materials = nullptr;
+	}
+
+	m_materialsCount = materialsCount;
+	if (materialsCount)
+	{
+		m_materials = new MaterialConstants[materialsCount];
+		::memcpy(m_materials, materials, sizeof(MaterialConstants) * materialsCount);
+	}
+}
+
+void SoftwareRHIDevice::Execute(const uint8* commands, uint64 size)
+{
+	NullRHIDevice::Execute(commands, size);
+
+	SoftwareFrame& frame = *m_frame;
+	uint64 offset = 0;
+	while (offset < size)
+	{
+		const RHICommandHeader* header = reinterpret_cast<const RHICommandHeader*>(commands + offset);
+		offset += header->size;
+
+		switch (header->type)
+		{
+		case RHI_COMMAND_TEXTURE_BARRIER:
+			Flush();
+			break;
+		case RHI_COMMAND_SET_RENDER_TARGETS:
+		{
+			const RHICommandSetRenderTargets* command = reinterpret_cast<const RHICommandSetRenderTargets*>(header);
+			Flush();
+			frame.colorTarget = ToTexture(command->colorTarget);
+			frame.depthTarget = ToTexture(command->depthTarget);
+			break;
+		}
+		case RHI_COMMAND_CLEAR_RENDER_TARGET:
+		{
+			const RHICommandClearRenderTarget* command = reinterpret_cast<const RHICommandClearRenderTarget*>(header);
+			Flush();
+			Clear(ToTexture(command->texture), PackColor(command->color));
+			break;
+		}
+		case RHI_COMMAND_CLEAR_DEPTH:
+		{
+			const RHICommandClearDepth* command = reinterpret_cast<const RHICommandClearDepth*>(header);
+			float depth = command->depth > 0.0f ? (command->depth < 1.0f ? command->depth : 1.0f) : 0.0f;
+			Flush();
+			Clear(ToTexture(command->texture), static_cast<uint32>(static_cast<double>(depth) * DEPTH_SCALE + 0.5));
+			break;
+		}
+		case RHI_COMMAND_SET_VIEWPORT:
+		{
+			const RHICommandSetViewport* command = reinterpret_cast<const RHICommandSetViewport*>(header);
+			Flush();
+			frame.viewportWidth = command->width;
+			frame.viewportHeight = command->height;
+			break;
+		}
+		case RHI_COMMAND_SET_PIPELINE:
+			frame.pipeline = ToPipeline(reinterpret_cast<const RHICommandSetPipeline*>(header)->pipeline);
+			break;
+		case RHI_COMMAND_SET_CONSTANTS:
+		{
+			const RHICommandSetConstants* command = reinterpret_cast<const RHICommandSetConstants*>(header);
+			if (command->slot == RHI_CONSTANTS_SLOT_OBJECT)
+				::memcpy(static_cast<void*>(&frame.objectConstants), command + 1, command->dataSize < sizeof(ObjectConstants) ? command->dataSize : sizeof(ObjectConstants));
+			else if (command->slot == RHI_CONSTANTS_SLOT_FRAME)
+				::memcpy(static_cast<void*>(&frame.frameConstants), command + 1, command->dataSize < sizeof(FrameConstants) ? command->dataSize : sizeof(FrameConstants));
+			break;
+		}
+		case RHI_COMMAND_SET_VERTEX_BUFFER:
+			frame.vertexBuffer = ToBuffer(reinterpret_cast<const RHICommandSetBuffer*>(header)->buffer);
+			break;
+		case RHI_COMMAND_SET_INDEX_BUFFER:
+			frame.indexBuffer = ToBuffer(reinterpret_cast<const RHICommandSetBuffer*>(header)->buffer);
+			break;
+		case RHI_COMMAND_DRAW_INDEXED:
+		{
+			const RHICommandDrawIndexed* command = reinterpret_cast<const RHICommandDrawIndexed*>(header);
+			m_rasterizerStats.trianglesCount += command->indexCount / 3;
+
+			if (!frame.pipeline || !frame.vertexBuffer || !frame.indexBuffer || frame.vertexBuffer->desc.stride == 0)
+				break;
+
+			// Indices past the end of the buffer are dropped.
+			uint32 bufferIndicesCount = frame.indexBuffer->desc.size / (frame.indexBuffer->desc.stride == 2 ? 2 : 4);
+			if (command->startIndex >= bufferIndicesCount)
+				break;
+			uint32 indexCount = command->indexCount < bufferIndicesCount - command->startIndex ? command->indexCount : bufferIndicesCount - command->startIndex;
+			indexCount -= indexCount % 3;
+			if (indexCount == 0)
+				break;
+
+			SoftwareDraw draw;
+			draw.vertexBuffer = frame.vertexBuffer;
+			draw.indexBuffer = frame.indexBuffer;
+			draw.indexCount = indexCount;
+			draw.startIndex = command->startIndex;
+			draw.baseVertex = command->baseVertex;
+			draw.features = frame.pipeline->desc.features;
+			draw.depthTest = frame.pipeline->desc.depthTest;
+
+			float world[16];
+			float view[16];
+			float proj[16];
+			float worldView[16];
+			LoadTransposed(frame.objectConstants.world, world);
+			LoadTransposed(frame.frameConstants.view, view);
+			LoadTransposed(frame.frameConstants.proj, proj);
+			MultiplyMatrix(world, view, worldView);
+			MultiplyMatrix(worldView, proj, draw.worldViewProj);
+
+			draw.baseColor[0] = draw.baseColor[1] = draw.baseColor[2] = draw.baseColor[3] = 1.0f;
+			uint32 materialIndex = frame.objectConstants.materialIndex;
+			if (materialIndex < m_materialsCount)
+			{
+				const MaterialConstants& material = m_materials[materialIndex];
+				::memcpy(draw.baseColor, &material.baseColor, sizeof(draw.baseColor));
+				draw.alphaCutoff = material.alphaCutoff;
+				if (material.albedoTexture < m_texturesCapacity)
+					draw.albedoTexture = m_textures[material.albedoTexture];
+			}
+
+			frame.draws.push_back(draw);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	Flush();
+}
+
+void SoftwareRHIDevice::Clear(NullRHITexture* texture, uint32 value)
+{
+	if (!texture)
+		return;
+
+	// Clears keep the stencil bits of depth targets zero, as a full clear would.
+	uint32 pixelsCount = texture->rowPitch / 4 * texture->desc.height;
+	uint32* pixels = reinterpret_cast<uint32*>(texture->data);
+	for (uint32 i = 0; i < pixelsCount; i++)
+	{
+		pixels[i] = value;
+	}
+}
+
+/*
+============
+Flush Jobs
+============
+*/
+
+// Finds the vertex range each draw reaches.
+static void MeasureDraw(void* context, uint32 drawIndex)
+{
+	SoftwareFrame* frame = static_cast<SoftwareFrame*>(context);
+	SoftwareDraw& draw = frame->draws[drawIndex];
+
+	uint32 minIndex = 0xffffffff;
+	uint32 maxIndex = 0;
+	for (uint32 i = 0; i < draw.indexCount; i++)
+	{
+		uint32 index = ReadIndex(draw.indexBuffer, draw.startIndex + i);
+		minIndex = index < minIndex ? index : minIndex;
+		maxIndex = index > maxIndex ? index : maxIndex;
+	}
+
+	int64 firstVertex = static_cast<int64>(minIndex) + draw.baseVertex;
+	int64 lastVertex = static_cast<int64>(maxIndex) + draw.baseVertex;
+	int64 bufferVertices = draw.vertexBuffer->desc.size / draw.vertexBuffer->desc.stride;
+	if (firstVertex < 0 || lastVertex >= bufferVertices)
+	{
+		draw.verticesCount = 0;
+		return;
+	}
+
+	draw.firstVertex = static_cast<uint32>(firstVertex);
+	draw.verticesCount = static_cast<uint32>(lastVertex - firstVertex + 1);
+}
+
+// VSMain.
+static void TransformVertices(void* context, uint32 jobIndex)
+{
+	SoftwareFrame* frame = static_cast<SoftwareFrame*>(context);
+	const VertexJob& job = frame->vertexJobs[jobIndex];
+	const SoftwareDraw& draw = frame->draws[job.drawIndex];
+	const float* m = draw.worldViewProj;
+	uint32 stride = draw.vertexBuffer->desc.stride;
+
+	ClipVertex* outVertices = &frame->clipVertices[draw.firstClipVertex + job.firstVertex];
+	const uint8* vertex = draw.vertexBuffer->data + static_cast<uint64>(draw.firstVertex + job.firstVertex) * stride;
+	for (uint32 i = 0; i < job.verticesCount; i++, vertex += stride)
+	{
+		float position[3];
+		::memcpy(position, vertex, sizeof(position));
+
+		ClipVertex& out = outVertices[i];
+		for (uint32 column = 0; column < 4; column++)
+		{
+			out.position[column] = position[0] * m[column] + position[1] * m[4 + column] + position[2] * m[8 + column] + m[12 + column];
+		}
+
+		if (stride >= VERTEX_TEXCOORD_OFFSET + sizeof(out.texCoord))
+		{
+			::memcpy(out.color, vertex + VERTEX_COLOR_OFFSET, sizeof(out.color));
+			::memcpy(out.texCoord, vertex + VERTEX_TEXCOORD_OFFSET, sizeof(out.texCoord));
+		}
+		else
+		{
+			out.color[0] = out.color[1] = out.color[2] = out.color[3] = 1.0f;
+			out.texCoord[0] = out.texCoord[1] = 0.0f;
+		}
+	}
+}
+
+static void SetupTriangles(void* context, uint32 jobIndex)
+{
+	SoftwareFrame* frame = static_cast<SoftwareFrame*>(context);
+	TriangleJob& job = frame->triangleJobs[jobIndex];
+	const SoftwareDraw& draw = frame->draws[job.drawIndex];
+	const ClipVertex* drawVertices = &frame->clipVertices[draw.firstClipVertex];
+	int64 firstVertex = static_cast<int64>(draw.firstVertex) - draw.baseVertex;
+
+	job.triangles.clear();
+	job.binTiles.clear();
+	job.binTriangles.clear();
+
+	for (uint32 t = job.firstTriangle; t < job.firstTriangle + job.trianglesCount; t++)
+	{
+		ClipVertex vertices[MAX_CLIPPED_VERTICES];
+		uint32 clipCodes[3];
+		for (uint32 c = 0; c < 3; c++)
+		{
+			uint32 index = ReadIndex(draw.indexBuffer, draw.startIndex + t * 3 + c);
+			vertices[c] = drawVertices[index - firstVertex];
+			clipCodes[c] = GetClipCode(vertices[c], frame->guardBandX, frame->guardBandY);
+		}
+
+		if (clipCodes[0] & clipCodes[1] & clipCodes[2])
+			continue;
+
+		uint32 clipCode = clipCodes[0] | clipCodes[1] | clipCodes[2];
+		if (!clipCode)
+		{
+			SetupAndBinTriangle(frame, &vertices[0], &vertices[1], &vertices[2], job.drawIndex, &job);
+			continue;
+		}
+
+		uint32 verticesCount = ClipPolygon(vertices, 3, clipCode, frame->guardBandX, frame->guardBandY);
+		for (uint32 i = 2; i < verticesCount; i++)
+		{
+			SetupAndBinTriangle(frame, &vertices[0], &vertices[i - 1], &vertices[i], job.drawIndex, &job);
+		}
+	}
+
+	// Counting sort by tile keeps each tile's triangles in setup order.
+	job.tileStarts.assign(frame->tilesCount + 1, 0);
+	for (uint32 tile : job.binTiles)
+	{
+		job.tileStarts[tile + 1]++;
+	}
+	for (uint32 tile = 0; tile < frame->tilesCount; tile++)
+	{
+		job.tileStarts[tile + 1] += job.tileStarts[tile];
+	}
+
+	job.tileTriangles.resize(job.binTriangles.size());
+	job.tileCursors.assign(job.tileStarts.begin(), job.tileStarts.end() - 1);
+	for (size_t i = 0; i < job.binTiles.size(); i++)
+	{
+		job.tileTriangles[job.tileCursors[job.binTiles[i]]++] = job.binTriangles[i];
+	}
+
+	frame->rasterizedTrianglesCount += job.triangles.size();
+}
+
+static void SetupAndBinTriangle(const SoftwareFrame* frame, const ClipVertex* v0, const ClipVertex* v1, const ClipVertex* v2, uint32 drawIndex, TriangleJob* job)
+{
+	const ClipVertex* vertices[3] = { v0, v1, v2 };
+	float width = static_cast<float>(frame->width);
+	float height = static_cast<float>(frame->height);
+
+	SetupTriangle triangle;
+	float invW[3];
+	for (uint32 i = 0; i < 3; i++)
+	{
+		const float* position = vertices[i]->position;
+		invW[i] = 1.0f / position[3];
+		float screenX = (position[0] * invW[i] * 0.5f + 0.5f) * width;
+		float screenY = (0.5f - position[1] * invW[i] * 0.5f) * height;
+		triangle.x[i] = static_cast<int32>(floorf(screenX * SUBPIXEL_ONE + 0.5f));
+		triangle.y[i] = static_cast<int32>(floorf(screenY * SUBPIXEL_ONE + 0.5f));
+	}
+
+	// Clockwise is front facing with y down; back faces and slivers go.
+	int64 area = static_cast<int64>(triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - static_cast<int64>(triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+	if (area <= 0)
+		return;
+
+	// Pixels whose centers fall inside the bounds, clamped to the viewport.
+	int32 minFixedX = triangle.x[0] < triangle.x[1] ? (triangle.x[0] < triangle.x[2] ? triangle.x[0] : triangle.x[2]) : (triangle.x[1] < triangle.x[2] ? triangle.x[1] : triangle.x[2]);
+	int32 maxFixedX = triangle.x[0] > triangle.x[1] ? (triangle.x[0] > triangle.x[2] ? triangle.x[0] : triangle.x[2]) : (triangle.x[1] > triangle.x[2] ? triangle.x[1] : triangle.x[2]);
+	int32 minFixedY = triangle.y[0] < triangle.y[1] ? (triangle.y[0] < triangle.y[2] ? triangle.y[0] : triangle.y[2]) : (triangle.y[1] < triangle.y[2] ? triangle.y[1] : triangle.y[2]);
+	int32 maxFixedY = triangle.y[0] > triangle.y[1] ? (triangle.y[0] > triangle.y[2] ? triangle.y[0] : triangle.y[2]) : (triangle.y[1] > triangle.y[2] ? triangle.y[1] : triangle.y[2]);
+
+	int32 halfPixel = SUBPIXEL_ONE / 2;
+	triangle.minX = (minFixedX - halfPixel + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS;
+	triangle.minY = (minFixedY - halfPixel + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS;
+	triangle.maxX = (maxFixedX - halfPixel) >> SUBPIXEL_BITS;
+	triangle.maxY = (maxFixedY - halfPixel) >> SUBPIXEL_BITS;
+	triangle.minX = triangle.minX > 0 ? triangle.minX : 0;
+	triangle.minY = triangle.minY > 0 ? triangle.minY : 0;
+	triangle.maxX = triangle.maxX < static_cast<int32>(frame->width) - 1 ? triangle.maxX : static_cast<int32>(frame->width) - 1;
+	triangle.maxY = triangle.maxY < static_cast<int32>(frame->height) - 1 ? triangle.maxY : static_cast<int32>(frame->height) - 1;
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+		return;
+
+	// Edge k is opposite vertex k. Top edges are horizontal with the interior
+	// below; left edges go up. The rest leave out pixels exactly on them.
+	for (uint32 k = 0; k < 3; k++)
+	{
+		uint32 a = (k + 1) % 3;
+		uint32 b = (k + 2) % 3;
+		int32 dx = triangle.x[b] - triangle.x[a];
+		int32 dy = triangle.y[b] - triangle.y[a];
+		triangle.bias[k] = (dy < 0 || (dy == 0 && dx > 0)) ? 0 : -1;
+	}
+
+	float attributes[3][ATTRIBUTES_COUNT];
+	for (uint32 i = 0; i < 3; i++)
+	{
+		const ClipVertex& vertex = *vertices[i];
+		attributes[i][ATTRIBUTE_DEPTH] = vertex.position[2] * invW[i];
+		attributes[i][ATTRIBUTE_INV_W] = invW[i];
+		attributes[i][ATTRIBUTE_RED] = vertex.color[0] * invW[i];
+		attributes[i][ATTRIBUTE_GREEN] = vertex.color[1] * invW[i];
+		attributes[i][ATTRIBUTE_BLUE] = vertex.color[2] * invW[i];
+		attributes[i][ATTRIBUTE_ALPHA] = vertex.color[3] * invW[i];
+		attributes[i][ATTRIBUTE_U] = vertex.texCoord[0] * invW[i];
+		attributes[i][ATTRIBUTE_V] = vertex.texCoord[1] * invW[i];
+	}
+
+	// Attribute planes over the snapped positions, so they agree with coverage.
+	double originX = static_cast<double>(triangle.x[0]) / SUBPIXEL_ONE;
+	double originY = static_cast<double>(triangle.y[0]) / SUBPIXEL_ONE;
+	double d1x = static_cast<double>(triangle.x[1] - triangle.x[0]) / SUBPIXEL_ONE;
+	double d1y = static_cast<double>(triangle.y[1] - triangle.y[0]) / SUBPIXEL_ONE;
+	double d2x = static_cast<double>(triangle.x[2] - triangle.x[0]) / SUBPIXEL_ONE;
+	double d2y = static_cast<double>(triangle.y[2] - triangle.y[0]) / SUBPIXEL_ONE;
+	double invArea = 1.0 / (d1x * d2y - d2x * d1y);
+
+	triangle.originX = static_cast<float>(originX);
+	triangle.originY = static_cast<float>(originY);
+	for (uint32 i = 0; i < ATTRIBUTES_COUNT; i++)
+	{
+		double delta1 = static_cast<double>(attributes[1][i]) - attributes[0][i];
+		double delta2 = static_cast<double>(attributes[2][i]) - attributes[0][i];
+		triangle.planes[i][0] = attributes[0][i];
+		triangle.planes[i][1] = static_cast<float>((delta1 * d2y - delta2 * d1y) * invArea);
+		triangle.planes[i][2] = static_cast<float>((delta2 * d1x - delta1 * d2x) * invArea);
+	}
+	triangle.drawIndex = drawIndex;
+
+	uint32 triangleIndex = static_cast<uint32>(job->triangles.size());
+	job->triangles.push_back(triangle);
+
+	for (int32 tileY = triangle.minY >> TILE_SIZE_LOG2; tileY <= triangle.maxY >> TILE_SIZE_LOG2; tileY++)
+	{
+		for (int32 tileX = triangle.minX >> TILE_SIZE_LOG2; tileX <= triangle.maxX >> TILE_SIZE_LOG2; tileX++)
+		{
+			job->binTiles.push_back(tileY * frame->tilesX + tileX);
+			job->binTriangles.push_back(triangleIndex);
+		}
+	}
+}
+
+static inline Float4 EvaluatePlane(const float* plane, Float4 x, Float4 y)
+{
+	return Add(SetFloat4(plane[0]), Add(Mul(SetFloat4(plane[1]), x), Mul(SetFloat4(plane[2]), y)));
+}
+
+// Rasterizes one triangle over the pixels of a tile, four at a time: coverage
+// from integer edge functions, the D24 depth test, then PSMain.
+static uint64 RasterizeTriangle(const SoftwareFrame* frame, const SetupTriangle& triangle, int32 tileMinX, int32 tileMinY, int32 tileMaxX, int32 tileMaxY)
+{
+	int32 minX = triangle.minX > tileMinX ? triangle.minX : tileMinX;
+	int32 minY = triangle.minY > tileMinY ? triangle.minY : tileMinY;
+	int32 maxX = triangle.maxX < tileMaxX ? triangle.maxX : tileMaxX;
+	int32 maxY = triangle.maxY < tileMaxY ? triangle.maxY : tileMaxY;
+	if (minX > maxX || minY > maxY)
+		return 0;
+
+	// Edges that cover the whole rectangle are dropped; the others vary by
+	// less than 2^29 across it, so they are stepped in 32 bits.
+	int32 rowValues[3];
+	int32 stepsX[3];
+	int32 stepsY[3];
+	uint32 edgesCount = 0;
+	for (uint32 k = 0; k < 3; k++)
+	{
+		uint32 a = (k + 1) % 3;
+		uint32 b = (k + 2) % 3;
+		int64 edgeA = triangle.y[a] - triangle.y[b];
+		int64 edgeB = triangle.x[b] - triangle.x[a];
+
+		int64 value = edgeA * (minX * SUBPIXEL_ONE + SUBPIXEL_ONE / 2 - triangle.x[a]) + edgeB * (minY * SUBPIXEL_ONE + SUBPIXEL_ONE / 2 - triangle.y[a]) + triangle.bias[k];
+		int64 spanX = edgeA * SUBPIXEL_ONE * (maxX - minX);
+		int64 spanY = edgeB * SUBPIXEL_ONE * (maxY - minY);
+		int64 minValue = value + (spanX < 0 ? spanX : 0) + (spanY < 0 ? spanY : 0);
+		int64 maxValue = value + (spanX > 0 ? spanX : 0) + (spanY > 0 ? spanY : 0);
+		if (maxValue < 0)
+			return 0;
+		if (minValue >= 0)
+			continue;
+
+		rowValues[edgesCount] = static_cast<int32>(value);
+		stepsX[edgesCount] = static_cast<int32>(edgeA * SUBPIXEL_ONE);
+		stepsY[edgesCount] = static_cast<int32>(edgeB * SUBPIXEL_ONE);
+		edgesCount++;
+	}
+
+	const SoftwareDraw& draw = frame->draws[triangle.drawIndex];
+	NullRHITexture* colorTarget = frame->colorTarget;
+	NullRHITexture* depthTarget = draw.depthTest ? frame->depthTarget : nullptr;
+	bool vertexColor = (draw.features & MATERIAL_FEATURE_VERTEX_COLOR) != 0;
+	bool albedoTexture = (draw.features & MATERIAL_FEATURE_ALBEDO_TEXTURE) != 0;
+	bool alphaTest = (draw.features & MATERIAL_FEATURE_ALPHA_TEST) != 0;
+
+	Int4 laneSteps[3];
+	for (uint32 k = 0; k < edgesCount; k++)
+	{
+		laneSteps[k] = SetInt4(0, stepsX[k], stepsX[k] * 2, stepsX[k] * 3);
+	}
+
+	const Int4 laneOffsets = SetInt4(0, 1, 2, 3);
+	const Float4 laneOffsetsFloat = SetFloat4(0.0f, 1.0f, 2.0f, 3.0f);
+	const Int4 firstX = SetInt4(minX - 1);
+	const Int4 lastX = SetInt4(maxX + 1);
+
+	uint64 pixelsCount = 0;
+	int32 groupMinX = minX & ~3;
+	for (int32 y = minY; y <= maxY; y++)
+	{
+		uint32* colorRow = colorTarget ? reinterpret_cast<uint32*>(colorTarget->data + static_cast<uint64>(y) * colorTarget->rowPitch) : nullptr;
+		uint32* depthRow = depthTarget ? reinterpret_cast<uint32*>(depthTarget->data + static_cast<uint64>(y) * depthTarget->rowPitch) : nullptr;
+		Float4 pixelY = SetFloat4(static_cast<float>(y) + 0.5f - triangle.originY);
+
+		for (int32 x = groupMinX; x <= maxX; x += 4)
+		{
+			Int4 laneX = Add(SetInt4(x), laneOffsets);
+			Int4 mask = And(CmpGreater(laneX, firstX), CmpLess(laneX, lastX));
+			for (uint32 k = 0; k < edgesCount; k++)
+			{
+				Int4 values = Add(SetInt4(rowValues[k] + (x - minX) * stepsX[k]), laneSteps[k]);
+				mask = AndNot(SignMask(values), mask);
+			}
+
+			if (!GetLaneMask(mask))
+				continue;
+
+			Float4 pixelX = Add(SetFloat4(static_cast<float>(x) + 0.5f - triangle.originX), laneOffsetsFloat);
+
+			Int4 depth = RoundToInt(Mul(Saturate(EvaluatePlane(triangle.planes[ATTRIBUTE_DEPTH], pixelX, pixelY)), SetFloat4(DEPTH_SCALE)));
+			Int4 oldDepthStencil = SetInt4(0);
+			if (depthRow)
+			{
+				oldDepthStencil = Load(depthRow + x);
+				mask = And(mask, CmpLess(depth, And(oldDepthStencil, SetInt4(DEPTH_MASK))));
+				if (!GetLaneMask(mask))
+					continue;
+			}
+
+			// PSMain.
+			Float4 red = SetFloat4(draw.baseColor[0]);
+			Float4 green = SetFloat4(draw.baseColor[1]);
+			Float4 blue = SetFloat4(draw.baseColor[2]);
+			Float4 alpha = SetFloat4(draw.baseColor[3]);
+			if (vertexColor || albedoTexture)
+			{
+				Float4 w = Div(SetFloat4(1.0f), EvaluatePlane(triangle.planes[ATTRIBUTE_INV_W], pixelX, pixelY));
+				if (albedoTexture)
+				{
+					Float4 u = Mul(EvaluatePlane(triangle.planes[ATTRIBUTE_U], pixelX, pixelY), w);
+					Float4 v = Mul(EvaluatePlane(triangle.planes[ATTRIBUTE_V], pixelX, pixelY), w);
+					Float4 texel[4];
+					SampleTexture(draw.albedoTexture, u, v, GetLaneMask(mask), texel);
+					red = Mul(red, texel[0]);
+					green = Mul(green, texel[1]);
+					blue = Mul(blue, texel[2]);
+					alpha = Mul(alpha, texel[3]);
+				}
+				if (vertexColor)
+				{
+					red = Mul(red, Mul(EvaluatePlane(triangle.planes[ATTRIBUTE_RED], pixelX, pixelY), w));
+					green = Mul(green, Mul(EvaluatePlane(triangle.planes[ATTRIBUTE_GREEN], pixelX, pixelY), w));
+					blue = Mul(blue, Mul(EvaluatePlane(triangle.planes[ATTRIBUTE_BLUE], pixelX, pixelY), w));
+					alpha = Mul(alpha, Mul(EvaluatePlane(triangle.planes[ATTRIBUTE_ALPHA], pixelX, pixelY), w));
+				}
+			}
+			if (alphaTest)
+			{
+				mask = And(mask, CmpGreaterEqual(alpha, SetFloat4(draw.alphaCutoff)));
+				if (!GetLaneMask(mask))
+					continue;
+			}
+
+			const Float4 scale = SetFloat4(255.0f);
+			if (colorRow)
+			{
+				Int4 packed = RoundToInt(Mul(Saturate(red), scale));
+				packed = Or(packed, ShiftLeft(RoundToInt(Mul(Saturate(green), scale)), 8));
+				packed = Or(packed, ShiftLeft(RoundToInt(Mul(Saturate(blue), scale)), 16));
+				packed = Or(packed, ShiftLeft(RoundToInt(Mul(Saturate(alpha), scale)), 24));
+				Store(colorRow + x, Select(mask, packed, Load(colorRow + x)));
+			}
+			if (depthRow)
+			{
+				Int4 depthStencil = Or(depth, And(oldDepthStencil, SetInt4(static_cast<int32>(STENCIL_MASK))));
+				Store(depthRow + x, Select(mask, depthStencil, oldDepthStencil));
+			}
+
+			uint32 laneMask = GetLaneMask(mask);
+			pixelsCount += (laneMask & 1) + ((laneMask >> 1) & 1) + ((laneMask >> 2) & 1) + (laneMask >> 3);
+		}
+
+		for (uint32 k = 0; k < edgesCount; k++)
+		{
+			rowValues[k] += stepsY[k];
+		}
+	}
+
+	return pixelsCount;
+}
+
+static void RasterizeTile(void* context, uint32 tile)
+{
+	SoftwareFrame* frame = static_cast<SoftwareFrame*>(context);
+	int32 minX = static_cast<int32>((tile % frame->tilesX) << TILE_SIZE_LOG2);
+	int32 minY = static_cast<int32>((tile / frame->tilesX) << TILE_SIZE_LOG2);
+	int32 maxX = minX + static_cast<int32>(TILE_SIZE) - 1;
+	int32 maxY = minY + static_cast<int32>(TILE_SIZE) - 1;
+
+	uint64 pixelsCount = 0;
+	for (uint32 jobIndex = 0; jobIndex < frame->triangleJobsCount; jobIndex++)
+	{
+		const TriangleJob& job = frame->triangleJobs[jobIndex];
+		for (uint32 i = job.tileStarts[tile]; i < job.tileStarts[tile + 1]; i++)
+		{
+			pixelsCount += RasterizeTriangle(frame, job.triangles[job.tileTriangles[i]], minX, minY, maxX, maxY);
+		}
+	}
+
+	frame->pixelsCount += pixelsCount;
+}
+
+void SoftwareRHIDevice::Flush()
+{
+	SoftwareFrame& frame = *m_frame;
+	if (frame.draws.empty())
+		return;
+
+	// Draws without targets have nothing to write.
+	NullRHITexture* target = frame.colorTarget ? frame.colorTarget : frame.depthTarget;
+	if (!target)
+	{
+		frame.draws.clear();
+		return;
+	}
+
+	frame.width = frame.viewportWidth < target->desc.width ? frame.viewportWidth : target->desc.width;
+	frame.height = frame.viewportHeight < target->desc.height ? frame.viewportHeight : target->desc.height;
+	if (frame.depthTarget)
+	{
+		frame.width = frame.width < frame.depthTarget->desc.width ? frame.width : frame.depthTarget->desc.width;
+		frame.height = frame.height < frame.depthTarget->desc.height ? frame.height : frame.depthTarget->desc.height;
+	}
+	if (frame.width == 0 || frame.height == 0)
+	{
+		frame.draws.clear();
+		return;
+	}
+
+	frame.tilesX = (frame.width + TILE_SIZE - 1) >> TILE_SIZE_LOG2;
+	frame.tilesCount = frame.tilesX * ((frame.height + TILE_SIZE - 1) >> TILE_SIZE_LOG2);
+	frame.guardBandX = 1.0f + 2.0f * GUARD_BAND_PIXELS / static_cast<float>(frame.width);
+	frame.guardBandY = 1.0f + 2.0f * GUARD_BAND_PIXELS / static_cast<float>(frame.height);
+	frame.rasterizedTrianglesCount = 0;
+	frame.pixelsCount = 0;
+
+	uint32 drawsCount = static_cast<uint32>(frame.draws.size());
+	m_workers->Run(MeasureDraw, &frame, drawsCount);
+
+	// Lay out the transformed vertices and cut the work into jobs.
+	uint32 clipVerticesCount = 0;
+	frame.vertexJobs.clear();
+	frame.triangleJobsCount = 0;
+	for (uint32 drawIndex = 0; drawIndex < drawsCount; drawIndex++)
+	{
+		SoftwareDraw& draw = frame.draws[drawIndex];
+		if (draw.verticesCount == 0)
+			continue;
+
+		draw.firstClipVertex = clipVerticesCount;
+		clipVerticesCount += draw.verticesCount;
+
+		for (uint32 first = 0; first < draw.verticesCount; first += VERTICES_PER_JOB)
+		{
+			VertexJob job;
+			job.drawIndex = drawIndex;
+			job.firstVertex = first;
+			job.verticesCount = draw.verticesCount - first < VERTICES_PER_JOB ? draw.verticesCount - first : VERTICES_PER_JOB;
+			frame.vertexJobs.push_back(job);
+		}
+
+		uint32 trianglesCount = draw.indexCount / 3;
+		for (uint32 first = 0; first < trianglesCount; first += TRIANGLES_PER_JOB)
+		{
+			if (frame.triangleJobsCount == frame.triangleJobs.size())
+				frame.triangleJobs.emplace_back();
+
+			TriangleJob& job = frame.triangleJobs[frame.triangleJobsCount++];
+			job.drawIndex = drawIndex;
+			job.firstTriangle = first;
+			job.trianglesCount = trianglesCount - first < TRIANGLES_PER_JOB ? trianglesCount - first : TRIANGLES_PER_JOB;
+		}
+	}
+
+	if (frame.clipVertices.size() < clipVerticesCount)
+		frame.clipVertices.resize(clipVerticesCount);
+
+	m_workers->Run(TransformVertices, &frame, static_cast<uint32>(frame.vertexJobs.size()));
+	m_workers->Run(SetupTriangles, &frame, frame.triangleJobsCount);
+	m_workers->Run(RasterizeTile, &frame, frame.tilesCount);
+
+	m_rasterizerStats.rasterizedTrianglesCount += frame.rasterizedTrianglesCount;
+	m_rasterizerStats.pixelsCount += frame.pixelsCount;
+	frame.draws.clear();
+}
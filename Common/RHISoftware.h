@@ -0,0 +1,75 @@
+#pragma once
+
+#include "RHINull.h"
+#include "ShaderConstants.h"
+
+struct SoftwareFrame;
+
+struct SoftwareRasterizerStats
+{
+	uint64 trianglesCount = 0;			// Drawn, before culling.
+	uint64 rasterizedTrianglesCount = 0;	// After clipping and back-face culling.
+	uint64 pixelsCount = 0;				// Written to the targets.
+};
+
+/*
+===================
+SoftwareRHIDevice
+===================
+*/
+
+// Renders on the CPU what the D3D12 backend renders on the GPU: the VSMain
+// transform, the PSMain material with its bilinear clamped texture sample and
+// alpha test, and a LESS depth test on D24. Rendering should match the GPU to
+// within rounding, and is the same from run to run and on any thread count,
+// so images can be compared with golden ones.
+//
+// Draws are gathered until something reads or writes the targets directly,
+// such as a clear, a barrier or the end of a list. Vertices are then
+// transformed and triangles set up and binned into 64x64 tiles in parallel,
+// and the tiles are rasterized in parallel, four pixels at a time with SSE2.
+// Each tile sees its triangles in draw order.
+//
+// Color targets are R8G8B8A8_UNORM and depth targets D24_UNORM_S8_UINT, with
+// targets of at most 4096x4096. Sampled textures are R8G8B8A8_UNORM.
+class SoftwareRHIDevice : public NullRHIDevice
+{
+public:
+	// threadsCount 0 uses every hardware thread.
+	void Init(uint32 threadsCount);
+	// Every texture must have been destroyed.
+	void Clean();
+
+	RHITexture* CreateTexture(const RHITextureDesc& desc, const void* data, uint32 rowPitch) override;
+	void DestroyTexture(RHITexture* texture) override;
+
+	// The materials PSMain reads, by ObjectConstants::materialIndex. They are
+	// copied; draws with an index past the end use a white material.
+	void SetMaterials(const MaterialConstants* materials, uint32 materialsCount);
+
+	inline const SoftwareRasterizerStats& GetRasterizerStats() const { return m_rasterizerStats; }
+	inline void ResetRasterizerStats() { m_rasterizerStats = {}; }
+
+protected:
+	void Execute(const uint8* commands, uint64 size) override;
+
+private:
+	// Threads and the per-flush work lists live in the .cpp so this header
+	// stays free of the standard library.
+	struct Workers;
+
+	Workers* m_workers = nullptr;
+	SoftwareFrame* m_frame = nullptr;
+
+	// Indexed by texture index.
+	NullRHITexture** m_textures = nullptr;
+	uint32 m_texturesCapacity = 0;
+
+	MaterialConstants* m_materials = nullptr;
+	uint32 m_materialsCount = 0;
+
+	SoftwareRasterizerStats m_rasterizerStats;
+
+	void Flush();
+	void Clear(NullRHITexture* texture, uint32 value);
+};
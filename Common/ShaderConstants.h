@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Vertex.h"
+#include "VirtualTexturePageTable.h"
+
+/*
+================
+Shader Constants
+================
+*/
+
+// Each feature is a define in shaders.hlsl. Pixels only pay for the features
+// their material has: every combination is compiled as its own permutation.
+enum MATERIAL_FEATURE
+{
+	MATERIAL_FEATURE_VERTEX_COLOR = 0x1,
+	MATERIAL_FEATURE_ALBEDO_TEXTURE = 0x2,
+	MATERIAL_FEATURE_ALPHA_TEST = 0x4,
+	MATERIAL_FEATURE_VIRTUAL_TEXTURE = 0x8,
+};
+
+const uint32 MATERIAL_FEATURES_COUNT = 4;
+const uint32 MATERIAL_PERMUTATIONS_COUNT = 1 << MATERIAL_FEATURES_COUNT;
+
+// Matches VirtualTextureConstants in VirtualTexture.hlsli.
+struct VirtualTextureConstants
+{
+	uint32 textureSize[2];
+	uint32 tileSize[2];
+	uint32 mip0Tiles[2];
+	uint32 standardMipsCount;
+	uint32 padding;
+	uint32 mipOffsets[VT_MAX_MIPS];	// First page table tile of each standard mip.
+};
+
+// Matches MaterialConstants in shaders.hlsl.
+struct MaterialConstants
+{
+	Vector4 baseColor;
+	float alphaCutoff;
+	uint32 albedoTexture;		// Texture index; see RHIDevice::GetTextureIndex.
+	uint32 virtualTexture;		// Bindless indices, used with MATERIAL_FEATURE_VIRTUAL_TEXTURE.
+	uint32 virtualResidencyMap;
+	uint32 virtualFeedback;		// Index into the UAV table.
+	float padding[3];
+	VirtualTextureConstants virtualTextureConstants;
+};
+
+// Bound through RHI_CONSTANTS_SLOT_OBJECT. Matches ObjectConstants in shaders.hlsl.
+struct ObjectConstants
+{
+	Matrix world;			// Transposed.
+	uint32 materialIndex;
+};
+
+// Bound through RHI_CONSTANTS_SLOT_FRAME. Matches FrameConstants in shaders.hlsl.
+struct FrameConstants
+{
+	Matrix view;			// Transposed.
+	Matrix proj;			// Transposed.
+	uint32 frameIndex = 0;	// Rotates the pixels that write virtual texture feedback.
+};
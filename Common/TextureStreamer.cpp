@@ -0,0 +1,305 @@
+#include "TextureStreamer.h"
+
+#include <math.h>
+#include <algorithm>
+
+/*
+==================
+TextureStreamer
+==================
+*/
+
+static bool CanBeTopMip(const StreamedTextureDesc& desc, uint32 mip)
+{
+	if (mip == 0 || !desc.blockCompressed)
+		return true;
+
+	uint32 width = desc.width >> mip;
+	uint32 height = desc.height >> mip;
+	return width && height && width % 4 == 0 && height % 4 == 0;
+}
+
+void TextureStreamer::Init(const TextureStreamerSettings& settings)
+{
+	m_settings = settings;
+	m_entries = new Entry[m_settings.maxTextures];
+	m_order = new uint32[m_settings.maxTextures];
+	m_freeHint = 0;
+	m_residentBytes = 0;
+}
+
+void TextureStreamer::Clean()
+{
+	if (m_entries)
+	{
+		delete[] m_entries;
+		m_entries = nullptr;
+	}
+
+	if (m_order)
+	{
+		delete[] m_order;
+		m_order = nullptr;
+	}
+
+	m_residentBytes = 0;
+}
+
+uint32 TextureStreamer::Register(const StreamedTextureDesc& desc)
+{
+	if (desc.mipLevels == 0 || desc.mipLevels > DDS_MAX_MIPS)
+		return TEXTURE_STREAMER_INVALID_ID;
+
+	for (uint32 n = 0; n < m_settings.maxTextures; n++)
+	{
+		uint32 id = (m_freeHint + n) % m_settings.maxTextures;
+		Entry& entry = m_entries[id];
+		if (entry.used)
+			continue;
+
+		uint32 topMipsMask = 0;
+		for (uint32 mip = 0; mip < desc.mipLevels; mip++)
+		{
+			if (CanBeTopMip(desc, mip))
+				topMipsMask |= 1u << mip;
+		}
+		if (topMipsMask == 1 && desc.mipLevels > 1)
+			return TEXTURE_STREAMER_INVALID_ID;
+
+		entry = {};
+		entry.desc = desc;
+		entry.used = true;
+		entry.topMipsMask = topMipsMask;
+
+		// The tail is the first top mip that fits in tailDimension, or the last one.
+		for (uint32 mip = 0; mip < desc.mipLevels; mip++)
+		{
+			if (!(topMipsMask & (1u << mip)))
+				continue;
+
+			entry.tailMip = mip;
+
+			uint32 width = desc.width >> mip ? desc.width >> mip : 1;
+			uint32 height = desc.height >> mip ? desc.height >> mip : 1;
+			if (width <= m_settings.tailDimension && height <= m_settings.tailDimension)
+				break;
+		}
+
+		entry.residentMip = desc.mipLevels;
+		SetResidentMip(entry, entry.tailMip);
+		entry.wantedMip = entry.tailMip;
+
+		m_freeHint = (id + 1) % m_settings.maxTextures;
+		return id;
+	}
+
+	return TEXTURE_STREAMER_INVALID_ID;
+}
+
+void TextureStreamer::Unregister(uint32 textureId)
+{
+	Entry& entry = m_entries[textureId];
+	SetResidentMip(entry, entry.desc.mipLevels);
+	entry = {};
+	m_freeHint = textureId;
+}
+
+void TextureStreamer::ReportScreenSize(uint32 textureId, float screenPixels)
+{
+	Entry& entry = m_entries[textureId];
+	entry.screenPixels = screenPixels > entry.screenPixels ? screenPixels : entry.screenPixels;
+}
+
+uint32 TextureStreamer::Update(TextureStreamRequest* outRequests, uint32 maxRequests)
+{
+	if (maxRequests > m_settings.maxRequestsPerFrame)
+		maxRequests = m_settings.maxRequestsPerFrame;
+
+	uint32 requestsCount = 0;
+	uint32 loadsCount = 0;
+
+	for (uint32 id = 0; id < m_settings.maxTextures; id++)
+	{
+		Entry& entry = m_entries[id];
+		if (!entry.used)
+			continue;
+
+		entry.wantedMip = CalcWantedMip(entry);
+
+		// How many screen pixels each resident texel covers; above one the texture looks blurry.
+		uint32 residentDimension = entry.desc.width > entry.desc.height ? entry.desc.width : entry.desc.height;
+		residentDimension >>= entry.residentMip;
+		entry.priority = entry.screenPixels / (residentDimension ? residentDimension : 1);
+		entry.screenPixels = 0.0f;
+
+		// Finer mips are requested right away, but a texture must want fewer
+		// mips for dropFrames in a row before losing them, so camera jitter
+		// around a mip boundary does not rebuild the texture every frame.
+		if (entry.wantedMip > entry.residentMip)
+			entry.coarserFrames++;
+		else
+			entry.coarserFrames = 0;
+
+		if (entry.pending)
+			continue;
+
+		if (entry.wantedMip < entry.residentMip)
+			m_order[loadsCount++] = id;
+	}
+
+	// Evictions first: they are cheap and free budget for the loads below.
+	for (uint32 id = 0; id < m_settings.maxTextures && requestsCount < maxRequests; id++)
+	{
+		Entry& entry = m_entries[id];
+		if (!entry.used || entry.pending || entry.coarserFrames < m_settings.dropFrames)
+			continue;
+
+		SetResidentMip(entry, entry.wantedMip);
+		entry.pending = true;
+		entry.coarserFrames = 0;
+		outRequests[requestsCount++] = { id, entry.wantedMip };
+	}
+
+	std::sort(m_order, m_order + loadsCount, [this](uint32 lhs, uint32 rhs)
+	{
+		if (m_entries[lhs].priority != m_entries[rhs].priority)
+			return m_entries[lhs].priority > m_entries[rhs].priority;
+		return lhs < rhs;
+	});
+
+	for (uint32 i = 0; i < loadsCount && requestsCount < maxRequests; i++)
+	{
+		uint32 id = m_order[i];
+		Entry& entry = m_entries[id];
+		if (entry.pending)
+			continue;
+
+		uint32 targetMip = entry.wantedMip;
+		uint64 residentBytes = CalcResidentBytes(entry, entry.residentMip);
+
+		// Make room by taking mips from less important textures.
+		while (m_residentBytes - residentBytes + CalcResidentBytes(entry, targetMip) > m_settings.budgetBytes && requestsCount + 1 < maxRequests)
+		{
+			uint32 victimId = FindVictim(id, entry.priority);
+			if (victimId == TEXTURE_STREAMER_INVALID_ID)
+				break;
+
+			Entry& victim = m_entries[victimId];
+			uint64 deficit = m_residentBytes - residentBytes + CalcResidentBytes(entry, targetMip) - m_settings.budgetBytes;
+			uint64 victimBytes = CalcResidentBytes(victim, victim.residentMip);
+
+			uint32 victimMip = victim.residentMip;
+			while (victimMip < victim.tailMip && victimBytes - CalcResidentBytes(victim, victimMip) < deficit)
+			{
+				victimMip = GetCoarserTopMip(victim, victimMip);
+			}
+
+			SetResidentMip(victim, victimMip);
+			victim.pending = true;
+			outRequests[requestsCount++] = { victimId, victimMip };
+		}
+
+		// Settle for a coarser mip than wanted if the budget is still short.
+		while (targetMip < entry.residentMip && m_residentBytes - residentBytes + CalcResidentBytes(entry, targetMip) > m_settings.budgetBytes)
+		{
+			targetMip = GetCoarserTopMip(entry, targetMip);
+		}
+
+		if (targetMip == entry.residentMip)
+			continue;
+
+		SetResidentMip(entry, targetMip);
+		entry.pending = true;
+		outRequests[requestsCount++] = { id, targetMip };
+	}
+
+	return requestsCount;
+}
+
+void TextureStreamer::CompleteRequest(uint32 textureId)
+{
+	m_entries[textureId].pending = false;
+}
+
+uint32 TextureStreamer::GetResidentMip(uint32 textureId) const
+{
+	return m_entries[textureId].residentMip;
+}
+
+uint32 TextureStreamer::GetTailMip(uint32 textureId) const
+{
+	return m_entries[textureId].tailMip;
+}
+
+uint64 TextureStreamer::CalcResidentBytes(const Entry& entry, uint32 mostDetailedMip) const
+{
+	uint64 bytes = 0;
+	for (uint32 mip = mostDetailedMip; mip < entry.desc.mipLevels; mip++)
+	{
+		bytes += entry.desc.mipSizes[mip];
+	}
+	return bytes;
+}
+
+uint32 TextureStreamer::CalcWantedMip(const Entry& entry) const
+{
+	// Textures that were not seen this frame only keep their tail.
+	if (entry.screenPixels <= 0.0f)
+		return entry.tailMip;
+
+	// Finest mip whose texels still cover at most one pixel each.
+	float dimension = static_cast<float>(entry.desc.width > entry.desc.height ? entry.desc.width : entry.desc.height);
+	float mip = floorf(log2f(dimension / entry.screenPixels));
+	if (mip <= 0.0f)
+		return 0;
+
+	uint32 wantedMip = static_cast<uint32>(mip);
+	if (wantedMip >= entry.tailMip)
+		return entry.tailMip;
+
+	// Rather a finer top mip than a blurrier one.
+	while (!(entry.topMipsMask & (1u << wantedMip)))
+	{
+		wantedMip--;
+	}
+	return wantedMip;
+}
+
+// The next top mip coarser than mip, but no coarser than the tail.
+uint32 TextureStreamer::GetCoarserTopMip(const Entry& entry, uint32 mip) const
+{
+	for (mip++; mip < entry.tailMip; mip++)
+	{
+		if (entry.topMipsMask & (1u << mip))
+			return mip;
+	}
+	return entry.tailMip;
+}
+
+void TextureStreamer::SetResidentMip(Entry& entry, uint32 mip)
+{
+	m_residentBytes -= CalcResidentBytes(entry, entry.residentMip);
+	m_residentBytes += CalcResidentBytes(entry, mip);
+	entry.residentMip = mip;
+}
+
+uint32 TextureStreamer::FindVictim(uint32 requesterId, float requesterPriority) const
+{
+	uint32 victimId = TEXTURE_STREAMER_INVALID_ID;
+	float victimPriority = requesterPriority;
+
+	for (uint32 id = 0; id < m_settings.maxTextures; id++)
+	{
+		const Entry& entry = m_entries[id];
+		if (!entry.used || entry.pending || id == requesterId || entry.residentMip >= entry.tailMip)
+			continue;
+
+		if (entry.priority < victimPriority)
+		{
+			victimPriority = entry.priority;
+			victimId = id;
+		}
+	}
+
+	return victimId;
+}
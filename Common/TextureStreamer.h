@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Types.h"
+#include "DDSFile.h"
+
+/*
+=================
+Texture Streamer
+=================
+*/
+
+const uint32 TEXTURE_STREAMER_INVALID_ID = 0xffffffff;
+
+struct TextureStreamerSettings
+{
+	uint64 budgetBytes = 256ull * 1024 * 1024;
+	uint32 maxTextures = 1024;
+	uint32 tailDimension = 64;			// Mips this size and smaller stay resident for the texture's lifetime.
+	uint32 dropFrames = 60;				// Frames a texture must want fewer mips before they are evicted.
+	uint32 maxRequestsPerFrame = 4;		// Resource rebuilds per Update, to bound per-frame upload cost.
+};
+
+struct StreamedTextureDesc
+{
+	uint32 width = 0;
+	uint32 height = 0;
+	uint32 mipLevels = 0;
+	uint64 mipSizes[DDS_MAX_MIPS] = {};	// Bytes per mip across all array slices.
+	// D3D12 only creates BC textures whose top mip is a multiple of 4 on both
+	// sides, so only such mips, and mip 0, are ever made the finest resident one.
+	bool blockCompressed = false;
+};
+
+// Rebuild the texture so that mostDetailedMip is its finest resident mip.
+struct TextureStreamRequest
+{
+	uint32 textureId = TEXTURE_STREAMER_INVALID_ID;
+	uint32 mostDetailedMip = 0;
+};
+
+/*
+==================
+TextureStreamer
+==================
+*/
+
+// Decides which mips each texture should have resident. It knows nothing
+// about the device: the renderer reports screen sizes, calls Update once a
+// frame and applies the requests it gets back.
+class TextureStreamer
+{
+public:
+	void Init(const TextureStreamerSettings& settings);
+	void Clean();
+
+	// Returns TEXTURE_STREAMER_INVALID_ID when full, or for a block-compressed
+	// texture with no mip but 0 that can be its top mip; keep those fully
+	// resident. The texture starts with only its tail resident.
+	uint32 Register(const StreamedTextureDesc& desc);
+	void Unregister(uint32 textureId);
+
+	// Largest on-screen size in pixels this frame; the finest mip needed follows from it.
+	void ReportScreenSize(uint32 textureId, float screenPixels);
+
+	// Returns the number of requests written. Finer mips are granted by
+	// priority (how magnified the texture currently is) within the budget,
+	// evicting mips from lower priority textures when needed.
+	uint32 Update(TextureStreamRequest* outRequests, uint32 maxRequests);
+
+	// Called once a request has been applied; the texture is considered again next Update.
+	void CompleteRequest(uint32 textureId);
+
+	uint32 GetResidentMip(uint32 textureId) const;
+	uint32 GetTailMip(uint32 textureId) const;
+
+	inline void SetBudget(uint64 budgetBytes) { m_settings.budgetBytes = budgetBytes; }
+	inline uint64 GetBudget() const { return m_settings.budgetBytes; }
+	inline uint64 GetResidentBytes() const { return m_residentBytes; }
+
+private:
+	struct Entry
+	{
+		StreamedTextureDesc desc = {};
+		uint32 residentMip = 0;
+		uint32 tailMip = 0;
+		uint32 wantedMip = 0;
+		uint32 topMipsMask = 0;			// Bit per mip that can be the finest resident one.
+		uint32 coarserFrames = 0;		// Consecutive frames the wanted mip was coarser than resident.
+		float screenPixels = 0.0f;
+		float priority = 0.0f;
+		bool used = false;
+		bool pending = false;
+	};
+
+	TextureStreamerSettings m_settings = {};
+	Entry* m_entries = nullptr;
+	uint32* m_order = nullptr;
+	uint32 m_freeHint = 0;
+	uint64 m_residentBytes = 0;
+
+	uint64 CalcResidentBytes(const Entry& entry, uint32 mostDetailedMip) const;
+	uint32 CalcWantedMip(const Entry& entry) const;
+	uint32 GetCoarserTopMip(const Entry& entry, uint32 mip) const;
+	void SetResidentMip(Entry& entry, uint32 mip);
+	uint32 FindVictim(uint32 requesterId, float requesterPriority) const;
+};
@@ -1,11 +1,15 @@
 #pragma once
 
+// The same types MSVC's __int16/__int32/__int64 name, spelled portably, so
+// format strings such as %llu stay correct on LP64 compilers too.
 using BYTE = unsigned char;
 using uint8 = unsigned char;
-using uint16 = unsigned __int16;
-using uint32 = unsigned __int32;
-using uint64 = unsigned __int64;
-using int16 = __int16;
-using int32 = __int32;
-using int64 = __int64;
+using uint16 = unsigned short;
+using uint32 = unsigned int;
+using uint64 = unsigned long long;
+using int8 = signed char;
+using int16 = short;
+using int32 = int;
+using int64 = long long;
 
+static_assert(sizeof(uint16) == 2 && sizeof(uint32) == 4 && sizeof(uint64) == 8, "Unexpected integer sizes.");
@@ -1,7 +1,13 @@
 #pragma once
 
-#include <directxtk/SimpleMath.h>
-#include <d3d12.h>
+#include "Types.h"
+
+#if defined(_WIN32)
+	#include <directxtk/SimpleMath.h>
+	#include <d3d12.h>
+#else
+	#include "PortableMath.h"
+#endif
 
 /*
 ======
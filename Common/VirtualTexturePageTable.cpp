@@ -0,0 +1,259 @@
+#include "VirtualTexturePageTable.h"
+
+#include <algorithm>
+
+/*
+=========================
+VirtualTexturePageTable
+=========================
+*/
+
+void VirtualTexturePageTable::Init(const VirtualTextureDesc& desc)
+{
+	m_desc = desc;
+
+	m_tilesCount = 0;
+	for (uint32 mip = 0; mip < m_desc.standardMipsCount; mip++)
+	{
+		m_mipOffsets[mip] = m_tilesCount;
+		m_tilesCount += m_desc.widthInTiles[mip] * m_desc.heightInTiles[mip];
+	}
+	m_mipOffsets[m_desc.standardMipsCount] = m_tilesCount;
+
+	m_tiles = new Tile[m_tilesCount];
+	m_requested = new uint32[m_tilesCount];
+	m_requestedCount = 0;
+
+	m_pages = new Page[m_desc.physicalPagesCount];
+	m_freePages = new uint32[m_desc.physicalPagesCount];
+	m_freePagesCount = m_desc.physicalPagesCount;
+	for (uint32 i = 0; i < m_freePagesCount; i++)
+	{
+		// Hand out low pages first.
+		m_freePages[i] = m_freePagesCount - 1 - i;
+	}
+
+	m_lruHead = VT_INVALID_INDEX;
+	m_lruTail = VT_INVALID_INDEX;
+	m_residentCount = 0;
+	m_frame = 1;
+}
+
+void VirtualTexturePageTable::Clean()
+{
+	if (m_tiles)
+	{
+		delete[] m_tiles;
+		m_tiles = nullptr;
+	}
+
+	if (m_requested)
+	{
+		delete[] m_requested;
+		m_requested = nullptr;
+	}
+
+	if (m_pages)
+	{
+		delete[] m_pages;
+		m_pages = nullptr;
+	}
+
+	if (m_freePages)
+	{
+		delete[] m_freePages;
+		m_freePages = nullptr;
+	}
+
+	m_tilesCount = 0;
+	m_freePagesCount = 0;
+	m_residentCount = 0;
+}
+
+uint32 VirtualTexturePageTable::GetTileIndex(uint32 mip, uint32 x, uint32 y) const
+{
+	return m_mipOffsets[mip] + y * m_desc.widthInTiles[mip] + x;
+}
+
+void VirtualTexturePageTable::GetTileCoord(uint32 tileIndex, uint32* outMip, uint32* outX, uint32* outY) const
+{
+	uint32 mip = 0;
+	while (tileIndex >= m_mipOffsets[mip + 1])
+	{
+		mip++;
+	}
+
+	uint32 local = tileIndex - m_mipOffsets[mip];
+	*outMip = mip;
+	*outX = local % m_desc.widthInTiles[mip];
+	*outY = local / m_desc.widthInTiles[mip];
+}
+
+void VirtualTexturePageTable::RequestTile(uint32 tileIndex)
+{
+	if (tileIndex >= m_tilesCount)
+		return;
+
+	uint32 mip, x, y;
+	GetTileCoord(tileIndex, &mip, &x, &y);
+
+	// Walk up the chain until a tile that was already requested this frame.
+	for (; mip < m_desc.standardMipsCount; mip++, x >>= 1, y >>= 1)
+	{
+		uint32 index = GetTileIndex(mip, x, y);
+		Tile& tile = m_tiles[index];
+		if (tile.requestFrame == m_frame)
+			break;
+
+		tile.requestFrame = m_frame;
+		m_requested[m_requestedCount++] = index;
+
+		if (tile.state == TILE_STATE_RESIDENT)
+		{
+			Unlink(tile.page);
+			LinkFront(tile.page);
+		}
+	}
+}
+
+uint32 VirtualTexturePageTable::Update(VirtualTileLoad* outLoads, uint32 maxLoads)
+{
+	// Coarse mips first: higher tile index means coarser mip.
+	std::sort(m_requested, m_requested + m_requestedCount, [](uint32 lhs, uint32 rhs) { return lhs > rhs; });
+
+	uint32 loadsCount = 0;
+	for (uint32 i = 0; i < m_requestedCount && loadsCount < maxLoads; i++)
+	{
+		uint32 tileIndex = m_requested[i];
+		Tile& tile = m_tiles[tileIndex];
+		if (tile.state != TILE_STATE_EMPTY)
+			continue;
+
+		VirtualTileLoad& load = outLoads[loadsCount];
+		load = {};
+		uint32 page = AllocatePage(&load);
+		if (page == VT_INVALID_INDEX)
+			break;
+
+		tile.state = TILE_STATE_LOADING;
+		tile.page = page;
+		m_pages[page].tileIndex = tileIndex;
+
+		load.tileIndex = tileIndex;
+		load.page = page;
+		GetTileCoord(tileIndex, &load.mip, &load.x, &load.y);
+		loadsCount++;
+	}
+
+	m_requestedCount = 0;
+	m_frame++;
+	return loadsCount;
+}
+
+void VirtualTexturePageTable::CompleteLoad(uint32 tileIndex)
+{
+	Tile& tile = m_tiles[tileIndex];
+	if (tile.state != TILE_STATE_LOADING)
+		return;
+
+	tile.state = TILE_STATE_RESIDENT;
+	LinkFront(tile.page);
+	m_residentCount++;
+}
+
+void VirtualTexturePageTable::CancelLoad(uint32 tileIndex)
+{
+	Tile& tile = m_tiles[tileIndex];
+	if (tile.state != TILE_STATE_LOADING)
+		return;
+
+	m_pages[tile.page].tileIndex = VT_INVALID_INDEX;
+	m_freePages[m_freePagesCount++] = tile.page;
+	tile.page = VT_INVALID_INDEX;
+	tile.state = TILE_STATE_EMPTY;
+}
+
+bool VirtualTexturePageTable::IsResident(uint32 tileIndex) const
+{
+	return m_tiles[tileIndex].state == TILE_STATE_RESIDENT;
+}
+
+void VirtualTexturePageTable::BuildResidencyMap(uint8* outMap) const
+{
+	uint32 width = m_desc.widthInTiles[0];
+	uint32 height = m_desc.heightInTiles[0];
+
+	for (uint32 y = 0; y < height; y++)
+	{
+		for (uint32 x = 0; x < width; x++)
+		{
+			// The packed tail is always there.
+			uint32 residentMip = m_desc.standardMipsCount;
+			for (uint32 mip = m_desc.standardMipsCount; mip-- > 0;)
+			{
+				if (!IsResident(GetTileIndex(mip, x >> mip, y >> mip)))
+					break;
+				residentMip = mip;
+			}
+			outMap[y * width + x] = static_cast<uint8>(residentMip);
+		}
+	}
+}
+
+void VirtualTexturePageTable::LinkFront(uint32 page)
+{
+	Page& entry = m_pages[page];
+	entry.prev = VT_INVALID_INDEX;
+	entry.next = m_lruHead;
+
+	if (m_lruHead != VT_INVALID_INDEX)
+		m_pages[m_lruHead].prev = page;
+	m_lruHead = page;
+
+	if (m_lruTail == VT_INVALID_INDEX)
+		m_lruTail = page;
+}
+
+void VirtualTexturePageTable::Unlink(uint32 page)
+{
+	Page& entry = m_pages[page];
+
+	if (entry.prev != VT_INVALID_INDEX)
+		m_pages[entry.prev].next = entry.next;
+	else
+		m_lruHead = entry.next;
+
+	if (entry.next != VT_INVALID_INDEX)
+		m_pages[entry.next].prev = entry.prev;
+	else
+		m_lruTail = entry.prev;
+
+	entry.prev = VT_INVALID_INDEX;
+	entry.next = VT_INVALID_INDEX;
+}
+
+uint32 VirtualTexturePageTable::AllocatePage(VirtualTileLoad* load)
+{
+	if (m_freePagesCount)
+		return m_freePages[--m_freePagesCount];
+
+	// Tiles requested this frame sit at the front, so if the tail was
+	// requested too, every resident tile is in use.
+	uint32 page = m_lruTail;
+	if (page == VT_INVALID_INDEX)
+		return VT_INVALID_INDEX;
+
+	uint32 evictedIndex = m_pages[page].tileIndex;
+	Tile& evicted = m_tiles[evictedIndex];
+	if (evicted.requestFrame == m_frame)
+		return VT_INVALID_INDEX;
+
+	Unlink(page);
+	evicted.state = TILE_STATE_EMPTY;
+	evicted.page = VT_INVALID_INDEX;
+	m_residentCount--;
+
+	load->evictedTileIndex = evictedIndex;
+	GetTileCoord(evictedIndex, &load->evictedMip, &load->evictedX, &load->evictedY);
+	return page;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Types.h"
+
+/*
+======================
+Virtual Texture Pages
+======================
+*/
+
+const uint32 VT_TILE_SIZE = 65536;			// D3D12 standard tile, in bytes.
+const uint32 VT_MAX_MIPS = 16;
+const uint32 VT_INVALID_INDEX = 0xffffffff;
+
+// Tile grid of every mip that is mapped tile by tile. Mips past
+// standardMipsCount form the packed tail and are always resident.
+struct VirtualTextureDesc
+{
+	uint32 standardMipsCount = 0;
+	uint32 widthInTiles[VT_MAX_MIPS] = {};
+	uint32 heightInTiles[VT_MAX_MIPS] = {};
+	uint32 physicalPagesCount = 0;
+};
+
+// Map tile (mip, x, y) to physical page. When evictedTile is valid, that tile
+// used the page until now and must be unmapped first.
+struct VirtualTileLoad
+{
+	uint32 tileIndex = VT_INVALID_INDEX;
+	uint32 mip = 0;
+	uint32 x = 0;
+	uint32 y = 0;
+	uint32 page = VT_INVALID_INDEX;
+	uint32 evictedTileIndex = VT_INVALID_INDEX;
+	uint32 evictedMip = 0;
+	uint32 evictedX = 0;
+	uint32 evictedY = 0;
+};
+
+/*
+=========================
+VirtualTexturePageTable
+=========================
+*/
+
+// CPU side of a sparse texture: which tiles are mapped to which physical
+// page, which are loading, and a least recently used list of pages. Tiles
+// requested by the feedback pass are granted coarsest mip first, so every
+// visible region gets a fallback before detail is added.
+class VirtualTexturePageTable
+{
+public:
+	void Init(const VirtualTextureDesc& desc);
+	void Clean();
+
+	uint32 GetTileIndex(uint32 mip, uint32 x, uint32 y) const;
+	void GetTileCoord(uint32 tileIndex, uint32* outMip, uint32* outX, uint32* outY) const;
+	inline uint32 GetTilesCount() const { return m_tilesCount; }
+
+	// Feedback for the current frame. Coarser tiles covering the same area are
+	// requested too, since they are the fallback while the tile loads.
+	void RequestTile(uint32 tileIndex);
+
+	// Returns the number of loads written. Pages come from the free list
+	// first, then from the least recently used tile that was not requested
+	// this frame. Ends the frame.
+	uint32 Update(VirtualTileLoad* outLoads, uint32 maxLoads);
+
+	// A load finished and its tile can be sampled; or failed and its page goes back to the free list.
+	void CompleteLoad(uint32 tileIndex);
+	void CancelLoad(uint32 tileIndex);
+
+	bool IsResident(uint32 tileIndex) const;
+	inline uint32 GetResidentTilesCount() const { return m_residentCount; }
+
+	// Finest fully resident mip for each mip 0 tile, written row by row into
+	// widthInTiles[0] * heightInTiles[0] bytes. Shaders clamp their LOD to it.
+	void BuildResidencyMap(uint8* outMap) const;
+
+private:
+	enum TILE_STATE : uint8
+	{
+		TILE_STATE_EMPTY,
+		TILE_STATE_LOADING,
+		TILE_STATE_RESIDENT,
+	};
+
+	struct Tile
+	{
+		uint32 page = VT_INVALID_INDEX;
+		uint32 requestFrame = 0;
+		TILE_STATE state = TILE_STATE_EMPTY;
+	};
+
+	// Resident pages form a doubly linked list, most recently used first.
+	struct Page
+	{
+		uint32 tileIndex = VT_INVALID_INDEX;
+		uint32 prev = VT_INVALID_INDEX;
+		uint32 next = VT_INVALID_INDEX;
+	};
+
+	VirtualTextureDesc m_desc = {};
+	uint32 m_mipOffsets[VT_MAX_MIPS + 1] = {};
+	uint32 m_tilesCount = 0;
+	Tile* m_tiles = nullptr;
+
+	Page* m_pages = nullptr;
+	uint32* m_freePages = nullptr;
+	uint32 m_freePagesCount = 0;
+	uint32 m_lruHead = VT_INVALID_INDEX;
+	uint32 m_lruTail = VT_INVALID_INDEX;
+	uint32 m_residentCount = 0;
+
+	uint32* m_requested = nullptr;
+	uint32 m_requestedCount = 0;
+	uint32 m_frame = 1;
+
+	void LinkFront(uint32 page);
+	void Unlink(uint32 page);
+	uint32 AllocatePage(VirtualTileLoad* load);
+};
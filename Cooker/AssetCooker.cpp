@@ -0,0 +1,259 @@
+#include "AssetCooker.h"
+#include "MeshImporter.h"
+#include "../Common/FileMapping.h"
+#include "../Common/Hash.h"
+#include "../Common/ImageFile.h"
+#include "../Common/MeshFile.h"
+#include "../Common/MeshOptimizer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+/*
+==============
+Cook Cache
+==============
+*/
+
+bool CookCache::Load(const char* filename)
+{
+	FILE* file = ::fopen(filename, "rt");
+	if (!file)
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	// One "<key> <output path>" entry per line.
+	char line[1024];
+	while (::fgets(line, sizeof(line), file))
+	{
+		unsigned long long key = 0;
+		int consumed = 0;
+		if (::sscanf(line, "%llx %n", &key, &consumed) != 1)
+			continue;
+
+		std::string path = line + consumed;
+		while (!path.empty() && (path.back() == '\n' || path.back() == '\r'))
+			path.pop_back();
+
+		if (!path.empty())
+			m_entries[path] = key;
+	}
+
+	::fclose(file);
+	return true;
+}
+
+bool CookCache::Save(const char* filename) const
+{
+	FILE* file = ::fopen(filename, "wt");
+	if (!file)
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	// Sorted so the file diffs cleanly between runs.
+	std::vector<const std::pair<const std::string, uint64>*> entries;
+	for (const auto& entry : m_entries)
+	{
+		entries.push_back(&entry);
+	}
+	std::sort(entries.begin(), entries.end(), [](const auto* lhs, const auto* rhs) { return lhs->first < rhs->first; });
+
+	for (const auto* entry : entries)
+	{
+		::fprintf(file, "%016llx %s\n", static_cast<unsigned long long>(entry->second), entry->first.c_str());
+	}
+
+	::fclose(file);
+	return true;
+}
+
+bool CookCache::IsUpToDate(const std::string& outputPath, uint64 key) const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	auto it = m_entries.find(outputPath);
+	if (it == m_entries.end() || it->second != key)
+		return false;
+
+	// The output may have been deleted since the last run.
+	FILE* file = ::fopen(outputPath.c_str(), "rb");
+	if (!file)
+		return false;
+
+	::fclose(file);
+	return true;
+}
+
+void CookCache::Update(const std::string& outputPath, uint64 key)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_entries[outputPath] = key;
+}
+
+/*
+==============
+AssetCooker
+==============
+*/
+
+namespace AssetCooker
+{
+	static DDS_FORMAT ToSrgb(DDS_FORMAT format)
+	{
+		switch (format)
+		{
+		case DDS_FORMAT_BC1_UNORM: return DDS_FORMAT_BC1_UNORM_SRGB;
+		case DDS_FORMAT_BC3_UNORM: return DDS_FORMAT_BC3_UNORM_SRGB;
+		case DDS_FORMAT_BC7_UNORM: return DDS_FORMAT_BC7_UNORM_SRGB;
+		default: return format;
+		}
+	}
+
+	bool ComputeSourceKey(const char* sourcePath, uint64* outKey)
+	{
+		FileMapping mapping = {};
+		if (!FileSystem::MapFile(sourcePath, &mapping))
+			return false;
+
+		uint64 key = HashBytes(mapping.data, mapping.size);
+		key = HashValue(COOKER_VERSION, key);
+		key = HashValue(MESH_FILE_VERSION, key);
+
+		FileSystem::UnmapFile(&mapping);
+
+		// An edited glTF buffer changes the mesh without touching the document.
+		if (MeshImporter::IsSupported(sourcePath) && !MeshImporter::HashDependencies(sourcePath, &key))
+			return false;
+
+		*outKey = key;
+		return true;
+	}
+
+	bool CookMesh(const char* sourcePath, const char* outputPath, CookStats* outStats)
+	{
+		*outStats = {};
+
+		MeshData meshData = {};
+		if (!MeshImporter::Load(sourcePath, &meshData))
+			return false;
+
+		outStats->sourceVerticesCount = meshData.verticesCount;
+		outStats->acmrBefore = MeshOptimizer::AnalyzeVertexCache(meshData.indices, meshData.indicesCount, meshData.verticesCount);
+
+		MeshOptimizer::QuantizeVertices(&meshData);
+		MeshOptimizer::WeldVertices(&meshData);
+		MeshOptimizer::OptimizeVertexCache(meshData.indices, meshData.indicesCount, meshData.verticesCount);
+		MeshOptimizer::OptimizeVertexFetch(&meshData);
+
+		outStats->acmrAfter = MeshOptimizer::AnalyzeVertexCache(meshData.indices, meshData.indicesCount, meshData.verticesCount);
+		outStats->verticesCount = meshData.verticesCount;
+		outStats->trianglesCount = meshData.indicesCount / 3;
+
+		// Simplified LODs come out in collapse order; give them the same cache treatment.
+		MeshLodChain lodChain = {};
+		bool hasLods = MeshSimplifier::BuildLodChain(meshData, &lodChain);
+		if (hasLods)
+		{
+			for (uint32 i = 1; i < lodChain.lodsCount; i++)
+			{
+				const MeshLod& lod = lodChain.lods[i];
+				MeshOptimizer::OptimizeVertexCache(&lodChain.indices[lod.indexOffset], lod.indicesCount, meshData.verticesCount);
+			}
+			outStats->lodsCount = lodChain.lodsCount;
+		}
+
+		MeshletData meshletData = {};
+		bool hasMeshlets = meshData.indicesCount / 3 >= MESHLET_MIN_MESH_TRIANGLES && MeshletBuilder::Build(meshData, &meshletData);
+		if (hasMeshlets)
+			outStats->meshletsCount = meshletData.meshletsCount;
+
+		bool result = MeshFile::Write(outputPath, meshData, hasLods ? &lodChain : nullptr, hasMeshlets ? &meshletData : nullptr);
+		if (!result)
+			::fprintf(stderr, "%s: failed to write\n", outputPath);
+
+		MeshletBuilder::Destroy(&meshletData);
+		MeshSimplifier::Destroy(&lodChain);
+		MeshImporter::Destroy(&meshData);
+		return result;
+	}
+
+	bool CookTexture(const char* sourcePath, const char* outputPath, const TextureCookSettings& settings, uint32 threadsCount, TextureCookStats* outStats)
+	{
+		*outStats = {};
+
+		ImageData image = {};
+		if (!ImageFile::Load(sourcePath, &image))
+		{
+			::fprintf(stderr, "%s: unsupported or corrupt image\n", sourcePath);
+			return false;
+		}
+
+		DDS_FORMAT format = settings.format;
+		if (format == DDS_FORMAT_UNKNOWN)
+			format = image.hasAlpha ? DDS_FORMAT_BC3_UNORM : DDS_FORMAT_BC1_UNORM;
+		if (settings.srgb)
+			format = ToSrgb(format);
+
+		// D3D12 only accepts block-compressed textures whose top mip is a multiple of 4.
+		if (image.width % 4 != 0 || image.height % 4 != 0)
+		{
+			::fprintf(stderr, "%s: %ux%u is not a multiple of 4\n", sourcePath, image.width, image.height);
+			ImageFile::Destroy(&image);
+			return false;
+		}
+
+		uint32 mipLevels = settings.generateMips ? MipGenerator::GetMipLevelsCount(image.width, image.height) : 1;
+
+		DDSTextureInfo pixelsInfo = {};
+		DDSTextureInfo info = {};
+		if (!BCEncoder::IsSupported(format) ||
+			!DDSFile::InitInfo(DDS_FORMAT_R8G8B8A8_UNORM, image.width, image.height, mipLevels, &pixelsInfo) ||
+			!DDSFile::InitInfo(format, image.width, image.height, mipLevels, &info))
+		{
+			::fprintf(stderr, "%s: cannot encode %ux%u\n", sourcePath, image.width, image.height);
+			ImageFile::Destroy(&image);
+			return false;
+		}
+
+		outStats->width = image.width;
+		outStats->height = image.height;
+		outStats->mipLevels = mipLevels;
+		outStats->format = format;
+
+		uint8* pixels = new uint8[pixelsInfo.sliceSize];
+		::memcpy(pixels, image.pixels, static_cast<size_t>(pixelsInfo.mips[0].size));
+
+		auto startTime = std::chrono::steady_clock::now();
+		MipGenerator::Generate(pixelsInfo, settings.mipFilter, !settings.linearData, threadsCount, pixels);
+		auto mipsTime = std::chrono::steady_clock::now();
+		outStats->mipsMilliseconds = std::chrono::duration<float, std::milli>(mipsTime - startTime).count();
+
+		uint8* blocks = new uint8[info.sliceSize];
+		for (uint32 mip = 0; mip < mipLevels; mip++)
+		{
+			const DDSMipLayout& layout = pixelsInfo.mips[mip];
+			BCEncoder::Compress(pixels + layout.offset, layout.width, layout.height, format, settings.quality, threadsCount, blocks + info.mips[mip].offset);
+		}
+		outStats->encodeMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mipsTime).count();
+
+		// Decode again to report what the compression cost.
+		uint8* decoded = new uint8[static_cast<size_t>(pixelsInfo.mips[0].size)];
+		BCEncoder::Decompress(blocks, image.width, image.height, format, decoded);
+		outStats->psnr = BCEncoder::ComputePsnr(image.pixels, decoded, image.width, image.height, image.hasAlpha);
+		delete[] decoded;
+
+		bool result = DDSFile::Write(outputPath, info, blocks);
+		if (!result)
+			::fprintf(stderr, "%s: failed to write\n", outputPath);
+
+		delete[] blocks;
+		delete[] pixels;
+		ImageFile::Destroy(&image);
+		return result;
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../Common/Types.h"
+#include "../Common/BCEncoder.h"
+#include "../Common/DDSFile.h"
+#include "../Common/MipGenerator.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/*
+==============
+Cook Cache
+==============
+*/
+
+// Bump whenever a cooking pass changes its output, so stale entries rebuild.
+const uint32 COOKER_VERSION = 1;
+
+// Maps each output file to the hash of everything it was cooked from (source
+// bytes, cooker and file format versions). Stored as text next to the outputs.
+class CookCache
+{
+public:
+	bool Load(const char* filename);
+	bool Save(const char* filename) const;
+
+	bool IsUpToDate(const std::string& outputPath, uint64 key) const;
+	void Update(const std::string& outputPath, uint64 key);
+
+private:
+	mutable std::mutex m_lock;
+	std::unordered_map<std::string, uint64> m_entries;
+};
+
+/*
+==============
+AssetCooker
+==============
+*/
+
+struct CookStats
+{
+	uint32 sourceVerticesCount = 0;
+	uint32 verticesCount = 0;
+	uint32 trianglesCount = 0;
+	uint32 lodsCount = 0;
+	uint32 meshletsCount = 0;
+	float acmrBefore = 0.0f;
+	float acmrAfter = 0.0f;
+};
+
+struct TextureCookSettings
+{
+	DDS_FORMAT format = DDS_FORMAT_UNKNOWN;		// Picked per image from its alpha.
+	BC_QUALITY quality = BC_QUALITY_NORMAL;
+	bool srgb = false;							// Tag the output as sRGB.
+	bool linearData = false;					// Normal maps and masks: filter mips without gamma.
+	bool generateMips = true;
+	MIP_FILTER mipFilter = MIP_FILTER_KAISER;
+};
+
+struct TextureCookStats
+{
+	uint32 width = 0;
+	uint32 height = 0;
+	uint32 mipLevels = 0;
+	DDS_FORMAT format = DDS_FORMAT_UNKNOWN;
+	float psnr = 0.0f;				// Mip 0 only, over RGB, or RGBA when the source has alpha.
+	float mipsMilliseconds = 0.0f;
+	float encodeMilliseconds = 0.0f;
+};
+
+namespace AssetCooker
+{
+	// Hash of the source file contents, and of the files it references, combined
+	// with the cooker and format versions.
+	bool ComputeSourceKey(const char* sourcePath, uint64* outKey);
+
+	// Import, quantize, weld, vertex cache and fetch optimization, LOD chain,
+	// meshlets, then MeshFile::Write to outputPath.
+	bool CookMesh(const char* sourcePath, const char* outputPath, CookStats* outStats);
+
+	// Decode a PNG or TGA, build its mip chain, block-compress every mip with
+	// threadsCount threads, then DDSFile::Write to outputPath.
+	bool CookTexture(const char* sourcePath, const char* outputPath, const TextureCookSettings& settings, uint32 threadsCount, TextureCookStats* outStats);
+}
@@ -0,0 +1,308 @@
+#include "AssetCooker.h"
+#include "MeshImporter.h"
+#include "../Common/Hash.h"
+#include "../Common/ImageFile.h"
+#include "../Common/Platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/*
+==============
+Cook Job
+==============
+*/
+
+struct CookJob
+{
+	std::string sourcePath;
+	std::string outputPath;
+	bool isTexture = false;
+};
+
+static void PrintUsage()
+{
+	::printf("Usage: Cooker [-o <output dir>] [-j <threads>] [-t bc1|bc3|bc7] [-q fast|normal|high] [-m box|kaiser|none] [-srgb] [-linear] [-f] <file or dir>...\n");
+	::printf("  -o  Output directory (default: Assets)\n");
+	::printf("  -j  Worker threads (default: hardware concurrency)\n");
+	::printf("  -t  Texture format (default: BC3 for images with alpha, BC1 otherwise)\n");
+	::printf("  -q  Texture encoder quality (default: normal)\n");
+	::printf("  -m  Mip filter: box, kaiser or none (default: kaiser)\n");
+	::printf("  -srgb  Tag textures as sRGB\n");
+	::printf("  -linear  Textures hold data, not color: filter mips without gamma\n");
+	::printf("  -f  Ignore the cook cache and rebuild everything\n");
+}
+
+static bool ParseTextureFormat(const char* name, DDS_FORMAT* outFormat)
+{
+	if (::strcmp(name, "bc1") == 0)
+		*outFormat = DDS_FORMAT_BC1_UNORM;
+	else if (::strcmp(name, "bc3") == 0)
+		*outFormat = DDS_FORMAT_BC3_UNORM;
+	else if (::strcmp(name, "bc7") == 0)
+		*outFormat = DDS_FORMAT_BC7_UNORM;
+	else
+		return false;
+	return true;
+}
+
+static bool ParseTextureQuality(const char* name, BC_QUALITY* outQuality)
+{
+	if (::strcmp(name, "fast") == 0)
+		*outQuality = BC_QUALITY_FAST;
+	else if (::strcmp(name, "normal") == 0)
+		*outQuality = BC_QUALITY_NORMAL;
+	else if (::strcmp(name, "high") == 0)
+		*outQuality = BC_QUALITY_HIGH;
+	else
+		return false;
+	return true;
+}
+
+static bool ParseMipFilter(const char* name, TextureCookSettings* outSettings)
+{
+	outSettings->generateMips = true;
+	if (::strcmp(name, "box") == 0)
+		outSettings->mipFilter = MIP_FILTER_BOX;
+	else if (::strcmp(name, "kaiser") == 0)
+		outSettings->mipFilter = MIP_FILTER_KAISER;
+	else if (::strcmp(name, "none") == 0)
+		outSettings->generateMips = false;
+	else
+		return false;
+	return true;
+}
+
+static void AddJob(const fs::path& sourcePath, const fs::path& outputDir, std::vector<CookJob>* outJobs)
+{
+	CookJob job;
+	job.sourcePath = sourcePath.generic_string();
+	job.isTexture = ImageFile::IsSupported(job.sourcePath.c_str());
+	job.outputPath = (outputDir / sourcePath.stem()).generic_string() + (job.isTexture ? ".dds" : ".xmesh");
+	outJobs->push_back(job);
+}
+
+// Files found in a directory keep their path below it, so files with the same
+// name in different folders cook to different outputs.
+static void CollectJobs(const fs::path& input, const fs::path& outputDir, std::vector<CookJob>* outJobs)
+{
+	std::error_code error;
+	if (fs::is_directory(input, error))
+	{
+		for (const fs::directory_entry& entry : fs::recursive_directory_iterator(input, error))
+		{
+			std::string path = entry.path().string();
+			if (entry.is_regular_file() && (MeshImporter::IsSupported(path.c_str()) || ImageFile::IsSupported(path.c_str())))
+				AddJob(entry.path(), outputDir / entry.path().lexically_relative(input).parent_path(), outJobs);
+		}
+		return;
+	}
+
+	AddJob(input, outputDir, outJobs);
+}
+
+// Sources can still meet at one output, such as a.gltf and a.glb, or one
+// file given twice. Cooking both would race on the file and the cache entry.
+static bool CheckOutputCollisions(const std::vector<CookJob>& jobs)
+{
+	std::unordered_map<std::string, const CookJob*> outputs;
+	bool result = true;
+	for (const CookJob& job : jobs)
+	{
+		auto inserted = outputs.emplace(job.outputPath, &job);
+		if (!inserted.second)
+		{
+			::fprintf(stderr, "%s and %s both cook to %s\n", inserted.first->second->sourcePath.c_str(), job.sourcePath.c_str(), job.outputPath.c_str());
+			result = false;
+		}
+	}
+	return result;
+}
+
+/*
+=================
+Main entry point
+=================
+*/
+
+int main(int argc, char* argv[])
+{
+	// AVX2 and AVX-512 builds would fault on the first wide instruction.
+	if (!Platform::IsInstructionSetSupported())
+	{
+		::printf("This build targets %s, which this CPU does not support.\n", Platform::GetInstructionSetName());
+		return 1;
+	}
+
+	fs::path outputDir = "Assets";
+	uint32 threadsCount = std::thread::hardware_concurrency();
+	bool force = false;
+	TextureCookSettings textureSettings;
+	std::vector<fs::path> inputs;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			outputDir = argv[++i];
+		else if (::strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+			threadsCount = static_cast<uint32>(::atoi(argv[++i]));
+		else if (::strcmp(argv[i], "-t") == 0 && i + 1 < argc && ParseTextureFormat(argv[i + 1], &textureSettings.format))
+			i++;
+		else if (::strcmp(argv[i], "-q") == 0 && i + 1 < argc && ParseTextureQuality(argv[i + 1], &textureSettings.quality))
+			i++;
+		else if (::strcmp(argv[i], "-m") == 0 && i + 1 < argc && ParseMipFilter(argv[i + 1], &textureSettings))
+			i++;
+		else if (::strcmp(argv[i], "-srgb") == 0)
+			textureSettings.srgb = true;
+		else if (::strcmp(argv[i], "-linear") == 0)
+			textureSettings.linearData = true;
+		else if (::strcmp(argv[i], "-f") == 0)
+			force = true;
+		else if (argv[i][0] == '-')
+		{
+			PrintUsage();
+			return 1;
+		}
+		else
+			inputs.push_back(argv[i]);
+	}
+
+	if (inputs.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::vector<CookJob> jobs;
+	for (const fs::path& input : inputs)
+	{
+		CollectJobs(input, outputDir, &jobs);
+	}
+
+	if (!CheckOutputCollisions(jobs))
+		return 1;
+
+	std::error_code error;
+	fs::create_directories(outputDir, error);
+	for (const CookJob& job : jobs)
+	{
+		fs::create_directories(fs::path(job.outputPath).parent_path(), error);
+	}
+
+	std::string cachePath = (outputDir / "CookCache.txt").generic_string();
+	CookCache cache;
+	if (!force)
+		cache.Load(cachePath.c_str());
+
+	if (threadsCount == 0)
+		threadsCount = 1;
+	// With fewer jobs than threads, the spare threads go to the block encoder instead.
+	uint32 encoderThreadsCount = jobs.size() < threadsCount ? threadsCount : 1;
+	if (threadsCount > jobs.size())
+		threadsCount = static_cast<uint32>(jobs.size());
+
+	std::atomic<uint32> nextJob(0);
+	std::atomic<uint32> cookedCount(0);
+	std::atomic<uint32> skippedCount(0);
+	std::atomic<uint32> failedCount(0);
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	// Jobs are independent, so workers just pull the next index until the list runs out.
+	auto worker = [&]()
+	{
+		while (true)
+		{
+			uint32 jobIndex = nextJob.fetch_add(1);
+			if (jobIndex >= jobs.size())
+				break;
+
+			const CookJob& job = jobs[jobIndex];
+
+			uint64 key = 0;
+			if (!AssetCooker::ComputeSourceKey(job.sourcePath.c_str(), &key))
+			{
+				::fprintf(stderr, "%s: cannot read\n", job.sourcePath.c_str());
+				failedCount++;
+				continue;
+			}
+
+			// Texture settings change the output, so they are part of the key.
+			if (job.isTexture)
+			{
+				key = HashValue(textureSettings.format, key);
+				key = HashValue(textureSettings.quality, key);
+				key = HashValue(textureSettings.srgb, key);
+				key = HashValue(textureSettings.linearData, key);
+				key = HashValue(textureSettings.generateMips, key);
+				key = HashValue(textureSettings.mipFilter, key);
+			}
+
+			if (cache.IsUpToDate(job.outputPath, key))
+			{
+				skippedCount++;
+				continue;
+			}
+
+			if (job.isTexture)
+			{
+				TextureCookStats stats;
+				if (!AssetCooker::CookTexture(job.sourcePath.c_str(), job.outputPath.c_str(), textureSettings, encoderThreadsCount, &stats))
+				{
+					failedCount++;
+					continue;
+				}
+
+				cache.Update(job.outputPath, key);
+				cookedCount++;
+
+				::printf("%s -> %s: %ux%u, %u mips, format %u, PSNR %.2f dB, mips %.1f ms, encode %.1f ms (%.1f Mpixels/s)\n",
+					job.sourcePath.c_str(), job.outputPath.c_str(), stats.width, stats.height, stats.mipLevels, static_cast<uint32>(stats.format),
+					stats.psnr, stats.mipsMilliseconds, stats.encodeMilliseconds, stats.width * stats.height / (stats.encodeMilliseconds * 1000.0f));
+				continue;
+			}
+
+			CookStats stats;
+			if (!AssetCooker::CookMesh(job.sourcePath.c_str(), job.outputPath.c_str(), &stats))
+			{
+				failedCount++;
+				continue;
+			}
+
+			cache.Update(job.outputPath, key);
+			cookedCount++;
+
+			::printf("%s -> %s: %u -> %u vertices, %u triangles, %u LODs, %u meshlets, ACMR %.3f -> %.3f\n",
+				job.sourcePath.c_str(), job.outputPath.c_str(), stats.sourceVerticesCount, stats.verticesCount,
+				stats.trianglesCount, stats.lodsCount, stats.meshletsCount, stats.acmrBefore, stats.acmrAfter);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (uint32 i = 1; i < threadsCount; i++)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	cache.Save(cachePath.c_str());
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	::printf("%u cooked, %u up to date, %u failed (%.2fs, %u threads)\n", cookedCount.load(), skippedCount.load(), failedCount.load(), seconds, threadsCount);
+
+	return failedCount.load() ? 1 : 0;
+}
@@ -0,0 +1,973 @@
+#include "MeshImporter.h"
+#include "../Common/FileMapping.h"
+#include "../Common/Hash.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+==================
+Helpers
+==================
+*/
+
+namespace MeshImporter
+{
+	static const char* GetExtension(const char* filename)
+	{
+		const char* dot = ::strrchr(filename, '.');
+		return dot ? dot + 1 : "";
+	}
+
+	static bool EqualsNoCase(const char* lhs, const char* rhs)
+	{
+		for (; *lhs && *rhs; lhs++, rhs++)
+		{
+			if (::tolower(static_cast<uint8>(*lhs)) != ::tolower(static_cast<uint8>(*rhs)))
+				return false;
+		}
+		return *lhs == *rhs;
+	}
+
+	static bool LoadFileBytes(const char* filename, std::vector<char>* outText)
+	{
+		FileMapping mapping = {};
+		if (!FileSystem::MapFile(filename, &mapping))
+			return false;
+
+		// Parsers rely on strtof/strtol, so keep the buffer null terminated.
+		outText->assign(reinterpret_cast<const char*>(mapping.data), reinterpret_cast<const char*>(mapping.data) + mapping.size);
+		outText->push_back('\0');
+
+		FileSystem::UnmapFile(&mapping);
+		return true;
+	}
+
+	static void StoreMeshData(const std::vector<Vertex>& vertices, const std::vector<Index>& indices, MeshData* outMeshData)
+	{
+		*outMeshData = {};
+
+		outMeshData->verticesCount = static_cast<uint32>(vertices.size());
+		outMeshData->verticesSize = sizeof(Vertex) * outMeshData->verticesCount;
+		outMeshData->vertices = new Vertex[outMeshData->verticesCount];
+		::memcpy(outMeshData->vertices, vertices.data(), outMeshData->verticesSize);
+
+		outMeshData->indicesCount = static_cast<uint32>(indices.size());
+		outMeshData->indicesSize = sizeof(Index) * outMeshData->indicesCount;
+		outMeshData->indices = new Index[outMeshData->indicesCount];
+		::memcpy(outMeshData->indices, indices.data(), outMeshData->indicesSize);
+	}
+
+	/*
+	==================
+	OBJ
+	==================
+	*/
+
+	static const char* SkipSpaces(const char* p)
+	{
+		while (*p == ' ' || *p == '\t')
+			p++;
+		return p;
+	}
+
+	static const char* NextLine(const char* p)
+	{
+		while (*p && *p != '\n')
+			p++;
+		return *p ? p + 1 : p;
+	}
+
+	// OBJ indices are 1-based; negative values count back from the last element.
+	static int32 ResolveObjIndex(long index, size_t count)
+	{
+		if (index > 0)
+			return static_cast<int32>(index - 1);
+		if (index < 0)
+			return static_cast<int32>(static_cast<long>(count) + index);
+		return -1;
+	}
+
+	bool LoadObj(const char* filename, MeshData* outMeshData)
+	{
+		std::vector<char> text;
+		if (!LoadFileBytes(filename, &text))
+			return false;
+
+		std::vector<Vector3> positions;
+		std::vector<Vector4> colors;
+		std::vector<Vector2> texCoords;
+		std::vector<Vertex> vertices;
+		std::vector<Index> indices;
+		std::vector<Vertex> polygon;
+
+		for (const char* p = text.data(); *p; p = NextLine(p))
+		{
+			p = SkipSpaces(p);
+
+			if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+			{
+				char* end = nullptr;
+				float values[7] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+				uint32 valuesCount = 0;
+				for (const char* q = p + 1; valuesCount < 7; q = end)
+				{
+					float value = ::strtof(q, &end);
+					if (end == q)
+						break;
+					values[valuesCount++] = value;
+				}
+
+				positions.push_back(Vector3(values[0], values[1], -values[2]));
+				colors.push_back(valuesCount >= 6 ? Vector4(values[3], values[4], values[5], 1.0f) : Vector4(1.0f, 1.0f, 1.0f, 1.0f));
+			}
+			else if (p[0] == 'v' && p[1] == 't')
+			{
+				char* end = nullptr;
+				float u = ::strtof(p + 2, &end);
+				float v = ::strtof(end, &end);
+				texCoords.push_back(Vector2(u, 1.0f - v));
+			}
+			else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+			{
+				polygon.clear();
+
+				const char* q = p + 1;
+				while (true)
+				{
+					q = SkipSpaces(q);
+					if (*q == '\0' || *q == '\n' || *q == '\r' || *q == '#')
+						break;
+
+					char* end = nullptr;
+					int32 positionIndex = ResolveObjIndex(::strtol(q, &end, 10), positions.size());
+					int32 texCoordIndex = -1;
+					if (*end == '/')
+					{
+						q = end + 1;
+						if (*q != '/')
+							texCoordIndex = ResolveObjIndex(::strtol(q, &end, 10), texCoords.size());
+						else
+							end = const_cast<char*>(q);
+
+						// Normals are not part of the vertex format.
+						if (*end == '/')
+							::strtol(end + 1, &end, 10);
+					}
+
+					if (positionIndex < 0 || positionIndex >= static_cast<int32>(positions.size()) || texCoordIndex >= static_cast<int32>(texCoords.size()))
+					{
+						::fprintf(stderr, "%s: invalid face index\n", filename);
+						return false;
+					}
+
+					Vertex vertex = {};
+					vertex.posModel = positions[positionIndex];
+					vertex.color = colors[positionIndex];
+					vertex.texCoord = texCoordIndex >= 0 ? texCoords[texCoordIndex] : Vector2(0.0f, 0.0f);
+					polygon.push_back(vertex);
+
+					q = end;
+					while (*q && !isspace(static_cast<uint8>(*q)))
+						q++;
+				}
+
+				// Negating z mirrors the mesh, which already turns counter-clockwise faces clockwise.
+				for (size_t i = 2; i < polygon.size(); i++)
+				{
+					Index base = static_cast<Index>(vertices.size());
+					vertices.push_back(polygon[0]);
+					vertices.push_back(polygon[i - 1]);
+					vertices.push_back(polygon[i]);
+					indices.push_back(base);
+					indices.push_back(base + 1);
+					indices.push_back(base + 2);
+				}
+			}
+		}
+
+		if (indices.empty())
+		{
+			::fprintf(stderr, "%s: no faces\n", filename);
+			return false;
+		}
+
+		StoreMeshData(vertices, indices, outMeshData);
+		return true;
+	}
+
+	/*
+	==================
+	JSON
+	==================
+	*/
+
+	// Just enough JSON for glTF documents.
+	struct JsonValue
+	{
+		enum TYPE
+		{
+			TYPE_NULL,
+			TYPE_BOOL,
+			TYPE_NUMBER,
+			TYPE_STRING,
+			TYPE_ARRAY,
+			TYPE_OBJECT,
+		};
+
+		TYPE type = TYPE_NULL;
+		double number = 0.0;
+		std::string string;
+		std::vector<JsonValue> array;
+		std::vector<std::pair<std::string, JsonValue>> object;
+
+		const JsonValue* Find(const char* key) const
+		{
+			for (const auto& member : object)
+			{
+				if (member.first == key)
+					return &member.second;
+			}
+			return nullptr;
+		}
+
+		const JsonValue* At(size_t index) const
+		{
+			return index < array.size() ? &array[index] : nullptr;
+		}
+
+		double GetNumber(const char* key, double defaultValue) const
+		{
+			const JsonValue* value = Find(key);
+			return value && value->type == TYPE_NUMBER ? value->number : defaultValue;
+		}
+	};
+
+	class JsonParser
+	{
+	public:
+		explicit JsonParser(const char* text) : m_cur(text) {}
+
+		bool Parse(JsonValue* outValue)
+		{
+			return ParseValue(outValue, 0);
+		}
+
+	private:
+		static const uint32 s_MaxDepth = 64;
+
+		void SkipWhitespace()
+		{
+			while (*m_cur == ' ' || *m_cur == '\t' || *m_cur == '\n' || *m_cur == '\r')
+				m_cur++;
+		}
+
+		bool ParseString(std::string* outString)
+		{
+			if (*m_cur != '"')
+				return false;
+			m_cur++;
+
+			while (*m_cur && *m_cur != '"')
+			{
+				if (*m_cur == '\\')
+				{
+					m_cur++;
+					switch (*m_cur)
+					{
+					case 'n': outString->push_back('\n'); break;
+					case 't': outString->push_back('\t'); break;
+					case 'r': outString->push_back('\r'); break;
+					case 'b': outString->push_back('\b'); break;
+					case 'f': outString->push_back('\f'); break;
+					case 'u':
+					{
+						// Names and URIs in practice are ASCII; keep the low byte.
+						char hex[5] = {};
+						for (uint32 i = 0; i < 4; i++)
+						{
+							if (!isxdigit(static_cast<uint8>(m_cur[1 + i])))
+								return false;
+							hex[i] = m_cur[1 + i];
+						}
+						outString->push_back(static_cast<char>(::strtol(hex, nullptr, 16) & 0xff));
+						m_cur += 4;
+						break;
+					}
+					case '\0': return false;
+					default: outString->push_back(*m_cur); break;
+					}
+					m_cur++;
+				}
+				else
+				{
+					outString->push_back(*m_cur++);
+				}
+			}
+
+			if (*m_cur != '"')
+				return false;
+			m_cur++;
+			return true;
+		}
+
+		bool ParseValue(JsonValue* outValue, uint32 depth)
+		{
+			if (depth > s_MaxDepth)
+				return false;
+
+			SkipWhitespace();
+			switch (*m_cur)
+			{
+			case '{':
+			{
+				outValue->type = JsonValue::TYPE_OBJECT;
+				m_cur++;
+				SkipWhitespace();
+				if (*m_cur == '}')
+				{
+					m_cur++;
+					return true;
+				}
+				while (true)
+				{
+					SkipWhitespace();
+					std::pair<std::string, JsonValue> member;
+					if (!ParseString(&member.first))
+						return false;
+					SkipWhitespace();
+					if (*m_cur++ != ':')
+						return false;
+					if (!ParseValue(&member.second, depth + 1))
+						return false;
+					outValue->object.push_back(std::move(member));
+
+					SkipWhitespace();
+					if (*m_cur == ',')
+					{
+						m_cur++;
+						continue;
+					}
+					if (*m_cur == '}')
+					{
+						m_cur++;
+						return true;
+					}
+					return false;
+				}
+			}
+			case '[':
+			{
+				outValue->type = JsonValue::TYPE_ARRAY;
+				m_cur++;
+				SkipWhitespace();
+				if (*m_cur == ']')
+				{
+					m_cur++;
+					return true;
+				}
+				while (true)
+				{
+					outValue->array.emplace_back();
+					if (!ParseValue(&outValue->array.back(), depth + 1))
+						return false;
+
+					SkipWhitespace();
+					if (*m_cur == ',')
+					{
+						m_cur++;
+						continue;
+					}
+					if (*m_cur == ']')
+					{
+						m_cur++;
+						return true;
+					}
+					return false;
+				}
+			}
+			case '"':
+				outValue->type = JsonValue::TYPE_STRING;
+				return ParseString(&outValue->string);
+			case 't':
+			case 'f':
+			{
+				bool value = *m_cur == 't';
+				const char* literal = value ? "true" : "false";
+				size_t length = ::strlen(literal);
+				if (::strncmp(m_cur, literal, length) != 0)
+					return false;
+				outValue->type = JsonValue::TYPE_BOOL;
+				outValue->number = value ? 1.0 : 0.0;
+				m_cur += length;
+				return true;
+			}
+			case 'n':
+				if (::strncmp(m_cur, "null", 4) != 0)
+					return false;
+				m_cur += 4;
+				return true;
+			default:
+			{
+				char* end = nullptr;
+				outValue->type = JsonValue::TYPE_NUMBER;
+				outValue->number = ::strtod(m_cur, &end);
+				if (end == m_cur)
+					return false;
+				m_cur = end;
+				return true;
+			}
+			}
+		}
+
+	private:
+		const char* m_cur = nullptr;
+	};
+
+	/*
+	==================
+	glTF
+	==================
+	*/
+
+	const uint32 GLB_MAGIC = 0x46546c67;		// 'glTF'
+	const uint32 GLB_CHUNK_JSON = 0x4e4f534a;
+	const uint32 GLB_CHUNK_BIN = 0x004e4942;
+
+	enum GLTF_COMPONENT_TYPE
+	{
+		GLTF_COMPONENT_TYPE_BYTE = 5120,
+		GLTF_COMPONENT_TYPE_UNSIGNED_BYTE = 5121,
+		GLTF_COMPONENT_TYPE_SHORT = 5122,
+		GLTF_COMPONENT_TYPE_UNSIGNED_SHORT = 5123,
+		GLTF_COMPONENT_TYPE_UNSIGNED_INT = 5125,
+		GLTF_COMPONENT_TYPE_FLOAT = 5126,
+	};
+
+	const uint32 GLTF_MODE_TRIANGLES = 4;
+
+	static bool DecodeBase64(const char* text, std::vector<uint8>* outBytes)
+	{
+		uint32 accumulator = 0;
+		uint32 bits = 0;
+		for (; *text && *text != '='; text++)
+		{
+			char c = *text;
+			uint32 value = 0;
+			if (c >= 'A' && c <= 'Z') value = c - 'A';
+			else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+			else if (c >= '0' && c <= '9') value = c - '0' + 52;
+			else if (c == '+') value = 62;
+			else if (c == '/') value = 63;
+			else return false;
+
+			accumulator = (accumulator << 6) | value;
+			bits += 6;
+			if (bits >= 8)
+			{
+				bits -= 8;
+				outBytes->push_back(static_cast<uint8>(accumulator >> bits));
+			}
+		}
+		return true;
+	}
+
+	struct GltfDocument
+	{
+		JsonValue root;
+		std::vector<std::vector<uint8>> buffers;
+	};
+
+	// External buffer uris are relative to the document.
+	static std::string GetDirectory(const char* filename)
+	{
+		std::string directory = filename;
+		size_t slash = directory.find_last_of("/\\");
+		return slash == std::string::npos ? std::string() : directory.substr(0, slash + 1);
+	}
+
+	static bool IsExternalUri(const JsonValue* uri)
+	{
+		return uri && uri->string.compare(0, 5, "data:") != 0;
+	}
+
+	static bool LoadGltfBuffers(const char* filename, const std::vector<uint8>& glbBinary, GltfDocument* document)
+	{
+		const JsonValue* buffers = document->root.Find("buffers");
+		if (!buffers)
+			return true;
+
+		std::string directory = GetDirectory(filename);
+
+		for (const JsonValue& buffer : buffers->array)
+		{
+			document->buffers.emplace_back();
+			std::vector<uint8>& bytes = document->buffers.back();
+
+			const JsonValue* uri = buffer.Find("uri");
+			if (!uri)
+			{
+				bytes = glbBinary;
+			}
+			else if (IsExternalUri(uri))
+			{
+				std::vector<char> data;
+				if (!LoadFileBytes((directory + uri->string).c_str(), &data))
+					return false;
+				bytes.assign(data.begin(), data.end() - 1);
+			}
+			else
+			{
+				size_t comma = uri->string.find(";base64,");
+				if (comma == std::string::npos || !DecodeBase64(uri->string.c_str() + comma + 8, &bytes))
+					return false;
+			}
+
+			if (bytes.size() < static_cast<size_t>(buffer.GetNumber("byteLength", 0.0)))
+				return false;
+		}
+		return true;
+	}
+
+	// Where an accessor's elements live in its buffer. data is nullptr for an
+	// accessor without a buffer view, whose elements are all zeros.
+	struct GltfAccessorView
+	{
+		const uint8* data = nullptr;
+		uint64 count = 0;
+		uint64 stride = 0;
+		uint32 componentType = 0;
+		uint32 componentSize = 0;
+		uint32 typeComponents = 0;
+		bool normalized = false;
+	};
+
+	static bool GetAccessorView(const GltfDocument& document, uint32 accessorIndex, GltfAccessorView* outView)
+	{
+		const JsonValue* accessors = document.root.Find("accessors");
+		const JsonValue* accessor = accessors ? accessors->At(accessorIndex) : nullptr;
+		if (!accessor)
+			return false;
+
+		GltfAccessorView& view = *outView;
+		view = {};
+
+		const JsonValue* type = accessor->Find("type");
+		if (type && type->string == "SCALAR") view.typeComponents = 1;
+		else if (type && type->string == "VEC2") view.typeComponents = 2;
+		else if (type && type->string == "VEC3") view.typeComponents = 3;
+		else if (type && type->string == "VEC4") view.typeComponents = 4;
+		if (view.typeComponents == 0)
+			return false;
+
+		view.componentType = static_cast<uint32>(accessor->GetNumber("componentType", 0.0));
+		switch (view.componentType)
+		{
+		case GLTF_COMPONENT_TYPE_BYTE:
+		case GLTF_COMPONENT_TYPE_UNSIGNED_BYTE: view.componentSize = 1; break;
+		case GLTF_COMPONENT_TYPE_SHORT:
+		case GLTF_COMPONENT_TYPE_UNSIGNED_SHORT: view.componentSize = 2; break;
+		case GLTF_COMPONENT_TYPE_UNSIGNED_INT:
+		case GLTF_COMPONENT_TYPE_FLOAT: view.componentSize = 4; break;
+		default: return false;
+		}
+
+		view.count = static_cast<uint64>(accessor->GetNumber("count", 0.0));
+		const JsonValue* normalizedValue = accessor->Find("normalized");
+		view.normalized = normalizedValue && normalizedValue->number != 0.0;
+
+		const JsonValue* bufferViewIndex = accessor->Find("bufferView");
+		if (!bufferViewIndex)
+			return true;
+
+		const JsonValue* bufferViews = document.root.Find("bufferViews");
+		const JsonValue* bufferView = bufferViews ? bufferViews->At(static_cast<size_t>(bufferViewIndex->number)) : nullptr;
+		if (!bufferView)
+			return false;
+
+		size_t bufferIndex = static_cast<size_t>(bufferView->GetNumber("buffer", 0.0));
+		if (bufferIndex >= document.buffers.size())
+			return false;
+
+		const std::vector<uint8>& buffer = document.buffers[bufferIndex];
+		uint64 elementSize = static_cast<uint64>(view.componentSize) * view.typeComponents;
+		view.stride = static_cast<uint64>(bufferView->GetNumber("byteStride", 0.0));
+		if (view.stride == 0)
+			view.stride = elementSize;
+
+		uint64 viewOffset = static_cast<uint64>(bufferView->GetNumber("byteOffset", 0.0));
+		uint64 viewLength = static_cast<uint64>(bufferView->GetNumber("byteLength", 0.0));
+		uint64 offset = static_cast<uint64>(accessor->GetNumber("byteOffset", 0.0));
+		if (viewOffset + viewLength > buffer.size() || (view.count && offset + (view.count - 1) * view.stride + elementSize > viewLength))
+			return false;
+
+		view.data = buffer.data() + viewOffset + offset;
+		return true;
+	}
+
+	// Reads an accessor into floats, componentsCount per element. Normalized
+	// integers are mapped to [0, 1] or [-1, 1] as the spec requires.
+	static bool ReadAccessor(const GltfDocument& document, uint32 accessorIndex, uint32 componentsCount, std::vector<float>* outValues)
+	{
+		GltfAccessorView view;
+		if (!GetAccessorView(document, accessorIndex, &view))
+			return false;
+
+		outValues->assign(view.count * componentsCount, 0.0f);
+		if (!view.data)
+			return true;
+
+		uint32 componentType = view.componentType;
+		bool normalized = view.normalized;
+		uint32 copyComponents = view.typeComponents < componentsCount ? view.typeComponents : componentsCount;
+		for (uint64 i = 0; i < view.count; i++)
+		{
+			const uint8* element = view.data + i * view.stride;
+			for (uint32 c = 0; c < copyComponents; c++)
+			{
+				const uint8* src = element + c * view.componentSize;
+				float value = 0.0f;
+				switch (componentType)
+				{
+				case GLTF_COMPONENT_TYPE_BYTE:
+				{
+					int8 v;
+					::memcpy(&v, src, sizeof(v));
+					value = normalized ? (v < -127 ? -1.0f : v / 127.0f) : v;
+					break;
+				}
+				case GLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+					value = normalized ? *src / 255.0f : *src;
+					break;
+				case GLTF_COMPONENT_TYPE_SHORT:
+				{
+					int16 v;
+					::memcpy(&v, src, sizeof(v));
+					value = normalized ? (v < -32767 ? -1.0f : v / 32767.0f) : v;
+					break;
+				}
+				case GLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+				{
+					uint16 v;
+					::memcpy(&v, src, sizeof(v));
+					value = normalized ? v / 65535.0f : v;
+					break;
+				}
+				case GLTF_COMPONENT_TYPE_UNSIGNED_INT:
+				{
+					uint32 v;
+					::memcpy(&v, src, sizeof(v));
+					value = static_cast<float>(v);
+					break;
+				}
+				case GLTF_COMPONENT_TYPE_FLOAT:
+					::memcpy(&value, src, sizeof(value));
+					break;
+				}
+				(*outValues)[i * componentsCount + c] = value;
+			}
+		}
+		return true;
+	}
+
+	// Index accessors are unsigned integer scalars; they are read as integers so
+	// indices past 2^24 survive.
+	static bool ReadIndices(const GltfDocument& document, uint32 accessorIndex, std::vector<Index>* outIndices)
+	{
+		GltfAccessorView view;
+		if (!GetAccessorView(document, accessorIndex, &view) || view.typeComponents != 1)
+			return false;
+
+		if (view.componentType != GLTF_COMPONENT_TYPE_UNSIGNED_BYTE &&
+			view.componentType != GLTF_COMPONENT_TYPE_UNSIGNED_SHORT &&
+			view.componentType != GLTF_COMPONENT_TYPE_UNSIGNED_INT)
+			return false;
+
+		outIndices->assign(view.count, 0);
+		if (!view.data)
+			return true;
+
+		for (uint64 i = 0; i < view.count; i++)
+		{
+			const uint8* src = view.data + i * view.stride;
+			switch (view.componentType)
+			{
+			case GLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+				(*outIndices)[i] = *src;
+				break;
+			case GLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			{
+				uint16 v;
+				::memcpy(&v, src, sizeof(v));
+				(*outIndices)[i] = v;
+				break;
+			}
+			case GLTF_COMPONENT_TYPE_UNSIGNED_INT:
+			{
+				uint32 v;
+				::memcpy(&v, src, sizeof(v));
+				(*outIndices)[i] = v;
+				break;
+			}
+			}
+		}
+		return true;
+	}
+
+	static bool AppendPrimitive(const GltfDocument& document, const JsonValue& primitive, std::vector<Vertex>* vertices, std::vector<Index>* indices)
+	{
+		if (static_cast<uint32>(primitive.GetNumber("mode", GLTF_MODE_TRIANGLES)) != GLTF_MODE_TRIANGLES)
+			return true;
+
+		const JsonValue* attributes = primitive.Find("attributes");
+		const JsonValue* position = attributes ? attributes->Find("POSITION") : nullptr;
+		if (!position)
+			return true;
+
+		std::vector<float> positions;
+		if (!ReadAccessor(document, static_cast<uint32>(position->number), 3, &positions))
+			return false;
+
+		size_t count = positions.size() / 3;
+
+		std::vector<float> texCoords;
+		const JsonValue* texCoord = attributes->Find("TEXCOORD_0");
+		if (texCoord && (!ReadAccessor(document, static_cast<uint32>(texCoord->number), 2, &texCoords) || texCoords.size() != count * 2))
+			return false;
+
+		// Three-component colors leave alpha at one.
+		std::vector<float> colors;
+		const JsonValue* color = attributes->Find("COLOR_0");
+		if (color)
+		{
+			std::vector<float> raw;
+			if (!ReadAccessor(document, static_cast<uint32>(color->number), 4, &raw) || raw.size() != count * 4)
+				return false;
+
+			const JsonValue* accessors = document.root.Find("accessors");
+			const JsonValue* accessor = accessors->At(static_cast<size_t>(color->number));
+			const JsonValue* type = accessor->Find("type");
+			if (type && type->string == "VEC3")
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					raw[i * 4 + 3] = 1.0f;
+				}
+			}
+			colors.swap(raw);
+		}
+
+		Index base = static_cast<Index>(vertices->size());
+		for (size_t i = 0; i < count; i++)
+		{
+			Vertex vertex = {};
+			vertex.posModel = Vector3(positions[i * 3], positions[i * 3 + 1], -positions[i * 3 + 2]);
+			vertex.color = colors.empty() ? Vector4(1.0f, 1.0f, 1.0f, 1.0f) : Vector4(colors[i * 4], colors[i * 4 + 1], colors[i * 4 + 2], colors[i * 4 + 3]);
+			vertex.texCoord = texCoords.empty() ? Vector2(0.0f, 0.0f) : Vector2(texCoords[i * 2], texCoords[i * 2 + 1]);
+			vertices->push_back(vertex);
+		}
+
+		std::vector<Index> primitiveIndices;
+		const JsonValue* indicesAccessor = primitive.Find("indices");
+		if (indicesAccessor)
+		{
+			if (!ReadIndices(document, static_cast<uint32>(indicesAccessor->number), &primitiveIndices))
+				return false;
+		}
+		else
+		{
+			primitiveIndices.resize(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				primitiveIndices[i] = static_cast<Index>(i);
+			}
+		}
+
+		// Like OBJ, the z mirror already flips glTF's counter-clockwise winding.
+		size_t trianglesCount = primitiveIndices.size() / 3;
+		for (size_t i = 0; i < trianglesCount * 3; i++)
+		{
+			if (primitiveIndices[i] >= count)
+				return false;
+			indices->push_back(base + primitiveIndices[i]);
+		}
+		return true;
+	}
+
+	// Parses the JSON of a .gltf, or of a .glb along with its binary chunk.
+	static bool ParseGltf(const char* filename, GltfDocument* outDocument, std::vector<uint8>* outGlbBinary)
+	{
+		std::vector<char> data;
+		if (!LoadFileBytes(filename, &data))
+			return false;
+
+		// ReadFile appends a terminator that is not part of the file.
+		size_t size = data.size() - 1;
+
+		std::string json;
+
+		uint32 magic = 0;
+		if (size >= 12)
+			::memcpy(&magic, data.data(), sizeof(magic));
+
+		if (magic == GLB_MAGIC)
+		{
+			size_t offset = 12;
+			while (offset + 8 <= size)
+			{
+				uint32 chunkHeader[2];
+				::memcpy(chunkHeader, data.data() + offset, sizeof(chunkHeader));
+				offset += 8;
+
+				uint32 chunkLength = chunkHeader[0];
+				if (offset + chunkLength > size)
+					break;
+
+				if (chunkHeader[1] == GLB_CHUNK_JSON)
+					json.assign(data.data() + offset, chunkLength);
+				else if (chunkHeader[1] == GLB_CHUNK_BIN && outGlbBinary->empty())
+					outGlbBinary->assign(data.data() + offset, data.data() + offset + chunkLength);
+
+				offset += (chunkLength + 3) & ~3u;
+			}
+		}
+		else
+		{
+			json.assign(data.data(), size);
+		}
+
+		JsonParser parser(json.c_str());
+		if (json.empty() || !parser.Parse(&outDocument->root) || outDocument->root.type != JsonValue::TYPE_OBJECT)
+		{
+			::fprintf(stderr, "%s: malformed glTF document\n", filename);
+			return false;
+		}
+		return true;
+	}
+
+	bool LoadGltf(const char* filename, MeshData* outMeshData)
+	{
+		GltfDocument document;
+		std::vector<uint8> glbBinary;
+		if (!ParseGltf(filename, &document, &glbBinary))
+			return false;
+
+		if (!LoadGltfBuffers(filename, glbBinary, &document))
+		{
+			::fprintf(stderr, "%s: failed to load buffers\n", filename);
+			return false;
+		}
+
+		std::vector<Vertex> vertices;
+		std::vector<Index> indices;
+
+		const JsonValue* meshes = document.root.Find("meshes");
+		if (meshes)
+		{
+			for (const JsonValue& mesh : meshes->array)
+			{
+				const JsonValue* primitives = mesh.Find("primitives");
+				if (!primitives)
+					continue;
+
+				for (const JsonValue& primitive : primitives->array)
+				{
+					if (!AppendPrimitive(document, primitive, &vertices, &indices))
+					{
+						::fprintf(stderr, "%s: invalid primitive\n", filename);
+						return false;
+					}
+				}
+			}
+		}
+
+		if (indices.empty())
+		{
+			::fprintf(stderr, "%s: no triangle primitives\n", filename);
+			return false;
+		}
+
+		StoreMeshData(vertices, indices, outMeshData);
+		return true;
+	}
+
+	/*
+	==================
+	MeshImporter
+	==================
+	*/
+
+	bool Load(const char* filename, MeshData* outMeshData)
+	{
+		const char* extension = GetExtension(filename);
+		if (EqualsNoCase(extension, "obj"))
+			return LoadObj(filename, outMeshData);
+		if (EqualsNoCase(extension, "gltf") || EqualsNoCase(extension, "glb"))
+			return LoadGltf(filename, outMeshData);
+
+		::fprintf(stderr, "%s: unsupported format\n", filename);
+		return false;
+	}
+
+	bool HashDependencies(const char* filename, uint64* key)
+	{
+		const char* extension = GetExtension(filename);
+		if (!EqualsNoCase(extension, "gltf") && !EqualsNoCase(extension, "glb"))
+			return true;
+
+		GltfDocument document;
+		std::vector<uint8> glbBinary;
+		if (!ParseGltf(filename, &document, &glbBinary))
+			return false;
+
+		const JsonValue* buffers = document.root.Find("buffers");
+		if (!buffers)
+			return true;
+
+		std::string directory = GetDirectory(filename);
+		for (const JsonValue& buffer : buffers->array)
+		{
+			const JsonValue* uri = buffer.Find("uri");
+			if (!IsExternalUri(uri))
+				continue;
+
+			FileMapping mapping = {};
+			if (!FileSystem::MapFile((directory + uri->string).c_str(), &mapping))
+				return false;
+
+			*key = HashString(uri->string.c_str(), *key);
+			*key = HashBytes(mapping.data, mapping.size, *key);
+
+			FileSystem::UnmapFile(&mapping);
+		}
+		return true;
+	}
+
+	bool IsSupported(const char* filename)
+	{
+		const char* extension = GetExtension(filename);
+		return EqualsNoCase(extension, "obj") || EqualsNoCase(extension, "gltf") || EqualsNoCase(extension, "glb");
+	}
+
+	void Destroy(MeshData* meshData)
+	{
+		if (meshData->vertices)
+		{
+			delete[] meshData->vertices;
+			meshData->vertices = nullptr;
+		}
+
+		if (meshData->indices)
+		{
+			delete[] meshData->indices;
+			meshData->indices = nullptr;
+		}
+
+		*meshData = {};
+	}
+}
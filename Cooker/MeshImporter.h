@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../Common/Types.h"
+#include "../Common/Vertex.h"
+
+/*
+==============
+MeshImporter
+==============
+*/
+
+// Source formats are converted to the engine's conventions on load:
+// left-handed (z negated), clockwise front faces, texcoord origin top-left.
+// The returned MeshData is allocated with new[]; free it with Destroy.
+namespace MeshImporter
+{
+	// Wavefront OBJ: v (with optional vertex colors), vt and f. Polygons are fan triangulated.
+	bool LoadObj(const char* filename, MeshData* outMeshData);
+
+	// glTF 2.0 (.gltf with external or embedded buffers, or .glb). All triangle
+	// primitives of all meshes are merged; node transforms are ignored.
+	bool LoadGltf(const char* filename, MeshData* outMeshData);
+
+	// Dispatches on the file extension.
+	bool Load(const char* filename, MeshData* outMeshData);
+	bool IsSupported(const char* filename);
+
+	// Folds the files a source references, such as glTF buffers stored next to
+	// the document, into key. Returns false when one of them cannot be read.
+	bool HashDependencies(const char* filename, uint64* key);
+
+	void Destroy(MeshData* meshData);
+}
@@ -0,0 +1,351 @@
+#include "Benchmark.h"
+
+#include "../Common/Platform.h"
+#include "../Common/Profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/*
+===============
+Benchmark State
+===============
+*/
+
+static double GetRealSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// CPU time of the calling thread, as Google Benchmark reports by default.
+static double GetCpuSeconds()
+{
+	return Platform::GetThreadCpuSeconds();
+}
+
+BenchmarkState::BenchmarkState(uint64 iterations, uint32 arg)
+{
+	m_iterations = iterations;
+	m_remaining = iterations;
+	m_arg = arg;
+}
+
+bool BenchmarkState::KeepRunning()
+{
+	if (!m_started)
+	{
+		m_started = true;
+		ResumeTiming();
+	}
+
+	if (m_remaining > 0)
+	{
+		m_remaining--;
+		return true;
+	}
+
+	PauseTiming();
+	return false;
+}
+
+void BenchmarkState::PauseTiming()
+{
+	if (!m_running)
+		return;
+
+	m_realSeconds += ::GetRealSeconds() - m_realStart;
+	m_cpuSeconds += ::GetCpuSeconds() - m_cpuStart;
+	m_running = false;
+}
+
+void BenchmarkState::ResumeTiming()
+{
+	if (m_running)
+		return;
+
+	m_running = true;
+	m_cpuStart = ::GetCpuSeconds();
+	m_realStart = ::GetRealSeconds();
+}
+
+/*
+=========
+Benchmark
+=========
+*/
+
+namespace Benchmark
+{
+	static const uint64 MAX_ITERATIONS = 1000000000;
+	static const double DEFAULT_MIN_TIME = 0.5;
+
+	// Results are only comparable between runs of the same build profile, so
+	// it goes in the output. The CMake build names the profile, such as
+	// "release-lto" or "pgo-use"; see CMakeLists.txt.
+#if defined(XFREE_BUILD_PROFILE)
+	static const char* BUILD_PROFILE = XFREE_BUILD_PROFILE;
+#else
+	static const char* BUILD_PROFILE = "default";
+#endif
+
+	struct Entry
+	{
+		std::string name;
+		BenchmarkFunc func = nullptr;
+		uint32 arg = 0;
+	};
+
+	struct Result
+	{
+		const Entry* entry = nullptr;
+		uint64 iterations = 0;
+		double realNanoseconds = 0.0;	// Per iteration.
+		double cpuNanoseconds = 0.0;
+		double itemsPerSecond = 0.0;
+		double bytesPerSecond = 0.0;
+		const char* error = nullptr;
+	};
+
+	static std::vector<Entry> s_entries;
+
+	void Register(const char* name, BenchmarkFunc func, uint32 arg)
+	{
+		Entry entry;
+		entry.name = name;
+		if (arg)
+			entry.name += "/" + std::to_string(arg);
+		entry.func = func;
+		entry.arg = arg;
+		s_entries.push_back(entry);
+	}
+
+	static void PrintUsage()
+	{
+		::printf("Usage: Test [--benchmark_filter=<text>] [--benchmark_min_time=<seconds>] [--benchmark_out=<file>] [--benchmark_list_tests]\n");
+	}
+
+	static const char* GetFlagValue(const char* arg, const char* flag)
+	{
+		size_t length = ::strlen(flag);
+		if (::strncmp(arg, flag, length) != 0 || arg[length] != '=')
+			return nullptr;
+		return arg + length + 1;
+	}
+
+	// Grows the iteration count the way Google Benchmark does until one run
+	// takes at least minTime, so the reported run is the only one that counts.
+	static Result Run(const Entry& entry, double minTime)
+	{
+		Result result;
+		result.entry = &entry;
+
+		uint64 iterations = 1;
+		while (true)
+		{
+			BenchmarkState state(iterations, entry.arg);
+			entry.func(state);
+
+			if (state.GetError())
+			{
+				result.error = state.GetError();
+				return result;
+			}
+
+			double seconds = state.GetRealSeconds();
+			if (seconds >= minTime || iterations >= MAX_ITERATIONS)
+			{
+				result.iterations = iterations;
+				result.realNanoseconds = seconds * 1e9 / static_cast<double>(iterations);
+				result.cpuNanoseconds = state.GetCpuSeconds() * 1e9 / static_cast<double>(iterations);
+				if (seconds > 0.0)
+				{
+					result.itemsPerSecond = static_cast<double>(state.GetItemsProcessed()) / seconds;
+					result.bytesPerSecond = static_cast<double>(state.GetBytesProcessed()) / seconds;
+				}
+				return result;
+			}
+
+			// Short runs are too noisy to extrapolate from; grow tenfold instead.
+			double multiplier = minTime * 1.4 / (seconds > 1e-9 ? seconds : 1e-9);
+			multiplier = seconds / minTime > 0.1 ? multiplier : 10.0;
+
+			double next = static_cast<double>(iterations) * multiplier;
+			uint64 nextIterations = next < static_cast<double>(MAX_ITERATIONS) ? static_cast<uint64>(next) : MAX_ITERATIONS;
+			iterations = nextIterations > iterations ? nextIterations : iterations + 1;
+		}
+	}
+
+	static void PrintResult(const Result& result)
+	{
+		if (result.error)
+		{
+			::printf("%-56s ERROR: %s\n", result.entry->name.c_str(), result.error);
+			return;
+		}
+
+		::printf("%-56s %13.0f ns %13.0f ns %12llu", result.entry->name.c_str(), result.realNanoseconds, result.cpuNanoseconds, static_cast<unsigned long long>(result.iterations));
+		if (result.bytesPerSecond > 0.0)
+			::printf(" bytes_per_second=%.4gM/s", result.bytesPerSecond / (1024.0 * 1024.0));
+		if (result.itemsPerSecond > 0.0)
+			::printf(" items_per_second=%.4gM/s", result.itemsPerSecond * 1e-6);
+		::printf("\n");
+		::fflush(stdout);
+	}
+
+	static void WriteEscaped(FILE* file, const char* text)
+	{
+		for (; *text; text++)
+		{
+			if (*text == '"' || *text == '\\')
+				fputc('\\', file);
+			fputc(*text, file);
+		}
+	}
+
+	static bool WriteJson(const char* filename, const char* executable, const std::vector<Result>& results)
+	{
+		FILE* file = Platform::OpenFile(filename, "wb");
+		if (file == nullptr)
+			return false;
+
+		char date[64] = {};
+		time_t now = time(nullptr);
+		tm localTime = {};
+#if defined(_WIN32)
+		localtime_s(&localTime, &now);
+#else
+		localtime_r(&now, &localTime);
+#endif
+		strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &localTime);
+
+		char hostName[256] = {};
+		Platform::GetHostName(hostName, sizeof(hostName));
+
+#if defined(NDEBUG)
+		const char* buildType = "release";
+#else
+		const char* buildType = "debug";
+#endif
+
+		fprintf(file, "{\n  \"context\": {\n");
+		fprintf(file, "    \"date\": \"%s\",\n", date);
+		fprintf(file, "    \"host_name\": \"");
+		WriteEscaped(file, hostName);
+		fprintf(file, "\",\n    \"executable\": \"");
+		WriteEscaped(file, executable);
+		fprintf(file, "\",\n");
+		fprintf(file, "    \"num_cpus\": %u,\n", Platform::GetHardwareThreadsCount());
+		fprintf(file, "    \"mhz_per_cpu\": 0,\n");
+		fprintf(file, "    \"cpu_scaling_enabled\": false,\n");
+		fprintf(file, "    \"caches\": [],\n");
+		fprintf(file, "    \"library_build_type\": \"%s\",\n", buildType);
+		fprintf(file, "    \"build_profile\": \"%s\",\n", BUILD_PROFILE);
+		fprintf(file, "    \"instruction_set\": \"%s\",\n", Platform::GetInstructionSetName());
+		fprintf(file, "    \"profiler\": %s\n", PROFILER_ENABLED ? "true" : "false");
+		fprintf(file, "  },\n  \"benchmarks\": [");
+
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& result = results[i];
+			fprintf(file, "%s\n    {\n      \"name\": \"", i ? "," : "");
+			WriteEscaped(file, result.entry->name.c_str());
+			fprintf(file, "\",\n      \"family_index\": %zu,\n", i);
+			fprintf(file, "      \"per_family_instance_index\": 0,\n");
+			fprintf(file, "      \"run_name\": \"");
+			WriteEscaped(file, result.entry->name.c_str());
+			fprintf(file, "\",\n      \"run_type\": \"iteration\",\n");
+			fprintf(file, "      \"repetitions\": 1,\n");
+			fprintf(file, "      \"repetition_index\": 0,\n");
+			fprintf(file, "      \"threads\": 1,\n");
+
+			if (result.error)
+			{
+				fprintf(file, "      \"error_occurred\": true,\n      \"error_message\": \"");
+				WriteEscaped(file, result.error);
+				fprintf(file, "\"\n    }");
+				continue;
+			}
+
+			fprintf(file, "      \"iterations\": %llu,\n", static_cast<unsigned long long>(result.iterations));
+			fprintf(file, "      \"real_time\": %.6e,\n", result.realNanoseconds);
+			fprintf(file, "      \"cpu_time\": %.6e,\n", result.cpuNanoseconds);
+			fprintf(file, "      \"time_unit\": \"ns\"");
+			if (result.bytesPerSecond > 0.0)
+				fprintf(file, ",\n      \"bytes_per_second\": %.6e", result.bytesPerSecond);
+			if (result.itemsPerSecond > 0.0)
+				fprintf(file, ",\n      \"items_per_second\": %.6e", result.itemsPerSecond);
+			fprintf(file, "\n    }");
+		}
+
+		fprintf(file, "\n  ]\n}\n");
+		bool succeeded = ferror(file) == 0;
+		fclose(file);
+		return succeeded;
+	}
+
+	int RunAll(int argc, char* argv[])
+	{
+		const char* filter = "";
+		const char* outFilename = nullptr;
+		double minTime = DEFAULT_MIN_TIME;
+		bool listTests = false;
+
+		for (int i = 1; i < argc; i++)
+		{
+			const char* value = nullptr;
+			if ((value = GetFlagValue(argv[i], "--benchmark_filter")))
+				filter = value;
+			else if ((value = GetFlagValue(argv[i], "--benchmark_out")))
+				outFilename = value;
+			else if ((value = GetFlagValue(argv[i], "--benchmark_min_time")))
+				minTime = ::atof(value);
+			else if (::strcmp(argv[i], "--benchmark_list_tests") == 0)
+				listTests = true;
+			else
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+
+		if (listTests)
+		{
+			for (const Entry& entry : s_entries)
+			{
+				if (entry.name.find(filter) != std::string::npos)
+					::printf("%s\n", entry.name.c_str());
+			}
+			return 0;
+		}
+
+		::printf("Build profile %s, %s, profiler %s\n", BUILD_PROFILE, Platform::GetInstructionSetName(), PROFILER_ENABLED ? "on" : "off");
+		::printf("%-56s %16s %16s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+		::printf("%s\n", std::string(103, '-').c_str());
+
+		std::vector<Result> results;
+		bool failed = false;
+		for (const Entry& entry : s_entries)
+		{
+			if (entry.name.find(filter) == std::string::npos)
+				continue;
+
+			Result result = Run(entry, minTime);
+			PrintResult(result);
+			failed |= result.error != nullptr;
+			results.push_back(result);
+		}
+
+		if (outFilename && !WriteJson(outFilename, argc > 0 ? argv[0] : "", results))
+		{
+			::printf("Failed to write %s\n", outFilename);
+			return 1;
+		}
+
+		return failed ? 1 : 0;
+	}
+}
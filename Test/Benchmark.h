@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../Common/Types.h"
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+/*
+===============
+Benchmark State
+===============
+*/
+
+// Passed to every benchmark, which times its work in a loop:
+//
+//	while (state.KeepRunning())
+//	{
+//		...
+//	}
+//
+// The runner calls the benchmark again with more iterations until the loop
+// takes at least the minimum time, then reports the time per iteration.
+class BenchmarkState
+{
+public:
+	BenchmarkState(uint64 iterations, uint32 arg);
+
+	bool KeepRunning();
+
+	// Excludes per-iteration setup, such as restoring an input the benchmark
+	// modifies, from the timings. Both cost a clock read, so keep the timed
+	// work much longer than that.
+	void PauseTiming();
+	void ResumeTiming();
+
+	inline uint32 GetArg() const { return m_arg; }
+	inline uint64 GetIterations() const { return m_iterations; }
+
+	// Totals over every iteration, reported as per-second rates.
+	inline void SetItemsProcessed(uint64 items) { m_itemsProcessed = items; }
+	inline void SetBytesProcessed(uint64 bytes) { m_bytesProcessed = bytes; }
+
+	// The benchmark must return right after; it is reported as failed.
+	inline void SkipWithError(const char* message) { m_error = message; }
+
+	inline double GetRealSeconds() const { return m_realSeconds; }
+	inline double GetCpuSeconds() const { return m_cpuSeconds; }
+	inline uint64 GetItemsProcessed() const { return m_itemsProcessed; }
+	inline uint64 GetBytesProcessed() const { return m_bytesProcessed; }
+	inline const char* GetError() const { return m_error; }
+
+private:
+	uint64 m_iterations = 0;
+	uint64 m_remaining = 0;
+	uint32 m_arg = 0;
+	bool m_started = false;
+	bool m_running = false;
+
+	double m_realStart = 0.0;
+	double m_cpuStart = 0.0;
+	double m_realSeconds = 0.0;
+	double m_cpuSeconds = 0.0;
+
+	uint64 m_itemsProcessed = 0;
+	uint64 m_bytesProcessed = 0;
+	const char* m_error = nullptr;
+};
+
+typedef void (*BenchmarkFunc)(BenchmarkState& state);
+
+/*
+=========
+Benchmark
+=========
+*/
+
+// A small stand-in for Google Benchmark with the same command line flags and
+// JSON output, so its compare.py and CI dashboards can read our results:
+//
+//	--benchmark_filter=<text>	Only run benchmarks whose name contains text.
+//	--benchmark_min_time=<s>	Minimum time per benchmark (default 0.5).
+//	--benchmark_out=<file>		Also write the results as JSON.
+//	--benchmark_list_tests		Print the names and exit.
+namespace Benchmark
+{
+	// name must outlive the run. A non-zero arg is appended as "name/arg" and
+	// passed through BenchmarkState::GetArg.
+	void Register(const char* name, BenchmarkFunc func, uint32 arg = 0);
+
+	// Returns the process exit code: non-zero on bad flags or failed benchmarks.
+	int RunAll(int argc, char* argv[]);
+
+	// Keeps the compiler from discarding a result that is otherwise unused.
+	template <typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+#if defined(_MSC_VER)
+		const volatile void* sink = &value;
+		(void)sink;
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "r"(&value) : "memory");
+#endif
+	}
+}
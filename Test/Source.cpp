@@ -0,0 +1,1401 @@
+#include "Benchmark.h"
+#include "UnitTest.h"
+#include "../Common/BCEncoder.h"
+#include "../Common/DDSFile.h"
+#include "../Common/GeometryGenerator.h"
+#include "../Common/Hash.h"
+#include "../Common/ImageFile.h"
+#include "../Common/MeshletBuilder.h"
+#include "../Common/MeshOptimizer.h"
+#include "../Common/MeshSimplifier.h"
+#include "../Common/MipGenerator.h"
+#include "../Common/PipelineCompileQueue.h"
+#include "../Common/Platform.h"
+#include "../Common/Profiler.h"
+#include "../Common/RHINull.h"
+#include "../Common/RHISoftware.h"
+#include "../Common/ShaderConstants.h"
+#include "../Common/TextureStreamer.h"
+#include "../Common/VirtualTexturePageTable.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+/*
+==============
+Inputs
+==============
+*/
+
+// Fixed seeds, so every run and every commit measures the same input.
+static uint32 NextRandom(uint32* state)
+{
+	uint32 x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+static void FreeMeshData(MeshData* meshData)
+{
+	delete[] meshData->vertices;
+	delete[] meshData->indices;
+	*meshData = {};
+}
+
+static MeshData CopyMeshData(const MeshData& meshData)
+{
+	MeshData copy = meshData;
+	copy.vertices = new Vertex[meshData.verticesCount];
+	copy.indices = new Index[meshData.indicesCount];
+	::memcpy(copy.vertices, meshData.vertices, sizeof(Vertex) * meshData.verticesCount);
+	::memcpy(copy.indices, meshData.indices, sizeof(Index) * meshData.indicesCount);
+	return copy;
+}
+
+// A sphere with arg slices, the densest mesh GeometryGenerator makes.
+static MeshData MakeSphere(uint32 slices)
+{
+	return GeometryGenerator::MakeSphere(1.0f, slices, slices / 2);
+}
+
+// Triangles in random order, like an unoptimized mesh straight from an importer.
+static MeshData MakeShuffledSphere(uint32 slices)
+{
+	MeshData meshData = MakeSphere(slices);
+
+	uint32 seed = 0x9e3779b9;
+	uint32 trianglesCount = meshData.indicesCount / 3;
+	for (uint32 i = trianglesCount - 1; i > 0; i--)
+	{
+		uint32 j = NextRandom(&seed) % (i + 1);
+		for (uint32 k = 0; k < 3; k++)
+		{
+			Index index = meshData.indices[i * 3 + k];
+			meshData.indices[i * 3 + k] = meshData.indices[j * 3 + k];
+			meshData.indices[j * 3 + k] = index;
+		}
+	}
+
+	return meshData;
+}
+
+static uint8* MakeNoiseImage(uint32 width, uint32 height)
+{
+	// Smooth gradients with a little noise compress like real albedo maps.
+	uint8* pixels = new uint8[width * height * 4];
+	uint32 seed = 0x2545f491;
+	for (uint32 y = 0; y < height; y++)
+	{
+		for (uint32 x = 0; x < width; x++)
+		{
+			uint8* pixel = pixels + (y * width + x) * 4;
+			uint32 noise = NextRandom(&seed) & 31;
+			pixel[0] = static_cast<uint8>((x * 255 / width + noise) & 0xff);
+			pixel[1] = static_cast<uint8>((y * 255 / height + noise) & 0xff);
+			pixel[2] = static_cast<uint8>(((x + y) * 127 / width + noise) & 0xff);
+			pixel[3] = 255;
+		}
+	}
+	return pixels;
+}
+
+/*
+==============
+Geometry
+==============
+*/
+
+static void BM_MakeSphere(BenchmarkState& state)
+{
+	uint32 trianglesCount = 0;
+	while (state.KeepRunning())
+	{
+		MeshData meshData = MakeSphere(state.GetArg());
+		Benchmark::DoNotOptimize(meshData.indices[0]);
+		trianglesCount = meshData.indicesCount / 3;
+		FreeMeshData(&meshData);
+	}
+	state.SetItemsProcessed(state.GetIterations() * trianglesCount);
+}
+
+/*
+==============
+Mesh Optimization
+==============
+*/
+
+static void BM_OptimizeVertexCache(BenchmarkState& state)
+{
+	MeshData source = MakeShuffledSphere(state.GetArg());
+	Index* indices = new Index[source.indicesCount];
+
+	while (state.KeepRunning())
+	{
+		state.PauseTiming();
+		::memcpy(indices, source.indices, sizeof(Index) * source.indicesCount);
+		state.ResumeTiming();
+
+		MeshOptimizer::OptimizeVertexCache(indices, source.indicesCount, source.verticesCount);
+		Benchmark::DoNotOptimize(indices[0]);
+	}
+	state.SetItemsProcessed(state.GetIterations() * (source.indicesCount / 3));
+
+	delete[] indices;
+	FreeMeshData(&source);
+}
+
+static void BM_AnalyzeVertexCache(BenchmarkState& state)
+{
+	MeshData source = MakeShuffledSphere(state.GetArg());
+
+	while (state.KeepRunning())
+	{
+		float acmr = MeshOptimizer::AnalyzeVertexCache(source.indices, source.indicesCount, source.verticesCount);
+		Benchmark::DoNotOptimize(acmr);
+	}
+	state.SetItemsProcessed(state.GetIterations() * (source.indicesCount / 3));
+
+	FreeMeshData(&source);
+}
+
+// The cooker's whole pass: quantize, weld, reorder for the cache and for fetch.
+static void BM_OptimizeMesh(BenchmarkState& state)
+{
+	MeshData source = MakeShuffledSphere(state.GetArg());
+
+	while (state.KeepRunning())
+	{
+		state.PauseTiming();
+		MeshData meshData = CopyMeshData(source);
+		state.ResumeTiming();
+
+		MeshOptimizer::QuantizeVertices(&meshData);
+		MeshOptimizer::WeldVertices(&meshData);
+		MeshOptimizer::OptimizeVertexCache(meshData.indices, meshData.indicesCount, meshData.verticesCount);
+		MeshOptimizer::OptimizeVertexFetch(&meshData);
+		Benchmark::DoNotOptimize(meshData.indices[0]);
+
+		state.PauseTiming();
+		FreeMeshData(&meshData);
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.GetIterations() * (source.indicesCount / 3));
+
+	FreeMeshData(&source);
+}
+
+static void BM_BuildLodChain(BenchmarkState& state)
+{
+	MeshData meshData = MakeSphere(state.GetArg());
+
+	while (state.KeepRunning())
+	{
+		MeshLodChain lodChain = {};
+		if (!MeshSimplifier::BuildLodChain(meshData, &lodChain))
+		{
+			state.SkipWithError("BuildLodChain failed");
+			break;
+		}
+		Benchmark::DoNotOptimize(lodChain.lodsCount);
+		MeshSimplifier::Destroy(&lodChain);
+	}
+	state.SetItemsProcessed(state.GetIterations() * (meshData.indicesCount / 3));
+
+	FreeMeshData(&meshData);
+}
+
+static void BM_BuildMeshlets(BenchmarkState& state)
+{
+	MeshData meshData = MakeSphere(state.GetArg());
+
+	while (state.KeepRunning())
+	{
+		MeshletData meshletData = {};
+		if (!MeshletBuilder::Build(meshData, &meshletData))
+		{
+			state.SkipWithError("MeshletBuilder::Build failed");
+			break;
+		}
+		Benchmark::DoNotOptimize(meshletData.meshletsCount);
+		MeshletBuilder::Destroy(&meshletData);
+	}
+	state.SetItemsProcessed(state.GetIterations() * (meshData.indicesCount / 3));
+
+	FreeMeshData(&meshData);
+}
+
+/*
+==============
+Culling and Transforms
+==============
+*/
+
+// The renderer's camera: at the origin looking down +z.
+static Matrix MakeViewProj()
+{
+	Matrix view = DirectX::XMMatrixLookToLH(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 1.0f, 0.0f));
+	Matrix proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(70.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	return view * proj;
+}
+
+// What D3D12Mesh::Update does per mesh at LOD 0: frustum and cone tests for
+// every meshlet of a sphere that is partly off screen.
+static void BM_CullMeshlets(BenchmarkState& state)
+{
+	MeshData meshData = MakeSphere(state.GetArg());
+	MeshletData meshletData = {};
+	if (!MeshletBuilder::Build(meshData, &meshletData))
+	{
+		state.SkipWithError("MeshletBuilder::Build failed");
+		FreeMeshData(&meshData);
+		return;
+	}
+
+	Matrix world = Matrix::CreateScale(2.0f) * Matrix::CreateTranslation(1.5f, 0.0f, 3.0f);
+	Vector3 cameraPosModel = Vector3::Transform(Vector3(0.0f, 0.0f, 0.0f), world.Invert());
+	Matrix worldViewProj = world * MakeViewProj();
+
+	while (state.KeepRunning())
+	{
+		Vector4 planes[6];
+		MeshletCulling::ExtractFrustumPlanes(worldViewProj, planes);
+
+		uint32 visibleCount = 0;
+		for (uint32 i = 0; i < meshletData.meshletsCount; i++)
+		{
+			visibleCount += MeshletCulling::IsVisible(meshletData.bounds[i], planes, cameraPosModel) ? 1 : 0;
+		}
+		Benchmark::DoNotOptimize(visibleCount);
+	}
+	state.SetItemsProcessed(state.GetIterations() * meshletData.meshletsCount);
+
+	MeshletBuilder::Destroy(&meshletData);
+	FreeMeshData(&meshData);
+}
+
+// Per object what a frame costs on the CPU before recording: the world matrix,
+// the culling matrices and the transposed copy written to the draw constants.
+static void BM_UpdateTransforms(BenchmarkState& state)
+{
+	uint32 objectsCount = state.GetArg();
+	Vector3* positions = new Vector3[objectsCount];
+	Matrix* worldConstants = new Matrix[objectsCount];
+	Vector3* cameraPositions = new Vector3[objectsCount];
+
+	uint32 seed = 0x68e31da4;
+	for (uint32 i = 0; i < objectsCount; i++)
+	{
+		positions[i] = Vector3(static_cast<float>(NextRandom(&seed) % 200) * 0.1f - 10.0f, 0.0f, static_cast<float>(NextRandom(&seed) % 100) * 0.1f + 2.0f);
+	}
+
+	Matrix viewProj = MakeViewProj();
+	float angle = 0.0f;
+	while (state.KeepRunning())
+	{
+		angle += 0.01f;
+		for (uint32 i = 0; i < objectsCount; i++)
+		{
+			Matrix world = Matrix::CreateScale(0.5f) * Matrix::CreateRotationY(angle) * Matrix::CreateTranslation(positions[i]);
+			Matrix worldViewProj = world * viewProj;
+			cameraPositions[i] = Vector3::Transform(Vector3(0.0f, 0.0f, 0.0f), world.Invert());
+			worldConstants[i] = world.Transpose();
+			Benchmark::DoNotOptimize(worldViewProj);
+		}
+		Benchmark::DoNotOptimize(worldConstants[0]);
+		Benchmark::DoNotOptimize(cameraPositions[0]);
+	}
+	state.SetItemsProcessed(state.GetIterations() * objectsCount);
+
+	delete[] cameraPositions;
+	delete[] worldConstants;
+	delete[] positions;
+}
+
+/*
+==============
+RHI
+==============
+*/
+
+// A whole frame on the null device: target barriers and clears, then per
+// object the transform, LOD selection, constants and draw, then submit and
+// wait. Nothing is rasterized, so this is the renderer's CPU cost per frame.
+static void BM_NullFrame(BenchmarkState& state)
+{
+	const uint32 width = 1280;
+	const uint32 height = 720;
+	uint32 objectsCount = state.GetArg();
+
+	MeshData meshData = MakeSphere(32);
+	MeshLodChain lodChain = {};
+	if (!MeshSimplifier::BuildLodChain(meshData, &lodChain))
+	{
+		state.SkipWithError("BuildLodChain failed");
+		FreeMeshData(&meshData);
+		return;
+	}
+
+	NullRHIDevice device;
+
+	RHIBufferDesc vertexBufferDesc;
+	vertexBufferDesc.usage = RHI_BUFFER_USAGE_VERTEX;
+	vertexBufferDesc.size = sizeof(Vertex) * meshData.verticesCount;
+	vertexBufferDesc.stride = sizeof(Vertex);
+	RHIBuffer* vertexBuffer = device.CreateBuffer(vertexBufferDesc, meshData.vertices);
+
+	RHIBufferDesc indexBufferDesc;
+	indexBufferDesc.usage = RHI_BUFFER_USAGE_INDEX;
+	indexBufferDesc.size = sizeof(Index) * lodChain.indicesCount;
+	indexBufferDesc.stride = sizeof(Index);
+	RHIBuffer* indexBuffer = device.CreateBuffer(indexBufferDesc, lodChain.indices);
+
+	RHITextureDesc colorDesc;
+	colorDesc.width = width;
+	colorDesc.height = height;
+	colorDesc.usage = RHI_TEXTURE_USAGE_RENDER_TARGET | RHI_TEXTURE_USAGE_SHADER_RESOURCE;
+	RHITexture* colorTarget = device.CreateTexture(colorDesc, nullptr, 0);
+
+	RHITextureDesc depthDesc;
+	depthDesc.width = width;
+	depthDesc.height = height;
+	depthDesc.format = RHI_FORMAT_D24_UNORM_S8_UINT;
+	depthDesc.usage = RHI_TEXTURE_USAGE_DEPTH_STENCIL;
+	RHITexture* depthTarget = device.CreateTexture(depthDesc, nullptr, 0);
+
+	RHIPipeline* pipeline = device.CreatePipeline(RHIPipelineDesc());
+	RHICommandList* commandList = device.CreateCommandList();
+
+	Vector3* positions = new Vector3[objectsCount];
+	uint32 seed = 0x3c6ef372;
+	for (uint32 i = 0; i < objectsCount; i++)
+	{
+		positions[i] = Vector3(static_cast<float>(NextRandom(&seed) % 200) * 0.1f - 10.0f, 0.0f, static_cast<float>(NextRandom(&seed) % 400) * 0.1f + 2.0f);
+	}
+
+	Matrix view = DirectX::XMMatrixLookToLH(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 1.0f, 0.0f));
+	Matrix proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(70.0f), static_cast<float>(width) / static_cast<float>(height), 0.1f, 100.0f);
+
+	FrameConstants frameConstants;
+	frameConstants.view = view.Transpose();
+	frameConstants.proj = proj.Transpose();
+
+	const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+	float angle = 0.0f;
+	while (state.KeepRunning())
+	{
+		angle += 0.01f;
+
+		commandList->Begin();
+		commandList->TextureBarrier(colorTarget, RHI_RESOURCE_STATE_SHADER_RESOURCE, RHI_RESOURCE_STATE_RENDER_TARGET);
+		commandList->SetRenderTargets(colorTarget, depthTarget);
+		commandList->SetViewport(width, height);
+		commandList->ClearRenderTarget(colorTarget, clearColor);
+		commandList->ClearDepth(depthTarget, 1.0f);
+		commandList->SetConstants(RHI_CONSTANTS_SLOT_FRAME, &frameConstants, sizeof(frameConstants));
+
+		for (uint32 i = 0; i < objectsCount; i++)
+		{
+			Matrix world = Matrix::CreateScale(0.5f) * Matrix::CreateRotationY(angle) * Matrix::CreateTranslation(positions[i]);
+
+			// As D3D12Mesh::CalcPixelsPerUnit, for a unit sphere.
+			float depth = Vector3::Transform(positions[i], view).z - 0.5f;
+			depth = depth > 0.1f ? depth : 0.1f;
+			const MeshLod& lod = lodChain.lods[MeshSimplifier::SelectLod(lodChain, 0.5f * proj._22 * static_cast<float>(height) * 0.5f / depth)];
+
+			ObjectConstants constants = {};
+			constants.world = world.Transpose();
+			constants.materialIndex = i & 7;
+			if (!commandList->SetConstants(RHI_CONSTANTS_SLOT_OBJECT, &constants, sizeof(constants)))
+				continue;
+
+			commandList->SetPipeline(pipeline);
+			commandList->SetVertexBuffer(vertexBuffer);
+			commandList->SetIndexBuffer(indexBuffer);
+			commandList->DrawIndexed(lod.indicesCount, lod.indexOffset, 0);
+		}
+
+		commandList->TextureBarrier(colorTarget, RHI_RESOURCE_STATE_RENDER_TARGET, RHI_RESOURCE_STATE_SHADER_RESOURCE);
+		commandList->End();
+
+		device.WaitForFence(device.Submit(&commandList, 1));
+	}
+	state.SetItemsProcessed(state.GetIterations() * objectsCount);
+	state.SetBytesProcessed(device.GetStats().recordedBytes);
+
+	delete[] positions;
+	device.DestroyCommandList(commandList);
+	device.DestroyPipeline(pipeline);
+	device.DestroyTexture(depthTarget);
+	device.DestroyTexture(colorTarget);
+	device.DestroyBuffer(indexBuffer);
+	device.DestroyBuffer(vertexBuffer);
+	MeshSimplifier::Destroy(&lodChain);
+	FreeMeshData(&meshData);
+}
+
+// The per-mesh constant buffer draws bound before the constant ring: world,
+// view and projection, padded to a 256-byte CBV.
+struct alignas(256) PerMeshConstants
+{
+	Matrix world;			// Transposed.
+	Matrix view;			// Transposed.
+	Matrix proj;			// Transposed.
+};
+
+// Records and submits arg draws of one mesh with per-draw constants bound
+// either way the D3D12 backend has done it. The ring path copies each draw's
+// ObjectConstants into the frame's constants and binds them with one root
+// CBV, which is what SetConstants is. The table path rewrites each mesh's own
+// buffer and then binds it and the material index separately; the null RHI
+// has no tables, so those two binds are recorded as an 8-byte buffer address
+// and a 4-byte root constant.
+static void RecordPerDrawConstants(BenchmarkState& state, bool perMeshTables)
+{
+	uint32 objectsCount = state.GetArg();
+
+	MeshData meshData = MakeSphere(16);
+	NullRHIDevice device;
+
+	RHIBufferDesc vertexBufferDesc;
+	vertexBufferDesc.usage = RHI_BUFFER_USAGE_VERTEX;
+	vertexBufferDesc.size = sizeof(Vertex) * meshData.verticesCount;
+	vertexBufferDesc.stride = sizeof(Vertex);
+	RHIBuffer* vertexBuffer = device.CreateBuffer(vertexBufferDesc, meshData.vertices);
+
+	RHIBufferDesc indexBufferDesc;
+	indexBufferDesc.usage = RHI_BUFFER_USAGE_INDEX;
+	indexBufferDesc.size = sizeof(Index) * meshData.indicesCount;
+	indexBufferDesc.stride = sizeof(Index);
+	RHIBuffer* indexBuffer = device.CreateBuffer(indexBufferDesc, meshData.indices);
+
+	RHIPipeline* pipeline = device.CreatePipeline(RHIPipelineDesc());
+	RHICommandList* commandList = device.CreateCommandList();
+
+	PerMeshConstants* meshConstants = new PerMeshConstants[objectsCount];
+	Matrix* worlds = new Matrix[objectsCount];
+	for (uint32 i = 0; i < objectsCount; i++)
+	{
+		worlds[i] = Matrix::CreateTranslation(static_cast<float>(i % 32) - 16.0f, 0.0f, static_cast<float>(i / 32) + 2.0f);
+	}
+
+	Matrix view = DirectX::XMMatrixLookToLH(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 1.0f, 0.0f));
+	Matrix proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(70.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+
+	FrameConstants frameConstants;
+	frameConstants.view = view.Transpose();
+	frameConstants.proj = proj.Transpose();
+
+	while (state.KeepRunning())
+	{
+		commandList->Begin();
+		commandList->SetPipeline(pipeline);
+		commandList->SetVertexBuffer(vertexBuffer);
+		commandList->SetIndexBuffer(indexBuffer);
+		if (!perMeshTables)
+			commandList->SetConstants(RHI_CONSTANTS_SLOT_FRAME, &frameConstants, sizeof(frameConstants));
+
+		for (uint32 i = 0; i < objectsCount; i++)
+		{
+			uint32 materialIndex = i & 7;
+			if (perMeshTables)
+			{
+				PerMeshConstants& constants = meshConstants[i];
+				constants.world = worlds[i].Transpose();
+				constants.view = frameConstants.view;
+				constants.proj = frameConstants.proj;
+
+				const PerMeshConstants* address = &constants;
+				commandList->SetConstants(RHI_CONSTANTS_SLOT_OBJECT, &address, sizeof(address));
+				commandList->SetConstants(RHI_CONSTANTS_SLOT_OBJECT, &materialIndex, sizeof(materialIndex));
+			}
+			else
+			{
+				ObjectConstants constants = {};
+				constants.world = worlds[i].Transpose();
+				constants.materialIndex = materialIndex;
+				commandList->SetConstants(RHI_CONSTANTS_SLOT_OBJECT, &constants, sizeof(constants));
+			}
+
+			commandList->DrawIndexed(meshData.indicesCount, 0, 0);
+		}
+
+		commandList->End();
+		device.WaitForFence(device.Submit(&commandList, 1));
+		Benchmark::DoNotOptimize(meshConstants[objectsCount - 1].world._11);
+	}
+	state.SetItemsProcessed(state.GetIterations() * objectsCount);
+
+	delete[] worlds;
+	delete[] meshConstants;
+	device.DestroyCommandList(commandList);
+	device.DestroyPipeline(pipeline);
+	device.DestroyBuffer(indexBuffer);
+	device.DestroyBuffer(vertexBuffer);
+	FreeMeshData(&meshData);
+}
+
+static void BM_RootConstantRing(BenchmarkState& state)
+{
+	RecordPerDrawConstants(state, false);
+}
+
+static void BM_PerMeshConstantTables(BenchmarkState& state)
+{
+	RecordPerDrawConstants(state, true);
+}
+
+/*
+==============
+Software Rasterizer
+==============
+*/
+
+enum SOFTWARE_MESH
+{
+	SOFTWARE_MESH_BOX,
+	SOFTWARE_MESH_SPHERE,
+	SOFTWARE_MESH_SQUARE,
+	SOFTWARE_MESHES_COUNT,
+};
+
+enum SOFTWARE_MATERIAL
+{
+	SOFTWARE_MATERIAL_VERTEX_COLOR,
+	SOFTWARE_MATERIAL_CHECKER,
+	SOFTWARE_MATERIAL_CHECKER_CUTOUT,
+	SOFTWARE_MATERIAL_ORANGE,
+	SOFTWARE_MATERIALS_COUNT,
+};
+
+static const uint32 SOFTWARE_MATERIAL_FEATURES[SOFTWARE_MATERIALS_COUNT] =
+{
+	MATERIAL_FEATURE_VERTEX_COLOR,
+	MATERIAL_FEATURE_ALBEDO_TEXTURE,
+	MATERIAL_FEATURE_ALBEDO_TEXTURE | MATERIAL_FEATURE_ALPHA_TEST,
+	0,
+};
+
+static const uint32 CHECKER_SIZE = 64;
+static const uint32 CHECKER_CELL_SIZE = 8;
+
+struct SoftwareScene
+{
+	SoftwareRHIDevice device;
+	uint32 width = 0;
+	uint32 height = 0;
+
+	RHITexture* colorTarget = nullptr;
+	RHITexture* depthTarget = nullptr;
+	RHITexture* checker = nullptr;
+	RHIBuffer* vertexBuffers[SOFTWARE_MESHES_COUNT] = {};
+	RHIBuffer* indexBuffers[SOFTWARE_MESHES_COUNT] = {};
+	uint32 indicesCounts[SOFTWARE_MESHES_COUNT] = {};
+	RHIPipeline* pipelines[SOFTWARE_MATERIALS_COUNT] = {};
+	RHICommandList* commandList = nullptr;
+};
+
+struct SoftwareObject
+{
+	SOFTWARE_MESH mesh;
+	SOFTWARE_MATERIAL material;
+	Vector3 position;
+	Vector3 scale;
+	float angle;		// Around y, in degrees.
+};
+
+// Two-tone cells; the dark ones are mostly transparent, for the alpha test.
+static uint8* MakeCheckerImage()
+{
+	uint8* pixels = new uint8[CHECKER_SIZE * CHECKER_SIZE * 4];
+	for (uint32 y = 0; y < CHECKER_SIZE; y++)
+	{
+		for (uint32 x = 0; x < CHECKER_SIZE; x++)
+		{
+			uint8* pixel = pixels + (y * CHECKER_SIZE + x) * 4;
+			bool light = ((x / CHECKER_CELL_SIZE) + (y / CHECKER_CELL_SIZE)) % 2 == 0;
+			pixel[0] = light ? 240 : static_cast<uint8>(40 + x * 2);
+			pixel[1] = light ? 220 : 60;
+			pixel[2] = light ? 160 : static_cast<uint8>(80 + y * 2);
+			pixel[3] = light ? 255 : 64;
+		}
+	}
+	return pixels;
+}
+
+static void CreateSoftwareMesh(SoftwareScene* scene, SOFTWARE_MESH mesh, MeshData meshData)
+{
+	RHIBufferDesc vertexBufferDesc;
+	vertexBufferDesc.usage = RHI_BUFFER_USAGE_VERTEX;
+	vertexBufferDesc.size = sizeof(Vertex) * meshData.verticesCount;
+	vertexBufferDesc.stride = sizeof(Vertex);
+	scene->vertexBuffers[mesh] = scene->device.CreateBuffer(vertexBufferDesc, meshData.vertices);
+
+	RHIBufferDesc indexBufferDesc;
+	indexBufferDesc.usage = RHI_BUFFER_USAGE_INDEX;
+	indexBufferDesc.size = sizeof(Index) * meshData.indicesCount;
+	indexBufferDesc.stride = sizeof(Index);
+	scene->indexBuffers[mesh] = scene->device.CreateBuffer(indexBufferDesc, meshData.indices);
+	scene->indicesCounts[mesh] = meshData.indicesCount;
+
+	FreeMeshData(&meshData);
+}
+
+static void InitSoftwareScene(SoftwareScene* scene, uint32 threadsCount, uint32 width, uint32 height, uint32 sphereSlices)
+{
+	SoftwareRHIDevice& device = scene->device;
+	device.Init(threadsCount);
+	scene->width = width;
+	scene->height = height;
+
+	CreateSoftwareMesh(scene, SOFTWARE_MESH_BOX, GeometryGenerator::MakeBox(1.0f));
+	CreateSoftwareMesh(scene, SOFTWARE_MESH_SPHERE, MakeSphere(sphereSlices));
+	CreateSoftwareMesh(scene, SOFTWARE_MESH_SQUARE, GeometryGenerator::MakeSqaure(1.0f));
+
+	RHITextureDesc checkerDesc;
+	checkerDesc.width = CHECKER_SIZE;
+	checkerDesc.height = CHECKER_SIZE;
+	uint8* checkerPixels = MakeCheckerImage();
+	scene->checker = device.CreateTexture(checkerDesc, checkerPixels, CHECKER_SIZE * 4);
+	delete[] checkerPixels;
+
+	MaterialConstants materials[SOFTWARE_MATERIALS_COUNT] = {};
+	for (uint32 i = 0; i < SOFTWARE_MATERIALS_COUNT; i++)
+	{
+		materials[i].baseColor = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+		materials[i].albedoTexture = device.GetTextureIndex(scene->checker);
+		materials[i].alphaCutoff = 0.5f;
+
+		RHIPipelineDesc pipelineDesc;
+		pipelineDesc.features = SOFTWARE_MATERIAL_FEATURES[i];
+		scene->pipelines[i] = device.CreatePipeline(pipelineDesc);
+	}
+	materials[SOFTWARE_MATERIAL_ORANGE].baseColor = Vector4(1.0f, 0.55f, 0.1f, 1.0f);
+	device.SetMaterials(materials, SOFTWARE_MATERIALS_COUNT);
+
+	RHITextureDesc colorDesc;
+	colorDesc.width = width;
+	colorDesc.height = height;
+	colorDesc.usage = RHI_TEXTURE_USAGE_RENDER_TARGET | RHI_TEXTURE_USAGE_SHADER_RESOURCE;
+	scene->colorTarget = device.CreateTexture(colorDesc, nullptr, 0);
+
+	RHITextureDesc depthDesc;
+	depthDesc.width = width;
+	depthDesc.height = height;
+	depthDesc.format = RHI_FORMAT_D24_UNORM_S8_UINT;
+	depthDesc.usage = RHI_TEXTURE_USAGE_DEPTH_STENCIL;
+	scene->depthTarget = device.CreateTexture(depthDesc, nullptr, 0);
+
+	scene->commandList = device.CreateCommandList();
+}
+
+static void CleanSoftwareScene(SoftwareScene* scene)
+{
+	SoftwareRHIDevice& device = scene->device;
+	device.DestroyCommandList(scene->commandList);
+	device.DestroyTexture(scene->depthTarget);
+	device.DestroyTexture(scene->colorTarget);
+	device.DestroyTexture(scene->checker);
+	for (uint32 i = 0; i < SOFTWARE_MATERIALS_COUNT; i++)
+	{
+		device.DestroyPipeline(scene->pipelines[i]);
+	}
+	for (uint32 i = 0; i < SOFTWARE_MESHES_COUNT; i++)
+	{
+		device.DestroyBuffer(scene->indexBuffers[i]);
+		device.DestroyBuffer(scene->vertexBuffers[i]);
+	}
+	device.Clean();
+}
+
+static void BeginSoftwareFrame(SoftwareScene* scene, const Matrix& view, const Matrix& proj)
+{
+	const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+
+	FrameConstants frameConstants;
+	frameConstants.view = view.Transpose();
+	frameConstants.proj = proj.Transpose();
+
+	RHICommandList* commandList = scene->commandList;
+	commandList->Begin();
+	commandList->SetRenderTargets(scene->colorTarget, scene->depthTarget);
+	commandList->SetViewport(scene->width, scene->height);
+	commandList->ClearRenderTarget(scene->colorTarget, clearColor);
+	commandList->ClearDepth(scene->depthTarget, 1.0f);
+	commandList->SetConstants(RHI_CONSTANTS_SLOT_FRAME, &frameConstants, sizeof(frameConstants));
+}
+
+static void DrawSoftwareObject(SoftwareScene* scene, const SoftwareObject& object)
+{
+	ObjectConstants constants = {};
+	constants.world = (Matrix::CreateScale(object.scale) * Matrix::CreateRotationY(DirectX::XMConvertToRadians(object.angle)) * Matrix::CreateTranslation(object.position)).Transpose();
+	constants.materialIndex = object.material;
+
+	RHICommandList* commandList = scene->commandList;
+	commandList->SetConstants(RHI_CONSTANTS_SLOT_OBJECT, &constants, sizeof(constants));
+	commandList->SetPipeline(scene->pipelines[object.material]);
+	commandList->SetVertexBuffer(scene->vertexBuffers[object.mesh]);
+	commandList->SetIndexBuffer(scene->indexBuffers[object.mesh]);
+	commandList->DrawIndexed(scene->indicesCounts[object.mesh], 0, 0);
+}
+
+static void EndSoftwareFrame(SoftwareScene* scene)
+{
+	scene->commandList->End();
+	scene->device.WaitForFence(scene->device.Submit(&scene->commandList, 1));
+}
+
+// Arg threads. Many small spheres spread over the screen, so this is bound by
+// transform, setup and binning rather than by pixels. Items are triangles
+// drawn, before clipping and culling.
+static void BM_SoftwareTriangles(BenchmarkState& state)
+{
+	const uint32 width = 1280;
+	const uint32 height = 720;
+	const uint32 objectsCount = 1024;
+
+	SoftwareScene* scene = new SoftwareScene;
+	InitSoftwareScene(scene, state.GetArg(), width, height, 16);
+
+	SoftwareObject* objects = new SoftwareObject[objectsCount];
+	uint32 seed = 0x6a09e667;
+	for (uint32 i = 0; i < objectsCount; i++)
+	{
+		float x = static_cast<float>(NextRandom(&seed) % 400) * 0.1f - 20.0f;
+		float y = static_cast<float>(NextRandom(&seed) % 220) * 0.1f - 11.0f;
+		objects[i] = { SOFTWARE_MESH_SPHERE, static_cast<SOFTWARE_MATERIAL>(i % SOFTWARE_MATERIALS_COUNT), Vector3(x, y, 20.0f + static_cast<float>(i % 16)), Vector3(0.4f, 0.4f, 0.4f), 0.0f };
+	}
+
+	Matrix view = DirectX::XMMatrixLookToLH(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 1.0f, 0.0f));
+	Matrix proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(70.0f), static_cast<float>(width) / static_cast<float>(height), 0.1f, 100.0f);
+
+	while (state.KeepRunning())
+	{
+		BeginSoftwareFrame(scene, view, proj);
+		for (uint32 i = 0; i < objectsCount; i++)
+		{
+			DrawSoftwareObject(scene, objects[i]);
+		}
+		EndSoftwareFrame(scene);
+	}
+	state.SetItemsProcessed(scene->device.GetRasterizerStats().trianglesCount);
+
+	delete[] objects;
+	CleanSoftwareScene(scene);
+	delete scene;
+}
+
+// Arg threads. Textured full-screen squares drawn back to front, so every
+// pixel passes the depth test and is shaded. Items are pixels written.
+static void BM_SoftwareFillRate(BenchmarkState& state)
+{
+	const uint32 width = 1280;
+	const uint32 height = 720;
+	const uint32 layersCount = 8;
+
+	SoftwareScene* scene = new SoftwareScene;
+	InitSoftwareScene(scene, state.GetArg(), width, height, 16);
+
+	// Squares straight in clip space, at depths from 0.9 to 0.2.
+	Matrix identity;
+	while (state.KeepRunning())
+	{
+		BeginSoftwareFrame(scene, identity, identity);
+		for (uint32 i = 0; i < layersCount; i++)
+		{
+			SoftwareObject layer = { SOFTWARE_MESH_SQUARE, SOFTWARE_MATERIAL_CHECKER, Vector3(0.0f, 0.0f, 0.9f - static_cast<float>(i) * 0.1f), Vector3(1.0f, 1.0f, 1.0f), 0.0f };
+			DrawSoftwareObject(scene, layer);
+		}
+		EndSoftwareFrame(scene);
+	}
+	state.SetItemsProcessed(scene->device.GetRasterizerStats().pixelsCount);
+
+	CleanSoftwareScene(scene);
+	delete scene;
+}
+
+/*
+==============
+Residency Allocators
+==============
+*/
+
+// Page allocation with LRU eviction: arg tiles requested per frame against a
+// 256-page pool, as the feedback pass drives it.
+static void BM_VirtualTexturePages(BenchmarkState& state)
+{
+	VirtualTextureDesc desc = {};
+	desc.standardMipsCount = 6;
+	for (uint32 mip = 0; mip < desc.standardMipsCount; mip++)
+	{
+		desc.widthInTiles[mip] = 32 >> mip;
+		desc.heightInTiles[mip] = 32 >> mip;
+	}
+	desc.physicalPagesCount = 256;
+
+	VirtualTexturePageTable pageTable;
+	pageTable.Init(desc);
+
+	uint32 requestsCount = state.GetArg();
+	VirtualTileLoad* loads = new VirtualTileLoad[requestsCount];
+	uint32 seed = 0x1b873593;
+
+	while (state.KeepRunning())
+	{
+		for (uint32 i = 0; i < requestsCount; i++)
+		{
+			pageTable.RequestTile(NextRandom(&seed) % pageTable.GetTilesCount());
+		}
+
+		uint32 loadsCount = pageTable.Update(loads, requestsCount);
+		for (uint32 i = 0; i < loadsCount; i++)
+		{
+			pageTable.CompleteLoad(loads[i].tileIndex);
+		}
+		Benchmark::DoNotOptimize(loadsCount);
+	}
+	state.SetItemsProcessed(state.GetIterations() * requestsCount);
+
+	delete[] loads;
+	pageTable.Clean();
+}
+
+// Mip residency under a budget that holds about half of arg textures.
+static void BM_TextureStreamer(BenchmarkState& state)
+{
+	uint32 texturesCount = state.GetArg();
+
+	StreamedTextureDesc desc = {};
+	desc.width = 2048;
+	desc.height = 2048;
+	desc.mipLevels = MipGenerator::GetMipLevelsCount(desc.width, desc.height);
+	uint64 textureBytes = 0;
+	for (uint32 mip = 0; mip < desc.mipLevels; mip++)
+	{
+		uint32 width = (desc.width >> mip) > 1 ? desc.width >> mip : 1;
+		uint32 height = (desc.height >> mip) > 1 ? desc.height >> mip : 1;
+		desc.mipSizes[mip] = static_cast<uint64>(width) * height;	// BC3: a byte per texel.
+		textureBytes += desc.mipSizes[mip];
+	}
+
+	TextureStreamerSettings settings;
+	settings.maxTextures = texturesCount;
+	settings.budgetBytes = textureBytes * texturesCount / 2;
+
+	TextureStreamer streamer;
+	streamer.Init(settings);
+	uint32* textureIds = new uint32[texturesCount];
+	for (uint32 i = 0; i < texturesCount; i++)
+	{
+		textureIds[i] = streamer.Register(desc);
+	}
+
+	TextureStreamRequest requests[16];
+	uint32 seed = 0x85ebca6b;
+	while (state.KeepRunning())
+	{
+		for (uint32 i = 0; i < texturesCount; i++)
+		{
+			streamer.ReportScreenSize(textureIds[i], static_cast<float>(NextRandom(&seed) % 2048));
+		}
+
+		uint32 requestsCount = streamer.Update(requests, 16);
+		for (uint32 i = 0; i < requestsCount; i++)
+		{
+			streamer.CompleteRequest(requests[i].textureId);
+		}
+		Benchmark::DoNotOptimize(requestsCount);
+	}
+	state.SetItemsProcessed(state.GetIterations() * texturesCount);
+
+	delete[] textureIds;
+	streamer.Clean();
+}
+
+/*
+==============
+Jobs
+==============
+*/
+
+static void* HashJob(void* context, void* job)
+{
+	// About a microsecond of work, short enough that queue overhead shows.
+	uint64 hash = HashBytes(context, 1024, reinterpret_cast<uintptr_t>(job));
+	return reinterpret_cast<void*>(static_cast<uintptr_t>(hash | 1));
+}
+
+// Submit a batch, help with it on this thread and wait for it, with arg workers.
+static void BM_PipelineCompileQueue(BenchmarkState& state)
+{
+	static uint8 s_jobData[1024] = {};
+	const uint32 JOBS_COUNT = 256;
+
+	PipelineCompileQueueSettings settings;
+	settings.maxJobs = JOBS_COUNT;
+	settings.threadsCount = state.GetArg();
+	settings.compile = HashJob;
+	settings.context = s_jobData;
+
+	PipelineCompileQueue queue;
+	queue.Init(settings);
+
+	uint32 jobIds[JOBS_COUNT];
+	while (state.KeepRunning())
+	{
+		for (uint32 i = 0; i < JOBS_COUNT; i++)
+		{
+			jobIds[i] = queue.Submit(reinterpret_cast<void*>(static_cast<uintptr_t>(i)));
+		}
+
+		while (queue.CompileOne())
+		{
+		}
+
+		for (uint32 i = 0; i < JOBS_COUNT; i++)
+		{
+			while (queue.GetState(jobIds[i]) != PIPELINE_COMPILE_STATE_READY)
+			{
+				std::this_thread::yield();
+			}
+			queue.Release(jobIds[i]);
+		}
+	}
+	state.SetItemsProcessed(state.GetIterations() * JOBS_COUNT);
+
+	queue.Clean();
+}
+
+// 1024x1024 of the noise image with arg threads.
+static void CompressBC(BenchmarkState& state, DDS_FORMAT format, BC_QUALITY quality)
+{
+	const uint32 SIZE = 1024;
+	DDSMipLayout layout = {};
+	DDSFile::ComputeMipLayout(format, SIZE, SIZE, 0, &layout);
+
+	uint8* pixels = MakeNoiseImage(SIZE, SIZE);
+	uint8* blocks = new uint8[layout.size];
+
+	while (state.KeepRunning())
+	{
+		if (!BCEncoder::Compress(pixels, SIZE, SIZE, format, quality, state.GetArg(), blocks))
+		{
+			state.SkipWithError("BCEncoder::Compress failed");
+			break;
+		}
+		Benchmark::DoNotOptimize(blocks[0]);
+	}
+	state.SetBytesProcessed(state.GetIterations() * SIZE * SIZE * 4);
+
+	delete[] blocks;
+	delete[] pixels;
+}
+
+static void BM_CompressBC1Fast(BenchmarkState& state)
+{
+	CompressBC(state, DDS_FORMAT_BC1_UNORM, BC_QUALITY_FAST);
+}
+
+static void BM_CompressBC1(BenchmarkState& state)
+{
+	CompressBC(state, DDS_FORMAT_BC1_UNORM, BC_QUALITY_NORMAL);
+}
+
+static void BM_CompressBC1High(BenchmarkState& state)
+{
+	CompressBC(state, DDS_FORMAT_BC1_UNORM, BC_QUALITY_HIGH);
+}
+
+static void BM_CompressBC3Fast(BenchmarkState& state)
+{
+	CompressBC(state, DDS_FORMAT_BC3_UNORM, BC_QUALITY_FAST);
+}
+
+static void BM_CompressBC3(BenchmarkState& state)
+{
+	CompressBC(state, DDS_FORMAT_BC3_UNORM, BC_QUALITY_NORMAL);
+}
+
+static void BM_CompressBC3High(BenchmarkState& state)
+{
+	CompressBC(state, DDS_FORMAT_BC3_UNORM, BC_QUALITY_HIGH);
+}
+
+static void BM_CompressBC7Fast(BenchmarkState& state)
+{
+	CompressBC(state, DDS_FORMAT_BC7_UNORM, BC_QUALITY_FAST);
+}
+
+static void BM_CompressBC7(BenchmarkState& state)
+{
+	CompressBC(state, DDS_FORMAT_BC7_UNORM, BC_QUALITY_NORMAL);
+}
+
+static void BM_CompressBC7High(BenchmarkState& state)
+{
+	CompressBC(state, DDS_FORMAT_BC7_UNORM, BC_QUALITY_HIGH);
+}
+
+static void GenerateMips(BenchmarkState& state, MIP_FILTER filter)
+{
+	const uint32 SIZE = 1024;
+	DDSTextureInfo info = {};
+	DDSFile::InitInfo(DDS_FORMAT_R8G8B8A8_UNORM, SIZE, SIZE, MipGenerator::GetMipLevelsCount(SIZE, SIZE), &info);
+
+	uint8* pixels = MakeNoiseImage(SIZE, SIZE);
+	uint8* data = new uint8[info.sliceSize];
+	::memcpy(data, pixels, SIZE * SIZE * 4);
+
+	uint32 threadsCount = Platform::GetHardwareThreadsCount();
+	while (state.KeepRunning())
+	{
+		if (!MipGenerator::Generate(info, filter, true, threadsCount, data))
+		{
+			state.SkipWithError("MipGenerator::Generate failed");
+			break;
+		}
+		Benchmark::DoNotOptimize(data[info.sliceSize - 1]);
+	}
+	state.SetBytesProcessed(state.GetIterations() * SIZE * SIZE * 4);
+
+	delete[] data;
+	delete[] pixels;
+}
+
+static void BM_GenerateMipsBox(BenchmarkState& state)
+{
+	GenerateMips(state, MIP_FILTER_BOX);
+}
+
+static void BM_GenerateMipsKaiser(BenchmarkState& state)
+{
+	GenerateMips(state, MIP_FILTER_KAISER);
+}
+
+/*
+==============
+Files
+==============
+*/
+
+static const char* DDS_TEMP_FILENAME = "BenchmarkTemp.dds";
+
+static void BM_ParseDDS(BenchmarkState& state)
+{
+	DDSTextureInfo info = {};
+	DDSFile::InitInfo(DDS_FORMAT_BC7_UNORM, 2048, 2048, MipGenerator::GetMipLevelsCount(2048, 2048), &info);
+
+	uint8* data = new uint8[info.sliceSize];
+	::memset(data, 0, info.sliceSize);
+	bool written = DDSFile::Write(DDS_TEMP_FILENAME, info, data);
+	delete[] data;
+
+	FileMapping mapping = {};
+	if (!written || !FileSystem::MapFile(DDS_TEMP_FILENAME, &mapping))
+	{
+		state.SkipWithError("Failed to write the DDS file");
+		::remove(DDS_TEMP_FILENAME);
+		return;
+	}
+
+	while (state.KeepRunning())
+	{
+		DDSTextureInfo parsed = {};
+		if (!DDSFile::Parse(mapping.data, mapping.size, &parsed))
+		{
+			state.SkipWithError("DDSFile::Parse failed");
+			break;
+		}
+		Benchmark::DoNotOptimize(parsed.mips[parsed.mipLevels - 1].offset);
+	}
+	state.SetItemsProcessed(state.GetIterations());
+
+	FileSystem::UnmapFile(&mapping);
+	::remove(DDS_TEMP_FILENAME);
+}
+
+static void BM_HashBytes(BenchmarkState& state)
+{
+	const uint32 SIZE = 1024 * 1024;
+	uint8* data = MakeNoiseImage(512, 512);
+
+	while (state.KeepRunning())
+	{
+		uint64 hash = HashBytes(data, SIZE);
+		Benchmark::DoNotOptimize(hash);
+	}
+	state.SetBytesProcessed(state.GetIterations() * SIZE);
+
+	delete[] data;
+}
+
+/*
+==============
+Profiler
+==============
+*/
+
+// The cost of one PROFILE_SCOPE, which every instrumented function pays.
+static void BM_ProfileScope(BenchmarkState& state)
+{
+	Profiler::Init();
+
+	while (state.KeepRunning())
+	{
+		ProfileScope scope("Benchmark");
+	}
+	state.SetItemsProcessed(state.GetIterations());
+
+	Profiler::Clean();
+}
+
+/*
+==============
+Golden Images
+==============
+*/
+
+// Small scenes the software rasterizer renders and compares with images from
+// an earlier run, so changes to it show up as pixel differences.
+struct GoldenScene
+{
+	const char* name;
+	Vector3 eye;
+	Vector3 direction;
+	const SoftwareObject* objects;
+	uint32 objectsCount;
+};
+
+// Boxes with vertex colors, textured spheres that cut into each other, a
+// textured floor going into the distance and a box through the near plane.
+static const SoftwareObject GOLDEN_SHAPES[] =
+{
+	{ SOFTWARE_MESH_BOX, SOFTWARE_MATERIAL_CHECKER, Vector3(0.0f, -1.2f, 4.0f), Vector3(6.0f, 0.1f, 10.0f), 0.0f },
+	{ SOFTWARE_MESH_BOX, SOFTWARE_MATERIAL_VERTEX_COLOR, Vector3(-1.8f, -0.3f, 2.5f), Vector3(0.7f, 0.7f, 0.7f), 30.0f },
+	{ SOFTWARE_MESH_SPHERE, SOFTWARE_MATERIAL_CHECKER, Vector3(0.6f, 0.0f, 4.0f), Vector3(1.0f, 1.0f, 1.0f), 0.0f },
+	{ SOFTWARE_MESH_SPHERE, SOFTWARE_MATERIAL_ORANGE, Vector3(1.5f, 0.2f, 3.3f), Vector3(0.6f, 0.6f, 0.6f), 0.0f },
+	{ SOFTWARE_MESH_BOX, SOFTWARE_MATERIAL_VERTEX_COLOR, Vector3(0.7f, -0.7f, -5.7f), Vector3(0.5f, 0.5f, 0.5f), 15.0f },
+};
+
+// Alpha-tested cutouts over a backdrop with vertex colors.
+static const SoftwareObject GOLDEN_CUTOUTS[] =
+{
+	{ SOFTWARE_MESH_SQUARE, SOFTWARE_MATERIAL_VERTEX_COLOR, Vector3(0.0f, 0.0f, 3.0f), Vector3(5.0f, 3.0f, 1.0f), 0.0f },
+	{ SOFTWARE_MESH_SPHERE, SOFTWARE_MATERIAL_CHECKER_CUTOUT, Vector3(-1.1f, 0.0f, 0.0f), Vector3(1.0f, 1.0f, 1.0f), 20.0f },
+	{ SOFTWARE_MESH_BOX, SOFTWARE_MATERIAL_CHECKER_CUTOUT, Vector3(1.3f, 0.0f, 0.5f), Vector3(0.8f, 0.8f, 0.8f), 45.0f },
+};
+
+static const GoldenScene GOLDEN_SCENES[] =
+{
+	{ "Shapes", Vector3(0.0f, 0.5f, -6.0f), Vector3(0.0f, -0.1f, 1.0f), GOLDEN_SHAPES, static_cast<uint32>(sizeof(GOLDEN_SHAPES) / sizeof(GOLDEN_SHAPES[0])) },
+	{ "Cutouts", Vector3(0.0f, 0.0f, -4.0f), Vector3(0.0f, 0.0f, 1.0f), GOLDEN_CUTOUTS, static_cast<uint32>(sizeof(GOLDEN_CUTOUTS) / sizeof(GOLDEN_CUTOUTS[0])) },
+};
+
+static const uint32 GOLDEN_WIDTH = 320;
+static const uint32 GOLDEN_HEIGHT = 180;
+
+// Compilers may round differently, so a few pixels may be off by a little.
+static const uint32 GOLDEN_CHANNEL_TOLERANCE = 2;
+static const uint32 GOLDEN_MAX_MISMATCHES = GOLDEN_WIDTH * GOLDEN_HEIGHT / 1000;
+
+// Tightly packed RGBA8 rows of the scene's color target.
+static uint8* RenderGoldenScene(const GoldenScene& goldenScene, uint32 threadsCount)
+{
+	SoftwareScene* scene = new SoftwareScene;
+	InitSoftwareScene(scene, threadsCount, GOLDEN_WIDTH, GOLDEN_HEIGHT, 32);
+
+	Matrix view = DirectX::XMMatrixLookToLH(goldenScene.eye, goldenScene.direction, Vector3(0.0f, 1.0f, 0.0f));
+	Matrix proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(70.0f), static_cast<float>(GOLDEN_WIDTH) / static_cast<float>(GOLDEN_HEIGHT), 0.1f, 100.0f);
+
+	BeginSoftwareFrame(scene, view, proj);
+	for (uint32 i = 0; i < goldenScene.objectsCount; i++)
+	{
+		DrawSoftwareObject(scene, goldenScene.objects[i]);
+	}
+	EndSoftwareFrame(scene);
+
+	const NullRHITexture* colorTarget = NullRHIDevice::ToTexture(scene->colorTarget);
+	uint8* pixels = new uint8[GOLDEN_WIDTH * GOLDEN_HEIGHT * 4];
+	for (uint32 y = 0; y < GOLDEN_HEIGHT; y++)
+	{
+		::memcpy(pixels + y * GOLDEN_WIDTH * 4, colorTarget->data + y * colorTarget->rowPitch, GOLDEN_WIDTH * 4);
+	}
+
+	CleanSoftwareScene(scene);
+	delete scene;
+	return pixels;
+}
+
+// Renders every golden scene single-threaded and on every core, which must
+// agree exactly, then compares with <directory>/SoftwareRasterizer_<name>.tga,
+// or writes it with update. Returns the process exit code.
+static int RunGoldenTests(const char* directory, bool update, uint32 threadsCount)
+{
+	uint32 failuresCount = 0;
+	for (const GoldenScene& goldenScene : GOLDEN_SCENES)
+	{
+		char filename[512];
+		::snprintf(filename, sizeof(filename), "%s/SoftwareRasterizer_%s.tga", directory, goldenScene.name);
+
+		uint8* pixels = RenderGoldenScene(goldenScene, 1);
+		uint8* threadedPixels = RenderGoldenScene(goldenScene, threadsCount);
+		bool deterministic = ::memcmp(pixels, threadedPixels, GOLDEN_WIDTH * GOLDEN_HEIGHT * 4) == 0;
+		delete[] threadedPixels;
+
+		if (!deterministic)
+		{
+			::printf("%-40s FAILED: %u threads render differently from 1\n", goldenScene.name, threadsCount);
+			failuresCount++;
+		}
+		else if (update)
+		{
+			bool saved = ImageFile::SaveTga(filename, pixels, GOLDEN_WIDTH, GOLDEN_HEIGHT, GOLDEN_WIDTH * 4);
+			::printf("%-40s %s %s\n", goldenScene.name, saved ? "wrote" : "FAILED to write", filename);
+			failuresCount += saved ? 0 : 1;
+		}
+		else
+		{
+			ImageData golden = {};
+			if (!ImageFile::Load(filename, &golden) || golden.width != GOLDEN_WIDTH || golden.height != GOLDEN_HEIGHT)
+			{
+				::printf("%-40s FAILED: no %ux%u golden image %s, run with --golden_update\n", goldenScene.name, GOLDEN_WIDTH, GOLDEN_HEIGHT, filename);
+				failuresCount++;
+			}
+			else
+			{
+				uint32 mismatchesCount = 0;
+				uint32 maxDifference = 0;
+				for (uint32 i = 0; i < GOLDEN_WIDTH * GOLDEN_HEIGHT; i++)
+				{
+					uint32 pixelDifference = 0;
+					for (uint32 c = 0; c < 4; c++)
+					{
+						uint32 difference = static_cast<uint32>(pixels[i * 4 + c] > golden.pixels[i * 4 + c] ? pixels[i * 4 + c] - golden.pixels[i * 4 + c] : golden.pixels[i * 4 + c] - pixels[i * 4 + c]);
+						pixelDifference = difference > pixelDifference ? difference : pixelDifference;
+					}
+					mismatchesCount += pixelDifference > GOLDEN_CHANNEL_TOLERANCE ? 1 : 0;
+					maxDifference = pixelDifference > maxDifference ? pixelDifference : maxDifference;
+				}
+
+				bool passed = mismatchesCount <= GOLDEN_MAX_MISMATCHES;
+				::printf("%-40s %s: %u pixels differ, by at most %u\n", goldenScene.name, passed ? "passed" : "FAILED", mismatchesCount, maxDifference);
+				failuresCount += passed ? 0 : 1;
+			}
+			ImageFile::Destroy(&golden);
+		}
+
+		delete[] pixels;
+	}
+
+	return failuresCount ? 1 : 0;
+}
+
+/*
+=================
+Main entry point
+=================
+*/
+
+int main(int argc, char* argv[])
+{
+	// AVX2 and AVX-512 builds would fault on the first wide instruction.
+	if (!Platform::IsInstructionSetSupported())
+	{
+		::printf("This build targets %s, which this CPU does not support.\n", Platform::GetInstructionSetName());
+		return 1;
+	}
+
+	uint32 threadsCount = Platform::GetHardwareThreadsCount();
+
+	// --golden=<directory> checks the software rasterizer against the golden
+	// images there, such as Test/Golden, instead of benchmarking; add
+	// --golden_update to write them. --test runs the unit tests instead; see
+	// UnitTest.h.
+	const char* goldenDirectory = nullptr;
+	bool goldenUpdate = false;
+	const char* testFilter = nullptr;
+	for (int i = 1; i < argc; i++)
+	{
+		if (::strncmp(argv[i], "--golden=", 9) == 0)
+			goldenDirectory = argv[i] + 9;
+		else if (::strcmp(argv[i], "--golden_update") == 0)
+			goldenUpdate = true;
+		else if (::strcmp(argv[i], "--test") == 0)
+			testFilter = "";
+		else if (::strncmp(argv[i], "--test=", 7) == 0)
+			testFilter = argv[i] + 7;
+		else if (::strncmp(argv[i], "--test_data=", 12) == 0)
+			UnitTest::SetDataDirectory(argv[i] + 12);
+	}
+	if (goldenDirectory)
+		return RunGoldenTests(goldenDirectory, goldenUpdate, threadsCount);
+	if (testFilter)
+	{
+		RegisterUnitTests();
+		return UnitTest::RunAll(testFilter);
+	}
+
+	Benchmark::Register("GeometryGenerator/MakeSphere", BM_MakeSphere, 64);
+	Benchmark::Register("GeometryGenerator/MakeSphere", BM_MakeSphere, 256);
+
+	Benchmark::Register("MeshOptimizer/OptimizeVertexCache", BM_OptimizeVertexCache, 64);
+	Benchmark::Register("MeshOptimizer/OptimizeVertexCache", BM_OptimizeVertexCache, 256);
+	Benchmark::Register("MeshOptimizer/AnalyzeVertexCache", BM_AnalyzeVertexCache, 256);
+	Benchmark::Register("MeshOptimizer/OptimizeMesh", BM_OptimizeMesh, 256);
+	Benchmark::Register("MeshSimplifier/BuildLodChain", BM_BuildLodChain, 64);
+	Benchmark::Register("MeshSimplifier/BuildLodChain", BM_BuildLodChain, 256);
+	Benchmark::Register("MeshletBuilder/Build", BM_BuildMeshlets, 64);
+	Benchmark::Register("MeshletBuilder/Build", BM_BuildMeshlets, 256);
+
+	Benchmark::Register("MeshletCulling/IsVisible", BM_CullMeshlets, 256);
+	Benchmark::Register("Transforms/Update", BM_UpdateTransforms, 1024);
+	Benchmark::Register("Transforms/Update", BM_UpdateTransforms, 16384);
+	Benchmark::Register("RHI/NullFrame", BM_NullFrame, 1024);
+	Benchmark::Register("RHI/NullFrame", BM_NullFrame, 16384);
+	Benchmark::Register("RHI/RootConstantRing", BM_RootConstantRing, 4096);
+	Benchmark::Register("RHI/PerMeshConstantTables", BM_PerMeshConstantTables, 4096);
+	Benchmark::Register("SoftwareRasterizer/Triangles", BM_SoftwareTriangles, 1);
+	Benchmark::Register("SoftwareRasterizer/FillRate", BM_SoftwareFillRate, 1);
+	if (threadsCount > 1)
+	{
+		Benchmark::Register("SoftwareRasterizer/Triangles", BM_SoftwareTriangles, threadsCount);
+		Benchmark::Register("SoftwareRasterizer/FillRate", BM_SoftwareFillRate, threadsCount);
+	}
+
+	Benchmark::Register("VirtualTexturePageTable/Update", BM_VirtualTexturePages, 64);
+	Benchmark::Register("VirtualTexturePageTable/Update", BM_VirtualTexturePages, 1024);
+	Benchmark::Register("TextureStreamer/Update", BM_TextureStreamer, 1024);
+
+	// Single-threaded and across every core.
+	Benchmark::Register("PipelineCompileQueue/Batch", BM_PipelineCompileQueue, 1);
+	Benchmark::Register("BCEncoder/CompressBC1", BM_CompressBC1, 1);
+	Benchmark::Register("BCEncoder/CompressBC3", BM_CompressBC3, 1);
+	Benchmark::Register("BCEncoder/CompressBC7", BM_CompressBC7, 1);
+	if (threadsCount > 1)
+	{
+		Benchmark::Register("PipelineCompileQueue/Batch", BM_PipelineCompileQueue, threadsCount);
+		Benchmark::Register("BCEncoder/CompressBC1", BM_CompressBC1, threadsCount);
+		Benchmark::Register("BCEncoder/CompressBC3", BM_CompressBC3, threadsCount);
+		Benchmark::Register("BCEncoder/CompressBC7", BM_CompressBC7, threadsCount);
+	}
+
+	// The other qualities on one thread; BCEncoder/Psnr in Tests.cpp pins what each buys.
+	Benchmark::Register("BCEncoder/CompressBC1Fast", BM_CompressBC1Fast, 1);
+	Benchmark::Register("BCEncoder/CompressBC1High", BM_CompressBC1High, 1);
+	Benchmark::Register("BCEncoder/CompressBC3Fast", BM_CompressBC3Fast, 1);
+	Benchmark::Register("BCEncoder/CompressBC3High", BM_CompressBC3High, 1);
+	Benchmark::Register("BCEncoder/CompressBC7Fast", BM_CompressBC7Fast, 1);
+	Benchmark::Register("BCEncoder/CompressBC7High", BM_CompressBC7High, 1);
+	Benchmark::Register("MipGenerator/Box", BM_GenerateMipsBox);
+	Benchmark::Register("MipGenerator/Kaiser", BM_GenerateMipsKaiser);
+
+	Benchmark::Register("DDSFile/Parse", BM_ParseDDS);
+	Benchmark::Register("Hash/HashBytes", BM_HashBytes);
+	Benchmark::Register("Profiler/ProfileScope", BM_ProfileScope);
+
+	return Benchmark::RunAll(argc, argv);
+}
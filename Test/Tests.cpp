@@ -0,0 +1,2325 @@
+#include "UnitTest.h"
+#include "../Cooker/MeshImporter.h"
+#include "../Common/BCEncoder.h"
+#include "../Common/DDSFile.h"
+#include "../Common/FrameStats.h"
+#include "../Common/GeometryGenerator.h"
+#include "../Common/ImageFile.h"
+#include "../Common/MeshFile.h"
+#include "../Common/MeshletBuilder.h"
+#include "../Common/MeshOptimizer.h"
+#include "../Common/MeshSimplifier.h"
+#include "../Common/MipGenerator.h"
+#include "../Common/PipelineCompileQueue.h"
+#include "../Common/Profiler.h"
+#include "../Common/RHINull.h"
+#include "../Common/TextureStreamer.h"
+#include "../Common/VirtualTexturePageTable.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <thread>
+
+/*
+======================
+Pipeline Compile Queue
+======================
+*/
+
+// Jobs are indices into the context's counters, stored in the job pointer.
+// Odd jobs fail to compile.
+struct CompileTestContext
+{
+	static const uint32 MAX_JOBS = 16;
+
+	std::atomic<uint32> compiles[MAX_JOBS] = {};
+	std::atomic<uint32> discards[MAX_JOBS] = {};
+	uint32 compileOrder[MAX_JOBS] = {};
+	std::atomic<uint32> compilesCount{ 0 };
+
+	// Set to make compiles wait for unblock, to hold a job in COMPILING.
+	std::atomic<bool> block{ false };
+	std::atomic<bool> unblock{ false };
+};
+
+static void* ToJob(uint32 index)
+{
+	return reinterpret_cast<void*>(static_cast<uintptr_t>(index));
+}
+
+static uint32 ToIndex(void* job)
+{
+	return static_cast<uint32>(reinterpret_cast<uintptr_t>(job));
+}
+
+static void* CountCompile(void* context, void* job)
+{
+	CompileTestContext* test = static_cast<CompileTestContext*>(context);
+	uint32 index = ToIndex(job);
+
+	while (test->block && !test->unblock)
+	{
+		std::this_thread::yield();
+	}
+
+	test->compiles[index]++;
+	test->compileOrder[test->compilesCount++ % CompileTestContext::MAX_JOBS] = index;
+	return index & 1 ? nullptr : ToJob(index + 1000);
+}
+
+static void CountDiscard(void* context, void* job, void* result)
+{
+	CompileTestContext* test = static_cast<CompileTestContext*>(context);
+	uint32 index = ToIndex(job);
+	test->discards[index]++;
+
+	// Only successful compiles have a result, and it belongs to the job.
+	if (result)
+		TEST_CHECK(ToIndex(result) == index + 1000);
+}
+
+static void InitCompileQueue(PipelineCompileQueue* queue, CompileTestContext* context, uint32 maxJobs, uint32 threadsCount)
+{
+	PipelineCompileQueueSettings settings;
+	settings.maxJobs = maxJobs;
+	settings.threadsCount = threadsCount;
+	settings.compile = CountCompile;
+	settings.discard = CountDiscard;
+	settings.context = context;
+	queue->Init(settings);
+}
+
+static void TestCompileQueueLifecycle()
+{
+	CompileTestContext context;
+	PipelineCompileQueue queue;
+	InitCompileQueue(&queue, &context, 4, 0);
+
+	uint32 ready = queue.Submit(ToJob(0));
+	uint32 failed = queue.Submit(ToJob(1));
+	TEST_REQUIRE(ready != PIPELINE_COMPILE_INVALID_ID && failed != PIPELINE_COMPILE_INVALID_ID);
+	TEST_CHECK(queue.GetState(ready) == PIPELINE_COMPILE_STATE_QUEUED);
+	TEST_CHECK(queue.GetResult(ready) == nullptr);
+	TEST_CHECK(queue.GetQueuedCount() == 2);
+
+	TEST_CHECK(queue.CompileOne());
+	TEST_CHECK(queue.CompileOne());
+	TEST_CHECK(!queue.CompileOne());
+	TEST_CHECK(queue.GetQueuedCount() == 0);
+
+	TEST_CHECK(queue.GetState(ready) == PIPELINE_COMPILE_STATE_READY);
+	TEST_CHECK(ToIndex(queue.GetResult(ready)) == 1000);
+	TEST_CHECK(queue.GetState(failed) == PIPELINE_COMPILE_STATE_FAILED);
+	TEST_CHECK(queue.GetResult(failed) == nullptr);
+
+	queue.Release(ready);
+	queue.Release(failed);
+	TEST_CHECK(queue.GetState(ready) == PIPELINE_COMPILE_STATE_FREE);
+	TEST_CHECK(queue.GetState(failed) == PIPELINE_COMPILE_STATE_FREE);
+	TEST_CHECK(context.discards[0] == 1 && context.discards[1] == 1);
+
+	// Releasing a free slot does nothing.
+	queue.Release(ready);
+	TEST_CHECK(context.discards[0] == 1);
+
+	queue.Clean();
+	TEST_CHECK(context.compiles[0] == 1 && context.compiles[1] == 1);
+	TEST_CHECK(context.discards[0] == 1 && context.discards[1] == 1);
+}
+
+static void TestCompileQueueOrder()
+{
+	CompileTestContext context;
+	PipelineCompileQueue queue;
+	InitCompileQueue(&queue, &context, 8, 0);
+
+	for (uint32 i = 0; i < 6; i++)
+	{
+		TEST_CHECK(queue.Submit(ToJob(i)) != PIPELINE_COMPILE_INVALID_ID);
+	}
+
+	while (queue.CompileOne())
+	{
+	}
+
+	TEST_REQUIRE(context.compilesCount == 6);
+	for (uint32 i = 0; i < 6; i++)
+	{
+		TEST_CHECK(context.compileOrder[i] == i);
+	}
+
+	queue.Clean();
+	for (uint32 i = 0; i < 6; i++)
+	{
+		TEST_CHECK(context.discards[i] == 1);
+	}
+}
+
+// A released queued job is discarded at once and never compiled, and neither
+// a second Release nor Clean discards it again.
+static void TestCompileQueueReleaseQueued()
+{
+	CompileTestContext context;
+	PipelineCompileQueue queue;
+	InitCompileQueue(&queue, &context, 4, 0);
+
+	uint32 released = queue.Submit(ToJob(2));
+	uint32 kept = queue.Submit(ToJob(4));
+	TEST_REQUIRE(released != PIPELINE_COMPILE_INVALID_ID && kept != PIPELINE_COMPILE_INVALID_ID);
+
+	queue.Release(released);
+	TEST_CHECK(context.discards[2] == 1);
+	TEST_CHECK(queue.GetState(released) == PIPELINE_COMPILE_STATE_FREE);
+	TEST_CHECK(queue.GetQueuedCount() == 1);
+
+	queue.Release(released);
+	TEST_CHECK(context.discards[2] == 1);
+
+	TEST_CHECK(queue.CompileOne());
+	TEST_CHECK(!queue.CompileOne());
+	TEST_CHECK(context.compiles[2] == 0);
+	TEST_CHECK(context.compiles[4] == 1);
+	TEST_CHECK(queue.GetState(kept) == PIPELINE_COMPILE_STATE_READY);
+
+	queue.Clean();
+	TEST_CHECK(context.discards[2] == 1);
+	TEST_CHECK(context.discards[4] == 1);
+}
+
+// Released while queued, then the queue cleaned before anything popped it,
+// as D3D12PipelineCache does when it releases a pipeline at shutdown.
+static void TestCompileQueueReleaseQueuedThenClean()
+{
+	CompileTestContext context;
+	PipelineCompileQueue queue;
+	InitCompileQueue(&queue, &context, 4, 0);
+
+	uint32 jobId = queue.Submit(ToJob(6));
+	TEST_REQUIRE(jobId != PIPELINE_COMPILE_INVALID_ID);
+	queue.Release(jobId);
+	queue.Clean();
+
+	TEST_CHECK(context.compiles[6] == 0);
+	TEST_CHECK(context.discards[6] == 1);
+}
+
+// Every state left at Clean is discarded exactly once.
+static void TestCompileQueueClean()
+{
+	CompileTestContext context;
+	PipelineCompileQueue queue;
+	InitCompileQueue(&queue, &context, 4, 0);
+
+	queue.Submit(ToJob(0));
+	queue.Submit(ToJob(1));
+	TEST_CHECK(queue.CompileOne());
+	TEST_CHECK(queue.CompileOne());
+	queue.Submit(ToJob(2));
+
+	queue.Clean();
+	TEST_CHECK(context.compiles[2] == 0);
+	for (uint32 i = 0; i < 3; i++)
+	{
+		TEST_CHECK(context.discards[i] == 1);
+	}
+}
+
+// Full queues reject jobs, and a released queued slot is only reused once it
+// has left the queue.
+static void TestCompileQueueFull()
+{
+	CompileTestContext context;
+	PipelineCompileQueue queue;
+	InitCompileQueue(&queue, &context, 2, 0);
+
+	uint32 first = queue.Submit(ToJob(0));
+	uint32 second = queue.Submit(ToJob(2));
+	TEST_REQUIRE(first != PIPELINE_COMPILE_INVALID_ID && second != PIPELINE_COMPILE_INVALID_ID);
+	TEST_CHECK(queue.Submit(ToJob(4)) == PIPELINE_COMPILE_INVALID_ID);
+
+	queue.Release(first);
+	TEST_CHECK(queue.Submit(ToJob(4)) == PIPELINE_COMPILE_INVALID_ID);
+
+	// Pops the released job on the way to the second one.
+	TEST_CHECK(queue.CompileOne());
+	uint32 third = queue.Submit(ToJob(4));
+	TEST_CHECK(third == first);
+	TEST_CHECK(queue.GetState(third) == PIPELINE_COMPILE_STATE_QUEUED);
+
+	queue.Clean();
+	TEST_CHECK(context.discards[0] == 1 && context.discards[2] == 1 && context.discards[4] == 1);
+}
+
+// A job released while a worker compiles it is discarded by that worker.
+static void TestCompileQueueReleaseCompiling()
+{
+	CompileTestContext context;
+	context.block = true;
+
+	PipelineCompileQueue queue;
+	InitCompileQueue(&queue, &context, 4, 1);
+
+	uint32 jobId = queue.Submit(ToJob(8));
+	TEST_REQUIRE(jobId != PIPELINE_COMPILE_INVALID_ID);
+	while (queue.GetState(jobId) != PIPELINE_COMPILE_STATE_COMPILING)
+	{
+		std::this_thread::yield();
+	}
+
+	queue.Release(jobId);
+	TEST_CHECK(queue.GetState(jobId) == PIPELINE_COMPILE_STATE_FREE);
+	TEST_CHECK(context.discards[8] == 0);
+
+	context.unblock = true;
+	while (context.discards[8] == 0)
+	{
+		std::this_thread::yield();
+	}
+
+	queue.Clean();
+	TEST_CHECK(context.compiles[8] == 1);
+	TEST_CHECK(context.discards[8] == 1);
+}
+
+/*
+============
+BC Encoder
+============
+*/
+
+// The crate's top mip decoded and halved with a box filter, which breaks up
+// its 4x4 blocks: a real albedo map that is not already BC friendly.
+static bool LoadBCTestImage(std::vector<uint8>* outPixels, uint32* outWidth, uint32* outHeight)
+{
+	char filename[512];
+	snprintf(filename, sizeof(filename), "%s/Assets/WoodCrate01.dds", UnitTest::GetDataDirectory());
+
+	DDSFileView view;
+	if (!DDSFile::Open(filename, &view))
+		return false;
+
+	uint32 width = view.info.width;
+	uint32 height = view.info.height;
+	std::vector<uint8> decoded(static_cast<size_t>(width) * height * 4);
+	bool decompressed = BCEncoder::Decompress(DDSFile::GetMipData(view, 0), width, height, view.info.format, decoded.data());
+	DDSFile::Close(&view);
+	if (!decompressed)
+		return false;
+
+	*outWidth = width / 2;
+	*outHeight = height / 2;
+	outPixels->resize(static_cast<size_t>(*outWidth) * *outHeight * 4);
+	for (uint32 y = 0; y < *outHeight; y++)
+	{
+		for (uint32 x = 0; x < *outWidth; x++)
+		{
+			for (uint32 c = 0; c < 4; c++)
+			{
+				uint32 sum = decoded[((y * 2) * width + x * 2) * 4 + c] + decoded[((y * 2) * width + x * 2 + 1) * 4 + c] +
+					decoded[((y * 2 + 1) * width + x * 2) * 4 + c] + decoded[((y * 2 + 1) * width + x * 2 + 1) * 4 + c];
+				(*outPixels)[(y * *outWidth + x) * 4 + c] = static_cast<uint8>((sum + 2) / 4);
+			}
+		}
+	}
+	return true;
+}
+
+// Floors half a dB under what each format and quality reaches on the crate,
+// so a quality regression fails here before it ships.
+static void TestBCEncoderPsnr()
+{
+	const DDS_FORMAT FORMATS[] = { DDS_FORMAT_BC1_UNORM, DDS_FORMAT_BC3_UNORM, DDS_FORMAT_BC7_UNORM };
+	const char* FORMAT_NAMES[] = { "BC1", "BC3", "BC7" };
+	const char* QUALITY_NAMES[] = { "fast", "normal", "high" };
+	// Measured: BC1 33.1, 34.3, 34.3; BC3 34.3, 35.5, 35.6; BC7 37.8, 39.7, 40.0.
+	const float MIN_PSNR[3][3] = {
+		{ 32.5f, 33.75f, 33.75f },
+		{ 33.75f, 35.0f, 35.0f },
+		{ 37.25f, 39.25f, 39.5f },
+	};
+
+	std::vector<uint8> pixels;
+	uint32 width = 0;
+	uint32 height = 0;
+	TEST_REQUIRE(LoadBCTestImage(&pixels, &width, &height));
+
+	std::vector<uint8> blocks(width * height);
+	std::vector<uint8> decoded(width * height * 4);
+
+	for (uint32 format = 0; format < 3; format++)
+	{
+		// BC1 keeps alpha opaque here, so it is measured over RGB only.
+		bool includeAlpha = FORMATS[format] != DDS_FORMAT_BC1_UNORM;
+		float previousPsnr = 0.0f;
+		for (uint32 quality = BC_QUALITY_FAST; quality <= BC_QUALITY_HIGH; quality++)
+		{
+			TEST_REQUIRE(BCEncoder::Compress(pixels.data(), width, height, FORMATS[format], static_cast<BC_QUALITY>(quality), 0, blocks.data()));
+			TEST_REQUIRE(BCEncoder::Decompress(blocks.data(), width, height, FORMATS[format], decoded.data()));
+
+			float psnr = BCEncoder::ComputePsnr(pixels.data(), decoded.data(), width, height, includeAlpha);
+			printf("  %s %s: %.2f dB\n", FORMAT_NAMES[format], QUALITY_NAMES[quality], psnr);
+			TEST_CHECK(psnr >= MIN_PSNR[format][quality]);
+
+			// Higher qualities never do worse.
+			TEST_CHECK(psnr >= previousPsnr - 0.01f);
+			previousPsnr = psnr;
+		}
+	}
+}
+
+/*
+==========
+DDS File
+==========
+*/
+
+// The checked-in crate texture: 512x512 DXT5 with a full chain of 10 mips.
+static void TestDDSFileWoodCrate()
+{
+	char filename[512];
+	snprintf(filename, sizeof(filename), "%s/Assets/WoodCrate01.dds", UnitTest::GetDataDirectory());
+
+	DDSFileView view;
+	TEST_REQUIRE(DDSFile::Open(filename, &view));
+
+	const DDSTextureInfo& info = view.info;
+	TEST_CHECK(info.format == DDS_FORMAT_BC3_UNORM);
+	TEST_CHECK(info.width == 512 && info.height == 512);
+	TEST_CHECK(info.mipLevels == 10);
+	TEST_CHECK(info.arraySize == 1 && !info.isCubemap);
+	TEST_CHECK(info.dataOffset == 128);
+
+	// 16 bytes per 4x4 block; mips under 4 pixels still take a whole block.
+	uint64 offset = 0;
+	for (uint32 mip = 0; mip < info.mipLevels; mip++)
+	{
+		uint32 dimension = 512 >> mip;
+		uint32 blocks = dimension < 4 ? 1 : dimension / 4;
+		const DDSMipLayout& layout = info.mips[mip];
+		TEST_CHECK(layout.width == dimension && layout.height == dimension);
+		TEST_CHECK(layout.rowPitch == blocks * 16);
+		TEST_CHECK(layout.rowsCount == blocks);
+		TEST_CHECK(layout.size == static_cast<uint64>(blocks) * blocks * 16);
+		TEST_CHECK(layout.offset == offset);
+		TEST_CHECK(DDSFile::GetMipData(view, mip) == view.mapping.data + 128 + offset);
+		offset += layout.size;
+	}
+	TEST_CHECK(info.sliceSize == offset);
+	TEST_CHECK(view.mapping.size == 128 + offset);
+
+	DDSFile::Close(&view);
+}
+
+// A DX10 header for an 8x8 R8 texture, one mip, with 64 bytes per slice.
+static uint32 MakeDX10Header(uint8* data, uint32 arraySize, bool isCubemap)
+{
+	const uint32 fields[] = {
+		DDS_MAGIC, 124, 0x1007, 8, 8, 8, 1, 1,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		32, 0x4, 0x30315844, 0, 0, 0, 0, 0,		// 'DX10'
+		0x1000, 0, 0, 0, 0,
+		DDS_FORMAT_R8_UNORM, 3, isCubemap ? 0x4u : 0u, arraySize, 0,
+	};
+	memcpy(data, fields, sizeof(fields));
+	return sizeof(fields);
+}
+
+// Array sizes past D3D12's limit, including ones that wrap once multiplied
+// by six faces, are rejected before the file size is checked against them.
+static void TestDDSFileArraySize()
+{
+	const uint32 SLICE_SIZE = 64;
+	const uint64 BUFFER_SIZE = 148 + SLICE_SIZE * DDS_MAX_ARRAY_SIZE;
+	uint8* data = new uint8[BUFFER_SIZE]();
+
+	DDSTextureInfo info;
+	uint32 headerSize = MakeDX10Header(data, DDS_MAX_ARRAY_SIZE, false);
+	TEST_CHECK(headerSize == 148);
+	TEST_CHECK(DDSFile::Parse(data, BUFFER_SIZE, &info));
+	TEST_CHECK(info.arraySize == DDS_MAX_ARRAY_SIZE && info.sliceSize == SLICE_SIZE);
+	TEST_CHECK(!DDSFile::Parse(data, BUFFER_SIZE - 1, &info));
+
+	MakeDX10Header(data, DDS_MAX_ARRAY_SIZE + 1, false);
+	TEST_CHECK(!DDSFile::Parse(data, BUFFER_SIZE, &info));
+
+	MakeDX10Header(data, DDS_MAX_ARRAY_SIZE / 6, true);
+	TEST_CHECK(DDSFile::Parse(data, BUFFER_SIZE, &info));
+	TEST_CHECK(info.isCubemap && info.arraySize == DDS_MAX_ARRAY_SIZE / 6 * 6);
+
+	MakeDX10Header(data, DDS_MAX_ARRAY_SIZE / 6 + 1, true);
+	TEST_CHECK(!DDSFile::Parse(data, BUFFER_SIZE, &info));
+
+	// 0x2aaaaaab * 6 wraps to 2 in 32 bits.
+	MakeDX10Header(data, 0x2aaaaaab, true);
+	TEST_CHECK(!DDSFile::Parse(data, BUFFER_SIZE, &info));
+
+	MakeDX10Header(data, 0xffffffff, false);
+	TEST_CHECK(!DDSFile::Parse(data, BUFFER_SIZE, &info));
+	TEST_CHECK(info.arraySize == 0);
+
+	// Headers alone, and truncated headers.
+	MakeDX10Header(data, 1, false);
+	TEST_CHECK(!DDSFile::Parse(data, headerSize, &info));
+	TEST_CHECK(!DDSFile::Parse(data, headerSize - 1, &info));
+	TEST_CHECK(!DDSFile::Parse(data, 100, &info));
+
+	delete[] data;
+}
+
+/*
+============
+Frame Stats
+============
+*/
+
+// Byte counters past 2^24 stay exact, which they did not as floats.
+static void TestFrameStatsLargeCounters()
+{
+	FrameStats stats;
+	stats.Init(4);
+
+	const uint64 HEAP_BYTES = (5ull << 32) + 3;
+	stats.Set(FRAME_STAT_LOCAL_MEMORY_BYTES, HEAP_BYTES);
+	stats.Set(FRAME_STAT_UPLOAD_BYTES, (1u << 24) + 1);
+	for (uint32 i = 0; i < 16; i++)
+	{
+		stats.Add(FRAME_STAT_TRIANGLES, 1 << 20);
+	}
+	stats.Add(FRAME_STAT_TRIANGLES, 1);
+	stats.SetMilliseconds(FRAME_STAT_FRAME_MILLISECONDS, 16.5f);
+	stats.EndFrame();
+
+	TEST_CHECK(stats.GetSummary(FRAME_STAT_LOCAL_MEMORY_BYTES).last == static_cast<double>(HEAP_BYTES));
+	TEST_CHECK(stats.GetSummary(FRAME_STAT_UPLOAD_BYTES).last == (1u << 24) + 1);
+	TEST_CHECK(stats.GetSummary(FRAME_STAT_TRIANGLES).last == (1u << 24) + 1);
+	TEST_CHECK(stats.GetSummary(FRAME_STAT_FRAME_MILLISECONDS).last == 16.5);
+
+	// Counters restart every frame.
+	stats.Set(FRAME_STAT_LOCAL_MEMORY_BYTES, HEAP_BYTES + 2);
+	stats.EndFrame();
+	TEST_CHECK(stats.GetSummary(FRAME_STAT_TRIANGLES).last == 0.0);
+
+	FrameStatSummary memory = stats.GetSummary(FRAME_STAT_LOCAL_MEMORY_BYTES);
+	TEST_CHECK(memory.average == static_cast<double>(HEAP_BYTES + 1));
+	TEST_CHECK(memory.p50 == static_cast<double>(HEAP_BYTES));
+	TEST_CHECK(memory.max == static_cast<double>(HEAP_BYTES + 2));
+	TEST_CHECK(stats.GetFramesCount() == 2);
+
+	stats.Clean();
+}
+
+// Nearest-rank percentiles over the history, which keeps the newest frames.
+static void TestFrameStatsPercentiles()
+{
+	FrameStats stats;
+	stats.Init(100);
+
+	// 200 frames: only 101 to 200 are kept.
+	for (uint32 i = 1; i <= 200; i++)
+	{
+		stats.Set(FRAME_STAT_DRAW_CALLS, i);
+		stats.EndFrame();
+	}
+
+	FrameStatSummary draws = stats.GetSummary(FRAME_STAT_DRAW_CALLS);
+	TEST_CHECK(stats.GetFramesCount() == 100);
+	TEST_CHECK(draws.last == 200.0);
+	TEST_CHECK(draws.average == 150.5);
+	TEST_CHECK(draws.p50 == 150.0);
+	TEST_CHECK(draws.p95 == 195.0);
+	TEST_CHECK(draws.p99 == 199.0);
+	TEST_CHECK(draws.max == 200.0);
+
+	stats.Clean();
+}
+
+/*
+===========
+Image File
+===========
+*/
+
+// A 2x1 TGA whose 8-bit pixels index a map of 24-bit BGR entries.
+static std::vector<uint8> MakeColorMappedTga(uint16 colorMapLength)
+{
+	std::vector<uint8> tga(18, 0);
+	tga[1] = 1;						// Has a color map.
+	tga[2] = 1;						// Color-mapped, uncompressed.
+	tga[5] = static_cast<uint8>(colorMapLength);
+	tga[6] = static_cast<uint8>(colorMapLength >> 8);
+	tga[7] = 24;
+	tga[12] = 2;
+	tga[14] = 1;
+	tga[16] = 8;
+	tga[17] = 0x20;					// Top to bottom.
+
+	for (uint32 i = 0; i < colorMapLength; i++)
+	{
+		const uint8 ENTRY[3] = { static_cast<uint8>(i * 10), static_cast<uint8>(i * 20), static_cast<uint8>(i * 30) };
+		tga.insert(tga.end(), ENTRY, ENTRY + 3);
+	}
+
+	tga.push_back(1);
+	tga.push_back(0);
+	return tga;
+}
+
+// Pixels read their map entry; a color-mapped image without entries is
+// rejected instead of reading past the map.
+static void TestImageFileColorMappedTga()
+{
+	std::vector<uint8> tga = MakeColorMappedTga(2);
+	ImageData image;
+	TEST_REQUIRE(ImageFile::LoadTga(tga.data(), tga.size(), &image));
+	TEST_REQUIRE(image.width == 2 && image.height == 1);
+
+	const uint8 EXPECTED[8] = { 30, 20, 10, 255, 0, 0, 0, 255 };
+	TEST_CHECK(memcmp(image.pixels, EXPECTED, sizeof(EXPECTED)) == 0);
+	ImageFile::Destroy(&image);
+
+	tga = MakeColorMappedTga(0);
+	TEST_CHECK(!ImageFile::LoadTga(tga.data(), tga.size(), &image));
+	TEST_CHECK(image.pixels == nullptr);
+}
+
+// Writes fixed Huffman deflate codes, most significant bit first as deflate
+// stores Huffman codes.
+struct DeflateWriter
+{
+	std::vector<uint8> bytes;
+	uint32 bitsCount = 0;
+
+	void WriteBits(uint32 value, uint32 count)
+	{
+		for (uint32 i = 0; i < count; i++)
+		{
+			if (bitsCount % 8 == 0)
+				bytes.push_back(0);
+			bytes.back() |= static_cast<uint8>(((value >> i) & 1) << (bitsCount % 8));
+			bitsCount++;
+		}
+	}
+
+	void WriteCode(uint32 code, uint32 length)
+	{
+		for (uint32 i = length; i > 0; i--)
+		{
+			WriteBits((code >> (i - 1)) & 1, 1);
+		}
+	}
+
+	void WriteLiteral(uint8 value)
+	{
+		if (value < 144)
+			WriteCode(0x30 + value, 8);
+		else
+			WriteCode(0x190 + value - 144, 9);
+	}
+};
+
+static void AppendPngChunk(std::vector<uint8>* png, const char* type, const std::vector<uint8>& data)
+{
+	uint32 length = static_cast<uint32>(data.size());
+	const uint8 LENGTH[4] = { static_cast<uint8>(length >> 24), static_cast<uint8>(length >> 16), static_cast<uint8>(length >> 8), static_cast<uint8>(length) };
+	png->insert(png->end(), LENGTH, LENGTH + 4);
+	png->insert(png->end(), type, type + 4);
+	png->insert(png->end(), data.begin(), data.end());
+
+	// The loader does not check CRCs.
+	png->insert(png->end(), 4, 0);
+}
+
+// A 1x1 8-bit gray PNG: its filtered data is the filter byte and one sample.
+// After those, copiesCount matches of 258 bytes each repeat the sample.
+static std::vector<uint8> MakeGrayPng(uint8 sample, uint32 copiesCount)
+{
+	DeflateWriter deflate;
+	deflate.WriteBits(1, 1);		// Last block.
+	deflate.WriteBits(1, 2);		// Fixed Huffman codes.
+	deflate.WriteLiteral(0);
+	deflate.WriteLiteral(sample);
+	for (uint32 i = 0; i < copiesCount; i++)
+	{
+		deflate.WriteCode(0xc5, 8);	// Length 258.
+		deflate.WriteCode(0, 5);	// Distance 1.
+	}
+	deflate.WriteCode(0, 7);		// End of block.
+
+	std::vector<uint8> idat = { 0x78, 0x01 };
+	idat.insert(idat.end(), deflate.bytes.begin(), deflate.bytes.end());
+	idat.insert(idat.end(), 4, 0);	// Adler-32, not checked either.
+
+	const uint8 PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	std::vector<uint8> png(PNG_SIGNATURE, PNG_SIGNATURE + 8);
+	AppendPngChunk(&png, "IHDR", { 0, 0, 0, 1, 0, 0, 0, 1, 8, 0, 0, 0, 0 });
+	AppendPngChunk(&png, "IDAT", idat);
+	AppendPngChunk(&png, "IEND", {});
+	return png;
+}
+
+// Inflate stops at the size the header implies, so a small file cannot
+// expand into a large allocation.
+static void TestImageFileInflateCap()
+{
+	std::vector<uint8> png = MakeGrayPng(128, 0);
+	ImageData image;
+	TEST_REQUIRE(ImageFile::LoadPng(png.data(), png.size(), &image));
+	TEST_REQUIRE(image.width == 1 && image.height == 1);
+	TEST_CHECK(image.pixels[0] == 128 && image.pixels[1] == 128 && image.pixels[2] == 128 && image.pixels[3] == 255);
+	ImageFile::Destroy(&image);
+
+	// Under 7 KB that would inflate to over 1 MB.
+	png = MakeGrayPng(128, 4096);
+	TEST_CHECK(png.size() < 7 * 1024);
+	TEST_CHECK(!ImageFile::LoadPng(png.data(), png.size(), &image));
+	TEST_CHECK(image.pixels == nullptr);
+}
+
+/*
+==========
+Mesh File
+==========
+*/
+
+static void FreeMeshData(MeshData* meshData)
+{
+	delete[] meshData->vertices;
+	delete[] meshData->indices;
+	*meshData = {};
+}
+
+// A cooked sphere with LODs and meshlets, as the Cooker writes it.
+struct MeshFileTestData
+{
+	MeshData meshData;
+	MeshLodChain lodChain;
+	MeshletData meshletData;
+	std::vector<uint8> file;
+};
+
+static bool CookTestMesh(const char* filename, MeshFileTestData* outData)
+{
+	outData->meshData = GeometryGenerator::MakeSphere(1.0f, 48, 24);
+	if (!MeshSimplifier::BuildLodChain(outData->meshData, &outData->lodChain) || !MeshletBuilder::Build(outData->meshData, &outData->meshletData))
+		return false;
+
+	if (!MeshFile::Write(filename, outData->meshData, &outData->lodChain, &outData->meshletData))
+		return false;
+
+	FileMapping mapping;
+	if (!FileSystem::MapFile(filename, &mapping))
+		return false;
+
+	outData->file.assign(mapping.data, mapping.data + mapping.size);
+	FileSystem::UnmapFile(&mapping);
+	return true;
+}
+
+static void FreeTestMesh(MeshFileTestData* data)
+{
+	MeshletBuilder::Destroy(&data->meshletData);
+	MeshSimplifier::Destroy(&data->lodChain);
+	FreeMeshData(&data->meshData);
+	remove("MeshFileTest.xmsh");
+}
+
+// Opens a copy of the cooked file, patched by corrupt, from memory.
+template <typename Corruption>
+static bool OpenCorrupted(const std::vector<uint8>& file, Corruption corrupt)
+{
+	std::vector<uint8> copy = file;
+	MeshFileHeader* header = reinterpret_cast<MeshFileHeader*>(copy.data());
+	uint64 size = copy.size();
+	corrupt(copy.data(), header, &size);
+
+	FileMapping mapping;
+	mapping.data = copy.data();
+	mapping.size = size;
+
+	MeshFileView view;
+	return MeshFile::Open(mapping, &view);
+}
+
+template <typename T>
+static T* GetSection(uint8* file, const MeshFileHeader* header, MESH_FILE_SECTION section)
+{
+	return reinterpret_cast<T*>(file + header->sections[section].offset);
+}
+
+static void TestMeshFileRoundTrip()
+{
+	MeshFileTestData data;
+	TEST_REQUIRE(CookTestMesh("MeshFileTest.xmsh", &data));
+
+	MeshFileView view;
+	TEST_REQUIRE(MeshFile::Open("MeshFileTest.xmsh", &view));
+
+	const MeshFileHeader& header = *view.header;
+	TEST_CHECK(header.verticesCount == data.meshData.verticesCount);
+	TEST_CHECK(header.indicesCount == data.lodChain.indicesCount);
+	TEST_CHECK(header.lodsCount == data.lodChain.lodsCount);
+	TEST_CHECK(header.meshletsCount == data.meshletData.meshletsCount);
+	TEST_CHECK(header.meshletVerticesCount == data.meshletData.verticesCount);
+	TEST_CHECK(header.meshletTrianglesCount == data.meshletData.trianglesCount);
+	TEST_CHECK(header.flags == MESH_FILE_FLAG_MESHLET_ORDERED);
+	TEST_CHECK(header.boundsRadius > 0.99f && header.boundsRadius < 1.01f);
+
+	TEST_CHECK(memcmp(view.vertices, data.meshData.vertices, sizeof(Vertex) * header.verticesCount) == 0);
+	TEST_CHECK(memcmp(view.lods, data.lodChain.lods, sizeof(MeshLod) * header.lodsCount) == 0);
+	TEST_CHECK(memcmp(view.meshlets, data.meshletData.meshlets, sizeof(Meshlet) * header.meshletsCount) == 0);
+	TEST_CHECK(memcmp(view.meshletBounds, data.meshletData.bounds, sizeof(MeshletBounds) * header.meshletsCount) == 0);
+	TEST_CHECK(memcmp(view.meshletVertices, data.meshletData.vertices, sizeof(uint32) * header.meshletVerticesCount) == 0);
+	TEST_CHECK(memcmp(view.meshletTriangles, data.meshletData.triangles, 3 * header.meshletTrianglesCount) == 0);
+
+	// LOD 0 comes back in meshlet order, the coarser LODs as they were.
+	std::vector<Index> expanded(data.meshletData.trianglesCount * 3);
+	MeshletBuilder::ExpandIndices(data.meshletData, expanded.data());
+	TEST_CHECK(memcmp(view.indices, expanded.data(), sizeof(Index) * expanded.size()) == 0);
+
+	uint32 lod0Count = data.lodChain.lods[0].indicesCount;
+	TEST_CHECK(memcmp(view.indices + lod0Count, data.lodChain.indices + lod0Count, sizeof(Index) * (header.indicesCount - lod0Count)) == 0);
+
+	for (uint32 i = 0; i < MESH_FILE_SECTION_COUNT; i++)
+	{
+		TEST_CHECK(header.sections[i].offset % MESH_FILE_ALIGNMENT == 0);
+	}
+
+	MeshFile::Close(&view);
+	FreeTestMesh(&data);
+}
+
+// Headers and sections that would send the renderer out of bounds.
+static void TestMeshFileCorrupt()
+{
+	MeshFileTestData data;
+	TEST_REQUIRE(CookTestMesh("MeshFileTest.xmsh", &data));
+	const std::vector<uint8>& file = data.file;
+
+	TEST_CHECK(OpenCorrupted(file, [](uint8*, MeshFileHeader*, uint64*) {}));
+
+	TEST_CHECK(!OpenCorrupted(file, [](uint8*, MeshFileHeader*, uint64* size) { *size = sizeof(MeshFileHeader) - 1; }));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8*, MeshFileHeader*, uint64* size) { *size -= 1; }));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8*, MeshFileHeader* header, uint64*) { header->magic = 0; }));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8*, MeshFileHeader* header, uint64*) { header->version++; }));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8*, MeshFileHeader* header, uint64*) { header->vertexStride++; }));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8*, MeshFileHeader* header, uint64*) { header->lodsCount = MESH_MAX_LODS + 1; }));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8*, MeshFileHeader* header, uint64*) { header->verticesCount++; }));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8*, MeshFileHeader* header, uint64*) { header->sections[MESH_FILE_SECTION_INDICES].offset += MESH_FILE_ALIGNMENT * 1000000; }));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8*, MeshFileHeader* header, uint64*) { header->sections[MESH_FILE_SECTION_VERTICES].offset++; }));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8*, MeshFileHeader* header, uint64*) { header->flags = 0; }));
+
+	// Contents.
+	TEST_CHECK(!OpenCorrupted(file, [](uint8* data, MeshFileHeader* header, uint64*) {
+		GetSection<Index>(data, header, MESH_FILE_SECTION_INDICES)[header->indicesCount - 1] = header->verticesCount;
+	}));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8* data, MeshFileHeader* header, uint64*) {
+		GetSection<MeshLod>(data, header, MESH_FILE_SECTION_LODS)[1].indexOffset = header->indicesCount;
+	}));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8* data, MeshFileHeader* header, uint64*) {
+		GetSection<MeshLod>(data, header, MESH_FILE_SECTION_LODS)[0].indicesCount -= 3;
+	}));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8* data, MeshFileHeader* header, uint64*) {
+		GetSection<MeshLod>(data, header, MESH_FILE_SECTION_LODS)[0].indexOffset = 3;
+	}));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8* data, MeshFileHeader* header, uint64*) {
+		GetSection<Meshlet>(data, header, MESH_FILE_SECTION_MESHLETS)[header->meshletsCount - 1].vertexOffset = header->meshletVerticesCount;
+	}));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8* data, MeshFileHeader* header, uint64*) {
+		GetSection<Meshlet>(data, header, MESH_FILE_SECTION_MESHLETS)[0].triangleOffset = header->meshletTrianglesCount * 3;
+	}));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8* data, MeshFileHeader* header, uint64*) {
+		GetSection<Meshlet>(data, header, MESH_FILE_SECTION_MESHLETS)[0].vertexCount = MESHLET_MAX_VERTICES + 1;
+	}));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8* data, MeshFileHeader* header, uint64*) {
+		GetSection<uint32>(data, header, MESH_FILE_SECTION_MESHLET_VERTICES)[0] = header->verticesCount;
+	}));
+	TEST_CHECK(!OpenCorrupted(file, [](uint8* data, MeshFileHeader* header, uint64*) {
+		const Meshlet& meshlet = GetSection<Meshlet>(data, header, MESH_FILE_SECTION_MESHLETS)[0];
+		GetSection<uint8>(data, header, MESH_FILE_SECTION_MESHLET_TRIANGLES)[meshlet.triangleOffset] = meshlet.vertexCount;
+	}));
+
+	FreeTestMesh(&data);
+}
+
+/*
+==============
+Mesh Importer
+==============
+*/
+
+static bool WriteTestFile(const char* filename, const void* data, size_t size)
+{
+	FILE* file = fopen(filename, "wb");
+	if (!file)
+		return false;
+
+	bool result = fwrite(data, 1, size, file) == size;
+	fclose(file);
+	return result;
+}
+
+static std::string EncodeBase64(const uint8* data, size_t size)
+{
+	static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	std::string text;
+	for (size_t i = 0; i < size; i += 3)
+	{
+		uint32 bits = data[i] << 16;
+		if (i + 1 < size)
+			bits |= data[i + 1] << 8;
+		if (i + 2 < size)
+			bits |= data[i + 2];
+
+		text.push_back(ALPHABET[(bits >> 18) & 63]);
+		text.push_back(ALPHABET[(bits >> 12) & 63]);
+		text.push_back(i + 1 < size ? ALPHABET[(bits >> 6) & 63] : '=');
+		text.push_back(i + 2 < size ? ALPHABET[bits & 63] : '=');
+	}
+	return text;
+}
+
+static const float IMPORTER_QUAD_POSITIONS[4][3] = { { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 2.0f }, { 1.0f, 1.0f, 3.0f }, { 0.0f, 1.0f, 4.0f } };
+static const float IMPORTER_QUAD_TEXCOORDS[4][2] = { { 0.0f, 1.0f }, { 1.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, 0.0f } };
+static const Index IMPORTER_QUAD_INDICES[6] = { 0, 1, 2, 0, 2, 3 };
+
+// A quad with positions, texcoords and six indices of componentType in one
+// buffer, stored next to the document or embedded as a data uri.
+static bool WriteGltfQuad(const char* filename, uint32 componentType, bool embedded)
+{
+	uint32 indexSize = componentType == 5121 ? 1 : componentType == 5123 || componentType == 5122 ? 2 : 4;
+
+	std::vector<uint8> buffer(sizeof(IMPORTER_QUAD_POSITIONS) + sizeof(IMPORTER_QUAD_TEXCOORDS) + 6 * indexSize);
+	memcpy(buffer.data(), IMPORTER_QUAD_POSITIONS, sizeof(IMPORTER_QUAD_POSITIONS));
+	memcpy(buffer.data() + sizeof(IMPORTER_QUAD_POSITIONS), IMPORTER_QUAD_TEXCOORDS, sizeof(IMPORTER_QUAD_TEXCOORDS));
+	uint8* indices = buffer.data() + sizeof(IMPORTER_QUAD_POSITIONS) + sizeof(IMPORTER_QUAD_TEXCOORDS);
+	for (uint32 i = 0; i < 6; i++)
+	{
+		if (componentType == 5126)
+		{
+			float value = static_cast<float>(IMPORTER_QUAD_INDICES[i]);
+			memcpy(indices + i * 4, &value, 4);
+		}
+		else
+		{
+			// Little endian, truncated to the component size.
+			memcpy(indices + i * indexSize, &IMPORTER_QUAD_INDICES[i], indexSize);
+		}
+	}
+
+	std::string uri = "MeshImporterTest.bin";
+	if (embedded)
+		uri = "data:application/octet-stream;base64," + EncodeBase64(buffer.data(), buffer.size());
+	else if (!WriteTestFile(uri.c_str(), buffer.data(), buffer.size()))
+		return false;
+
+	char json[1024];
+	snprintf(json, sizeof(json),
+		"{ \"asset\": { \"version\": \"2.0\" },"
+		" \"buffers\": [ { \"byteLength\": %zu, \"uri\": \"%%s\" } ],"
+		" \"bufferViews\": [ { \"buffer\": 0, \"byteOffset\": 0, \"byteLength\": 48 }, { \"buffer\": 0, \"byteOffset\": 48, \"byteLength\": 32 }, { \"buffer\": 0, \"byteOffset\": 80, \"byteLength\": %u } ],"
+		" \"accessors\": [ { \"bufferView\": 0, \"componentType\": 5126, \"count\": 4, \"type\": \"VEC3\" }, { \"bufferView\": 1, \"componentType\": 5126, \"count\": 4, \"type\": \"VEC2\" }, { \"bufferView\": 2, \"componentType\": %u, \"count\": 6, \"type\": \"SCALAR\" } ],"
+		" \"meshes\": [ { \"primitives\": [ { \"attributes\": { \"POSITION\": 0, \"TEXCOORD_0\": 1 }, \"indices\": 2 } ] } ] }",
+		buffer.size(), 6 * indexSize, componentType);
+
+	std::vector<char> document(strlen(json) + uri.size());
+	int length = snprintf(document.data(), document.size(), json, uri.c_str());
+	return WriteTestFile(filename, document.data(), length);
+}
+
+static void CheckImportedQuad(const MeshData& meshData)
+{
+	TEST_REQUIRE(meshData.verticesCount == 4 && meshData.indicesCount == 6);
+	TEST_CHECK(memcmp(meshData.indices, IMPORTER_QUAD_INDICES, sizeof(IMPORTER_QUAD_INDICES)) == 0);
+
+	// Left-handed: z is negated.
+	for (uint32 i = 0; i < 4; i++)
+	{
+		const Vertex& vertex = meshData.vertices[i];
+		TEST_CHECK(vertex.posModel.x == IMPORTER_QUAD_POSITIONS[i][0]);
+		TEST_CHECK(vertex.posModel.y == IMPORTER_QUAD_POSITIONS[i][1]);
+		TEST_CHECK(vertex.posModel.z == -IMPORTER_QUAD_POSITIONS[i][2]);
+		TEST_CHECK(vertex.texCoord.x == IMPORTER_QUAD_TEXCOORDS[i][0]);
+		TEST_CHECK(vertex.texCoord.y == IMPORTER_QUAD_TEXCOORDS[i][1]);
+		TEST_CHECK(vertex.color.x == 1.0f && vertex.color.w == 1.0f);
+	}
+}
+
+// Unsigned byte, short and int index accessors read as integers; float and
+// signed indices are not valid glTF.
+static void TestMeshImporterGltfIndices()
+{
+	const uint32 VALID_TYPES[] = { 5121, 5123, 5125 };
+	for (uint32 componentType : VALID_TYPES)
+	{
+		TEST_REQUIRE(WriteGltfQuad("MeshImporterTest.gltf", componentType, false));
+
+		MeshData meshData = {};
+		TEST_CHECK(MeshImporter::Load("MeshImporterTest.gltf", &meshData));
+		CheckImportedQuad(meshData);
+		MeshImporter::Destroy(&meshData);
+	}
+
+	const uint32 INVALID_TYPES[] = { 5122, 5126 };
+	for (uint32 componentType : INVALID_TYPES)
+	{
+		TEST_REQUIRE(WriteGltfQuad("MeshImporterTest.gltf", componentType, false));
+
+		MeshData meshData = {};
+		TEST_CHECK(!MeshImporter::Load("MeshImporterTest.gltf", &meshData));
+	}
+
+	remove("MeshImporterTest.gltf");
+	remove("MeshImporterTest.bin");
+}
+
+static void TestMeshImporterGltfEmbedded()
+{
+	TEST_REQUIRE(WriteGltfQuad("MeshImporterTest.gltf", 5123, true));
+
+	MeshData meshData = {};
+	TEST_CHECK(MeshImporter::Load("MeshImporterTest.gltf", &meshData));
+	CheckImportedQuad(meshData);
+	MeshImporter::Destroy(&meshData);
+
+	remove("MeshImporterTest.gltf");
+}
+
+// External buffers are part of the key; embedded ones are already in the document.
+static void TestMeshImporterHashDependencies()
+{
+	TEST_REQUIRE(WriteGltfQuad("MeshImporterTest.gltf", 5123, false));
+
+	uint64 key = 0;
+	TEST_CHECK(MeshImporter::HashDependencies("MeshImporterTest.gltf", &key));
+	uint64 sameKey = 0;
+	TEST_CHECK(MeshImporter::HashDependencies("MeshImporterTest.gltf", &sameKey));
+	TEST_CHECK(key != 0 && key == sameKey);
+
+	TEST_REQUIRE(WriteGltfQuad("MeshImporterTest.gltf", 5125, false));
+	uint64 editedKey = 0;
+	TEST_CHECK(MeshImporter::HashDependencies("MeshImporterTest.gltf", &editedKey));
+	TEST_CHECK(editedKey != key);
+
+	remove("MeshImporterTest.bin");
+	TEST_CHECK(!MeshImporter::HashDependencies("MeshImporterTest.gltf", &key));
+
+	TEST_REQUIRE(WriteGltfQuad("MeshImporterTest.gltf", 5123, true));
+	uint64 embeddedKey = 0;
+	TEST_CHECK(MeshImporter::HashDependencies("MeshImporterTest.gltf", &embeddedKey));
+	TEST_CHECK(embeddedKey == 0);
+
+	remove("MeshImporterTest.gltf");
+}
+
+// Polygons are fan triangulated, z is negated and texcoords flip to a top-left origin.
+static void TestMeshImporterObj()
+{
+	const char OBJ[] =
+		"# quad\n"
+		"v 0 0 1\nv 1 0 2\nv 1 1 3\nv 0 1 4\n"
+		"vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+		"f 1/1 2/2 3/3 4/4\n";
+	TEST_REQUIRE(WriteTestFile("MeshImporterTest.obj", OBJ, sizeof(OBJ) - 1));
+
+	MeshData meshData = {};
+	TEST_REQUIRE(MeshImporter::Load("MeshImporterTest.obj", &meshData));
+	remove("MeshImporterTest.obj");
+
+	// One vertex per face corner; the cooker welds them later.
+	TEST_REQUIRE(meshData.verticesCount == 6 && meshData.indicesCount == 6);
+	const uint32 CORNERS[6] = { 0, 1, 2, 0, 2, 3 };
+	for (uint32 i = 0; i < 6; i++)
+	{
+		const Vertex& vertex = meshData.vertices[meshData.indices[i]];
+		uint32 corner = CORNERS[i];
+		TEST_CHECK(vertex.posModel.x == IMPORTER_QUAD_POSITIONS[corner][0]);
+		TEST_CHECK(vertex.posModel.y == IMPORTER_QUAD_POSITIONS[corner][1]);
+		TEST_CHECK(vertex.posModel.z == -IMPORTER_QUAD_POSITIONS[corner][2]);
+		TEST_CHECK(vertex.texCoord.x == IMPORTER_QUAD_TEXCOORDS[corner][0]);
+		TEST_CHECK(vertex.texCoord.y == IMPORTER_QUAD_TEXCOORDS[corner][1]);
+	}
+
+	MeshImporter::Destroy(&meshData);
+}
+
+/*
+================
+Meshlet Builder
+================
+*/
+
+struct MeshletTriangle
+{
+	Index indices[3];
+
+	// Rotated so the smallest index comes first, which keeps the winding.
+	static MeshletTriangle Make(Index a, Index b, Index c)
+	{
+		if (b < a && b < c)
+			return { { b, c, a } };
+		if (c < a && c < b)
+			return { { c, a, b } };
+		return { { a, b, c } };
+	}
+
+	bool operator<(const MeshletTriangle& other) const
+	{
+		return memcmp(indices, other.indices, sizeof(indices)) < 0;
+	}
+
+	bool operator==(const MeshletTriangle& other) const
+	{
+		return memcmp(indices, other.indices, sizeof(indices)) == 0;
+	}
+};
+
+static std::vector<MeshletTriangle> GetSortedTriangles(const Index* indices, uint32 trianglesCount)
+{
+	std::vector<MeshletTriangle> triangles(trianglesCount);
+	for (uint32 i = 0; i < trianglesCount; i++)
+	{
+		triangles[i] = MeshletTriangle::Make(indices[i * 3 + 0], indices[i * 3 + 1], indices[i * 3 + 2]);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+// The meshes the builder sees: dense and high-valence at the poles, in mesh
+// order and shuffled, and one too small to split.
+static MeshData MakeMeshletTestMesh(uint32 variant)
+{
+	if (variant == 2)
+		return GeometryGenerator::MakeBox();
+
+	MeshData meshData = GeometryGenerator::MakeSphere(1.0f, 64, 32);
+	if (variant == 1)
+	{
+		uint32 seed = 0x9e3779b9;
+		for (uint32 i = meshData.indicesCount / 3 - 1; i > 0; i--)
+		{
+			seed = seed * 1664525 + 1013904223;
+			uint32 j = (seed >> 8) % (i + 1);
+			for (uint32 k = 0; k < 3; k++)
+			{
+				std::swap(meshData.indices[i * 3 + k], meshData.indices[j * 3 + k]);
+			}
+		}
+	}
+	return meshData;
+}
+
+// Meshlets stay within the limits, pack their ranges back to back, and emit
+// every triangle exactly once with its winding.
+static void TestMeshletBuilderTriangles()
+{
+	for (uint32 variant = 0; variant < 3; variant++)
+	{
+		MeshData meshData = MakeMeshletTestMesh(variant);
+		MeshletData meshletData;
+		TEST_REQUIRE(MeshletBuilder::Build(meshData, &meshletData));
+		TEST_CHECK(meshletData.trianglesCount * 3 == meshData.indicesCount);
+
+		uint32 vertexOffset = 0;
+		uint32 triangleOffset = 0;
+		std::vector<Index> indices;
+		for (uint32 i = 0; i < meshletData.meshletsCount; i++)
+		{
+			const Meshlet& meshlet = meshletData.meshlets[i];
+			TEST_CHECK(meshlet.vertexCount > 0 && meshlet.vertexCount <= MESHLET_MAX_VERTICES);
+			TEST_CHECK(meshlet.triangleCount > 0 && meshlet.triangleCount <= MESHLET_MAX_TRIANGLES);
+			TEST_CHECK(meshlet.vertexOffset == vertexOffset && meshlet.triangleOffset == triangleOffset);
+			vertexOffset += meshlet.vertexCount;
+			triangleOffset += meshlet.triangleCount * 3;
+
+			for (uint32 j = 0; j < meshlet.triangleCount * 3u; j++)
+			{
+				uint8 local = meshletData.triangles[meshlet.triangleOffset + j];
+				TEST_REQUIRE(local < meshlet.vertexCount);
+				indices.push_back(meshletData.vertices[meshlet.vertexOffset + local]);
+			}
+		}
+		TEST_CHECK(vertexOffset == meshletData.verticesCount);
+		TEST_CHECK(triangleOffset == meshletData.trianglesCount * 3);
+
+		TEST_CHECK(GetSortedTriangles(indices.data(), meshletData.trianglesCount) == GetSortedTriangles(meshData.indices, meshData.indicesCount / 3));
+
+		MeshletBuilder::Destroy(&meshletData);
+		FreeMeshData(&meshData);
+	}
+}
+
+// ExpandIndices writes each meshlet's triangles at its own range, the same
+// triangles Build emitted.
+static void TestMeshletBuilderExpandIndices()
+{
+	MeshData meshData = MakeMeshletTestMesh(1);
+	MeshletData meshletData;
+	TEST_REQUIRE(MeshletBuilder::Build(meshData, &meshletData));
+
+	std::vector<Index> expanded(meshletData.trianglesCount * 3, 0xffffffff);
+	MeshletBuilder::ExpandIndices(meshletData, expanded.data());
+
+	for (uint32 i = 0; i < meshletData.meshletsCount; i++)
+	{
+		const Meshlet& meshlet = meshletData.meshlets[i];
+		for (uint32 j = 0; j < meshlet.triangleCount * 3u; j++)
+		{
+			uint8 local = meshletData.triangles[meshlet.triangleOffset + j];
+			TEST_CHECK(expanded[meshlet.triangleOffset + j] == meshletData.vertices[meshlet.vertexOffset + local]);
+		}
+	}
+
+	// Meshlet order is a permutation of the source triangles, so a second build
+	// over it covers the same triangles.
+	TEST_CHECK(GetSortedTriangles(expanded.data(), meshletData.trianglesCount) == GetSortedTriangles(meshData.indices, meshData.indicesCount / 3));
+
+	MeshData reordered = meshData;
+	reordered.indices = expanded.data();
+	MeshletData rebuilt;
+	TEST_REQUIRE(MeshletBuilder::Build(reordered, &rebuilt));
+	std::vector<Index> reexpanded(rebuilt.trianglesCount * 3);
+	MeshletBuilder::ExpandIndices(rebuilt, reexpanded.data());
+	TEST_CHECK(GetSortedTriangles(reexpanded.data(), rebuilt.trianglesCount) == GetSortedTriangles(expanded.data(), meshletData.trianglesCount));
+
+	MeshletBuilder::Destroy(&rebuilt);
+	MeshletBuilder::Destroy(&meshletData);
+	FreeMeshData(&meshData);
+}
+
+static bool IsInsideClip(const Vector3& p, const Matrix& m)
+{
+	float x = p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41;
+	float y = p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42;
+	float z = p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43;
+	float w = p.x * m._14 + p.y * m._24 + p.z * m._34 + m._44;
+	return -w <= x && x <= w && -w <= y && y <= w && 0.0f <= z && z <= w;
+}
+
+// From random cameras, a culled meshlet never has a vertex in the frustum
+// or a triangle facing the camera, as checked triangle by triangle.
+static void TestMeshletBuilderCulling()
+{
+	MeshData meshData = MakeMeshletTestMesh(0);
+	MeshletData meshletData;
+	TEST_REQUIRE(MeshletBuilder::Build(meshData, &meshletData));
+
+	for (uint32 i = 0; i < meshletData.meshletsCount; i++)
+	{
+		const Meshlet& meshlet = meshletData.meshlets[i];
+		const MeshletBounds& bounds = meshletData.bounds[i];
+		for (uint32 j = 0; j < meshlet.vertexCount; j++)
+		{
+			const Vector3& p = meshData.vertices[meshletData.vertices[meshlet.vertexOffset + j]].posModel;
+			TEST_CHECK(Vector3::Distance(p, bounds.center) <= bounds.radius * 1.0001f);
+		}
+	}
+
+	Matrix proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(50.0f), 1.0f, 0.1f, 100.0f);
+	uint32 seed = 0x2545f491;
+	uint32 backfacingCount = 0;
+	uint32 outsideCount = 0;
+	for (uint32 camera = 0; camera < 64; camera++)
+	{
+		float random[4];
+		for (uint32 i = 0; i < 4; i++)
+		{
+			seed = seed * 1664525 + 1013904223;
+			random[i] = static_cast<float>(seed >> 8) / 16777216.0f;
+		}
+
+		// Around the sphere, looking roughly at it.
+		Vector3 eye = Vector3(random[0] - 0.5f, random[1] - 0.5f, random[2] - 0.5f);
+		eye.Normalize();
+		eye *= 1.5f + 3.0f * random[3];
+		Vector3 direction = Vector3(random[1] * 0.6f - 0.3f, random[2] * 0.6f - 0.3f, random[0] * 0.6f - 0.3f) - eye;
+		Matrix worldViewProj = DirectX::XMMatrixLookToLH(eye, direction, Vector3(0.0f, 1.0f, 0.0f)) * proj;
+
+		Vector4 planes[6];
+		MeshletCulling::ExtractFrustumPlanes(worldViewProj, planes);
+
+		for (uint32 i = 0; i < meshletData.meshletsCount; i++)
+		{
+			const Meshlet& meshlet = meshletData.meshlets[i];
+			const MeshletBounds& bounds = meshletData.bounds[i];
+
+			if (MeshletCulling::IsBackfacing(bounds, eye))
+			{
+				backfacingCount++;
+				for (uint32 j = 0; j < meshlet.triangleCount; j++)
+				{
+					const uint8* triangle = meshletData.triangles + meshlet.triangleOffset + j * 3;
+					const Vector3& a = meshData.vertices[meshletData.vertices[meshlet.vertexOffset + triangle[0]]].posModel;
+					const Vector3& b = meshData.vertices[meshletData.vertices[meshlet.vertexOffset + triangle[1]]].posModel;
+					const Vector3& c = meshData.vertices[meshletData.vertices[meshlet.vertexOffset + triangle[2]]].posModel;
+					TEST_CHECK((b - a).Cross(c - a).Dot(a - eye) >= 0.0f);
+				}
+			}
+
+			if (!MeshletCulling::IsSphereVisible(planes, bounds.center, bounds.radius))
+			{
+				outsideCount++;
+				for (uint32 j = 0; j < meshlet.vertexCount; j++)
+				{
+					TEST_CHECK(!IsInsideClip(meshData.vertices[meshletData.vertices[meshlet.vertexOffset + j]].posModel, worldViewProj));
+				}
+			}
+		}
+	}
+
+	// The cone and the sphere do cull.
+	TEST_CHECK(backfacingCount > 0);
+	TEST_CHECK(outsideCount > 0);
+
+	MeshletBuilder::Destroy(&meshletData);
+	FreeMeshData(&meshData);
+}
+
+/*
+===============
+Mesh Optimizer
+===============
+*/
+
+static Vertex MakeTestVertex(float x, float y)
+{
+	Vertex vertex = {};
+	vertex.posModel = Vector3(x, y, 0.0f);
+	vertex.color = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+	vertex.texCoord = Vector2(x, y);
+	return vertex;
+}
+
+// Bit-identical vertices merge, first occurrence first; an index buffer is
+// built when there is none and remapped when there is one.
+static void TestMeshOptimizerWeldVertices()
+{
+	const Vertex CORNERS[6] = { MakeTestVertex(0, 0), MakeTestVertex(1, 0), MakeTestVertex(1, 1), MakeTestVertex(0, 0), MakeTestVertex(1, 1), MakeTestVertex(0, 1) };
+
+	MeshData meshData = {};
+	meshData.vertices = new Vertex[6];
+	meshData.verticesCount = 6;
+	meshData.verticesSize = sizeof(Vertex) * 6;
+	memcpy(meshData.vertices, CORNERS, sizeof(CORNERS));
+
+	MeshOptimizer::WeldVertices(&meshData);
+
+	const Index EXPECTED_INDICES[6] = { 0, 1, 2, 0, 2, 3 };
+	TEST_REQUIRE(meshData.verticesCount == 4 && meshData.indicesCount == 6);
+	TEST_CHECK(meshData.verticesSize == sizeof(Vertex) * 4);
+	TEST_CHECK(memcmp(meshData.indices, EXPECTED_INDICES, sizeof(EXPECTED_INDICES)) == 0);
+	TEST_CHECK(memcmp(&meshData.vertices[0], &CORNERS[0], sizeof(Vertex)) == 0);
+	TEST_CHECK(memcmp(&meshData.vertices[1], &CORNERS[1], sizeof(Vertex)) == 0);
+	TEST_CHECK(memcmp(&meshData.vertices[2], &CORNERS[2], sizeof(Vertex)) == 0);
+	TEST_CHECK(memcmp(&meshData.vertices[3], &CORNERS[5], sizeof(Vertex)) == 0);
+
+	// Welding again changes nothing.
+	MeshOptimizer::WeldVertices(&meshData);
+	TEST_CHECK(meshData.verticesCount == 4);
+	TEST_CHECK(memcmp(meshData.indices, EXPECTED_INDICES, sizeof(EXPECTED_INDICES)) == 0);
+
+	FreeMeshData(&meshData);
+
+	// A vertex differing in one attribute stays apart.
+	meshData.vertices = new Vertex[2];
+	meshData.verticesCount = 2;
+	meshData.verticesSize = sizeof(Vertex) * 2;
+	meshData.vertices[0] = MakeTestVertex(0, 0);
+	meshData.vertices[1] = MakeTestVertex(0, 0);
+	meshData.vertices[1].color.x = 0.5f;
+
+	MeshOptimizer::WeldVertices(&meshData);
+	TEST_CHECK(meshData.verticesCount == 2);
+
+	FreeMeshData(&meshData);
+}
+
+// The cache order keeps every triangle with its winding, beats a shuffled
+// order, and is deterministic.
+static void TestMeshOptimizerVertexCache()
+{
+	MeshData meshData = MakeMeshletTestMesh(1);
+	uint32 trianglesCount = meshData.indicesCount / 3;
+	std::vector<MeshletTriangle> before = GetSortedTriangles(meshData.indices, trianglesCount);
+	float acmrBefore = MeshOptimizer::AnalyzeVertexCache(meshData.indices, meshData.indicesCount, meshData.verticesCount);
+
+	std::vector<Index> shuffled(meshData.indices, meshData.indices + meshData.indicesCount);
+	MeshOptimizer::OptimizeVertexCache(meshData.indices, meshData.indicesCount, meshData.verticesCount);
+	float acmrAfter = MeshOptimizer::AnalyzeVertexCache(meshData.indices, meshData.indicesCount, meshData.verticesCount);
+
+	TEST_CHECK(GetSortedTriangles(meshData.indices, trianglesCount) == before);
+	TEST_CHECK(acmrBefore > 2.0f);
+	TEST_CHECK(acmrAfter < 0.8f);
+
+	MeshOptimizer::OptimizeVertexCache(shuffled.data(), meshData.indicesCount, meshData.verticesCount);
+	TEST_CHECK(memcmp(shuffled.data(), meshData.indices, sizeof(Index) * meshData.indicesCount) == 0);
+
+	FreeMeshData(&meshData);
+}
+
+/*
+================
+Mesh Simplifier
+================
+*/
+
+// Cosine between the triangle's normal and the direction from the sphere's
+// center, negative when the triangle faces inward.
+static float GetOutwardFacing(const MeshData& meshData, const Index* triangle, float* outArea)
+{
+	const Vector3& p0 = meshData.vertices[triangle[0]].posModel;
+	const Vector3& p1 = meshData.vertices[triangle[1]].posModel;
+	const Vector3& p2 = meshData.vertices[triangle[2]].posModel;
+
+	Vector3 normal = (p1 - p0).Cross(p2 - p0);
+	Vector3 outward = p0 + p1 + p2;
+	*outArea = normal.Length() * 0.5f;
+	return *outArea > 0.0f ? normal.Dot(outward) / (normal.Length() * outward.Length()) : 0.0f;
+}
+
+// Halving the sphere reaches the target without collapsing or flipping a
+// triangle, and the same input always gives the same indices.
+static void TestMeshSimplifierSphere()
+{
+	MeshData meshData = MakeMeshletTestMesh(0);
+	uint32 trianglesCount = meshData.indicesCount / 3;
+
+	// The generator's winding, which every simplified triangle must keep. This
+	// holds at the poles too, where no triangle may have zero area.
+	float area = 0.0f;
+	float sourceSign = GetOutwardFacing(meshData, meshData.indices, &area) > 0.0f ? 1.0f : -1.0f;
+	for (uint32 i = 0; i < trianglesCount; i++)
+	{
+		TEST_REQUIRE(GetOutwardFacing(meshData, &meshData.indices[i * 3], &area) * sourceSign > 0.5f);
+	}
+
+	uint32 targetIndicesCount = (trianglesCount / 2) * 3;
+	std::vector<Index> simplified(meshData.indicesCount);
+	float error = -1.0f;
+	uint32 count = MeshSimplifier::Simplify(meshData, meshData.indices, meshData.indicesCount, targetIndicesCount, 1e30f, simplified.data(), &error);
+	TEST_CHECK(count > 0 && count <= targetIndicesCount);
+	TEST_CHECK(count % 3 == 0);
+	TEST_CHECK(error >= 0.0f && error < 0.1f);
+
+	for (uint32 i = 0; i < count; i += 3)
+	{
+		const Index* triangle = &simplified[i];
+		TEST_REQUIRE(triangle[0] < meshData.verticesCount && triangle[1] < meshData.verticesCount && triangle[2] < meshData.verticesCount);
+		TEST_CHECK(triangle[0] != triangle[1] && triangle[1] != triangle[2] && triangle[2] != triangle[0]);
+		TEST_CHECK(GetOutwardFacing(meshData, triangle, &area) * sourceSign > 0.0f);
+		TEST_CHECK(area > 1e-6f);
+	}
+
+	std::vector<Index> again(meshData.indicesCount);
+	float againError = -1.0f;
+	uint32 againCount = MeshSimplifier::Simplify(meshData, meshData.indices, meshData.indicesCount, targetIndicesCount, 1e30f, again.data(), &againError);
+	TEST_CHECK(againCount == count && againError == error);
+	TEST_CHECK(memcmp(again.data(), simplified.data(), sizeof(Index) * count) == 0);
+
+	FreeMeshData(&meshData);
+}
+
+// A zero error budget keeps the sphere as it is.
+static void TestMeshSimplifierMaxError()
+{
+	MeshData meshData = MakeMeshletTestMesh(0);
+
+	std::vector<Index> simplified(meshData.indicesCount);
+	float error = -1.0f;
+	uint32 count = MeshSimplifier::Simplify(meshData, meshData.indices, meshData.indicesCount, meshData.indicesCount / 2, 0.0f, simplified.data(), &error);
+	TEST_CHECK(count == meshData.indicesCount);
+	TEST_CHECK(error == 0.0f);
+
+	FreeMeshData(&meshData);
+}
+
+// Each LOD roughly halves the previous one, with growing error, and LOD 0 is
+// the source mesh.
+static void TestMeshSimplifierLodChain()
+{
+	MeshData meshData = MakeMeshletTestMesh(0);
+	MeshLodChain lodChain;
+	TEST_REQUIRE(MeshSimplifier::BuildLodChain(meshData, &lodChain));
+	TEST_REQUIRE(lodChain.lodsCount >= 3);
+
+	TEST_CHECK(lodChain.lods[0].indexOffset == 0 && lodChain.lods[0].indicesCount == meshData.indicesCount);
+	TEST_CHECK(lodChain.lods[0].error == 0.0f);
+	TEST_CHECK(GetSortedTriangles(lodChain.indices, meshData.indicesCount / 3) == GetSortedTriangles(meshData.indices, meshData.indicesCount / 3));
+
+	for (uint32 i = 1; i < lodChain.lodsCount; i++)
+	{
+		const MeshLod& prev = lodChain.lods[i - 1];
+		const MeshLod& lod = lodChain.lods[i];
+		TEST_CHECK(lod.indexOffset == prev.indexOffset + prev.indicesCount);
+		TEST_CHECK(lod.indicesCount <= prev.indicesCount * 3 / 4);
+		TEST_CHECK(lod.error >= prev.error);
+	}
+	TEST_CHECK(lodChain.indicesCount == lodChain.lods[lodChain.lodsCount - 1].indexOffset + lodChain.lods[lodChain.lodsCount - 1].indicesCount);
+
+	MeshSimplifier::Destroy(&lodChain);
+	FreeMeshData(&meshData);
+}
+
+/*
+==============
+Mip Generator
+==============
+*/
+
+static float* GetMipFloats(const DDSTextureInfo& info, std::vector<uint8>& data, uint32 mip)
+{
+	return reinterpret_cast<float*>(&data[info.mips[mip].offset]);
+}
+
+// Black and white average to half the light, which sRGB stores as 188, not
+// 128. Alpha and linear data average their codes.
+static void TestMipGeneratorSrgbAverage()
+{
+	const uint8 BLACK[4] = { 0, 0, 0, 0 };
+	const uint8 WHITE[4] = { 255, 255, 255, 255 };
+
+	const DDS_FORMAT FORMATS[3] = { DDS_FORMAT_R8G8B8A8_UNORM_SRGB, DDS_FORMAT_R8G8B8A8_UNORM, DDS_FORMAT_R8G8B8A8_UNORM };
+	const bool SRGB[3] = { false, true, false };
+	const uint8 EXPECTED_COLORS[3] = { 188, 188, 128 };
+
+	for (uint32 i = 0; i < 3; i++)
+	{
+		DDSTextureInfo info;
+		TEST_REQUIRE(DDSFile::InitInfo(FORMATS[i], 2, 2, 2, &info));
+		std::vector<uint8> data(static_cast<size_t>(info.sliceSize), 0xcd);
+		for (uint32 texel = 0; texel < 4; texel++)
+		{
+			uint32 x = texel % 2;
+			uint32 y = texel / 2;
+			memcpy(&data[info.mips[0].offset + y * info.mips[0].rowPitch + x * 4], (x ^ y) ? WHITE : BLACK, 4);
+		}
+
+		TEST_REQUIRE(MipGenerator::Generate(info, MIP_FILTER_BOX, SRGB[i], 1, data.data()));
+
+		const uint8* texel = &data[info.mips[1].offset];
+		TEST_CHECK(texel[0] == EXPECTED_COLORS[i] && texel[1] == EXPECTED_COLORS[i] && texel[2] == EXPECTED_COLORS[i]);
+		TEST_CHECK(texel[3] == 128);
+	}
+}
+
+// Each box texel is the mean of the 2x2 texels under it.
+static void TestMipGeneratorBox()
+{
+	DDSTextureInfo info;
+	TEST_REQUIRE(DDSFile::InitInfo(DDS_FORMAT_R32G32B32A32_FLOAT, 4, 4, 3, &info));
+	std::vector<uint8> data(static_cast<size_t>(info.sliceSize), 0);
+
+	// (x + 4y, 1, y, x)
+	float* texels = GetMipFloats(info, data, 0);
+	for (uint32 y = 0; y < 4; y++)
+	{
+		for (uint32 x = 0; x < 4; x++)
+		{
+			float* texel = &texels[(y * 4 + x) * 4];
+			texel[0] = static_cast<float>(x + 4 * y);
+			texel[1] = 1.0f;
+			texel[2] = static_cast<float>(y);
+			texel[3] = static_cast<float>(x);
+		}
+	}
+
+	TEST_REQUIRE(MipGenerator::Generate(info, MIP_FILTER_BOX, false, 2, data.data()));
+
+	const float EXPECTED_MIP1[4][4] = { { 2.5f, 1.0f, 0.5f, 0.5f }, { 4.5f, 1.0f, 0.5f, 2.5f }, { 10.5f, 1.0f, 2.5f, 0.5f }, { 12.5f, 1.0f, 2.5f, 2.5f } };
+	const float* mip1 = GetMipFloats(info, data, 1);
+	for (uint32 i = 0; i < 4; i++)
+	{
+		for (uint32 c = 0; c < 4; c++)
+		{
+			TEST_CHECK(fabsf(mip1[i * 4 + c] - EXPECTED_MIP1[i][c]) < 1e-5f);
+		}
+	}
+
+	const float EXPECTED_MIP2[4] = { 7.5f, 1.0f, 1.5f, 1.5f };
+	const float* mip2 = GetMipFloats(info, data, 2);
+	for (uint32 c = 0; c < 4; c++)
+	{
+		TEST_CHECK(fabsf(mip2[c] - EXPECTED_MIP2[c]) < 1e-5f);
+	}
+}
+
+// 5x3 halves to 2x1: each destination column covers two and a half source
+// texels, so the middle one is split between both, and each row covers all three.
+static void TestMipGeneratorOddSize()
+{
+	DDSTextureInfo info;
+	TEST_REQUIRE(DDSFile::InitInfo(DDS_FORMAT_R32G32B32A32_FLOAT, 5, 3, MipGenerator::GetMipLevelsCount(5, 3), &info));
+	TEST_REQUIRE(info.mipLevels == 3);
+	TEST_REQUIRE(info.mips[1].width == 2 && info.mips[1].height == 1);
+	std::vector<uint8> data(static_cast<size_t>(info.sliceSize), 0);
+
+	// (x, y, 0, 1)
+	float* texels = GetMipFloats(info, data, 0);
+	for (uint32 y = 0; y < 3; y++)
+	{
+		for (uint32 x = 0; x < 5; x++)
+		{
+			float* texel = &texels[(y * 5 + x) * 4];
+			texel[0] = static_cast<float>(x);
+			texel[1] = static_cast<float>(y);
+			texel[3] = 1.0f;
+		}
+	}
+
+	TEST_REQUIRE(MipGenerator::Generate(info, MIP_FILTER_BOX, false, 1, data.data()));
+
+	// 0.4 * 0 + 0.4 * 1 + 0.2 * 2 and 0.2 * 2 + 0.4 * 3 + 0.4 * 4.
+	const float* mip1 = GetMipFloats(info, data, 1);
+	TEST_CHECK(fabsf(mip1[0] - 0.8f) < 1e-5f && fabsf(mip1[1] - 1.0f) < 1e-5f && fabsf(mip1[3] - 1.0f) < 1e-5f);
+	TEST_CHECK(fabsf(mip1[4] - 3.2f) < 1e-5f && fabsf(mip1[5] - 1.0f) < 1e-5f && fabsf(mip1[7] - 1.0f) < 1e-5f);
+
+	const float* mip2 = GetMipFloats(info, data, 2);
+	TEST_CHECK(fabsf(mip2[0] - 2.0f) < 1e-5f && fabsf(mip2[1] - 1.0f) < 1e-5f && fabsf(mip2[3] - 1.0f) < 1e-5f);
+}
+
+// An impulse comes out as the Kaiser window itself: for a 2:1 reduction each
+// destination texel has twelve taps at +-0.25, +-0.75 ... +-2.75 destination
+// texels, weighted sinc(x) * I0(4 * sqrt(1 - (x / 3)^2)) / I0(4) and
+// normalized, negative lobes included.
+static void TestMipGeneratorKaiser()
+{
+	DDSTextureInfo info;
+	TEST_REQUIRE(DDSFile::InitInfo(DDS_FORMAT_R32G32B32A32_FLOAT, 16, 1, 2, &info));
+	std::vector<uint8> data(static_cast<size_t>(info.sliceSize), 0);
+	GetMipFloats(info, data, 0)[8 * 4] = 1.0f;
+
+	TEST_REQUIRE(MipGenerator::Generate(info, MIP_FILTER_KAISER, false, 1, data.data()));
+
+	auto kaiser = [](double x)
+	{
+		double sinc = x == 0.0 ? 1.0 : sin(3.14159265358979 * x) / (3.14159265358979 * x);
+		return sinc * std::cyl_bessel_i(0.0, 4.0 * sqrt(1.0 - (x / 3.0) * (x / 3.0))) / std::cyl_bessel_i(0.0, 4.0);
+	};
+
+	double sum = 0.0;
+	for (uint32 t = 0; t < 6; t++)
+	{
+		sum += 2.0 * kaiser(0.25 + 0.5 * t);
+	}
+
+	const float* mip1 = GetMipFloats(info, data, 1);
+	for (uint32 d = 0; d < 8; d++)
+	{
+		// Source texel 8 is 8.5 - (2d + 1) source texels from the center of d.
+		double x = (7.5 - 2.0 * d) * 0.5;
+		double expected = fabs(x) < 3.0 ? kaiser(x) / sum : 0.0;
+		TEST_CHECK(fabs(mip1[d * 4] - expected) < 1e-5);
+	}
+
+	// The lobe 1.75 texels out rings below zero.
+	TEST_CHECK(mip1[2 * 4] < 0.0f);
+}
+
+/*
+========
+Null RHI
+========
+*/
+
+template<typename T>
+static const T* NextCommand(const uint8* commands, uint64 size, uint64* offset, RHI_COMMAND type)
+{
+	if (*offset + sizeof(T) > size)
+		return nullptr;
+
+	const RHICommandHeader* header = reinterpret_cast<const RHICommandHeader*>(commands + *offset);
+	if (header->type != type || header->size % 8 != 0 || header->size < sizeof(T))
+		return nullptr;
+
+	*offset += header->size;
+	return reinterpret_cast<const T*>(header);
+}
+
+// One frame's worth of commands comes back in order, 8-byte aligned, with
+// every argument and the constant data intact, and Submit counts them.
+static void TestRHINullCommandStream()
+{
+	NullRHIDevice device;
+
+	RHITextureDesc colorDesc;
+	colorDesc.width = 4;
+	colorDesc.height = 4;
+	colorDesc.usage = RHI_TEXTURE_USAGE_RENDER_TARGET;
+	RHITexture* color = device.CreateTexture(colorDesc, nullptr, 0);
+
+	RHITextureDesc depthDesc = colorDesc;
+	depthDesc.format = RHI_FORMAT_D24_UNORM_S8_UINT;
+	depthDesc.usage = RHI_TEXTURE_USAGE_DEPTH_STENCIL;
+	RHITexture* depth = device.CreateTexture(depthDesc, nullptr, 0);
+
+	const Index INDICES[3] = { 0, 1, 2 };
+	RHIBufferDesc indexDesc;
+	indexDesc.usage = RHI_BUFFER_USAGE_INDEX;
+	indexDesc.size = sizeof(INDICES);
+	indexDesc.stride = sizeof(Index);
+	RHIBuffer* indexBuffer = device.CreateBuffer(indexDesc, INDICES);
+
+	const Vertex VERTICES[3] = {};
+	RHIBufferDesc vertexDesc;
+	vertexDesc.size = sizeof(VERTICES);
+	vertexDesc.stride = sizeof(Vertex);
+	RHIBuffer* vertexBuffer = device.CreateBuffer(vertexDesc, VERTICES);
+
+	RHIPipeline* pipeline = device.CreatePipeline(RHIPipelineDesc());
+	TEST_REQUIRE(color && depth && indexBuffer && vertexBuffer && pipeline);
+
+	RHICommandList* commandList = device.CreateCommandList();
+	const float CLEAR_COLOR[4] = { 0.25f, 0.5f, 0.75f, 1.0f };
+	const uint32 CONSTANTS[3] = { 7, 8, 9 };
+
+	commandList->Begin();
+	commandList->TextureBarrier(color, RHI_RESOURCE_STATE_PRESENT, RHI_RESOURCE_STATE_RENDER_TARGET);
+	commandList->SetRenderTargets(color, depth);
+	commandList->ClearRenderTarget(color, CLEAR_COLOR);
+	commandList->ClearDepth(depth, 1.0f);
+	commandList->SetViewport(4, 4);
+	commandList->SetPipeline(pipeline);
+	TEST_CHECK(commandList->SetConstants(RHI_CONSTANTS_SLOT_OBJECT, CONSTANTS, sizeof(CONSTANTS)));
+	commandList->SetVertexBuffer(vertexBuffer);
+	commandList->SetIndexBuffer(indexBuffer);
+	commandList->DrawIndexed(3, 0, -2);
+	commandList->End();
+
+	const NullRHICommandList* nullList = static_cast<const NullRHICommandList*>(commandList);
+	const uint8* commands = nullList->GetCommands();
+	uint64 size = nullList->GetCommandsSize();
+	uint64 offset = 0;
+
+	const RHICommandTextureBarrier* barrier = NextCommand<RHICommandTextureBarrier>(commands, size, &offset, RHI_COMMAND_TEXTURE_BARRIER);
+	TEST_REQUIRE(barrier);
+	TEST_CHECK(barrier->texture == color && barrier->before == RHI_RESOURCE_STATE_PRESENT && barrier->after == RHI_RESOURCE_STATE_RENDER_TARGET);
+
+	const RHICommandSetRenderTargets* renderTargets = NextCommand<RHICommandSetRenderTargets>(commands, size, &offset, RHI_COMMAND_SET_RENDER_TARGETS);
+	TEST_REQUIRE(renderTargets);
+	TEST_CHECK(renderTargets->colorTarget == color && renderTargets->depthTarget == depth);
+
+	const RHICommandClearRenderTarget* clear = NextCommand<RHICommandClearRenderTarget>(commands, size, &offset, RHI_COMMAND_CLEAR_RENDER_TARGET);
+	TEST_REQUIRE(clear);
+	TEST_CHECK(clear->texture == color && memcmp(clear->color, CLEAR_COLOR, sizeof(CLEAR_COLOR)) == 0);
+
+	const RHICommandClearDepth* clearDepth = NextCommand<RHICommandClearDepth>(commands, size, &offset, RHI_COMMAND_CLEAR_DEPTH);
+	TEST_REQUIRE(clearDepth);
+	TEST_CHECK(clearDepth->texture == depth && clearDepth->depth == 1.0f);
+
+	const RHICommandSetViewport* viewport = NextCommand<RHICommandSetViewport>(commands, size, &offset, RHI_COMMAND_SET_VIEWPORT);
+	TEST_REQUIRE(viewport);
+	TEST_CHECK(viewport->width == 4 && viewport->height == 4);
+
+	const RHICommandSetPipeline* setPipeline = NextCommand<RHICommandSetPipeline>(commands, size, &offset, RHI_COMMAND_SET_PIPELINE);
+	TEST_REQUIRE(setPipeline);
+	TEST_CHECK(setPipeline->pipeline == pipeline);
+
+	// The data follows the command, and the size is padded past it.
+	const RHICommandSetConstants* constants = NextCommand<RHICommandSetConstants>(commands, size, &offset, RHI_COMMAND_SET_CONSTANTS);
+	TEST_REQUIRE(constants);
+	TEST_CHECK(constants->slot == RHI_CONSTANTS_SLOT_OBJECT && constants->dataSize == sizeof(CONSTANTS));
+	TEST_CHECK(constants->header.size == ((sizeof(RHICommandSetConstants) + sizeof(CONSTANTS) + 7) & ~7u));
+	TEST_CHECK(memcmp(constants + 1, CONSTANTS, sizeof(CONSTANTS)) == 0);
+
+	const RHICommandSetBuffer* setVertexBuffer = NextCommand<RHICommandSetBuffer>(commands, size, &offset, RHI_COMMAND_SET_VERTEX_BUFFER);
+	TEST_REQUIRE(setVertexBuffer);
+	TEST_CHECK(setVertexBuffer->buffer == vertexBuffer);
+
+	const RHICommandSetBuffer* setIndexBuffer = NextCommand<RHICommandSetBuffer>(commands, size, &offset, RHI_COMMAND_SET_INDEX_BUFFER);
+	TEST_REQUIRE(setIndexBuffer);
+	TEST_CHECK(setIndexBuffer->buffer == indexBuffer);
+
+	const RHICommandDrawIndexed* draw = NextCommand<RHICommandDrawIndexed>(commands, size, &offset, RHI_COMMAND_DRAW_INDEXED);
+	TEST_REQUIRE(draw);
+	TEST_CHECK(draw->indexCount == 3 && draw->startIndex == 0 && draw->baseVertex == -2);
+	TEST_CHECK(offset == size);
+
+	TEST_CHECK(device.Submit(&commandList, 1) == 1);
+	TEST_CHECK(device.GetCompletedFenceValue() == 1);
+	const RHINullStats& stats = device.GetStats();
+	TEST_CHECK(stats.submitsCount == 1 && stats.commandsCount == 10);
+	TEST_CHECK(stats.drawsCount == 1 && stats.indicesCount == 3);
+	TEST_CHECK(stats.constantBytes == sizeof(CONSTANTS) && stats.recordedBytes == size);
+
+	// Begin starts over, and a stream that outgrows its block keeps every command.
+	const uint32 DRAWS_COUNT = 10000;
+	commandList->Begin();
+	for (uint32 i = 0; i < DRAWS_COUNT; i++)
+	{
+		commandList->DrawIndexed(i, i * 3, 0);
+	}
+	commandList->End();
+
+	commands = nullList->GetCommands();
+	size = nullList->GetCommandsSize();
+	offset = 0;
+	TEST_REQUIRE(size == DRAWS_COUNT * ((sizeof(RHICommandDrawIndexed) + 7) & ~7u));
+	for (uint32 i = 0; i < DRAWS_COUNT; i++)
+	{
+		draw = NextCommand<RHICommandDrawIndexed>(commands, size, &offset, RHI_COMMAND_DRAW_INDEXED);
+		TEST_REQUIRE(draw);
+		TEST_REQUIRE(draw->indexCount == i && draw->startIndex == i * 3);
+	}
+
+	device.DestroyCommandList(commandList);
+	device.DestroyPipeline(pipeline);
+	device.DestroyBuffer(vertexBuffer);
+	device.DestroyBuffer(indexBuffer);
+	device.DestroyTexture(depth);
+	device.DestroyTexture(color);
+}
+
+/*
+========
+Profiler
+========
+*/
+
+struct TraceZone
+{
+	std::string name;
+	uint32 threadId;
+	double begin;		// Microseconds.
+	double duration;
+};
+
+static std::vector<std::string> ReadTraceLines(const char* filename)
+{
+	std::vector<std::string> lines;
+	FILE* file = fopen(filename, "rb");
+	if (!file)
+		return lines;
+
+	std::string line;
+	for (int c = fgetc(file); c != EOF; c = fgetc(file))
+	{
+		if (c == '\n')
+		{
+			lines.push_back(line);
+			line.clear();
+		}
+		else
+		{
+			line += static_cast<char>(c);
+		}
+	}
+	fclose(file);
+	return lines;
+}
+
+// The complete events of the trace, in file order.
+static std::vector<TraceZone> ReadTraceZones(const char* filename)
+{
+	std::vector<TraceZone> zones;
+	for (const std::string& line : ReadTraceLines(filename))
+	{
+		char name[64] = {};
+		TraceZone zone = {};
+		if (sscanf(line.c_str(), "{\"name\":\"%63[^\"]\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lf,\"dur\":%lf}", name, &zone.threadId, &zone.begin, &zone.duration) == 4)
+		{
+			zone.name = name;
+			zones.push_back(zone);
+		}
+	}
+	return zones;
+}
+
+static const char* const PROFILER_ZONE_NAMES[10] = { "Zone0", "Zone1", "Zone2", "Zone3", "Zone4", "Zone5", "Zone6", "Zone7", "Zone8", "Zone9" };
+
+// A full ring keeps the newest events, and a trace written while the ring
+// wraps under it holds whole events only: back to back zones never overlap.
+static void TestProfilerRingWrap()
+{
+	const uint32 CAPACITY = 4;
+	Profiler::Init(CAPACITY);
+
+	for (uint32 i = 0; i < 10; i++)
+	{
+		Profiler::BeginZone(PROFILER_ZONE_NAMES[i]);
+		Profiler::EndZone();
+	}
+
+	TEST_REQUIRE(Profiler::WriteChromeTrace("ProfilerTest.json"));
+	std::vector<TraceZone> zones = ReadTraceZones("ProfilerTest.json");
+	TEST_REQUIRE(zones.size() == CAPACITY);
+	for (uint32 i = 0; i < CAPACITY; i++)
+	{
+		TEST_CHECK(zones[i].name == PROFILER_ZONE_NAMES[10 - CAPACITY + i]);
+		TEST_CHECK(zones[i].duration >= 0.0);
+	}
+
+	std::atomic<bool> quit(false);
+	std::thread recorder([&quit]()
+	{
+		for (uint32 i = 0; !quit.load(); i = (i + 1) % 10)
+		{
+			Profiler::BeginZone(PROFILER_ZONE_NAMES[i]);
+			Profiler::EndZone();
+		}
+	});
+
+	for (uint32 pass = 0; pass < 200; pass++)
+	{
+		TEST_REQUIRE(Profiler::WriteChromeTrace("ProfilerTest.json"));
+		zones = ReadTraceZones("ProfilerTest.json");
+
+		// The main thread's ring has not changed.
+		uint32 mainCount = 0;
+		std::vector<TraceZone> recorded;
+		for (const TraceZone& zone : zones)
+		{
+			if (zone.threadId == 1)
+				mainCount++;
+			else
+				recorded.push_back(zone);
+		}
+		TEST_CHECK(mainCount == CAPACITY);
+		TEST_CHECK(recorded.size() <= CAPACITY);
+
+		// A torn event would pair one zone's begin with another's end.
+		for (size_t i = 0; i < recorded.size(); i++)
+		{
+			TEST_CHECK(recorded[i].name.compare(0, 4, "Zone") == 0);
+			TEST_CHECK(recorded[i].duration >= 0.0 && recorded[i].duration < 1e6);
+			if (i > 0)
+				TEST_CHECK(recorded[i - 1].begin + recorded[i - 1].duration <= recorded[i].begin + 0.002);
+		}
+	}
+
+	quit.store(true);
+	recorder.join();
+
+	Profiler::Clean();
+	remove("ProfilerTest.json");
+}
+
+// Metadata first, names escaped, then complete events sorted by thread and
+// begin, with parents ahead of children that start on the same tick.
+static void TestProfilerTraceFormat()
+{
+	Profiler::Init();
+	Profiler::SetThreadName("Main \"quoted\"");
+	uint32 track = Profiler::CreateTrack("GPU");
+	TEST_REQUIRE(track == 2);
+
+	uint64 ticksPerMillisecond = Profiler::GetTicksPerSecond() / 1000;
+	uint64 begin = Profiler::GetTicks() + ticksPerMillisecond;
+	Profiler::AddZone(track, "Child", begin, begin + ticksPerMillisecond, 1);
+	Profiler::AddZone(track, "Parent", begin, begin + 2 * ticksPerMillisecond, 0);
+	Profiler::AddZone(track, "Before", begin - ticksPerMillisecond / 2, begin, 0);
+	Profiler::BeginZone("Main");
+	Profiler::EndZone();
+
+	TEST_REQUIRE(Profiler::WriteChromeTrace("ProfilerTest.json"));
+	Profiler::Clean();
+
+	std::vector<std::string> lines = ReadTraceLines("ProfilerTest.json");
+	TEST_REQUIRE(lines.size() == 9);
+	TEST_CHECK(lines[0] == "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	TEST_CHECK(lines[1] == "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"XFree\"}},");
+	TEST_CHECK(lines[2] == "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Main \\\"quoted\\\"\"}},");
+	TEST_CHECK(lines[3] == "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}},");
+	TEST_CHECK(lines[8] == "]}");
+
+	std::vector<TraceZone> zones = ReadTraceZones("ProfilerTest.json");
+	TEST_REQUIRE(zones.size() == 4);
+	TEST_CHECK(zones[0].name == "Main" && zones[0].threadId == 1);
+	TEST_CHECK(zones[1].name == "Before" && zones[1].threadId == 2);
+	TEST_CHECK(zones[2].name == "Parent" && zones[2].threadId == 2);
+	TEST_CHECK(zones[3].name == "Child" && zones[3].threadId == 2);
+
+	// Microseconds with three decimals.
+	TEST_CHECK(fabs(zones[1].duration - 500.0) < 0.002);
+	TEST_CHECK(fabs(zones[2].duration - 2000.0) < 0.002);
+	TEST_CHECK(fabs(zones[3].duration - 1000.0) < 0.002);
+	TEST_CHECK(fabs(zones[2].begin - zones[1].begin - 500.0) < 0.002);
+	TEST_CHECK(zones[2].begin == zones[3].begin);
+
+	remove("ProfilerTest.json");
+}
+
+/*
+================
+Texture Streamer
+================
+*/
+
+static StreamedTextureDesc MakeStreamedDesc(DDS_FORMAT format, uint32 width, uint32 height)
+{
+	DDSTextureInfo info;
+	DDSFile::InitInfo(format, width, height, DDS_MAX_MIPS, &info);
+
+	StreamedTextureDesc desc;
+	desc.width = width;
+	desc.height = height;
+	desc.mipLevels = info.mipLevels;
+	desc.blockCompressed = DDSFile::IsBlockCompressed(format);
+	for (uint32 mip = 0; mip < info.mipLevels; mip++)
+	{
+		desc.mipSizes[mip] = info.mips[mip].size;
+	}
+	return desc;
+}
+
+static bool IsValidTopMip(const StreamedTextureDesc& desc, uint32 mip)
+{
+	if (mip == 0 || !desc.blockCompressed)
+		return true;
+
+	uint32 width = desc.width >> mip;
+	uint32 height = desc.height >> mip;
+	return width && height && width % 4 == 0 && height % 4 == 0;
+}
+
+// BC textures only ever get a top mip D3D12 can create, or are not streamed.
+static void TestStreamerBlockCompressedTopMips()
+{
+	TextureStreamerSettings settings;
+	settings.maxTextures = 8;
+
+	TextureStreamer streamer;
+	streamer.Init(settings);
+
+	// 100: 50 and 25 are not multiples of 4, 12 is. 1000: 500, 250 (no), 125 (no), 62 (no), 31 (no)...
+	uint32 hundred = streamer.Register(MakeStreamedDesc(DDS_FORMAT_BC1_UNORM, 100, 100));
+	TEST_REQUIRE(hundred != TEXTURE_STREAMER_INVALID_ID);
+	TEST_CHECK(streamer.GetTailMip(hundred) == 3);
+	TEST_CHECK(streamer.GetResidentMip(hundred) == 3);
+
+	uint32 thousand = streamer.Register(MakeStreamedDesc(DDS_FORMAT_BC7_UNORM, 1000, 1000));
+	TEST_REQUIRE(thousand != TEXTURE_STREAMER_INVALID_ID);
+	TEST_CHECK(streamer.GetTailMip(thousand) == 1);
+
+	uint32 aligned = streamer.Register(MakeStreamedDesc(DDS_FORMAT_BC3_UNORM, 256, 128));
+	TEST_REQUIRE(aligned != TEXTURE_STREAMER_INVALID_ID);
+	TEST_CHECK(streamer.GetTailMip(aligned) == 2);
+
+	// 20: 10, 5, 2 and 1 can never be the top mip.
+	TEST_CHECK(streamer.Register(MakeStreamedDesc(DDS_FORMAT_BC1_UNORM, 20, 20)) == TEXTURE_STREAMER_INVALID_ID);
+
+	// Uncompressed textures can start on any mip.
+	uint32 uncompressed = streamer.Register(MakeStreamedDesc(DDS_FORMAT_R8G8B8A8_UNORM, 100, 100));
+	TEST_REQUIRE(uncompressed != TEXTURE_STREAMER_INVALID_ID);
+	TEST_CHECK(streamer.GetTailMip(uncompressed) == 1);
+
+	streamer.Clean();
+}
+
+// Under a tight budget and changing screen sizes, every request names a
+// top mip D3D12 can create.
+static void TestStreamerRequestsValidTopMips()
+{
+	const uint32 SIZES[][2] = { { 100, 100 }, { 1000, 1000 }, { 36, 36 }, { 1000, 200 }, { 512, 512 }, { 1028, 772 } };
+	const uint32 TEXTURES_COUNT = sizeof(SIZES) / sizeof(SIZES[0]);
+
+	TextureStreamerSettings settings;
+	settings.maxTextures = TEXTURES_COUNT;
+	settings.budgetBytes = 512 * 1024;
+	settings.dropFrames = 2;
+
+	TextureStreamer streamer;
+	streamer.Init(settings);
+
+	StreamedTextureDesc descs[TEXTURES_COUNT];
+	uint32 textureIds[TEXTURES_COUNT];
+	for (uint32 i = 0; i < TEXTURES_COUNT; i++)
+	{
+		descs[i] = MakeStreamedDesc(DDS_FORMAT_BC1_UNORM, SIZES[i][0], SIZES[i][1]);
+		textureIds[i] = streamer.Register(descs[i]);
+		TEST_REQUIRE(textureIds[i] == i);
+		TEST_CHECK(IsValidTopMip(descs[i], streamer.GetTailMip(i)));
+	}
+
+	uint32 seed = 0x12345678;
+	uint32 requestsTotal = 0;
+	for (uint32 frame = 0; frame < 500; frame++)
+	{
+		for (uint32 i = 0; i < TEXTURES_COUNT; i++)
+		{
+			seed = seed * 1664525 + 1013904223;
+			streamer.ReportScreenSize(textureIds[i], static_cast<float>((seed >> 8) % 1200));
+		}
+
+		TextureStreamRequest requests[4];
+		uint32 requestsCount = streamer.Update(requests, 4);
+		for (uint32 i = 0; i < requestsCount; i++)
+		{
+			uint32 id = requests[i].textureId;
+			TEST_CHECK(IsValidTopMip(descs[id], requests[i].mostDetailedMip));
+			TEST_CHECK(requests[i].mostDetailedMip <= streamer.GetTailMip(id));
+			streamer.CompleteRequest(id);
+		}
+		requestsTotal += requestsCount;
+	}
+	TEST_CHECK(requestsTotal > 0);
+
+	streamer.Clean();
+}
+
+/*
+===========================
+Virtual Texture Page Table
+===========================
+*/
+
+// 4x4 tiles at mip 0, 2x2 at mip 1 and one at mip 2.
+static void InitPageTable(VirtualTexturePageTable* pageTable, uint32 mipsCount, uint32 pagesCount)
+{
+	VirtualTextureDesc desc;
+	desc.standardMipsCount = mipsCount;
+	for (uint32 mip = 0; mip < mipsCount; mip++)
+	{
+		desc.widthInTiles[mip] = 4 >> mip;
+		desc.heightInTiles[mip] = 4 >> mip;
+	}
+	desc.physicalPagesCount = pagesCount;
+	pageTable->Init(desc);
+}
+
+// Requests one mip 0 tile, loads it and completes the load.
+static uint32 LoadTile(VirtualTexturePageTable* pageTable, uint32 x, uint32 y, VirtualTileLoad* outLoad)
+{
+	uint32 tileIndex = pageTable->GetTileIndex(0, x, y);
+	pageTable->RequestTile(tileIndex);
+	if (pageTable->Update(outLoad, 1) != 1)
+		return VT_INVALID_INDEX;
+
+	pageTable->CompleteLoad(outLoad->tileIndex);
+	return tileIndex;
+}
+
+// A mip 0 request maps its coarser tiles first, then itself.
+static void TestPageTableMap()
+{
+	VirtualTexturePageTable pageTable;
+	InitPageTable(&pageTable, 3, 8);
+	TEST_REQUIRE(pageTable.GetTilesCount() == 21);
+
+	for (uint32 i = 0; i < pageTable.GetTilesCount(); i++)
+	{
+		uint32 mip, x, y;
+		pageTable.GetTileCoord(i, &mip, &x, &y);
+		TEST_CHECK(pageTable.GetTileIndex(mip, x, y) == i);
+	}
+
+	pageTable.RequestTile(pageTable.GetTileIndex(0, 3, 2));
+	VirtualTileLoad loads[8];
+	uint32 loadsCount = pageTable.Update(loads, 8);
+	TEST_REQUIRE(loadsCount == 3);
+
+	const uint32 EXPECTED[3][3] = { { 2, 0, 0 }, { 1, 1, 1 }, { 0, 3, 2 } };
+	for (uint32 i = 0; i < loadsCount; i++)
+	{
+		TEST_CHECK(loads[i].mip == EXPECTED[i][0] && loads[i].x == EXPECTED[i][1] && loads[i].y == EXPECTED[i][2]);
+		TEST_CHECK(loads[i].tileIndex == pageTable.GetTileIndex(loads[i].mip, loads[i].x, loads[i].y));
+		TEST_CHECK(loads[i].page == i);
+		TEST_CHECK(loads[i].evictedTileIndex == VT_INVALID_INDEX);
+		TEST_CHECK(!pageTable.IsResident(loads[i].tileIndex));
+	}
+
+	// Loading tiles are neither resident nor requested again.
+	pageTable.RequestTile(pageTable.GetTileIndex(0, 3, 2));
+	TEST_CHECK(pageTable.Update(loads + 3, 5) == 0);
+
+	for (uint32 i = 0; i < loadsCount; i++)
+	{
+		pageTable.CompleteLoad(loads[i].tileIndex);
+		TEST_CHECK(pageTable.IsResident(loads[i].tileIndex));
+	}
+	TEST_CHECK(pageTable.GetResidentTilesCount() == 3);
+
+	pageTable.RequestTile(pageTable.GetTileIndex(0, 3, 2));
+	TEST_CHECK(pageTable.Update(loads, 8) == 0);
+
+	pageTable.Clean();
+}
+
+// Missing tiles fall back to the finest mip resident all the way up the chain.
+static void TestPageTableResidencyFallback()
+{
+	VirtualTexturePageTable pageTable;
+	InitPageTable(&pageTable, 3, 8);
+
+	uint8 map[16];
+	pageTable.BuildResidencyMap(map);
+	for (uint32 i = 0; i < 16; i++)
+	{
+		TEST_CHECK(map[i] == 3);
+	}
+
+	pageTable.RequestTile(pageTable.GetTileIndex(0, 3, 2));
+	VirtualTileLoad loads[3];
+	TEST_REQUIRE(pageTable.Update(loads, 3) == 3);
+
+	// Mip 1 failed: the mip 0 tile under it cannot be sampled past mip 2.
+	pageTable.CompleteLoad(loads[0].tileIndex);
+	pageTable.CancelLoad(loads[1].tileIndex);
+	pageTable.CompleteLoad(loads[2].tileIndex);
+	TEST_CHECK(!pageTable.IsResident(loads[1].tileIndex));
+
+	pageTable.BuildResidencyMap(map);
+	for (uint32 i = 0; i < 16; i++)
+	{
+		TEST_CHECK(map[i] == 2);
+	}
+
+	// The cancelled page is handed out again, and then every level is there.
+	pageTable.RequestTile(pageTable.GetTileIndex(0, 3, 2));
+	TEST_REQUIRE(pageTable.Update(loads, 3) == 1);
+	TEST_CHECK(loads[0].mip == 1 && loads[0].page == 1);
+	pageTable.CompleteLoad(loads[0].tileIndex);
+
+	pageTable.BuildResidencyMap(map);
+	for (uint32 y = 0; y < 4; y++)
+	{
+		for (uint32 x = 0; x < 4; x++)
+		{
+			uint8 expected = x == 3 && y == 2 ? 0 : (x >= 2 && y >= 2 ? 1 : 2);
+			TEST_CHECK(map[y * 4 + x] == expected);
+		}
+	}
+
+	pageTable.Clean();
+}
+
+// Once the pages run out, the least recently requested tile is evicted.
+static void TestPageTableEvictOrder()
+{
+	VirtualTexturePageTable pageTable;
+	InitPageTable(&pageTable, 1, 3);
+
+	VirtualTileLoad load;
+	uint32 a = LoadTile(&pageTable, 0, 0, &load);
+	uint32 b = LoadTile(&pageTable, 1, 0, &load);
+	uint32 c = LoadTile(&pageTable, 2, 0, &load);
+	TEST_REQUIRE(a != VT_INVALID_INDEX && b != VT_INVALID_INDEX && c != VT_INVALID_INDEX);
+	TEST_CHECK(pageTable.GetResidentTilesCount() == 3);
+
+	// Touching a makes b the oldest.
+	pageTable.RequestTile(a);
+	TEST_CHECK(pageTable.Update(&load, 1) == 0);
+
+	const uint32 expectedEvictions[3] = { b, c, a };
+	const uint32 expectedX[3] = { 1, 2, 0 };
+	for (uint32 i = 0; i < 3; i++)
+	{
+		uint32 tileIndex = LoadTile(&pageTable, i, 1, &load);
+		TEST_REQUIRE(tileIndex != VT_INVALID_INDEX);
+		TEST_CHECK(load.evictedTileIndex == expectedEvictions[i]);
+		TEST_CHECK(load.evictedMip == 0 && load.evictedX == expectedX[i] && load.evictedY == 0);
+		TEST_CHECK(!pageTable.IsResident(expectedEvictions[i]));
+		TEST_CHECK(pageTable.GetResidentTilesCount() == 3);
+	}
+
+	pageTable.Clean();
+}
+
+// Never more tiles than pages, and tiles requested this frame are never evicted.
+static void TestPageTableCapacity()
+{
+	VirtualTexturePageTable pageTable;
+	InitPageTable(&pageTable, 1, 3);
+
+	for (uint32 x = 0; x < 4; x++)
+	{
+		pageTable.RequestTile(pageTable.GetTileIndex(0, x, 0));
+	}
+	pageTable.RequestTile(pageTable.GetTileIndex(0, 0, 1));
+
+	VirtualTileLoad loads[8];
+	uint32 loadsCount = pageTable.Update(loads, 8);
+	TEST_REQUIRE(loadsCount == 3);
+	for (uint32 i = 0; i < loadsCount; i++)
+	{
+		pageTable.CompleteLoad(loads[i].tileIndex);
+	}
+
+	// Every resident tile is wanted again, so nothing can be replaced.
+	for (uint32 i = 0; i < loadsCount; i++)
+	{
+		pageTable.RequestTile(loads[i].tileIndex);
+	}
+	pageTable.RequestTile(pageTable.GetTileIndex(0, 3, 3));
+	TEST_CHECK(pageTable.Update(loads + 3, 5) == 0);
+	TEST_CHECK(pageTable.GetResidentTilesCount() == 3);
+
+	// maxLoads caps the loads of a frame.
+	pageTable.RequestTile(pageTable.GetTileIndex(0, 3, 3));
+	pageTable.RequestTile(pageTable.GetTileIndex(0, 2, 3));
+	TEST_CHECK(pageTable.Update(loads, 1) == 1);
+	TEST_CHECK(loads[0].evictedTileIndex != VT_INVALID_INDEX);
+	TEST_CHECK(pageTable.GetResidentTilesCount() == 2);
+
+	pageTable.Clean();
+}
+
+/*
+==============
+Registration
+==============
+*/
+
+void RegisterUnitTests()
+{
+	UnitTest::Register("PipelineCompileQueue/Lifecycle", TestCompileQueueLifecycle);
+	UnitTest::Register("PipelineCompileQueue/Order", TestCompileQueueOrder);
+	UnitTest::Register("PipelineCompileQueue/ReleaseQueued", TestCompileQueueReleaseQueued);
+	UnitTest::Register("PipelineCompileQueue/ReleaseQueuedThenClean", TestCompileQueueReleaseQueuedThenClean);
+	UnitTest::Register("PipelineCompileQueue/Clean", TestCompileQueueClean);
+	UnitTest::Register("PipelineCompileQueue/Full", TestCompileQueueFull);
+	UnitTest::Register("PipelineCompileQueue/ReleaseCompiling", TestCompileQueueReleaseCompiling);
+
+	UnitTest::Register("BCEncoder/Psnr", TestBCEncoderPsnr);
+
+	UnitTest::Register("DDSFile/WoodCrate", TestDDSFileWoodCrate);
+	UnitTest::Register("DDSFile/ArraySize", TestDDSFileArraySize);
+
+	UnitTest::Register("FrameStats/LargeCounters", TestFrameStatsLargeCounters);
+	UnitTest::Register("FrameStats/Percentiles", TestFrameStatsPercentiles);
+
+	UnitTest::Register("ImageFile/ColorMappedTga", TestImageFileColorMappedTga);
+	UnitTest::Register("ImageFile/InflateCap", TestImageFileInflateCap);
+
+	UnitTest::Register("MeshFile/RoundTrip", TestMeshFileRoundTrip);
+	UnitTest::Register("MeshFile/Corrupt", TestMeshFileCorrupt);
+
+	UnitTest::Register("MeshImporter/GltfIndices", TestMeshImporterGltfIndices);
+	UnitTest::Register("MeshImporter/GltfEmbedded", TestMeshImporterGltfEmbedded);
+	UnitTest::Register("MeshImporter/HashDependencies", TestMeshImporterHashDependencies);
+	UnitTest::Register("MeshImporter/Obj", TestMeshImporterObj);
+
+	UnitTest::Register("MeshletBuilder/Triangles", TestMeshletBuilderTriangles);
+	UnitTest::Register("MeshletBuilder/ExpandIndices", TestMeshletBuilderExpandIndices);
+	UnitTest::Register("MeshletBuilder/Culling", TestMeshletBuilderCulling);
+
+	UnitTest::Register("MeshOptimizer/WeldVertices", TestMeshOptimizerWeldVertices);
+	UnitTest::Register("MeshOptimizer/VertexCache", TestMeshOptimizerVertexCache);
+
+	UnitTest::Register("MeshSimplifier/Sphere", TestMeshSimplifierSphere);
+	UnitTest::Register("MeshSimplifier/MaxError", TestMeshSimplifierMaxError);
+	UnitTest::Register("MeshSimplifier/LodChain", TestMeshSimplifierLodChain);
+
+	UnitTest::Register("MipGenerator/SrgbAverage", TestMipGeneratorSrgbAverage);
+	UnitTest::Register("MipGenerator/Box", TestMipGeneratorBox);
+	UnitTest::Register("MipGenerator/OddSize", TestMipGeneratorOddSize);
+	UnitTest::Register("MipGenerator/Kaiser", TestMipGeneratorKaiser);
+
+	UnitTest::Register("RHINull/CommandStream", TestRHINullCommandStream);
+
+	UnitTest::Register("Profiler/RingWrap", TestProfilerRingWrap);
+	UnitTest::Register("Profiler/TraceFormat", TestProfilerTraceFormat);
+
+	UnitTest::Register("TextureStreamer/BlockCompressedTopMips", TestStreamerBlockCompressedTopMips);
+	UnitTest::Register("TextureStreamer/RequestsValidTopMips", TestStreamerRequestsValidTopMips);
+
+	UnitTest::Register("VirtualTexturePageTable/Map", TestPageTableMap);
+	UnitTest::Register("VirtualTexturePageTable/ResidencyFallback", TestPageTableResidencyFallback);
+	UnitTest::Register("VirtualTexturePageTable/EvictOrder", TestPageTableEvictOrder);
+	UnitTest::Register("VirtualTexturePageTable/Capacity", TestPageTableCapacity);
+}
@@ -0,0 +1,78 @@
+#include "UnitTest.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/*
+=========
+Unit Test
+=========
+*/
+
+namespace UnitTest
+{
+	// Only the first few failures of a test are printed; loops over thousands
+	// of elements would bury the rest of the output.
+	static const uint32 MAX_PRINTED_FAILURES = 8;
+
+	struct Entry
+	{
+		const char* name = nullptr;
+		UnitTestFunc func = nullptr;
+	};
+
+	static std::vector<Entry> s_entries;
+	static uint32 s_failuresCount = 0;
+	static std::string s_dataDirectory = ".";
+
+	void Register(const char* name, UnitTestFunc func)
+	{
+		Entry entry;
+		entry.name = name;
+		entry.func = func;
+		s_entries.push_back(entry);
+	}
+
+	int RunAll(const char* filter)
+	{
+		uint32 testsCount = 0;
+		uint32 failedCount = 0;
+		for (const Entry& entry : s_entries)
+		{
+			if (std::string(entry.name).find(filter) == std::string::npos)
+				continue;
+
+			s_failuresCount = 0;
+			entry.func();
+
+			if (s_failuresCount > MAX_PRINTED_FAILURES)
+				::printf("  ... %u more failures\n", s_failuresCount - MAX_PRINTED_FAILURES);
+			::printf("%-56s %s\n", entry.name, s_failuresCount ? "FAILED" : "passed");
+			::fflush(stdout);
+
+			testsCount++;
+			failedCount += s_failuresCount ? 1 : 0;
+		}
+
+		::printf("%u of %u tests passed\n", testsCount - failedCount, testsCount);
+		return failedCount || testsCount == 0 ? 1 : 0;
+	}
+
+	void Fail(const char* file, int line, const char* expression)
+	{
+		if (s_failuresCount < MAX_PRINTED_FAILURES)
+			::printf("  %s(%d): check failed: %s\n", file, line, expression);
+		s_failuresCount++;
+	}
+
+	const char* GetDataDirectory()
+	{
+		return s_dataDirectory.c_str();
+	}
+
+	void SetDataDirectory(const char* directory)
+	{
+		s_dataDirectory = directory;
+	}
+}
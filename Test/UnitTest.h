@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../Common/Types.h"
+
+/*
+=========
+Unit Test
+=========
+*/
+
+// Behavior checks for the parts of Common that run without a device, next to
+// the benchmarks in the same executable:
+//
+//	--test				Run every test.
+//	--test=<text>		Only run tests whose name contains text.
+//
+// A test is a function that checks with TEST_CHECK, which records a failure
+// and carries on, and TEST_REQUIRE, which also returns from the test.
+typedef void (*UnitTestFunc)();
+
+namespace UnitTest
+{
+	// name must outlive the run.
+	void Register(const char* name, UnitTestFunc func);
+
+	// Returns the process exit code: non-zero when a test failed or none ran.
+	int RunAll(const char* filter);
+
+	// Records a failure of the running test.
+	void Fail(const char* file, int line, const char* expression);
+
+	// Where tests find files in the source tree, such as Assets/. Set by
+	// --test_data=<directory>; "." otherwise.
+	const char* GetDataDirectory();
+	void SetDataDirectory(const char* directory);
+}
+
+// Tests.cpp
+void RegisterUnitTests();
+
+#define TEST_CHECK(expression) \
+	do { if (!(expression)) UnitTest::Fail(__FILE__, __LINE__, #expression); } while (0)
+
+#define TEST_REQUIRE(expression) \
+	do { if (!(expression)) { UnitTest::Fail(__FILE__, __LINE__, #expression); return; } } while (0)